@@ -0,0 +1,104 @@
+#!/bin/bash
+# Per-opcode dispatch cost of the bytecode VM
+#
+# Builds three variants of izi with CMake (computed-goto dispatch, switch
+# dispatch, and an instruction-counting build), runs every benchmarks/*.iz
+# under `izi run --vm`, and reports the average cost of one dispatched
+# instruction: (best wall time - startup time) / instructions dispatched.
+#
+# Usage:
+#   ./benchmarks/dispatch.sh [extra.iz ...]
+#
+# Environment:
+#   BUILD_DIR   where the variants are built (default: _dispatch_build)
+#   BASE_BIN    optional izi binary to compare against (e.g. a build of an
+#               older commit); shown as the "before" column
+#   ITERATIONS  runs per measurement, the fastest is kept (default: 5)
+
+set -e
+
+BENCHMARK_DIR="benchmarks"
+BUILD_DIR="${BUILD_DIR:-_dispatch_build}"
+ITERATIONS="${ITERATIONS:-5}"
+
+if [ ! -d "$BENCHMARK_DIR" ]; then
+    echo "Error: run this script from the repository root"
+    exit 1
+fi
+
+build_variant() {
+    local name=$1
+    shift
+    echo "Building $name variant..." >&2
+    cmake -S . -B "$BUILD_DIR/$name" -DCMAKE_BUILD_TYPE=Release -DHAVE_READLINE=OFF "$@" > /dev/null
+    cmake --build "$BUILD_DIR/$name" --target izi -j"$(nproc)" > /dev/null
+}
+
+build_variant threaded -DIZI_VM_SWITCH_DISPATCH=OFF -DIZI_VM_COUNT_DISPATCH=OFF
+build_variant switch -DIZI_VM_SWITCH_DISPATCH=ON -DIZI_VM_COUNT_DISPATCH=OFF
+build_variant count -DIZI_VM_SWITCH_DISPATCH=OFF -DIZI_VM_COUNT_DISPATCH=ON
+
+THREADED_BIN="$BUILD_DIR/threaded/izi"
+SWITCH_BIN="$BUILD_DIR/switch/izi"
+COUNT_BIN="$BUILD_DIR/count/izi"
+
+# Fastest wall time of a run, in nanoseconds
+best_time() {
+    local bin=$1
+    local script=$2
+    local best=""
+    for i in $(seq 1 "$ITERATIONS"); do
+        local start=$(date +%s%N)
+        "$bin" run --vm "$script" > /dev/null 2>&1 || true
+        local end=$(date +%s%N)
+        local elapsed=$((end - start))
+        if [ -z "$best" ] || [ "$elapsed" -lt "$best" ]; then
+            best=$elapsed
+        fi
+    done
+    echo "$best"
+}
+
+# Nanoseconds per instruction after subtracting process startup
+per_op() {
+    local elapsed=$1
+    local startup=$2
+    local count=$3
+    awk -v t="$elapsed" -v s="$startup" -v n="$count" 'BEGIN { printf "%.2f", (t - s) / n }'
+}
+
+EMPTY_SCRIPT=$(mktemp --suffix=.iz)
+trap 'rm -f "$EMPTY_SCRIPT"' EXIT
+
+STARTUP_THREADED=$(best_time "$THREADED_BIN" "$EMPTY_SCRIPT")
+STARTUP_SWITCH=$(best_time "$SWITCH_BIN" "$EMPTY_SCRIPT")
+if [ -n "$BASE_BIN" ]; then
+    STARTUP_BASE=$(best_time "$BASE_BIN" "$EMPTY_SCRIPT")
+fi
+
+echo ""
+printf "%-14s %14s %12s %12s %12s\n" "Benchmark" "Instructions" "Before" "Switch" "Threaded"
+echo "──────────────────────────────────────────────────────────────────────"
+
+for script in "$BENCHMARK_DIR"/*.iz "$@"; do
+    name=$(basename "$script" .iz)
+    count=$("$COUNT_BIN" run --vm "$script" 2>&1 > /dev/null | sed -n 's/^vm: \([0-9]*\) instructions dispatched$/\1/p' | tail -1)
+    if [ -z "$count" ] || [ "$count" -eq 0 ]; then
+        printf "%-14s %14s\n" "$name" "(no VM run)"
+        continue
+    fi
+
+    before="-"
+    if [ -n "$BASE_BIN" ]; then
+        before="$(per_op "$(best_time "$BASE_BIN" "$script")" "$STARTUP_BASE" "$count")ns"
+    fi
+    switch_ns="$(per_op "$(best_time "$SWITCH_BIN" "$script")" "$STARTUP_SWITCH" "$count")ns"
+    threaded_ns="$(per_op "$(best_time "$THREADED_BIN" "$script")" "$STARTUP_THREADED" "$count")ns"
+
+    printf "%-14s %14s %12s %12s %12s\n" "$name" "$count" "$before" "$switch_ns" "$threaded_ns"
+done
+
+echo ""
+echo "Notes:"
+echo "  - Cost per instruction = (fastest of $ITERATIONS runs - startup) / instructions dispatched"
+echo "  - Benchmarks that dispatch fewer than ~1M instructions are dominated by noise"
@@ -0,0 +1,65 @@
+#!/bin/bash
+# Opcode and opcode-pair frequency profile of the bytecode VM
+#
+# Builds the instruction-counting variant of izi (-DIZI_VM_COUNT_DISPATCH=ON),
+# runs every benchmarks/*.iz under `izi run --vm`, and sums the dynamic
+# opcode and opcode-pair counts.  The superinstructions in
+# src/bytecode/opcode.hpp are chosen from this profile; rerun it after
+# changing the compiler or the benchmark suite.
+#
+# Usage:
+#   ./benchmarks/opcode_profile.sh [extra.iz ...]
+#
+# Environment:
+#   BUILD_DIR   where the counting build lives (default: _dispatch_build)
+#   OUTPUT      profile file to write (default: benchmarks/opcode_profile.txt)
+#   TOP         number of opcodes and pairs to list (default: 25)
+
+set -e
+
+BENCHMARK_DIR="benchmarks"
+BUILD_DIR="${BUILD_DIR:-_dispatch_build}"
+OUTPUT="${OUTPUT:-$BENCHMARK_DIR/opcode_profile.txt}"
+TOP="${TOP:-25}"
+
+if [ ! -d "$BENCHMARK_DIR" ]; then
+    echo "Error: run this script from the repository root"
+    exit 1
+fi
+
+echo "Building counting variant..." >&2
+cmake -S . -B "$BUILD_DIR/count" -DCMAKE_BUILD_TYPE=Release -DHAVE_READLINE=OFF \
+    -DIZI_VM_SWITCH_DISPATCH=OFF -DIZI_VM_COUNT_DISPATCH=ON > /dev/null
+cmake --build "$BUILD_DIR/count" --target izi -j"$(nproc)" > /dev/null
+COUNT_BIN="$BUILD_DIR/count/izi"
+
+RAW=$(mktemp)
+trap 'rm -f "$RAW" "$RAW.run"' EXIT
+
+SCRIPTS=()
+for script in "$BENCHMARK_DIR"/*.iz "$@"; do
+    echo "Profiling $script..." >&2
+    IZI_VM_PROFILE="$RAW.run" "$COUNT_BIN" run --vm "$script" > /dev/null 2>&1 || true
+    if [ -f "$RAW.run" ]; then
+        cat "$RAW.run" >> "$RAW"
+        rm -f "$RAW.run"
+        SCRIPTS+=("$(basename "$script")")
+    fi
+done
+
+{
+    echo "# VM opcode profile (generated by benchmarks/opcode_profile.sh)"
+    echo "# Scripts: ${SCRIPTS[*]}"
+    echo ""
+    echo "## Opcodes"
+    awk '$1 == "op" { count[$2] += $3; total += $3 }
+         END { for (op in count) printf "%-24s %12d %6.2f%%\n", op, count[op], 100 * count[op] / total }' "$RAW" \
+        | sort -k2,2nr | head -n "$TOP"
+    echo ""
+    echo "## Pairs"
+    awk '$1 == "pair" { key = $2 " " $3; count[key] += $4; total += $4 }
+         END { for (key in count) { split(key, p, " "); printf "%-22s %-22s %12d %6.2f%%\n", p[1], p[2], count[key], 100 * count[key] / total } }' "$RAW" \
+        | sort -k3,3nr | head -n "$TOP"
+} > "$OUTPUT"
+
+cat "$OUTPUT"
@@ -19,6 +19,17 @@ newoption {
     description = "Disable GNU readline support in the REPL"
 }
 
+-- Optional: VM dispatch variants used by benchmarks/dispatch.sh
+newoption {
+    trigger = "vm-switch-dispatch",
+    description = "Use switch dispatch in the bytecode VM instead of computed goto"
+}
+
+newoption {
+    trigger = "vm-count-dispatch",
+    description = "Count dispatched VM instructions and report the total on exit"
+}
+
 project "izi"
 location "."
 kind "ConsoleApp"
@@ -43,6 +54,14 @@ if not _OPTIONS["no-readline"] then
     defines {"HAVE_READLINE"}
 end
 
+if _OPTIONS["vm-switch-dispatch"] then
+    defines {"IZI_VM_SWITCH_DISPATCH"}
+end
+
+if _OPTIONS["vm-count-dispatch"] then
+    defines {"IZI_VM_COUNT_DISPATCH"}
+end
+
 filter "configurations:Debug"
 runtime "Debug"
 symbols "on"
@@ -8,12 +8,12 @@ namespace izi {
 // ── Helpers ───────────────────────────────────────────────────────────────────
 
 std::string AstPrinter::literalToString(const Value& v) {
-    if (std::holds_alternative<Nil>(v)) {
+    if (v.isNil()) {
         return "nil";
-    } else if (std::holds_alternative<bool>(v)) {
-        return std::get<bool>(v) ? "true" : "false";
-    } else if (std::holds_alternative<double>(v)) {
-        double num = std::get<double>(v);
+    } else if (v.isBool()) {
+        return v.asBool() ? "true" : "false";
+    } else if (v.isNumber()) {
+        double num = v.asNumber();
         std::ostringstream oss;
         if (num == std::floor(num) && std::isfinite(num)) {
             oss << static_cast<long long>(num);
@@ -21,8 +21,8 @@ std::string AstPrinter::literalToString(const Value& v) {
             oss << num;
         }
         return oss.str();
-    } else if (std::holds_alternative<std::string>(v)) {
-        return "\"" + std::get<std::string>(v) + "\"";
+    } else if (v.isString()) {
+        return "\"" + v.asString() + "\"";
     }
     return "<value>";
 }
@@ -6,13 +6,15 @@
 
 #include "common/token.hpp"
 #include "common/value.hpp"
+#include "node_pool.hpp"
 #include "visitor.hpp"
 #include "pattern.hpp"
+#include "scope.hpp"
 
 namespace izi {
 
 // Base struct for all expressions
-struct Expr {
+struct Expr : PoolAllocated {
     virtual ~Expr() = default;
     virtual Value accept(ExprVisitor& visitor) = 0;
 };
@@ -31,6 +33,7 @@ struct LiteralExpr : Expr {
 struct VariableExpr : Expr {
     std::string name;
     ExprPtr value;
+    VarSlot slot;  // Set by the Resolver
     explicit VariableExpr(const std::string& n, ExprPtr v) : name(std::move(n)), value(std::move(v)) {}
 
     Value accept(ExprVisitor& v) override { return v.visit(*this); }
@@ -40,6 +43,7 @@ struct VariableExpr : Expr {
 struct AssignExpr : Expr {
     std::string name;
     ExprPtr value;
+    VarSlot slot;  // Set by the Resolver
 
     AssignExpr(std::string n, ExprPtr v) : name(std::move(n)), value(std::move(v)) {}
 
@@ -167,6 +171,8 @@ struct SetPropertyExpr : Expr {
 
 // This expression for referencing the current instance (v0.3)
 struct ThisExpr : Expr {
+    VarSlot slot;  // Set by the Resolver
+
     ThisExpr() = default;
 
     Value accept(ExprVisitor& v) override { return v.visit(*this); }
@@ -175,6 +181,8 @@ struct ThisExpr : Expr {
 // Super expression for referencing the parent class (v0.3)
 struct SuperExpr : Expr {
     std::string method;  // Name of the method to call on super
+    VarSlot superSlot;  // Set by the Resolver
+    VarSlot thisSlot;
 
     explicit SuperExpr(std::string m) : method(std::move(m)) {}
 
@@ -193,6 +201,8 @@ struct FunctionExpr : Expr {
     std::vector<std::string> params;
     std::vector<StmtPtr> body;
     bool isAsync = false;  // true when declared with 'async fn'; call returns a Task
+    ScopeLayout scope;  // Parameters, then the body's locals
+    std::shared_ptr<CompiledBlock> compiled;  // Set on the first call in closure mode
 
     FunctionExpr(std::vector<std::string> p, std::vector<StmtPtr> b, bool async = false)
         : params(std::move(p)), body(std::move(b)), isAsync(async) {}
@@ -215,6 +225,7 @@ struct MatchCase {
     PatternPtr pattern;
     ExprPtr guard;  // Optional: if condition
     ExprPtr result;
+    ScopeLayout scope;  // The pattern's binding, if any, for the guard and the result
 
     MatchCase(PatternPtr p, ExprPtr g, ExprPtr r) : pattern(std::move(p)), guard(std::move(g)), result(std::move(r)) {}
 
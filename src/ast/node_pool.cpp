@@ -0,0 +1,102 @@
+#include "node_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace izi {
+
+namespace {
+
+constexpr size_t GRANULE = 8;
+constexpr size_t MAX_NODE = 1024;  // Larger nodes use the global heap
+constexpr size_t FIRST_SLAB = 4 * 1024;  // A one-line parse (REPL, eval) stays small
+constexpr size_t MAX_SLAB = 64 * 1024;
+
+std::atomic<size_t> reserved{0};
+
+// Precedes every node; null for nodes on the global heap
+struct NodeHeader {
+    AstArena* arena;
+};
+static_assert(sizeof(NodeHeader) == GRANULE);
+
+thread_local AstArena* currentArena = nullptr;
+
+}  // namespace
+
+class AstArena {
+   public:
+    void* allocate(size_t bytes) {
+        if (static_cast<size_t>(end_ - next_) < bytes) {
+            size_t size = slabs_.empty() ? FIRST_SLAB : std::min(slabSize_ * 2, MAX_SLAB);
+            slabs_.emplace_back(new char[size]);
+            slabSize_ = size;
+            reservedHere_ += size;
+            reserved.fetch_add(size, std::memory_order_relaxed);
+            next_ = slabs_.back().get();
+            end_ = next_ + size;
+        }
+        char* block = next_;
+        next_ += bytes;
+        refs_.fetch_add(1, std::memory_order_relaxed);
+        return block;
+    }
+
+    // Drops a node's reference, or the open scope's
+    void release() noexcept {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+   private:
+    ~AstArena() { reserved.fetch_sub(reservedHere_, std::memory_order_relaxed); }
+
+    std::atomic<size_t> refs_{1};  // Live nodes, plus one while the scope is open
+    std::vector<std::unique_ptr<char[]>> slabs_;
+    size_t slabSize_ = 0;
+    size_t reservedHere_ = 0;
+    char* next_ = nullptr;
+    char* end_ = nullptr;
+};
+
+AstArenaScope::AstArenaScope() : arena_(new AstArena), previous_(currentArena) {
+    currentArena = arena_;
+}
+
+AstArenaScope::~AstArenaScope() {
+    currentArena = previous_;
+    arena_->release();
+}
+
+void* NodePool::allocate(size_t size) {
+    size_t bytes = sizeof(NodeHeader) + (size + GRANULE - 1) / GRANULE * GRANULE;
+    AstArena* arena = currentArena;
+    void* block;
+    if (arena && bytes <= MAX_NODE) {
+        block = arena->allocate(bytes);
+    } else {
+        block = ::operator new(bytes);
+        arena = nullptr;
+    }
+    static_cast<NodeHeader*>(block)->arena = arena;
+    return static_cast<char*>(block) + sizeof(NodeHeader);
+}
+
+void NodePool::deallocate(void* node, size_t) noexcept {
+    auto* header = reinterpret_cast<NodeHeader*>(static_cast<char*>(node) - sizeof(NodeHeader));
+    if (header->arena) {
+        header->arena->release();
+    } else {
+        ::operator delete(header);
+    }
+}
+
+size_t NodePool::reservedBytes() {
+    return reserved.load(std::memory_order_relaxed);
+}
+
+}  // namespace izi
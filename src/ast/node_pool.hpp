@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+
+namespace izi {
+
+class AstArena;
+
+// Allocator for AST nodes.
+//
+// A parse makes one small allocation per node, hundreds of thousands for a
+// large codebase.  While a parse runs (see AstArenaScope), nodes come
+// instead from an arena owned by that parse: slabs carved by a pointer bump,
+// so a tree's nodes sit next to each other in the order they were parsed.
+// Each node is preceded by a pointer to its arena.  The arena frees its
+// slabs once the parse is over and the last of its nodes is deleted, on
+// whichever thread that happens; nodes are not reused one by one.  Nodes
+// made outside a parse (by the optimizer or tests) and oversized ones use
+// the global heap.
+class NodePool {
+   public:
+    static void* allocate(size_t size);
+    static void deallocate(void* node, size_t size) noexcept;
+
+    // Bytes of slab memory held by arenas that are still alive
+    static size_t reservedBytes();
+};
+
+// Opens a fresh arena for the nodes allocated on this thread until it is
+// destroyed.  Parser::parse() opens one per parse; scopes nest.
+class AstArenaScope {
+   public:
+    AstArenaScope();
+    ~AstArenaScope();
+
+    AstArenaScope(const AstArenaScope&) = delete;
+    AstArenaScope& operator=(const AstArenaScope&) = delete;
+
+   private:
+    AstArena* arena_;
+    AstArena* previous_;
+};
+
+// Base for the AST's node hierarchies (Expr, Stmt, Pattern): routes `new`
+// and `delete` of every node type through the NodePool.
+struct PoolAllocated {
+    static void* operator new(size_t size) { return NodePool::allocate(size); }
+    static void operator delete(void* node, size_t size) noexcept { NodePool::deallocate(node, size); }
+};
+
+}  // namespace izi
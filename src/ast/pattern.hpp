@@ -4,6 +4,7 @@
 #include <string>
 #include "common/value.hpp"
 #include "common/token.hpp"
+#include "node_pool.hpp"
 
 namespace izi {
 
@@ -12,7 +13,7 @@ struct Expr;
 using ExprPtr = std::unique_ptr<Expr>;
 
 // Base class for all patterns
-struct Pattern {
+struct Pattern : PoolAllocated {
     virtual ~Pattern() = default;
 };
 
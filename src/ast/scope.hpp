@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace izi {
+
+// Marks a name the interpreter's Resolver has not placed
+constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+// Where the Resolver found a variable: `depth` environments out from the one
+// the reference runs in, at index `slot`.  `checked` marks a slot of a
+// top-level environment, which may not be defined yet when it is read.
+// Unresolved references are looked up by name.
+struct VarSlot {
+    uint32_t depth = NO_SLOT;
+    uint32_t slot = 0;
+    bool checked = false;
+
+    bool resolved() const { return depth != NO_SLOT; }
+};
+
+// The variables of one scope in slot order, filled in by the Resolver.  Every
+// Environment created for the scope gets one slot per name.  `captured` marks
+// a scope whose environment closures may hold on to after it ends: one that
+// creates a function or class, or runs a module's top level.  `late` marks,
+// by slot, names declared after a function in the scope that the function
+// reads: it may run before they are defined, and then reads the name from an
+// outer scope, so their slots start undefined.
+struct ScopeLayout {
+    std::vector<std::string> names;
+    std::vector<bool> late;  // Empty when no slot is late
+    bool captured = false;
+};
+
+// A function body compiled by the interpreter's ClosureCompiler
+struct CompiledBlock;
+
+// The scopes the interpreter wraps around class methods: a bound method's
+// `this` and, in a subclass, `super`
+inline const ScopeLayout& thisScopeLayout() {
+    static const ScopeLayout layout{{"this"}, {}, false};
+    return layout;
+}
+
+inline const ScopeLayout& superScopeLayout() {
+    static const ScopeLayout layout{{"super"}, {}, true};
+    return layout;
+}
+
+}  // namespace izi
@@ -6,6 +6,7 @@
 
 #include "common/token.hpp"
 #include "expr.hpp"
+#include "node_pool.hpp"
 #include "visitor.hpp"
 #include "type.hpp"
 #include "pattern.hpp"
@@ -13,7 +14,7 @@
 namespace izi {
 
 // Base struct for all statements
-struct Stmt {
+struct Stmt : PoolAllocated {
     virtual ~Stmt() = default;
     virtual void accept(StmtVisitor& visitor) = 0;
     int line = 0;  // Source line number (set by parser for debug support)
@@ -33,6 +34,7 @@ struct ExprStmt : public Stmt {
 // Block statement (e.g., "{ stmt1; stmt2; }")
 struct BlockStmt : public Stmt {
     std::vector<StmtPtr> statements;
+    ScopeLayout scope;  // Set by the Resolver
 
     explicit BlockStmt(std::vector<StmtPtr> stmts) : statements(std::move(stmts)) {}
 
@@ -45,6 +47,7 @@ struct VarStmt : public Stmt {
     PatternPtr pattern;  // For destructuring declarations
     ExprPtr initializer;
     TypePtr typeAnnotation;  // Optional type annotation (v0.3)
+    uint32_t slot = NO_SLOT;  // Slot of a simple declaration, set by the Resolver
 
     // Constructor for simple variable declaration
     VarStmt(std::string n, ExprPtr init, TypePtr type = nullptr)
@@ -85,6 +88,9 @@ struct FunctionStmt : public Stmt {
     std::vector<TypePtr> paramTypes;  // Optional parameter type annotations (v0.3)
     TypePtr returnType;  // Optional return type annotation (v0.3)
     bool isAsync = false;  // true when declared with 'async fn'; call returns a Task
+    uint32_t slot = NO_SLOT;  // Set by the Resolver
+    ScopeLayout scope;  // Parameters, then the body's locals
+    std::shared_ptr<CompiledBlock> compiled;  // Set on the first call in closure mode
 
     FunctionStmt(std::string n, std::vector<std::string> p, std::vector<StmtPtr> b, std::vector<TypePtr> pTypes = {},
                  TypePtr rType = nullptr, bool async = false)
@@ -203,6 +209,7 @@ struct TryStmt : public Stmt {
     std::string catchVariable;  // Variable name to bind the exception to (e.g., "e" in catch(e))
     StmtPtr catchBlock;  // Can be nullptr if no catch
     StmtPtr finallyBlock;  // Can be nullptr if no finally
+    ScopeLayout catchScope;  // The catch variable, then the catch block's locals
 
     TryStmt(StmtPtr tryB, std::string catchVar, StmtPtr catchB, StmtPtr finallyB)
         : tryBlock(std::move(tryB)),
@@ -229,6 +236,8 @@ struct ClassStmt : public Stmt {
     std::string superclass;  // Name of the superclass (empty string if no inheritance)
     std::vector<std::unique_ptr<VarStmt>> fields;  // Class fields (owned)
     std::vector<std::unique_ptr<FunctionStmt>> methods;  // Class methods (owned)
+    uint32_t slot = NO_SLOT;  // Set by the Resolver
+    VarSlot superclassSlot;
 
     ClassStmt(std::string n, std::string super, std::vector<std::unique_ptr<VarStmt>> f,
               std::vector<std::unique_ptr<FunctionStmt>> m)
@@ -1,14 +1,145 @@
 #pragma once
 #include "opcode.hpp"
 #include "common/value.hpp"
+#include "bytecode/property_cache.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
 #include <vector>
 
 namespace izi {
+class JitCode;
+
+// Exception table entry.  An exception raised by the instruction at a code
+// offset in [start, end) unwinds the frame's stack to `stackDepth` slots above
+// its base, pushes the exception value and resumes at `handler`.  Entries for
+// nested try statements precede the entries that enclose them.
+struct ExceptionTableEntry {
+    uint32_t start;
+    uint32_t end;
+    uint32_t handler;
+    uint32_t stackDepth;
+};
+
+// A chunk's bytecode.  A compiled chunk owns its bytes; a chunk loaded from
+// a .izb image points into the image's Code section instead and keeps the
+// image alive.  Growing or replacing mapped code copies it out first, while
+// writing a byte in place (quickening) writes the image, which is a private
+// copy-on-write mapping or buffer.
+class Bytecode {
+   public:
+    Bytecode() = default;
+    Bytecode(std::initializer_list<uint8_t> bytes) : owned_(bytes) { sync(); }
+    Bytecode(const Bytecode& other) : owned_(other.begin(), other.end()) { sync(); }
+    Bytecode(Bytecode&& other) noexcept { *this = std::move(other); }
+
+    Bytecode& operator=(const Bytecode& other) {
+        if (this != &other) {
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+    Bytecode& operator=(Bytecode&& other) noexcept {
+        owned_ = std::move(other.owned_);
+        image_ = std::move(other.image_);
+        data_ = image_ ? other.data_ : owned_.data();
+        size_ = other.size_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+        return *this;
+    }
+
+    // Point at `size` bytes of an image that `image` keeps alive
+    void view(uint8_t* data, size_t size, std::shared_ptr<const void> image) {
+        owned_.clear();
+        image_ = std::move(image);
+        data_ = data;
+        size_ = size;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    uint8_t* data() { return data_; }
+    const uint8_t* data() const { return data_; }
+    uint8_t& operator[](size_t i) { return data_[i]; }
+    const uint8_t& operator[](size_t i) const { return data_[i]; }
+    uint8_t* begin() { return data_; }
+    uint8_t* end() { return data_ + size_; }
+    const uint8_t* begin() const { return data_; }
+    const uint8_t* end() const { return data_ + size_; }
+
+    void push_back(uint8_t byte) {
+        own();
+        owned_.push_back(byte);
+        sync();
+    }
+
+    template <typename It>
+    void assign(It first, It last) {
+        std::vector<uint8_t> bytes(first, last);
+        image_.reset();
+        owned_ = std::move(bytes);
+        sync();
+    }
+
+    friend bool operator==(const Bytecode& a, const Bytecode& b) {
+        return a.size_ == b.size_ && std::equal(a.begin(), a.end(), b.begin());
+    }
+
+   private:
+    std::vector<uint8_t> owned_;
+    std::shared_ptr<const void> image_;  // Set while viewing an image
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+
+    void own() {
+        if (image_) {
+            owned_.assign(data_, data_ + size_);
+            image_.reset();
+        }
+    }
+    void sync() {
+        data_ = owned_.data();
+        size_ = owned_.size();
+    }
+};
+
 struct Chunk {
-    std::vector<uint8_t> code;
+    // Mutable because the VM quickens it in place: an operand-free opcode
+    // byte flips between a generic instruction and its specialized form
+    // (ADD and ADD_NUM, LESS and LESS_NUM, INDEX and INDEX_ARRAY_NUM), which
+    // never changes an instruction's length or what it computes.  Like the
+    // link-time state below, the code belongs to the VM running the chunk: a
+    // chunk must not run on two threads at once.
+    mutable Bytecode code;
     std::vector<Value> constants;
     std::vector<std::string> names;
     std::vector<int> lines;  // Source line number for each bytecode instruction
+    std::vector<ExceptionTableEntry> exceptionTable;  // Consulted only when an exception is raised
+
+    // Link-time state owned by the VM: globalSlots[i] is the VM global slot
+    // for names[i], valid while linkedVm matches the running VM's id.
+    mutable uint64_t linkedVm = 0;
+    mutable std::vector<uint32_t> globalSlots;
+    // Inline caches for GET_PROPERTY / SET_PROPERTY, indexed like names
+    mutable std::vector<PropertyCache> propertyCaches;
+    // Baseline JIT (VMs with the JIT enabled): calls, back-edges and returns
+    // into this chunk so far, and its native code once it got hot
+    mutable uint32_t hotness = 0;
+    mutable std::shared_ptr<const JitCode> jitCode;
+
+    // Set on a function's chunk loaded from an image while its constants,
+    // names and line table are still undecoded; VmUserFunction::getChunk()
+    // decodes them the first time the function is used
+    std::function<void(Chunk&)> undecoded;
+
+    void decode() {
+        auto decodeRest = std::move(undecoded);
+        undecoded = nullptr;
+        decodeRest(*this);
+    }
 
     void write(uint8_t byte, int line = 0) {
         code.push_back(byte);
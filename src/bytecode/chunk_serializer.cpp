@@ -4,401 +4,798 @@
 #include "vm_class.hpp"
 #include "common/error.hpp"
 #include <cstring>
+#include <fstream>
+#include <sstream>
 #include <stdexcept>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace izi {
 
-// Write helper methods
-void ChunkSerializer::writeUint32(std::ofstream& out, uint32_t value) {
-    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+namespace {
+
+// On-disk records.  All fields are fixed-width and the layout has no
+// implicit padding, so records are written and read with memcpy.
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t checksum;  // Of every byte after this field, up to `size`
+    uint64_t size;
+};
+
+struct SectionEntry {
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct StringRecord {
+    uint32_t offset;  // Into StringData
+    uint32_t length;
+};
+
+struct ChunkRecord {
+    uint32_t codeOffset;
+    uint32_t codeSize;
+    uint32_t constantFirst;
+    uint32_t constantCount;
+    uint32_t nameFirst;  // Indices: string per name
+    uint32_t nameCount;
+    uint32_t handlerFirst;
+    uint32_t handlerCount;
+    uint32_t lineOffset;
+    uint32_t lineSize;
+};
+
+// `a` and `b` by tag: BOOL a = 0/1; NUMBER b = IEEE bits; STRING a = string;
+// ARRAY a = first index, b = count (constant per element); MAP and SET
+// a = first index, b = count of (string key, constant) pairs; FUNCTION
+// a = function; CLASS a = class; ERROR a = message string, b = type string.
+struct ConstantRecord {
+    uint8_t tag;
+    uint8_t padding[3];
+    uint32_t a;
+    uint64_t b;
+};
+
+struct FunctionRecord {
+    uint32_t name;
+    uint32_t chunk;
+    uint32_t paramFirst;  // Indices: string per parameter
+    uint32_t paramCount;
+    uint32_t upvalueFirst;  // Indices: slot index, high bit set when local
+    uint32_t upvalueCount;
+};
+
+struct ClassRecord {
+    uint32_t name;
+    uint32_t fieldFirst;  // Indices: string per field
+    uint32_t fieldCount;
+    uint32_t defaultFirst;  // Indices: (string, constant) pairs
+    uint32_t defaultCount;
+    uint32_t methodFirst;  // Indices: (string, function) pairs
+    uint32_t methodCount;
+    uint32_t padding;
+};
+
+static_assert(sizeof(FileHeader) == 24 && sizeof(SectionEntry) == 16 && sizeof(ChunkRecord) == 40 &&
+              sizeof(ConstantRecord) == 16 && sizeof(ClassRecord) == 32 && sizeof(ExceptionTableEntry) == 16);
+
+constexpr uint32_t LOCAL_UPVALUE = 0x80000000u;
+constexpr size_t CHECKSUM_START = offsetof(FileHeader, size);
+constexpr int MAX_CONSTANT_DEPTH = 512;
+
+// Multiply-xorshift over 64-bit words in four independent lanes, so hashing
+// a large image runs at memory speed rather than one multiply per byte
+uint64_t checksum(const unsigned char* data, size_t size) {
+    uint64_t lanes[4] = {0x243F6A8885A308D3ull, 0x13198A2E03707344ull, 0xA4093822299F31D0ull, 0x082EFA98EC4E6C89ull};
+    constexpr uint64_t PRIME = 0x100000001B3ull;
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int lane = 0; lane < 4; ++lane) {
+            uint64_t word;
+            std::memcpy(&word, data + i + lane * 8, 8);
+            lanes[lane] = (lanes[lane] ^ word) * PRIME;
+            lanes[lane] ^= lanes[lane] >> 29;
+        }
+    }
+    uint64_t hash = lanes[0] ^ (lanes[1] * 3) ^ (lanes[2] * 5) ^ (lanes[3] * 7);
+    for (; i < size; ++i) {
+        hash = (hash ^ data[i]) * PRIME;
+    }
+    return hash ^ (hash >> 32);
 }
 
-void ChunkSerializer::writeUint8(std::ofstream& out, uint8_t value) {
-    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+void writeVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
 }
 
-void ChunkSerializer::writeString(std::ofstream& out, const std::string& str) {
-    writeUint32(out, static_cast<uint32_t>(str.size()));
-    out.write(str.data(), str.size());
+template <typename T>
+void appendRecords(std::string& out, const std::vector<T>& records) {
+    out.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T));
 }
 
-void ChunkSerializer::writeValue(std::ofstream& out, const Value& value) {
-    if (std::holds_alternative<Nil>(value)) {
-        writeUint8(out, static_cast<uint8_t>(ValueType::NIL));
-    } else if (std::holds_alternative<bool>(value)) {
-        writeUint8(out, static_cast<uint8_t>(ValueType::BOOL));
-        writeUint8(out, std::get<bool>(value) ? 1 : 0);
-    } else if (std::holds_alternative<double>(value)) {
-        writeUint8(out, static_cast<uint8_t>(ValueType::NUMBER));
-        double num = std::get<double>(value);
-        out.write(reinterpret_cast<const char*>(&num), sizeof(num));
-    } else if (std::holds_alternative<std::string>(value)) {
-        writeUint8(out, static_cast<uint8_t>(ValueType::STRING));
-        writeString(out, std::get<std::string>(value));
-    } else if (std::holds_alternative<std::shared_ptr<Array>>(value)) {
-        writeUint8(out, static_cast<uint8_t>(ValueType::ARRAY));
-        const auto& arr = std::get<std::shared_ptr<Array>>(value);
-        writeUint32(out, static_cast<uint32_t>(arr->elements.size()));
-        for (const auto& elem : arr->elements) {
-            writeValue(out, elem);
-        }
-    } else if (std::holds_alternative<std::shared_ptr<Map>>(value)) {
-        writeUint8(out, static_cast<uint8_t>(ValueType::MAP));
-        const auto& map = std::get<std::shared_ptr<Map>>(value);
-        writeUint32(out, static_cast<uint32_t>(map->entries.size()));
-        for (const auto& [key, val] : map->entries) {
-            writeString(out, key);
-            writeValue(out, val);
-        }
-    } else if (std::holds_alternative<std::shared_ptr<Set>>(value)) {
-        writeUint8(out, static_cast<uint8_t>(ValueType::SET));
-        const auto& set = std::get<std::shared_ptr<Set>>(value);
-        writeUint32(out, static_cast<uint32_t>(set->values.size()));
-        for (const auto& [key, val] : set->values) {
-            writeString(out, key);
-            writeValue(out, val);
-        }
-    } else if (std::holds_alternative<std::shared_ptr<VmCallable>>(value)) {
-        auto callable = std::get<std::shared_ptr<VmCallable>>(value);
-
-        // Check if it's a VmUserFunction
-        if (auto userFunc = std::dynamic_pointer_cast<VmUserFunction>(callable)) {
-            writeUint8(out, static_cast<uint8_t>(ValueType::FUNCTION));
-            writeString(out, userFunc->name());
-
-            // Write parameter count and names
-            const auto& params = userFunc->params();
-            writeUint32(out, static_cast<uint32_t>(params.size()));
-            for (const auto& param : params) {
-                writeString(out, param);
-            }
+void alignTo8(std::string& out) {
+    out.resize((out.size() + 7) & ~size_t{7}, '\0');
+}
 
-            // Recursively serialize the function's chunk
-            const Chunk& funcChunk = userFunc->getChunk();
+}  // namespace
+
+class ChunkSerializer::Writer {
+   public:
+    std::string write(const Chunk& script) {
+        addChunk(script);
+
+        std::string image(sizeof(FileHeader) + SECTION_COUNT * sizeof(SectionEntry), '\0');
+        SectionEntry directory[SECTION_COUNT];
+        auto section = [&](Section id, const char* data, size_t size) {
+            alignTo8(image);
+            directory[id] = {image.size(), size};
+            image.append(data, size);
+        };
+        auto records = [&](Section id, const auto& vector) {
+            section(id, reinterpret_cast<const char*>(vector.data()), vector.size() * sizeof(vector[0]));
+        };
+        records(Strings, strings_);
+        section(StringData, stringData_.data(), stringData_.size());
+        records(Chunks, chunks_);
+        section(Code, code_.data(), code_.size());
+        records(Constants, constants_);
+        records(Functions, functions_);
+        records(Classes, classes_);
+        records(Indices, indices_);
+        records(Handlers, handlers_);
+        section(Lines, lines_.data(), lines_.size());
+        alignTo8(image);
+
+        FileHeader header{};
+        std::memcpy(header.magic, MAGIC, 4);
+        header.version = FORMAT_VERSION;
+        header.size = image.size();
+        std::memcpy(image.data(), &header, sizeof(header));
+        std::memcpy(image.data() + sizeof(header), directory, sizeof(directory));
+        header.checksum = checksum(reinterpret_cast<const unsigned char*>(image.data()) + CHECKSUM_START,
+                                   image.size() - CHECKSUM_START);
+        std::memcpy(image.data(), &header, sizeof(header));
+        return image;
+    }
 
-            // Write code section
-            writeUint32(out, static_cast<uint32_t>(funcChunk.code.size()));
-            for (uint8_t byte : funcChunk.code) {
-                writeUint8(out, byte);
-            }
+   private:
+    std::vector<StringRecord> strings_;
+    std::string stringData_;
+    std::vector<ChunkRecord> chunks_;
+    std::string code_;
+    std::vector<ConstantRecord> constants_;
+    std::vector<FunctionRecord> functions_;
+    std::vector<ClassRecord> classes_;
+    std::vector<uint32_t> indices_;
+    std::vector<ExceptionTableEntry> handlers_;
+    std::string lines_;
+
+    std::unordered_map<std::string, uint32_t> stringIndex_;
+    std::unordered_map<const Chunk*, uint32_t> chunkIndex_;
+    std::unordered_map<const VmUserFunction*, uint32_t> functionIndex_;
+    std::unordered_map<const VmClass*, uint32_t> classIndex_;
+
+    static uint32_t count(size_t size) {
+        if (size > UINT32_MAX) {
+            throw std::runtime_error("Bytecode image exceeds the 4 GB format limit");
+        }
+        return static_cast<uint32_t>(size);
+    }
 
-            // Write constants section
-            writeUint32(out, static_cast<uint32_t>(funcChunk.constants.size()));
-            for (const auto& constant : funcChunk.constants) {
-                writeValue(out, constant);
-            }
+    uint32_t addString(const std::string& str) {
+        auto [it, inserted] = stringIndex_.try_emplace(str, count(strings_.size()));
+        if (inserted) {
+            strings_.push_back({count(stringData_.size()), count(str.size())});
+            stringData_ += str;
+        }
+        return it->second;
+    }
 
-            // Write names section
-            writeUint32(out, static_cast<uint32_t>(funcChunk.names.size()));
-            for (const auto& name : funcChunk.names) {
-                writeString(out, name);
-            }
-        } else {
-            // Native function - store only name reference
-            writeUint8(out, static_cast<uint8_t>(ValueType::NATIVE_FUNCTION));
-            writeString(out, callable->name());
-        }
-    } else if (std::holds_alternative<std::shared_ptr<VmClass>>(value)) {
-        writeUint8(out, static_cast<uint8_t>(ValueType::CLASS));
-        const auto& vmClass = std::get<std::shared_ptr<VmClass>>(value);
-        writeString(out, vmClass->className);
-
-        // Write field names
-        writeUint32(out, static_cast<uint32_t>(vmClass->fieldNames.size()));
-        for (const auto& fieldName : vmClass->fieldNames) {
-            writeString(out, fieldName);
-        }
-
-        // Write field defaults
-        writeUint32(out, static_cast<uint32_t>(vmClass->fieldDefaults.size()));
-        for (const auto& [fieldName, defaultValue] : vmClass->fieldDefaults) {
-            writeString(out, fieldName);
-            writeValue(out, defaultValue);
-        }
-
-        // Write methods
-        writeUint32(out, static_cast<uint32_t>(vmClass->methods.size()));
-        for (const auto& [methodName, methodCallable] : vmClass->methods) {
-            writeString(out, methodName);
-            writeValue(out, methodCallable);
-        }
-    } else if (std::holds_alternative<std::shared_ptr<Instance>>(value)) {
-        // Instances cannot be serialized directly - they are runtime constructs
-        throw std::runtime_error("Cannot serialize instance objects to bytecode");
-    } else if (std::holds_alternative<std::shared_ptr<Error>>(value)) {
-        writeUint8(out, static_cast<uint8_t>(ValueType::ERROR));
-        const auto& err = std::get<std::shared_ptr<Error>>(value);
-        writeString(out, err->message);
-        writeString(out, err->type);
-        // Note: We don't serialize cause chain or stack trace for simplicity
-    } else {
-        throw std::runtime_error("Unknown value type for serialization");
+    // Appends a list to Indices; returns its first position
+    uint32_t addIndices(const std::vector<uint32_t>& list) {
+        uint32_t first = count(indices_.size());
+        indices_.insert(indices_.end(), list.begin(), list.end());
+        return first;
     }
-}
 
-// Read helper methods
-uint32_t ChunkSerializer::readUint32(std::ifstream& in) {
-    uint32_t value;
-    in.read(reinterpret_cast<char*>(&value), sizeof(value));
-    if (!in) {
-        throw std::runtime_error("Failed to read uint32 from bytecode file");
+    uint32_t addChunk(const Chunk& chunk) {
+        if (auto it = chunkIndex_.find(&chunk); it != chunkIndex_.end()) {
+            return it->second;
+        }
+        uint32_t index = count(chunks_.size());
+        chunkIndex_.emplace(&chunk, index);
+        chunks_.emplace_back();
+
+        ChunkRecord record{};
+        record.codeOffset = count(code_.size());
+        record.codeSize = count(chunk.code.size());
+        code_.append(reinterpret_cast<const char*>(chunk.code.data()), chunk.code.size());
+
+        // The chunk's constants are one contiguous run; elements of nested
+        // arrays, maps and classes are appended after it
+        record.constantFirst = count(constants_.size());
+        record.constantCount = count(chunk.constants.size());
+        constants_.resize(constants_.size() + chunk.constants.size());
+        for (size_t i = 0; i < chunk.constants.size(); ++i) {
+            ConstantRecord constant = makeConstant(chunk.constants[i]);
+            constants_[record.constantFirst + i] = constant;
+        }
+
+        std::vector<uint32_t> names;
+        for (const auto& name : chunk.names) {
+            names.push_back(addString(name));
+        }
+        record.nameFirst = addIndices(names);
+        record.nameCount = count(names.size());
+
+        record.handlerFirst = count(handlers_.size());
+        record.handlerCount = count(chunk.exceptionTable.size());
+        handlers_.insert(handlers_.end(), chunk.exceptionTable.begin(), chunk.exceptionTable.end());
+
+        record.lineOffset = count(lines_.size());
+        int previous = 0;
+        for (size_t i = 0; i < chunk.lines.size();) {
+            size_t run = 1;
+            while (i + run < chunk.lines.size() && chunk.lines[i + run] == chunk.lines[i]) {
+                ++run;
+            }
+            int64_t delta = static_cast<int64_t>(chunk.lines[i]) - previous;
+            writeVarint(lines_, run);
+            writeVarint(lines_, (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63));
+            previous = chunk.lines[i];
+            i += run;
+        }
+        record.lineSize = count(lines_.size()) - record.lineOffset;
+
+        chunks_[index] = record;
+        return index;
     }
-    return value;
-}
 
-uint8_t ChunkSerializer::readUint8(std::ifstream& in) {
-    uint8_t value;
-    in.read(reinterpret_cast<char*>(&value), sizeof(value));
-    if (!in) {
-        throw std::runtime_error("Failed to read uint8 from bytecode file");
+    uint32_t addConstant(const Value& value) {
+        ConstantRecord constant = makeConstant(value);
+        constants_.push_back(constant);
+        return count(constants_.size() - 1);
     }
-    return value;
-}
 
-std::string ChunkSerializer::readString(std::ifstream& in) {
-    uint32_t length = readUint32(in);
-    std::string str(length, '\0');
-    in.read(&str[0], length);
-    if (!in) {
-        throw std::runtime_error("Failed to read string from bytecode file");
+    ConstantRecord makeConstant(const Value& value) {
+        ConstantRecord constant{};
+        auto tag = [&](ValueType type) { constant.tag = static_cast<uint8_t>(type); };
+        if (value.isNil()) {
+            tag(ValueType::NIL);
+        } else if (value.isBool()) {
+            tag(ValueType::BOOL);
+            constant.a = value.asBool() ? 1 : 0;
+        } else if (value.isNumber()) {
+            tag(ValueType::NUMBER);
+            double number = value.asNumber();
+            std::memcpy(&constant.b, &number, sizeof(number));
+        } else if (value.isString()) {
+            tag(ValueType::STRING);
+            constant.a = addString(value.asString());
+        } else if (value.isArray()) {
+            tag(ValueType::ARRAY);
+            std::vector<uint32_t> elements;
+            for (const auto& element : value.asArray()->elements) {
+                elements.push_back(addConstant(element));
+            }
+            constant.a = addIndices(elements);
+            constant.b = elements.size();
+        } else if (value.isMap() || value.isSet()) {
+            tag(value.isMap() ? ValueType::MAP : ValueType::SET);
+            const auto& entries = value.isMap() ? value.asMap()->entries : value.asSet()->values;
+            std::vector<uint32_t> pairs;
+            for (const auto& [key, entry] : entries) {
+                pairs.push_back(addString(key));
+                pairs.push_back(addConstant(entry));
+            }
+            constant.a = addIndices(pairs);
+            constant.b = entries.size();
+        } else if (value.isVmCallable()) {
+            auto callable = value.asVmCallable();
+            auto function = dynamicRefCast<VmUserFunction>(callable);
+            if (!function) {
+                throw std::runtime_error("Cannot serialize native function '" + callable->name() +
+                                         "': native functions must be registered at runtime");
+            }
+            tag(ValueType::FUNCTION);
+            constant.a = addFunction(*function);
+        } else if (value.isVmClass()) {
+            tag(ValueType::CLASS);
+            constant.a = addClass(*value.asVmClass());
+        } else if (value.isInstance()) {
+            // Instances cannot be serialized directly - they are runtime constructs
+            throw std::runtime_error("Cannot serialize instance objects to bytecode");
+        } else if (value.isError()) {
+            // Note: We don't serialize cause chain or stack trace for simplicity
+            tag(ValueType::ERROR);
+            constant.a = addString(value.asError()->message);
+            constant.b = addString(value.asError()->type);
+        } else {
+            throw std::runtime_error("Unknown value type for serialization");
+        }
+        return constant;
     }
-    return str;
-}
 
-Value ChunkSerializer::readValue(std::ifstream& in) {
-    uint8_t typeTag = readUint8(in);
-    ValueType type = static_cast<ValueType>(typeTag);
+    uint32_t addFunction(const VmUserFunction& function) {
+        if (auto it = functionIndex_.find(&function); it != functionIndex_.end()) {
+            return it->second;
+        }
+        uint32_t index = count(functions_.size());
+        functionIndex_.emplace(&function, index);
+        functions_.emplace_back();
+
+        FunctionRecord record{};
+        record.name = addString(function.name());
+        record.chunk = addChunk(function.getChunk());
+        std::vector<uint32_t> params;
+        for (const auto& param : function.params()) {
+            params.push_back(addString(param));
+        }
+        record.paramFirst = addIndices(params);
+        record.paramCount = count(params.size());
+        std::vector<uint32_t> upvalues;
+        for (const auto& desc : function.upvalueDescs()) {
+            upvalues.push_back(desc.index | (desc.isLocal ? LOCAL_UPVALUE : 0));
+        }
+        record.upvalueFirst = addIndices(upvalues);
+        record.upvalueCount = count(upvalues.size());
 
-    switch (type) {
-        case ValueType::NIL:
-            return Nil{};
+        functions_[index] = record;
+        return index;
+    }
 
-        case ValueType::BOOL: {
-            uint8_t boolVal = readUint8(in);
-            return boolVal != 0;
+    uint32_t addClass(const VmClass& vmClass) {
+        if (auto it = classIndex_.find(&vmClass); it != classIndex_.end()) {
+            return it->second;
         }
-
-        case ValueType::NUMBER: {
-            double num;
-            in.read(reinterpret_cast<char*>(&num), sizeof(num));
-            if (!in) {
-                throw std::runtime_error("Failed to read number from bytecode file");
-            }
-            return num;
+        uint32_t index = count(classes_.size());
+        classIndex_.emplace(&vmClass, index);
+        classes_.emplace_back();
+
+        ClassRecord record{};
+        record.name = addString(vmClass.className);
+        std::vector<uint32_t> list;
+        for (const auto& field : vmClass.fieldNames) {
+            list.push_back(addString(field));
         }
+        record.fieldFirst = addIndices(list);
+        record.fieldCount = count(list.size());
 
-        case ValueType::STRING:
-            return readString(in);
-
-        case ValueType::ARRAY: {
-            uint32_t size = readUint32(in);
-            auto arr = std::make_shared<Array>();
-            arr->elements.reserve(size);
-            for (uint32_t i = 0; i < size; ++i) {
-                arr->elements.push_back(readValue(in));
+        list.clear();
+        for (const auto& [field, defaultValue] : vmClass.fieldDefaults) {
+            list.push_back(addString(field));
+            list.push_back(addConstant(defaultValue));
+        }
+        record.defaultFirst = addIndices(list);
+        record.defaultCount = count(vmClass.fieldDefaults.size());
+
+        list.clear();
+        for (const auto& [methodName, method] : vmClass.methods) {
+            auto function = dynamicRefCast<VmUserFunction>(method);
+            if (!function) {
+                throw std::runtime_error("Cannot serialize native method '" + methodName + "'");
             }
-            return arr;
+            list.push_back(addString(methodName));
+            list.push_back(addFunction(*function));
         }
+        record.methodFirst = addIndices(list);
+        record.methodCount = count(vmClass.methods.size());
 
-        case ValueType::MAP: {
-            uint32_t size = readUint32(in);
-            auto map = std::make_shared<Map>();
-            for (uint32_t i = 0; i < size; ++i) {
-                std::string key = readString(in);
-                Value val = readValue(in);
-                map->entries[key] = val;
+        classes_[index] = record;
+        return index;
+    }
+};
+
+// A loaded image: its bytes, its section table and the strings decoded so
+// far.  Chunks loaded from it point into its Code section and keep it alive,
+// and a function's chunk goes back to it the first time the function is used
+// to decode its constants, names and line table.
+class ChunkSerializer::Image {
+   public:
+    Image(std::shared_ptr<void> bytes, unsigned char* data, size_t size) : bytes_(std::move(bytes)), data_(data) {
+        FileHeader header;
+        if (size < sizeof(header) + sizeof(sections_)) {
+            throw std::runtime_error("Invalid bytecode file: truncated header");
+        }
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, 4) != 0) {
+            throw std::runtime_error("Invalid bytecode file: magic number mismatch");
+        }
+        if (header.version != FORMAT_VERSION) {
+            throw std::runtime_error("Incompatible bytecode version: " + std::to_string(header.version));
+        }
+        if (header.size > size || header.size < sizeof(header) + sizeof(sections_)) {
+            throw std::runtime_error("Invalid bytecode file: truncated image");
+        }
+        if (checksum(data + CHECKSUM_START, header.size - CHECKSUM_START) != header.checksum) {
+            throw std::runtime_error("Invalid bytecode file: checksum mismatch");
+        }
+        std::memcpy(sections_, data + sizeof(header), sizeof(sections_));
+        for (const auto& section : sections_) {
+            if (section.offset > header.size || section.size > header.size - section.offset) {
+                throw std::runtime_error("Invalid bytecode file: section out of range");
             }
-            return map;
         }
+        strings_.resize(sections_[Strings].size / sizeof(StringRecord));
+    }
 
-        case ValueType::SET: {
-            uint32_t size = readUint32(in);
-            auto set = std::make_shared<Set>();
-            for (uint32_t i = 0; i < size; ++i) {
-                std::string key = readString(in);
-                Value val = readValue(in);
-                set->values[key] = val;
-            }
-            return set;
+    [[noreturn]] static void corrupt(const char* what) {
+        throw std::runtime_error(std::string("Invalid bytecode file: ") + what);
+    }
+
+    unsigned char* bytes(Section id, uint64_t offset, uint64_t size) const {
+        const SectionEntry& section = sections_[id];
+        if (offset > section.size || size > section.size - offset) {
+            corrupt("reference out of range");
         }
+        return data_ + section.offset + offset;
+    }
 
-        case ValueType::FUNCTION: {
-            std::string funcName = readString(in);
+    uint64_t count(Section id, size_t recordSize) const { return sections_[id].size / recordSize; }
 
-            // Read parameters
-            uint32_t paramCount = readUint32(in);
-            std::vector<std::string> params;
-            params.reserve(paramCount);
-            for (uint32_t i = 0; i < paramCount; ++i) {
-                params.push_back(readString(in));
-            }
+    template <typename T>
+    T record(Section id, uint64_t index) const {
+        T value;
+        std::memcpy(&value, bytes(id, index * sizeof(T), sizeof(T)), sizeof(T));
+        return value;
+    }
 
-            // Read function's chunk
-            Chunk funcChunk;
+    uint32_t indexAt(uint64_t position) const { return record<uint32_t>(Indices, position); }
 
-            // Read code section
-            uint32_t codeSize = readUint32(in);
-            funcChunk.code.reserve(codeSize);
-            for (uint32_t i = 0; i < codeSize; ++i) {
-                funcChunk.code.push_back(readUint8(in));
-            }
+    // Decoded on first reference, then shared
+    const Value& string(uint32_t index) {
+        if (index >= strings_.size()) {
+            corrupt("string index out of range");
+        }
+        Value& str = strings_[index];
+        if (str.isNil()) {
+            auto entry = record<StringRecord>(Strings, index);
+            str = std::string(reinterpret_cast<const char*>(bytes(StringData, entry.offset, entry.length)),
+                              entry.length);
+        }
+        return str;
+    }
 
-            // Read constants section
-            uint32_t constCount = readUint32(in);
-            funcChunk.constants.reserve(constCount);
-            for (uint32_t i = 0; i < constCount; ++i) {
-                funcChunk.constants.push_back(readValue(in));
-            }
+   private:
+    std::shared_ptr<void> bytes_;  // The mapping or buffer data_ points into
+    unsigned char* data_;
+    SectionEntry sections_[SECTION_COUNT];
+    std::vector<Value> strings_;
+};
+
+// Decodes chunks from an Image.  A script decodes its own chunk and the
+// values it needs at once; functions get chunks whose code already points
+// into the image and whose other parts are decoded by another Reader when
+// the function is first used.
+class ChunkSerializer::Reader {
+   public:
+    explicit Reader(std::shared_ptr<Image> image) : image_(std::move(image)) {}
+
+    Chunk readScript() {
+        if (image_->count(Chunks, sizeof(ChunkRecord)) == 0) {
+            Image::corrupt("no script chunk");
+        }
+        Chunk script;
+        readCode(0, script);
+        readChunk(0, script);
+        return script;
+    }
 
-            // Read names section
-            uint32_t namesCount = readUint32(in);
-            funcChunk.names.reserve(namesCount);
-            for (uint32_t i = 0; i < namesCount; ++i) {
-                funcChunk.names.push_back(readString(in));
+    void readChunk(uint32_t index, Chunk& chunk) {
+        auto record = image_->record<ChunkRecord>(Chunks, index);
+        chunk.constants.reserve(record.constantCount);
+        for (uint32_t i = 0; i < record.constantCount; ++i) {
+            chunk.constants.push_back(constant(uint64_t{record.constantFirst} + i));
+        }
+        chunk.names = names(record.nameFirst, record.nameCount);
+
+        chunk.exceptionTable.resize(record.handlerCount);
+        std::memcpy(chunk.exceptionTable.data(),
+                    image_->bytes(Handlers, uint64_t{record.handlerFirst} * sizeof(ExceptionTableEntry),
+                                  uint64_t{record.handlerCount} * sizeof(ExceptionTableEntry)),
+                    record.handlerCount * sizeof(ExceptionTableEntry));
+
+        const unsigned char* pos = image_->bytes(Lines, record.lineOffset, record.lineSize);
+        const unsigned char* end = pos + record.lineSize;
+        auto varint = [&]() {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                if (pos == end) {
+                    Image::corrupt("truncated line table");
+                }
+                uint8_t byte = *pos++;
+                value |= uint64_t{byte & 0x7Fu} << shift;
+                if (!(byte & 0x80)) {
+                    return value;
+                }
+            }
+            Image::corrupt("bad line table");
+        };
+        chunk.lines.reserve(record.codeSize);
+        int64_t line = 0;
+        while (pos != end) {
+            uint64_t run = varint();
+            uint64_t zigzag = varint();
+            if (run > record.codeSize - chunk.lines.size()) {
+                Image::corrupt("line table longer than code");
             }
+            line += static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+            chunk.lines.insert(chunk.lines.end(), run, static_cast<int>(line));
+        }
+    }
 
-            auto funcChunkPtr = std::make_shared<Chunk>(std::move(funcChunk));
-            return std::make_shared<VmUserFunction>(funcName, params, funcChunkPtr);
+   private:
+    std::shared_ptr<Image> image_;
+    // Values this Reader made, so that a function, class or chunk referred to
+    // twice is one object
+    std::unordered_map<uint32_t, std::shared_ptr<Chunk>> chunks_;
+    std::unordered_map<uint32_t, Value> functions_;
+    std::unordered_map<uint32_t, Value> classes_;
+    int depth_ = 0;
+
+    const std::string& name(uint32_t index) { return image_->string(index).asString(); }
+
+    std::vector<std::string> names(uint32_t first, uint32_t count) {
+        std::vector<std::string> list;
+        list.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            list.push_back(name(image_->indexAt(uint64_t{first} + i)));
         }
+        return list;
+    }
+
+    void readCode(uint32_t index, Chunk& chunk) {
+        auto record = image_->record<ChunkRecord>(Chunks, index);
+        chunk.code.view(image_->bytes(Code, record.codeOffset, record.codeSize), record.codeSize, image_);
+    }
 
-        case ValueType::NATIVE_FUNCTION: {
-            // For native functions, we can't restore them from name alone
-            // They need to be registered during VM initialization
-            std::string funcName = readString(in);
-            throw std::runtime_error("Cannot deserialize native function '" + funcName +
-                                     "': native functions must be registered at runtime");
+    std::shared_ptr<Chunk> chunkAt(uint32_t index) {
+        if (index >= image_->count(Chunks, sizeof(ChunkRecord))) {
+            Image::corrupt("chunk index out of range");
         }
+        auto& chunk = chunks_[index];
+        if (!chunk) {
+            chunk = std::make_shared<Chunk>();
+            readCode(index, *chunk);
+            chunk->undecoded = [image = image_, index](Chunk& self) { Reader(image).readChunk(index, self); };
+        }
+        return chunk;
+    }
 
-        case ValueType::CLASS: {
-            std::string className = readString(in);
+    Value constant(uint64_t index) {
+        // Every cycle through functions, classes and nested values passes here
+        if (++depth_ > MAX_CONSTANT_DEPTH) {
+            Image::corrupt("constants nested too deeply");
+        }
+        Value value = readConstant(image_->record<ConstantRecord>(Constants, index));
+        --depth_;
+        return value;
+    }
 
-            // Read field names
-            uint32_t fieldCount = readUint32(in);
-            std::vector<std::string> fieldNames;
-            fieldNames.reserve(fieldCount);
-            for (uint32_t i = 0; i < fieldCount; ++i) {
-                fieldNames.push_back(readString(in));
+    Value readConstant(const ConstantRecord& constant) {
+        switch (static_cast<ValueType>(constant.tag)) {
+            case ValueType::NIL:
+                return Nil{};
+
+            case ValueType::BOOL:
+                return constant.a != 0;
+
+            case ValueType::NUMBER: {
+                double number;
+                std::memcpy(&number, &constant.b, sizeof(number));
+                return number;
+            }
+
+            case ValueType::STRING:
+                return image_->string(constant.a);
+
+            case ValueType::ARRAY: {
+                auto arr = makeRef<Array>();
+                arr->elements.reserve(constant.b);
+                for (uint64_t i = 0; i < constant.b; ++i) {
+                    arr->elements.push_back(this->constant(image_->indexAt(constant.a + i)));
+                }
+                return arr;
             }
 
-            // Read field defaults
-            uint32_t defaultCount = readUint32(in);
-            std::unordered_map<std::string, Value> fieldDefaults;
-            for (uint32_t i = 0; i < defaultCount; ++i) {
-                std::string fieldName = readString(in);
-                Value defaultValue = readValue(in);
-                fieldDefaults[fieldName] = defaultValue;
+            case ValueType::MAP: {
+                auto map = makeRef<Map>();
+                for (uint64_t i = 0; i < constant.b; ++i) {
+                    const std::string& key = name(image_->indexAt(constant.a + 2 * i));
+                    map->entries[key] = this->constant(image_->indexAt(constant.a + 2 * i + 1));
+                }
+                return map;
             }
 
-            // Read methods
-            uint32_t methodCount = readUint32(in);
-            std::unordered_map<std::string, std::shared_ptr<VmCallable>> methods;
-            for (uint32_t i = 0; i < methodCount; ++i) {
-                std::string methodName = readString(in);
-                Value methodValue = readValue(in);
-
-                // Convert Value to VmCallable
-                if (std::holds_alternative<std::shared_ptr<VmCallable>>(methodValue)) {
-                    methods[methodName] = std::get<std::shared_ptr<VmCallable>>(methodValue);
-                } else {
-                    throw std::runtime_error("Class method is not a callable");
+            case ValueType::SET: {
+                auto set = makeRef<Set>();
+                for (uint64_t i = 0; i < constant.b; ++i) {
+                    const std::string& key = name(image_->indexAt(constant.a + 2 * i));
+                    set->values[key] = this->constant(image_->indexAt(constant.a + 2 * i + 1));
                 }
+                return set;
             }
 
-            return std::make_shared<VmClass>(className, nullptr, fieldNames, fieldDefaults, methods);
-        }
+            case ValueType::FUNCTION:
+                return function(constant.a);
 
-        case ValueType::ERROR: {
-            std::string message = readString(in);
-            std::string errorType = readString(in);
-            return std::make_shared<Error>(message, errorType);
+            case ValueType::CLASS:
+                return vmClass(constant.a);
+
+            case ValueType::ERROR:
+                return makeRef<Error>(name(constant.a), name(static_cast<uint32_t>(constant.b)));
+
+            default:
+                throw std::runtime_error("Unknown value type tag: " + std::to_string(constant.tag));
         }
+    }
 
-        default:
-            throw std::runtime_error("Unknown value type tag: " + std::to_string(typeTag));
+    Value function(uint32_t index) {
+        if (index >= image_->count(Functions, sizeof(FunctionRecord))) {
+            Image::corrupt("function index out of range");
+        }
+        Value& function = functions_[index];
+        if (function.isNil()) {
+            auto record = image_->record<FunctionRecord>(Functions, index);
+            std::vector<UpvalueDesc> upvalueDescs;
+            upvalueDescs.reserve(record.upvalueCount);
+            for (uint32_t i = 0; i < record.upvalueCount; ++i) {
+                uint32_t desc = image_->indexAt(uint64_t{record.upvalueFirst} + i);
+                upvalueDescs.push_back(
+                    UpvalueDesc{static_cast<uint8_t>(desc & 0xFF), (desc & LOCAL_UPVALUE) != 0});
+            }
+            function = makeRef<VmUserFunction>(name(record.name), names(record.paramFirst, record.paramCount),
+                                               chunkAt(record.chunk), std::move(upvalueDescs));
+        }
+        return function;
     }
-}
 
-// Main serialization methods
-bool ChunkSerializer::serializeToFile(const Chunk& chunk, const std::string& filepath) {
-    std::ofstream out(filepath, std::ios::binary);
-    if (!out) {
-        return false;
+    Value vmClass(uint32_t index) {
+        if (index >= image_->count(Classes, sizeof(ClassRecord))) {
+            Image::corrupt("class index out of range");
+        }
+        if (auto it = classes_.find(index); it != classes_.end()) {
+            return it->second;
+        }
+        auto record = image_->record<ClassRecord>(Classes, index);
+        std::unordered_map<std::string, Value> fieldDefaults;
+        for (uint32_t i = 0; i < record.defaultCount; ++i) {
+            uint64_t pair = record.defaultFirst + uint64_t{2} * i;
+            fieldDefaults[name(image_->indexAt(pair))] = constant(image_->indexAt(pair + 1));
+        }
+        std::unordered_map<std::string, Ref<VmCallable>> methods;
+        for (uint32_t i = 0; i < record.methodCount; ++i) {
+            uint64_t pair = record.methodFirst + uint64_t{2} * i;
+            methods[name(image_->indexAt(pair))] = function(image_->indexAt(pair + 1)).asVmCallable();
+        }
+        Value vmClass = makeRef<VmClass>(name(record.name), nullptr, names(record.fieldFirst, record.fieldCount),
+                                         std::move(fieldDefaults), std::move(methods));
+        classes_.emplace(index, vmClass);
+        return vmClass;
+    }
+};
+
+namespace {
+
+// A whole file in memory: a private copy-on-write mapping where the platform
+// allows it, so quickening a loaded chunk never writes the file, and a buffer
+// read from the file otherwise
+class FileImage {
+   public:
+    explicit FileImage(const std::string& filepath) {
+#ifndef _WIN32
+        int fd = ::open(filepath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Could not open bytecode file: " + filepath);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+            size_ = static_cast<size_t>(info.st_size);
+            void* mapping = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                mapping_ = mapping;
+                data_ = static_cast<unsigned char*>(mapping);
+            }
+        }
+        ::close(fd);
+        if (mapping_) {
+            return;
+        }
+#endif
+        std::ifstream in(filepath, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("Could not open bytecode file: " + filepath);
+        }
+        std::ostringstream contents;
+        contents << in.rdbuf();
+        buffer_ = contents.str();
+        data_ = reinterpret_cast<unsigned char*>(buffer_.data());
+        size_ = buffer_.size();
     }
 
-    try {
-        // Write magic number
-        out.write(MAGIC, 4);
+    ~FileImage() {
+#ifndef _WIN32
+        if (mapping_) {
+            ::munmap(mapping_, size_);
+        }
+#endif
+    }
 
-        // Write version
-        writeUint32(out, FORMAT_VERSION);
+    FileImage(const FileImage&) = delete;
+    FileImage& operator=(const FileImage&) = delete;
 
-        // Write code section
-        writeUint32(out, static_cast<uint32_t>(chunk.code.size()));
-        for (uint8_t byte : chunk.code) {
-            writeUint8(out, byte);
-        }
+    unsigned char* data() { return data_; }
+    size_t size() const { return size_; }
 
-        // Write constants section
-        writeUint32(out, static_cast<uint32_t>(chunk.constants.size()));
-        for (const auto& constant : chunk.constants) {
-            writeValue(out, constant);
-        }
+   private:
+    void* mapping_ = nullptr;
+    std::string buffer_;
+    unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+};
 
-        // Write names section
-        writeUint32(out, static_cast<uint32_t>(chunk.names.size()));
-        for (const auto& name : chunk.names) {
-            writeString(out, name);
-        }
+}  // namespace
 
-        return out.good();
-    } catch (const std::exception& e) {
-        return false;
-    }
+Chunk ChunkSerializer::load(std::shared_ptr<std::string> buffer) {
+    auto* data = reinterpret_cast<unsigned char*>(buffer->data());
+    size_t size = buffer->size();
+    return Reader(std::make_shared<Image>(std::move(buffer), data, size)).readScript();
 }
 
-Chunk ChunkSerializer::deserializeFromFile(const std::string& filepath) {
-    std::ifstream in(filepath, std::ios::binary);
-    if (!in) {
-        throw std::runtime_error("Could not open bytecode file: " + filepath);
-    }
+std::string ChunkSerializer::serialize(const Chunk& chunk) {
+    return Writer().write(chunk);
+}
 
-    // Read and verify magic number
-    char magic[4];
-    in.read(magic, 4);
-    if (!in || std::memcmp(magic, MAGIC, 4) != 0) {
-        throw std::runtime_error("Invalid bytecode file: magic number mismatch");
-    }
+Chunk ChunkSerializer::deserialize(const void* data, size_t size) {
+    // Loaded code is quickened in place, so it cannot stay in read-only memory
+    auto* bytes = static_cast<const char*>(data);
+    return load(std::make_shared<std::string>(bytes, size));
+}
 
-    // Read and verify version
-    uint32_t version = readUint32(in);
-    if (version != FORMAT_VERSION) {
-        throw std::runtime_error("Incompatible bytecode version: " + std::to_string(version));
-    }
+void ChunkSerializer::serialize(const Chunk& chunk, std::ostream& out) {
+    std::string image = serialize(chunk);
+    out.write(image.data(), static_cast<std::streamsize>(image.size()));
+}
 
-    Chunk chunk;
+Chunk ChunkSerializer::deserialize(std::istream& in) {
+    std::ostringstream rest;
+    rest << in.rdbuf();
+    return load(std::make_shared<std::string>(std::move(rest).str()));
+}
 
-    // Read code section
-    uint32_t codeSize = readUint32(in);
-    chunk.code.reserve(codeSize);
-    for (uint32_t i = 0; i < codeSize; ++i) {
-        chunk.code.push_back(readUint8(in));
+bool ChunkSerializer::serializeToFile(const Chunk& chunk, const std::string& filepath) {
+    std::ofstream out(filepath, std::ios::binary);
+    if (!out) {
+        return false;
     }
 
-    // Read constants section
-    uint32_t constCount = readUint32(in);
-    chunk.constants.reserve(constCount);
-    for (uint32_t i = 0; i < constCount; ++i) {
-        chunk.constants.push_back(readValue(in));
+    try {
+        serialize(chunk, out);
+        return out.good();
+    } catch (const std::exception& e) {
+        return false;
     }
+}
 
-    // Read names section
-    uint32_t namesCount = readUint32(in);
-    chunk.names.reserve(namesCount);
-    for (uint32_t i = 0; i < namesCount; ++i) {
-        chunk.names.push_back(readString(in));
+Chunk ChunkSerializer::deserializeFromFile(const std::string& filepath, size_t offset) {
+    auto file = std::make_shared<FileImage>(filepath);
+    if (offset > file->size()) {
+        throw std::runtime_error("Invalid bytecode file: truncated image");
     }
-
-    return chunk;
+    unsigned char* data = file->data() + offset;
+    size_t size = file->size() - offset;
+    return Reader(std::make_shared<Image>(std::move(file), data, size)).readScript();
 }
 
 }  // namespace izi
@@ -1,26 +1,52 @@
 #pragma once
 
 #include "chunk.hpp"
+#include "opcode.hpp"
 #include <string>
-#include <fstream>
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <ostream>
 
 namespace izi {
 
 /**
  * ChunkSerializer - Serialize and deserialize bytecode chunks to/from binary format
  *
- * Binary format (.izb file):
- * - Magic number: "IZB\0" (4 bytes)
- * - Version: uint32_t (4 bytes)
- * - Code section size: uint32_t (4 bytes)
- * - Code bytes: uint8_t[] (variable)
- * - Constants section size: uint32_t (4 bytes)
- * - Constants: serialized Value[] (variable)
- * - Names section size: uint32_t (4 bytes)
- * - Names: serialized string[] (variable)
+ * Binary format (.izb file), little-endian, every part aligned to 8 bytes:
+ * - Header: magic "IZB\0", uint32_t version, uint64_t checksum of everything
+ *   after it, uint64_t image size
+ * - Section directory: (offset, size) uint64_t pair per Section, in order
+ * - Sections:
+ *   - Strings / StringData: (offset, length) records into one blob holding
+ *     every distinct string once
+ *   - Chunks: fixed-size records locating each chunk's code, constants,
+ *     names, exception table and line table.  Chunk 0 is the script;
+ *     functions and methods refer to the others by index.
+ *   - Code: the bytecode of all chunks, back to back
+ *   - Constants: 16-byte records; strings, functions, classes and the
+ *     elements of arrays, maps and sets are indices into other sections
+ *   - Functions / Classes: fixed-size records for function and class constants
+ *   - Indices: uint32_t lists referenced by the records above
+ *   - Handlers: exception table entries, stored as ExceptionTableEntry
+ *   - Lines: per chunk, (run length, line delta) varint pairs
+ *
+ * Files are mapped with mmap where available (privately, so quickening never
+ * writes them back).  A loaded chunk's code points into the Code section
+ * rather than being copied out.  The script's constants, names and line
+ * table are decoded at load, but a function's are decoded the first time the
+ * function is used; a string becomes a Value or name the first time something
+ * decoded refers to it, and then is shared.
  */
 class ChunkSerializer {
    public:
+    // Binary format version
+    static constexpr uint32_t FORMAT_VERSION = 6;  // v6: section table layout, shared strings
+    // Opcode numbers and operand widths are part of the format.  When this
+    // check fails, bump FORMAT_VERSION and record the new fingerprint.
+    static constexpr uint64_t OPCODE_FINGERPRINT = 0xea425be05ec7d440ull;
+    static_assert(opcodeFingerprint() == OPCODE_FINGERPRINT, "Opcodes changed: bump ChunkSerializer::FORMAT_VERSION");
+
     /**
      * Serialize a chunk to a binary file
      * @param chunk The chunk to serialize
@@ -32,14 +58,37 @@ class ChunkSerializer {
     /**
      * Deserialize a chunk from a binary file
      * @param filepath Path to .izb file
+     * @param offset Where the image starts in the file (after a container's own header)
      * @return The deserialized chunk
      * @throws std::runtime_error if file cannot be read or format is invalid
      */
-    static Chunk deserializeFromFile(const std::string& filepath);
+    static Chunk deserializeFromFile(const std::string& filepath, size_t offset = 0);
+
+    /**
+     * Serialize a chunk to an in-memory image in the .izb format
+     * @param chunk The chunk to serialize
+     * @return The bytes of the image
+     * @throws std::runtime_error if the chunk holds a value that cannot be serialized
+     */
+    static std::string serialize(const Chunk& chunk);
+
+    /**
+     * Deserialize a chunk from an in-memory image (e.g. bytecode embedded in an
+     * executable by `izi compile --bytecode`).  The image is copied once, since
+     * the VM quickens loaded code in place.
+     * @param data Start of the image
+     * @param size Size of the image in bytes
+     * @return The deserialized chunk
+     * @throws std::runtime_error if the format is invalid
+     */
+    static Chunk deserialize(const void* data, size_t size);
+
+    // Stream forms of the above, for containers that add their own framing
+    // (see BytecodeCache)
+    static void serialize(const Chunk& chunk, std::ostream& out);
+    static Chunk deserialize(std::istream& in);
 
    private:
-    // Binary format version
-    static constexpr uint32_t FORMAT_VERSION = 1;
     static constexpr char MAGIC[4] = {'I', 'Z', 'B', '\0'};
 
     // Value type tags for serialization
@@ -58,17 +107,26 @@ class ChunkSerializer {
         ERROR = 11  // Error
     };
 
-    // Helper methods for writing
-    static void writeUint32(std::ofstream& out, uint32_t value);
-    static void writeUint8(std::ofstream& out, uint8_t value);
-    static void writeString(std::ofstream& out, const std::string& str);
-    static void writeValue(std::ofstream& out, const Value& value);
+    enum Section : uint32_t {
+        Strings,
+        StringData,
+        Chunks,
+        Code,
+        Constants,
+        Functions,
+        Classes,
+        Indices,
+        Handlers,
+        Lines,
+        SECTION_COUNT
+    };
+
+    // Builds and parses images (chunk_serializer.cpp)
+    class Writer;
+    class Image;
+    class Reader;
 
-    // Helper methods for reading
-    static uint32_t readUint32(std::ifstream& in);
-    static uint8_t readUint8(std::ifstream& in);
-    static std::string readString(std::ifstream& in);
-    static Value readValue(std::ifstream& in);
+    static Chunk load(std::shared_ptr<std::string> buffer);
 };
 
 }  // namespace izi
@@ -10,6 +10,10 @@ void Disassembler::disassemble(const Chunk& chunk, const std::string& name, std:
     for (size_t offset = 0; offset < chunk.code.size();) {
         offset = disassembleInstruction(chunk, offset, out);
     }
+    for (const auto& entry : chunk.exceptionTable) {
+        out << "try [" << std::setw(4) << std::setfill('0') << entry.start << ", " << std::setw(4) << entry.end
+            << ") -> " << std::setw(4) << entry.handler << std::setfill(' ') << " stack " << entry.stackDepth << '\n';
+    }
 }
 
 // Helper: format an offset as a 4-digit zero-padded decimal.
@@ -51,13 +55,13 @@ static size_t constantInstruction(const std::string& name, const Chunk& chunk, s
         out << " (";
         // Format the constant value inline
         const Value& v = chunk.constants[idx];
-        if (std::holds_alternative<double>(v)) {
-            out << std::get<double>(v);
-        } else if (std::holds_alternative<bool>(v)) {
-            out << (std::get<bool>(v) ? "true" : "false");
-        } else if (std::holds_alternative<std::string>(v)) {
-            out << '"' << std::get<std::string>(v) << '"';
-        } else if (std::holds_alternative<Nil>(v)) {
+        if (v.isNumber()) {
+            out << v.asNumber();
+        } else if (v.isBool()) {
+            out << (v.asBool() ? "true" : "false");
+        } else if (v.isString()) {
+            out << '"' << v.asString() << '"';
+        } else if (v.isNil()) {
             out << "nil";
         }
         out << ")";
@@ -138,6 +142,12 @@ size_t Disassembler::disassembleInstruction(const Chunk& chunk, size_t offset, s
             return byteInstruction("GET_LOCAL", chunk, offset, out);
         case OpCode::SET_LOCAL:
             return byteInstruction("SET_LOCAL", chunk, offset, out);
+        case OpCode::GET_UPVALUE:
+            return byteInstruction("GET_UPVALUE", chunk, offset, out);
+        case OpCode::SET_UPVALUE:
+            return byteInstruction("SET_UPVALUE", chunk, offset, out);
+        case OpCode::CLOSE_UPVALUE:
+            return simpleInstruction("CLOSE_UPVALUE", offset, out);
         case OpCode::INDEX:
             return simpleInstruction("INDEX", offset, out);
         case OpCode::SET_INDEX:
@@ -150,32 +160,23 @@ size_t Disassembler::disassembleInstruction(const Chunk& chunk, size_t offset, s
             return jumpInstruction("LOOP", -1, chunk, offset, out);
         case OpCode::CALL:
             return byteInstruction("CALL", chunk, offset, out);
+        case OpCode::INVOKE: {
+            uint8_t nameIdx = chunk.code[offset + 1];
+            std::string methodName = (nameIdx < chunk.names.size()) ? chunk.names[nameIdx] : "?";
+            out << std::left << std::setw(20) << "INVOKE"
+                << " '" << methodName << "' (" << static_cast<int>(chunk.code[offset + 2]) << " args)\n";
+            return offset + 3;
+        }
+        case OpCode::CLOSURE:
+            return byteInstruction("CLOSURE", chunk, offset, out);
         case OpCode::RETURN:
             return simpleInstruction("RETURN", offset, out);
         case OpCode::POP:
             return simpleInstruction("POP", offset, out);
         case OpCode::PRINT:
             return simpleInstruction("PRINT", offset, out);
-        case OpCode::TRY: {
-            // TRY opcode layout: catch-offset (2 bytes) + finally-offset (2 bytes) +
-            // catch-var index (1 byte).  Display each field for debugging clarity.
-            uint16_t catchOff = (static_cast<uint16_t>(chunk.code[offset + 1]) << 8) |
-                                 static_cast<uint16_t>(chunk.code[offset + 2]);
-            uint16_t finallyOff = (static_cast<uint16_t>(chunk.code[offset + 3]) << 8) |
-                                   static_cast<uint16_t>(chunk.code[offset + 4]);
-            uint8_t catchVar = chunk.code[offset + 5];
-            std::string catchVarName =
-                (catchVar < chunk.names.size()) ? chunk.names[catchVar] : "?";
-            out << std::left << std::setw(20) << "TRY"
-                << " catch->" << fmtOffset(offset + 6 + catchOff)
-                << " finally->" << fmtOffset(offset + 6 + finallyOff)
-                << " var='" << catchVarName << "'\n";
-            return offset + 6;
-        }
         case OpCode::THROW:
             return simpleInstruction("THROW", offset, out);
-        case OpCode::END_TRY:
-            return simpleInstruction("END_TRY", offset, out);
         case OpCode::GET_PROPERTY:
             return namedInstruction("GET_PROPERTY", chunk, offset, out);
         case OpCode::SET_PROPERTY:
@@ -190,8 +191,48 @@ size_t Disassembler::disassembleInstruction(const Chunk& chunk, size_t offset, s
             return byteInstruction("BUILD_ARRAY", chunk, offset, out);
         case OpCode::BUILD_MAP:
             return byteInstruction("BUILD_MAP", chunk, offset, out);
+        case OpCode::GET_LOCAL_0:
+            return simpleInstruction("GET_LOCAL_0", offset, out);
+        case OpCode::GET_LOCAL_1:
+            return simpleInstruction("GET_LOCAL_1", offset, out);
+        case OpCode::GET_LOCAL_2:
+            return simpleInstruction("GET_LOCAL_2", offset, out);
+        case OpCode::GET_LOCAL_3:
+            return simpleInstruction("GET_LOCAL_3", offset, out);
+        case OpCode::GET_LOCAL_PROPERTY: {
+            uint8_t slot = chunk.code[offset + 1];
+            uint8_t nameIdx = chunk.code[offset + 2];
+            std::string propName = (nameIdx < chunk.names.size()) ? chunk.names[nameIdx] : "?";
+            out << std::left << std::setw(20) << "GET_LOCAL_PROPERTY"
+                << " " << static_cast<int>(slot) << " '" << propName << "'\n";
+            return offset + 3;
+        }
+        case OpCode::ADD_CONST:
+            return constantInstruction("ADD_CONST", chunk, offset, out);
+        case OpCode::SET_GLOBAL_POP:
+            return namedInstruction("SET_GLOBAL_POP", chunk, offset, out);
+        case OpCode::POP_JUMP_IF_FALSE:
+            return jumpInstruction("POP_JUMP_IF_FALSE", 1, chunk, offset, out);
+        case OpCode::LESS_CONST_JUMP: {
+            uint8_t idx = chunk.code[offset + 1];
+            uint16_t jump = (static_cast<uint16_t>(chunk.code[offset + 2]) << 8) |
+                            static_cast<uint16_t>(chunk.code[offset + 3]);
+            out << std::left << std::setw(20) << "LESS_CONST_JUMP"
+                << " " << static_cast<int>(idx);
+            if (idx < chunk.constants.size() && chunk.constants[idx].isNumber()) {
+                out << " (" << chunk.constants[idx].asNumber() << ")";
+            }
+            out << " -> " << fmtOffset(offset + 4 + jump) << '\n';
+            return offset + 4;
+        }
         case OpCode::JUMP_IF_NOT_NIL:
             return jumpInstruction("JUMP_IF_NOT_NIL", 1, chunk, offset, out);
+        case OpCode::ADD_NUM:
+            return simpleInstruction("ADD_NUM", offset, out);
+        case OpCode::LESS_NUM:
+            return simpleInstruction("LESS_NUM", offset, out);
+        case OpCode::INDEX_ARRAY_NUM:
+            return simpleInstruction("INDEX_ARRAY_NUM", offset, out);
         default:
             out << "UNKNOWN(" << static_cast<int>(chunk.code[offset]) << ")\n";
             return offset + 1;
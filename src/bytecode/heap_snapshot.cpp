@@ -0,0 +1,830 @@
+#include "heap_snapshot.hpp"
+#include "chunk_serializer.hpp"
+#include "vm_class.hpp"
+#include "vm_native.hpp"
+#include "vm_native_modules.hpp"
+#include "vm_user_function.hpp"
+#include "common/cli.hpp"
+#include "common/error.hpp"
+#include "interp/izi_class.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace izi {
+
+namespace {
+
+// Value encoding: inline for nil, booleans, numbers and strings, an object
+// number for everything else
+enum class Tag : uint8_t { Nil, False, True, Number, String, Object };
+
+enum class Kind : uint8_t {
+    Array,
+    Map,
+    Set,
+    Instance,
+    Function,  // VmUserFunction: prototype number and upvalue cells
+    Native,  // VmNativeFunction: module and name
+    BoundMethod,
+    Class,
+    Error,
+    Mutex,
+    Upvalue,  // Closed upvalue cell shared by closures
+};
+
+// Kinds whose allocation record says everything about them
+bool hasContents(Kind kind) {
+    return kind != Kind::Function && kind != Kind::Native && kind != Kind::Mutex;
+}
+
+void writeUint32(std::string& out, uint32_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void writeString(std::string& out, const std::string& str) {
+    writeUint32(out, static_cast<uint32_t>(str.size()));
+    out += str;
+}
+
+// Bounds-checked reader over the snapshot bytes
+class Cursor {
+   public:
+    Cursor(const unsigned char* data, size_t size) : pos_(data), end_(data + size) {}
+
+    const unsigned char* take(size_t size) {
+        if (size > static_cast<size_t>(end_ - pos_)) {
+            throw std::runtime_error("Invalid snapshot: unexpected end of file");
+        }
+        const unsigned char* start = pos_;
+        pos_ += size;
+        return start;
+    }
+
+    uint8_t u8() { return *take(1); }
+
+    uint32_t u32() {
+        uint32_t value;
+        std::memcpy(&value, take(sizeof(value)), sizeof(value));
+        return value;
+    }
+
+    double f64() {
+        double value;
+        std::memcpy(&value, take(sizeof(value)), sizeof(value));
+        return value;
+    }
+
+    std::string str() {
+        uint32_t size = u32();
+        return std::string(reinterpret_cast<const char*>(take(size)), size);
+    }
+
+   private:
+    const unsigned char* pos_;
+    const unsigned char* end_;
+};
+
+// Identity of a heap value: the address of the object it refers to
+const void* objectKey(const Value& value) {
+    switch (value.type()) {
+        case Value::Type::Array:
+            return value.asArray().get();
+        case Value::Type::Map:
+            return value.asMap().get();
+        case Value::Type::Set:
+            return value.asSet().get();
+        case Value::Type::Instance:
+            return value.asInstance().get();
+        case Value::Type::Error:
+            return value.asError().get();
+        case Value::Type::Mutex:
+            return value.asMutex().get();
+        case Value::Type::VmClass:
+            return dynamic_cast<const void*>(value.asVmClass().get());
+        case Value::Type::VmCallable:
+            return dynamic_cast<const void*>(value.asVmCallable().get());
+        default:
+            return nullptr;
+    }
+}
+
+// Global natives of a fresh VM, by name
+std::unordered_map<std::string, Value> builtinNatives() {
+    VM vm;
+    registerVmNatives(vm);
+    return vm.getGlobals();
+}
+
+bool isBuiltinGlobal(const std::string& name, const Value& value) {
+    if (!value.isVmCallable()) {
+        return false;
+    }
+    auto* native = dynamic_cast<const VmNativeFunction*>(value.asVmCallable().get());
+    return native && native->module().empty() && native->name() == name;
+}
+
+}  // namespace
+
+class HeapSnapshot::Writer {
+   public:
+    explicit Writer(const VM& vm) : vm_(vm) {}
+
+    std::string write() {
+        std::vector<std::pair<std::string, Value>> globals;
+        for (auto& [name, value] : vm_.getGlobals()) {
+            if (!isBuiltinGlobal(name, value)) {
+                globals.emplace_back(name, value);
+            }
+        }
+        std::sort(globals.begin(), globals.end(),
+                  [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        // Number every object reachable from the globals
+        for (const auto& [name, value] : globals) {
+            discover(value);
+        }
+        while (!pending_.empty()) {
+            uint32_t id = pending_.back();
+            pending_.pop_back();
+            visit(id);
+        }
+
+        out_.append(MAGIC, 4);
+        writeUint32(out_, FORMAT_VERSION);
+        writeString(out_, IZILANG_VERSION);
+        writeString(out_, ChunkSerializer::serialize(prototypes_));
+
+        // Cells and classes before the closures that capture them, classes
+        // before the instances that take their shape
+        writeUint32(out_, static_cast<uint32_t>(objects_.size()));
+        for (uint32_t id = 0; id < objects_.size(); ++id) {
+            if (objects_[id].kind != Kind::Function) {
+                writeAllocation(id);
+            }
+        }
+        for (uint32_t id = 0; id < objects_.size(); ++id) {
+            if (objects_[id].kind == Kind::Function) {
+                writeAllocation(id);
+            }
+        }
+        for (uint32_t id = 0; id < objects_.size(); ++id) {
+            if (objects_[id].kind == Kind::Class) {
+                writeContents(id);
+            }
+        }
+        for (uint32_t id = 0; id < objects_.size(); ++id) {
+            if (objects_[id].kind != Kind::Class && hasContents(objects_[id].kind)) {
+                writeContents(id);
+            }
+        }
+
+        writeUint32(out_, static_cast<uint32_t>(globals.size()));
+        for (const auto& [name, value] : globals) {
+            writeString(out_, name);
+            writeValue(value);
+        }
+        return std::move(out_);
+    }
+
+   private:
+    struct Object {
+        Kind kind;
+        Value value;  // Keeps the object alive while numbering
+        Ref<Upvalue> cell = nullptr;  // Kind::Upvalue only
+        uint32_t prototype = 0;  // Kind::Function only
+    };
+
+    const VM& vm_;
+    std::vector<Object> objects_;
+    std::unordered_map<const void*, uint32_t> ids_;
+    std::vector<uint32_t> pending_;
+    Chunk prototypes_;  // Constants: one function per chunk closures run
+    std::unordered_map<const Chunk*, uint32_t> prototypeIndex_;
+    std::unordered_map<std::string, Value> builtins_;
+    std::string out_;
+
+    [[noreturn]] static void unsupported(const std::string& what) {
+        throw std::runtime_error("Cannot snapshot " + what);
+    }
+
+    uint32_t add(const void* key, Object object) {
+        auto [it, inserted] = ids_.try_emplace(key, static_cast<uint32_t>(objects_.size()));
+        if (inserted) {
+            objects_.push_back(std::move(object));
+            pending_.push_back(it->second);
+        }
+        return it->second;
+    }
+
+    void discover(const Value& value) {
+        switch (value.type()) {
+            case Value::Type::Nil:
+            case Value::Type::Bool:
+            case Value::Type::Number:
+            case Value::Type::String:
+                return;
+            case Value::Type::Array:
+                add(objectKey(value), {Kind::Array, value});
+                return;
+            case Value::Type::Map:
+                add(objectKey(value), {Kind::Map, value});
+                return;
+            case Value::Type::Set:
+                add(objectKey(value), {Kind::Set, value});
+                return;
+            case Value::Type::Instance:
+                add(objectKey(value), {Kind::Instance, value});
+                return;
+            case Value::Type::Error:
+                add(objectKey(value), {Kind::Error, value});
+                return;
+            case Value::Type::Mutex:
+                add(objectKey(value), {Kind::Mutex, value});
+                return;
+            case Value::Type::VmClass:
+                add(objectKey(value), {Kind::Class, value});
+                return;
+            case Value::Type::VmCallable:
+                discoverCallable(value);
+                return;
+            default:
+                unsupported("a value of type " + getTypeName(value));
+        }
+    }
+
+    void discoverCallable(const Value& value) {
+        const auto& callable = value.asVmCallable();
+        if (ids_.contains(objectKey(value))) {
+            return;
+        }
+        if (auto function = dynamicRefCast<VmUserFunction>(callable)) {
+            const Chunk* chunk = &function->getChunk();
+            auto [it, inserted] =
+                prototypeIndex_.try_emplace(chunk, static_cast<uint32_t>(prototypes_.constants.size()));
+            if (inserted) {
+                prototypes_.addConstant(Value(function->bindUpvalues({})));
+            }
+            Object object{Kind::Function, value};
+            object.prototype = it->second;
+            add(objectKey(value), std::move(object));
+        } else if (auto native = dynamicRefCast<VmNativeFunction>(callable)) {
+            if (native->module().empty()) {
+                if (builtins_.empty()) {
+                    builtins_ = builtinNatives();
+                }
+                if (!builtins_.contains(native->name())) {
+                    unsupported("native function '" + native->name() + "'");
+                }
+            }
+            add(objectKey(value), {Kind::Native, value});
+        } else if (callable->isBoundMethod()) {
+            add(objectKey(value), {Kind::BoundMethod, value});
+        } else if (auto vmClass = dynamicRefCast<VmClass>(callable)) {
+            add(objectKey(value), {Kind::Class, Value(vmClass)});
+        } else {
+            unsupported("function '" + callable->name() + "'");
+        }
+    }
+
+    void discoverCell(const Ref<Upvalue>& cell) {
+        if (cell->open) {
+            unsupported("an upvalue of a running function");
+        }
+        Object object{Kind::Upvalue, Value()};
+        object.cell = cell;
+        add(cell.get(), std::move(object));
+    }
+
+    // Number the objects `id` refers to
+    void visit(uint32_t id) {
+        // Copies: discovering may grow objects_
+        Kind kind = objects_[id].kind;
+        Value value = objects_[id].value;
+        switch (kind) {
+            case Kind::Array:
+                for (const auto& element : value.asArray()->elements) {
+                    discover(element);
+                }
+                break;
+            case Kind::Map:
+                for (const auto& [key, entry] : value.asMap()->entries) {
+                    discover(entry);
+                }
+                break;
+            case Kind::Set:
+                for (const auto& [key, entry] : value.asSet()->values) {
+                    discover(entry);
+                }
+                break;
+            case Kind::Instance: {
+                const auto& instance = value.asInstance();
+                if (!std::holds_alternative<Ref<VmClass>>(instance->klass)) {
+                    unsupported("an instance of an interpreter class");
+                }
+                discover(Value(std::get<Ref<VmClass>>(instance->klass)));
+                for (const auto& slot : instance->slots) {
+                    discover(slot);
+                }
+                break;
+            }
+            case Kind::Function: {
+                const auto& function = static_cast<const VmUserFunction&>(*value.asVmCallable());
+                for (size_t i = 0; i < function.upvalueCount(); ++i) {
+                    discoverCell(function.upvalueCell(i));
+                }
+                if (function.superclass()) {
+                    discover(Value(function.superclass()));
+                }
+                break;
+            }
+            case Kind::BoundMethod: {
+                const auto& bound = static_cast<const VmBoundMethod&>(*value.asVmCallable());
+                discover(Value(bound.instance));
+                discover(Value(staticRefCast<VmCallable>(bound.method)));
+                break;
+            }
+            case Kind::Class: {
+                const auto& vmClass = value.asVmClass();
+                if (vmClass->superclass) {
+                    discover(Value(vmClass->superclass));
+                }
+                for (const auto& [field, defaultValue] : vmClass->fieldDefaults) {
+                    discover(defaultValue);
+                }
+                for (const auto& [name, method] : vmClass->methods) {
+                    discover(Value(method));
+                }
+                break;
+            }
+            case Kind::Error:
+                if (value.asError()->cause) {
+                    discover(Value(value.asError()->cause));
+                }
+                break;
+            case Kind::Upvalue:
+                discover(objects_[id].cell->closed);
+                break;
+            case Kind::Native:
+            case Kind::Mutex:
+                break;
+        }
+    }
+
+    void writeValue(const Value& value) {
+        switch (value.type()) {
+            case Value::Type::Nil:
+                out_.push_back(static_cast<char>(Tag::Nil));
+                return;
+            case Value::Type::Bool:
+                out_.push_back(static_cast<char>(value.asBool() ? Tag::True : Tag::False));
+                return;
+            case Value::Type::Number: {
+                out_.push_back(static_cast<char>(Tag::Number));
+                double number = value.asNumber();
+                out_.append(reinterpret_cast<const char*>(&number), sizeof(number));
+                return;
+            }
+            case Value::Type::String:
+                out_.push_back(static_cast<char>(Tag::String));
+                writeString(out_, value.asString());
+                return;
+            default:
+                out_.push_back(static_cast<char>(Tag::Object));
+                writeUint32(out_, ids_.at(objectKey(value)));
+                return;
+        }
+    }
+
+    void writeAllocation(uint32_t id) {
+        const Object& object = objects_[id];
+        writeUint32(out_, id);
+        out_.push_back(static_cast<char>(object.kind));
+        switch (object.kind) {
+            case Kind::Function: {
+                const auto& function = static_cast<const VmUserFunction&>(*object.value.asVmCallable());
+                writeUint32(out_, object.prototype);
+                writeUint32(out_, static_cast<uint32_t>(function.upvalueCount()));
+                for (size_t i = 0; i < function.upvalueCount(); ++i) {
+                    writeUint32(out_, ids_.at(function.upvalueCell(i).get()));
+                }
+                writeValue(function.superclass() ? Value(function.superclass()) : Value());
+                break;
+            }
+            case Kind::Native: {
+                const auto& native = static_cast<const VmNativeFunction&>(*object.value.asVmCallable());
+                writeString(out_, native.module());
+                writeString(out_, native.name());
+                break;
+            }
+            case Kind::Class:
+                writeString(out_, object.value.asVmClass()->className);
+                break;
+            case Kind::Error:
+                writeString(out_, object.value.asError()->message);
+                writeString(out_, object.value.asError()->type);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void writeContents(uint32_t id) {
+        const Object& object = objects_[id];
+        const Value& value = object.value;
+        writeUint32(out_, id);
+        switch (object.kind) {
+            case Kind::Array:
+                writeUint32(out_, static_cast<uint32_t>(value.asArray()->elements.size()));
+                for (const auto& element : value.asArray()->elements) {
+                    writeValue(element);
+                }
+                break;
+            case Kind::Map:
+            case Kind::Set: {
+                const auto& entries = object.kind == Kind::Map ? value.asMap()->entries : value.asSet()->values;
+                writeUint32(out_, static_cast<uint32_t>(entries.size()));
+                for (const auto& [key, entry] : entries) {
+                    writeString(out_, key);
+                    writeValue(entry);
+                }
+                break;
+            }
+            case Kind::Instance: {
+                const auto& instance = value.asInstance();
+                writeValue(Value(std::get<Ref<VmClass>>(instance->klass)));
+                const auto& names = instance->shape->fieldNames();
+                writeUint32(out_, static_cast<uint32_t>(names.size()));
+                for (size_t slot = 0; slot < names.size(); ++slot) {
+                    writeString(out_, names[slot]);
+                    writeValue(instance->slots[slot]);
+                }
+                break;
+            }
+            case Kind::BoundMethod: {
+                const auto& bound = static_cast<const VmBoundMethod&>(*value.asVmCallable());
+                writeValue(Value(bound.instance));
+                writeValue(Value(staticRefCast<VmCallable>(bound.method)));
+                break;
+            }
+            case Kind::Class: {
+                const auto& vmClass = value.asVmClass();
+                writeValue(vmClass->superclass ? Value(vmClass->superclass) : Value());
+                writeUint32(out_, static_cast<uint32_t>(vmClass->fieldNames.size()));
+                for (const auto& field : vmClass->fieldNames) {
+                    writeString(out_, field);
+                }
+                writeUint32(out_, static_cast<uint32_t>(vmClass->fieldDefaults.size()));
+                for (const auto& [field, defaultValue] : vmClass->fieldDefaults) {
+                    writeString(out_, field);
+                    writeValue(defaultValue);
+                }
+                writeUint32(out_, static_cast<uint32_t>(vmClass->methods.size()));
+                for (const auto& [name, method] : vmClass->methods) {
+                    writeString(out_, name);
+                    writeValue(Value(method));
+                }
+                break;
+            }
+            case Kind::Error:
+                writeValue(value.asError()->cause ? Value(value.asError()->cause) : Value());
+                break;
+            case Kind::Upvalue:
+                writeValue(object.cell->closed);
+                break;
+            default:
+                break;
+        }
+    }
+};
+
+class HeapSnapshot::Reader {
+   public:
+    Reader(VM& vm, const void* data, size_t size) : vm_(vm), in_(static_cast<const unsigned char*>(data), size) {}
+
+    void read() {
+        const unsigned char* magic = in_.take(4);
+        if (std::memcmp(magic, MAGIC, 4) != 0) {
+            throw std::runtime_error("Invalid snapshot: magic number mismatch");
+        }
+        uint32_t version = in_.u32();
+        if (version != FORMAT_VERSION) {
+            throw std::runtime_error("Incompatible snapshot version: " + std::to_string(version));
+        }
+        std::string writer = in_.str();
+        if (writer != IZILANG_VERSION) {
+            throw std::runtime_error("Snapshot was written by " + writer + "; rebuild it with izi snapshot");
+        }
+        uint32_t codeSize = in_.u32();
+        prototypes_ = ChunkSerializer::deserialize(in_.take(codeSize), codeSize);
+
+        uint32_t count = in_.u32();
+        kinds_.resize(count);
+        objects_.resize(count);
+        cells_.resize(count);
+        allocated_.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            allocate();
+        }
+        for (uint32_t id = 0; id < count; ++id) {
+            if (!allocated_[id]) {
+                throw std::runtime_error("Invalid snapshot: object " + std::to_string(id) + " missing");
+            }
+        }
+        for (uint32_t id = 0; id < count; ++id) {
+            if (hasContents(kinds_[id])) {
+                fill();
+            }
+        }
+
+        uint32_t globals = in_.u32();
+        for (uint32_t i = 0; i < globals; ++i) {
+            std::string name = in_.str();
+            vm_.setGlobal(name, readValue());
+        }
+    }
+
+   private:
+    VM& vm_;
+    Cursor in_;
+    Chunk prototypes_;
+    std::vector<Kind> kinds_;
+    std::vector<Value> objects_;
+    std::vector<Ref<Upvalue>> cells_;
+    std::vector<bool> allocated_;
+    std::unordered_map<std::string, Value> globals_;  // Of vm_ before restoring, for natives
+    std::unordered_map<std::string, Value> modules_;
+
+    [[noreturn]] static void corrupt(const std::string& what) {
+        throw std::runtime_error("Invalid snapshot: " + what);
+    }
+
+    uint32_t objectId() {
+        uint32_t id = in_.u32();
+        if (id >= objects_.size()) {
+            corrupt("object number out of range");
+        }
+        return id;
+    }
+
+    Value readValue() {
+        switch (static_cast<Tag>(in_.u8())) {
+            case Tag::Nil:
+                return Value();
+            case Tag::False:
+                return false;
+            case Tag::True:
+                return true;
+            case Tag::Number:
+                return in_.f64();
+            case Tag::String:
+                return in_.str();
+            case Tag::Object: {
+                uint32_t id = objectId();
+                if (!allocated_[id] || kinds_[id] == Kind::Upvalue) {
+                    corrupt("bad object reference");
+                }
+                return objects_[id];
+            }
+            default:
+                corrupt("unknown value tag");
+        }
+    }
+
+    template <typename T>
+    Ref<T> expect(const Value& value, bool (Value::*is)() const, const Ref<T>& (Value::*as)() const, const char* what) {
+        if (!(value.*is)()) {
+            corrupt(std::string("expected ") + what);
+        }
+        return (value.*as)();
+    }
+
+    Value resolveNative(const std::string& module, const std::string& name) {
+        if (module.empty()) {
+            if (globals_.empty()) {
+                globals_ = vm_.getGlobals();
+            }
+            auto it = globals_.find(name);
+            if (it != globals_.end() && isBuiltinGlobal(name, it->second)) {
+                return it->second;
+            }
+        } else if (isVmNativeModule(module)) {
+            auto [it, inserted] = modules_.try_emplace(module);
+            if (inserted) {
+                it->second = getVmNativeModule(module, vm_);
+            }
+            if (it->second.isMap()) {
+                for (const auto& [key, value] : it->second.asMap()->entries) {
+                    if (value.isVmCallable() && value.asVmCallable()->name() == name) {
+                        return value;
+                    }
+                }
+            }
+        }
+        throw std::runtime_error("Snapshot refers to unknown native function '" +
+                                 (module.empty() ? name : module + "." + name) + "'");
+    }
+
+    void allocate() {
+        uint32_t id = objectId();
+        if (allocated_[id]) {
+            corrupt("object allocated twice");
+        }
+        Kind kind = static_cast<Kind>(in_.u8());
+        Value& object = objects_[id];
+        switch (kind) {
+            case Kind::Array:
+                object = makeRef<Array>();
+                break;
+            case Kind::Map:
+                object = makeRef<Map>();
+                break;
+            case Kind::Set:
+                object = makeRef<Set>();
+                break;
+            case Kind::Instance:
+                object = makeRef<Instance>(Ref<VmClass>());
+                break;
+            case Kind::Function: {
+                uint32_t prototype = in_.u32();
+                if (prototype >= prototypes_.constants.size() || !prototypes_.constants[prototype].isVmCallable()) {
+                    corrupt("bad function prototype");
+                }
+                auto function = dynamicRefCast<VmUserFunction>(
+                    prototypes_.constants[prototype].asVmCallable());
+                if (!function) {
+                    corrupt("bad function prototype");
+                }
+                std::vector<Ref<Upvalue>> cells(in_.u32());
+                for (auto& cell : cells) {
+                    uint32_t cellId = objectId();
+                    if (!allocated_[cellId] || kinds_[cellId] != Kind::Upvalue) {
+                        corrupt("bad upvalue reference");
+                    }
+                    cell = cells_[cellId];
+                }
+                if (cells.size() != function->upvalueDescs().size()) {
+                    corrupt("upvalue count does not match the function");
+                }
+                auto closure = function->bindUpvalues(std::move(cells));
+                Value superclass = readValue();
+                if (!superclass.isNil()) {
+                    closure->setSuperclass(expect(superclass, &Value::isVmClass, &Value::asVmClass, "a class"));
+                }
+                object = Value(std::move(closure));
+                break;
+            }
+            case Kind::Native: {
+                std::string module = in_.str();
+                std::string name = in_.str();
+                object = resolveNative(module, name);
+                break;
+            }
+            case Kind::BoundMethod:
+                object = Value(makeRef<VmBoundMethod>(nullptr, nullptr));
+                break;
+            case Kind::Class:
+                object = makeRef<VmClass>(in_.str(), nullptr, std::vector<std::string>{},
+                                                   std::unordered_map<std::string, Value>{},
+                                                   std::unordered_map<std::string, Ref<VmCallable>>{});
+                break;
+            case Kind::Error: {
+                std::string message = in_.str();
+                object = makeRef<Error>(std::move(message), in_.str());
+                break;
+            }
+            case Kind::Mutex:
+                object = makeRef<Mutex>();
+                break;
+            case Kind::Upvalue:
+                cells_[id] = makeRef<Upvalue>(0, false);
+                break;
+            default:
+                corrupt("unknown object kind");
+        }
+        kinds_[id] = kind;
+        allocated_[id] = true;
+    }
+
+    void fill() {
+        uint32_t id = objectId();
+        const Value& object = objects_[id];
+        switch (kinds_[id]) {
+            case Kind::Array: {
+                auto& elements = object.asArray()->elements;
+                uint32_t count = in_.u32();
+                elements.reserve(count);
+                for (uint32_t i = 0; i < count; ++i) {
+                    elements.push_back(readValue());
+                }
+                break;
+            }
+            case Kind::Map:
+            case Kind::Set: {
+                auto& entries = kinds_[id] == Kind::Map ? object.asMap()->entries : object.asSet()->values;
+                uint32_t count = in_.u32();
+                entries.reserve(count);
+                for (uint32_t i = 0; i < count; ++i) {
+                    std::string key = in_.str();
+                    entries[std::move(key)] = readValue();
+                }
+                break;
+            }
+            case Kind::Instance: {
+                auto vmClass = expect(readValue(), &Value::isVmClass, &Value::asVmClass, "a class");
+                // Start from the class's root shape, as construction does, so
+                // restored instances share shapes (and inline caches) with new ones
+                const auto& instance = object.asInstance();
+                *instance = std::move(*vmClass->instantiate().asInstance());
+                uint32_t count = in_.u32();
+                for (uint32_t i = 0; i < count; ++i) {
+                    std::string field = in_.str();
+                    instance->setField(field, readValue());
+                }
+                break;
+            }
+            case Kind::BoundMethod: {
+                auto& bound = static_cast<VmBoundMethod&>(*object.asVmCallable());
+                bound.instance = expect(readValue(), &Value::isInstance, &Value::asInstance, "an instance");
+                Value method = readValue();
+                if (method.isVmCallable()) {
+                    bound.method = dynamicRefCast<VmUserFunction>(method.asVmCallable());
+                }
+                if (!bound.method) {
+                    corrupt("expected a method");
+                }
+                break;
+            }
+            case Kind::Class: {
+                const auto& vmClass = object.asVmClass();
+                Value superclass = readValue();
+                if (!superclass.isNil()) {
+                    vmClass->setSuperclass(expect(superclass, &Value::isVmClass, &Value::asVmClass, "a class"));
+                }
+                uint32_t fields = in_.u32();
+                for (uint32_t i = 0; i < fields; ++i) {
+                    vmClass->fieldNames.push_back(in_.str());
+                }
+                uint32_t defaults = in_.u32();
+                for (uint32_t i = 0; i < defaults; ++i) {
+                    std::string field = in_.str();
+                    vmClass->fieldDefaults[std::move(field)] = readValue();
+                }
+                uint32_t methods = in_.u32();
+                for (uint32_t i = 0; i < methods; ++i) {
+                    std::string name = in_.str();
+                    Value method = readValue();
+                    if (!method.isVmCallable()) {
+                        corrupt("expected a method");
+                    }
+                    vmClass->methods[std::move(name)] = method.asVmCallable();
+                }
+                break;
+            }
+            case Kind::Error: {
+                Value cause = readValue();
+                if (!cause.isNil()) {
+                    object.asError()->cause = expect(cause, &Value::isError, &Value::asError, "an error");
+                }
+                break;
+            }
+            case Kind::Upvalue:
+                cells_[id]->closed = readValue();
+                break;
+            default:
+                corrupt("unexpected contents record");
+        }
+    }
+};
+
+std::string HeapSnapshot::save(const VM& vm) {
+    return Writer(vm).write();
+}
+
+void HeapSnapshot::restore(VM& vm, const void* data, size_t size) {
+    Reader(vm, data, size).read();
+}
+
+void HeapSnapshot::saveToFile(const VM& vm, const std::string& filepath) {
+    std::string snapshot = save(vm);
+    std::ofstream out(filepath, std::ios::binary);
+    if (!out || !out.write(snapshot.data(), static_cast<std::streamsize>(snapshot.size()))) {
+        throw std::runtime_error("Could not write snapshot file: " + filepath);
+    }
+}
+
+void HeapSnapshot::restoreFromFile(VM& vm, const std::string& filepath) {
+    std::ifstream in(filepath, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Could not open snapshot file: " + filepath);
+    }
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    std::string snapshot = contents.str();
+    restore(vm, snapshot.data(), snapshot.size());
+}
+
+}  // namespace izi
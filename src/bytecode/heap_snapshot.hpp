@@ -0,0 +1,60 @@
+#pragma once
+
+#include "bytecode/vm.hpp"
+#include <cstddef>
+#include <string>
+
+namespace izi {
+
+/**
+ * HeapSnapshot - Save and restore the globals of a VM with everything they reach
+ *
+ * `izi snapshot app.iz -o app.izs` runs the script's top level and saves the
+ * result; `izi run --snapshot app.izs` loads it into a fresh VM instead of
+ * running the initializers again.
+ *
+ * Snapshot format (.izs file):
+ * - Magic number: "IZS\0", uint32_t version, IziLang version string
+ * - Code: a .izb image (ChunkSerializer) whose constants are one prototype
+ *   per function chunk that the heap refers to
+ * - Objects: uint32_t count, then an allocation record per object
+ *   (kind and what its constructor needs), then a contents record per
+ *   object (elements, entries, fields, superclass, captured values).
+ *   Objects are numbered, so shared and cyclic references survive.
+ * - Globals: uint32_t count, then (name, value) pairs
+ *
+ * Arrays, maps, sets, instances, closures with their upvalue cells, classes,
+ * bound methods, errors and mutexes are saved.  Native functions are saved
+ * by name and re-bound to the natives of the restoring VM (global natives
+ * that still hold their built-in value are not saved at all).  Tasks and
+ * interpreter objects cannot be saved.
+ */
+class HeapSnapshot {
+   public:
+    /**
+     * Snapshot the globals of a VM that is not running
+     * @return The bytes of the snapshot
+     * @throws std::runtime_error if the heap holds a value that cannot be saved
+     */
+    static std::string save(const VM& vm);
+
+    /**
+     * Define the snapshot's globals in `vm`, whose natives must already be
+     * registered (registerVmNatives)
+     * @throws std::runtime_error if the snapshot is invalid
+     */
+    static void restore(VM& vm, const void* data, size_t size);
+
+    // File forms of the above; both throw std::runtime_error on failure
+    static void saveToFile(const VM& vm, const std::string& filepath);
+    static void restoreFromFile(VM& vm, const std::string& filepath);
+
+   private:
+    static constexpr uint32_t FORMAT_VERSION = 1;
+    static constexpr char MAGIC[4] = {'I', 'Z', 'S', '\0'};
+
+    class Writer;
+    class Reader;
+};
+
+}  // namespace izi
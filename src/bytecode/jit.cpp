@@ -0,0 +1,812 @@
+#include "jit.hpp"
+#include "bytecode/chunk.hpp"
+#include "bytecode/opcode.hpp"
+#include "bytecode/vm.hpp"
+#include "bytecode/vm_user_function.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define IZI_JIT_X64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define IZI_JIT_X64 0
+#endif
+
+namespace izi {
+
+bool JitRuntime::getGlobal(JitContext* context, Value* target, uint32_t nameIndex) noexcept {
+    VM& vm = *context->vm;
+    uint32_t slot = context->frame->chunk->globalSlots[nameIndex];
+    if (!vm.globalDefined[slot]) {
+        return false;
+    }
+    *target = vm.globalValues[slot];
+    return true;
+}
+
+void JitRuntime::setGlobal(JitContext* context, const Value* value, uint32_t nameIndex) noexcept {
+    VM& vm = *context->vm;
+    uint32_t slot = context->frame->chunk->globalSlots[nameIndex];
+    vm.globalValues[slot] = *value;
+    vm.globalDefined[slot] = 1;
+}
+
+void JitRuntime::setGlobalPop(JitContext* context, Value* value, uint32_t nameIndex) noexcept {
+    VM& vm = *context->vm;
+    uint32_t slot = context->frame->chunk->globalSlots[nameIndex];
+    vm.globalValues[slot] = std::move(*value);  // Leaves nil in the popped slot
+    vm.globalDefined[slot] = 1;
+}
+
+void JitRuntime::getUpvalue(JitContext* context, Value* target, uint32_t index) noexcept {
+    Upvalue& upvalue = context->frame->function->upvalue(index);
+    *target = upvalue.open ? context->vm->stack[upvalue.slot] : upvalue.closed;
+}
+
+void JitRuntime::setUpvalue(JitContext* context, const Value* value, uint32_t index) noexcept {
+    Upvalue& upvalue = context->frame->function->upvalue(index);
+    (upvalue.open ? context->vm->stack[upvalue.slot] : upvalue.closed) = *value;
+}
+
+bool JitRuntime::modulo(Value* operands) noexcept {
+    if (!operands[0].isNumber() || !operands[1].isNumber() || operands[1].numberUnchecked() == 0.0) {
+        return false;
+    }
+    operands[0].replaceInline(std::fmod(operands[0].numberUnchecked(), operands[1].numberUnchecked()));
+    return true;
+}
+
+bool JitRuntime::indexArray(Value* operands) noexcept {
+    if (!operands[0].isArray() || !operands[1].isNumber()) {
+        return false;
+    }
+    const auto& elements = operands[0].asArray()->elements;
+    double index = operands[1].numberUnchecked();
+    if (!(index >= 0 && index < static_cast<double>(elements.size())) || index != std::trunc(index)) {
+        return false;
+    }
+    Value element = elements[static_cast<size_t>(index)];
+    operands[0] = std::move(element);
+    return true;
+}
+
+namespace {
+
+// Helpers for the templates' slow paths
+void assignValue(Value* target, const Value* source) noexcept {
+    *target = *source;
+}
+
+void releaseValue(Value* value) noexcept {
+    *value = Value();
+}
+
+bool truthy(const Value* value) noexcept {
+    return isTruthy(*value);
+}
+
+bool popTruthy(Value* value) noexcept {
+    bool result = isTruthy(*value);
+    *value = Value();
+    return result;
+}
+
+void logicalNot(Value* value) noexcept {
+    *value = Value(!isTruthy(*value));
+}
+
+// operands[0] op operands[1]; the result replaces operands[0]
+void compareEqual(Value* operands, bool negate) noexcept {
+    bool equal = operands[0] == operands[1];
+    operands[1] = Value();
+    operands[0] = Value(equal != negate);
+}
+
+bool valueLayoutMatches() {
+    // Templates address a Value as a one-byte tag at offset 0 and the
+    // payload at offset 8
+    Value number(1.5);
+    Value boolean(true);
+    unsigned char numberBytes[sizeof(Value)];
+    unsigned char boolBytes[sizeof(Value)];
+    std::memcpy(numberBytes, static_cast<const void*>(&number), sizeof(Value));
+    std::memcpy(boolBytes, static_cast<const void*>(&boolean), sizeof(Value));
+    double payload;
+    std::memcpy(&payload, numberBytes + 8, sizeof(double));
+    return numberBytes[0] == static_cast<unsigned char>(Value::Type::Number) && payload == 1.5 &&
+           boolBytes[0] == static_cast<unsigned char>(Value::Type::Bool) && boolBytes[8] == 1;
+}
+
+}  // namespace
+
+static_assert(sizeof(Value) == 16);
+static_assert(offsetof(JitContext, sp) == 0);
+static_assert(offsetof(JitContext, slots) == 8);
+static_assert(offsetof(JitContext, constants) == 16);
+static_assert(offsetof(JitContext, stackLimit) == 24);
+static_assert(offsetof(JitContext, backEdgesLeft) == 48);
+
+#if IZI_JIT_X64
+
+namespace {
+
+enum Reg : int { RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7, R12 = 12, R13 = 13, R14 = 14, R15 = 15 };
+enum Cond : uint8_t { CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5, CC_BE = 0x6, CC_A = 0x7 };
+
+// Register assignment inside generated code (all callee-saved, so they
+// survive helper calls)
+constexpr int CONTEXT = RBX;
+constexpr int SP = R12;
+constexpr int SLOTS = R13;
+constexpr int CONSTANTS = R14;
+constexpr int LIMIT = R15;
+
+constexpr int32_t SLOT = static_cast<int32_t>(sizeof(Value));
+constexpr int32_t PAYLOAD = 8;
+constexpr uint8_t TAG_NIL = static_cast<uint8_t>(Value::Type::Nil);
+constexpr uint8_t TAG_BOOL = static_cast<uint8_t>(Value::Type::Bool);
+constexpr uint8_t TAG_NUMBER = static_cast<uint8_t>(Value::Type::Number);
+constexpr uint8_t TAG_FIRST_HEAP = static_cast<uint8_t>(Value::Type::String);
+
+// Minimal x86-64 encoder for the instructions the templates use.  Memory
+// operands are always [base + disp32].  Templates store Values as two
+// qwords (tag, payload) and never wider or narrower, so a load that follows
+// a store to the same slot is forwarded from the store buffer.
+class Assembler {
+   public:
+    std::vector<uint8_t> code;
+
+    int newLabel() {
+        labels_.push_back(-1);
+        return static_cast<int>(labels_.size() - 1);
+    }
+    void bind(int label) { labels_[label] = static_cast<int64_t>(code.size()); }
+    size_t here() const { return code.size(); }
+
+    void push(int r) {
+        if (r & 8) byte(0x41);
+        byte(0x50 + (r & 7));
+    }
+    void pop(int r) {
+        if (r & 8) byte(0x41);
+        byte(0x58 + (r & 7));
+    }
+    void ret() { byte(0xC3); }
+
+    void movLoad(int dst, int base, int32_t disp) {
+        rex(true, dst, base);
+        byte(0x8B);
+        mem(dst, base, disp);
+    }
+    void movStore(int base, int32_t disp, int src) {
+        rex(true, src, base);
+        byte(0x89);
+        mem(src, base, disp);
+    }
+    void movReg(int dst, int src) {
+        rex(true, src, dst);
+        byte(0x89);
+        regReg(src, dst);
+    }
+    void movImm32(int dst, uint32_t imm) {
+        rex(false, 0, dst);
+        byte(0xB8 + (dst & 7));
+        dword(imm);
+    }
+    void movImm64(int dst, uint64_t imm) {
+        rex(true, 0, dst);
+        byte(0xB8 + (dst & 7));
+        for (int i = 0; i < 8; ++i) byte(static_cast<uint8_t>(imm >> (8 * i)));
+    }
+    void lea(int dst, int base, int32_t disp) {
+        rex(true, dst, base);
+        byte(0x8D);
+        mem(dst, base, disp);
+    }
+    void addImm(int dst, int8_t imm) {
+        rex(true, 0, dst);
+        byte(0x83);
+        regReg(0, dst);
+        byte(static_cast<uint8_t>(imm));
+    }
+    void subImm(int dst, int8_t imm) {
+        rex(true, 0, dst);
+        byte(0x83);
+        regReg(5, dst);
+        byte(static_cast<uint8_t>(imm));
+    }
+    // Flags of a - b
+    void cmpReg(int a, int b) {
+        rex(true, b, a);
+        byte(0x39);
+        regReg(b, a);
+    }
+    void cmpByte(int base, int32_t disp, uint8_t imm) {
+        rex(false, 0, base);
+        byte(0x80);
+        mem(7, base, disp);
+        byte(imm);
+    }
+    // Sign-extended imm32 into a qword
+    void movQwordImm(int base, int32_t disp, int32_t imm) {
+        rex(true, 0, base);
+        byte(0xC7);
+        mem(0, base, disp);
+        dword(static_cast<uint32_t>(imm));
+    }
+    void movzxByte(int dst, int base, int32_t disp) {
+        rex(false, dst, base);
+        byte(0x0F);
+        byte(0xB6);
+        mem(dst, base, disp);
+    }
+    void movzxAl() {
+        byte(0x0F);
+        byte(0xB6);
+        byte(0xC0);  // movzx eax, al
+    }
+    void testAl() {
+        byte(0x84);
+        byte(0xC0);
+    }
+    void setcc(Cond cc) {
+        byte(0x0F);
+        byte(0x90 | cc);
+        byte(0xC0);
+    }
+    void decDword(int base, int32_t disp) {
+        rex(false, 0, base);
+        byte(0xFF);
+        mem(1, base, disp);
+    }
+    void btcQword(int base, int32_t disp, uint8_t bit) {
+        rex(true, 0, base);
+        byte(0x0F);
+        byte(0xBA);
+        mem(7, base, disp);
+        byte(bit);
+    }
+
+    // SSE2: movsd / addsd / subsd / mulsd / divsd with a memory operand
+    void sd(uint8_t op, int xmm, int base, int32_t disp) { sse(0xF2, op, xmm, base, disp); }
+    void ucomisd(int a, int b) {
+        byte(0x66);
+        rex(false, a, b);
+        byte(0x0F);
+        byte(0x2E);
+        regReg(a, b);
+    }
+
+    void jmp(int label) {
+        byte(0xE9);
+        fixup(label);
+    }
+    void jcc(Cond cc, int label) {
+        byte(0x0F);
+        byte(0x80 | cc);
+        fixup(label);
+    }
+    void jmpReg(int r) {
+        rex(false, 0, r);
+        byte(0xFF);
+        regReg(4, r);
+    }
+    template <typename Fn>
+    void call(Fn* fn) {
+        movImm64(RAX, reinterpret_cast<uint64_t>(fn));
+        byte(0xFF);
+        byte(0xD0);  // call rax
+    }
+
+    // Resolve label references; false if a label was never bound
+    bool finish() {
+        for (const auto& [position, label] : fixups_) {
+            if (labels_[label] < 0) {
+                return false;
+            }
+            int64_t rel = labels_[label] - static_cast<int64_t>(position + 4);
+            for (int i = 0; i < 4; ++i) code[position + i] = static_cast<uint8_t>(rel >> (8 * i));
+        }
+        return true;
+    }
+
+   private:
+    std::vector<int64_t> labels_;
+    std::vector<std::pair<size_t, int>> fixups_;
+
+    void byte(uint8_t b) { code.push_back(b); }
+    void dword(uint32_t v) {
+        for (int i = 0; i < 4; ++i) byte(static_cast<uint8_t>(v >> (8 * i)));
+    }
+    void rex(bool wide, int reg, int base) {
+        uint8_t prefix = 0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((base & 8) ? 1 : 0);
+        if (prefix != 0x40) byte(prefix);
+    }
+    void mem(int reg, int base, int32_t disp) {
+        byte(0x80 | ((reg & 7) << 3) | (base & 7));  // mod=10: [base + disp32]
+        if ((base & 7) == RSP) byte(0x24);  // rsp/r12 as base need a SIB byte
+        dword(static_cast<uint32_t>(disp));
+    }
+    void regReg(int reg, int rm) { byte(0xC0 | ((reg & 7) << 3) | (rm & 7)); }
+    void sse(uint8_t prefix, uint8_t op, int xmm, int base, int32_t disp) {
+        if (prefix) byte(prefix);
+        rex(false, xmm, base);
+        byte(0x0F);
+        byte(op);
+        mem(xmm, base, disp);
+    }
+    void fixup(int label) {
+        fixups_.emplace_back(code.size(), label);
+        dword(0);
+    }
+};
+
+}  // namespace
+
+class JitCompiler {
+   public:
+    explicit JitCompiler(const Chunk& chunk) : chunk_(chunk) {}
+
+    std::shared_ptr<const JitCode> compile() {
+        auto result = std::make_shared<JitCode>();
+        const auto& code = chunk_.code;
+
+        // Every instruction start (and the end of the code) gets a label
+        std::vector<int> labelAt(code.size() + 1, -1);
+        for (size_t offset = 0; offset < code.size();) {
+            labelAt[offset] = a_.newLabel();
+            offset += 1 + operandBytes(static_cast<OpCode>(code[offset]));
+        }
+        labelAt[code.size()] = a_.newLabel();
+        exitLabel_ = a_.newLabel();
+
+        // uint32_t (*)(JitContext* context, const void* entry)
+        a_.push(RBX);
+        a_.push(R12);
+        a_.push(R13);
+        a_.push(R14);
+        a_.push(R15);
+        a_.movReg(CONTEXT, RDI);
+        a_.movLoad(SP, CONTEXT, offsetof(JitContext, sp));
+        a_.movLoad(SLOTS, CONTEXT, offsetof(JitContext, slots));
+        a_.movLoad(CONSTANTS, CONTEXT, offsetof(JitContext, constants));
+        a_.movLoad(LIMIT, CONTEXT, offsetof(JitContext, stackLimit));
+        a_.jmpReg(RSI);
+
+        result->entries_.assign(code.size() + 1, 0);
+        for (size_t offset = 0; offset < code.size();) {
+            result->entries_[offset] = static_cast<uint32_t>(a_.here());
+            a_.bind(labelAt[offset]);
+            size_t length = 1 + operandBytes(static_cast<OpCode>(code[offset]));
+            if (offset + length > code.size()) {
+                exitAt(static_cast<uint32_t>(offset));
+                break;
+            }
+            emitInstruction(static_cast<uint32_t>(offset), labelAt);
+            offset += length;
+        }
+        result->entries_[code.size()] = static_cast<uint32_t>(a_.here());
+        a_.bind(labelAt[code.size()]);
+        exitAt(static_cast<uint32_t>(code.size()));
+
+        // Guard failures: hand the instruction back to the interpreter
+        for (const auto& [label, offset] : bailouts_) {
+            a_.bind(label);
+            exitAt(offset);
+        }
+
+        // eax = offset to resume at
+        a_.bind(exitLabel_);
+        a_.movStore(CONTEXT, offsetof(JitContext, sp), SP);
+        a_.pop(R15);
+        a_.pop(R14);
+        a_.pop(R13);
+        a_.pop(R12);
+        a_.pop(RBX);
+        a_.ret();
+
+        if (!a_.finish()) {
+            return result;
+        }
+        install(*result);
+        return result;
+    }
+
+   private:
+    const Chunk& chunk_;
+    Assembler a_;
+    int exitLabel_ = -1;
+    std::vector<std::pair<int, uint32_t>> bailouts_;
+
+    void exitAt(uint32_t offset) {
+        a_.movImm32(RAX, offset);
+        a_.jmp(exitLabel_);
+    }
+
+    int bailout(uint32_t offset) {
+        int label = a_.newLabel();
+        bailouts_.emplace_back(label, offset);
+        return label;
+    }
+
+    uint16_t readShort(size_t at) const { return static_cast<uint16_t>((chunk_.code[at] << 8) | chunk_.code[at + 1]); }
+
+    bool constantIsNumber(uint8_t index) const {
+        return index < chunk_.constants.size() && chunk_.constants[index].isNumber();
+    }
+
+    void guardNumber(int32_t disp, int bail) {
+        a_.cmpByte(SP, disp, TAG_NUMBER);
+        a_.jcc(CC_NE, bail);
+    }
+
+    void guardRoom(int bail) {
+        a_.cmpReg(SP, LIMIT);
+        a_.jcc(CC_AE, bail);
+    }
+
+    // Copy a Value that holds no heap reference
+    void copyInline(int dstBase, int32_t dstDisp, int srcBase, int32_t srcDisp) {
+        a_.movLoad(RAX, srcBase, srcDisp);
+        a_.movLoad(RCX, srcBase, srcDisp + PAYLOAD);
+        a_.movStore(dstBase, dstDisp, RAX);
+        a_.movStore(dstBase, dstDisp + PAYLOAD, RCX);
+    }
+
+    // Push a copy of the value at [base + disp]
+    void pushCopy(int base, int32_t disp) {
+        int heap = a_.newLabel();
+        int done = a_.newLabel();
+        a_.cmpByte(base, disp, TAG_FIRST_HEAP);
+        a_.jcc(CC_AE, heap);
+        copyInline(SP, 0, base, disp);
+        a_.jmp(done);
+        a_.bind(heap);
+        a_.movReg(RDI, SP);
+        a_.lea(RSI, base, disp);
+        a_.call(&assignValue);
+        a_.bind(done);
+        a_.addImm(SP, SLOT);
+    }
+
+    // Two numbers on top -> one number: xmm0 = a <op> b
+    void numberArithmetic(uint8_t sseOp, uint32_t offset) {
+        int bail = bailout(offset);
+        guardNumber(-2 * SLOT, bail);
+        guardNumber(-SLOT, bail);
+        a_.sd(0x10, 0, SP, -2 * SLOT + PAYLOAD);
+        a_.sd(sseOp, 0, SP, -SLOT + PAYLOAD);
+        a_.sd(0x11, 0, SP, -2 * SLOT + PAYLOAD);
+        a_.subImm(SP, SLOT);
+    }
+
+    // Two numbers on top -> bool.  `swap` compares b against a.
+    void numberComparison(Cond cc, bool swap, uint32_t offset) {
+        int bail = bailout(offset);
+        guardNumber(-2 * SLOT, bail);
+        guardNumber(-SLOT, bail);
+        a_.sd(0x10, 0, SP, -2 * SLOT + PAYLOAD);
+        a_.sd(0x10, 1, SP, -SLOT + PAYLOAD);
+        if (swap) {
+            a_.ucomisd(1, 0);
+        } else {
+            a_.ucomisd(0, 1);
+        }
+        a_.setcc(cc);
+        a_.movzxAl();
+        a_.movQwordImm(SP, -2 * SLOT, TAG_BOOL);
+        a_.movStore(SP, -2 * SLOT + PAYLOAD, RAX);
+        a_.subImm(SP, SLOT);
+    }
+
+    // al = truthiness of the top value; pops it when `pop` is set
+    void topTruthiness(bool pop) {
+        int slow = a_.newLabel();
+        int test = a_.newLabel();
+        a_.cmpByte(SP, -SLOT, TAG_BOOL);
+        a_.jcc(CC_NE, slow);
+        a_.movzxByte(RAX, SP, -SLOT + PAYLOAD);
+        a_.jmp(test);
+        a_.bind(slow);
+        a_.lea(RDI, SP, -SLOT);
+        if (pop) {
+            a_.call(&popTruthy);
+        } else {
+            a_.call(&truthy);
+        }
+        a_.bind(test);
+        if (pop) {
+            a_.subImm(SP, SLOT);
+        }
+    }
+
+    void emitInstruction(uint32_t offset, const std::vector<int>& labelAt) {
+        const auto& code = chunk_.code;
+        OpCode op = static_cast<OpCode>(code[offset]);
+        uint8_t operand = offset + 1 < code.size() ? code[offset + 1] : 0;
+        auto jumpTarget = [&](int64_t target) -> int {
+            if (target < 0 || static_cast<size_t>(target) > code.size() || labelAt[target] < 0) {
+                return -1;
+            }
+            return labelAt[target];
+        };
+
+        switch (op) {
+            case OpCode::CONSTANT: {
+                guardRoom(bailout(offset));
+                if (operand < chunk_.constants.size() && !chunk_.constants[operand].isHeap()) {
+                    copyInline(SP, 0, CONSTANTS, operand * SLOT);
+                    a_.addImm(SP, SLOT);
+                } else {
+                    pushCopy(CONSTANTS, operand * SLOT);
+                }
+                return;
+            }
+            case OpCode::NIL:
+            case OpCode::TRUE:
+            case OpCode::FALSE:
+                guardRoom(bailout(offset));
+                a_.movQwordImm(SP, 0, op == OpCode::NIL ? TAG_NIL : TAG_BOOL);
+                a_.movQwordImm(SP, PAYLOAD, op == OpCode::TRUE ? 1 : 0);
+                a_.addImm(SP, SLOT);
+                return;
+            case OpCode::POP: {
+                int done = a_.newLabel();
+                a_.cmpByte(SP, -SLOT, TAG_FIRST_HEAP);
+                a_.jcc(CC_B, done);
+                a_.lea(RDI, SP, -SLOT);
+                a_.call(&releaseValue);
+                a_.bind(done);
+                a_.subImm(SP, SLOT);
+                return;
+            }
+            case OpCode::GET_LOCAL:
+            case OpCode::GET_LOCAL_0:
+            case OpCode::GET_LOCAL_1:
+            case OpCode::GET_LOCAL_2:
+            case OpCode::GET_LOCAL_3: {
+                int32_t slot = op == OpCode::GET_LOCAL ? operand
+                                                       : static_cast<int32_t>(op) - static_cast<int32_t>(OpCode::GET_LOCAL_0);
+                guardRoom(bailout(offset));
+                pushCopy(SLOTS, slot * SLOT);
+                return;
+            }
+            case OpCode::SET_LOCAL: {
+                int slow = a_.newLabel();
+                int done = a_.newLabel();
+                a_.cmpByte(SLOTS, operand * SLOT, TAG_FIRST_HEAP);
+                a_.jcc(CC_AE, slow);
+                a_.cmpByte(SP, -SLOT, TAG_FIRST_HEAP);
+                a_.jcc(CC_AE, slow);
+                copyInline(SLOTS, operand * SLOT, SP, -SLOT);
+                a_.jmp(done);
+                a_.bind(slow);
+                a_.lea(RDI, SLOTS, operand * SLOT);
+                a_.lea(RSI, SP, -SLOT);
+                a_.call(&assignValue);
+                a_.bind(done);
+                return;
+            }
+            case OpCode::GET_GLOBAL: {
+                int bail = bailout(offset);
+                guardRoom(bail);
+                a_.movReg(RDI, CONTEXT);
+                a_.movReg(RSI, SP);
+                a_.movImm32(RDX, operand);
+                a_.call(&JitRuntime::getGlobal);
+                a_.testAl();
+                a_.jcc(CC_E, bail);  // Undefined: the interpreter raises the error
+                a_.addImm(SP, SLOT);
+                return;
+            }
+            case OpCode::SET_GLOBAL:
+            case OpCode::SET_GLOBAL_POP:
+                a_.movReg(RDI, CONTEXT);
+                a_.lea(RSI, SP, -SLOT);
+                a_.movImm32(RDX, operand);
+                if (op == OpCode::SET_GLOBAL) {
+                    a_.call(&JitRuntime::setGlobal);
+                } else {
+                    a_.call(&JitRuntime::setGlobalPop);
+                    a_.subImm(SP, SLOT);
+                }
+                return;
+            case OpCode::GET_UPVALUE:
+                guardRoom(bailout(offset));
+                a_.movReg(RDI, CONTEXT);
+                a_.movReg(RSI, SP);
+                a_.movImm32(RDX, operand);
+                a_.call(&JitRuntime::getUpvalue);
+                a_.addImm(SP, SLOT);
+                return;
+            case OpCode::SET_UPVALUE:
+                a_.movReg(RDI, CONTEXT);
+                a_.lea(RSI, SP, -SLOT);
+                a_.movImm32(RDX, operand);
+                a_.call(&JitRuntime::setUpvalue);
+                return;
+            case OpCode::ADD:
+            case OpCode::ADD_NUM:
+                numberArithmetic(0x58, offset);  // Strings fall back to the interpreter
+                return;
+            case OpCode::SUBTRACT:
+                numberArithmetic(0x5C, offset);
+                return;
+            case OpCode::MULTIPLY:
+                numberArithmetic(0x59, offset);
+                return;
+            case OpCode::DIVIDE:
+                numberArithmetic(0x5E, offset);
+                return;
+            case OpCode::ADD_CONST: {
+                if (!constantIsNumber(operand)) {
+                    break;
+                }
+                int bail = bailout(offset);
+                guardNumber(-SLOT, bail);
+                a_.sd(0x10, 0, SP, -SLOT + PAYLOAD);
+                a_.sd(0x58, 0, CONSTANTS, operand * SLOT + PAYLOAD);
+                a_.sd(0x11, 0, SP, -SLOT + PAYLOAD);
+                return;
+            }
+            case OpCode::MODULO: {
+                int bail = bailout(offset);
+                a_.lea(RDI, SP, -2 * SLOT);
+                a_.call(&JitRuntime::modulo);
+                a_.testAl();
+                a_.jcc(CC_E, bail);
+                a_.subImm(SP, SLOT);
+                return;
+            }
+            case OpCode::NEGATE:
+                guardNumber(-SLOT, bailout(offset));
+                a_.btcQword(SP, -SLOT + PAYLOAD, 63);  // Flip the sign bit
+                return;
+            case OpCode::LESS:
+            case OpCode::LESS_NUM:
+                numberComparison(CC_A, true, offset);  // b > a
+                return;
+            case OpCode::LESS_EQUAL:
+                numberComparison(CC_AE, true, offset);  // b >= a
+                return;
+            case OpCode::GREATER:
+                numberComparison(CC_A, false, offset);
+                return;
+            case OpCode::GREATER_EQUAL:
+                numberComparison(CC_AE, false, offset);
+                return;
+            case OpCode::EQUAL:
+            case OpCode::NOT_EQUAL:
+                a_.lea(RDI, SP, -2 * SLOT);
+                a_.movImm32(RSI, op == OpCode::NOT_EQUAL ? 1 : 0);
+                a_.call(&compareEqual);
+                a_.subImm(SP, SLOT);
+                return;
+            case OpCode::NOT:
+                a_.lea(RDI, SP, -SLOT);
+                a_.call(&logicalNot);
+                return;
+            case OpCode::INDEX:
+            case OpCode::INDEX_ARRAY_NUM: {
+                int bail = bailout(offset);  // Maps and errors go to the interpreter
+                a_.lea(RDI, SP, -2 * SLOT);
+                a_.call(&JitRuntime::indexArray);
+                a_.testAl();
+                a_.jcc(CC_E, bail);
+                a_.subImm(SP, SLOT);
+                return;
+            }
+            case OpCode::JUMP:
+            case OpCode::LOOP: {
+                int64_t distance = readShort(offset + 1);
+                int target = jumpTarget(op == OpCode::JUMP ? offset + 3 + distance : offset + 3 - distance);
+                if (target < 0) {
+                    break;
+                }
+                if (op == OpCode::LOOP) {
+                    // Safepoint poll: out of back-edges, the interpreter runs this LOOP
+                    a_.decDword(CONTEXT, offsetof(JitContext, backEdgesLeft));
+                    a_.jcc(CC_E, bailout(offset));
+                }
+                a_.jmp(target);
+                return;
+            }
+            case OpCode::JUMP_IF_FALSE:
+            case OpCode::POP_JUMP_IF_FALSE: {
+                int target = jumpTarget(offset + 3 + readShort(offset + 1));
+                if (target < 0) {
+                    break;
+                }
+                topTruthiness(op == OpCode::POP_JUMP_IF_FALSE);
+                a_.testAl();
+                a_.jcc(CC_E, target);
+                return;
+            }
+            case OpCode::LESS_CONST_JUMP: {
+                int target = jumpTarget(offset + 4 + readShort(offset + 2));
+                if (!constantIsNumber(operand) || target < 0) {
+                    break;
+                }
+                guardNumber(-SLOT, bailout(offset));
+                a_.sd(0x10, 0, SP, -SLOT + PAYLOAD);
+                a_.sd(0x10, 1, CONSTANTS, operand * SLOT + PAYLOAD);
+                a_.subImm(SP, SLOT);
+                a_.ucomisd(1, 0);
+                a_.jcc(CC_BE, target);  // Not (value < constant), NaN included
+                return;
+            }
+            default:
+                break;
+        }
+        // No template: calls, returns, property access, ...
+        exitAt(offset);
+    }
+
+    void install(JitCode& result) {
+        size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t size = (a_.code.size() + pageSize - 1) / pageSize * pageSize;
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return;
+        }
+        std::memcpy(memory, a_.code.data(), a_.code.size());
+        if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+            munmap(memory, size);
+            return;
+        }
+        result.code_ = memory;
+        result.size_ = size;
+    }
+};
+
+JitCode::~JitCode() {
+    if (code_ != nullptr) {
+        munmap(code_, size_);
+    }
+}
+
+uint32_t JitCode::run(JitContext& context, uint32_t offset) const {
+    if (entry_ != nullptr) {
+        return entry_(context, offset);
+    }
+    using Entry = uint32_t (*)(JitContext*, const void*);
+    auto entry = reinterpret_cast<Entry>(code_);
+    return entry(&context, static_cast<const uint8_t*>(code_) + entries_[offset]);
+}
+
+bool jitSupported() {
+    static const bool supported = valueLayoutMatches();
+    return supported;
+}
+
+std::shared_ptr<const JitCode> compileChunk(const Chunk& chunk) {
+    if (!jitSupported()) {
+        return std::make_shared<JitCode>();
+    }
+    return JitCompiler(chunk).compile();
+}
+
+#else  // !IZI_JIT_X64
+
+class JitCompiler {};
+
+JitCode::~JitCode() = default;
+
+uint32_t JitCode::run(JitContext& context, uint32_t offset) const {
+    return entry_ != nullptr ? entry_(context, offset) : offset;
+}
+
+bool jitSupported() {
+    return false;
+}
+
+std::shared_ptr<const JitCode> compileChunk(const Chunk&) {
+    return std::make_shared<JitCode>();
+}
+
+#endif
+
+}  // namespace izi
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "common/value.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace izi {
+
+struct Chunk;
+struct CallFrame;
+class VM;
+
+// Baseline JIT for the bytecode VM (x86-64 Linux only).
+//
+// A hot chunk is translated instruction by instruction into native code from
+// fixed per-opcode templates.  The code works directly on the VM's value
+// stack and frame, so the interpreter and the native code can hand control to
+// each other at any instruction boundary:
+//  - the VM enters native code at the current instruction (function entry,
+//    loop back-edges, returns into the chunk);
+//  - native code returns the offset of the first instruction it did not
+//    execute: an opcode without a template (calls, returns, property access,
+//    ...), a template whose operand-type guard failed, or a LOOP once
+//    backEdgesLeft runs out.  The interpreter then executes that
+//    instruction generically, including raising errors, so native code
+//    never throws.
+// `izi compile` (compile/aot_compiler.hpp) generates C++ with the same
+// contract ahead of time and attaches it to its chunks as a NativeEntry.
+
+// Default number of calls plus back-edges before a chunk is compiled
+constexpr uint32_t JIT_DEFAULT_THRESHOLD = 1000;
+
+// Loop back-edges native code takes per entry.  The next LOOP is left to
+// the interpreter, so whatever the VM does on a back-edge still happens
+// inside a long native loop before it enters native code again.
+constexpr uint32_t JIT_SAFEPOINT_INTERVAL = 4096;
+
+// State shared with native code for one entry.  Layout is read by the
+// generated code (see the offsets checked in jit.cpp).
+struct JitContext {
+    Value* sp;  // Stack top, updated on exit
+    Value* slots;  // Local 0 of the frame
+    const Value* constants;
+    Value* stackLimit;
+    VM* vm;
+    CallFrame* frame;
+    uint32_t backEdgesLeft = JIT_SAFEPOINT_INTERVAL;  // Counted down by LOOP
+};
+
+// Native code for one chunk: run from the instruction at `offset` and return
+// the offset of the first instruction left to the interpreter
+using NativeEntry = uint32_t (*)(JitContext& context, uint32_t offset);
+
+// Helpers called from native code (JIT templates and the C++ that
+// `izi compile` generates).  They never throw: a failure is reported to the
+// caller, which hands the instruction back to the interpreter.
+struct JitRuntime {
+    // False when the global is undefined
+    static bool getGlobal(JitContext* context, Value* target, uint32_t nameIndex) noexcept;
+    static void setGlobal(JitContext* context, const Value* value, uint32_t nameIndex) noexcept;
+    static void setGlobalPop(JitContext* context, Value* value, uint32_t nameIndex) noexcept;
+    static void getUpvalue(JitContext* context, Value* target, uint32_t index) noexcept;
+    static void setUpvalue(JitContext* context, const Value* value, uint32_t index) noexcept;
+    // operands[0] = operands[0] % operands[1]; false unless both are numbers
+    // and the divisor is not zero
+    static bool modulo(Value* operands) noexcept;
+    // operands[0] = operands[0][operands[1]]; false unless that is an
+    // in-bounds integral index into an array
+    static bool indexArray(Value* operands) noexcept;
+};
+
+class JitCode {
+   public:
+    JitCode() = default;
+    // Code compiled ahead of time (see AotCompiler)
+    explicit JitCode(NativeEntry entry) : entry_(entry) {}
+    ~JitCode();
+    JitCode(const JitCode&) = delete;
+    JitCode& operator=(const JitCode&) = delete;
+
+    // False when the chunk could not be compiled (unsupported platform);
+    // the VM keeps interpreting it.
+    bool compiled() const { return code_ != nullptr || entry_ != nullptr; }
+
+    // Run from the instruction at `offset` until the first instruction left
+    // to the interpreter; returns that instruction's offset.
+    uint32_t run(JitContext& context, uint32_t offset) const;
+
+    size_t codeSize() const { return size_; }
+
+   private:
+    friend class JitCompiler;
+
+    NativeEntry entry_ = nullptr;
+    void* code_ = nullptr;
+    size_t size_ = 0;
+    std::vector<uint32_t> entries_;  // Native offset of each instruction, by bytecode offset
+};
+
+// True when this build can generate native code (x86-64 Linux)
+bool jitSupported();
+
+// Translate a chunk; never returns null (see JitCode::compiled()).
+std::shared_ptr<const JitCode> compileChunk(const Chunk& chunk);
+
+}  // namespace izi
@@ -8,12 +8,16 @@
 
 namespace izi {
 class VM;
-class VmCallable {
+class VmCallable : public RefCounted {
    public:
-    virtual ~VmCallable() = default;
-
     virtual std::string name() const = 0;
     virtual int arity() const = 0;  // -1 for variadic
     virtual Value call(VM& vm, const std::vector<Value>& args) = 0;
+
+    // True for VmUserFunction, which the VM runs in its own dispatch loop
+    // instead of going through call().
+    virtual bool isUserFunction() const { return false; }
+    // True for VmBoundMethod, which the VM calls as a method frame over its receiver.
+    virtual bool isBoundMethod() const { return false; }
 };
 }  // namespace izi
\ No newline at end of file
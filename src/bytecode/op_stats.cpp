@@ -0,0 +1,280 @@
+#include "op_stats.hpp"
+#include "vm_user_function.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <x86intrin.h>
+#define IZI_OPSTATS_RDTSC 1
+#else
+#define IZI_OPSTATS_RDTSC 0
+#endif
+
+namespace izi {
+
+namespace {
+
+uint64_t steadyNanos() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+std::string jsonString(const std::string& str) {
+    std::string out = "\"";
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+            out += escape;
+        } else {
+            out += c;
+        }
+    }
+    return out + '"';
+}
+
+template <typename... Args>
+std::string formatRow(const char* format, Args... args) {
+    char line[160];
+    std::snprintf(line, sizeof(line), format, args...);
+    return line;
+}
+
+}  // namespace
+
+uint64_t OpStats::readClock() {
+#if IZI_OPSTATS_RDTSC
+    return __rdtsc();
+#else
+    return steadyNanos();
+#endif
+}
+
+OpStats::OpStats() : pairs_(OPCODE_COUNT * OPCODE_COUNT, 0) {
+    // Cost of one clock read, taken off every charge
+    constexpr int reads = 1000;
+    uint64_t begin = readClock();
+    for (int i = 0; i < reads; ++i) {
+        last_ = readClock();
+    }
+    clockOverhead_ = (last_ - begin) / reads;
+    startTicks_ = readClock();
+    startNanos_ = steadyNanos();
+}
+
+void OpStats::enterChunk(const CallFrame& frame) {
+    currentChunk_ = frame.chunk;
+    auto& stats = functions_[frame.chunk];
+    if (!stats) {
+        stats = std::make_unique<FunctionStats>();
+        stats->name = frame.function ? frame.function->name() : "<script>";
+        stats->line = frame.chunk->getLine(0);
+    }
+    current_ = stats.get();
+}
+
+uint64_t OpStats::FunctionStats::instructions() const {
+    uint64_t total = 0;
+    for (uint64_t count : counts) {
+        total += count;
+    }
+    return total;
+}
+
+uint64_t OpStats::FunctionStats::totalTicks() const {
+    uint64_t total = 0;
+    for (uint64_t tick : ticks) {
+        total += tick;
+    }
+    return total;
+}
+
+OpStats::Totals OpStats::totals() const {
+    Totals totals;
+    for (const auto& [chunk, stats] : functions_) {
+        for (size_t op = 0; op < OPCODE_COUNT; ++op) {
+            totals.counts[op] += stats->counts[op];
+            totals.ticks[op] += stats->ticks[op];
+        }
+    }
+    return totals;
+}
+
+uint64_t OpStats::instructions() const {
+    uint64_t total = 0;
+    for (const auto& [chunk, stats] : functions_) {
+        total += stats->instructions();
+    }
+    return total;
+}
+
+uint64_t OpStats::count(OpCode op) const {
+    uint64_t total = 0;
+    for (const auto& [chunk, stats] : functions_) {
+        total += stats->counts[static_cast<size_t>(op)];
+    }
+    return total;
+}
+
+double OpStats::nanosPerTick() const {
+#if IZI_OPSTATS_RDTSC
+    uint64_t ticks = readClock() - startTicks_;
+    uint64_t nanos = steadyNanos() - startNanos_;
+    return ticks == 0 ? 0.0 : static_cast<double>(nanos) / static_cast<double>(ticks);
+#else
+    return 1.0;
+#endif
+}
+
+std::vector<const OpStats::FunctionStats*> OpStats::functionsByInstructions() const {
+    std::vector<const FunctionStats*> functions;
+    for (const auto& [chunk, stats] : functions_) {
+        functions.push_back(stats.get());
+    }
+    std::sort(functions.begin(), functions.end(), [](const FunctionStats* a, const FunctionStats* b) {
+        uint64_t countA = a->instructions(), countB = b->instructions();
+        if (countA != countB) return countA > countB;
+        if (a->name != b->name) return a->name < b->name;
+        return a->line < b->line;
+    });
+    return functions;
+}
+
+namespace {
+
+// Opcodes of one count/ticks table, most executed first, without unused ones
+std::vector<size_t> opcodesByCount(const uint64_t* counts) {
+    std::vector<size_t> ops;
+    for (size_t op = 0; op < OPCODE_COUNT; ++op) {
+        if (counts[op] != 0) {
+            ops.push_back(op);
+        }
+    }
+    std::stable_sort(ops.begin(), ops.end(), [&](size_t a, size_t b) { return counts[a] > counts[b]; });
+    return ops;
+}
+
+}  // namespace
+
+void OpStats::writeTable(std::ostream& out, size_t topPairs, size_t topFunctions) const {
+    const Totals all = totals();
+    const double scale = nanosPerTick();
+    uint64_t total = 0;
+    uint64_t totalTicks = 0;
+    for (size_t op = 0; op < OPCODE_COUNT; ++op) {
+        total += all.counts[op];
+        totalTicks += all.ticks[op];
+    }
+    auto percent = [](uint64_t part, uint64_t whole) {
+        return whole == 0 ? 0.0 : 100.0 * static_cast<double>(part) / static_cast<double>(whole);
+    };
+    auto millis = [&](uint64_t ticks) { return static_cast<double>(ticks) * scale / 1e6; };
+    auto average = [&](uint64_t ticks, uint64_t count) {
+        return count == 0 ? 0.0 : static_cast<double>(ticks) * scale / static_cast<double>(count);
+    };
+
+    out << formatRow("Opcode statistics: %llu instructions, %.1f ms\n", static_cast<unsigned long long>(total),
+                     millis(totalTicks));
+    out << "opcode                     count      %   time ms      %   avg ns\n";
+    for (size_t op : opcodesByCount(all.counts)) {
+        out << formatRow("%-20s %12llu %5.1f%% %9.2f %5.1f%% %8.1f\n", opcodeName(op),
+                         static_cast<unsigned long long>(all.counts[op]), percent(all.counts[op], total),
+                         millis(all.ticks[op]), percent(all.ticks[op], totalTicks), average(all.ticks[op], all.counts[op]));
+    }
+
+    std::vector<size_t> pairs;
+    for (size_t pair = 0; pair < pairs_.size(); ++pair) {
+        if (pairs_[pair] != 0) {
+            pairs.push_back(pair);
+        }
+    }
+    std::stable_sort(pairs.begin(), pairs.end(), [&](size_t a, size_t b) { return pairs_[a] > pairs_[b]; });
+    if (pairs.size() > topPairs) {
+        pairs.resize(topPairs);
+    }
+    out << "\nTop opcode pairs:\n";
+    for (size_t pair : pairs) {
+        std::string name = std::string(opcodeName(pair / OPCODE_COUNT)) + " -> " + opcodeName(pair % OPCODE_COUNT);
+        out << formatRow("  %-40s %12llu %5.1f%%\n", name.c_str(), static_cast<unsigned long long>(pairs_[pair]),
+                         percent(pairs_[pair], total));
+    }
+
+    std::vector<const FunctionStats*> functions = functionsByInstructions();
+    if (functions.size() > topFunctions) {
+        functions.resize(topFunctions);
+    }
+    out << "\nBy function:\n";
+    for (const FunctionStats* function : functions) {
+        uint64_t count = function->instructions();
+        uint64_t ticks = function->totalTicks();
+        std::string name = function->name + (function->line > 0 ? ":" + std::to_string(function->line) : "");
+        out << formatRow("  %-30s %12llu %5.1f%% %9.2f ms\n", name.c_str(), static_cast<unsigned long long>(count),
+                         percent(count, total), millis(ticks));
+        std::vector<size_t> ops = opcodesByCount(function->counts);
+        if (ops.size() > 5) {
+            ops.resize(5);
+        }
+        for (size_t op : ops) {
+            out << formatRow("      %-24s %12llu %5.1f%% %9.2f ms %8.1f ns\n", opcodeName(op),
+                             static_cast<unsigned long long>(function->counts[op]), percent(function->counts[op], count),
+                             millis(function->ticks[op]), average(function->ticks[op], function->counts[op]));
+        }
+    }
+}
+
+void OpStats::writeJson(std::ostream& out) const {
+    const Totals all = totals();
+    const double scale = nanosPerTick();
+    auto nanos = [&](uint64_t ticks) { return static_cast<uint64_t>(static_cast<double>(ticks) * scale); };
+    auto writeOpcodes = [&](const uint64_t* counts, const uint64_t* ticks) {
+        out << '[';
+        bool first = true;
+        for (size_t op : opcodesByCount(counts)) {
+            out << (first ? "" : ",") << "{\"opcode\":\"" << opcodeName(op) << "\",\"count\":" << counts[op]
+                << ",\"timeNs\":" << nanos(ticks[op]) << '}';
+            first = false;
+        }
+        out << ']';
+    };
+
+    uint64_t total = 0;
+    uint64_t totalTicks = 0;
+    for (size_t op = 0; op < OPCODE_COUNT; ++op) {
+        total += all.counts[op];
+        totalTicks += all.ticks[op];
+    }
+    out << "{\"instructions\":" << total << ",\"timeNs\":" << nanos(totalTicks) << ",\"opcodes\":";
+    writeOpcodes(all.counts, all.ticks);
+
+    std::vector<size_t> pairs;
+    for (size_t pair = 0; pair < pairs_.size(); ++pair) {
+        if (pairs_[pair] != 0) {
+            pairs.push_back(pair);
+        }
+    }
+    std::stable_sort(pairs.begin(), pairs.end(), [&](size_t a, size_t b) { return pairs_[a] > pairs_[b]; });
+    out << ",\"pairs\":[";
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        out << (i == 0 ? "" : ",") << "{\"first\":\"" << opcodeName(pairs[i] / OPCODE_COUNT) << "\",\"second\":\""
+            << opcodeName(pairs[i] % OPCODE_COUNT) << "\",\"count\":" << pairs_[pairs[i]] << '}';
+    }
+
+    out << "],\"functions\":[";
+    bool first = true;
+    for (const FunctionStats* function : functionsByInstructions()) {
+        out << (first ? "" : ",") << "{\"name\":" << jsonString(function->name) << ",\"line\":" << function->line
+            << ",\"instructions\":" << function->instructions() << ",\"timeNs\":" << nanos(function->totalTicks())
+            << ",\"opcodes\":";
+        writeOpcodes(function->counts, function->ticks);
+        out << '}';
+        first = false;
+    }
+    out << "]}\n";
+}
+
+}  // namespace izi
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "bytecode/opcode.hpp"
+#include "bytecode/vm.hpp"
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace izi {
+
+// Per-opcode execution statistics for `izi run --vm --opstats`.
+//
+// A VM given an OpStats (VM::setOpStats) dispatches every instruction through
+// record(): it counts the opcode in the running function and in the pair it
+// forms with the previous instruction, and charges the time since the
+// previous dispatch to the previous instruction.  Times come from the cycle
+// counter (x86-64) or steady_clock, less the cost of reading it; they are
+// inflated by the bookkeeping, so compare them with each other rather than
+// with an uninstrumented run.  Quickened and fused opcodes are counted under
+// their own names.  The VM does not use the JIT while counting.
+class OpStats {
+   public:
+    OpStats();
+
+    void record(const CallFrame& frame, uint8_t op) {
+        uint64_t now = readClock();
+        if (previous_) {
+            uint64_t elapsed = now - last_;
+            previous_->ticks[previousOp_] += elapsed > clockOverhead_ ? elapsed - clockOverhead_ : 0;
+            ++pairs_[previousOp_ * OPCODE_COUNT + op];
+        }
+        if (frame.chunk != currentChunk_) {
+            enterChunk(frame);
+        }
+        ++current_->counts[op];
+        previous_ = current_;
+        previousOp_ = op;
+        last_ = readClock();  // Leave the bookkeeping above out of the next charge
+    }
+
+    uint64_t instructions() const;
+    uint64_t count(OpCode op) const;
+    uint64_t pairCount(OpCode first, OpCode second) const {
+        return pairs_[static_cast<size_t>(first) * OPCODE_COUNT + static_cast<size_t>(second)];
+    }
+
+    // Opcodes by count, the `topPairs` most frequent pairs, then the
+    // `topFunctions` functions with the most instructions and their
+    // five most frequent opcodes
+    void writeTable(std::ostream& out, size_t topPairs = 15, size_t topFunctions = 10) const;
+    // Everything, as one JSON object
+    void writeJson(std::ostream& out) const;
+
+   private:
+    struct FunctionStats {
+        std::string name;
+        int line = 0;  // First line of the function's code
+        uint64_t counts[OPCODE_COUNT] = {};
+        uint64_t ticks[OPCODE_COUNT] = {};
+
+        uint64_t instructions() const;
+        uint64_t totalTicks() const;
+    };
+
+    struct Totals {
+        uint64_t counts[OPCODE_COUNT] = {};
+        uint64_t ticks[OPCODE_COUNT] = {};
+    };
+
+    std::unordered_map<const Chunk*, std::unique_ptr<FunctionStats>> functions_;
+    const Chunk* currentChunk_ = nullptr;
+    FunctionStats* current_ = nullptr;
+    FunctionStats* previous_ = nullptr;  // Function of the previous instruction
+    uint8_t previousOp_ = 0;
+    uint64_t last_ = 0;
+    uint64_t clockOverhead_ = 0;
+    std::vector<uint64_t> pairs_;  // OPCODE_COUNT x OPCODE_COUNT
+
+    // Clock calibration: ticks and nanoseconds at construction
+    uint64_t startTicks_;
+    uint64_t startNanos_;
+
+    void enterChunk(const CallFrame& frame);
+    Totals totals() const;
+    double nanosPerTick() const;
+    std::vector<const FunctionStats*> functionsByInstructions() const;
+
+    static uint64_t readClock();
+};
+
+}  // namespace izi
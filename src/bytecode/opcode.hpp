@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 namespace izi {
@@ -35,6 +36,9 @@ enum class OpCode : uint8_t {
     SET_GLOBAL,  // Set global variable
     GET_LOCAL,  // Get local variable
     SET_LOCAL,  // Set local variable
+    GET_UPVALUE,  // Get captured variable of the running closure (followed by upvalue index)
+    SET_UPVALUE,  // Set captured variable of the running closure (followed by upvalue index)
+    CLOSE_UPVALUE,  // Move the captured local on top of the stack into its cell, then pop it
 
     INDEX,  // Indexing operation
     SET_INDEX,  // Set value at index
@@ -46,21 +50,21 @@ enum class OpCode : uint8_t {
 
     // Functions
     CALL,  // Call function
+    INVOKE,  // Call a method on the receiver below the arguments (followed by name index and argument count)
+    CLOSURE,  // Create a closure from a function constant, capturing its upvalues (followed by constant index)
     RETURN,  // Return from function
 
     // Stack manipulation
     POP,  // Pop top of stack
     PRINT,  // Print statement
 
-    // Exception handling
-    TRY,  // Set up exception handler (followed by catch offset and finally offset)
+    // Exception handling (handlers are found through Chunk::exceptionTable)
     THROW,  // Throw an exception
-    END_TRY,  // End try-catch-finally block
 
     // Class support (v0.3)
     GET_PROPERTY,  // Get a property from an instance (followed by name index)
     SET_PROPERTY,  // Set a property on an instance (followed by name index)
-    GET_SUPER_METHOD,  // Get a method from superclass and bind to this
+    GET_SUPER_METHOD,  // Get a method from the running function's captured superclass and bind to this
     INHERIT,  // Set superclass on a class: pops superclass then subclass, sets super, pushes subclass
 
     // Module support
@@ -72,6 +76,107 @@ enum class OpCode : uint8_t {
 
     // Nullish-coalescing jump
     JUMP_IF_NOT_NIL,  // Peek top of stack; if NOT nil, jump forward (don't pop). If nil, fall through (don't pop).
+
+    // Superinstructions: fused forms of the most frequent opcode pairs in
+    // benchmarks/opcode_profile.txt (regenerate with benchmarks/opcode_profile.sh)
+    GET_LOCAL_0,  // GET_LOCAL 0 ('this' in methods)
+    GET_LOCAL_1,  // GET_LOCAL 1
+    GET_LOCAL_2,  // GET_LOCAL 2
+    GET_LOCAL_3,  // GET_LOCAL 3
+    GET_LOCAL_PROPERTY,  // GET_LOCAL + GET_PROPERTY (followed by slot and name index)
+    ADD_CONST,  // CONSTANT + ADD (followed by constant index)
+    SET_GLOBAL_POP,  // SET_GLOBAL + POP (followed by name index)
+    POP_JUMP_IF_FALSE,  // JUMP_IF_FALSE + POP on both paths: pop the condition, jump if falsy
+    LESS_CONST_JUMP,  // CONSTANT + LESS + POP_JUMP_IF_FALSE (followed by constant index and jump offset)
+
+    // Quickened forms: never emitted by the compiler.  The VM rewrites an
+    // ADD / LESS / INDEX site in place once it sees the operand types below,
+    // and rewrites it back to the generic opcode on the first miss.
+    ADD_NUM,  // ADD of two numbers
+    LESS_NUM,  // LESS of two numbers
+    INDEX_ARRAY_NUM,  // INDEX of an array by a number
+};
+
+// Number of opcodes; keep in sync with the last enumerator (the VM's dispatch
+// table is checked against it at compile time).
+constexpr size_t OPCODE_COUNT = static_cast<size_t>(OpCode::INDEX_ARRAY_NUM) + 1;
+
+// Opcodes in enum order.  The VM's computed-goto table and opcodeName() are
+// generated from this list; vm.cpp checks it against the enum.
+#define IZI_VM_OPCODES(X)                                                                                      \
+    X(CONSTANT) X(NIL) X(TRUE) X(FALSE) X(ADD) X(SUBTRACT) X(MULTIPLY) X(DIVIDE) X(MODULO) X(NEGATE) X(EQUAL) \
+    X(NOT_EQUAL) X(GREATER) X(GREATER_EQUAL) X(LESS) X(LESS_EQUAL) X(NOT) X(GET_GLOBAL) X(SET_GLOBAL)        \
+    X(GET_LOCAL) X(SET_LOCAL) X(GET_UPVALUE) X(SET_UPVALUE) X(CLOSE_UPVALUE) X(INDEX) X(SET_INDEX) X(JUMP)   \
+    X(JUMP_IF_FALSE) X(LOOP) X(CALL) X(INVOKE) X(CLOSURE) X(RETURN) X(POP) X(PRINT) X(THROW)                 \
+    X(GET_PROPERTY) X(SET_PROPERTY) X(GET_SUPER_METHOD) X(INHERIT) X(LOAD_MODULE) X(BUILD_ARRAY)             \
+    X(BUILD_MAP) X(JUMP_IF_NOT_NIL) X(GET_LOCAL_0) X(GET_LOCAL_1) X(GET_LOCAL_2) X(GET_LOCAL_3)               \
+    X(GET_LOCAL_PROPERTY) X(ADD_CONST) X(SET_GLOBAL_POP) X(POP_JUMP_IF_FALSE) X(LESS_CONST_JUMP) X(ADD_NUM)    \
+    X(LESS_NUM) X(INDEX_ARRAY_NUM)
+
+inline constexpr const char* OPCODE_NAMES[] = {
+#define IZI_VM_OPCODE_NAME(name) #name,
+    IZI_VM_OPCODES(IZI_VM_OPCODE_NAME)
+#undef IZI_VM_OPCODE_NAME
 };
 
+// Mnemonic of an opcode, "UNKNOWN" past the last one
+constexpr const char* opcodeName(size_t op) {
+    return op < OPCODE_COUNT ? OPCODE_NAMES[op] : "UNKNOWN";
+}
+
+// Operand bytes following each opcode
+constexpr size_t operandBytes(OpCode op) {
+    switch (op) {
+        case OpCode::CONSTANT:
+        case OpCode::GET_GLOBAL:
+        case OpCode::SET_GLOBAL:
+        case OpCode::GET_LOCAL:
+        case OpCode::SET_LOCAL:
+        case OpCode::GET_UPVALUE:
+        case OpCode::SET_UPVALUE:
+        case OpCode::CALL:
+        case OpCode::CLOSURE:
+        case OpCode::GET_PROPERTY:
+        case OpCode::SET_PROPERTY:
+        case OpCode::GET_SUPER_METHOD:
+        case OpCode::LOAD_MODULE:
+        case OpCode::BUILD_ARRAY:
+        case OpCode::BUILD_MAP:
+        case OpCode::ADD_CONST:
+        case OpCode::SET_GLOBAL_POP:
+            return 1;
+        case OpCode::JUMP:
+        case OpCode::JUMP_IF_FALSE:
+        case OpCode::LOOP:
+        case OpCode::INVOKE:
+        case OpCode::JUMP_IF_NOT_NIL:
+        case OpCode::GET_LOCAL_PROPERTY:
+        case OpCode::POP_JUMP_IF_FALSE:
+            return 2;
+        case OpCode::LESS_CONST_JUMP:
+            return 3;
+        default:
+            return 0;
+    }
+}
+
+// FNV-1a hash of every opcode's name, number and operand width.  Binary
+// formats that store bytecode pin it (see ChunkSerializer) so that
+// renumbering an opcode cannot go unnoticed by their version.
+constexpr uint64_t opcodeFingerprint() {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto mix = [&hash](uint8_t byte) {
+        hash ^= byte;
+        hash *= 0x100000001b3ull;
+    };
+    for (size_t op = 0; op < OPCODE_COUNT; ++op) {
+        for (const char* c = OPCODE_NAMES[op]; *c != '\0'; ++c) {
+            mix(static_cast<uint8_t>(*c));
+        }
+        mix(0);
+        mix(static_cast<uint8_t>(operandBytes(static_cast<OpCode>(op))));
+    }
+    return hash;
+}
+
 }  // namespace izi
\ No newline at end of file
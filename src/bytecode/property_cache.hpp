@@ -0,0 +1,87 @@
+#pragma once
+
+#include "common/shape.hpp"
+#include "common/value.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace izi {
+
+class VmUserFunction;
+
+// One receiver type seen at a GET_PROPERTY / SET_PROPERTY / INVOKE site.
+// Shapes hold no references back to classes or values, so entries pin them
+// strongly; a pinned shape cannot be confused with a newer one at the same
+// address.  A method is held by raw pointer: a hit means a live instance has
+// `shape`, whose class (and so the method) is therefore still alive.
+struct PropertyCacheEntry {
+    enum class Kind : uint8_t {
+        Empty,
+        Field,     // Instance with `shape`: value in slots[slot]
+        AddField,  // SET only: field missing on `shape`; append to slots and move to `transition`
+        Method,    // GET / INVOKE: no such field on `shape`; resolves to `method`
+        MapEntry,  // `map` with layoutVersion == `slot`: value at `mapValue`
+    };
+
+    Kind kind = Kind::Empty;
+    uint32_t slot = 0;
+    std::shared_ptr<Shape> shape;
+    std::shared_ptr<Shape> transition;
+    VmUserFunction* method = nullptr;
+    const Map* map = nullptr;
+    uint64_t mapId = 0;  // Detects a dead map whose address was reused
+    Value* mapValue = nullptr;
+};
+
+// Map::cacheId of a map a cache is about to record
+inline uint64_t mapCacheId(Map& map) {
+    static std::atomic<uint64_t> next{0};
+    if (map.cacheId == 0) {
+        map.cacheId = next.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+    return map.cacheId;
+}
+
+// Polymorphic inline cache for one property access or method call site.  Chunk names are
+// not deduplicated, so a chunk's name index identifies the site.
+struct PropertyCache {
+    static constexpr size_t WAYS = 4;
+
+    std::array<PropertyCacheEntry, WAYS> entries;
+    uint8_t nextVictim = 0;  // Round-robin replacement once every way is in use
+
+    PropertyCacheEntry* findShape(const Shape* shape) {
+        for (auto& entry : entries) {
+            if (entry.shape.get() == shape) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    PropertyCacheEntry* findMap(const Map& map) {
+        for (auto& entry : entries) {
+            if (entry.map == &map && entry.slot == map.layoutVersion && entry.mapId == map.cacheId) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    // Entry to fill for a newly seen receiver
+    PropertyCacheEntry& claim() {
+        for (auto& entry : entries) {
+            if (entry.kind == PropertyCacheEntry::Kind::Empty) {
+                return entry;
+            }
+        }
+        PropertyCacheEntry& victim = entries[nextVictim];
+        nextVictim = static_cast<uint8_t>((nextVictim + 1) % WAYS);
+        victim = PropertyCacheEntry{};
+        return victim;
+    }
+};
+
+}  // namespace izi
@@ -5,59 +5,256 @@
 #include "bytecode/vm_user_function.hpp"
 #include "bytecode/vm_native_modules.hpp"
 #include "interp/izi_class.hpp"
+#include "bytecode/op_stats.hpp"
+#include "common/profiler.hpp"
+#include "common/trace.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
 
 namespace izi {
 
-VM::VM() : stack(), frames() {
-    stack.reserve(STACK_MAX);
-    frames.reserve(64);  // Arbitrary limit on call frames
+static std::atomic<uint64_t> nextVmId{1};
+
+VM::VM() : stack(), frames(), id(nextVmId++) {
+    frames.reserve(MAX_CALL_FRAMES);  // CallFrame pointers held by run() stay valid
+
+    if (const char* threshold = std::getenv("IZI_JIT_THRESHOLD")) {
+        jitThreshold = static_cast<uint32_t>(std::strtoul(threshold, nullptr, 10));
+    }
+    if (const char* enabled = std::getenv("IZI_JIT"); enabled && *enabled && std::string(enabled) != "0") {
+        enableJit(jitThreshold);
+    }
+}
+
+bool VM::enableJit(uint32_t threshold) {
+    jit = jitSupported();
+    jitThreshold = threshold;
+    return jit;
+}
+
+void VM::sampleProfile() {
+    profiler->beginSample();
+    for (const CallFrame& callFrame : frames) {
+        const uint8_t* code = callFrame.chunk->code.data();
+        // A caller's ip is past its CALL; a fresh frame's is at offset 0
+        size_t offset = callFrame.ip > code ? static_cast<size_t>(callFrame.ip - code) - 1 : 0;
+        int line = callFrame.chunk->getLine(offset);
+        if (callFrame.function) {
+            profiler->addFrame(callFrame.function->name(), line);
+        } else {
+            profiler->addFrame("<script>", line);
+        }
+    }
+    profiler->endSample();
+}
+
+void VM::traceFrames() {
+    for (; tracedFrames > frames.size(); --tracedFrames) {
+        Trace::end();
+    }
+    for (; tracedFrames < frames.size(); ++tracedFrames) {
+        const CallFrame& callFrame = frames[tracedFrames];
+        Trace::begin("call", callFrame.function ? callFrame.function->name() : "<script>");
+    }
+}
+
+const JitCode* VM::jitCodeFor(const Chunk& chunk) {
+    if (!chunk.jitCode) {
+        if (jitThreshold == UINT32_MAX || ++chunk.hotness < jitThreshold) {
+            return nullptr;
+        }
+        chunk.jitCode = compileChunk(chunk);
+    }
+    return chunk.jitCode->compiled() ? chunk.jitCode.get() : nullptr;
+}
+
+uint32_t VM::globalSlot(const std::string& name) {
+    auto [it, inserted] = globalSlotIndex.try_emplace(name, static_cast<uint32_t>(globalValues.size()));
+    if (inserted) {
+        globalValues.emplace_back();
+        globalDefined.push_back(0);
+        globalNames.push_back(name);
+    }
+    return it->second;
+}
+
+void VM::link(const Chunk& chunk) {
+    chunk.globalSlots.resize(chunk.names.size());
+    chunk.propertyCaches.assign(chunk.names.size(), PropertyCache{});
+    for (size_t i = 0; i < chunk.names.size(); ++i) {
+        chunk.globalSlots[i] = globalSlot(chunk.names[i]);
+    }
+    chunk.linkedVm = id;
 }
 
 void VM::setGlobal(const std::string& name, const Value& value) {
-    globals[name] = value;
+    uint32_t slot = globalSlot(name);
+    globalValues[slot] = value;
+    globalDefined[slot] = 1;
+}
+
+const Value* VM::findGlobal(const std::string& name) const {
+    auto it = globalSlotIndex.find(name);
+    if (it == globalSlotIndex.end() || !globalDefined[it->second]) {
+        return nullptr;
+    }
+    return &globalValues[it->second];
+}
+
+Ref<Upvalue> VM::captureUpvalue(size_t slot) {
+    auto it = openUpvalues.end();
+    while (it != openUpvalues.begin() && (*(it - 1))->slot > slot) {
+        --it;
+    }
+    if (it != openUpvalues.begin() && (*(it - 1))->slot == slot) {
+        return *(it - 1);
+    }
+    auto upvalue = makeRef<Upvalue>(slot);
+    openUpvalues.insert(it, upvalue);
+    return upvalue;
+}
+
+void VM::closeUpvalues(size_t fromSlot) {
+    while (!openUpvalues.empty() && openUpvalues.back()->slot >= fromSlot) {
+        Upvalue& upvalue = *openUpvalues.back();
+        upvalue.closed = stack[upvalue.slot];
+        upvalue.open = false;
+        openUpvalues.pop_back();
+    }
+}
+
+std::unordered_map<std::string, Value> VM::getGlobals() const {
+    std::unordered_map<std::string, Value> result;
+    for (size_t slot = 0; slot < globalValues.size(); ++slot) {
+        if (globalDefined[slot]) {
+            result.emplace(globalNames[slot], globalValues[slot]);
+        }
+    }
+    return result;
 }
 
 CallFrame* VM::currentFrame() {
     return &frames.back();
 }
 
-uint8_t VM::readByte() {
-    CallFrame* frame = currentFrame();
-    return *frame->ip++;
+// Dispatch strategy.  GCC and Clang support "labels as values", which lets
+// every handler end with its own indirect jump to the next handler instead
+// of returning to a shared switch; the branch predictor then learns opcode
+// sequences.  Other compilers (or -DIZI_VM_SWITCH_DISPATCH) use the switch.
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(IZI_VM_SWITCH_DISPATCH)
+#define IZI_VM_COMPUTED_GOTO 1
+#else
+#define IZI_VM_COMPUTED_GOTO 0
+#endif
+
+namespace {
+
+constexpr OpCode opcodeOrder[] = {
+#define IZI_VM_OPCODE_ENTRY(name) OpCode::name,
+    IZI_VM_OPCODES(IZI_VM_OPCODE_ENTRY)
+#undef IZI_VM_OPCODE_ENTRY
+};
+
+constexpr bool opcodeListMatchesEnum() {
+    for (size_t i = 0; i < std::size(opcodeOrder); ++i) {
+        if (static_cast<size_t>(opcodeOrder[i]) != i) {
+            return false;
+        }
+    }
+    return std::size(opcodeOrder) == OPCODE_COUNT;
 }
+static_assert(opcodeListMatchesEnum(), "IZI_VM_OPCODES must list every OpCode in declaration order");
+
+#ifdef IZI_VM_COUNT_DISPATCH
+// Benchmark builds only (see benchmarks/dispatch.sh and
+// benchmarks/opcode_profile.sh): instructions and opcode pairs dispatched by
+// every VM in the process.  The total is reported on exit; the full profile is
+// written to the file named by IZI_VM_PROFILE when that variable is set.
+struct DispatchProfile {
+    uint64_t total = 0;
+    uint8_t previous = 0;
+    bool hasPrevious = false;
+    uint64_t opcodes[OPCODE_COUNT] = {};
+    uint64_t pairs[OPCODE_COUNT][OPCODE_COUNT] = {};
+
+    void record(uint8_t op) {
+        ++total;
+        if (op >= OPCODE_COUNT) {
+            return;
+        }
+        ++opcodes[op];
+        if (hasPrevious) {
+            ++pairs[previous][op];
+        }
+        previous = op;
+        hasPrevious = true;
+    }
+
+    ~DispatchProfile() {
+        std::cerr << "vm: " << total << " instructions dispatched\n";
+        const char* path = std::getenv("IZI_VM_PROFILE");
+        if (path == nullptr) {
+            return;
+        }
+        std::ofstream out(path);
+        for (size_t a = 0; a < OPCODE_COUNT; ++a) {
+            if (opcodes[a] != 0) {
+                out << "op " << opcodeName(a) << ' ' << opcodes[a] << '\n';
+            }
+        }
+        for (size_t a = 0; a < OPCODE_COUNT; ++a) {
+            for (size_t b = 0; b < OPCODE_COUNT; ++b) {
+                if (pairs[a][b] != 0) {
+                    out << "pair " << opcodeName(a) << ' ' << opcodeName(b) << ' ' << pairs[a][b] << '\n';
+                }
+            }
+        }
+    }
+} dispatchProfile;
+#define IZI_VM_COUNT(op) dispatchProfile.record(op)
+#else
+#define IZI_VM_COUNT(op) ((void)0)
+#endif
 
-uint16_t VM::readShort() {
-    CallFrame* frame = currentFrame();
-    uint16_t high = *frame->ip++;
-    uint16_t low = *frame->ip++;
-    return (high << 8) | low;
+[[noreturn]] void throwExpectedNumber() {
+    throw std::runtime_error("Expected number.");
 }
 
-Value VM::run(const Chunk& entry, const std::vector<Value>& initialLocals,
-              std::shared_ptr<VmUserFunction> function) {
+}  // namespace
+
+Value VM::run(const Chunk& entry, const std::vector<Value>& initialLocals, Ref<VmUserFunction> function) {
     bool wasRunning = isRunning;
     isRunning = true;
 
     if (!wasRunning) {
         stack.clear();
         frames.clear();
+        openUpvalues.clear();
+        uncaughtError = false;
     }
 
     size_t startingFrameCount = frames.size();
-    CallFrame mainFrame{&entry, entry.code.data(), stack.size(), std::move(function)};
-
-    frames.push_back(mainFrame);
+    size_t startingStackSize = stack.size();
+    if (entry.linkedVm != id) {
+        link(entry);
+    }
+    CallFrame mainFrame{&entry, entry.code.data(), stack.size(), stack.size(), function.get()};
 
     // Check for stack overflow (call depth)
-    if (frames.size() > MAX_CALL_FRAMES) {
+    if (frames.size() >= MAX_CALL_FRAMES) {
         isRunning = wasRunning;
         throw std::runtime_error("Stack overflow: Maximum call depth of " + std::to_string(MAX_CALL_FRAMES) +
                                  " exceeded.");
     }
 
+    frames.push_back(mainFrame);
+
     // Push initial local variable slots (function parameters) after the frame is set up
     // so that GET_LOCAL 0 == stack[stackBase + 0] == first parameter.
     // Guard against unreasonably large parameter lists that would exhaust the stack.
@@ -70,260 +267,409 @@ Value VM::run(const Chunk& entry, const std::vector<Value>& initialLocals,
         stack.push_back(local);
     }
 
+    // Interpreter registers.  The hot handlers work on these locals only;
+    // SAVE_STATE() publishes them before anything that can call out, throw,
+    // or push a frame, and LOAD_STATE() picks up whatever that changed.
+    CallFrame* frame;
+    const uint8_t* ip;
+    Value* slots;  // Local 0 of the running frame
+    Value* sp;  // One past the top of the stack
+    const Value* constants;
+    Value* const stackLimit = stack.limit();
+
+#define SAVE_STATE()          \
+    do {                      \
+        frame->ip = ip;       \
+        stack.setTop(sp);     \
+    } while (false)
+#define LOAD_STATE()                                 \
+    do {                                             \
+        frame = &frames.back();                      \
+        ip = frame->ip;                              \
+        slots = stack.data() + frame->stackBase;     \
+        constants = frame->chunk->constants.data();  \
+        sp = stack.top();                            \
+    } while (false)
+#define READ_BYTE() (*ip++)
+#define READ_SHORT() (ip += 2, static_cast<uint16_t>((ip[-2] << 8) | ip[-1]))
+#define PUSH(value)                                                            \
+    do {                                                                       \
+        if (sp == stackLimit) {                                                \
+            SAVE_STATE();                                                      \
+            throw std::runtime_error("Stack overflow: too many values on the stack."); \
+        }                                                                      \
+        *sp++ = (value);                                                       \
+    } while (false)
+#define NUMBER_OPERANDS()                               \
+    if (!sp[-2].isNumber() || !sp[-1].isNumber()) {     \
+        SAVE_STATE();                                   \
+        throwExpectedNumber();                          \
+    }                                                   \
+    double a = sp[-2].asNumber();                       \
+    double b = sp[-1].asNumber()
+// Type quickening: rewrite the opcode byte of the executing instruction in
+// the chunk's code (see Chunk::code).  Only used by operand-free opcodes, so
+// that byte is ip[-1].
+#define QUICKEN(op) \
+    (frame->chunk->code[static_cast<size_t>(ip - frame->chunk->code.data()) - 1] = static_cast<uint8_t>(OpCode::op))
+// A quickened instruction whose operands do not match: restore the generic
+// opcode and dispatch the same instruction again
+#define DEQUICKEN(op)  \
+    {                  \
+        QUICKEN(op);   \
+        --ip;          \
+        DISPATCH();    \
+    }
+// Numbers hold no references, so popping one only moves the top
+#define BINARY_NUMBER(expr) \
+    {                       \
+        NUMBER_OPERANDS();  \
+        --sp;               \
+        sp[-1] = Value(expr); \
+        DISPATCH();         \
+    }
+
+// Record a profiler sample when its timer has ticked
+#define PROFILE_SAMPLE()                                                                   \
+    do {                                                                                   \
+        if (profiler && Profiler::pending()) [[unlikely]] {                                \
+            frame->ip = ip;                                                                \
+            sampleProfile();                                                               \
+        }                                                                                  \
+    } while (false)
+// Safepoint at run entry, calls, returns and loop back-edges: profiling,
+// cycle collection, call slices for --trace-out, and the baseline JIT,
+// which counts an entry into the running chunk and, once it has native
+// code, runs that from the current instruction up to the first instruction
+// it leaves to this loop
+#define SAFEPOINT()                                                                        \
+    do {                                                                                   \
+        PROFILE_SAMPLE();                                                                  \
+        Gc::maybeCollect();                                                                \
+        if (Trace::enabled()) [[unlikely]] {                                               \
+            traceFrames();                                                                 \
+        }                                                                                  \
+        if (jit) {                                                                         \
+            if (const JitCode* native = jitCodeFor(*frame->chunk)) {                       \
+                const uint8_t* code = frame->chunk->code.data();                           \
+                JitContext context{sp, slots, constants, stackLimit, this, frame};         \
+                ip = code + native->run(context, static_cast<uint32_t>(ip - code));        \
+                sp = context.sp;                                                           \
+            }                                                                              \
+        }                                                                                  \
+    } while (false)
+
+#if IZI_VM_COMPUTED_GOTO
+    static const void* const dispatchTable[] = {
+#define IZI_VM_LABEL_ADDRESS(name) &&op_##name,
+        IZI_VM_OPCODES(IZI_VM_LABEL_ADDRESS)
+#undef IZI_VM_LABEL_ADDRESS
+    };
+    // With --opstats every opcode goes through recordOpcode first, so the
+    // plain dispatch path carries no check for it
+    static const void* const opStatsTable[] = {
+#define IZI_VM_RECORD_ADDRESS(name) &&recordOpcode,
+        IZI_VM_OPCODES(IZI_VM_RECORD_ADDRESS)
+#undef IZI_VM_RECORD_ADDRESS
+    };
+    const void* const* const handlers = opStats ? opStatsTable : dispatchTable;
+// A computed goto leaves the handler's scope without running destructors,
+// so a handler that holds a Value or Ref in a local keeps it in an
+// inner block that closes before DISPATCH() (or moves it out first)
+#define CASE(name) op_##name:
+#define DISPATCH()                                                  \
+    do {                                                            \
+        uint8_t nextOp = *ip++;                                     \
+        IZI_VM_COUNT(nextOp);                                       \
+        if (nextOp >= OPCODE_COUNT) [[unlikely]] goto unknownOpcode; \
+        goto* handlers[nextOp];                                     \
+    } while (false)
+#else
+#define CASE(name) case OpCode::name:
+#define DISPATCH() goto dispatchLoop
+#endif
+
     while (true) {
         try {
-            OpCode op = static_cast<OpCode>(readByte());
-            switch (static_cast<OpCode>(op)) {
-                case OpCode::CONSTANT: {
-                    uint8_t index = readByte();
-                    const Value& constant = currentFrame()->chunk->constants[index];
-                    if (std::holds_alternative<std::shared_ptr<VmCallable>>(constant)) {
-                        auto callable = std::get<std::shared_ptr<VmCallable>>(constant);
-                        auto functionTemplate = std::dynamic_pointer_cast<VmUserFunction>(callable);
-                        if (functionTemplate && !functionTemplate->captureNames().empty()) {
-                            std::unordered_map<std::string, Value> capturedVars;
-                            for (const auto& name : functionTemplate->captureNames()) {
-                                bool bound = false;
-                                if (currentFrame()->function) {
-                                    const auto& localNames = currentFrame()->function->localNames();
-                                    auto localIt = std::find(localNames.begin(), localNames.end(), name);
-                                    if (localIt != localNames.end()) {
-                                        size_t slot = static_cast<size_t>(std::distance(localNames.begin(), localIt));
-                                        size_t stackIndex = currentFrame()->stackBase + slot;
-                                        if (stackIndex < stack.size()) {
-                                            capturedVars[name] = stack[stackIndex];
-                                            bound = true;
-                                        }
-                                    }
-                                    if (!bound) {
-                                        if (const Value* captured = currentFrame()->function->getCapturedVar(name)) {
-                                            capturedVars[name] = *captured;
-                                            bound = true;
-                                        }
-                                    }
-                                }
-                                if (!bound) {
-                                    auto globalIt = globals.find(name);
-                                    if (globalIt != globals.end()) {
-                                        capturedVars[name] = globalIt->second;
-                                    }
-                                }
-                            }
-                            push(std::static_pointer_cast<VmCallable>(functionTemplate->bindCaptured(std::move(capturedVars))));
-                            break;
-                        }
-                    }
-                    push(constant);
-                    break;
+            LOAD_STATE();
+            SAFEPOINT();
+#if IZI_VM_COMPUTED_GOTO
+            DISPATCH();
+        recordOpcode:
+            opStats->record(*frame, ip[-1]);
+            goto* dispatchTable[ip[-1]];
+#else
+        dispatchLoop:
+            IZI_VM_COUNT(*ip);
+            if (opStats && *ip < OPCODE_COUNT) [[unlikely]] {
+                opStats->record(*frame, *ip);
+            }
+            switch (static_cast<OpCode>(*ip++)) {
+#endif
+            CASE(CONSTANT) {
+                PUSH(constants[READ_BYTE()]);
+                DISPATCH();
+            }
+            CASE(NIL) {
+                PUSH(Value());
+                DISPATCH();
+            }
+            CASE(TRUE) {
+                PUSH(Value(true));
+                DISPATCH();
+            }
+            CASE(FALSE) {
+                PUSH(Value(false));
+                DISPATCH();
+            }
+            CASE(POP) {
+                *--sp = Value();
+                DISPATCH();
+            }
+            CASE(GET_GLOBAL) {
+                uint8_t nameIndex = READ_BYTE();
+                uint32_t slot = frame->chunk->globalSlots[nameIndex];
+                if (!globalDefined[slot]) {
+                    SAVE_STATE();
+                    throw std::runtime_error("Undefined variable '" + frame->chunk->names[nameIndex] + "'.");
                 }
-                case OpCode::NIL:
-                    push(Nil{});
-                    break;
-                case OpCode::TRUE:
-                    push(true);
-                    break;
-                case OpCode::FALSE:
-                    push(false);
-                    break;
-                case OpCode::POP:
-                    pop();
-                    break;
-                case OpCode::GET_GLOBAL: {
-                    uint8_t nameIndex = readByte();
-                    const std::string& name = currentFrame()->chunk->names[nameIndex];
-                    if (currentFrame()->function) {
-                        if (const Value* captured = currentFrame()->function->getCapturedVar(name)) {
-                            push(*captured);
-                            break;
+                PUSH(globalValues[slot]);
+                DISPATCH();
+            }
+            CASE(SET_GLOBAL) {
+                uint32_t slot = frame->chunk->globalSlots[READ_BYTE()];
+                globalValues[slot] = sp[-1];  // Peek at the value
+                globalDefined[slot] = 1;
+                DISPATCH();
+            }
+            CASE(GET_UPVALUE) {
+                Upvalue& upvalue = frame->function->upvalue(READ_BYTE());
+                PUSH(upvalue.open ? stack[upvalue.slot] : upvalue.closed);
+                DISPATCH();
+            }
+            CASE(SET_UPVALUE) {
+                Upvalue& upvalue = frame->function->upvalue(READ_BYTE());
+                (upvalue.open ? stack[upvalue.slot] : upvalue.closed) = sp[-1];
+                DISPATCH();
+            }
+            CASE(CLOSE_UPVALUE) {
+                closeUpvalues(static_cast<size_t>(sp - 1 - stack.data()));
+                *--sp = Value();
+                DISPATCH();
+            }
+            CASE(CLOSURE) {
+                {
+                    const auto& prototype = static_cast<const VmUserFunction&>(*constants[READ_BYTE()].asVmCallable());
+                    const auto& descs = prototype.upvalueDescs();
+                    std::vector<Ref<Upvalue>> upvalues;
+                    upvalues.reserve(descs.size());
+                    for (const auto& desc : descs) {
+                        if (desc.isLocal) {
+                            upvalues.push_back(captureUpvalue(frame->stackBase + desc.index));
+                        } else {
+                            upvalues.push_back(frame->function->upvalueCell(desc.index));
                         }
                     }
-                    auto it = globals.find(name);
-                    if (it == globals.end()) {
-                        throw std::runtime_error("Undefined variable '" + name + "'.");
-                    }
-                    push(it->second);
-                    break;
-                }
-                case OpCode::SET_GLOBAL: {
-                    uint8_t nameIndex = readByte();
-                    const std::string& name = currentFrame()->chunk->names[nameIndex];
-                    Value value = stack.back();  // Peek at the value
-                    if (currentFrame()->function && currentFrame()->function->setCapturedVar(name, value)) {
-                        break;
-                    }
-                    globals[name] = value;
-                    break;
-                }
-                case OpCode::PRINT: {
-                    Value value = pop();
-                    printValue(value);
-                    std::cout << '\n';
-                    break;
-                }
-                case OpCode::ADD: {
-                    Value b = pop();
-                    Value a = pop();
-                    if (std::holds_alternative<std::string>(a) && std::holds_alternative<std::string>(b)) {
-                        push(std::get<std::string>(a) + std::get<std::string>(b));
-                    } else {
-                        push(asNumber(a) + asNumber(b));
+                    auto closure = prototype.bindUpvalues(std::move(upvalues));
+                    if (frame->function) {
+                        closure->setSuperclass(frame->function->superclass());  // `super` inside a method
                     }
-                    break;
+                    PUSH(staticRefCast<VmCallable>(std::move(closure)));
                 }
-                case OpCode::SUBTRACT:
-                    binaryNumeric([](double a, double b) { return a - b; });
-                    break;
-                case OpCode::MULTIPLY:
-                    binaryNumeric([](double a, double b) { return a * b; });
-                    break;
-                case OpCode::DIVIDE:
-                    binaryNumeric([](double a, double b) { return a / b; });
-                    break;
-                case OpCode::MODULO:
-                    binaryNumeric([](double a, double b) {
-                        if (b == 0.0) {
-                            throw std::runtime_error("Division by zero in modulo operation.");
-                        }
-                        return std::fmod(a, b);
-                    });
-                    break;
-                case OpCode::NEGATE: {
-                    Value value = pop();
-                    push(-asNumber(value));
-                    break;
+                DISPATCH();
+            }
+            CASE(PRINT) {
+                printValue(sp[-1]);
+                std::cout << '\n';
+                *--sp = Value();
+                DISPATCH();
+            }
+            CASE(ADD) {
+                Value& a = sp[-2];
+                Value& b = sp[-1];
+                if (a.isNumber() && b.isNumber()) {
+                    QUICKEN(ADD_NUM);
+                    a = Value(a.asNumber() + b.asNumber());
+                    --sp;
+                } else if (a.isString() && b.isString()) {
+                    a = Value(a.asString() + b.asString());
+                    *--sp = Value();
+                } else {
+                    SAVE_STATE();
+                    throwExpectedNumber();
                 }
-                case OpCode::JUMP: {
-                    uint16_t offset = readShort();
-                    currentFrame()->ip += offset;
-                    break;
+                DISPATCH();
+            }
+            CASE(SUBTRACT) BINARY_NUMBER(a - b)
+            CASE(MULTIPLY) BINARY_NUMBER(a * b)
+            CASE(DIVIDE) BINARY_NUMBER(a / b)
+            CASE(MODULO) {
+                NUMBER_OPERANDS();
+                if (b == 0.0) {
+                    SAVE_STATE();
+                    throw std::runtime_error("Division by zero in modulo operation.");
                 }
-                case OpCode::JUMP_IF_FALSE: {
-                    uint16_t offset = readShort();
-                    Value condition = stack.back();
-                    if (!isTruthy(condition)) {
-                        currentFrame()->ip += offset;
-                    }
-                    break;
+                --sp;
+                sp[-1] = Value(std::fmod(a, b));
+                DISPATCH();
+            }
+            CASE(NEGATE) {
+                if (!sp[-1].isNumber()) {
+                    SAVE_STATE();
+                    throwExpectedNumber();
                 }
-                case OpCode::LOOP: {
-                    uint16_t offset = readShort();
-                    currentFrame()->ip -= offset;
-                    break;
+                sp[-1] = Value(-sp[-1].asNumber());
+                DISPATCH();
+            }
+            CASE(JUMP) {
+                uint16_t offset = READ_SHORT();
+                ip += offset;
+                DISPATCH();
+            }
+            CASE(JUMP_IF_FALSE) {
+                uint16_t offset = READ_SHORT();
+                if (!isTruthy(sp[-1])) {
+                    ip += offset;
                 }
-                case OpCode::CALL: {
-                    uint8_t argCount = readByte();
-                    Value callee = stack[stack.size() - 1 - argCount];
-
-                    std::shared_ptr<VmCallable> function;
-                    if (std::holds_alternative<std::shared_ptr<VmCallable>>(callee)) {
-                        function = std::get<std::shared_ptr<VmCallable>>(callee);
-                    } else if (std::holds_alternative<std::shared_ptr<VmClass>>(callee)) {
-                        function = std::get<std::shared_ptr<VmClass>>(callee);
-                    } else {
-                        throw std::runtime_error("Can only call VM functions and classes.");
-                    }
-
-                    int ar = function->arity();
-                    if (ar >= 0 && argCount != ar) {
-                        throw std::runtime_error("Expected " + std::to_string(function->arity()) +
-                                                 " arguments but got " + std::to_string(argCount) + ".");
-                    }
-                    std::vector<Value> args;
-                    args.reserve(argCount);
-                    for (size_t i = 0; i < argCount; ++i) {
-                        args.push_back(stack[stack.size() - argCount + i]);
-                    }
+                DISPATCH();
+            }
+            CASE(LOOP) {
+                uint16_t offset = READ_SHORT();
+                ip -= offset;
+                SAFEPOINT();
+                DISPATCH();
+            }
+            CASE(CALL) {
+                uint8_t argCount = READ_BYTE();
+                SAVE_STATE();
+                callValue(static_cast<size_t>(sp - 1 - argCount - stack.data()), argCount);
+                LOAD_STATE();
+                SAFEPOINT();
+                DISPATCH();
+            }
+            CASE(INVOKE) {
+                // obj.name(args): the receiver stays in the slot below the
+                // arguments and becomes local 0 ('this') of the method's frame.
+                uint8_t nameIndex = READ_BYTE();
+                uint8_t argCount = READ_BYTE();
+                SAVE_STATE();
+                const Chunk* chunk = frame->chunk;
+                PropertyCache& cache = chunk->propertyCaches[nameIndex];
+                size_t receiverSlot = static_cast<size_t>(sp - 1 - argCount - stack.data());
+                const Value& receiver = stack[receiverSlot];
 
-                    // Pop arguments and callee
-                    for (size_t i = 0; i < argCount + 1; ++i) {
-                        pop();
-                    }
-                    Value result = function->call(*this, args);
-                    push(result);
-                    break;
-                }
-                case OpCode::RETURN: {
-                    Value result = pop();
-                    CallFrame finished = frames.back();
-                    frames.pop_back();
-
-                    // Check if we've returned from the frame we pushed in this run() call
-                    if (frames.size() == startingFrameCount) {
-                        // Clean up any local variable slots that were pushed for this frame
-                        stack.resize(finished.stackBase);
-                        isRunning = wasRunning;
-                        return result;
+                if (receiver.isInstance()) {
+                    Instance& instance = *receiver.asInstance();
+                    const PropertyCacheEntry* entry = cache.findShape(instance.shape.get());
+                    if (entry && entry->kind == PropertyCacheEntry::Kind::Method) {
+                        pushMethodFrame(entry->method, receiverSlot, argCount);
+                        LOAD_STATE();
+                        SAFEPOINT();
+                        DISPATCH();
                     }
-
-                    if (frames.empty()) {
-                        stack.resize(finished.stackBase);
-                        isRunning = wasRunning;
-                        return result;  // Exit the VM
+                } else if (receiver.isMap()) {
+                    if (const PropertyCacheEntry* entry = cache.findMap(*receiver.asMap())) {
+                        stack[receiverSlot] = Value(*entry->mapValue);
+                        callValue(receiverSlot, argCount);
+                        LOAD_STATE();
+                        SAFEPOINT();
+                        DISPATCH();
                     }
-                    // Clean up the stack
-                    stack.resize(finished.stackBase);
-                    push(result);
-                    break;
                 }
-                case OpCode::EQUAL: {
-                    Value b = pop();
-                    Value a = pop();
-                    push(a == b);
-                    break;
+                invoke(cache, chunk->names[nameIndex], receiverSlot, argCount);
+                LOAD_STATE();
+                SAFEPOINT();
+                DISPATCH();
+            }
+            CASE(RETURN) {
+                PROFILE_SAMPLE();  // Ticks that arrived in the returning frame's native code
+                Value result = std::move(*--sp);
+                if (frame->isConstructor) {
+                    result = slots[0];  // The new instance in slot 0
                 }
-                case OpCode::NOT_EQUAL: {
-                    Value b = pop();
-                    Value a = pop();
-                    push(a != b);
-                    break;
+                if (!openUpvalues.empty()) {
+                    closeUpvalues(frame->stackBase);
                 }
-                case OpCode::GREATER:
-                    binaryComparison([](double a, double b) { return a > b; });
-                    break;
-                case OpCode::GREATER_EQUAL:
-                    binaryComparison([](double a, double b) { return a >= b; });
-                    break;
-                case OpCode::LESS:
-                    binaryComparison([](double a, double b) { return a < b; });
-                    break;
-                case OpCode::LESS_EQUAL:
-                    binaryComparison([](double a, double b) { return a <= b; });
-                    break;
-                case OpCode::NOT: {
-                    Value value = pop();
-                    push(!isTruthy(value));
-                    break;
+                Value* resultTop = stack.data() + frame->resultSlot;
+                while (sp > resultTop) {
+                    *--sp = Value();
                 }
-                case OpCode::GET_LOCAL: {
-                    uint8_t slot = readByte();
-                    push(stack[currentFrame()->stackBase + slot]);
-                    break;
-                }
-                case OpCode::SET_LOCAL: {
-                    uint8_t slot = readByte();
-                    stack[currentFrame()->stackBase + slot] = stack.back();
-                    break;
+                frames.pop_back();
+
+                // Check if we've returned from the frame we pushed in this run() call
+                if (frames.size() == startingFrameCount) {
+                    if (Trace::enabled()) [[unlikely]] {
+                        traceFrames();
+                    }
+                    stack.setTop(sp);
+                    isRunning = wasRunning;
+                    return result;
                 }
-                case OpCode::INDEX: {
+                *sp++ = std::move(result);
+                frame = &frames.back();
+                ip = frame->ip;
+                slots = stack.data() + frame->stackBase;
+                constants = frame->chunk->constants.data();
+                SAFEPOINT();
+                DISPATCH();
+            }
+            CASE(EQUAL) {
+                bool equal = sp[-2] == sp[-1];
+                *--sp = Value();
+                sp[-1] = Value(equal);
+                DISPATCH();
+            }
+            CASE(NOT_EQUAL) {
+                bool notEqual = sp[-2] != sp[-1];
+                *--sp = Value();
+                sp[-1] = Value(notEqual);
+                DISPATCH();
+            }
+            CASE(GREATER) BINARY_NUMBER(a > b)
+            CASE(GREATER_EQUAL) BINARY_NUMBER(a >= b)
+            CASE(LESS) {
+                NUMBER_OPERANDS();
+                QUICKEN(LESS_NUM);
+                --sp;
+                sp[-1] = Value(a < b);
+                DISPATCH();
+            }
+            CASE(LESS_EQUAL) BINARY_NUMBER(a <= b)
+            CASE(NOT) {
+                sp[-1] = Value(!isTruthy(sp[-1]));
+                DISPATCH();
+            }
+            CASE(GET_LOCAL) {
+                PUSH(slots[READ_BYTE()]);
+                DISPATCH();
+            }
+            CASE(SET_LOCAL) {
+                slots[READ_BYTE()] = sp[-1];
+                DISPATCH();
+            }
+            CASE(INDEX) {
+                SAVE_STATE();
+                {
                     Value index = pop();
                     Value collection = pop();
 
-                    if (std::holds_alternative<std::shared_ptr<Array>>(collection)) {
-                        auto arr = std::get<std::shared_ptr<Array>>(collection);
-                        if (!std::holds_alternative<double>(index)) {
+                    if (collection.isArray()) {
+                        const auto& arr = collection.asArray();
+                        if (!index.isNumber()) {
                             throw std::runtime_error("Array index must be a number.");
                         }
-                        size_t idx = validateArrayIndex(std::get<double>(index));
+                        size_t idx = validateArrayIndex(index.asNumber());
                         if (idx >= arr->elements.size()) {
                             throw std::runtime_error("Array index out of bounds.");
                         }
+                        QUICKEN(INDEX_ARRAY_NUM);
                         push(arr->elements[idx]);
-                    } else if (std::holds_alternative<std::shared_ptr<Map>>(collection)) {
-                        auto map = std::get<std::shared_ptr<Map>>(collection);
-                        if (!std::holds_alternative<std::string>(index)) {
+                    } else if (collection.isMap()) {
+                        const auto& map = collection.asMap();
+                        if (!index.isString()) {
                             throw std::runtime_error("Map key must be a string.");
                         }
-                        const std::string& key = std::get<std::string>(index);
+                        const std::string& key = index.asString();
                         auto it = map->entries.find(key);
                         if (it == map->entries.end()) {
                             push(Nil{});
@@ -333,254 +679,355 @@ Value VM::run(const Chunk& entry, const std::vector<Value>& initialLocals,
                     } else {
                         throw std::runtime_error("Can only index arrays and maps.");
                     }
-                    break;
                 }
-                case OpCode::SET_INDEX: {
+                LOAD_STATE();
+                DISPATCH();
+            }
+            CASE(SET_INDEX) {
+                SAVE_STATE();
+                {
                     Value value = pop();
                     Value index = pop();
                     Value collection = pop();
 
-                    if (std::holds_alternative<std::shared_ptr<Array>>(collection)) {
-                        auto arr = std::get<std::shared_ptr<Array>>(collection);
-                        if (!std::holds_alternative<double>(index)) {
+                    if (collection.isArray()) {
+                        const auto& arr = collection.asArray();
+                        if (!index.isNumber()) {
                             throw std::runtime_error("Array index must be a number.");
                         }
-                        size_t idx = validateArrayIndex(std::get<double>(index));
+                        size_t idx = validateArrayIndex(index.asNumber());
                         if (idx >= arr->elements.size()) {
                             throw std::runtime_error("Array index out of bounds.");
                         }
                         arr->elements[idx] = value;
                         push(value);
-                    } else if (std::holds_alternative<std::shared_ptr<Map>>(collection)) {
-                        auto map = std::get<std::shared_ptr<Map>>(collection);
-                        if (!std::holds_alternative<std::string>(index)) {
+                    } else if (collection.isMap()) {
+                        const auto& map = collection.asMap();
+                        if (!index.isString()) {
                             throw std::runtime_error("Map key must be a string.");
                         }
-                        const std::string& key = std::get<std::string>(index);
+                        const std::string& key = index.asString();
                         map->entries[key] = value;
                         push(value);
                     } else {
                         throw std::runtime_error("Can only index arrays and maps.");
                     }
-                    break;
-                }
-                case OpCode::TRY: {
-                    // TRY opcode followed by:
-                    // - 2 bytes: offset to catch block (0 if no catch)
-                    // - 2 bytes: offset to finally block (0 if no finally)
-                    // - 1 byte: name index for catch variable (0 if no catch)
-                    uint16_t catchOffset = readShort();
-                    uint16_t finallyOffset = readShort();
-                    uint8_t catchVarIndex = readByte();
-
-                    ExceptionHandler handler;
-                    handler.frameIndex = frames.size() - 1;
-                    handler.stackSize = stack.size();
-
-                    // Calculate absolute instruction pointers
-                    if (catchOffset > 0) {
-                        handler.catchIp = currentFrame()->ip + catchOffset;
-                        handler.catchVariable = currentFrame()->chunk->names[catchVarIndex];
-                    } else {
-                        handler.catchIp = nullptr;
-                        handler.catchVariable = "";
-                    }
-
-                    if (finallyOffset > 0) {
-                        handler.finallyIp = currentFrame()->ip + finallyOffset;
-                    } else {
-                        handler.finallyIp = nullptr;
-                    }
-
-                    exceptionHandlers.push_back(handler);
-                    break;
-                }
-                case OpCode::THROW: {
-                    // Pop the exception value from stack and throw it
-                    Value exception = pop();
-                    throwException(exception);
-                    // If throwException returns, it means exception was handled
-                    // Continue execution will be at the catch/finally block
-                    break;
-                }
-                case OpCode::END_TRY: {
-                    // End of try-catch-finally block
-                    // Pop the exception handler from the stack
-                    if (!exceptionHandlers.empty()) {
-                        exceptionHandlers.pop_back();
-                    }
-                    break;
-                }
-                case OpCode::GET_PROPERTY: {
-                    uint8_t nameIndex = readByte();
-                    const std::string& propertyName = currentFrame()->chunk->names[nameIndex];
-                    Value object = pop();
-
-                    // Support Map property access (used by native modules)
-                    if (std::holds_alternative<std::shared_ptr<Map>>(object)) {
-                        auto map = std::get<std::shared_ptr<Map>>(object);
-                        auto it = map->entries.find(propertyName);
-                        if (it == map->entries.end()) {
-                            throw std::runtime_error("Undefined property '" + propertyName + "'.");
-                        }
-                        push(it->second);
-                        break;
-                    }
-
-                    if (!std::holds_alternative<std::shared_ptr<Instance>>(object)) {
-                        throw std::runtime_error("Only instances have properties.");
-                    }
-
-                    auto instance = std::get<std::shared_ptr<Instance>>(object);
-
-                    // Check if it's a field
-                    auto fieldIt = instance->fields.find(propertyName);
-                    if (fieldIt != instance->fields.end()) {
-                        push(fieldIt->second);
-                        break;
-                    }
-
-                    // Check if it's a method
-                    if (std::holds_alternative<std::shared_ptr<VmClass>>(instance->klass)) {
-                        auto klass = std::get<std::shared_ptr<VmClass>>(instance->klass);
-                        auto method = klass->getMethod(propertyName, instance);
-                        if (method) {
-                            push(method);
-                            break;
-                        }
-                    }
-
-                    throw std::runtime_error("Undefined property '" + propertyName + "'.");
                 }
-                case OpCode::SET_PROPERTY: {
-                    uint8_t nameIndex = readByte();
-                    const std::string& propertyName = currentFrame()->chunk->names[nameIndex];
-                    Value value = pop();
-                    Value object = pop();
+                LOAD_STATE();
+                DISPATCH();
+            }
+            CASE(THROW) {
+                // Pop the exception value from stack and throw it
+                --sp;
+                SAVE_STATE();
+                throwException(Value(std::move(*sp)), startingFrameCount);
+                // If throwException returns, it means exception was handled
+                // Continue execution will be at the catch/finally block
+                LOAD_STATE();
+                DISPATCH();
+            }
+            CASE(GET_PROPERTY) {
+                uint8_t nameIndex = READ_BYTE();
+                PropertyCache& cache = frame->chunk->propertyCaches[nameIndex];
+                Value& object = sp[-1];
 
-                    // Support Map property assignment
-                    if (std::holds_alternative<std::shared_ptr<Map>>(object)) {
-                        auto map = std::get<std::shared_ptr<Map>>(object);
-                        map->entries[propertyName] = value;
-                        push(value);
-                        break;
+                // Inline cache hit: a shape (or map) compare and a load
+                if (object.isInstance()) {
+                    Instance& instance = *object.asInstance();
+                    const PropertyCacheEntry* entry = cache.findShape(instance.shape.get());
+                    if (entry && entry->kind == PropertyCacheEntry::Kind::Field) {
+                        object = Value(instance.slots[entry->slot]);
+                        DISPATCH();
                     }
-
-                    if (!std::holds_alternative<std::shared_ptr<Instance>>(object)) {
-                        throw std::runtime_error("Only instances have properties.");
+                } else if (object.isMap()) {
+                    if (const PropertyCacheEntry* entry = cache.findMap(*object.asMap())) {
+                        object = Value(*entry->mapValue);
+                        DISPATCH();
                     }
-
-                    auto instance = std::get<std::shared_ptr<Instance>>(object);
-                    instance->fields[propertyName] = value;
-                    push(value);  // Assignment expression returns the value
-                    break;
                 }
-                // ... handle other opcodes ...
-                case OpCode::INHERIT: {
-                    // Compiler pushes subclass first, then superclass (superclass is on top of stack)
-                    // Stack layout: [..., subclass, superclass(top)]
+                SAVE_STATE();
+                object = getProperty(cache, object, frame->chunk->names[nameIndex]);
+                DISPATCH();
+            }
+            CASE(SET_PROPERTY) {
+                uint8_t nameIndex = READ_BYTE();
+                SAVE_STATE();
+                const Chunk* chunk = frame->chunk;
+                Value value = std::move(*--sp);
+                Value& object = sp[-1];
+                stack.setTop(sp);
+                setProperty(chunk->propertyCaches[nameIndex], object, chunk->names[nameIndex], value);
+                object = std::move(value);  // Assignment expression returns the value
+                DISPATCH();
+            }
+            CASE(INHERIT) {
+                // Compiler pushes subclass first, then superclass (superclass is on top of stack)
+                // Stack layout: [..., subclass, superclass(top)]
+                SAVE_STATE();
+                {
                     Value superclassVal = pop();   // top of stack = superclass
                     Value subclassVal = stack.back();  // peek = subclass (kept on stack)
 
-                    if (!std::holds_alternative<std::shared_ptr<VmClass>>(superclassVal)) {
+                    if (!superclassVal.isVmClass()) {
                         throw std::runtime_error("Superclass must be a class.");
                     }
-                    if (!std::holds_alternative<std::shared_ptr<VmClass>>(subclassVal)) {
+                    if (!subclassVal.isVmClass()) {
                         throw std::runtime_error("INHERIT requires a class on the stack.");
                     }
 
-                    auto superClass = std::get<std::shared_ptr<VmClass>>(superclassVal);
-                    auto subClass = std::get<std::shared_ptr<VmClass>>(subclassVal);
-                    subClass->superclass = superClass;
-                    break;
+                    auto superClass = superclassVal.asVmClass();
+                    auto subClass = subclassVal.asVmClass();
+                    subClass->setSuperclass(superClass);
                 }
-                case OpCode::GET_SUPER_METHOD: {
-                    // Compiler pushes superclass first, then 'this' (instance is on top of stack)
-                    // Stack layout: [..., superclass, instance(top)]
-                    // Followed by: method name index
-                    uint8_t methodIndex = readByte();
-                    const std::string& methodName = currentFrame()->chunk->names[methodIndex];
+                LOAD_STATE();
+                DISPATCH();
+            }
+            CASE(GET_SUPER_METHOD) {
+                // Compiler pushes 'this'; the superclass is the one the running
+                // function captured when its class was created
+                // Stack layout: [..., instance(top)]
+                // Followed by: method name index
+                uint8_t methodIndex = READ_BYTE();
+                SAVE_STATE();
+                {
+                    const std::string& methodName = frame->chunk->names[methodIndex];
 
-                    Value instanceVal = pop();   // top of stack = 'this' instance
-                    Value superclassVal = pop();  // next = superclass
+                    Value instanceVal = pop();  // top of stack = 'this' instance
+                    VmClass* superClass = frame->function ? frame->function->superclass().get() : nullptr;
 
-                    if (!std::holds_alternative<std::shared_ptr<VmClass>>(superclassVal)) {
+                    if (!superClass) {
                         throw std::runtime_error("'super' must refer to a class.");
                     }
-                    if (!std::holds_alternative<std::shared_ptr<Instance>>(instanceVal)) {
+                    if (!instanceVal.isInstance()) {
                         throw std::runtime_error("Cannot use 'super' outside of a class method.");
                     }
 
-                    auto superClass = std::get<std::shared_ptr<VmClass>>(superclassVal);
-                    auto instance = std::get<std::shared_ptr<Instance>>(instanceVal);
+                    auto instance = instanceVal.asInstance();
 
                     auto method = superClass->getMethod(methodName, instance);
                     if (!method) {
                         throw std::runtime_error("Undefined method '" + methodName + "' in superclass.");
                     }
-                    push(std::static_pointer_cast<VmCallable>(method));
-                    break;
+                    push(staticRefCast<VmCallable>(method));
                 }
-                case OpCode::LOAD_MODULE: {
-                    uint8_t nameIndex = readByte();
-                    const std::string& moduleName = currentFrame()->chunk->names[nameIndex];
-                    push(getVmNativeModule(moduleName, *this));
-                    break;
-                }
-                case OpCode::BUILD_ARRAY: {
-                    uint8_t count = readByte();
-                    auto arr = std::make_shared<Array>();
+                LOAD_STATE();
+                DISPATCH();
+            }
+            CASE(LOAD_MODULE) {
+                uint8_t nameIndex = READ_BYTE();
+                SAVE_STATE();
+                push(getVmNativeModule(frame->chunk->names[nameIndex], *this));
+                LOAD_STATE();
+                DISPATCH();
+            }
+            CASE(BUILD_ARRAY) {
+                uint8_t count = READ_BYTE();
+                SAVE_STATE();
+                {
+                    auto arr = makeRef<Array>();
                     arr->elements.resize(count);
                     for (int i = count - 1; i >= 0; --i) {
                         arr->elements[static_cast<size_t>(i)] = pop();
                     }
-                    push(arr);
-                    break;
+                    push(std::move(arr));
                 }
-                case OpCode::BUILD_MAP: {
-                    uint8_t count = readByte();
-                    auto map = std::make_shared<Map>();
+                LOAD_STATE();
+                DISPATCH();
+            }
+            CASE(BUILD_MAP) {
+                uint8_t count = READ_BYTE();
+                SAVE_STATE();
+                {
+                    auto map = makeRef<Map>();
                     // Entries were pushed in order (key then value); pop in LIFO order (value first, then key).
                     for (uint8_t i = 0; i < count; ++i) {
                         Value value = pop();
                         Value key = pop();
-                        if (!std::holds_alternative<std::string>(key)) {
+                        if (!key.isString()) {
                             throw std::runtime_error("Map key must be a string.");
                         }
-                        map->entries[std::get<std::string>(key)] = std::move(value);
+                        map->entries[key.asString()] = std::move(value);
                     }
-                    push(map);
-                    break;
+                    push(std::move(map));
                 }
-                case OpCode::JUMP_IF_NOT_NIL: {
-                    uint16_t offset = readShort();
-                    // Peek at the top of stack; if NOT nil, jump (keep value on stack).
-                    // If nil, fall through (also keep value on stack — caller must POP).
-                    if (!std::holds_alternative<Nil>(stack.back())) {
-                        currentFrame()->ip += offset;
+                LOAD_STATE();
+                DISPATCH();
+            }
+            CASE(JUMP_IF_NOT_NIL) {
+                uint16_t offset = READ_SHORT();
+                // Peek at the top of stack; if NOT nil, jump (keep value on stack).
+                // If nil, fall through (also keep value on stack — caller must POP).
+                if (!sp[-1].isNil()) {
+                    ip += offset;
+                }
+                DISPATCH();
+            }
+            CASE(GET_LOCAL_0) {
+                PUSH(slots[0]);
+                DISPATCH();
+            }
+            CASE(GET_LOCAL_1) {
+                PUSH(slots[1]);
+                DISPATCH();
+            }
+            CASE(GET_LOCAL_2) {
+                PUSH(slots[2]);
+                DISPATCH();
+            }
+            CASE(GET_LOCAL_3) {
+                PUSH(slots[3]);
+                DISPATCH();
+            }
+            CASE(GET_LOCAL_PROPERTY) {
+                uint8_t slot = READ_BYTE();
+                uint8_t nameIndex = READ_BYTE();
+                PropertyCache& cache = frame->chunk->propertyCaches[nameIndex];
+                const Value& object = slots[slot];
+
+                if (object.isInstance()) {
+                    Instance& instance = *object.asInstance();
+                    const PropertyCacheEntry* entry = cache.findShape(instance.shape.get());
+                    if (entry && entry->kind == PropertyCacheEntry::Kind::Field) {
+                        PUSH(instance.slots[entry->slot]);
+                        DISPATCH();
+                    }
+                } else if (object.isMap()) {
+                    if (const PropertyCacheEntry* entry = cache.findMap(*object.asMap())) {
+                        PUSH(*entry->mapValue);
+                        DISPATCH();
+                    }
+                }
+                SAVE_STATE();
+                Value property = getProperty(cache, object, frame->chunk->names[nameIndex]);
+                PUSH(std::move(property));
+                DISPATCH();
+            }
+            CASE(ADD_CONST) {
+                Value& a = sp[-1];
+                const Value& b = constants[READ_BYTE()];
+                if (a.isNumber() && b.isNumber()) {
+                    a = Value(a.asNumber() + b.asNumber());
+                } else if (a.isString() && b.isString()) {
+                    a = Value(a.asString() + b.asString());
+                } else {
+                    SAVE_STATE();
+                    throwExpectedNumber();
+                }
+                DISPATCH();
+            }
+            CASE(SET_GLOBAL_POP) {
+                uint32_t slot = frame->chunk->globalSlots[READ_BYTE()];
+                globalValues[slot] = std::move(*--sp);  // Leaves nil in the popped slot
+                globalDefined[slot] = 1;
+                DISPATCH();
+            }
+            CASE(POP_JUMP_IF_FALSE) {
+                uint16_t offset = READ_SHORT();
+                bool truthy = isTruthy(sp[-1]);
+                *--sp = Value();
+                if (!truthy) {
+                    ip += offset;
+                }
+                DISPATCH();
+            }
+            CASE(LESS_CONST_JUMP) {
+                // Jumps when the value on top is NOT less than the constant
+                const Value& limit = constants[READ_BYTE()];
+                uint16_t offset = READ_SHORT();
+                if (!sp[-1].isNumber() || !limit.isNumber()) {
+                    SAVE_STATE();
+                    throwExpectedNumber();
+                }
+                bool less = sp[-1].asNumber() < limit.asNumber();
+                --sp;
+                if (!less) {
+                    ip += offset;
+                }
+                DISPATCH();
+            }
+            CASE(ADD_NUM) {
+                if (!sp[-2].isNumber() || !sp[-1].isNumber()) [[unlikely]] DEQUICKEN(ADD)
+                --sp;
+                sp[-1].replaceInline(sp[-1].numberUnchecked() + sp[0].numberUnchecked());
+                DISPATCH();
+            }
+            CASE(LESS_NUM) {
+                if (!sp[-2].isNumber() || !sp[-1].isNumber()) [[unlikely]] DEQUICKEN(LESS)
+                --sp;
+                sp[-1].replaceInline(sp[-1].numberUnchecked() < sp[0].numberUnchecked());
+                DISPATCH();
+            }
+            CASE(INDEX_ARRAY_NUM) {
+                if (!sp[-2].isArray() || !sp[-1].isNumber()) [[unlikely]] DEQUICKEN(INDEX)
+                const auto& elements = sp[-2].asArray()->elements;
+                double index = sp[-1].numberUnchecked();
+                // In range and whole: the common case needs no further checks
+                if (!(index >= 0 && index < static_cast<double>(elements.size())) || index != std::trunc(index))
+                    [[unlikely]] {
+                    SAVE_STATE();
+                    size_t idx = validateArrayIndex(index);
+                    if (idx >= elements.size()) {
+                        throw std::runtime_error("Array index out of bounds.");
                     }
-                    break;
                 }
-                default:
-                    throw std::runtime_error("Unknown opcode encountered.");
+                Value element = elements[static_cast<size_t>(index)];
+                --sp;
+                sp[-1] = std::move(element);  // Releases the array only after the copy
+                DISPATCH();
             }
+#if IZI_VM_COMPUTED_GOTO
+        unknownOpcode:
+#else
+            default:
+#endif
+            SAVE_STATE();
+            throw std::runtime_error("Unknown opcode encountered.");
+#if !IZI_VM_COMPUTED_GOTO
+            }
+#endif
         } catch (const std::runtime_error& e) {
             // Convert C++ exception to IziLang exception and try to handle it
             Value exception = std::string(e.what());
 
             // Try to handle the exception through the exception handler stack
-            if (handleException(exception)) {
-                // Exception was handled, continue execution from catch/finally block
-                // The handleException already updated the IP
-                continue;  // Continue the while loop
-            } else {
-                // No handler found, report error and exit
-                std::cerr << "Uncaught Runtime Error: " << e.what() << '\n';
-                isRunning = wasRunning;
-                return Nil{};
+            if (handleException(exception, startingFrameCount)) {
+                // Exception was handled; the loop reloads the registers from
+                // the catch/finally frame that handleException selected
+                continue;
+            }
+
+            // No handler in this run(): unwind its frames.  A nested run()
+            // (a native calling back into script code) lets the error
+            // propagate to the caller's handlers; the outermost one reports it.
+            frames.resize(startingFrameCount);
+            if (Trace::enabled()) [[unlikely]] {
+                traceFrames();
+            }
+            closeUpvalues(startingStackSize);
+            stack.resize(startingStackSize);
+            isRunning = wasRunning;
+            if (wasRunning) {
+                throw;
             }
+            std::cerr << "Uncaught Runtime Error: " << e.what() << '\n';
+            uncaughtError = true;
+            return Nil{};
         }
     }
+
+#undef SAVE_STATE
+#undef LOAD_STATE
+#undef READ_BYTE
+#undef READ_SHORT
+#undef PUSH
+#undef NUMBER_OPERANDS
+#undef BINARY_NUMBER
+#undef QUICKEN
+#undef DEQUICKEN
+#undef SAFEPOINT
+#undef PROFILE_SAMPLE
+#undef CASE
+#undef DISPATCH
 }
 
 void VM::push(Value v) {
@@ -597,10 +1044,10 @@ Value VM::pop() {
 }
 
 double VM::asNumber(const Value& v) {
-    if (!std::holds_alternative<double>(v)) {
+    if (!v.isNumber()) {
         throw std::runtime_error("Expected number.");
     }
-    return std::get<double>(v);
+    return v.asNumber();
 }
 
 size_t VM::validateArrayIndex(double index) {
@@ -613,70 +1060,264 @@ size_t VM::validateArrayIndex(double index) {
     return static_cast<size_t>(index);
 }
 
-void VM::throwException(const Value& exception) {
-    // Try to handle the exception
-    if (!handleException(exception)) {
-        // No handler found, convert to C++ exception to be caught by outer catch block
-        std::string msg = "Uncaught exception: ";
-        if (std::holds_alternative<std::string>(exception)) {
-            msg += std::get<std::string>(exception);
-        } else if (std::holds_alternative<double>(exception)) {
-            msg += std::to_string(std::get<double>(exception));
-        } else if (std::holds_alternative<bool>(exception)) {
-            msg += std::get<bool>(exception) ? "true" : "false";
-        } else {
-            msg += "<value>";
+Value VM::getProperty(PropertyCache& cache, const Value& object, const std::string& name) {
+    // Support Map property access (used by native modules)
+    if (object.isMap()) {
+        const auto& map = object.asMap();
+        auto it = map->entries.find(name);
+        if (it == map->entries.end()) {
+            throw std::runtime_error("Undefined property '" + name + "'.");
+        }
+        PropertyCacheEntry& entry = cache.claim();
+        entry.kind = PropertyCacheEntry::Kind::MapEntry;
+        entry.map = map.get();
+        entry.mapId = mapCacheId(*map);
+        entry.slot = map->layoutVersion;
+        entry.mapValue = &it->second;
+        return it->second;
+    }
+
+    if (!object.isInstance()) {
+        throw std::runtime_error("Only instances have properties.");
+    }
+
+    const auto& instance = object.asInstance();
+
+    // Method previously resolved for this shape: a method used as a value
+    // is the only case that materializes a bound method.
+    if (PropertyCacheEntry* entry = cache.findShape(instance->shape.get())) {
+        if (entry->kind == PropertyCacheEntry::Kind::Method) {
+            return staticRefCast<VmCallable>(makeRef<VmBoundMethod>(instance, Ref<VmUserFunction>(entry->method)));
+        }
+    }
+
+    // Check if it's a field
+    int slot = instance->shape->slotOf(name);
+    if (slot >= 0) {
+        PropertyCacheEntry& entry = cache.claim();
+        entry.kind = PropertyCacheEntry::Kind::Field;
+        entry.shape = instance->shape;
+        entry.slot = static_cast<uint32_t>(slot);
+        return instance->slots[static_cast<size_t>(slot)];
+    }
+
+    // Check if it's a method.  Shapes of VM instances are rooted per class, so
+    // the lookup result can be cached against the shape.
+    if (std::holds_alternative<Ref<VmClass>>(instance->klass)) {
+        const auto& klass = std::get<Ref<VmClass>>(instance->klass);
+        if (VmUserFunction* method = klass->findMethod(name)) {
+            PropertyCacheEntry& entry = cache.claim();
+            entry.kind = PropertyCacheEntry::Kind::Method;
+            entry.shape = instance->shape;
+            entry.method = method;
+            return staticRefCast<VmCallable>(makeRef<VmBoundMethod>(instance, Ref<VmUserFunction>(method)));
         }
-        throw std::runtime_error(msg);
     }
+
+    throw std::runtime_error("Undefined property '" + name + "'.");
 }
 
-bool VM::handleException(const Value& exception) {
-    // Search for an exception handler in the current call frame
-    while (!exceptionHandlers.empty()) {
-        ExceptionHandler& handler = exceptionHandlers.back();
+void VM::setProperty(PropertyCache& cache, const Value& object, const std::string& name, const Value& value) {
+    // Support Map property assignment
+    if (object.isMap()) {
+        const auto& map = object.asMap();
+        if (PropertyCacheEntry* entry = cache.findMap(*map)) {
+            *entry->mapValue = value;
+            return;
+        }
+        Value& stored = map->entries[name];
+        stored = value;
+        PropertyCacheEntry& entry = cache.claim();
+        entry.kind = PropertyCacheEntry::Kind::MapEntry;
+        entry.map = map.get();
+        entry.mapId = mapCacheId(*map);
+        entry.slot = map->layoutVersion;
+        entry.mapValue = &stored;
+        return;
+    }
+
+    if (!object.isInstance()) {
+        throw std::runtime_error("Only instances have properties.");
+    }
 
-        // Check if handler is in current frame
-        if (handler.frameIndex != frames.size() - 1) {
-            // Handler is in a different frame, pop it
-            exceptionHandlers.pop_back();
-            continue;
+    Instance& instance = *object.asInstance();
+    if (const PropertyCacheEntry* entry = cache.findShape(instance.shape.get())) {
+        if (entry->kind == PropertyCacheEntry::Kind::Field) {
+            instance.slots[entry->slot] = value;
+            return;
+        }
+        if (entry->kind == PropertyCacheEntry::Kind::AddField) {
+            instance.shape = entry->transition;
+            instance.slots.push_back(value);
+            return;
         }
+    }
 
-        // Restore stack to the state when try block was entered
-        stack.resize(handler.stackSize);
+    PropertyCacheEntry& entry = cache.claim();
+    entry.shape = instance.shape;
+    int slot = instance.shape->slotOf(name);
+    if (slot >= 0) {
+        entry.kind = PropertyCacheEntry::Kind::Field;
+        entry.slot = static_cast<uint32_t>(slot);
+        instance.slots[static_cast<size_t>(slot)] = value;
+    } else {
+        entry.kind = PropertyCacheEntry::Kind::AddField;
+        entry.transition = instance.shape->withField(name);
+        entry.slot = static_cast<uint32_t>(instance.slots.size());
+        instance.shape = entry.transition;
+        instance.slots.push_back(value);
+    }
+}
 
-        // If there's a catch block, jump to it
-        if (handler.catchIp != nullptr) {
-            // Push exception value to stack
-            push(exception);
+void VM::pushFrame(VmUserFunction* function, size_t stackBase, size_t resultSlot, bool isConstructor) {
+    if (frames.size() >= MAX_CALL_FRAMES) {
+        throw std::runtime_error("Stack overflow: Maximum call depth of " + std::to_string(MAX_CALL_FRAMES) +
+                                 " exceeded.");
+    }
+    if (stack.size() >= STACK_MAX) {
+        throw std::runtime_error("Stack overflow: too many local variables in function call.");
+    }
+    const Chunk& chunk = function->getChunk();
+    if (chunk.linkedVm != id) {
+        link(chunk);
+    }
+    frames.push_back(CallFrame{&chunk, chunk.code.data(), stackBase, resultSlot, function, isConstructor});
+}
 
-            // Set the catch variable as a global
-            // NOTE: This is a simplification - ideally catch variables should be local to the catch block
-            // However, the current VM implementation uses globals for all variables accessed by name
-            globals[handler.catchVariable] = exception;
+void VM::pushMethodFrame(VmUserFunction* method, size_t receiverSlot, uint8_t argCount, bool isConstructor) {
+    if (argCount != method->arity()) {
+        throw std::runtime_error("Expected " + std::to_string(method->arity()) + " arguments but got " +
+                                 std::to_string(argCount) + ".");
+    }
+    pushFrame(method, receiverSlot, receiverSlot, isConstructor);
+}
 
-            // Jump to catch block
-            currentFrame()->ip = handler.catchIp;
+void VM::callValue(size_t calleeSlot, uint8_t argCount) {
+    const Value& callee = stack[calleeSlot];
 
-            // The END_TRY opcode will clean up the handler
-            return true;
+    // Instantiation: the new instance replaces the class in the callee slot
+    // and the constructor runs as a method frame over it.
+    if (callee.isVmClass()) {
+        auto klass = callee.asVmClass();
+        auto constructor = klass->findConstructor();
+        stack[calleeSlot] = klass->instantiate();
+        if (constructor) {
+            pushMethodFrame(constructor, calleeSlot, argCount, true);
+        } else if (argCount != 0) {
+            throw std::runtime_error("Expected 0 arguments but got " + std::to_string(argCount) + ".");
         }
+        return;
+    }
 
-        // If there's only a finally block (no catch), jump to it
-        // NOTE: In a full implementation, the exception should be re-thrown after finally executes
-        // For this initial implementation, we execute the finally block and consider the exception handled
-        if (handler.finallyIp != nullptr) {
-            // Jump to finally block
-            currentFrame()->ip = handler.finallyIp;
-            return true;
+    if (!callee.isVmCallable()) {
+        throw std::runtime_error("Can only call VM functions and classes.");
+    }
+    Ref<VmCallable> function = callee.asVmCallable();
+
+    // A bound method calls its method with the receiver in the callee slot
+    if (function->isBoundMethod()) {
+        auto& bound = static_cast<VmBoundMethod&>(*function);
+        stack[calleeSlot] = bound.instance;
+        pushMethodFrame(bound.method.get(), calleeSlot, argCount);
+        return;
+    }
+
+    int ar = function->arity();
+    if (ar >= 0 && argCount != ar) {
+        throw std::runtime_error("Expected " + std::to_string(function->arity()) + " arguments but got " +
+                                 std::to_string(argCount) + ".");
+    }
+
+    // Script functions run in this dispatch loop: the arguments
+    // already on the stack become the new frame's first locals.
+    if (function->isUserFunction()) {
+        pushFrame(static_cast<VmUserFunction*>(function.get()), calleeSlot + 1, calleeSlot);
+        return;
+    }
+
+    // Natives leave the loop.
+    std::vector<Value> args(stack.end() - argCount, stack.end());
+    stack.resize(calleeSlot);
+    Value result;
+    if (Trace::enabled()) [[unlikely]] {
+        TraceScope trace("native", function->name(), Trace::NATIVE_CALL_THRESHOLD_US);
+        result = function->call(*this, args);
+    } else {
+        result = function->call(*this, args);
+    }
+    push(std::move(result));
+}
+
+void VM::invoke(PropertyCache& cache, const std::string& name, size_t receiverSlot, uint8_t argCount) {
+    const Value& receiver = stack[receiverSlot];
+    if (receiver.isInstance()) {
+        const auto& instance = receiver.asInstance();
+
+        // A field holding a function shadows methods of the same name
+        if (const Value* field = instance->findField(name)) {
+            stack[receiverSlot] = Value(*field);
+            callValue(receiverSlot, argCount);
+            return;
         }
 
-        // No catch or finally, pop handler and continue searching
-        exceptionHandlers.pop_back();
+        if (std::holds_alternative<Ref<VmClass>>(instance->klass)) {
+            const auto& klass = std::get<Ref<VmClass>>(instance->klass);
+            if (VmUserFunction* method = klass->findMethod(name)) {
+                PropertyCacheEntry& entry = cache.claim();
+                entry.kind = PropertyCacheEntry::Kind::Method;
+                entry.shape = instance->shape;
+                entry.method = method;
+                pushMethodFrame(method, receiverSlot, argCount);
+                return;
+            }
+        }
+        throw std::runtime_error("Undefined property '" + name + "'.");
     }
 
-    // No handler found
+    // Maps (native modules) and everything else: load the property, then call it
+    stack[receiverSlot] = getProperty(cache, receiver, name);
+    callValue(receiverSlot, argCount);
+}
+
+void VM::throwException(const Value& exception, size_t baseFrame) {
+    // Try to handle the exception
+    if (!handleException(exception, baseFrame)) {
+        // No handler found, convert to C++ exception to be caught by outer catch block
+        std::string msg = "Uncaught exception: ";
+        if (exception.isString()) {
+            msg += exception.asString();
+        } else if (exception.isNumber()) {
+            msg += std::to_string(exception.asNumber());
+        } else if (exception.isBool()) {
+            msg += exception.asBool() ? "true" : "false";
+        } else {
+            msg += "<value>";
+        }
+        throw std::runtime_error(msg);
+    }
+}
+
+bool VM::handleException(const Value& exception, size_t baseFrame) {
+    // Walk the frames of this run() from the innermost outwards and look the
+    // faulting instruction up in each frame's exception table.  Frames below
+    // baseFrame belong to an outer run(), which searches them itself.
+    for (size_t frameIndex = frames.size(); frameIndex-- > baseFrame;) {
+        CallFrame& frame = frames[frameIndex];
+        // ip has moved past the opcode (and the call that raised, for callers)
+        size_t offset = static_cast<size_t>(frame.ip - frame.chunk->code.data()) - 1;
+        for (const ExceptionTableEntry& entry : frame.chunk->exceptionTable) {
+            if (offset < entry.start || offset >= entry.end) {
+                continue;
+            }
+            frames.resize(frameIndex + 1);
+            size_t handlerStack = frame.stackBase + entry.stackDepth;
+            closeUpvalues(handlerStack);
+            stack.resize(handlerStack);
+            push(exception);  // Becomes the handler's first local
+            frame.ip = frame.chunk->code.data() + entry.handler;
+            return true;
+        }
+    }
     return false;
 }
 
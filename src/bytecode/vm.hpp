@@ -2,90 +2,195 @@
 
 #include "common/value.hpp"
 #include "bytecode/chunk.hpp"
+#include "bytecode/jit.hpp"
 #include <vector>
 #include <array>
+#include <memory>
+#include <stdexcept>
 #include <unordered_map>
 #include <string>
 
 namespace izi {
 
 class VmUserFunction;
+struct Upvalue;
+class Profiler;
+class OpStats;
+
+constexpr size_t STACK_MAX = 16384;  // Maximum number of value slots across all frames
+constexpr size_t MAX_CALL_FRAMES = 1024;  // Maximum call depth for stack overflow protection
+
+// Fixed-capacity value stack.  Every slot is constructed up front and the
+// storage never moves, so the dispatch loop can keep the top in a local
+// pointer and hand it back with setTop().  Slots at or above the top never
+// hold heap references (popping a string or object resets the slot to nil).
+class ValueStack {
+   public:
+    // Headroom above STACK_MAX for the temporaries of the deepest frame
+    static constexpr size_t CAPACITY = STACK_MAX + 1024;
+
+    ValueStack() : slots_(new Value[CAPACITY]), top_(slots_.get()) {}
+
+    size_t size() const { return static_cast<size_t>(top_ - slots_.get()); }
+    bool empty() const { return top_ == slots_.get(); }
+
+    Value* begin() { return slots_.get(); }
+    Value* end() { return top_; }
+    Value* data() { return slots_.get(); }
+    Value* limit() { return slots_.get() + CAPACITY; }
+
+    Value& operator[](size_t index) { return slots_[index]; }
+    const Value& operator[](size_t index) const { return slots_[index]; }
+    Value& back() { return top_[-1]; }
+
+    void push_back(Value value) {
+        if (top_ == limit()) {
+            throw std::runtime_error("Stack overflow: too many values on the stack.");
+        }
+        *top_++ = std::move(value);
+    }
+    void pop_back() { *--top_ = Value(); }
+
+    void resize(size_t count) {
+        Value* target = slots_.get() + count;
+        while (top_ > target) {
+            *--top_ = Value();
+        }
+        top_ = target;
+    }
+    void clear() { resize(0); }
 
-constexpr size_t STACK_MAX = 256;
-constexpr size_t MAX_CALL_FRAMES = 256;  // Maximum call depth for stack overflow protection
+    Value* top() const { return top_; }
+    void setTop(Value* top) { top_ = top; }
+
+   private:
+    std::unique_ptr<Value[]> slots_;
+    Value* top_;
+};
 
 struct CallFrame {
     const Chunk* chunk;
     const uint8_t* ip;  // Instruction pointer
-    size_t stackBase;  // Start index in the VM stack for this call frame
-    std::shared_ptr<VmUserFunction> function;
-};
-
-// Exception handler for try-catch-finally blocks
-struct ExceptionHandler {
-    size_t frameIndex;  // Index of the call frame where this handler was set up
-    const uint8_t* catchIp;  // Instruction pointer to catch block (nullptr if no catch)
-    const uint8_t* finallyIp;  // Instruction pointer to finally block (nullptr if no finally)
-    size_t stackSize;  // Stack size when handler was set up
-    std::string catchVariable;  // Variable name to bind exception to in catch block
+    size_t stackBase;  // Start index in the VM stack for this call frame (slot of local 0)
+    size_t resultSlot;  // Stack height to restore on RETURN before pushing the result
+    VmUserFunction* function;  // Kept alive by the callee slot or by the caller of run()
+    bool isConstructor = false;  // RETURN yields local 0 (the new instance) instead of the returned value
 };
 
 class VM {
    public:
     VM();
 
-    Value run(const Chunk& chunk, const std::vector<Value>& initialLocals = {},
-              std::shared_ptr<VmUserFunction> function = nullptr);
+    Value run(const Chunk& chunk, const std::vector<Value>& initialLocals = {}, Ref<VmUserFunction> function = nullptr);
+
+    // The outermost run() reports an error no handler caught on stderr and
+    // returns nil; this tells the caller that it did, e.g. to exit non-zero.
+    bool hadUncaughtError() const { return uncaughtError; }
 
     void setGlobal(const std::string& name, const Value& value);
 
+    // Baseline JIT (bytecode/jit.hpp): compile a chunk to native code once it
+    // has seen `threshold` calls and loop back-edges.  Returns false when the
+    // platform is not supported.  Setting IZI_JIT=1 in the environment
+    // enables it in every VM, with IZI_JIT_THRESHOLD overriding the default.
+    bool enableJit(uint32_t threshold = JIT_DEFAULT_THRESHOLD);
+    void disableJit() { jit = false; }
+    bool isJitEnabled() const { return jit; }
+    // Run only the native code attached to chunks ahead of time (`izi
+    // compile`); chunks without it are interpreted and never compiled.
+    void enableAotCode() {
+        jit = true;
+        jitThreshold = UINT32_MAX;
+    }
+
+    // Sample the call stack into `profiler` whenever its timer ticks (`izi
+    // run --profile`).  The profiler must outlive the run; nullptr disables.
+    void setProfiler(Profiler* profiler) { this->profiler = profiler; }
+
+    // Count and time every dispatched instruction into `stats` (`izi run
+    // --opstats`).  Must outlive the run; nullptr disables.  Turns the JIT
+    // off, since instructions run by JIT code would not be counted.
+    void setOpStats(OpStats* stats) {
+        opStats = stats;
+        if (stats) {
+            jit = false;
+        }
+    }
+
     // Runtime safety limits
     size_t getCallDepth() const { return frames.size(); }
     size_t getStackSize() const { return stack.size(); }
 
-    // Get all global variables (for REPL :vars command)
-    const std::unordered_map<std::string, Value>& getGlobals() const { return globals; }
+    // Snapshot of all defined global variables (for REPL :vars command)
+    std::unordered_map<std::string, Value> getGlobals() const;
 
     // void push(Value value);
     // Value pop();
 
    private:
-    std::vector<Value> stack;
+    ValueStack stack;
     std::vector<CallFrame> frames;
-    std::unordered_map<std::string, Value> globals;
-    std::vector<ExceptionHandler> exceptionHandlers;  // Stack of exception handlers
+
+    // Globals live in dense slots indexed by GET_GLOBAL/SET_GLOBAL through the
+    // chunk's link table.  globalSlotIndex is the name -> slot side table used
+    // when linking a chunk and by name-based APIs (setGlobal, natives).
+    std::vector<Value> globalValues;
+    std::vector<uint8_t> globalDefined;
+    std::vector<std::string> globalNames;
+    std::unordered_map<std::string, uint32_t> globalSlotIndex;
+    uint64_t id;  // Unique per VM instance; identifies which VM a chunk is linked to
+    std::vector<Ref<Upvalue>> openUpvalues;  // Cells still pointing into the stack, sorted by slot
     bool isRunning = false;
+    bool uncaughtError = false;
+    bool jit = false;
+    uint32_t jitThreshold = JIT_DEFAULT_THRESHOLD;
+    Profiler* profiler = nullptr;
+    OpStats* opStats = nullptr;
+    size_t tracedFrames = 0;  // Frames with an open slice in the --trace-out timeline
+
+    friend struct JitRuntime;  // Runtime helpers of the generated code
+
+    // Count an entry into the chunk; its native code once hot, else nullptr
+    const JitCode* jitCodeFor(const Chunk& chunk);
+
+    // Record the frames (function and line of each) as one profiler sample
+    void sampleProfile();
+    // Close the timeline slices of frames that returned, open ones for new frames
+    void traceFrames();
 
     CallFrame* currentFrame();
 
-    uint8_t readByte();
-    uint16_t readShort();
+    // Find or allocate the slot for a global name
+    uint32_t globalSlot(const std::string& name);
+    // Resolve every name in the chunk to a global slot of this VM
+    void link(const Chunk& chunk);
+    const Value* findGlobal(const std::string& name) const;
+
+    // Return the open cell for a stack slot, creating it on first capture
+    Ref<Upvalue> captureUpvalue(size_t slot);
+    // Move every open cell at or above `fromSlot` off the stack
+    void closeUpvalues(size_t fromSlot);
 
     void push(Value v);
     Value pop();
 
-    // Exception handling helpers
-    void throwException(const Value& exception);
-    bool handleException(const Value& exception);
+    // Call helpers.  A method frame starts at the receiver, so 'this' is local 0.
+    void pushFrame(VmUserFunction* function, size_t stackBase, size_t resultSlot, bool isConstructor = false);
+    void pushMethodFrame(VmUserFunction* method, size_t receiverSlot, uint8_t argCount, bool isConstructor = false);
+    void callValue(size_t calleeSlot, uint8_t argCount);
+    void invoke(PropertyCache& cache, const std::string& name, size_t receiverSlot, uint8_t argCount);
 
-    static double asNumber(const Value& v);
-    static size_t validateArrayIndex(double index);
+    // Property access slow paths: resolve by name and refill the site's inline cache
+    Value getProperty(PropertyCache& cache, const Value& object, const std::string& name);
+    void setProperty(PropertyCache& cache, const Value& object, const std::string& name, const Value& value);
 
-    template <typename Fn>
-    void binaryNumeric(Fn fn) {
-        Value b = pop();
-        Value a = pop();
-        double result = fn(asNumber(a), asNumber(b));
-        push(result);
-    }
+    // Exception handling helpers.  `baseFrame` is the frame count at entry
+    // to the innermost run(); handlers below it belong to an outer run().
+    void throwException(const Value& exception, size_t baseFrame);
+    bool handleException(const Value& exception, size_t baseFrame);
 
-    template <typename Fn>
-    void binaryComparison(Fn fn) {
-        Value b = pop();
-        Value a = pop();
-        bool result = fn(asNumber(a), asNumber(b));
-        push(result);
-    }
+    static double asNumber(const Value& v);
+    static size_t validateArrayIndex(double index);
 };
 
 }  // namespace izi
\ No newline at end of file
@@ -5,96 +5,135 @@
 
 namespace izi {
 
+std::string VmBoundMethod::name() const {
+    return method->name();
+}
+
+int VmBoundMethod::arity() const {
+    return method->arity();
+}
+
 Value VmBoundMethod::call(VM& vm, const std::vector<Value>& arguments) {
-    // Set 'this' as a global variable before calling the method
-    // Note: This is a simplified implementation. Using a global variable means
-    // nested method calls or recursive methods will overwrite 'this', which could
-    // cause incorrect behavior. A proper implementation would use a call stack
-    // mechanism where 'this' is passed as a local variable or stored in call frames.
-    // For the current use cases (non-recursive, non-nested method calls), this works.
-    vm.setGlobal("this", instance);
-
-    // Set 'super' to the owning class's superclass so that super.method() works
-    if (ownerClass && ownerClass->superclass) {
-        vm.setGlobal("super", ownerClass->superclass);
-    }
+    // Methods take their receiver as local 0 ('this'), ahead of the arguments
+    std::vector<Value> locals;
+    locals.reserve(arguments.size() + 1);
+    locals.emplace_back(instance);
+    locals.insert(locals.end(), arguments.begin(), arguments.end());
+    return method->call(vm, locals);
+}
 
-    // Call the method
-    Value result = method->call(vm, arguments);
+void VmBoundMethod::traceRefs(GcTracer& tracer) const {
+    tracer.trace(instance);
+    tracer.trace(method);
+}
 
-    return result;
+void VmBoundMethod::clearRefs() {
+    instance.reset();
+    method.reset();
 }
 
 int VmClass::arity() const {
-    // Check if there's a constructor method
-    auto it = methods.find("constructor");
-    if (it != methods.end()) {
-        return it->second->arity();
-    }
-    // Check superclass constructor
-    if (superclass) {
-        return superclass->arity();
-    }
-    return 0;  // No constructor means no arguments
+    VmUserFunction* constructor = findConstructor();
+    return constructor ? constructor->arity() : 0;  // No constructor means no arguments
 }
 
-// Helper to recursively initialize fields from the entire inheritance chain
-static void initFieldsRecursive(const VmClass* klass, std::shared_ptr<Instance> instance) {
+// Helper to lay out the declared fields of the entire inheritance chain
+static void collectFieldsRecursive(const VmClass* klass, std::shared_ptr<Shape>& shape,
+                                   std::vector<Value>& defaults) {
     if (klass->superclass) {
-        initFieldsRecursive(klass->superclass.get(), instance);
+        collectFieldsRecursive(klass->superclass.get(), shape, defaults);
     }
     for (const auto& fieldName : klass->fieldNames) {
+        int slot = shape->slotOf(fieldName);
+        if (slot < 0) {
+            shape = shape->withField(fieldName);
+            slot = static_cast<int>(defaults.size());
+            defaults.emplace_back();
+        }
         auto it = klass->fieldDefaults.find(fieldName);
         if (it != klass->fieldDefaults.end()) {
-            instance->fields[fieldName] = it->second;
-        } else if (instance->fields.find(fieldName) == instance->fields.end()) {
-            instance->fields[fieldName] = Nil{};
+            defaults[static_cast<size_t>(slot)] = it->second;
         }
     }
 }
 
-Value VmClass::call(VM& vm, const std::vector<Value>& arguments) {
-    // Create a new instance
-    auto instance = std::make_shared<Instance>(shared_from_this());
-
-    // Initialize fields from the entire inheritance chain
-    initFieldsRecursive(this, instance);
-
-    // If there's a constructor, call it with 'this' bound
-    auto constructorIt = methods.find("constructor");
-    if (constructorIt != methods.end()) {
-        auto boundMethod = std::make_shared<VmBoundMethod>(instance, constructorIt->second, shared_from_this());
-        boundMethod->call(vm, arguments);
-    } else if (superclass) {
-        // Inherit constructor from superclass chain: find and call it with 'this' bound
-        std::shared_ptr<VmClass> ownerKlass = superclass;
-        while (ownerKlass) {
-            auto superConstructorIt = ownerKlass->methods.find("constructor");
-            if (superConstructorIt != ownerKlass->methods.end()) {
-                auto boundMethod = std::make_shared<VmBoundMethod>(instance, superConstructorIt->second, ownerKlass);
-                boundMethod->call(vm, arguments);
-                break;
-            }
-            ownerKlass = ownerKlass->superclass;
+const std::shared_ptr<Shape>& VmClass::instanceShape() {
+    if (!instanceShape_) {
+        // Each class gets its own root so that a shape also identifies the class,
+        // which lets property caches remember method lookups per shape.
+        auto shape = std::make_shared<Shape>();
+        slotDefaults_.clear();
+        collectFieldsRecursive(this, shape, slotDefaults_);
+        instanceShape_ = std::move(shape);
+    }
+    return instanceShape_;
+}
+
+void VmClass::setSuperclass(Ref<VmClass> super) {
+    // Re-running a class statement re-links the same superclass; keep the shape then
+    if (superclass != super) {
+        superclass = std::move(super);
+        instanceShape_.reset();
+    }
+    // `super` in the methods stays bound to this class, whatever its name is
+    // assigned later
+    for (const auto& [name, method] : methods) {
+        if (method->isUserFunction()) {
+            static_cast<VmUserFunction&>(*method).setSuperclass(superclass);
         }
     }
+}
+
+Value VmClass::instantiate() {
+    const auto& shape = instanceShape();
+    return makeRef<Instance>(Ref<VmClass>(this), shape, slotDefaults_);
+}
 
+Value VmClass::call(VM& vm, const std::vector<Value>& arguments) {
+    // Entry point for natives constructing instances; OpCode::CALL instantiates inline.
+    Value instance = instantiate();
+    if (VmUserFunction* constructor = findConstructor()) {
+        VmBoundMethod(instance.asInstance(), Ref<VmUserFunction>(constructor)).call(vm, arguments);
+    }
     return instance;
 }
 
-std::shared_ptr<VmCallable> VmClass::getMethod(const std::string& name, std::shared_ptr<Instance> instance) {
-    auto it = methods.find(name);
-    if (it != methods.end()) {
-        // Bind the method to the instance, passing this class as owner for 'super' resolution
-        return std::make_shared<VmBoundMethod>(instance, it->second, shared_from_this());
+VmUserFunction* VmClass::findMethod(const std::string& name) const {
+    for (const VmClass* klass = this; klass != nullptr; klass = klass->superclass.get()) {
+        auto it = klass->methods.find(name);
+        if (it != klass->methods.end() && it->second->isUserFunction()) {
+            return static_cast<VmUserFunction*>(it->second.get());
+        }
     }
+    return nullptr;
+}
+
+VmUserFunction* VmClass::findConstructor() const {
+    VmUserFunction* constructor = findMethod("init");
+    return constructor ? constructor : findMethod("constructor");
+}
 
-    // Search superclass chain
-    if (superclass) {
-        return superclass->getMethod(name, instance);
+Ref<VmCallable> VmClass::getMethod(const std::string& name, Ref<Instance> instance) {
+    VmUserFunction* method = findMethod(name);
+    if (!method) {
+        return nullptr;
     }
+    return makeRef<VmBoundMethod>(std::move(instance), Ref<VmUserFunction>(method));
+}
 
-    return nullptr;
+void VmClass::traceRefs(GcTracer& tracer) const {
+    tracer.trace(superclass);
+    for (const auto& [name, method] : methods) tracer.trace(method);
+    for (const auto& [name, value] : fieldDefaults) tracer.trace(value);
+    for (const Value& value : slotDefaults_) tracer.trace(value);
+}
+
+void VmClass::clearRefs() {
+    superclass.reset();
+    methods.clear();
+    fieldDefaults.clear();
+    slotDefaults_.clear();
+    instanceShape_.reset();
 }
 
 }  // namespace izi
@@ -2,6 +2,7 @@
 
 #include "mv_callable.hpp"
 #include "chunk.hpp"
+#include "common/shape.hpp"
 #include "common/value.hpp"
 #include <memory>
 #include <string>
@@ -17,36 +18,41 @@ class VmClass;
 // Note: Instance is already defined in common/value.hpp via izi_class.hpp
 // We'll use the same Instance struct for both interpreter and VM
 
-// Binds a method to an instance in the VM
-class VmBoundMethod : public VmCallable {
+class VmUserFunction;
+
+// A method taken as a value (`var f = obj.method;`).  Direct calls use INVOKE
+// and never create one.
+class VmBoundMethod : public VmCallable, public GcObject {
    public:
-    std::shared_ptr<Instance> instance;
-    std::shared_ptr<VmCallable> method;
-    std::shared_ptr<VmClass> ownerClass;  // The class that owns the method (for 'super' resolution)
+    Ref<Instance> instance;
+    Ref<VmUserFunction> method;
 
-    VmBoundMethod(std::shared_ptr<Instance> inst, std::shared_ptr<VmCallable> meth,
-                  std::shared_ptr<VmClass> owner = nullptr)
-        : instance(std::move(inst)), method(std::move(meth)), ownerClass(std::move(owner)) {}
+    VmBoundMethod(Ref<Instance> inst, Ref<VmUserFunction> meth)
+        : instance(std::move(inst)), method(std::move(meth)) {}
 
-    std::string name() const override { return method->name(); }
+    std::string name() const override;
 
-    int arity() const override { return method->arity(); }
+    int arity() const override;
 
     Value call(VM& vm, const std::vector<Value>& arguments) override;
+    bool isBoundMethod() const override { return true; }
+
+    void traceRefs(GcTracer& tracer) const override;
+    void clearRefs() override;
 };
 
 // Represents a class definition in the VM (callable to construct instances)
-class VmClass : public VmCallable, public std::enable_shared_from_this<VmClass> {
+class VmClass : public VmCallable, public GcObject {
    public:
     std::string className;
-    std::shared_ptr<VmClass> superclass;  // Parent class for inheritance (nullptr if none)
-    std::unordered_map<std::string, std::shared_ptr<VmCallable>> methods;
+    Ref<VmClass> superclass;  // Parent class for inheritance (nullptr if none)
+    std::unordered_map<std::string, Ref<VmCallable>> methods;
     std::vector<std::string> fieldNames;
     std::unordered_map<std::string, Value> fieldDefaults;
 
-    VmClass(std::string name, std::shared_ptr<VmClass> super, std::vector<std::string> fields,
+    VmClass(std::string name, Ref<VmClass> super, std::vector<std::string> fields,
             std::unordered_map<std::string, Value> defaults,
-            std::unordered_map<std::string, std::shared_ptr<VmCallable>> meths)
+            std::unordered_map<std::string, Ref<VmCallable>> meths)
         : className(std::move(name)),
           superclass(std::move(super)),
           methods(std::move(meths)),
@@ -59,7 +65,29 @@ class VmClass : public VmCallable, public std::enable_shared_from_this<VmClass>
 
     Value call(VM& vm, const std::vector<Value>& arguments) override;
 
-    std::shared_ptr<VmCallable> getMethod(const std::string& name, std::shared_ptr<Instance> instance);
+    Ref<VmCallable> getMethod(const std::string& name, Ref<Instance> instance);
+
+    // Find a method along the superclass chain without binding it
+    VmUserFunction* findMethod(const std::string& name) const;
+    // `init`, falling back to `constructor` (same precedence as the interpreter)
+    VmUserFunction* findConstructor() const;
+
+    // Allocate an instance with declared fields at their defaults (no constructor call)
+    Value instantiate();
+
+    // Root shape of new instances: every declared field of the inheritance
+    // chain, superclass fields first, with `slotDefaults` as initial values.
+    // Built on first instantiation; reset when the superclass changes.
+    const std::shared_ptr<Shape>& instanceShape();
+    // Link the superclass and bind `super` in this class's methods to it
+    void setSuperclass(Ref<VmClass> super);
+
+    void traceRefs(GcTracer& tracer) const override;
+    void clearRefs() override;
+
+   private:
+    std::shared_ptr<Shape> instanceShape_;
+    std::vector<Value> slotDefaults_;
 };
 
 }  // namespace izi
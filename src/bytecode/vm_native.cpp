@@ -42,17 +42,17 @@ Value vmNativeLen(VM& vm, const std::vector<Value>& arguments) {
         throw std::runtime_error("len() takes exactly one argument.");
     }
     const Value& arg = arguments[0];
-    if (std::holds_alternative<std::shared_ptr<Array>>(arg)) {
-        auto arr = std::get<std::shared_ptr<Array>>(arg);
+    if (arg.isArray()) {
+        auto arr = arg.asArray();
         return static_cast<double>(arr->elements.size());
-    } else if (std::holds_alternative<std::shared_ptr<Map>>(arg)) {
-        auto map = std::get<std::shared_ptr<Map>>(arg);
+    } else if (arg.isMap()) {
+        auto map = arg.asMap();
         return static_cast<double>(map->entries.size());
-    } else if (std::holds_alternative<std::shared_ptr<Set>>(arg)) {
-        auto set = std::get<std::shared_ptr<Set>>(arg);
+    } else if (arg.isSet()) {
+        auto set = arg.asSet();
         return static_cast<double>(set->values.size());
-    } else if (std::holds_alternative<std::string>(arg)) {
-        auto str = std::get<std::string>(arg);
+    } else if (arg.isString()) {
+        auto str = arg.asString();
         return static_cast<double>(str.size());
     }
     return Nil{};
@@ -71,10 +71,10 @@ Value vmNativePush(VM& vm, const std::vector<Value>& arguments) {
     }
     const Value& arrVal = arguments[0];
     const Value& elem = arguments[1];
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arrVal)) {
+    if (!arrVal.isArray()) {
         throw std::runtime_error("First argument to push() must be an array.");
     }
-    auto arr = std::get<std::shared_ptr<Array>>(arrVal);
+    auto arr = arrVal.asArray();
     arr->elements.push_back(elem);
     return arr;
 }
@@ -84,10 +84,10 @@ Value vmNativePop(VM& vm, const std::vector<Value>& arguments) {
         throw std::runtime_error("pop() takes exactly one argument.");
     }
     const Value& arrVal = arguments[0];
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arrVal)) {
+    if (!arrVal.isArray()) {
         throw std::runtime_error("Argument to pop() must be an array.");
     }
-    auto arr = std::get<std::shared_ptr<Array>>(arrVal);
+    auto arr = arrVal.asArray();
     if (arr->elements.empty()) {
         throw std::runtime_error("Cannot pop from an empty array.");
     }
@@ -101,10 +101,10 @@ Value vmNativeShift(VM& vm, const std::vector<Value>& arguments) {
         throw std::runtime_error("shift() takes exactly one argument.");
     }
     const Value& arrVal = arguments[0];
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arrVal)) {
+    if (!arrVal.isArray()) {
         throw std::runtime_error("Argument to shift() must be an array.");
     }
-    auto arr = std::get<std::shared_ptr<Array>>(arrVal);
+    auto arr = arrVal.asArray();
     if (arr->elements.empty()) {
         throw std::runtime_error("Cannot shift from an empty array.");
     }
@@ -119,10 +119,10 @@ Value vmNativeUnshift(VM& vm, const std::vector<Value>& arguments) {
     }
     const Value& arrVal = arguments[0];
     const Value& elem = arguments[1];
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arrVal)) {
+    if (!arrVal.isArray()) {
         throw std::runtime_error("First argument to unshift() must be an array.");
     }
-    auto arr = std::get<std::shared_ptr<Array>>(arrVal);
+    auto arr = arrVal.asArray();
     arr->elements.insert(arr->elements.begin(), elem);
     return arr;
 }
@@ -132,15 +132,15 @@ Value vmNativeSplice(VM& vm, const std::vector<Value>& arguments) {
         throw std::runtime_error("splice() takes 2 or 3 arguments.");
     }
     const Value& arrVal = arguments[0];
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arrVal)) {
+    if (!arrVal.isArray()) {
         throw std::runtime_error("First argument to splice() must be an array.");
     }
 
-    auto arr = std::get<std::shared_ptr<Array>>(arrVal);
+    auto arr = arrVal.asArray();
     size_t start = static_cast<size_t>(asNumber(arguments[1]));
 
     if (start >= arr->elements.size()) {
-        return std::make_shared<Array>();
+        return makeRef<Array>();
     }
 
     size_t deleteCount;
@@ -151,7 +151,7 @@ Value vmNativeSplice(VM& vm, const std::vector<Value>& arguments) {
     }
 
     // Create result array with removed elements
-    auto result = std::make_shared<Array>();
+    auto result = makeRef<Array>();
     size_t end = std::min(start + deleteCount, arr->elements.size());
 
     for (size_t i = start; i < end; ++i) {
@@ -169,11 +169,11 @@ Value vmNativeKeys(VM& vm, const std::vector<Value>& arguments) {
         throw std::runtime_error("keys() takes exactly one argument.");
     }
     const Value& mapVal = arguments[0];
-    if (!std::holds_alternative<std::shared_ptr<Map>>(mapVal)) {
+    if (!mapVal.isMap()) {
         throw std::runtime_error("Argument to keys() must be a map.");
     }
-    auto map = std::get<std::shared_ptr<Map>>(mapVal);
-    auto keysArray = std::make_shared<Array>();
+    auto map = mapVal.asMap();
+    auto keysArray = makeRef<Array>();
     for (const auto& [key, _] : map->entries) {
         keysArray->elements.push_back(key);
     }
@@ -185,11 +185,11 @@ Value vmNativeValues(VM& vm, const std::vector<Value>& arguments) {
         throw std::runtime_error("values() takes exactly one argument.");
     }
     const Value& mapVal = arguments[0];
-    if (!std::holds_alternative<std::shared_ptr<Map>>(mapVal)) {
+    if (!mapVal.isMap()) {
         throw std::runtime_error("Argument to values() must be a map.");
     }
-    auto map = std::get<std::shared_ptr<Map>>(mapVal);
-    auto valuesArray = std::make_shared<Array>();
+    auto map = mapVal.asMap();
+    auto valuesArray = makeRef<Array>();
     for (const auto& [_, value] : map->entries) {
         valuesArray->elements.push_back(value);
     }
@@ -202,14 +202,14 @@ Value vmNativeHasKey(VM& vm, const std::vector<Value>& arguments) {
     }
     const Value& mapVal = arguments[0];
     const Value& keyVal = arguments[1];
-    if (!std::holds_alternative<std::shared_ptr<Map>>(mapVal)) {
+    if (!mapVal.isMap()) {
         throw std::runtime_error("First argument to hasKey() must be a map.");
     }
-    if (!std::holds_alternative<std::string>(keyVal)) {
+    if (!keyVal.isString()) {
         throw std::runtime_error("Second argument to hasKey() must be a string.");
     }
-    auto map = std::get<std::shared_ptr<Map>>(mapVal);
-    std::string key = std::get<std::string>(keyVal);
+    auto map = mapVal.asMap();
+    std::string key = keyVal.asString();
     bool hasKey = (map->entries.find(key) != map->entries.end());
     return hasKey;
 }
@@ -225,17 +225,18 @@ Value vmNativeDelete(VM& vm, const std::vector<Value>& arguments) {
     }
     const Value& mapVal = arguments[0];
     const Value& keyVal = arguments[1];
-    if (!std::holds_alternative<std::shared_ptr<Map>>(mapVal)) {
+    if (!mapVal.isMap()) {
         throw std::runtime_error("First argument to delete() must be a map.");
     }
-    if (!std::holds_alternative<std::string>(keyVal)) {
+    if (!keyVal.isString()) {
         throw std::runtime_error("Second argument to delete() must be a string.");
     }
-    auto map = std::get<std::shared_ptr<Map>>(mapVal);
-    std::string key = std::get<std::string>(keyVal);
+    auto map = mapVal.asMap();
+    std::string key = keyVal.asString();
     bool existed = (map->entries.find(key) != map->entries.end());
     if (existed) {
         map->entries.erase(key);
+        ++map->layoutVersion;
     }
     return existed;
 }
@@ -245,13 +246,13 @@ Value vmNativeEntries(VM& vm, const std::vector<Value>& arguments) {
         throw std::runtime_error("entries() takes exactly one argument.");
     }
     const Value& mapVal = arguments[0];
-    if (!std::holds_alternative<std::shared_ptr<Map>>(mapVal)) {
+    if (!mapVal.isMap()) {
         throw std::runtime_error("Argument to entries() must be a map.");
     }
-    auto map = std::get<std::shared_ptr<Map>>(mapVal);
-    auto entriesArray = std::make_shared<Array>();
+    auto map = mapVal.asMap();
+    auto entriesArray = makeRef<Array>();
     for (const auto& [key, value] : map->entries) {
-        auto entry = std::make_shared<Array>();
+        auto entry = makeRef<Array>();
         entry->elements.push_back(key);
         entry->elements.push_back(value);
         entriesArray->elements.push_back(entry);
@@ -267,24 +268,24 @@ Value vmNativeSetAdd(VM& vm, const std::vector<Value>& arguments) {
     }
     const Value& setVal = arguments[0];
     const Value& valueVal = arguments[1];
-    if (!std::holds_alternative<std::shared_ptr<Set>>(setVal)) {
+    if (!setVal.isSet()) {
         throw std::runtime_error("First argument to setAdd() must be a set.");
     }
 
-    auto set = std::get<std::shared_ptr<Set>>(setVal);
+    auto set = setVal.asSet();
 
     // Convert value to string for key (using a simple serialization)
     std::string key;
-    if (std::holds_alternative<std::string>(valueVal)) {
-        key = std::get<std::string>(valueVal);
-    } else if (std::holds_alternative<double>(valueVal)) {
+    if (valueVal.isString()) {
+        key = valueVal.asString();
+    } else if (valueVal.isNumber()) {
         // Use stringstream for consistent number formatting
         std::ostringstream oss;
-        oss << std::fixed << std::setprecision(15) << std::get<double>(valueVal);
+        oss << std::fixed << std::setprecision(15) << valueVal.asNumber();
         key = oss.str();
-    } else if (std::holds_alternative<bool>(valueVal)) {
-        key = std::get<bool>(valueVal) ? "true" : "false";
-    } else if (std::holds_alternative<Nil>(valueVal)) {
+    } else if (valueVal.isBool()) {
+        key = valueVal.asBool() ? "true" : "false";
+    } else if (valueVal.isNil()) {
         key = "nil";
     } else {
         throw std::runtime_error("setAdd() only supports primitive types (string, number, boolean, nil), but got: " +
@@ -301,24 +302,24 @@ Value vmNativeSetHas(VM& vm, const std::vector<Value>& arguments) {
     }
     const Value& setVal = arguments[0];
     const Value& valueVal = arguments[1];
-    if (!std::holds_alternative<std::shared_ptr<Set>>(setVal)) {
+    if (!setVal.isSet()) {
         throw std::runtime_error("First argument to setHas() must be a set.");
     }
 
-    auto set = std::get<std::shared_ptr<Set>>(setVal);
+    auto set = setVal.asSet();
 
     // Convert value to string for key lookup
     std::string key;
-    if (std::holds_alternative<std::string>(valueVal)) {
-        key = std::get<std::string>(valueVal);
-    } else if (std::holds_alternative<double>(valueVal)) {
+    if (valueVal.isString()) {
+        key = valueVal.asString();
+    } else if (valueVal.isNumber()) {
         // Use stringstream for consistent number formatting
         std::ostringstream oss;
-        oss << std::fixed << std::setprecision(15) << std::get<double>(valueVal);
+        oss << std::fixed << std::setprecision(15) << valueVal.asNumber();
         key = oss.str();
-    } else if (std::holds_alternative<bool>(valueVal)) {
-        key = std::get<bool>(valueVal) ? "true" : "false";
-    } else if (std::holds_alternative<Nil>(valueVal)) {
+    } else if (valueVal.isBool()) {
+        key = valueVal.asBool() ? "true" : "false";
+    } else if (valueVal.isNil()) {
         key = "nil";
     } else {
         return false;
@@ -333,24 +334,24 @@ Value vmNativeSetDelete(VM& vm, const std::vector<Value>& arguments) {
     }
     const Value& setVal = arguments[0];
     const Value& valueVal = arguments[1];
-    if (!std::holds_alternative<std::shared_ptr<Set>>(setVal)) {
+    if (!setVal.isSet()) {
         throw std::runtime_error("First argument to setDelete() must be a set.");
     }
 
-    auto set = std::get<std::shared_ptr<Set>>(setVal);
+    auto set = setVal.asSet();
 
     // Convert value to string for key lookup
     std::string key;
-    if (std::holds_alternative<std::string>(valueVal)) {
-        key = std::get<std::string>(valueVal);
-    } else if (std::holds_alternative<double>(valueVal)) {
+    if (valueVal.isString()) {
+        key = valueVal.asString();
+    } else if (valueVal.isNumber()) {
         // Use stringstream for consistent number formatting
         std::ostringstream oss;
-        oss << std::fixed << std::setprecision(15) << std::get<double>(valueVal);
+        oss << std::fixed << std::setprecision(15) << valueVal.asNumber();
         key = oss.str();
-    } else if (std::holds_alternative<bool>(valueVal)) {
-        key = std::get<bool>(valueVal) ? "true" : "false";
-    } else if (std::holds_alternative<Nil>(valueVal)) {
+    } else if (valueVal.isBool()) {
+        key = valueVal.asBool() ? "true" : "false";
+    } else if (valueVal.isNil()) {
         key = "nil";
     } else {
         return false;
@@ -368,10 +369,10 @@ Value vmNativeSetSize(VM& vm, const std::vector<Value>& arguments) {
         throw std::runtime_error("setSize() takes exactly one argument.");
     }
     const Value& setVal = arguments[0];
-    if (!std::holds_alternative<std::shared_ptr<Set>>(setVal)) {
+    if (!setVal.isSet()) {
         throw std::runtime_error("Argument to setSize() must be a set.");
     }
-    auto set = std::get<std::shared_ptr<Set>>(setVal);
+    auto set = setVal.asSet();
     return static_cast<double>(set->values.size());
 }
 
@@ -379,7 +380,7 @@ Value vmNativeSet(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 0) {
         throw std::runtime_error("Set() takes no arguments.");
     }
-    return std::make_shared<Set>();
+    return makeRef<Set>();
 }
 
 // ============ std.math functions ============
@@ -570,10 +571,10 @@ Value vmNativeSubstring(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() < 2 || arguments.size() > 3) {
         throw std::runtime_error("substring() takes 2 or 3 arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("First argument to substring() must be a string.");
     }
-    std::string str = std::get<std::string>(arguments[0]);
+    std::string str = arguments[0].asString();
     size_t start = static_cast<size_t>(asNumber(arguments[1]));
     size_t length = (arguments.size() == 3) ? static_cast<size_t>(asNumber(arguments[2])) : str.length() - start;
 
@@ -587,13 +588,13 @@ Value vmNativeSplit(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 2) {
         throw std::runtime_error("split() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to split() must be strings.");
     }
-    std::string str = std::get<std::string>(arguments[0]);
-    std::string delim = std::get<std::string>(arguments[1]);
+    std::string str = arguments[0].asString();
+    std::string delim = arguments[1].asString();
 
-    auto result = std::make_shared<Array>();
+    auto result = makeRef<Array>();
     if (delim.empty()) {
         for (char c : str) {
             result->elements.push_back(std::string(1, c));
@@ -616,19 +617,19 @@ Value vmNativeJoin(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 2) {
         throw std::runtime_error("join() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arguments[0]) ||
-        !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isArray() ||
+        !arguments[1].isString()) {
         throw std::runtime_error("join() requires an array and a string separator.");
     }
-    auto arr = std::get<std::shared_ptr<Array>>(arguments[0]);
-    std::string sep = std::get<std::string>(arguments[1]);
+    auto arr = arguments[0].asArray();
+    std::string sep = arguments[1].asString();
 
     std::stringstream ss;
     for (size_t i = 0; i < arr->elements.size(); ++i) {
-        if (std::holds_alternative<std::string>(arr->elements[i])) {
-            ss << std::get<std::string>(arr->elements[i]);
-        } else if (std::holds_alternative<double>(arr->elements[i])) {
-            ss << std::get<double>(arr->elements[i]);
+        if (arr->elements[i].isString()) {
+            ss << arr->elements[i].asString();
+        } else if (arr->elements[i].isNumber()) {
+            ss << arr->elements[i].asNumber();
         }
         if (i + 1 < arr->elements.size()) {
             ss << sep;
@@ -641,10 +642,10 @@ Value vmNativeToUpper(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 1) {
         throw std::runtime_error("toUpper() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("Argument to toUpper() must be a string.");
     }
-    std::string str = std::get<std::string>(arguments[0]);
+    std::string str = arguments[0].asString();
     std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) { return std::toupper(c); });
     return str;
 }
@@ -653,10 +654,10 @@ Value vmNativeToLower(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 1) {
         throw std::runtime_error("toLower() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("Argument to toLower() must be a string.");
     }
-    std::string str = std::get<std::string>(arguments[0]);
+    std::string str = arguments[0].asString();
     std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) { return std::tolower(c); });
     return str;
 }
@@ -665,10 +666,10 @@ Value vmNativeTrim(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 1) {
         throw std::runtime_error("trim() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("Argument to trim() must be a string.");
     }
-    std::string str = std::get<std::string>(arguments[0]);
+    std::string str = arguments[0].asString();
 
     // Trim from start
     str.erase(str.begin(), std::find_if(str.begin(), str.end(), [](unsigned char ch) { return !std::isspace(ch); }));
@@ -684,13 +685,13 @@ Value vmNativeReplace(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 3) {
         throw std::runtime_error("replace() takes exactly three arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1]) ||
-        !std::holds_alternative<std::string>(arguments[2])) {
+    if (!arguments[0].isString() || !arguments[1].isString() ||
+        !arguments[2].isString()) {
         throw std::runtime_error("All arguments to replace() must be strings.");
     }
-    std::string str = std::get<std::string>(arguments[0]);
-    std::string from = std::get<std::string>(arguments[1]);
-    std::string to = std::get<std::string>(arguments[2]);
+    std::string str = arguments[0].asString();
+    std::string from = arguments[1].asString();
+    std::string to = arguments[2].asString();
 
     if (from.empty()) return str;
 
@@ -706,11 +707,11 @@ Value vmNativeStartsWith(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 2) {
         throw std::runtime_error("startsWith() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to startsWith() must be strings.");
     }
-    std::string str = std::get<std::string>(arguments[0]);
-    std::string prefix = std::get<std::string>(arguments[1]);
+    std::string str = arguments[0].asString();
+    std::string prefix = arguments[1].asString();
     return str.rfind(prefix, 0) == 0;
 }
 
@@ -718,11 +719,11 @@ Value vmNativeEndsWith(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 2) {
         throw std::runtime_error("endsWith() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to endsWith() must be strings.");
     }
-    std::string str = std::get<std::string>(arguments[0]);
-    std::string suffix = std::get<std::string>(arguments[1]);
+    std::string str = arguments[0].asString();
+    std::string suffix = arguments[1].asString();
     if (suffix.length() > str.length()) return false;
     return str.compare(str.length() - suffix.length(), suffix.length(), suffix) == 0;
 }
@@ -731,11 +732,11 @@ Value vmNativeIndexOf(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 2) {
         throw std::runtime_error("indexOf() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to indexOf() must be strings.");
     }
-    std::string str = std::get<std::string>(arguments[0]);
-    std::string substr = std::get<std::string>(arguments[1]);
+    std::string str = arguments[0].asString();
+    std::string substr = arguments[1].asString();
     size_t pos = str.find(substr);
     if (pos == std::string::npos) {
         return -1.0;
@@ -747,11 +748,11 @@ Value vmNativeContains(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 2) {
         throw std::runtime_error("contains() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to contains() must be strings.");
     }
-    const std::string& str = std::get<std::string>(arguments[0]);
-    const std::string& substr = std::get<std::string>(arguments[1]);
+    const std::string& str = arguments[0].asString();
+    const std::string& substr = arguments[1].asString();
     return str.find(substr) != std::string::npos;
 }
 
@@ -761,16 +762,16 @@ Value vmNativeMap(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 2) {
         throw std::runtime_error("map() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arguments[0])) {
+    if (!arguments[0].isArray()) {
         throw std::runtime_error("First argument to map() must be an array.");
     }
-    if (!std::holds_alternative<std::shared_ptr<VmCallable>>(arguments[1])) {
+    if (!arguments[1].isVmCallable()) {
         throw std::runtime_error("Second argument to map() must be a function.");
     }
 
-    auto arr = std::get<std::shared_ptr<Array>>(arguments[0]);
-    auto func = std::get<std::shared_ptr<VmCallable>>(arguments[1]);
-    auto result = std::make_shared<Array>();
+    auto arr = arguments[0].asArray();
+    auto func = arguments[1].asVmCallable();
+    auto result = makeRef<Array>();
 
     for (const auto& elem : arr->elements) {
         result->elements.push_back(func->call(vm, {elem}));
@@ -782,16 +783,16 @@ Value vmNativeFilter(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 2) {
         throw std::runtime_error("filter() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arguments[0])) {
+    if (!arguments[0].isArray()) {
         throw std::runtime_error("First argument to filter() must be an array.");
     }
-    if (!std::holds_alternative<std::shared_ptr<VmCallable>>(arguments[1])) {
+    if (!arguments[1].isVmCallable()) {
         throw std::runtime_error("Second argument to filter() must be a function.");
     }
 
-    auto arr = std::get<std::shared_ptr<Array>>(arguments[0]);
-    auto func = std::get<std::shared_ptr<VmCallable>>(arguments[1]);
-    auto result = std::make_shared<Array>();
+    auto arr = arguments[0].asArray();
+    auto func = arguments[1].asVmCallable();
+    auto result = makeRef<Array>();
 
     for (const auto& elem : arr->elements) {
         Value testResult = func->call(vm, {elem});
@@ -806,15 +807,15 @@ Value vmNativeReduce(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() < 2 || arguments.size() > 3) {
         throw std::runtime_error("reduce() takes 2 or 3 arguments.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arguments[0])) {
+    if (!arguments[0].isArray()) {
         throw std::runtime_error("First argument to reduce() must be an array.");
     }
-    if (!std::holds_alternative<std::shared_ptr<VmCallable>>(arguments[1])) {
+    if (!arguments[1].isVmCallable()) {
         throw std::runtime_error("Second argument to reduce() must be a function.");
     }
 
-    auto arr = std::get<std::shared_ptr<Array>>(arguments[0]);
-    auto func = std::get<std::shared_ptr<VmCallable>>(arguments[1]);
+    auto arr = arguments[0].asArray();
+    auto func = arguments[1].asVmCallable();
 
     if (arr->elements.empty()) {
         if (arguments.size() == 3) {
@@ -844,29 +845,29 @@ Value vmNativeSort(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() < 1 || arguments.size() > 2) {
         throw std::runtime_error("sort() takes 1 or 2 arguments.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arguments[0])) {
+    if (!arguments[0].isArray()) {
         throw std::runtime_error("Argument to sort() must be an array.");
     }
 
-    auto arr = std::get<std::shared_ptr<Array>>(arguments[0]);
-    auto result = std::make_shared<Array>(*arr);
+    auto arr = arguments[0].asArray();
+    auto result = makeRef<Array>(*arr);
 
     if (arguments.size() == 2) {
-        if (!std::holds_alternative<std::shared_ptr<VmCallable>>(arguments[1])) {
+        if (!arguments[1].isVmCallable()) {
             throw std::runtime_error("Second argument to sort() must be a function.");
         }
-        auto comparator = std::get<std::shared_ptr<VmCallable>>(arguments[1]);
+        auto comparator = arguments[1].asVmCallable();
         std::sort(result->elements.begin(), result->elements.end(), [&](const Value& a, const Value& b) {
             Value cmpResult = comparator->call(vm, {a, b});
             return asNumber(cmpResult) < 0;
         });
     } else {
         std::sort(result->elements.begin(), result->elements.end(), [](const Value& a, const Value& b) {
-            if (std::holds_alternative<double>(a) && std::holds_alternative<double>(b)) {
-                return std::get<double>(a) < std::get<double>(b);
+            if (a.isNumber() && b.isNumber()) {
+                return a.asNumber() < b.asNumber();
             }
-            if (std::holds_alternative<std::string>(a) && std::holds_alternative<std::string>(b)) {
-                return std::get<std::string>(a) < std::get<std::string>(b);
+            if (a.isString() && b.isString()) {
+                return a.asString() < b.asString();
             }
             return false;
         });
@@ -878,12 +879,12 @@ Value vmNativeReverse(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 1) {
         throw std::runtime_error("reverse() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arguments[0])) {
+    if (!arguments[0].isArray()) {
         throw std::runtime_error("Argument to reverse() must be an array.");
     }
 
-    auto arr = std::get<std::shared_ptr<Array>>(arguments[0]);
-    auto result = std::make_shared<Array>();
+    auto arr = arguments[0].asArray();
+    auto result = makeRef<Array>();
     result->elements.assign(arr->elements.rbegin(), arr->elements.rend());
     return result;
 }
@@ -892,14 +893,14 @@ Value vmNativeConcat(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 2) {
         throw std::runtime_error("concat() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arguments[0]) ||
-        !std::holds_alternative<std::shared_ptr<Array>>(arguments[1])) {
+    if (!arguments[0].isArray() ||
+        !arguments[1].isArray()) {
         throw std::runtime_error("Both arguments to concat() must be arrays.");
     }
 
-    auto arr1 = std::get<std::shared_ptr<Array>>(arguments[0]);
-    auto arr2 = std::get<std::shared_ptr<Array>>(arguments[1]);
-    auto result = std::make_shared<Array>();
+    auto arr1 = arguments[0].asArray();
+    auto arr2 = arguments[1].asArray();
+    auto result = makeRef<Array>();
 
     result->elements.insert(result->elements.end(), arr1->elements.begin(), arr1->elements.end());
     result->elements.insert(result->elements.end(), arr2->elements.begin(), arr2->elements.end());
@@ -910,15 +911,15 @@ Value vmNativeSlice(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() < 2 || arguments.size() > 3) {
         throw std::runtime_error("slice() takes 2 or 3 arguments.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arguments[0])) {
+    if (!arguments[0].isArray()) {
         throw std::runtime_error("First argument to slice() must be an array.");
     }
 
-    auto arr = std::get<std::shared_ptr<Array>>(arguments[0]);
+    auto arr = arguments[0].asArray();
     size_t start = static_cast<size_t>(asNumber(arguments[1]));
     size_t end = (arguments.size() == 3) ? static_cast<size_t>(asNumber(arguments[2])) : arr->elements.size();
 
-    auto result = std::make_shared<Array>();
+    auto result = makeRef<Array>();
     if (start >= arr->elements.size()) {
         return result;
     }
@@ -934,11 +935,11 @@ Value vmNativeReadFile(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 1) {
         throw std::runtime_error("readFile() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("Argument to readFile() must be a string.");
     }
 
-    std::string filename = std::get<std::string>(arguments[0]);
+    std::string filename = arguments[0].asString();
     std::ifstream file(filename);
     if (!file.is_open()) {
         throw std::runtime_error("Failed to open file: " + filename);
@@ -953,12 +954,12 @@ Value vmNativeWriteFile(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 2) {
         throw std::runtime_error("writeFile() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to writeFile() must be strings.");
     }
 
-    std::string filename = std::get<std::string>(arguments[0]);
-    std::string content = std::get<std::string>(arguments[1]);
+    std::string filename = arguments[0].asString();
+    std::string content = arguments[1].asString();
 
     std::ofstream file(filename);
     if (!file.is_open()) {
@@ -973,12 +974,12 @@ Value vmNativeAppendFile(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 2) {
         throw std::runtime_error("appendFile() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to appendFile() must be strings.");
     }
 
-    std::string filename = std::get<std::string>(arguments[0]);
-    std::string content = std::get<std::string>(arguments[1]);
+    std::string filename = arguments[0].asString();
+    std::string content = arguments[1].asString();
 
     std::ofstream file(filename, std::ios::app);
     if (!file.is_open()) {
@@ -993,11 +994,11 @@ Value vmNativeFileExists(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 1) {
         throw std::runtime_error("fileExists() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("Argument to fileExists() must be a string.");
     }
 
-    std::string filename = std::get<std::string>(arguments[0]);
+    std::string filename = arguments[0].asString();
     struct stat buffer;
     return (stat(filename.c_str(), &buffer) == 0);
 }
@@ -1052,11 +1053,11 @@ Value vmNativeTimeSleep(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 1) {
         throw std::runtime_error("time.sleep() takes exactly one argument.");
     }
-    if (!std::holds_alternative<double>(arguments[0])) {
+    if (!arguments[0].isNumber()) {
         throw std::runtime_error("Argument to time.sleep() must be a number (seconds).");
     }
 
-    double seconds = std::get<double>(arguments[0]);
+    double seconds = arguments[0].asNumber();
     if (seconds < 0) {
         throw std::runtime_error("time.sleep() argument must be non-negative.");
     }
@@ -1071,18 +1072,18 @@ Value vmNativeTimeFormat(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() < 1 || arguments.size() > 2) {
         throw std::runtime_error("time.format() takes 1 or 2 arguments.");
     }
-    if (!std::holds_alternative<double>(arguments[0])) {
+    if (!arguments[0].isNumber()) {
         throw std::runtime_error("First argument to time.format() must be a number (timestamp).");
     }
 
-    double timestamp = std::get<double>(arguments[0]);
+    double timestamp = arguments[0].asNumber();
     std::string format = "%Y-%m-%d %H:%M:%S";
 
     if (arguments.size() == 2) {
-        if (!std::holds_alternative<std::string>(arguments[1])) {
+        if (!arguments[1].isString()) {
             throw std::runtime_error("Second argument to time.format() must be a string (format).");
         }
-        format = std::get<std::string>(arguments[1]);
+        format = arguments[1].asString();
     }
 
     std::time_t time = static_cast<std::time_t>(timestamp);
@@ -1204,7 +1205,7 @@ static Value vmParseJsonArray(const std::string& str, size_t& pos) {
     }
     ++pos;
 
-    auto arr = std::make_shared<Array>();
+    auto arr = makeRef<Array>();
     vmSkipWhitespace(str, pos);
 
     if (pos < str.size() && str[pos] == ']') {
@@ -1241,7 +1242,7 @@ static Value vmParseJsonObject(const std::string& str, size_t& pos) {
     }
     ++pos;
 
-    auto map = std::make_shared<Map>();
+    auto map = makeRef<Map>();
     vmSkipWhitespace(str, pos);
 
     if (pos < str.size() && str[pos] == '}') {
@@ -1257,7 +1258,7 @@ static Value vmParseJsonObject(const std::string& str, size_t& pos) {
         }
 
         Value keyVal = vmParseJsonString(str, pos);
-        std::string key = std::get<std::string>(keyVal);
+        std::string key = keyVal.asString();
 
         vmSkipWhitespace(str, pos);
         if (pos >= str.size() || str[pos] != ':') {
@@ -1309,12 +1310,12 @@ static Value vmJsonValueFromString(const std::string& jsonStr, size_t& pos) {
 }
 
 static std::string vmValueToJson(const Value& value) {
-    if (std::holds_alternative<Nil>(value)) {
+    if (value.isNil()) {
         return "null";
-    } else if (std::holds_alternative<bool>(value)) {
-        return std::get<bool>(value) ? "true" : "false";
-    } else if (std::holds_alternative<double>(value)) {
-        double d = std::get<double>(value);
+    } else if (value.isBool()) {
+        return value.asBool() ? "true" : "false";
+    } else if (value.isNumber()) {
+        double d = value.asNumber();
         if (std::isnan(d) || std::isinf(d)) {
             return "null";
         }
@@ -1330,8 +1331,8 @@ static std::string vmValueToJson(const Value& value) {
             }
         }
         return str;
-    } else if (std::holds_alternative<std::string>(value)) {
-        std::string str = std::get<std::string>(value);
+    } else if (value.isString()) {
+        std::string str = value.asString();
         std::ostringstream oss;
         oss << '"';
         for (char c : str) {
@@ -1364,8 +1365,8 @@ static std::string vmValueToJson(const Value& value) {
         }
         oss << '"';
         return oss.str();
-    } else if (std::holds_alternative<std::shared_ptr<Array>>(value)) {
-        auto arr = std::get<std::shared_ptr<Array>>(value);
+    } else if (value.isArray()) {
+        auto arr = value.asArray();
         std::ostringstream oss;
         oss << '[';
         for (size_t i = 0; i < arr->elements.size(); ++i) {
@@ -1374,8 +1375,8 @@ static std::string vmValueToJson(const Value& value) {
         }
         oss << ']';
         return oss.str();
-    } else if (std::holds_alternative<std::shared_ptr<Map>>(value)) {
-        auto map = std::get<std::shared_ptr<Map>>(value);
+    } else if (value.isMap()) {
+        auto map = value.asMap();
         std::ostringstream oss;
         oss << '{';
         bool first = true;
@@ -1395,11 +1396,11 @@ Value vmNativeJsonParse(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 1) {
         throw std::runtime_error("json.parse() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("Argument to json.parse() must be a string.");
     }
 
-    std::string jsonStr = std::get<std::string>(arguments[0]);
+    std::string jsonStr = arguments[0].asString();
     size_t pos = 0;
 
     try {
@@ -1431,16 +1432,16 @@ Value vmNativeRegexMatch(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 2) {
         throw std::runtime_error("regex.match() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to regex.match() must be strings.");
     }
 
-    std::string text = std::get<std::string>(arguments[0]);
-    std::string pattern = std::get<std::string>(arguments[1]);
+    std::string text = arguments[0].asString();
+    std::string pattern = arguments[1].asString();
 
     try {
         std::regex re(pattern);
-        auto result = std::make_shared<Array>();
+        auto result = makeRef<Array>();
         auto searchStart = text.cbegin();
         std::smatch match;
         while (std::regex_search(searchStart, text.cend(), match, re)) {
@@ -1463,14 +1464,14 @@ Value vmNativeRegexReplace(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 3) {
         throw std::runtime_error("regex.replace() takes exactly three arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1]) ||
-        !std::holds_alternative<std::string>(arguments[2])) {
+    if (!arguments[0].isString() || !arguments[1].isString() ||
+        !arguments[2].isString()) {
         throw std::runtime_error("All arguments to regex.replace() must be strings.");
     }
 
-    std::string text = std::get<std::string>(arguments[0]);
-    std::string pattern = std::get<std::string>(arguments[1]);
-    std::string replacement = std::get<std::string>(arguments[2]);
+    std::string text = arguments[0].asString();
+    std::string pattern = arguments[1].asString();
+    std::string replacement = arguments[2].asString();
 
     try {
         std::regex re(pattern);
@@ -1484,12 +1485,12 @@ Value vmNativeRegexTest(VM& vm, const std::vector<Value>& arguments) {
     if (arguments.size() != 2) {
         throw std::runtime_error("regex.test() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to regex.test() must be strings.");
     }
 
-    std::string text = std::get<std::string>(arguments[0]);
-    std::string pattern = std::get<std::string>(arguments[1]);
+    std::string text = arguments[0].asString();
+    std::string pattern = arguments[1].asString();
 
     try {
         std::regex re(pattern);
@@ -1541,13 +1542,13 @@ static void vmIpcFreeHandle(int id) {
 }  // anonymous namespace
 
 Value vmNativeIpcCreatePipe(VM& /*vm*/, const std::vector<Value>& arguments) {
-    if (arguments.size() != 1 || !std::holds_alternative<std::string>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isString()) {
         throw std::runtime_error("ipc.createPipe() takes exactly one string argument (pipe name).");
     }
 #ifdef _WIN32
     throw std::runtime_error("ipc.createPipe() is not supported on Windows.");
 #else
-    const std::string& name = std::get<std::string>(arguments[0]);
+    const std::string& name = arguments[0].asString();
     std::string path = vmIpcPipePath(name);
     if (mkfifo(path.c_str(), 0600) != 0 && errno != EEXIST) {
         throw std::runtime_error("ipc.createPipe() failed to create pipe '" + name + "': " + strerror(errno));
@@ -1557,13 +1558,13 @@ Value vmNativeIpcCreatePipe(VM& /*vm*/, const std::vector<Value>& arguments) {
 }
 
 Value vmNativeIpcOpenRead(VM& /*vm*/, const std::vector<Value>& arguments) {
-    if (arguments.size() != 1 || !std::holds_alternative<std::string>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isString()) {
         throw std::runtime_error("ipc.openRead() takes exactly one string argument (pipe name).");
     }
 #ifdef _WIN32
     throw std::runtime_error("ipc.openRead() is not supported on Windows.");
 #else
-    const std::string& name = std::get<std::string>(arguments[0]);
+    const std::string& name = arguments[0].asString();
     std::string path = vmIpcPipePath(name);
     int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK);
     if (fd < 0) {
@@ -1577,13 +1578,13 @@ Value vmNativeIpcOpenRead(VM& /*vm*/, const std::vector<Value>& arguments) {
 }
 
 Value vmNativeIpcOpenWrite(VM& /*vm*/, const std::vector<Value>& arguments) {
-    if (arguments.size() != 1 || !std::holds_alternative<std::string>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isString()) {
         throw std::runtime_error("ipc.openWrite() takes exactly one string argument (pipe name).");
     }
 #ifdef _WIN32
     throw std::runtime_error("ipc.openWrite() is not supported on Windows.");
 #else
-    const std::string& name = std::get<std::string>(arguments[0]);
+    const std::string& name = arguments[0].asString();
     std::string path = vmIpcPipePath(name);
     int fd = open(path.c_str(), O_WRONLY | O_NONBLOCK);
     if (fd < 0) {
@@ -1599,15 +1600,15 @@ Value vmNativeIpcOpenWrite(VM& /*vm*/, const std::vector<Value>& arguments) {
 }
 
 Value vmNativeIpcSend(VM& /*vm*/, const std::vector<Value>& arguments) {
-    if (arguments.size() != 2 || !std::holds_alternative<double>(arguments[0]) ||
-        !std::holds_alternative<std::string>(arguments[1])) {
+    if (arguments.size() != 2 || !arguments[0].isNumber() ||
+        !arguments[1].isString()) {
         throw std::runtime_error("ipc.send() takes a handle (number) and a message (string).");
     }
 #ifdef _WIN32
     throw std::runtime_error("ipc.send() is not supported on Windows.");
 #else
-    int handle = static_cast<int>(std::get<double>(arguments[0]));
-    const std::string& message = std::get<std::string>(arguments[1]);
+    int handle = static_cast<int>(arguments[0].asNumber());
+    const std::string& message = arguments[1].asString();
     VmIpcHandle h = vmIpcGetHandle(handle);
     if (h.is_read) {
         throw std::runtime_error("ipc.send() called on a read-only handle.");
@@ -1631,13 +1632,13 @@ Value vmNativeIpcSend(VM& /*vm*/, const std::vector<Value>& arguments) {
 }
 
 Value vmNativeIpcRecv(VM& /*vm*/, const std::vector<Value>& arguments) {
-    if (arguments.size() != 1 || !std::holds_alternative<double>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isNumber()) {
         throw std::runtime_error("ipc.recv() takes exactly one handle (number) argument.");
     }
 #ifdef _WIN32
     throw std::runtime_error("ipc.recv() is not supported on Windows.");
 #else
-    int handle = static_cast<int>(std::get<double>(arguments[0]));
+    int handle = static_cast<int>(arguments[0].asNumber());
     VmIpcHandle h = vmIpcGetHandle(handle);
     if (!h.is_read) {
         throw std::runtime_error("ipc.recv() called on a write-only handle.");
@@ -1668,13 +1669,13 @@ Value vmNativeIpcRecv(VM& /*vm*/, const std::vector<Value>& arguments) {
 }
 
 Value vmNativeIpcTryRecv(VM& /*vm*/, const std::vector<Value>& arguments) {
-    if (arguments.size() != 1 || !std::holds_alternative<double>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isNumber()) {
         throw std::runtime_error("ipc.tryRecv() takes exactly one handle (number) argument.");
     }
 #ifdef _WIN32
     throw std::runtime_error("ipc.tryRecv() is not supported on Windows.");
 #else
-    int handle = static_cast<int>(std::get<double>(arguments[0]));
+    int handle = static_cast<int>(arguments[0].asNumber());
     VmIpcHandle h = vmIpcGetHandle(handle);
     if (!h.is_read) {
         throw std::runtime_error("ipc.tryRecv() called on a write-only handle.");
@@ -1713,13 +1714,13 @@ Value vmNativeIpcTryRecv(VM& /*vm*/, const std::vector<Value>& arguments) {
 }
 
 Value vmNativeIpcClose(VM& /*vm*/, const std::vector<Value>& arguments) {
-    if (arguments.size() != 1 || !std::holds_alternative<double>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isNumber()) {
         throw std::runtime_error("ipc.close() takes exactly one handle (number) argument.");
     }
 #ifdef _WIN32
     throw std::runtime_error("ipc.close() is not supported on Windows.");
 #else
-    int handle = static_cast<int>(std::get<double>(arguments[0]));
+    int handle = static_cast<int>(arguments[0].asNumber());
     VmIpcHandle h = vmIpcGetHandle(handle);
     close(h.fd);
     vmIpcFreeHandle(handle);
@@ -1728,13 +1729,13 @@ Value vmNativeIpcClose(VM& /*vm*/, const std::vector<Value>& arguments) {
 }
 
 Value vmNativeIpcRemovePipe(VM& /*vm*/, const std::vector<Value>& arguments) {
-    if (arguments.size() != 1 || !std::holds_alternative<std::string>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isString()) {
         throw std::runtime_error("ipc.removePipe() takes exactly one string argument (pipe name).");
     }
 #ifdef _WIN32
     throw std::runtime_error("ipc.removePipe() is not supported on Windows.");
 #else
-    const std::string& name = std::get<std::string>(arguments[0]);
+    const std::string& name = arguments[0].asString();
     std::string path = vmIpcPipePath(name);
     if (unlink(path.c_str()) != 0 && errno != ENOENT) {
         throw std::runtime_error("ipc.removePipe() failed to remove pipe '" + name + "': " + strerror(errno));
@@ -1780,12 +1781,12 @@ static void vmNetFreeHandle(int id) {
 }  // anonymous namespace
 
 Value vmNativeNetConnect(VM& /*vm*/, const std::vector<Value>& arguments) {
-    if (arguments.size() != 2 || !std::holds_alternative<std::string>(arguments[0]) ||
-        !std::holds_alternative<double>(arguments[1])) {
+    if (arguments.size() != 2 || !arguments[0].isString() ||
+        !arguments[1].isNumber()) {
         throw std::runtime_error("net.connect() takes a host (string) and port (number).");
     }
-    const std::string& host = std::get<std::string>(arguments[0]);
-    int port = static_cast<int>(std::get<double>(arguments[1]));
+    const std::string& host = arguments[0].asString();
+    int port = static_cast<int>(arguments[1].asNumber());
     if (port <= 0 || port > 65535) {
         throw std::runtime_error("net.connect(): port must be between 1 and 65535.");
     }
@@ -1818,10 +1819,10 @@ Value vmNativeNetConnect(VM& /*vm*/, const std::vector<Value>& arguments) {
 }
 
 Value vmNativeNetListen(VM& /*vm*/, const std::vector<Value>& arguments) {
-    if (arguments.size() != 1 || !std::holds_alternative<double>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isNumber()) {
         throw std::runtime_error("net.listen() takes exactly one numeric argument (port).");
     }
-    int port = static_cast<int>(std::get<double>(arguments[0]));
+    int port = static_cast<int>(arguments[0].asNumber());
     if (port <= 0 || port > 65535) {
         throw std::runtime_error("net.listen(): port must be between 1 and 65535.");
     }
@@ -1870,10 +1871,10 @@ Value vmNativeNetListen(VM& /*vm*/, const std::vector<Value>& arguments) {
 }
 
 Value vmNativeNetAccept(VM& /*vm*/, const std::vector<Value>& arguments) {
-    if (arguments.empty() || !std::holds_alternative<double>(arguments[0])) {
+    if (arguments.empty() || !arguments[0].isNumber()) {
         throw std::runtime_error("net.accept() takes a server handle (number) and an optional timeout (number).");
     }
-    int handle = static_cast<int>(std::get<double>(arguments[0]));
+    int handle = static_cast<int>(arguments[0].asNumber());
     VmNetSocket srv = vmNetGetHandle(handle);
     if (!srv.is_server) {
         throw std::runtime_error("net.accept(): handle is not a server socket.");
@@ -1881,10 +1882,10 @@ Value vmNativeNetAccept(VM& /*vm*/, const std::vector<Value>& arguments) {
 
     int timeoutMs = -1;
     if (arguments.size() >= 2) {
-        if (!std::holds_alternative<double>(arguments[1])) {
+        if (!arguments[1].isNumber()) {
             throw std::runtime_error("net.accept(): timeout must be a number.");
         }
-        timeoutMs = static_cast<int>(std::get<double>(arguments[1]));
+        timeoutMs = static_cast<int>(arguments[1].asNumber());
     }
 
     if (timeoutMs >= 0) {
@@ -1910,12 +1911,12 @@ Value vmNativeNetAccept(VM& /*vm*/, const std::vector<Value>& arguments) {
 }
 
 Value vmNativeNetSend(VM& /*vm*/, const std::vector<Value>& arguments) {
-    if (arguments.size() != 2 || !std::holds_alternative<double>(arguments[0]) ||
-        !std::holds_alternative<std::string>(arguments[1])) {
+    if (arguments.size() != 2 || !arguments[0].isNumber() ||
+        !arguments[1].isString()) {
         throw std::runtime_error("net.send() takes a socket handle (number) and data (string).");
     }
-    int handle = static_cast<int>(std::get<double>(arguments[0]));
-    const std::string& data = std::get<std::string>(arguments[1]);
+    int handle = static_cast<int>(arguments[0].asNumber());
+    const std::string& data = arguments[1].asString();
     VmNetSocket sock = vmNetGetHandle(handle);
     if (sock.is_server) {
         throw std::runtime_error("net.send(): cannot send on a server (listening) socket.");
@@ -1940,16 +1941,16 @@ Value vmNativeNetSend(VM& /*vm*/, const std::vector<Value>& arguments) {
 }
 
 Value vmNativeNetRecv(VM& /*vm*/, const std::vector<Value>& arguments) {
-    if (arguments.empty() || !std::holds_alternative<double>(arguments[0])) {
+    if (arguments.empty() || !arguments[0].isNumber()) {
         throw std::runtime_error("net.recv() takes a socket handle (number) and an optional buffer size (number).");
     }
-    int handle = static_cast<int>(std::get<double>(arguments[0]));
+    int handle = static_cast<int>(arguments[0].asNumber());
     int bufsize = 4096;
     if (arguments.size() >= 2) {
-        if (!std::holds_alternative<double>(arguments[1])) {
+        if (!arguments[1].isNumber()) {
             throw std::runtime_error("net.recv(): buffer size must be a number.");
         }
-        bufsize = static_cast<int>(std::get<double>(arguments[1]));
+        bufsize = static_cast<int>(arguments[1].asNumber());
         if (bufsize <= 0) throw std::runtime_error("net.recv(): buffer size must be positive.");
     }
     VmNetSocket sock = vmNetGetHandle(handle);
@@ -1970,10 +1971,10 @@ Value vmNativeNetRecv(VM& /*vm*/, const std::vector<Value>& arguments) {
 }
 
 Value vmNativeNetClose(VM& /*vm*/, const std::vector<Value>& arguments) {
-    if (arguments.size() != 1 || !std::holds_alternative<double>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isNumber()) {
         throw std::runtime_error("net.close() takes exactly one socket handle (number).");
     }
-    int handle = static_cast<int>(std::get<double>(arguments[0]));
+    int handle = static_cast<int>(arguments[0].asNumber());
     VmNetSocket sock = vmNetGetHandle(handle);
     ::close(sock.fd);
     vmNetFreeHandle(handle);
@@ -1981,12 +1982,12 @@ Value vmNativeNetClose(VM& /*vm*/, const std::vector<Value>& arguments) {
 }
 
 Value vmNativeNetSetTimeout(VM& /*vm*/, const std::vector<Value>& arguments) {
-    if (arguments.size() != 2 || !std::holds_alternative<double>(arguments[0]) ||
-        !std::holds_alternative<double>(arguments[1])) {
+    if (arguments.size() != 2 || !arguments[0].isNumber() ||
+        !arguments[1].isNumber()) {
         throw std::runtime_error("net.setTimeout() takes a socket handle (number) and timeout in ms (number).");
     }
-    int handle = static_cast<int>(std::get<double>(arguments[0]));
-    int ms = static_cast<int>(std::get<double>(arguments[1]));
+    int handle = static_cast<int>(arguments[0].asNumber());
+    int ms = static_cast<int>(arguments[1].asNumber());
     if (ms < 0) throw std::runtime_error("net.setTimeout(): timeout must be non-negative.");
     VmNetSocket sock = vmNetGetHandle(handle);
 
@@ -2000,81 +2001,81 @@ Value vmNativeNetSetTimeout(VM& /*vm*/, const std::vector<Value>& arguments) {
 
 void registerVmNatives(VM& vm) {
     // Core functions
-    vm.setGlobal("print", std::make_shared<VmNativeFunction>("print", -1, vmNativePrint));
-    vm.setGlobal("len", std::make_shared<VmNativeFunction>("len", 1, vmNativeLen));
-    vm.setGlobal("clock", std::make_shared<VmNativeFunction>("clock", 0, vmNativeClock));
+    vm.setGlobal("print", makeRef<VmNativeFunction>("print", -1, vmNativePrint));
+    vm.setGlobal("len", makeRef<VmNativeFunction>("len", 1, vmNativeLen));
+    vm.setGlobal("clock", makeRef<VmNativeFunction>("clock", 0, vmNativeClock));
 
     // Array functions
-    vm.setGlobal("push", std::make_shared<VmNativeFunction>("push", 2, vmNativePush));
-    vm.setGlobal("pop", std::make_shared<VmNativeFunction>("pop", 1, vmNativePop));
-    vm.setGlobal("shift", std::make_shared<VmNativeFunction>("shift", 1, vmNativeShift));
-    vm.setGlobal("unshift", std::make_shared<VmNativeFunction>("unshift", 2, vmNativeUnshift));
-    vm.setGlobal("splice", std::make_shared<VmNativeFunction>("splice", -1, vmNativeSplice));
+    vm.setGlobal("push", makeRef<VmNativeFunction>("push", 2, vmNativePush));
+    vm.setGlobal("pop", makeRef<VmNativeFunction>("pop", 1, vmNativePop));
+    vm.setGlobal("shift", makeRef<VmNativeFunction>("shift", 1, vmNativeShift));
+    vm.setGlobal("unshift", makeRef<VmNativeFunction>("unshift", 2, vmNativeUnshift));
+    vm.setGlobal("splice", makeRef<VmNativeFunction>("splice", -1, vmNativeSplice));
 
     // Map functions
-    vm.setGlobal("keys", std::make_shared<VmNativeFunction>("keys", 1, vmNativeKeys));
-    vm.setGlobal("values", std::make_shared<VmNativeFunction>("values", 1, vmNativeValues));
-    vm.setGlobal("hasKey", std::make_shared<VmNativeFunction>("hasKey", 2, vmNativeHasKey));
-    vm.setGlobal("has", std::make_shared<VmNativeFunction>("has", 2, vmNativeHas));
-    vm.setGlobal("delete", std::make_shared<VmNativeFunction>("delete", 2, vmNativeDelete));
-    vm.setGlobal("entries", std::make_shared<VmNativeFunction>("entries", 1, vmNativeEntries));
+    vm.setGlobal("keys", makeRef<VmNativeFunction>("keys", 1, vmNativeKeys));
+    vm.setGlobal("values", makeRef<VmNativeFunction>("values", 1, vmNativeValues));
+    vm.setGlobal("hasKey", makeRef<VmNativeFunction>("hasKey", 2, vmNativeHasKey));
+    vm.setGlobal("has", makeRef<VmNativeFunction>("has", 2, vmNativeHas));
+    vm.setGlobal("delete", makeRef<VmNativeFunction>("delete", 2, vmNativeDelete));
+    vm.setGlobal("entries", makeRef<VmNativeFunction>("entries", 1, vmNativeEntries));
 
     // Set functions
-    vm.setGlobal("Set", std::make_shared<VmNativeFunction>("Set", 0, vmNativeSet));
-    vm.setGlobal("setAdd", std::make_shared<VmNativeFunction>("setAdd", 2, vmNativeSetAdd));
-    vm.setGlobal("setHas", std::make_shared<VmNativeFunction>("setHas", 2, vmNativeSetHas));
-    vm.setGlobal("setDelete", std::make_shared<VmNativeFunction>("setDelete", 2, vmNativeSetDelete));
-    vm.setGlobal("setSize", std::make_shared<VmNativeFunction>("setSize", 1, vmNativeSetSize));
+    vm.setGlobal("Set", makeRef<VmNativeFunction>("Set", 0, vmNativeSet));
+    vm.setGlobal("setAdd", makeRef<VmNativeFunction>("setAdd", 2, vmNativeSetAdd));
+    vm.setGlobal("setHas", makeRef<VmNativeFunction>("setHas", 2, vmNativeSetHas));
+    vm.setGlobal("setDelete", makeRef<VmNativeFunction>("setDelete", 2, vmNativeSetDelete));
+    vm.setGlobal("setSize", makeRef<VmNativeFunction>("setSize", 1, vmNativeSetSize));
 
     // std.math functions
-    vm.setGlobal("sqrt", std::make_shared<VmNativeFunction>("sqrt", 1, vmNativeSqrt));
-    vm.setGlobal("pow", std::make_shared<VmNativeFunction>("pow", 2, vmNativePow));
-    vm.setGlobal("abs", std::make_shared<VmNativeFunction>("abs", 1, vmNativeAbs));
-    vm.setGlobal("floor", std::make_shared<VmNativeFunction>("floor", 1, vmNativeFloor));
-    vm.setGlobal("ceil", std::make_shared<VmNativeFunction>("ceil", 1, vmNativeCeil));
-    vm.setGlobal("round", std::make_shared<VmNativeFunction>("round", 1, vmNativeRound));
-    vm.setGlobal("trunc", std::make_shared<VmNativeFunction>("trunc", 1, vmNativeTrunc));
-    vm.setGlobal("log", std::make_shared<VmNativeFunction>("log", 1, vmNativeLog));
-    vm.setGlobal("log2", std::make_shared<VmNativeFunction>("log2", 1, vmNativeLog2));
-    vm.setGlobal("log10", std::make_shared<VmNativeFunction>("log10", 1, vmNativeLog10));
-    vm.setGlobal("sin", std::make_shared<VmNativeFunction>("sin", 1, vmNativeSin));
-    vm.setGlobal("cos", std::make_shared<VmNativeFunction>("cos", 1, vmNativeCos));
-    vm.setGlobal("tan", std::make_shared<VmNativeFunction>("tan", 1, vmNativeTan));
-    vm.setGlobal("asin", std::make_shared<VmNativeFunction>("asin", 1, vmNativeAsin));
-    vm.setGlobal("acos", std::make_shared<VmNativeFunction>("acos", 1, vmNativeAcos));
-    vm.setGlobal("atan", std::make_shared<VmNativeFunction>("atan", 1, vmNativeAtan));
-    vm.setGlobal("atan2", std::make_shared<VmNativeFunction>("atan2", 2, vmNativeAtan2));
-    vm.setGlobal("hypot", std::make_shared<VmNativeFunction>("hypot", -1, vmNativeHypot));
-    vm.setGlobal("min", std::make_shared<VmNativeFunction>("min", -1, vmNativeMin));
-    vm.setGlobal("max", std::make_shared<VmNativeFunction>("max", -1, vmNativeMax));
+    vm.setGlobal("sqrt", makeRef<VmNativeFunction>("sqrt", 1, vmNativeSqrt));
+    vm.setGlobal("pow", makeRef<VmNativeFunction>("pow", 2, vmNativePow));
+    vm.setGlobal("abs", makeRef<VmNativeFunction>("abs", 1, vmNativeAbs));
+    vm.setGlobal("floor", makeRef<VmNativeFunction>("floor", 1, vmNativeFloor));
+    vm.setGlobal("ceil", makeRef<VmNativeFunction>("ceil", 1, vmNativeCeil));
+    vm.setGlobal("round", makeRef<VmNativeFunction>("round", 1, vmNativeRound));
+    vm.setGlobal("trunc", makeRef<VmNativeFunction>("trunc", 1, vmNativeTrunc));
+    vm.setGlobal("log", makeRef<VmNativeFunction>("log", 1, vmNativeLog));
+    vm.setGlobal("log2", makeRef<VmNativeFunction>("log2", 1, vmNativeLog2));
+    vm.setGlobal("log10", makeRef<VmNativeFunction>("log10", 1, vmNativeLog10));
+    vm.setGlobal("sin", makeRef<VmNativeFunction>("sin", 1, vmNativeSin));
+    vm.setGlobal("cos", makeRef<VmNativeFunction>("cos", 1, vmNativeCos));
+    vm.setGlobal("tan", makeRef<VmNativeFunction>("tan", 1, vmNativeTan));
+    vm.setGlobal("asin", makeRef<VmNativeFunction>("asin", 1, vmNativeAsin));
+    vm.setGlobal("acos", makeRef<VmNativeFunction>("acos", 1, vmNativeAcos));
+    vm.setGlobal("atan", makeRef<VmNativeFunction>("atan", 1, vmNativeAtan));
+    vm.setGlobal("atan2", makeRef<VmNativeFunction>("atan2", 2, vmNativeAtan2));
+    vm.setGlobal("hypot", makeRef<VmNativeFunction>("hypot", -1, vmNativeHypot));
+    vm.setGlobal("min", makeRef<VmNativeFunction>("min", -1, vmNativeMin));
+    vm.setGlobal("max", makeRef<VmNativeFunction>("max", -1, vmNativeMax));
 
     // std.string functions
-    vm.setGlobal("substring", std::make_shared<VmNativeFunction>("substring", -1, vmNativeSubstring));
-    vm.setGlobal("split", std::make_shared<VmNativeFunction>("split", 2, vmNativeSplit));
-    vm.setGlobal("join", std::make_shared<VmNativeFunction>("join", 2, vmNativeJoin));
-    vm.setGlobal("toUpper", std::make_shared<VmNativeFunction>("toUpper", 1, vmNativeToUpper));
-    vm.setGlobal("toLower", std::make_shared<VmNativeFunction>("toLower", 1, vmNativeToLower));
-    vm.setGlobal("trim", std::make_shared<VmNativeFunction>("trim", 1, vmNativeTrim));
-    vm.setGlobal("replace", std::make_shared<VmNativeFunction>("replace", 3, vmNativeReplace));
-    vm.setGlobal("startsWith", std::make_shared<VmNativeFunction>("startsWith", 2, vmNativeStartsWith));
-    vm.setGlobal("endsWith", std::make_shared<VmNativeFunction>("endsWith", 2, vmNativeEndsWith));
-    vm.setGlobal("indexOf", std::make_shared<VmNativeFunction>("indexOf", 2, vmNativeIndexOf));
-    vm.setGlobal("contains", std::make_shared<VmNativeFunction>("contains", 2, vmNativeContains));
+    vm.setGlobal("substring", makeRef<VmNativeFunction>("substring", -1, vmNativeSubstring));
+    vm.setGlobal("split", makeRef<VmNativeFunction>("split", 2, vmNativeSplit));
+    vm.setGlobal("join", makeRef<VmNativeFunction>("join", 2, vmNativeJoin));
+    vm.setGlobal("toUpper", makeRef<VmNativeFunction>("toUpper", 1, vmNativeToUpper));
+    vm.setGlobal("toLower", makeRef<VmNativeFunction>("toLower", 1, vmNativeToLower));
+    vm.setGlobal("trim", makeRef<VmNativeFunction>("trim", 1, vmNativeTrim));
+    vm.setGlobal("replace", makeRef<VmNativeFunction>("replace", 3, vmNativeReplace));
+    vm.setGlobal("startsWith", makeRef<VmNativeFunction>("startsWith", 2, vmNativeStartsWith));
+    vm.setGlobal("endsWith", makeRef<VmNativeFunction>("endsWith", 2, vmNativeEndsWith));
+    vm.setGlobal("indexOf", makeRef<VmNativeFunction>("indexOf", 2, vmNativeIndexOf));
+    vm.setGlobal("contains", makeRef<VmNativeFunction>("contains", 2, vmNativeContains));
 
     // std.array functions
-    vm.setGlobal("map", std::make_shared<VmNativeFunction>("map", 2, vmNativeMap));
-    vm.setGlobal("filter", std::make_shared<VmNativeFunction>("filter", 2, vmNativeFilter));
-    vm.setGlobal("reduce", std::make_shared<VmNativeFunction>("reduce", -1, vmNativeReduce));
-    vm.setGlobal("sort", std::make_shared<VmNativeFunction>("sort", -1, vmNativeSort));
-    vm.setGlobal("reverse", std::make_shared<VmNativeFunction>("reverse", 1, vmNativeReverse));
-    vm.setGlobal("concat", std::make_shared<VmNativeFunction>("concat", 2, vmNativeConcat));
-    vm.setGlobal("slice", std::make_shared<VmNativeFunction>("slice", -1, vmNativeSlice));
+    vm.setGlobal("map", makeRef<VmNativeFunction>("map", 2, vmNativeMap));
+    vm.setGlobal("filter", makeRef<VmNativeFunction>("filter", 2, vmNativeFilter));
+    vm.setGlobal("reduce", makeRef<VmNativeFunction>("reduce", -1, vmNativeReduce));
+    vm.setGlobal("sort", makeRef<VmNativeFunction>("sort", -1, vmNativeSort));
+    vm.setGlobal("reverse", makeRef<VmNativeFunction>("reverse", 1, vmNativeReverse));
+    vm.setGlobal("concat", makeRef<VmNativeFunction>("concat", 2, vmNativeConcat));
+    vm.setGlobal("slice", makeRef<VmNativeFunction>("slice", -1, vmNativeSlice));
 
     // std.io functions
-    vm.setGlobal("readFile", std::make_shared<VmNativeFunction>("readFile", 1, vmNativeReadFile));
-    vm.setGlobal("writeFile", std::make_shared<VmNativeFunction>("writeFile", 2, vmNativeWriteFile));
-    vm.setGlobal("appendFile", std::make_shared<VmNativeFunction>("appendFile", 2, vmNativeAppendFile));
-    vm.setGlobal("fileExists", std::make_shared<VmNativeFunction>("fileExists", 1, vmNativeFileExists));
+    vm.setGlobal("readFile", makeRef<VmNativeFunction>("readFile", 1, vmNativeReadFile));
+    vm.setGlobal("writeFile", makeRef<VmNativeFunction>("writeFile", 2, vmNativeWriteFile));
+    vm.setGlobal("appendFile", makeRef<VmNativeFunction>("appendFile", 2, vmNativeAppendFile));
+    vm.setGlobal("fileExists", makeRef<VmNativeFunction>("fileExists", 1, vmNativeFileExists));
 }
 
 }  // namespace izi
@@ -18,10 +18,15 @@ class VmNativeFunction : public VmCallable {
 
     Value call(VM& vm, const std::vector<Value>& arguments) override { return fn_(vm, arguments); }
 
+    // Native module that exported this function ("math", ...); empty for globals
+    const std::string& module() const { return module_; }
+    void setModule(std::string module) { module_ = std::move(module); }
+
    private:
     std::string name_;
     int arity_;
     NativeFn fn_;
+    std::string module_;
 };
 
 // Native function implementations
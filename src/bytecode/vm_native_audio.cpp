@@ -86,38 +86,38 @@ struct VmMusicHandle {
 // ---------------------------------------------------------------------------
 #ifdef HAVE_RAYLIB
 static Value vmBuildSoundObject(std::shared_ptr<VmSoundHandle> handle) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
-    obj->entries["play"] = Value{std::make_shared<VmNativeFunction>("play", 0,
+    obj->entries["play"] = Value{makeRef<VmNativeFunction>("play", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) PlaySound(handle->sound);
             return Nil{};
         })};
 
-    obj->entries["stop"] = Value{std::make_shared<VmNativeFunction>("stop", 0,
+    obj->entries["stop"] = Value{makeRef<VmNativeFunction>("stop", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) StopSound(handle->sound);
             return Nil{};
         })};
 
-    obj->entries["pause"] = Value{std::make_shared<VmNativeFunction>("pause", 0,
+    obj->entries["pause"] = Value{makeRef<VmNativeFunction>("pause", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) PauseSound(handle->sound);
             return Nil{};
         })};
 
-    obj->entries["resume"] = Value{std::make_shared<VmNativeFunction>("resume", 0,
+    obj->entries["resume"] = Value{makeRef<VmNativeFunction>("resume", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ResumeSound(handle->sound);
             return Nil{};
         })};
 
-    obj->entries["isPlaying"] = Value{std::make_shared<VmNativeFunction>("isPlaying", 0,
+    obj->entries["isPlaying"] = Value{makeRef<VmNativeFunction>("isPlaying", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             return handle->loaded && static_cast<bool>(IsSoundPlaying(handle->sound));
         })};
 
-    obj->entries["setVolume"] = Value{std::make_shared<VmNativeFunction>("setVolume", 1,
+    obj->entries["setVolume"] = Value{makeRef<VmNativeFunction>("setVolume", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("sound.setVolume() takes 1 argument (volume).");
@@ -126,7 +126,7 @@ static Value vmBuildSoundObject(std::shared_ptr<VmSoundHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["setPitch"] = Value{std::make_shared<VmNativeFunction>("setPitch", 1,
+    obj->entries["setPitch"] = Value{makeRef<VmNativeFunction>("setPitch", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("sound.setPitch() takes 1 argument (pitch).");
@@ -135,7 +135,7 @@ static Value vmBuildSoundObject(std::shared_ptr<VmSoundHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["setPan"] = Value{std::make_shared<VmNativeFunction>("setPan", 1,
+    obj->entries["setPan"] = Value{makeRef<VmNativeFunction>("setPan", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("sound.setPan() takes 1 argument (pan).");
@@ -144,7 +144,7 @@ static Value vmBuildSoundObject(std::shared_ptr<VmSoundHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["unload"] = Value{std::make_shared<VmNativeFunction>("unload", 0,
+    obj->entries["unload"] = Value{makeRef<VmNativeFunction>("unload", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) {
                 UnloadSound(handle->sound);
@@ -157,38 +157,38 @@ static Value vmBuildSoundObject(std::shared_ptr<VmSoundHandle> handle) {
 }
 #else
 static Value vmBuildSoundObject(std::shared_ptr<VmSoundHandle> handle) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
-    obj->entries["play"] = Value{std::make_shared<VmNativeFunction>("play", 0,
+    obj->entries["play"] = Value{makeRef<VmNativeFunction>("play", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ma_sound_start(&handle->sound);
             return Nil{};
         })};
 
-    obj->entries["stop"] = Value{std::make_shared<VmNativeFunction>("stop", 0,
+    obj->entries["stop"] = Value{makeRef<VmNativeFunction>("stop", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ma_sound_stop(&handle->sound);
             return Nil{};
         })};
 
-    obj->entries["pause"] = Value{std::make_shared<VmNativeFunction>("pause", 0,
+    obj->entries["pause"] = Value{makeRef<VmNativeFunction>("pause", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ma_sound_stop(&handle->sound);
             return Nil{};
         })};
 
-    obj->entries["resume"] = Value{std::make_shared<VmNativeFunction>("resume", 0,
+    obj->entries["resume"] = Value{makeRef<VmNativeFunction>("resume", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ma_sound_start(&handle->sound);
             return Nil{};
         })};
 
-    obj->entries["isPlaying"] = Value{std::make_shared<VmNativeFunction>("isPlaying", 0,
+    obj->entries["isPlaying"] = Value{makeRef<VmNativeFunction>("isPlaying", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             return handle->loaded && static_cast<bool>(ma_sound_is_playing(&handle->sound));
         })};
 
-    obj->entries["setVolume"] = Value{std::make_shared<VmNativeFunction>("setVolume", 1,
+    obj->entries["setVolume"] = Value{makeRef<VmNativeFunction>("setVolume", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("sound.setVolume() takes 1 argument (volume).");
@@ -197,7 +197,7 @@ static Value vmBuildSoundObject(std::shared_ptr<VmSoundHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["setPitch"] = Value{std::make_shared<VmNativeFunction>("setPitch", 1,
+    obj->entries["setPitch"] = Value{makeRef<VmNativeFunction>("setPitch", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("sound.setPitch() takes 1 argument (pitch).");
@@ -206,7 +206,7 @@ static Value vmBuildSoundObject(std::shared_ptr<VmSoundHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["setPan"] = Value{std::make_shared<VmNativeFunction>("setPan", 1,
+    obj->entries["setPan"] = Value{makeRef<VmNativeFunction>("setPan", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("sound.setPan() takes 1 argument (pan).");
@@ -215,7 +215,7 @@ static Value vmBuildSoundObject(std::shared_ptr<VmSoundHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["unload"] = Value{std::make_shared<VmNativeFunction>("unload", 0,
+    obj->entries["unload"] = Value{makeRef<VmNativeFunction>("unload", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) {
                 ma_sound_uninit(&handle->sound);
@@ -233,44 +233,44 @@ static Value vmBuildSoundObject(std::shared_ptr<VmSoundHandle> handle) {
 // ---------------------------------------------------------------------------
 #ifdef HAVE_RAYLIB
 static Value vmBuildMusicObject(std::shared_ptr<VmMusicHandle> handle) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
-    obj->entries["play"] = Value{std::make_shared<VmNativeFunction>("play", 0,
+    obj->entries["play"] = Value{makeRef<VmNativeFunction>("play", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) PlayMusicStream(handle->music);
             return Nil{};
         })};
 
-    obj->entries["stop"] = Value{std::make_shared<VmNativeFunction>("stop", 0,
+    obj->entries["stop"] = Value{makeRef<VmNativeFunction>("stop", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) StopMusicStream(handle->music);
             return Nil{};
         })};
 
-    obj->entries["pause"] = Value{std::make_shared<VmNativeFunction>("pause", 0,
+    obj->entries["pause"] = Value{makeRef<VmNativeFunction>("pause", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) PauseMusicStream(handle->music);
             return Nil{};
         })};
 
-    obj->entries["resume"] = Value{std::make_shared<VmNativeFunction>("resume", 0,
+    obj->entries["resume"] = Value{makeRef<VmNativeFunction>("resume", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ResumeMusicStream(handle->music);
             return Nil{};
         })};
 
-    obj->entries["update"] = Value{std::make_shared<VmNativeFunction>("update", 0,
+    obj->entries["update"] = Value{makeRef<VmNativeFunction>("update", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) UpdateMusicStream(handle->music);
             return Nil{};
         })};
 
-    obj->entries["isPlaying"] = Value{std::make_shared<VmNativeFunction>("isPlaying", 0,
+    obj->entries["isPlaying"] = Value{makeRef<VmNativeFunction>("isPlaying", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             return handle->loaded && static_cast<bool>(IsMusicStreamPlaying(handle->music));
         })};
 
-    obj->entries["setVolume"] = Value{std::make_shared<VmNativeFunction>("setVolume", 1,
+    obj->entries["setVolume"] = Value{makeRef<VmNativeFunction>("setVolume", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("music.setVolume() takes 1 argument (volume).");
@@ -279,7 +279,7 @@ static Value vmBuildMusicObject(std::shared_ptr<VmMusicHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["setPitch"] = Value{std::make_shared<VmNativeFunction>("setPitch", 1,
+    obj->entries["setPitch"] = Value{makeRef<VmNativeFunction>("setPitch", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("music.setPitch() takes 1 argument (pitch).");
@@ -288,7 +288,7 @@ static Value vmBuildMusicObject(std::shared_ptr<VmMusicHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["setPan"] = Value{std::make_shared<VmNativeFunction>("setPan", 1,
+    obj->entries["setPan"] = Value{makeRef<VmNativeFunction>("setPan", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("music.setPan() takes 1 argument (pan).");
@@ -297,7 +297,7 @@ static Value vmBuildMusicObject(std::shared_ptr<VmMusicHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["seek"] = Value{std::make_shared<VmNativeFunction>("seek", 1,
+    obj->entries["seek"] = Value{makeRef<VmNativeFunction>("seek", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("music.seek() takes 1 argument (position).");
@@ -306,19 +306,19 @@ static Value vmBuildMusicObject(std::shared_ptr<VmMusicHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["getLength"] = Value{std::make_shared<VmNativeFunction>("getLength", 0,
+    obj->entries["getLength"] = Value{makeRef<VmNativeFunction>("getLength", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (!handle->loaded) return 0.0;
             return static_cast<double>(GetMusicTimeLength(handle->music));
         })};
 
-    obj->entries["getTimePlayed"] = Value{std::make_shared<VmNativeFunction>("getTimePlayed", 0,
+    obj->entries["getTimePlayed"] = Value{makeRef<VmNativeFunction>("getTimePlayed", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (!handle->loaded) return 0.0;
             return static_cast<double>(GetMusicTimePlayed(handle->music));
         })};
 
-    obj->entries["unload"] = Value{std::make_shared<VmNativeFunction>("unload", 0,
+    obj->entries["unload"] = Value{makeRef<VmNativeFunction>("unload", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) {
                 UnloadMusicStream(handle->music);
@@ -331,44 +331,44 @@ static Value vmBuildMusicObject(std::shared_ptr<VmMusicHandle> handle) {
 }
 #else
 static Value vmBuildMusicObject(std::shared_ptr<VmMusicHandle> handle) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
-    obj->entries["play"] = Value{std::make_shared<VmNativeFunction>("play", 0,
+    obj->entries["play"] = Value{makeRef<VmNativeFunction>("play", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ma_sound_start(&handle->sound);
             return Nil{};
         })};
 
-    obj->entries["stop"] = Value{std::make_shared<VmNativeFunction>("stop", 0,
+    obj->entries["stop"] = Value{makeRef<VmNativeFunction>("stop", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ma_sound_stop(&handle->sound);
             return Nil{};
         })};
 
-    obj->entries["pause"] = Value{std::make_shared<VmNativeFunction>("pause", 0,
+    obj->entries["pause"] = Value{makeRef<VmNativeFunction>("pause", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ma_sound_stop(&handle->sound);
             return Nil{};
         })};
 
-    obj->entries["resume"] = Value{std::make_shared<VmNativeFunction>("resume", 0,
+    obj->entries["resume"] = Value{makeRef<VmNativeFunction>("resume", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ma_sound_start(&handle->sound);
             return Nil{};
         })};
 
-    obj->entries["update"] = Value{std::make_shared<VmNativeFunction>("update", 0,
+    obj->entries["update"] = Value{makeRef<VmNativeFunction>("update", 0,
         [](VM&, const std::vector<Value>&) -> Value {
             // miniaudio streams are updated automatically on a background thread.
             return Nil{};
         })};
 
-    obj->entries["isPlaying"] = Value{std::make_shared<VmNativeFunction>("isPlaying", 0,
+    obj->entries["isPlaying"] = Value{makeRef<VmNativeFunction>("isPlaying", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             return handle->loaded && static_cast<bool>(ma_sound_is_playing(&handle->sound));
         })};
 
-    obj->entries["setVolume"] = Value{std::make_shared<VmNativeFunction>("setVolume", 1,
+    obj->entries["setVolume"] = Value{makeRef<VmNativeFunction>("setVolume", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("music.setVolume() takes 1 argument (volume).");
@@ -377,7 +377,7 @@ static Value vmBuildMusicObject(std::shared_ptr<VmMusicHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["setPitch"] = Value{std::make_shared<VmNativeFunction>("setPitch", 1,
+    obj->entries["setPitch"] = Value{makeRef<VmNativeFunction>("setPitch", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("music.setPitch() takes 1 argument (pitch).");
@@ -386,7 +386,7 @@ static Value vmBuildMusicObject(std::shared_ptr<VmMusicHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["setPan"] = Value{std::make_shared<VmNativeFunction>("setPan", 1,
+    obj->entries["setPan"] = Value{makeRef<VmNativeFunction>("setPan", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("music.setPan() takes 1 argument (pan).");
@@ -395,7 +395,7 @@ static Value vmBuildMusicObject(std::shared_ptr<VmMusicHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["seek"] = Value{std::make_shared<VmNativeFunction>("seek", 1,
+    obj->entries["seek"] = Value{makeRef<VmNativeFunction>("seek", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("music.seek() takes 1 argument (position).");
@@ -406,7 +406,7 @@ static Value vmBuildMusicObject(std::shared_ptr<VmMusicHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["getLength"] = Value{std::make_shared<VmNativeFunction>("getLength", 0,
+    obj->entries["getLength"] = Value{makeRef<VmNativeFunction>("getLength", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (!handle->loaded) return 0.0;
             float len = 0.0f;
@@ -414,7 +414,7 @@ static Value vmBuildMusicObject(std::shared_ptr<VmMusicHandle> handle) {
             return static_cast<double>(len);
         })};
 
-    obj->entries["getTimePlayed"] = Value{std::make_shared<VmNativeFunction>("getTimePlayed", 0,
+    obj->entries["getTimePlayed"] = Value{makeRef<VmNativeFunction>("getTimePlayed", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (!handle->loaded) return 0.0;
             float t = 0.0f;
@@ -422,7 +422,7 @@ static Value vmBuildMusicObject(std::shared_ptr<VmMusicHandle> handle) {
             return static_cast<double>(t);
         })};
 
-    obj->entries["unload"] = Value{std::make_shared<VmNativeFunction>("unload", 0,
+    obj->entries["unload"] = Value{makeRef<VmNativeFunction>("unload", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) {
                 ma_sound_uninit(&handle->sound);
@@ -439,10 +439,10 @@ static Value vmBuildMusicObject(std::shared_ptr<VmMusicHandle> handle) {
 // Build the top-level audio module Map (VM version)
 // ---------------------------------------------------------------------------
 Value createVmAudioModule(VM& /*vm*/) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // audio.initDevice()
-    module->entries["initDevice"] = Value{std::make_shared<VmNativeFunction>("initDevice", 0,
+    module->entries["initDevice"] = Value{makeRef<VmNativeFunction>("initDevice", 0,
         [](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             InitAudioDevice();
@@ -461,7 +461,7 @@ Value createVmAudioModule(VM& /*vm*/) {
         })};
 
     // audio.closeDevice()
-    module->entries["closeDevice"] = Value{std::make_shared<VmNativeFunction>("closeDevice", 0,
+    module->entries["closeDevice"] = Value{makeRef<VmNativeFunction>("closeDevice", 0,
         [](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             CloseAudioDevice();
@@ -476,7 +476,7 @@ Value createVmAudioModule(VM& /*vm*/) {
         })};
 
     // audio.isDeviceReady() -> bool
-    module->entries["isDeviceReady"] = Value{std::make_shared<VmNativeFunction>("isDeviceReady", 0,
+    module->entries["isDeviceReady"] = Value{makeRef<VmNativeFunction>("isDeviceReady", 0,
         [](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             return static_cast<bool>(IsAudioDeviceReady());
@@ -486,7 +486,7 @@ Value createVmAudioModule(VM& /*vm*/) {
         })};
 
     // audio.setMasterVolume(volume)
-    module->entries["setMasterVolume"] = Value{std::make_shared<VmNativeFunction>("setMasterVolume", 1,
+    module->entries["setMasterVolume"] = Value{makeRef<VmNativeFunction>("setMasterVolume", 1,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("audio.setMasterVolume() takes 1 argument (volume).");
@@ -503,11 +503,11 @@ Value createVmAudioModule(VM& /*vm*/) {
         })};
 
     // audio.loadSound(path) -> sound object
-    module->entries["loadSound"] = Value{std::make_shared<VmNativeFunction>("loadSound", 1,
+    module->entries["loadSound"] = Value{makeRef<VmNativeFunction>("loadSound", 1,
         [](VM&, const std::vector<Value>& args) -> Value {
-            if (args.size() != 1 || !std::holds_alternative<std::string>(args[0]))
+            if (args.size() != 1 || !args[0].isString())
                 throw std::runtime_error("audio.loadSound() takes 1 string argument (path).");
-            const std::string& path = std::get<std::string>(args[0]);
+            const std::string& path = args[0].asString();
 #ifdef HAVE_RAYLIB
             auto handle = std::make_shared<VmSoundHandle>();
             handle->sound = LoadSound(path.c_str());
@@ -531,11 +531,11 @@ Value createVmAudioModule(VM& /*vm*/) {
         })};
 
     // audio.loadMusic(path) -> music stream object
-    module->entries["loadMusic"] = Value{std::make_shared<VmNativeFunction>("loadMusic", 1,
+    module->entries["loadMusic"] = Value{makeRef<VmNativeFunction>("loadMusic", 1,
         [](VM&, const std::vector<Value>& args) -> Value {
-            if (args.size() != 1 || !std::holds_alternative<std::string>(args[0]))
+            if (args.size() != 1 || !args[0].isString())
                 throw std::runtime_error("audio.loadMusic() takes 1 string argument (path).");
-            const std::string& path = std::get<std::string>(args[0]);
+            const std::string& path = args[0].asString();
 #ifdef HAVE_RAYLIB
             auto handle = std::make_shared<VmMusicHandle>();
             handle->music = LoadMusicStream(path.c_str());
@@ -110,21 +110,21 @@ static Value vmBuildImageObject(std::shared_ptr<VmImageHandle> handle);
 
 #ifdef HAVE_RAYLIB
 static Value vmBuildImageObject(std::shared_ptr<VmImageHandle> handle) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
-    obj->entries["getWidth"] = Value{std::make_shared<VmNativeFunction>("getWidth", 0,
+    obj->entries["getWidth"] = Value{makeRef<VmNativeFunction>("getWidth", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (!handle->loaded) return 0.0;
             return static_cast<double>(handle->image.width);
         })};
 
-    obj->entries["getHeight"] = Value{std::make_shared<VmNativeFunction>("getHeight", 0,
+    obj->entries["getHeight"] = Value{makeRef<VmNativeFunction>("getHeight", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (!handle->loaded) return 0.0;
             return static_cast<double>(handle->image.height);
         })};
 
-    obj->entries["resize"] = Value{std::make_shared<VmNativeFunction>("resize", 2,
+    obj->entries["resize"] = Value{makeRef<VmNativeFunction>("resize", 2,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 2)
                 throw std::runtime_error("image.resize() takes 2 arguments (width, height).");
@@ -138,7 +138,7 @@ static Value vmBuildImageObject(std::shared_ptr<VmImageHandle> handle) {
             return vmBuildImageObject(newHandle);
         })};
 
-    obj->entries["crop"] = Value{std::make_shared<VmNativeFunction>("crop", 4,
+    obj->entries["crop"] = Value{makeRef<VmNativeFunction>("crop", 4,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 4)
                 throw std::runtime_error("image.crop() takes 4 arguments (x, y, width, height).");
@@ -156,7 +156,7 @@ static Value vmBuildImageObject(std::shared_ptr<VmImageHandle> handle) {
             return vmBuildImageObject(newHandle);
         })};
 
-    obj->entries["rotate"] = Value{std::make_shared<VmNativeFunction>("rotate", 1,
+    obj->entries["rotate"] = Value{makeRef<VmNativeFunction>("rotate", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("image.rotate() takes 1 argument (degrees).");
@@ -168,7 +168,7 @@ static Value vmBuildImageObject(std::shared_ptr<VmImageHandle> handle) {
             return vmBuildImageObject(newHandle);
         })};
 
-    obj->entries["flipHorizontal"] = Value{std::make_shared<VmNativeFunction>("flipHorizontal", 0,
+    obj->entries["flipHorizontal"] = Value{makeRef<VmNativeFunction>("flipHorizontal", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (!handle->loaded)
                 throw std::runtime_error("image.flipHorizontal(): image is not loaded.");
@@ -179,7 +179,7 @@ static Value vmBuildImageObject(std::shared_ptr<VmImageHandle> handle) {
             return vmBuildImageObject(newHandle);
         })};
 
-    obj->entries["flipVertical"] = Value{std::make_shared<VmNativeFunction>("flipVertical", 0,
+    obj->entries["flipVertical"] = Value{makeRef<VmNativeFunction>("flipVertical", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (!handle->loaded)
                 throw std::runtime_error("image.flipVertical(): image is not loaded.");
@@ -190,7 +190,7 @@ static Value vmBuildImageObject(std::shared_ptr<VmImageHandle> handle) {
             return vmBuildImageObject(newHandle);
         })};
 
-    obj->entries["blur"] = Value{std::make_shared<VmNativeFunction>("blur", 1,
+    obj->entries["blur"] = Value{makeRef<VmNativeFunction>("blur", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("image.blur() takes 1 argument (blurSize).");
@@ -202,16 +202,16 @@ static Value vmBuildImageObject(std::shared_ptr<VmImageHandle> handle) {
             return vmBuildImageObject(newHandle);
         })};
 
-    obj->entries["save"] = Value{std::make_shared<VmNativeFunction>("save", 1,
+    obj->entries["save"] = Value{makeRef<VmNativeFunction>("save", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
-            if (args.size() != 1 || !std::holds_alternative<std::string>(args[0]))
+            if (args.size() != 1 || !args[0].isString())
                 throw std::runtime_error("image.save() takes 1 string argument (path).");
             if (!handle->loaded) throw std::runtime_error("image.save(): image is not loaded.");
-            ExportImage(handle->image, std::get<std::string>(args[0]).c_str());
+            ExportImage(handle->image, args[0].asString().c_str());
             return Nil{};
         })};
 
-    obj->entries["unload"] = Value{std::make_shared<VmNativeFunction>("unload", 0,
+    obj->entries["unload"] = Value{makeRef<VmNativeFunction>("unload", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (handle->loaded) {
                 UnloadImage(handle->image);
@@ -226,21 +226,21 @@ static Value vmBuildImageObject(std::shared_ptr<VmImageHandle> handle) {
 #else  // !HAVE_RAYLIB — stb_image-backed implementation
 
 static Value vmBuildImageObject(std::shared_ptr<VmImageHandle> handle) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
-    obj->entries["getWidth"] = Value{std::make_shared<VmNativeFunction>("getWidth", 0,
+    obj->entries["getWidth"] = Value{makeRef<VmNativeFunction>("getWidth", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (!handle->loaded) return 0.0;
             return static_cast<double>(handle->width);
         })};
 
-    obj->entries["getHeight"] = Value{std::make_shared<VmNativeFunction>("getHeight", 0,
+    obj->entries["getHeight"] = Value{makeRef<VmNativeFunction>("getHeight", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (!handle->loaded) return 0.0;
             return static_cast<double>(handle->height);
         })};
 
-    obj->entries["resize"] = Value{std::make_shared<VmNativeFunction>("resize", 2,
+    obj->entries["resize"] = Value{makeRef<VmNativeFunction>("resize", 2,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 2)
                 throw std::runtime_error("image.resize() takes 2 arguments (width, height).");
@@ -262,7 +262,7 @@ static Value vmBuildImageObject(std::shared_ptr<VmImageHandle> handle) {
             return vmBuildImageObject(newHandle);
         })};
 
-    obj->entries["crop"] = Value{std::make_shared<VmNativeFunction>("crop", 4,
+    obj->entries["crop"] = Value{makeRef<VmNativeFunction>("crop", 4,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 4)
                 throw std::runtime_error("image.crop() takes 4 arguments (x, y, width, height).");
@@ -291,7 +291,7 @@ static Value vmBuildImageObject(std::shared_ptr<VmImageHandle> handle) {
             return vmBuildImageObject(newHandle);
         })};
 
-    obj->entries["rotate"] = Value{std::make_shared<VmNativeFunction>("rotate", 1,
+    obj->entries["rotate"] = Value{makeRef<VmNativeFunction>("rotate", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("image.rotate() takes 1 argument (degrees).");
@@ -313,7 +313,7 @@ static Value vmBuildImageObject(std::shared_ptr<VmImageHandle> handle) {
             return vmBuildImageObject(newHandle);
         })};
 
-    obj->entries["flipHorizontal"] = Value{std::make_shared<VmNativeFunction>("flipHorizontal", 0,
+    obj->entries["flipHorizontal"] = Value{makeRef<VmNativeFunction>("flipHorizontal", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (!handle->loaded)
                 throw std::runtime_error("image.flipHorizontal(): image is not loaded.");
@@ -337,7 +337,7 @@ static Value vmBuildImageObject(std::shared_ptr<VmImageHandle> handle) {
             return vmBuildImageObject(newHandle);
         })};
 
-    obj->entries["flipVertical"] = Value{std::make_shared<VmNativeFunction>("flipVertical", 0,
+    obj->entries["flipVertical"] = Value{makeRef<VmNativeFunction>("flipVertical", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             if (!handle->loaded)
                 throw std::runtime_error("image.flipVertical(): image is not loaded.");
@@ -358,7 +358,7 @@ static Value vmBuildImageObject(std::shared_ptr<VmImageHandle> handle) {
             return vmBuildImageObject(newHandle);
         })};
 
-    obj->entries["blur"] = Value{std::make_shared<VmNativeFunction>("blur", 1,
+    obj->entries["blur"] = Value{makeRef<VmNativeFunction>("blur", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("image.blur() takes 1 argument (blurSize).");
@@ -374,17 +374,17 @@ static Value vmBuildImageObject(std::shared_ptr<VmImageHandle> handle) {
             return vmBuildImageObject(newHandle);
         })};
 
-    obj->entries["save"] = Value{std::make_shared<VmNativeFunction>("save", 1,
+    obj->entries["save"] = Value{makeRef<VmNativeFunction>("save", 1,
         [handle](VM&, const std::vector<Value>& args) -> Value {
-            if (args.size() != 1 || !std::holds_alternative<std::string>(args[0]))
+            if (args.size() != 1 || !args[0].isString())
                 throw std::runtime_error("image.save() takes 1 string argument (path).");
             if (!handle->loaded) throw std::runtime_error("image.save(): image is not loaded.");
-            vmSaveImageToFile(std::get<std::string>(args[0]),
+            vmSaveImageToFile(args[0].asString(),
                               handle->pixels.data(), handle->width, handle->height, handle->channels);
             return Nil{};
         })};
 
-    obj->entries["unload"] = Value{std::make_shared<VmNativeFunction>("unload", 0,
+    obj->entries["unload"] = Value{makeRef<VmNativeFunction>("unload", 0,
         [handle](VM&, const std::vector<Value>&) -> Value {
             handle->pixels.clear();
             handle->pixels.shrink_to_fit();
@@ -400,14 +400,14 @@ static Value vmBuildImageObject(std::shared_ptr<VmImageHandle> handle) {
 // Build the top-level image module Map (VM version)
 // ---------------------------------------------------------------------------
 Value createVmImageModule(VM& /*vm*/) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // image.load(path) -> image object
-    module->entries["load"] = Value{std::make_shared<VmNativeFunction>("load", 1,
+    module->entries["load"] = Value{makeRef<VmNativeFunction>("load", 1,
         [](VM&, const std::vector<Value>& args) -> Value {
-            if (args.size() != 1 || !std::holds_alternative<std::string>(args[0]))
+            if (args.size() != 1 || !args[0].isString())
                 throw std::runtime_error("image.load() takes 1 string argument (path).");
-            const std::string& path = std::get<std::string>(args[0]);
+            const std::string& path = args[0].asString();
 #ifdef HAVE_RAYLIB
             auto handle = std::make_shared<VmImageHandle>();
             handle->image = LoadImage(path.c_str());
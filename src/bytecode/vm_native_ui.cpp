@@ -31,7 +31,7 @@ struct VmUiPanel {
 // ---------------------------------------------------------------------------
 
 static Value vmMakeColorValue(int r, int g, int b, int a = 255) {
-    auto m = std::make_shared<Map>();
+    auto m = makeRef<Map>();
     m->entries["r"] = static_cast<double>(r);
     m->entries["g"] = static_cast<double>(g);
     m->entries["b"] = static_cast<double>(b);
@@ -41,14 +41,14 @@ static Value vmMakeColorValue(int r, int g, int b, int a = 255) {
 
 #ifdef HAVE_RAYLIB
 static ::Color vmExtractRaylibColor(const Value& v) {
-    if (!std::holds_alternative<std::shared_ptr<Map>>(v)) {
+    if (!v.isMap()) {
         throw std::runtime_error("Expected a color value from ui.color().");
     }
-    auto m = std::get<std::shared_ptr<Map>>(v);
+    auto m = v.asMap();
     auto getChannel = [&](const std::string& key, int defaultValue) -> unsigned char {
         auto it = m->entries.find(key);
-        if (it != m->entries.end() && std::holds_alternative<double>(it->second)) {
-            return static_cast<unsigned char>(std::get<double>(it->second));
+        if (it != m->entries.end() && it->second.isNumber()) {
+            return static_cast<unsigned char>(it->second.asNumber());
         }
         return static_cast<unsigned char>(defaultValue);
     };
@@ -61,9 +61,9 @@ static ::Color vmExtractRaylibColor(const Value& v) {
 // ---------------------------------------------------------------------------
 
 static Value vmBuildPanelObject(std::shared_ptr<VmUiPanel> panel) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
-    obj->entries["begin"] = Value{std::make_shared<VmNativeFunction>("begin", 0,
+    obj->entries["begin"] = Value{makeRef<VmNativeFunction>("begin", 0,
         [panel](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             BeginScissorMode(panel->x, panel->y, panel->width, panel->height);
@@ -71,7 +71,7 @@ static Value vmBuildPanelObject(std::shared_ptr<VmUiPanel> panel) {
             return Nil{};
         })};
 
-    obj->entries["end"] = Value{std::make_shared<VmNativeFunction>("end", 0,
+    obj->entries["end"] = Value{makeRef<VmNativeFunction>("end", 0,
         [](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             EndScissorMode();
@@ -79,9 +79,9 @@ static Value vmBuildPanelObject(std::shared_ptr<VmUiPanel> panel) {
             return Nil{};
         })};
 
-    obj->entries["getMousePosition"] = Value{std::make_shared<VmNativeFunction>("getMousePosition", 0,
+    obj->entries["getMousePosition"] = Value{makeRef<VmNativeFunction>("getMousePosition", 0,
         [panel](VM&, const std::vector<Value>&) -> Value {
-            auto m = std::make_shared<Map>();
+            auto m = makeRef<Map>();
 #ifdef HAVE_RAYLIB
             ::Vector2 pos = GetMousePosition();
             m->entries["x"] = static_cast<double>(pos.x - panel->x);
@@ -93,7 +93,7 @@ static Value vmBuildPanelObject(std::shared_ptr<VmUiPanel> panel) {
             return Value{m};
         })};
 
-    obj->entries["containsMouse"] = Value{std::make_shared<VmNativeFunction>("containsMouse", 0,
+    obj->entries["containsMouse"] = Value{makeRef<VmNativeFunction>("containsMouse", 0,
         [panel](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             ::Vector2 pos = GetMousePosition();
@@ -106,7 +106,7 @@ static Value vmBuildPanelObject(std::shared_ptr<VmUiPanel> panel) {
 #endif
         })};
 
-    obj->entries["drawText"] = Value{std::make_shared<VmNativeFunction>("drawText", 5,
+    obj->entries["drawText"] = Value{makeRef<VmNativeFunction>("drawText", 5,
         [panel](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 5) {
                 throw std::runtime_error(
@@ -115,8 +115,8 @@ static Value vmBuildPanelObject(std::shared_ptr<VmUiPanel> panel) {
 #ifdef HAVE_RAYLIB
             int x = static_cast<int>(asNumber(args[0])) + panel->x;
             int y = static_cast<int>(asNumber(args[1])) + panel->y;
-            std::string text = std::holds_alternative<std::string>(args[2])
-                                   ? std::get<std::string>(args[2])
+            std::string text = args[2].isString()
+                                   ? args[2].asString()
                                    : valueToString(args[2]);
             int fontSize = static_cast<int>(asNumber(args[3]));
             ::Color color = vmExtractRaylibColor(args[4]);
@@ -127,7 +127,7 @@ static Value vmBuildPanelObject(std::shared_ptr<VmUiPanel> panel) {
             return Nil{};
         })};
 
-    obj->entries["fillRect"] = Value{std::make_shared<VmNativeFunction>("fillRect", 5,
+    obj->entries["fillRect"] = Value{makeRef<VmNativeFunction>("fillRect", 5,
         [panel](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 5) {
                 throw std::runtime_error(
@@ -146,7 +146,7 @@ static Value vmBuildPanelObject(std::shared_ptr<VmUiPanel> panel) {
             return Nil{};
         })};
 
-    obj->entries["drawRect"] = Value{std::make_shared<VmNativeFunction>("drawRect", 5,
+    obj->entries["drawRect"] = Value{makeRef<VmNativeFunction>("drawRect", 5,
         [panel](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 5) {
                 throw std::runtime_error(
@@ -165,7 +165,7 @@ static Value vmBuildPanelObject(std::shared_ptr<VmUiPanel> panel) {
             return Nil{};
         })};
 
-    obj->entries["drawLine"] = Value{std::make_shared<VmNativeFunction>("drawLine", 6,
+    obj->entries["drawLine"] = Value{makeRef<VmNativeFunction>("drawLine", 6,
         [panel](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 6) {
                 throw std::runtime_error(
@@ -186,7 +186,7 @@ static Value vmBuildPanelObject(std::shared_ptr<VmUiPanel> panel) {
             return Nil{};
         })};
 
-    obj->entries["drawCircle"] = Value{std::make_shared<VmNativeFunction>("drawCircle", 4,
+    obj->entries["drawCircle"] = Value{makeRef<VmNativeFunction>("drawCircle", 4,
         [panel](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 4) {
                 throw std::runtime_error(
@@ -204,7 +204,7 @@ static Value vmBuildPanelObject(std::shared_ptr<VmUiPanel> panel) {
             return Nil{};
         })};
 
-    obj->entries["drawCircleLines"] = Value{std::make_shared<VmNativeFunction>("drawCircleLines", 4,
+    obj->entries["drawCircleLines"] = Value{makeRef<VmNativeFunction>("drawCircleLines", 4,
         [panel](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 4) {
                 throw std::runtime_error(
@@ -222,7 +222,7 @@ static Value vmBuildPanelObject(std::shared_ptr<VmUiPanel> panel) {
             return Nil{};
         })};
 
-    obj->entries["fillRectRounded"] = Value{std::make_shared<VmNativeFunction>("fillRectRounded", 6,
+    obj->entries["fillRectRounded"] = Value{makeRef<VmNativeFunction>("fillRectRounded", 6,
         [panel](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 6) {
                 throw std::runtime_error(
@@ -242,7 +242,7 @@ static Value vmBuildPanelObject(std::shared_ptr<VmUiPanel> panel) {
             return Nil{};
         })};
 
-    obj->entries["drawRectRounded"] = Value{std::make_shared<VmNativeFunction>("drawRectRounded", 6,
+    obj->entries["drawRectRounded"] = Value{makeRef<VmNativeFunction>("drawRectRounded", 6,
         [panel](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 6) {
                 throw std::runtime_error(
@@ -262,15 +262,15 @@ static Value vmBuildPanelObject(std::shared_ptr<VmUiPanel> panel) {
             return Nil{};
         })};
 
-    obj->entries["measureText"] = Value{std::make_shared<VmNativeFunction>("measureText", 2,
+    obj->entries["measureText"] = Value{makeRef<VmNativeFunction>("measureText", 2,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 2) {
                 throw std::runtime_error(
                     "panel.measureText() takes 2 arguments (text, fontSize).");
             }
 #ifdef HAVE_RAYLIB
-            std::string text = std::holds_alternative<std::string>(args[0])
-                                   ? std::get<std::string>(args[0])
+            std::string text = args[0].isString()
+                                   ? args[0].asString()
                                    : valueToString(args[0]);
             int fontSize = static_cast<int>(asNumber(args[1]));
             return static_cast<double>(MeasureText(text.c_str(), fontSize));
@@ -279,7 +279,7 @@ static Value vmBuildPanelObject(std::shared_ptr<VmUiPanel> panel) {
 #endif
         })};
 
-    obj->entries["drawTriangle"] = Value{std::make_shared<VmNativeFunction>("drawTriangle", 7,
+    obj->entries["drawTriangle"] = Value{makeRef<VmNativeFunction>("drawTriangle", 7,
         [panel](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 7) {
                 throw std::runtime_error(
@@ -300,7 +300,7 @@ static Value vmBuildPanelObject(std::shared_ptr<VmUiPanel> panel) {
             return Nil{};
         })};
 
-    obj->entries["drawTriangleLines"] = Value{std::make_shared<VmNativeFunction>("drawTriangleLines", 7,
+    obj->entries["drawTriangleLines"] = Value{makeRef<VmNativeFunction>("drawTriangleLines", 7,
         [panel](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 7) {
                 throw std::runtime_error(
@@ -321,7 +321,7 @@ static Value vmBuildPanelObject(std::shared_ptr<VmUiPanel> panel) {
             return Nil{};
         })};
 
-    obj->entries["fillRectGradientV"] = Value{std::make_shared<VmNativeFunction>("fillRectGradientV", 6,
+    obj->entries["fillRectGradientV"] = Value{makeRef<VmNativeFunction>("fillRectGradientV", 6,
         [panel](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 6) {
                 throw std::runtime_error(
@@ -341,7 +341,7 @@ static Value vmBuildPanelObject(std::shared_ptr<VmUiPanel> panel) {
             return Nil{};
         })};
 
-    obj->entries["fillRectGradientH"] = Value{std::make_shared<VmNativeFunction>("fillRectGradientH", 6,
+    obj->entries["fillRectGradientH"] = Value{makeRef<VmNativeFunction>("fillRectGradientH", 6,
         [panel](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 6) {
                 throw std::runtime_error(
@@ -369,9 +369,9 @@ static Value vmBuildPanelObject(std::shared_ptr<VmUiPanel> panel) {
 // ---------------------------------------------------------------------------
 
 static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
-    obj->entries["isOpen"] = Value{std::make_shared<VmNativeFunction>("isOpen", 0,
+    obj->entries["isOpen"] = Value{makeRef<VmNativeFunction>("isOpen", 0,
         [win](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             if (win->open) {
@@ -381,7 +381,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return static_cast<bool>(win->open);
         })};
 
-    obj->entries["close"] = Value{std::make_shared<VmNativeFunction>("close", 0,
+    obj->entries["close"] = Value{makeRef<VmNativeFunction>("close", 0,
         [win](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             if (win->open) {
@@ -392,7 +392,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Nil{};
         })};
 
-    obj->entries["beginDrawing"] = Value{std::make_shared<VmNativeFunction>("beginDrawing", 0,
+    obj->entries["beginDrawing"] = Value{makeRef<VmNativeFunction>("beginDrawing", 0,
         [](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             BeginDrawing();
@@ -402,7 +402,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Nil{};
         })};
 
-    obj->entries["endDrawing"] = Value{std::make_shared<VmNativeFunction>("endDrawing", 0,
+    obj->entries["endDrawing"] = Value{makeRef<VmNativeFunction>("endDrawing", 0,
         [](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             EndDrawing();
@@ -412,7 +412,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Nil{};
         })};
 
-    obj->entries["clear"] = Value{std::make_shared<VmNativeFunction>("clear", 1,
+    obj->entries["clear"] = Value{makeRef<VmNativeFunction>("clear", 1,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1) {
                 throw std::runtime_error("win.clear() takes 1 argument.");
@@ -425,21 +425,21 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Nil{};
         })};
 
-    obj->entries["setTitle"] = Value{std::make_shared<VmNativeFunction>("setTitle", 1,
+    obj->entries["setTitle"] = Value{makeRef<VmNativeFunction>("setTitle", 1,
         [win](VM&, const std::vector<Value>& args) -> Value {
-            if (args.size() != 1 || !std::holds_alternative<std::string>(args[0])) {
+            if (args.size() != 1 || !args[0].isString()) {
                 throw std::runtime_error("win.setTitle() takes 1 string argument.");
             }
-            win->title = std::get<std::string>(args[0]);
+            win->title = args[0].asString();
 #ifdef HAVE_RAYLIB
             SetWindowTitle(win->title.c_str());
 #endif
             return Nil{};
         })};
 
-    obj->entries["getSize"] = Value{std::make_shared<VmNativeFunction>("getSize", 0,
+    obj->entries["getSize"] = Value{makeRef<VmNativeFunction>("getSize", 0,
         [win](VM&, const std::vector<Value>&) -> Value {
-            auto m = std::make_shared<Map>();
+            auto m = makeRef<Map>();
 #ifdef HAVE_RAYLIB
             win->width = GetScreenWidth();
             win->height = GetScreenHeight();
@@ -449,7 +449,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Value{m};
         })};
 
-    obj->entries["getFps"] = Value{std::make_shared<VmNativeFunction>("getFps", 0,
+    obj->entries["getFps"] = Value{makeRef<VmNativeFunction>("getFps", 0,
         [](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             return static_cast<double>(GetFPS());
@@ -458,7 +458,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
 #endif
         })};
 
-    obj->entries["setTargetFPS"] = Value{std::make_shared<VmNativeFunction>("setTargetFPS", 1,
+    obj->entries["setTargetFPS"] = Value{makeRef<VmNativeFunction>("setTargetFPS", 1,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1) {
                 throw std::runtime_error("win.setTargetFPS() takes 1 argument (fps).");
@@ -471,7 +471,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Nil{};
         })};
 
-    obj->entries["getFrameTime"] = Value{std::make_shared<VmNativeFunction>("getFrameTime", 0,
+    obj->entries["getFrameTime"] = Value{makeRef<VmNativeFunction>("getFrameTime", 0,
         [](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             return static_cast<double>(GetFrameTime());
@@ -480,7 +480,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
 #endif
         })};
 
-    obj->entries["drawText"] = Value{std::make_shared<VmNativeFunction>("drawText", 5,
+    obj->entries["drawText"] = Value{makeRef<VmNativeFunction>("drawText", 5,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 5) {
                 throw std::runtime_error("win.drawText() takes 5 arguments (x, y, text, fontSize, color).");
@@ -488,8 +488,8 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
 #ifdef HAVE_RAYLIB
             int x = static_cast<int>(asNumber(args[0]));
             int y = static_cast<int>(asNumber(args[1]));
-            std::string text = std::holds_alternative<std::string>(args[2])
-                                   ? std::get<std::string>(args[2])
+            std::string text = args[2].isString()
+                                   ? args[2].asString()
                                    : valueToString(args[2]);
             int fontSize = static_cast<int>(asNumber(args[3]));
             ::Color color = vmExtractRaylibColor(args[4]);
@@ -500,7 +500,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Nil{};
         })};
 
-    obj->entries["drawRect"] = Value{std::make_shared<VmNativeFunction>("drawRect", 5,
+    obj->entries["drawRect"] = Value{makeRef<VmNativeFunction>("drawRect", 5,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 5) {
                 throw std::runtime_error("win.drawRect() takes 5 arguments (x, y, width, height, color).");
@@ -518,7 +518,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Nil{};
         })};
 
-    obj->entries["fillRect"] = Value{std::make_shared<VmNativeFunction>("fillRect", 5,
+    obj->entries["fillRect"] = Value{makeRef<VmNativeFunction>("fillRect", 5,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 5) {
                 throw std::runtime_error("win.fillRect() takes 5 arguments (x, y, width, height, color).");
@@ -536,7 +536,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Nil{};
         })};
 
-    obj->entries["drawLine"] = Value{std::make_shared<VmNativeFunction>("drawLine", 6,
+    obj->entries["drawLine"] = Value{makeRef<VmNativeFunction>("drawLine", 6,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 6) {
                 throw std::runtime_error("win.drawLine() takes 6 arguments (x1, y1, x2, y2, thickness, color).");
@@ -556,7 +556,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Nil{};
         })};
 
-    obj->entries["drawCircle"] = Value{std::make_shared<VmNativeFunction>("drawCircle", 4,
+    obj->entries["drawCircle"] = Value{makeRef<VmNativeFunction>("drawCircle", 4,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 4) {
                 throw std::runtime_error("win.drawCircle() takes 4 arguments (x, y, radius, color).");
@@ -573,7 +573,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Nil{};
         })};
 
-    obj->entries["drawCircleLines"] = Value{std::make_shared<VmNativeFunction>("drawCircleLines", 4,
+    obj->entries["drawCircleLines"] = Value{makeRef<VmNativeFunction>("drawCircleLines", 4,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 4) {
                 throw std::runtime_error("win.drawCircleLines() takes 4 arguments (x, y, radius, color).");
@@ -590,7 +590,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Nil{};
         })};
 
-    obj->entries["fillRectRounded"] = Value{std::make_shared<VmNativeFunction>("fillRectRounded", 6,
+    obj->entries["fillRectRounded"] = Value{makeRef<VmNativeFunction>("fillRectRounded", 6,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 6) {
                 throw std::runtime_error("win.fillRectRounded() takes 6 arguments (x, y, width, height, roundness, color).");
@@ -609,7 +609,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Nil{};
         })};
 
-    obj->entries["drawRectRounded"] = Value{std::make_shared<VmNativeFunction>("drawRectRounded", 6,
+    obj->entries["drawRectRounded"] = Value{makeRef<VmNativeFunction>("drawRectRounded", 6,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 6) {
                 throw std::runtime_error("win.drawRectRounded() takes 6 arguments (x, y, width, height, roundness, color).");
@@ -628,14 +628,14 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Nil{};
         })};
 
-    obj->entries["measureText"] = Value{std::make_shared<VmNativeFunction>("measureText", 2,
+    obj->entries["measureText"] = Value{makeRef<VmNativeFunction>("measureText", 2,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 2) {
                 throw std::runtime_error("win.measureText() takes 2 arguments (text, fontSize).");
             }
 #ifdef HAVE_RAYLIB
-            std::string text = std::holds_alternative<std::string>(args[0])
-                                   ? std::get<std::string>(args[0])
+            std::string text = args[0].isString()
+                                   ? args[0].asString()
                                    : valueToString(args[0]);
             int fontSize = static_cast<int>(asNumber(args[1]));
             return static_cast<double>(MeasureText(text.c_str(), fontSize));
@@ -644,7 +644,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
 #endif
         })};
 
-    obj->entries["toggleFullscreen"] = Value{std::make_shared<VmNativeFunction>("toggleFullscreen", 0,
+    obj->entries["toggleFullscreen"] = Value{makeRef<VmNativeFunction>("toggleFullscreen", 0,
         [](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             ToggleFullscreen();
@@ -654,7 +654,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Nil{};
         })};
 
-    obj->entries["isWindowFocused"] = Value{std::make_shared<VmNativeFunction>("isWindowFocused", 0,
+    obj->entries["isWindowFocused"] = Value{makeRef<VmNativeFunction>("isWindowFocused", 0,
         [](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             return static_cast<bool>(IsWindowFocused());
@@ -663,7 +663,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
 #endif
         })};
 
-    obj->entries["setWindowMinSize"] = Value{std::make_shared<VmNativeFunction>("setWindowMinSize", 2,
+    obj->entries["setWindowMinSize"] = Value{makeRef<VmNativeFunction>("setWindowMinSize", 2,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 2) {
                 throw std::runtime_error("win.setWindowMinSize() takes 2 arguments (width, height).");
@@ -676,7 +676,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Nil{};
         })};
 
-    obj->entries["createPanel"] = Value{std::make_shared<VmNativeFunction>("createPanel", 4,
+    obj->entries["createPanel"] = Value{makeRef<VmNativeFunction>("createPanel", 4,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 4) {
                 throw std::runtime_error(
@@ -690,7 +690,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return vmBuildPanelObject(p);
         })};
 
-    obj->entries["drawTriangle"] = Value{std::make_shared<VmNativeFunction>("drawTriangle", 7,
+    obj->entries["drawTriangle"] = Value{makeRef<VmNativeFunction>("drawTriangle", 7,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 7) {
                 throw std::runtime_error(
@@ -711,7 +711,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Nil{};
         })};
 
-    obj->entries["drawTriangleLines"] = Value{std::make_shared<VmNativeFunction>("drawTriangleLines", 7,
+    obj->entries["drawTriangleLines"] = Value{makeRef<VmNativeFunction>("drawTriangleLines", 7,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 7) {
                 throw std::runtime_error(
@@ -732,7 +732,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Nil{};
         })};
 
-    obj->entries["fillRectGradientV"] = Value{std::make_shared<VmNativeFunction>("fillRectGradientV", 6,
+    obj->entries["fillRectGradientV"] = Value{makeRef<VmNativeFunction>("fillRectGradientV", 6,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 6) {
                 throw std::runtime_error(
@@ -752,7 +752,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Nil{};
         })};
 
-    obj->entries["fillRectGradientH"] = Value{std::make_shared<VmNativeFunction>("fillRectGradientH", 6,
+    obj->entries["fillRectGradientH"] = Value{makeRef<VmNativeFunction>("fillRectGradientH", 6,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 6) {
                 throw std::runtime_error(
@@ -772,7 +772,7 @@ static Value vmBuildWindowObject(std::shared_ptr<VmUiWindow> win) {
             return Nil{};
         })};
 
-    obj->entries["drawFPS"] = Value{std::make_shared<VmNativeFunction>("drawFPS", 2,
+    obj->entries["drawFPS"] = Value{makeRef<VmNativeFunction>("drawFPS", 2,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 2) {
                 throw std::runtime_error("win.drawFPS() takes 2 arguments (x, y).");
@@ -799,9 +799,9 @@ struct VmUiCamera2D {
 };
 
 static Value vmBuildCamera2DObject(std::shared_ptr<VmUiCamera2D> cam) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
-    obj->entries["setTarget"] = Value{std::make_shared<VmNativeFunction>("setTarget", 2,
+    obj->entries["setTarget"] = Value{makeRef<VmNativeFunction>("setTarget", 2,
         [cam](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 2) {
                 throw std::runtime_error("camera.setTarget() takes 2 arguments (x, y).");
@@ -811,7 +811,7 @@ static Value vmBuildCamera2DObject(std::shared_ptr<VmUiCamera2D> cam) {
             return Nil{};
         })};
 
-    obj->entries["setOffset"] = Value{std::make_shared<VmNativeFunction>("setOffset", 2,
+    obj->entries["setOffset"] = Value{makeRef<VmNativeFunction>("setOffset", 2,
         [cam](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 2) {
                 throw std::runtime_error("camera.setOffset() takes 2 arguments (x, y).");
@@ -821,7 +821,7 @@ static Value vmBuildCamera2DObject(std::shared_ptr<VmUiCamera2D> cam) {
             return Nil{};
         })};
 
-    obj->entries["setRotation"] = Value{std::make_shared<VmNativeFunction>("setRotation", 1,
+    obj->entries["setRotation"] = Value{makeRef<VmNativeFunction>("setRotation", 1,
         [cam](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1) {
                 throw std::runtime_error("camera.setRotation() takes 1 argument (degrees).");
@@ -831,7 +831,7 @@ static Value vmBuildCamera2DObject(std::shared_ptr<VmUiCamera2D> cam) {
             return Nil{};
         })};
 
-    obj->entries["setZoom"] = Value{std::make_shared<VmNativeFunction>("setZoom", 1,
+    obj->entries["setZoom"] = Value{makeRef<VmNativeFunction>("setZoom", 1,
         [cam](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1) {
                 throw std::runtime_error("camera.setZoom() takes 1 argument (zoom).");
@@ -840,7 +840,7 @@ static Value vmBuildCamera2DObject(std::shared_ptr<VmUiCamera2D> cam) {
             return Nil{};
         })};
 
-    obj->entries["beginMode"] = Value{std::make_shared<VmNativeFunction>("beginMode", 0,
+    obj->entries["beginMode"] = Value{makeRef<VmNativeFunction>("beginMode", 0,
         [cam](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             ::Camera2D c{};
@@ -855,7 +855,7 @@ static Value vmBuildCamera2DObject(std::shared_ptr<VmUiCamera2D> cam) {
             return Nil{};
         })};
 
-    obj->entries["endMode"] = Value{std::make_shared<VmNativeFunction>("endMode", 0,
+    obj->entries["endMode"] = Value{makeRef<VmNativeFunction>("endMode", 0,
         [](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             EndMode2D();
@@ -865,12 +865,12 @@ static Value vmBuildCamera2DObject(std::shared_ptr<VmUiCamera2D> cam) {
             return Nil{};
         })};
 
-    obj->entries["getWorldToScreen"] = Value{std::make_shared<VmNativeFunction>("getWorldToScreen", 2,
+    obj->entries["getWorldToScreen"] = Value{makeRef<VmNativeFunction>("getWorldToScreen", 2,
         [cam](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 2) {
                 throw std::runtime_error("camera.getWorldToScreen() takes 2 arguments (x, y).");
             }
-            auto m = std::make_shared<Map>();
+            auto m = makeRef<Map>();
 #ifdef HAVE_RAYLIB
             ::Camera2D c{};
             c.offset = {cam->offsetX, cam->offsetY};
@@ -889,12 +889,12 @@ static Value vmBuildCamera2DObject(std::shared_ptr<VmUiCamera2D> cam) {
             return Value{m};
         })};
 
-    obj->entries["getScreenToWorld"] = Value{std::make_shared<VmNativeFunction>("getScreenToWorld", 2,
+    obj->entries["getScreenToWorld"] = Value{makeRef<VmNativeFunction>("getScreenToWorld", 2,
         [cam](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 2) {
                 throw std::runtime_error("camera.getScreenToWorld() takes 2 arguments (x, y).");
             }
-            auto m = std::make_shared<Map>();
+            auto m = makeRef<Map>();
 #ifdef HAVE_RAYLIB
             ::Camera2D c{};
             c.offset = {cam->offsetX, cam->offsetY};
@@ -932,19 +932,19 @@ struct VmUiTexture {
 };
 
 static Value vmBuildTextureObject(std::shared_ptr<VmUiTexture> tex) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
-    obj->entries["getWidth"] = Value{std::make_shared<VmNativeFunction>("getWidth", 0,
+    obj->entries["getWidth"] = Value{makeRef<VmNativeFunction>("getWidth", 0,
         [tex](VM&, const std::vector<Value>&) -> Value {
             return tex->loaded ? static_cast<double>(tex->texture.width) : 0.0;
         })};
 
-    obj->entries["getHeight"] = Value{std::make_shared<VmNativeFunction>("getHeight", 0,
+    obj->entries["getHeight"] = Value{makeRef<VmNativeFunction>("getHeight", 0,
         [tex](VM&, const std::vector<Value>&) -> Value {
             return tex->loaded ? static_cast<double>(tex->texture.height) : 0.0;
         })};
 
-    obj->entries["draw"] = Value{std::make_shared<VmNativeFunction>("draw", 3,
+    obj->entries["draw"] = Value{makeRef<VmNativeFunction>("draw", 3,
         [tex](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 3) {
                 throw std::runtime_error("texture.draw() takes 3 arguments (x, y, tint).");
@@ -958,7 +958,7 @@ static Value vmBuildTextureObject(std::shared_ptr<VmUiTexture> tex) {
             return Nil{};
         })};
 
-    obj->entries["drawEx"] = Value{std::make_shared<VmNativeFunction>("drawEx", 5,
+    obj->entries["drawEx"] = Value{makeRef<VmNativeFunction>("drawEx", 5,
         [tex](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 5) {
                 throw std::runtime_error(
@@ -975,7 +975,7 @@ static Value vmBuildTextureObject(std::shared_ptr<VmUiTexture> tex) {
             return Nil{};
         })};
 
-    obj->entries["drawRec"] = Value{std::make_shared<VmNativeFunction>("drawRec", 4,
+    obj->entries["drawRec"] = Value{makeRef<VmNativeFunction>("drawRec", 4,
         [tex](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 4) {
                 throw std::runtime_error(
@@ -983,16 +983,16 @@ static Value vmBuildTextureObject(std::shared_ptr<VmUiTexture> tex) {
                     "srcRec and position are {x, y, width, height} and {x, y} maps respectively.");
             }
             if (tex->loaded) {
-                if (!std::holds_alternative<std::shared_ptr<Map>>(args[0]) ||
-                    !std::holds_alternative<std::shared_ptr<Map>>(args[1])) {
+                if (!args[0].isMap() ||
+                    !args[1].isMap()) {
                     throw std::runtime_error("texture.drawRec(): srcRec and position must be maps.");
                 }
-                auto srcMap = std::get<std::shared_ptr<Map>>(args[0]);
-                auto posMap = std::get<std::shared_ptr<Map>>(args[1]);
-                auto getNum = [](const std::shared_ptr<Map>& m, const std::string& k) -> float {
+                auto srcMap = args[0].asMap();
+                auto posMap = args[1].asMap();
+                auto getNum = [](const Ref<Map>& m, const std::string& k) -> float {
                     auto it = m->entries.find(k);
-                    return (it != m->entries.end() && std::holds_alternative<double>(it->second))
-                               ? static_cast<float>(std::get<double>(it->second))
+                    return (it != m->entries.end() && it->second.isNumber())
+                               ? static_cast<float>(it->second.asNumber())
                                : 0.0f;
                 };
                 ::Rectangle src{getNum(srcMap, "x"), getNum(srcMap, "y"),
@@ -1005,7 +1005,7 @@ static Value vmBuildTextureObject(std::shared_ptr<VmUiTexture> tex) {
             return Nil{};
         })};
 
-    obj->entries["unload"] = Value{std::make_shared<VmNativeFunction>("unload", 0,
+    obj->entries["unload"] = Value{makeRef<VmNativeFunction>("unload", 0,
         [tex](VM&, const std::vector<Value>&) -> Value {
             if (tex->loaded) {
                 UnloadTexture(tex->texture);
@@ -1025,10 +1025,10 @@ static Value vmNativeUiCreateWindow(VM& /*vm*/, const std::vector<Value>& args)
     if (args.size() != 3) {
         throw std::runtime_error("ui.createWindow() takes 3 arguments (title, width, height).");
     }
-    if (!std::holds_alternative<std::string>(args[0])) {
+    if (!args[0].isString()) {
         throw std::runtime_error("ui.createWindow(): title must be a string.");
     }
-    std::string title = std::get<std::string>(args[0]);
+    std::string title = args[0].asString();
     int width = static_cast<int>(asNumber(args[1]));
     int height = static_cast<int>(asNumber(args[2]));
     auto win = std::make_shared<VmUiWindow>();
@@ -1055,13 +1055,13 @@ static Value vmNativeUiCreateWindow(VM& /*vm*/, const std::vector<Value>& args)
 // Build the top-level ui module Map (VM version)
 // ---------------------------------------------------------------------------
 Value createVmUiModule(VM& /*vm*/) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     module->entries["createWindow"] =
-        Value{std::make_shared<VmNativeFunction>("createWindow", 3, vmNativeUiCreateWindow)};
+        Value{makeRef<VmNativeFunction>("createWindow", 3, vmNativeUiCreateWindow)};
 
     // Camera 2D
-    module->entries["createCamera2D"] = Value{std::make_shared<VmNativeFunction>("createCamera2D", 6,
+    module->entries["createCamera2D"] = Value{makeRef<VmNativeFunction>("createCamera2D", 6,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 6) {
                 throw std::runtime_error(
@@ -1078,13 +1078,13 @@ Value createVmUiModule(VM& /*vm*/) {
         })};
 
     // Texture loading
-    module->entries["loadTexture"] = Value{std::make_shared<VmNativeFunction>("loadTexture", 1,
+    module->entries["loadTexture"] = Value{makeRef<VmNativeFunction>("loadTexture", 1,
         [](VM&, const std::vector<Value>& args) -> Value {
-            if (args.size() != 1 || !std::holds_alternative<std::string>(args[0])) {
+            if (args.size() != 1 || !args[0].isString()) {
                 throw std::runtime_error("ui.loadTexture() takes 1 string argument (path).");
             }
 #ifdef HAVE_RAYLIB
-            const std::string& path = std::get<std::string>(args[0]);
+            const std::string& path = args[0].asString();
             auto tex = std::make_shared<VmUiTexture>();
             tex->texture = LoadTexture(path.c_str());
             tex->loaded = true;
@@ -1095,7 +1095,7 @@ Value createVmUiModule(VM& /*vm*/) {
         })};
 
 
-    module->entries["color"] = Value{std::make_shared<VmNativeFunction>("color", -1,
+    module->entries["color"] = Value{makeRef<VmNativeFunction>("color", -1,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() < 3 || args.size() > 4) {
                 throw std::runtime_error("ui.color() takes 3 or 4 arguments (r, g, b [, a]).");
@@ -1107,7 +1107,7 @@ Value createVmUiModule(VM& /*vm*/) {
             return vmMakeColorValue(r, g, b, a);
         })};
 
-    module->entries["keyDown"] = Value{std::make_shared<VmNativeFunction>("keyDown", 1,
+    module->entries["keyDown"] = Value{makeRef<VmNativeFunction>("keyDown", 1,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1) {
                 throw std::runtime_error("ui.keyDown() takes 1 argument.");
@@ -1121,7 +1121,7 @@ Value createVmUiModule(VM& /*vm*/) {
 #endif
         })};
 
-    module->entries["keyPressed"] = Value{std::make_shared<VmNativeFunction>("keyPressed", 1,
+    module->entries["keyPressed"] = Value{makeRef<VmNativeFunction>("keyPressed", 1,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1) {
                 throw std::runtime_error("ui.keyPressed() takes 1 argument.");
@@ -1135,7 +1135,7 @@ Value createVmUiModule(VM& /*vm*/) {
 #endif
         })};
 
-    module->entries["mouseDown"] = Value{std::make_shared<VmNativeFunction>("mouseDown", 1,
+    module->entries["mouseDown"] = Value{makeRef<VmNativeFunction>("mouseDown", 1,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1) {
                 throw std::runtime_error("ui.mouseDown() takes 1 argument.");
@@ -1149,7 +1149,7 @@ Value createVmUiModule(VM& /*vm*/) {
 #endif
         })};
 
-    module->entries["mousePressed"] = Value{std::make_shared<VmNativeFunction>("mousePressed", 1,
+    module->entries["mousePressed"] = Value{makeRef<VmNativeFunction>("mousePressed", 1,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1) {
                 throw std::runtime_error("ui.mousePressed() takes 1 argument.");
@@ -1163,11 +1163,11 @@ Value createVmUiModule(VM& /*vm*/) {
 #endif
         })};
 
-    module->entries["getMousePosition"] = Value{std::make_shared<VmNativeFunction>("getMousePosition", 0,
+    module->entries["getMousePosition"] = Value{makeRef<VmNativeFunction>("getMousePosition", 0,
         [](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             ::Vector2 pos = GetMousePosition();
-            auto m = std::make_shared<Map>();
+            auto m = makeRef<Map>();
             m->entries["x"] = static_cast<double>(pos.x);
             m->entries["y"] = static_cast<double>(pos.y);
             return Value{m};
@@ -1176,7 +1176,7 @@ Value createVmUiModule(VM& /*vm*/) {
 #endif
         })};
 
-    module->entries["getMouseWheelMove"] = Value{std::make_shared<VmNativeFunction>("getMouseWheelMove", 0,
+    module->entries["getMouseWheelMove"] = Value{makeRef<VmNativeFunction>("getMouseWheelMove", 0,
         [](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             return static_cast<double>(GetMouseWheelMove());
@@ -1185,7 +1185,7 @@ Value createVmUiModule(VM& /*vm*/) {
 #endif
         })};
 
-    module->entries["getCharPressed"] = Value{std::make_shared<VmNativeFunction>("getCharPressed", 0,
+    module->entries["getCharPressed"] = Value{makeRef<VmNativeFunction>("getCharPressed", 0,
         [](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             return static_cast<double>(GetCharPressed());
@@ -1194,7 +1194,7 @@ Value createVmUiModule(VM& /*vm*/) {
 #endif
         })};
 
-    module->entries["getTime"] = Value{std::make_shared<VmNativeFunction>("getTime", 0,
+    module->entries["getTime"] = Value{makeRef<VmNativeFunction>("getTime", 0,
         [](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             return static_cast<double>(GetTime());
@@ -1203,7 +1203,7 @@ Value createVmUiModule(VM& /*vm*/) {
 #endif
         })};
 
-    module->entries["keyReleased"] = Value{std::make_shared<VmNativeFunction>("keyReleased", 1,
+    module->entries["keyReleased"] = Value{makeRef<VmNativeFunction>("keyReleased", 1,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1) {
                 throw std::runtime_error("ui.keyReleased() takes 1 argument.");
@@ -1217,7 +1217,7 @@ Value createVmUiModule(VM& /*vm*/) {
 #endif
         })};
 
-    module->entries["mouseReleased"] = Value{std::make_shared<VmNativeFunction>("mouseReleased", 1,
+    module->entries["mouseReleased"] = Value{makeRef<VmNativeFunction>("mouseReleased", 1,
         [](VM&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1) {
                 throw std::runtime_error("ui.mouseReleased() takes 1 argument.");
@@ -1231,11 +1231,11 @@ Value createVmUiModule(VM& /*vm*/) {
 #endif
         })};
 
-    module->entries["getMouseDelta"] = Value{std::make_shared<VmNativeFunction>("getMouseDelta", 0,
+    module->entries["getMouseDelta"] = Value{makeRef<VmNativeFunction>("getMouseDelta", 0,
         [](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             ::Vector2 delta = GetMouseDelta();
-            auto m = std::make_shared<Map>();
+            auto m = makeRef<Map>();
             m->entries["x"] = static_cast<double>(delta.x);
             m->entries["y"] = static_cast<double>(delta.y);
             return Value{m};
@@ -1244,7 +1244,7 @@ Value createVmUiModule(VM& /*vm*/) {
 #endif
         })};
 
-    module->entries["hideCursor"] = Value{std::make_shared<VmNativeFunction>("hideCursor", 0,
+    module->entries["hideCursor"] = Value{makeRef<VmNativeFunction>("hideCursor", 0,
         [](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             HideCursor();
@@ -1254,7 +1254,7 @@ Value createVmUiModule(VM& /*vm*/) {
             return Nil{};
         })};
 
-    module->entries["showCursor"] = Value{std::make_shared<VmNativeFunction>("showCursor", 0,
+    module->entries["showCursor"] = Value{makeRef<VmNativeFunction>("showCursor", 0,
         [](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             ShowCursor();
@@ -1264,7 +1264,7 @@ Value createVmUiModule(VM& /*vm*/) {
             return Nil{};
         })};
 
-    module->entries["isCursorOnScreen"] = Value{std::make_shared<VmNativeFunction>("isCursorOnScreen", 0,
+    module->entries["isCursorOnScreen"] = Value{makeRef<VmNativeFunction>("isCursorOnScreen", 0,
         [](VM&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             return static_cast<bool>(IsCursorOnScreen());
@@ -1275,7 +1275,7 @@ Value createVmUiModule(VM& /*vm*/) {
 
     // Key constants sub-map
     {
-        auto keys = std::make_shared<Map>();
+        auto keys = makeRef<Map>();
 #ifdef HAVE_RAYLIB
         keys->entries["escape"] = static_cast<double>(KEY_ESCAPE);
         keys->entries["enter"] = static_cast<double>(KEY_ENTER);
@@ -1392,7 +1392,7 @@ Value createVmUiModule(VM& /*vm*/) {
 
     // Mouse button constants sub-map
     {
-        auto mouse = std::make_shared<Map>();
+        auto mouse = makeRef<Map>();
 #ifdef HAVE_RAYLIB
         mouse->entries["left"] = static_cast<double>(MOUSE_BUTTON_LEFT);
         mouse->entries["right"] = static_cast<double>(MOUSE_BUTTON_RIGHT);
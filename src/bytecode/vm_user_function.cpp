@@ -1,13 +1,25 @@
 #include "vm_user_function.hpp"
+#include "vm_class.hpp"
 #include "vm.hpp"
 
 namespace izi {
 
 Value VmUserFunction::call(VM& vm, const std::vector<Value>& arguments) {
-    // Execute the function's bytecode, passing arguments as initial local variable slots.
-    // Each argument is pushed onto the VM stack immediately after the call frame is
-    // created, so GET_LOCAL 0 == first parameter, GET_LOCAL 1 == second parameter, etc.
-    return vm.run(*chunk_, arguments, shared_from_this());
+    // Entry point for natives calling back into script code (map, filter, sort...);
+    // OpCode::CALL pushes a frame directly instead.  Arguments are pushed onto the
+    // VM stack immediately after the call frame is created, so GET_LOCAL 0 == first
+    // parameter, GET_LOCAL 1 == second parameter, etc.
+    return vm.run(getChunk(), arguments, Ref<VmUserFunction>(this));
+}
+
+void VmUserFunction::traceRefs(GcTracer& tracer) const {
+    for (const auto& cell : upvalues_) tracer.trace(cell);
+    tracer.trace(superclass_);
+}
+
+void VmUserFunction::clearRefs() {
+    upvalues_.clear();
+    superclass_.reset();
 }
 
 }  // namespace izi
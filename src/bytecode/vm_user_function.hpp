@@ -2,73 +2,96 @@
 
 #include "mv_callable.hpp"
 #include "chunk.hpp"
-#include <unordered_map>
 #include <memory>
 #include <string>
 #include <vector>
 
 namespace izi {
 
-class VmUserFunction : public VmCallable, public std::enable_shared_from_this<VmUserFunction> {
-     public:
-        VmUserFunction(std::string name, std::vector<std::string> params, std::shared_ptr<Chunk> functionChunk,
-                                     std::vector<std::string> localNames = {}, std::vector<std::string> captureNames = {})
-                : name_(std::move(name)),
-                    params_(std::move(params)),
-                    chunk_(std::move(functionChunk)),
-                    localNames_(std::move(localNames)),
-                    captureNames_(std::move(captureNames)) {}
-
-        VmUserFunction(std::string name, std::vector<std::string> params, std::shared_ptr<Chunk> functionChunk,
-                                     std::vector<std::string> localNames, std::vector<std::string> captureNames,
-                                     std::unordered_map<std::string, Value> capturedVars)
-                : name_(std::move(name)),
-                    params_(std::move(params)),
-                    chunk_(std::move(functionChunk)),
-                    localNames_(std::move(localNames)),
-                    captureNames_(std::move(captureNames)),
-                    capturedVars_(std::move(capturedVars)) {}
+class VmClass;
+
+// A variable captured by a closure.  While the declaring function is still
+// running the cell is "open" and refers to that function's stack slot; when
+// the slot goes out of scope the VM copies the value into `closed`.  Every
+// closure that captured the variable holds the same cell, so writes are shared.
+struct Upvalue : RefCounted, GcNode {
+    size_t slot;  // Absolute VM stack index while open
+    bool open = true;
+    Value closed;
+
+    explicit Upvalue(size_t stackSlot, bool isOpen = true, Value value = Value())
+        : slot(stackSlot), open(isOpen), closed(std::move(value)) {}
+
+    void traceRefs(GcTracer& tracer) const override {
+        if (!open) tracer.trace(closed);
+    }
+};
+
+// Compile-time description of where a closure's upvalue comes from: a local
+// slot of the enclosing function (isLocal) or one of the enclosing function's
+// own upvalues.
+struct UpvalueDesc {
+    uint8_t index;
+    bool isLocal;
+};
+
+class VmUserFunction : public VmCallable, public GcObject {
+   public:
+    VmUserFunction(std::string name, std::vector<std::string> params, std::shared_ptr<Chunk> functionChunk,
+                   std::vector<UpvalueDesc> upvalueDescs = {})
+        : name_(std::move(name)),
+          params_(std::move(params)),
+          chunk_(std::move(functionChunk)),
+          upvalueDescs_(std::move(upvalueDescs)) {}
 
     std::string name() const override { return name_; }
     int arity() const override { return static_cast<int>(params_.size()); }
 
     Value call(VM& vm, const std::vector<Value>& arguments) override;
+    bool isUserFunction() const override { return true; }
 
-    const Chunk& getChunk() const { return *chunk_; }
-    const std::vector<std::string>& params() const { return params_; }
-    const std::vector<std::string>& localNames() const { return localNames_; }
-    const std::vector<std::string>& captureNames() const { return captureNames_; }
-    
-    // Get captured variable value (returns nullptr if not found)
-    const Value* getCapturedVar(const std::string& name) const {
-        auto it = capturedVars_.find(name);
-        if (it != capturedVars_.end()) {
-            return &it->second;
+    const Chunk& getChunk() const {
+        if (chunk_->undecoded) [[unlikely]] {
+            chunk_->decode();
         }
-        return nullptr;
+        return *chunk_;
     }
+    // False until the first getChunk() of a function loaded from an image
+    bool decoded() const { return !chunk_->undecoded; }
+    const std::vector<std::string>& params() const { return params_; }
 
-    bool setCapturedVar(const std::string& name, const Value& value) {
-        auto it = capturedVars_.find(name);
-        if (it == capturedVars_.end()) {
-            return false;
-        }
-        it->second = value;
-        return true;
-    }
+    // Upvalue layout computed by the compiler (empty for functions that capture nothing)
+    const std::vector<UpvalueDesc>& upvalueDescs() const { return upvalueDescs_; }
 
-    std::shared_ptr<VmUserFunction> bindCaptured(std::unordered_map<std::string, Value> capturedVars) const {
-        return std::make_shared<VmUserFunction>(name_, params_, chunk_, localNames_, captureNames_,
-                                                std::move(capturedVars));
+    // Cells bound by OpCode::CLOSURE, indexed by GET_UPVALUE / SET_UPVALUE
+    size_t upvalueCount() const { return upvalues_.size(); }
+    Upvalue& upvalue(size_t index) const { return *upvalues_[index]; }
+    const Ref<Upvalue>& upvalueCell(size_t index) const { return upvalues_[index]; }
+
+    // Create a closure over this function prototype with the given cells
+    Ref<VmUserFunction> bindUpvalues(std::vector<Ref<Upvalue>> upvalues) const {
+        auto closure = makeRef<VmUserFunction>(name_, params_, chunk_, upvalueDescs_);
+        closure->upvalues_ = std::move(upvalues);
+        return closure;
     }
 
+    // The class `super` looks methods up in: set on a class's methods when the
+    // class statement links its superclass, and handed down to the closures
+    // created inside them, so reassigning the superclass's name later does not
+    // change it
+    const Ref<VmClass>& superclass() const { return superclass_; }
+    void setSuperclass(Ref<VmClass> super) { superclass_ = std::move(super); }
+
+    void traceRefs(GcTracer& tracer) const override;
+    void clearRefs() override;
+
    private:
     std::string name_;
     std::vector<std::string> params_;
     std::shared_ptr<Chunk> chunk_;
-    std::vector<std::string> localNames_;
-    std::vector<std::string> captureNames_;
-    std::unordered_map<std::string, Value> capturedVars_;
+    std::vector<UpvalueDesc> upvalueDescs_;
+    std::vector<Ref<Upvalue>> upvalues_;
+    Ref<VmClass> superclass_;
 };
 
 }  // namespace izi
@@ -6,9 +6,8 @@
 namespace izi {
 class Interpreter;  // forward
 
-class Callable {
+class Callable : public RefCounted {
    public:
-    virtual ~Callable() = default;
     virtual int arity() const = 0;
     virtual Value call(Interpreter& interp, const std::vector<Value>& args) = 0;
     virtual std::string name() const = 0;
@@ -1,5 +1,6 @@
 #include "common/cli.hpp"
 #include <iostream>
+#include <cstdlib>
 #include <cstring>
 
 namespace izi {
@@ -17,6 +18,7 @@ void CliOptions::printHelp() {
     std::cout << "  check <file>        Parse and analyze without executing\n";
     std::cout << "  compile <file>      Compile to native executable\n";
     std::cout << "  chunk <file>        Compile to bytecode chunk (.izb)\n";
+    std::cout << "  snapshot <file>     Run the top level and save the VM heap (.izs)\n";
     std::cout << "  test [pattern]      Run test files (searches for *.iz in tests/)\n";
     std::cout << "  repl                Start interactive REPL\n";
     std::cout << "  bench <file>        Run performance benchmark\n";
@@ -30,6 +32,8 @@ void CliOptions::printHelp() {
     std::cout << "  --debug             Enable debug/verbose output\n";
     std::cout << "  --optimize, -O      Enable optimizations (default: on)\n";
     std::cout << "  --no-optimize, -O0  Disable optimizations\n";
+    std::cout << "  --trace-out=<file>  Write a Chrome/Perfetto timeline of compiler phases,\n";
+    std::cout << "                      imports and calls\n";
     std::cout << "  --memory-stats      Show memory usage statistics (debug)\n";
     std::cout << "  --help, -h          Show this help message\n";
     std::cout << "  --version, -v       Show version information\n";
@@ -41,6 +45,7 @@ void CliOptions::printHelp() {
     std::cout << "  izi build app.iz    Check syntax without running\n";
     std::cout << "  izi compile app.iz  Compile to native executable\n";
     std::cout << "  izi chunk app.iz -o app.izb  Compile to bytecode chunk\n";
+    std::cout << "  izi snapshot app.iz -o app.izs  Save initialized state\n";
     std::cout << "  izi test            Run all tests\n";
     std::cout << "  izi repl            Start REPL explicitly\n";
     std::cout << "\n";
@@ -55,12 +60,27 @@ void CliOptions::printCommandHelp(Command cmd) {
             std::cout << "Usage: izi run [options] <file>\n\n";
             std::cout << "Options:\n";
             std::cout << "  --vm       Use bytecode VM\n";
+            std::cout << "  --jit      With --vm: compile hot functions to native code (x86-64 Linux)\n";
+            std::cout << "  --no-cache With --vm: do not read or write __izicache__/ bytecode\n";
+            std::cout << "  --profile[=hz]\n";
+            std::cout << "             Sample the call stack (default 1000 Hz); writes <script>.folded\n";
+            std::cout << "             for flamegraph tools and prints the hottest functions\n";
+            std::cout << "  --opstats[=file.json]\n";
+            std::cout << "             With --vm: count and time every opcode, per function and in\n";
+            std::cout << "             pairs; prints a table and optionally writes JSON\n";
+            std::cout << "  --snapshot <file.izs>\n";
+            std::cout << "             Restore a heap snapshot on the VM and call its main()\n";
+            std::cout << "             instead of running a source file\n";
             std::cout << "  --interp   Use tree-walker interpreter (default)\n";
+            std::cout << "  --closure  Use the tree-walker interpreter on closures compiled once from\n";
+            std::cout << "             the tree: faster, and runs everything the VM cannot compile\n";
             std::cout << "  --debug    Enable debug output\n";
             std::cout << "\n";
             std::cout << "Examples:\n";
             std::cout << "  izi run script.iz\n";
             std::cout << "  izi run --vm script.iz\n";
+            std::cout << "  izi run --profile=500 script.iz\n";
+            std::cout << "  izi run --snapshot app.izs [args...]\n";
             break;
 
         case Command::Build:
@@ -104,10 +124,13 @@ void CliOptions::printCommandHelp(Command cmd) {
             std::cout << "Options:\n";
             std::cout << "  -o <output>  Specify output executable name\n";
             std::cout << "  --debug      Include debug symbols\n";
+            std::cout << "  --bytecode   Embed the bytecode instead of translating it to C++\n";
+            std::cout << "               (faster to build; the program runs on the VM)\n";
             std::cout << "\n";
             std::cout << "Examples:\n";
             std::cout << "  izi compile app.iz\n";
             std::cout << "  izi compile app.iz -o myapp\n";
+            std::cout << "  izi compile --bytecode app.iz\n";
             std::cout << "  izi compile --debug app.iz\n";
             break;
 
@@ -132,6 +155,32 @@ void CliOptions::printCommandHelp(Command cmd) {
             std::cout << "  izi run --vm app.izb\n";
             break;
 
+        case Command::Snapshot:
+            std::cout << "izi snapshot - Save the VM heap after initialization (.izs)\n\n";
+            std::cout << "Usage: izi snapshot [options] <file> [-o <output>]\n\n";
+            std::cout << "Description:\n";
+            std::cout << "  Compiles the file, runs its top level (imports, lookup tables,\n";
+            std::cout << "  class and function definitions) on the VM and saves every\n";
+            std::cout << "  global with the objects it reaches.  `izi run --snapshot`\n";
+            std::cout << "  restores them without running that code again, then calls\n";
+            std::cout << "  main() (or main(args)) if the script defines it.\n";
+            std::cout << "\n";
+            std::cout << "  The whole top level runs at snapshot time, not only its\n";
+            std::cout << "  initializers: its output and other side effects happen once,\n";
+            std::cout << "  here, and the snapshot holds the globals as they were when it\n";
+            std::cout << "  finished.  Keep work meant for every run inside main().  Open\n";
+            std::cout << "  files, threads and other native resources are not saved.  A\n";
+            std::cout << "  top level that fails writes no snapshot.\n";
+            std::cout << "\n";
+            std::cout << "Options:\n";
+            std::cout << "  -o <output>  Specify output .izs file name\n";
+            std::cout << "  --debug      Show compilation details\n";
+            std::cout << "\n";
+            std::cout << "Examples:\n";
+            std::cout << "  izi snapshot app.iz -o app.izs\n";
+            std::cout << "  izi run --snapshot app.izs\n";
+            break;
+
         case Command::Test:
             std::cout << "izi test - Run test files\n\n";
             std::cout << "Usage: izi test [options] [pattern]\n\n";
@@ -259,6 +308,9 @@ CliOptions CliOptions::parse(int argc, char** argv) {
     } else if (firstArg == "chunk") {
         options.command = Command::Chunk;
         i++;
+    } else if (firstArg == "snapshot") {
+        options.command = Command::Snapshot;
+        i++;
     } else if (firstArg == "test") {
         options.command = Command::Test;
         i++;
@@ -288,6 +340,8 @@ CliOptions CliOptions::parse(int argc, char** argv) {
                 printCommandHelp(Command::Compile);
             } else if (helpCmd == "chunk") {
                 printCommandHelp(Command::Chunk);
+            } else if (helpCmd == "snapshot") {
+                printCommandHelp(Command::Snapshot);
             } else if (helpCmd == "test") {
                 printCommandHelp(Command::Test);
             } else if (helpCmd == "repl") {
@@ -321,6 +375,9 @@ CliOptions CliOptions::parse(int argc, char** argv) {
         if (arg == "--vm") {
             options.engine = Engine::VM;
             i++;
+        } else if (arg == "--closure" && options.command == Command::Run) {
+            options.engine = Engine::Closure;
+            i++;
         } else if (arg == "--interp") {
             options.engine = Engine::Interpreter;
             i++;
@@ -333,16 +390,55 @@ CliOptions CliOptions::parse(int argc, char** argv) {
         } else if (arg == "--no-optimize" || arg == "-O0") {
             options.optimize = false;
             i++;
+        } else if (arg.rfind("--trace-out=", 0) == 0 && arg.size() > 12) {
+            options.traceOut = arg.substr(12);
+            i++;
         } else if (arg == "--memory-stats") {
             options.memoryStats = true;
             i++;
+        } else if (arg == "--jit" && options.command == Command::Run) {
+            options.jit = true;
+            i++;
+        } else if (arg == "--no-cache" && options.command == Command::Run) {
+            options.cache = false;
+            i++;
+        } else if ((arg == "--profile" || arg.rfind("--profile=", 0) == 0) && options.command == Command::Run) {
+            options.profileHz = 1000;
+            if (arg.size() > 10) {
+                char* end = nullptr;
+                long hz = std::strtol(arg.c_str() + 10, &end, 10);
+                if (*end != '\0' || hz < 1 || hz > 100000) {
+                    std::cerr << "Error: --profile rate must be between 1 and 100000 Hz\n";
+                    std::exit(1);
+                }
+                options.profileHz = static_cast<int>(hz);
+            }
+            i++;
+        } else if ((arg == "--opstats" || arg.rfind("--opstats=", 0) == 0) && options.command == Command::Run) {
+            options.opStats = true;
+            if (arg.size() > 10) {
+                options.opStatsJson = arg.substr(10);
+            }
+            i++;
+        } else if (arg == "--snapshot" && options.command == Command::Run) {
+            if (i + 1 < argc) {
+                options.snapshot = argv[i + 1];
+                i += 2;
+            } else {
+                std::cerr << "Error: --snapshot option requires a snapshot file\n";
+                std::exit(1);
+            }
+        } else if (arg == "--bytecode" && options.command == Command::Compile) {
+            options.bytecode = true;
+            i++;
         } else if (arg == "--write" && options.command == Command::Fmt) {
             options.write = true;
             i++;
         } else if (arg == "--check" && options.command == Command::Fmt) {
             options.check = true;
             i++;
-        } else if (arg == "-o" && (options.command == Command::Compile || options.command == Command::Chunk)) {
+        } else if (arg == "-o" && (options.command == Command::Compile || options.command == Command::Chunk ||
+                                   options.command == Command::Snapshot)) {
             // Output file for compile or chunk command
             if (i + 1 < argc) {
                 options.output = argv[i + 1];
@@ -395,10 +491,10 @@ CliOptions CliOptions::parse(int argc, char** argv) {
             // This is a positional argument
             if (options.command == Command::Run || options.command == Command::Build ||
                 options.command == Command::Check || options.command == Command::Compile ||
-                options.command == Command::Chunk || options.command == Command::Bench ||
-                options.command == Command::Fmt) {
-                // These commands expect a filename
-                if (options.input.empty()) {
+                options.command == Command::Chunk || options.command == Command::Snapshot ||
+                options.command == Command::Bench || options.command == Command::Fmt) {
+                // These commands expect a filename (a snapshot replaces it for run)
+                if (options.input.empty() && options.snapshot.empty()) {
                     options.input = arg;
                 } else {
                     // For run command, additional arguments are passed to the script
@@ -419,8 +515,9 @@ CliOptions CliOptions::parse(int argc, char** argv) {
 
     // Validate command-specific requirements
     if (options.command == Command::Run || options.command == Command::Build || options.command == Command::Check ||
-        options.command == Command::Compile || options.command == Command::Chunk || options.command == Command::Bench) {
-        if (options.input.empty()) {
+        options.command == Command::Compile || options.command == Command::Chunk ||
+        options.command == Command::Snapshot || options.command == Command::Bench) {
+        if (options.input.empty() && options.snapshot.empty()) {
             // Map command to string for error message
             std::string cmdName;
             switch (options.command) {
@@ -439,6 +536,9 @@ CliOptions CliOptions::parse(int argc, char** argv) {
                 case Command::Chunk:
                     cmdName = "chunk";
                     break;
+                case Command::Snapshot:
+                    cmdName = "snapshot";
+                    break;
                 case Command::Bench:
                     cmdName = "bench";
                     break;
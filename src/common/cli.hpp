@@ -16,6 +16,7 @@ struct CliOptions {
         Check,  // Parse + analyze, no execution
         Compile,  // Compile to native executable
         Chunk,  // Compile to bytecode chunk (.izb)
+        Snapshot,  // Run the top level, save the VM heap (.izs)
         Test,  // Execute test files
         Repl,  // Interactive REPL mode
         Bench,  // Run benchmark
@@ -26,6 +27,7 @@ struct CliOptions {
 
     enum class Engine {
         Interpreter,  // Tree-walker interpreter
+        Closure,  // Tree-walker interpreter running closures compiled from the tree
         VM  // Bytecode VM
     };
 
@@ -34,10 +36,18 @@ struct CliOptions {
     bool debug = false;
     bool optimize = true;  // Enable optimizations by default
     bool memoryStats = false;  // Enable memory statistics tracking
+    bool jit = false;  // run --vm: compile hot chunks with the baseline JIT
+    bool cache = true;  // run --vm: reuse bytecode from __izicache__/
+    int profileHz = 0;  // run --profile[=hz]: sampling rate, 0 when not profiling
+    bool opStats = false;  // run --vm --opstats[=file]: per-opcode counts and times
+    std::string opStatsJson;  // run --opstats=<file>: also write them as JSON
+    std::string traceOut;  // --trace-out=<file>: Chrome trace-event timeline of the command
+    bool bytecode = false;  // compile: embed bytecode instead of translating it to C++
     bool write = false;   // fmt: write formatted output back to file in-place
     bool check = false;   // fmt: check if file needs formatting (exit 1 if yes)
     std::string input;  // Filename or inline code
     std::string output;  // Output filename for compile command
+    std::string snapshot;  // run: heap snapshot to start from instead of a source file
     std::vector<std::string> args;  // Additional arguments (e.g., test patterns)
 
     static CliOptions parse(int argc, char** argv);
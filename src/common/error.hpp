@@ -5,6 +5,8 @@
 #include <vector>
 #include <optional>
 
+#include "ref.hpp"
+
 namespace izi {
 
 // Forward declaration to avoid circular dependency with Value
@@ -22,10 +24,10 @@ struct StackFrame {
 };
 
 // Base Error class for composable, inspectable errors
-struct Error {
+struct Error : RefCounted {
     std::string message;
     std::string type;
-    std::shared_ptr<Error> cause;  // Error chaining
+    Ref<Error> cause;  // Error chaining
     std::vector<StackFrame> stackTrace;  // Preserved across async boundaries
 
     // Constructor without cause
@@ -33,7 +35,7 @@ struct Error {
         : message(std::move(msg)), type(std::move(errorType)), cause(nullptr) {}
 
     // Constructor with cause for error chaining
-    Error(std::string msg, std::string errorType, std::shared_ptr<Error> causedBy)
+    Error(std::string msg, std::string errorType, Ref<Error> causedBy)
         : message(std::move(msg)), type(std::move(errorType)), cause(std::move(causedBy)) {}
 
     virtual ~Error() = default;
@@ -77,14 +79,14 @@ struct Error {
 struct IOError : public Error {
     explicit IOError(std::string msg) : Error(std::move(msg), "IOError") {}
 
-    IOError(std::string msg, std::shared_ptr<Error> causedBy) : Error(std::move(msg), "IOError", std::move(causedBy)) {}
+    IOError(std::string msg, Ref<Error> causedBy) : Error(std::move(msg), "IOError", std::move(causedBy)) {}
 };
 
 // TypeError for type-related errors
 struct TypeError : public Error {
     explicit TypeError(std::string msg) : Error(std::move(msg), "TypeError") {}
 
-    TypeError(std::string msg, std::shared_ptr<Error> causedBy)
+    TypeError(std::string msg, Ref<Error> causedBy)
         : Error(std::move(msg), "TypeError", std::move(causedBy)) {}
 };
 
@@ -92,7 +94,7 @@ struct TypeError : public Error {
 struct ValueError : public Error {
     explicit ValueError(std::string msg) : Error(std::move(msg), "ValueError") {}
 
-    ValueError(std::string msg, std::shared_ptr<Error> causedBy)
+    ValueError(std::string msg, Ref<Error> causedBy)
         : Error(std::move(msg), "ValueError", std::move(causedBy)) {}
 };
 
@@ -0,0 +1,178 @@
+#include "common/gc.hpp"
+#include "common/value.hpp"
+#include "bytecode/mv_callable.hpp"
+#include "bytecode/vm_class.hpp"
+#include "interp/izi_class.hpp"
+#include <algorithm>
+#include <mutex>
+
+namespace izi {
+
+std::atomic<size_t> Gc::allocated_{0};
+size_t Gc::threshold_ = Gc::MIN_THRESHOLD;
+uint32_t Gc::collections_ = 0;
+std::atomic<int> Gc::threads_{0};
+
+namespace {
+
+// Registry of live GcObjects: an intrusive list so that linking and
+// unlinking are O(1).  Until thread_spawn starts a worker every object is
+// made and freed on this thread, so the mutex is only taken after that.
+std::mutex registryMutex;
+GcObject* registryHead = nullptr;
+size_t registrySize = 0;
+
+std::unique_lock<std::mutex> lockRegistry() {
+    if (RefCounted::threaded()) {
+        return std::unique_lock<std::mutex>(registryMutex);
+    }
+    return std::unique_lock<std::mutex>();
+}
+
+}  // namespace
+
+GcObject::GcObject() { Gc::link(this); }
+
+GcObject::~GcObject() { Gc::unlink(this); }
+
+void Gc::link(GcObject* object) {
+    auto lock = lockRegistry();
+    object->next_ = registryHead;
+    if (registryHead) {
+        registryHead->prev_ = object;
+    }
+    registryHead = object;
+    ++registrySize;
+    // Every writer holds the registry lock once there are threads
+    allocated_.store(allocated_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void Gc::unlink(GcObject* object) {
+    auto lock = lockRegistry();
+    if (object->prev_) {
+        object->prev_->next_ = object->next_;
+    } else {
+        registryHead = object->next_;
+    }
+    if (object->next_) {
+        object->next_->prev_ = object->prev_;
+    }
+    --registrySize;
+}
+
+size_t Gc::liveObjects() {
+    auto lock = lockRegistry();
+    return registrySize;
+}
+
+size_t GcTracer::nodeFor(const GcNode* node) {
+    if (node->collection_ != collection_) {
+        node->collection_ = collection_;
+        node->index_ = static_cast<uint32_t>(nodes_.size());
+        nodes_.push_back(Node{node});
+    }
+    return node->index_;
+}
+
+void GcTracer::reference(const RefCounted* object, const GcNode* node) {
+    if (keep_) {
+        keep_->push_back(Ref<RefCounted>(const_cast<RefCounted*>(object)));
+        return;
+    }
+    size_t index = nodeFor(node);
+    nodes_[index].refs = object->refCount();
+    ++nodes_[index].internal;
+    edges_.push_back(index);
+}
+
+void GcTracer::trace(const Value& value) {
+    switch (value.type_) {
+        case Value::Type::Array: trace(value.payload<Value::Type::Array>()); break;
+        case Value::Type::Map: trace(value.payload<Value::Type::Map>()); break;
+        case Value::Type::Set: trace(value.payload<Value::Type::Set>()); break;
+        case Value::Type::Instance: trace(value.payload<Value::Type::Instance>()); break;
+        case Value::Type::VmClass: trace(value.payload<Value::Type::VmClass>()); break;
+        case Value::Type::Callable: trace(value.payload<Value::Type::Callable>()); break;
+        case Value::Type::VmCallable: trace(value.payload<Value::Type::VmCallable>()); break;
+        default: break;  // Strings, errors, tasks and mutexes hold no cycles
+    }
+}
+
+void GcTracer::traceNode(size_t index) {
+    size_t first = edges_.size();
+    nodes_[index].node->traceRefs(*this);
+    nodes_[index].firstEdge = first;
+    nodes_[index].edgeCount = edges_.size() - first;
+}
+
+size_t Gc::collect() {
+    if (threads_.load(std::memory_order_acquire) > 0) {
+        return 0;
+    }
+
+    std::vector<GcObject*> garbage;
+    std::vector<Ref<RefCounted>> keep;
+    {
+        auto lock = lockRegistry();
+        GcTracer tracer;
+        tracer.collection_ = ++collections_;
+        tracer.nodes_.reserve(registrySize);
+        std::vector<GcObject*> objects;
+        objects.reserve(registrySize);
+        for (GcObject* object = registryHead; object; object = object->next_) {
+            tracer.nodeFor(object);
+            objects.push_back(object);
+        }
+
+        // Trace every registered object and every upvalue and environment
+        // found between them; nodes_ grows as new ones turn up
+        for (size_t i = 0; i < tracer.nodes_.size(); ++i) {
+            tracer.traceNode(i);
+        }
+
+        // Nodes referenced from outside the graph are roots
+        std::vector<size_t> pending;
+        for (size_t i = 0; i < tracer.nodes_.size(); ++i) {
+            GcTracer::Node& node = tracer.nodes_[i];
+            if (node.refs == 0 || node.internal < node.refs) {
+                node.reachable = true;
+                pending.push_back(i);
+            }
+        }
+        while (!pending.empty()) {
+            const GcTracer::Node& node = tracer.nodes_[pending.back()];
+            pending.pop_back();
+            for (size_t e = node.firstEdge; e < node.firstEdge + node.edgeCount; ++e) {
+                GcTracer::Node& next = tracer.nodes_[tracer.edges_[e]];
+                if (!next.reachable) {
+                    next.reachable = true;
+                    pending.push_back(tracer.edges_[e]);
+                }
+            }
+        }
+
+        // Hold every reference out of the garbage so that nothing in it is
+        // freed while clearRefs() runs
+        GcTracer keeper;
+        keeper.keep_ = &keep;
+        for (size_t i = 0; i < objects.size(); ++i) {
+            if (!tracer.nodes_[i].reachable) {
+                garbage.push_back(objects[i]);
+                objects[i]->traceRefs(keeper);
+            }
+        }
+
+        threshold_ = std::max(MIN_THRESHOLD, registrySize - garbage.size());
+        allocated_.store(0, std::memory_order_relaxed);
+    }
+
+    // Outside the lock: clearing drops references, and whatever that frees
+    // unlinks itself
+    for (GcObject* object : garbage) {
+        object->clearRefs();
+    }
+    keep.clear();
+    return garbage.size();
+}
+
+}  // namespace izi
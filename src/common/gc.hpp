@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "ref.hpp"
+
+namespace izi {
+
+class Value;
+class GcTracer;
+
+// Anything the cycle collector can look inside: it reports its outgoing
+// references to traceRefs().  Upvalue cells and shared environments are plain
+// nodes; containers that can close a cycle are GcObjects.  Every GcNode is
+// also RefCounted.
+class GcNode {
+   public:
+    virtual void traceRefs(GcTracer& tracer) const = 0;
+
+   protected:
+    ~GcNode() = default;
+
+   private:
+    friend class GcTracer;
+    // Position in the running collection's node table, valid while
+    // collection_ matches the collector's counter
+    mutable uint32_t collection_ = 0;
+    mutable uint32_t index_ = 0;
+};
+
+// A heap object that can be part of a reference cycle: arrays, maps, sets,
+// instances, closures, bound methods and classes.  Every GcObject is linked
+// into the collector's registry for its whole lifetime, and clearRefs() drops
+// the references it holds so that a garbage cycle falls apart.
+class GcObject : public GcNode {
+   public:
+    GcObject();
+    GcObject(const GcObject&) : GcObject() {}
+    GcObject& operator=(const GcObject&) { return *this; }
+    virtual ~GcObject();
+
+    virtual void clearRefs() = 0;
+
+   private:
+    friend class Gc;
+    GcObject* prev_ = nullptr;
+    GcObject* next_ = nullptr;
+};
+
+// Passed to traceRefs(); receives each Value and each Ref the node holds.
+// References to things that cannot hold further references (strings,
+// natives, errors) are ignored.
+class GcTracer {
+   public:
+    void trace(const Value& value);
+
+    template <typename T>
+    void trace(const Ref<T>& ref) {
+        if (const GcNode* node = asNode(ref.get())) {
+            reference(ref.get(), node);
+        }
+    }
+
+   private:
+    friend class Gc;
+
+    struct Node {
+        const GcNode* node;
+        size_t refs = 0;  // Reference count, 0 while only known from the registry
+        size_t internal = 0;  // References from other nodes
+        size_t firstEdge = 0;
+        size_t edgeCount = 0;
+        bool reachable = false;
+    };
+
+    uint32_t collection_ = 0;
+    std::vector<Node> nodes_;
+    std::vector<size_t> edges_;
+    std::vector<Ref<RefCounted>>* keep_ = nullptr;
+
+    template <typename T>
+    static const GcNode* asNode(const T* object) {
+        if constexpr (std::is_base_of_v<GcNode, T>) {
+            return object;
+        } else {
+            return dynamic_cast<const GcNode*>(object);
+        }
+    }
+
+    size_t nodeFor(const GcNode* node);
+    void traceNode(size_t index);
+    void reference(const RefCounted* object, const GcNode* node);
+};
+
+// Cycle collector for the reference-counted heap.
+//
+// Reference counting frees everything except cycles; Gc finds those.  A
+// collection traces every registered GcObject, together with the upvalues
+// and environments between them, and counts how many of each node's
+// references come from inside that graph.  A node with more references than
+// that is held from outside it (the VM stack, frames and globals, interpreter
+// environments, native code) and is a root.  Whatever the roots cannot reach
+// is garbage: its references are cleared and reference counting frees it.
+//
+// Collections happen at interpreter and VM safepoints (maybeCollect), once
+// the number of objects allocated since the last one reaches the number that
+// survived it, and never while thread_spawn workers are running.
+class Gc {
+   public:
+    // Allocations between collections never drop below this
+    static constexpr size_t MIN_THRESHOLD = 10000;
+
+    static void maybeCollect() {
+        if (allocated_.load(std::memory_order_relaxed) >= threshold_) [[unlikely]] {
+            collect();
+        }
+    }
+
+    // Collect now; returns the number of objects freed from cycles
+    static size_t collect();
+
+    // Registered objects currently alive
+    static size_t liveObjects();
+
+    // While a worker thread runs, collection is suspended
+    static void enterThread() { threads_.fetch_add(1, std::memory_order_acq_rel); }
+    static void exitThread() { threads_.fetch_sub(1, std::memory_order_acq_rel); }
+
+   private:
+    friend class GcObject;
+
+    static std::atomic<size_t> allocated_;
+    static size_t threshold_;
+    static uint32_t collections_;
+    static std::atomic<int> threads_;
+
+    static void link(GcObject* object);
+    static void unlink(GcObject* object);
+};
+
+}  // namespace izi
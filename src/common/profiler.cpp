@@ -0,0 +1,173 @@
+#include "common/profiler.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <unordered_set>
+#include <vector>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/time.h>
+#endif
+
+namespace izi {
+
+std::atomic<uint32_t> Profiler::ticks_{0};
+std::atomic<Profiler*> Profiler::active_{nullptr};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "the SIGPROF handler needs a lock-free counter");
+
+namespace {
+
+#ifndef _WIN32
+struct sigaction previousAction;
+#endif
+
+// Function name of a folded frame ("name:line" or "name")
+std::string_view functionOf(std::string_view frame) {
+    size_t colon = frame.rfind(':');
+    if (colon == std::string_view::npos || colon + 1 == frame.size()) {
+        return frame;
+    }
+    for (size_t i = colon + 1; i < frame.size(); ++i) {
+        if (frame[i] < '0' || frame[i] > '9') {
+            return frame;
+        }
+    }
+    return frame.substr(0, colon);
+}
+
+}  // namespace
+
+bool Profiler::start() {
+#ifdef _WIN32
+    return false;
+#else
+    if (running_ || hz_ <= 0) {
+        return false;
+    }
+    Profiler* expected = nullptr;
+    if (!active_.compare_exchange_strong(expected, this)) {
+        return false;
+    }
+    ticks_.store(0, std::memory_order_relaxed);
+
+    struct sigaction action {};
+    action.sa_handler = [](int) { ticks_.fetch_add(1, std::memory_order_relaxed); };
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;  // Ticks must not fail the script's I/O with EINTR
+    if (sigaction(SIGPROF, &action, &previousAction) != 0) {
+        active_.store(nullptr);
+        return false;
+    }
+
+    const long interval = std::max(1L, 1000000L / hz_);
+    struct itimerval timer {};
+    timer.it_interval.tv_sec = interval / 1000000;
+    timer.it_interval.tv_usec = interval % 1000000;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+        sigaction(SIGPROF, &previousAction, nullptr);
+        active_.store(nullptr);
+        return false;
+    }
+    running_ = true;
+    return true;
+#endif
+}
+
+void Profiler::stop() {
+#ifndef _WIN32
+    if (!running_) {
+        return;
+    }
+    struct itimerval timer {};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    sigaction(SIGPROF, &previousAction, nullptr);
+    ticks_.store(0, std::memory_order_relaxed);
+    active_.store(nullptr);
+    running_ = false;
+#endif
+}
+
+void Profiler::addFrame(std::string_view function, int line) {
+    if (!current_.empty()) {
+        current_ += ';';
+    }
+    // ';' separates frames and the last ' ' the count
+    for (char c : function) {
+        current_ += (c == ';' || c == ' ') ? '_' : c;
+    }
+    if (line > 0) {
+        current_ += ':';
+        current_ += std::to_string(line);
+    }
+}
+
+void Profiler::endSample(uint64_t weight) {
+    if (weight == 0 || current_.empty()) {
+        return;
+    }
+    stacks_[current_] += weight;
+    total_ += weight;
+}
+
+void Profiler::writeFolded(std::ostream& out) const {
+    std::vector<const std::pair<const std::string, uint64_t>*> sorted;
+    sorted.reserve(stacks_.size());
+    for (const auto& entry : stacks_) {
+        sorted.push_back(&entry);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](auto a, auto b) { return a->first < b->first; });
+    for (const auto* entry : sorted) {
+        out << entry->first << ' ' << entry->second << '\n';
+    }
+}
+
+void Profiler::writeTable(std::ostream& out, size_t top) const {
+    struct Counts {
+        uint64_t self = 0;
+        uint64_t total = 0;
+    };
+    std::unordered_map<std::string_view, Counts> functions;
+    std::unordered_set<std::string_view> seen;  // Recursion counts once toward total
+    for (const auto& [stack, count] : stacks_) {
+        seen.clear();
+        std::string_view rest = stack;
+        std::string_view function;
+        while (true) {
+            size_t separator = rest.find(';');
+            function = functionOf(rest.substr(0, separator));
+            if (seen.insert(function).second) {
+                functions[function].total += count;
+            }
+            if (separator == std::string_view::npos) {
+                break;
+            }
+            rest.remove_prefix(separator + 1);
+        }
+        functions[function].self += count;
+    }
+
+    std::vector<std::pair<std::string_view, Counts>> rows(functions.begin(), functions.end());
+    std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+        if (a.second.self != b.second.self) return a.second.self > b.second.self;
+        if (a.second.total != b.second.total) return a.second.total > b.second.total;
+        return a.first < b.first;
+    });
+    if (rows.size() > top) {
+        rows.resize(top);
+    }
+
+    out << "Profile: " << total_ << " samples at " << hz_ << " Hz\n";
+    out << "    self  self%    total total%  function\n";
+    for (const auto& [function, counts] : rows) {
+        char line[64];
+        const double scale = total_ == 0 ? 0.0 : 100.0 / static_cast<double>(total_);
+        std::snprintf(line, sizeof(line), "%8llu %5.1f%% %8llu %5.1f%%  ",
+                      static_cast<unsigned long long>(counts.self), static_cast<double>(counts.self) * scale,
+                      static_cast<unsigned long long>(counts.total), static_cast<double>(counts.total) * scale);
+        out << line << function << '\n';
+    }
+}
+
+}  // namespace izi
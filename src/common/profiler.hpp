@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace izi {
+
+// Sampling profiler for `izi run --profile`.
+//
+// A SIGPROF interval timer ticks `hz` times per second of CPU time.  The
+// signal handler only counts the tick; the engine notices it at its next
+// safepoint (VM: calls, returns and loop back-edges; interpreter: each
+// statement) and records its current call stack, weighted by the ticks that
+// arrived since the previous sample.  Stacks are aggregated in memory and
+// reported as folded stacks (`a:3;b:12 42`, one line per stack, for
+// flamegraph.pl, speedscope and similar tools) and as a table of the
+// functions with the most self and total samples.
+class Profiler {
+   public:
+    static constexpr int DEFAULT_HZ = 1000;
+
+    explicit Profiler(int hz = DEFAULT_HZ) : hz_(hz) {}
+    ~Profiler() { stop(); }
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    // Install the signal handler and start the timer.  Returns false when
+    // the platform has no SIGPROF or another profiler is already running.
+    bool start();
+    void stop();
+
+    int hz() const { return hz_; }
+
+    // Whether a tick is waiting for a sample; a single relaxed load
+    static bool pending() { return ticks_.load(std::memory_order_relaxed) != 0; }
+    // Ticks since the last sample, resetting the count
+    static uint32_t takeTicks() { return ticks_.exchange(0, std::memory_order_relaxed); }
+
+    // Record one stack, outermost frame first:
+    //   beginSample(); addFrame(...) for each frame; endSample();
+    void beginSample() { current_.clear(); }
+    void addFrame(std::string_view function, int line);
+    void endSample() { endSample(takeTicks()); }
+    void endSample(uint64_t weight);
+
+    uint64_t totalSamples() const { return total_; }
+
+    // Folded stacks, sorted by stack
+    void writeFolded(std::ostream& out) const;
+    // The `top` functions with the most self samples, with their total
+    // samples (stacks the function appears in at least once)
+    void writeTable(std::ostream& out, size_t top = 20) const;
+
+   private:
+    int hz_;
+    bool running_ = false;
+    std::string current_;  // Folded stack being built
+    std::unordered_map<std::string, uint64_t> stacks_;
+    uint64_t total_ = 0;
+
+    static std::atomic<uint32_t> ticks_;
+    static std::atomic<Profiler*> active_;
+};
+
+}  // namespace izi
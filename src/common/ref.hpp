@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace izi {
+
+// Base of every object a Value can point at, and of the environments and
+// upvalue cells closures share.  The reference count lives in the object, so
+// a Value is a tag and a pointer straight at it, and a raw pointer to a live
+// object can always be turned back into an owning Ref.
+//
+// Until the first worker thread starts, every count is changed with plain
+// loads and stores; thread_spawn calls shareAcrossThreads() first, and from
+// then on counts are changed atomically.
+class RefCounted {
+   public:
+    RefCounted() = default;
+    // A copy is a new object with no owners yet
+    RefCounted(const RefCounted&) noexcept {}
+    RefCounted& operator=(const RefCounted&) noexcept { return *this; }
+    virtual ~RefCounted() = default;
+
+    uint32_t refCount() const noexcept { return refs_.load(std::memory_order_relaxed); }
+
+    void retain() const noexcept {
+        if (threaded()) [[unlikely]] {
+            refs_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            refs_.store(refs_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+
+    void release() const noexcept {
+        uint32_t left;
+        if (threaded()) [[unlikely]] {
+            left = refs_.fetch_sub(1, std::memory_order_acq_rel) - 1;
+        } else {
+            left = refs_.load(std::memory_order_relaxed) - 1;
+            refs_.store(left, std::memory_order_relaxed);
+        }
+        if (left == 0) {
+            delete this;
+        }
+    }
+
+    // True once a worker thread may share objects with this one
+    static bool threaded() noexcept { return threaded_.load(std::memory_order_relaxed); }
+    // Called before the first worker thread starts; never undone
+    static void shareAcrossThreads() noexcept { threaded_.store(true, std::memory_order_relaxed); }
+
+   private:
+    mutable std::atomic<uint32_t> refs_{0};
+    static inline std::atomic<bool> threaded_{false};
+};
+
+// Owning pointer to a RefCounted object, used where a std::shared_ptr
+// would be.  Every Ref<T> has the representation of a Value's pointer, so a
+// Value can hand out a reference to one without touching the count.
+template <typename T>
+class Ref {
+   public:
+    using element_type = T;
+
+    Ref() noexcept = default;
+    Ref(std::nullptr_t) noexcept {}
+    // Adds an owner to an object that is already alive (or was just made)
+    explicit Ref(T* object) noexcept : ptr_(object) {
+        if (ptr_) ptr_->retain();
+    }
+
+    Ref(const Ref& other) noexcept : ptr_(other.ptr_) {
+        if (ptr_) ptr_->retain();
+    }
+    Ref(Ref&& other) noexcept : ptr_(other.ptr_) { other.ptr_ = nullptr; }
+
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    Ref(const Ref<U>& other) noexcept : ptr_(other.ptr_) {
+        if (ptr_) ptr_->retain();
+    }
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    Ref(Ref<U>&& other) noexcept : ptr_(other.ptr_) {
+        other.ptr_ = nullptr;
+    }
+
+    Ref& operator=(Ref other) noexcept {
+        std::swap(ptr_, other.ptr_);
+        return *this;
+    }
+
+    ~Ref() {
+        if (ptr_) ptr_->release();
+    }
+
+    void reset() noexcept { Ref().swap(*this); }
+    void swap(Ref& other) noexcept { std::swap(ptr_, other.ptr_); }
+
+    T* get() const noexcept { return static_cast<T*>(ptr_); }
+    T& operator*() const noexcept { return *get(); }
+    T* operator->() const noexcept { return get(); }
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+    template <typename U>
+    bool operator==(const Ref<U>& other) const noexcept {
+        return ptr_ == other.ptr_;
+    }
+    template <typename U>
+    bool operator!=(const Ref<U>& other) const noexcept {
+        return ptr_ != other.ptr_;
+    }
+    bool operator==(std::nullptr_t) const noexcept { return ptr_ == nullptr; }
+    bool operator!=(std::nullptr_t) const noexcept { return ptr_ != nullptr; }
+
+   private:
+    template <typename U>
+    friend class Ref;
+    friend class Value;
+
+    // RefCounted* rather than T*, which also keeps Ref<T> usable as a
+    // member while T is still only declared
+    RefCounted* ptr_ = nullptr;
+};
+
+template <typename T, typename... Args>
+Ref<T> makeRef(Args&&... args) {
+    return Ref<T>(new T(std::forward<Args>(args)...));
+}
+
+template <typename T, typename U>
+Ref<T> staticRefCast(const Ref<U>& ref) noexcept {
+    return Ref<T>(static_cast<T*>(ref.get()));
+}
+
+template <typename T, typename U>
+Ref<T> dynamicRefCast(const Ref<U>& ref) noexcept {
+    return Ref<T>(dynamic_cast<T*>(ref.get()));
+}
+
+}  // namespace izi
+
+namespace std {
+template <typename T>
+struct hash<izi::Ref<T>> {
+    size_t operator()(const izi::Ref<T>& ref) const noexcept { return hash<T*>()(ref.get()); }
+};
+}  // namespace std
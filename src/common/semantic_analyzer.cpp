@@ -141,17 +141,17 @@ bool SemanticAnalyzer::areTypesCompatible(const TypeAnnotation& expected, const
 }
 
 TypePtr SemanticAnalyzer::valueToType(const Value& value) {
-    if (std::holds_alternative<Nil>(value)) {
+    if (value.isNil()) {
         return TypeAnnotation::simple(TypeAnnotation::Kind::Nil);
-    } else if (std::holds_alternative<bool>(value)) {
+    } else if (value.isBool()) {
         return TypeAnnotation::simple(TypeAnnotation::Kind::Bool);
-    } else if (std::holds_alternative<double>(value)) {
+    } else if (value.isNumber()) {
         return TypeAnnotation::simple(TypeAnnotation::Kind::Number);
-    } else if (std::holds_alternative<std::string>(value)) {
+    } else if (value.isString()) {
         return TypeAnnotation::simple(TypeAnnotation::Kind::String);
-    } else if (std::holds_alternative<std::shared_ptr<Array>>(value)) {
+    } else if (value.isArray()) {
         return TypeAnnotation::simple(TypeAnnotation::Kind::Array);
-    } else if (std::holds_alternative<std::shared_ptr<Map>>(value)) {
+    } else if (value.isMap()) {
         return TypeAnnotation::simple(TypeAnnotation::Kind::Map);
     }
     return TypeAnnotation::simple(TypeAnnotation::Kind::Any);
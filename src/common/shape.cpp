@@ -0,0 +1,26 @@
+#include "shape.hpp"
+
+namespace izi {
+
+std::shared_ptr<Shape> Shape::empty() {
+    static const std::shared_ptr<Shape> root = std::make_shared<Shape>();
+    return root;
+}
+
+std::shared_ptr<Shape> Shape::withField(const std::string& name) {
+    std::lock_guard<std::mutex> lock(transitionsMutex_);
+    auto it = transitions_.find(name);
+    if (it != transitions_.end()) {
+        return it->second;
+    }
+
+    auto child = std::make_shared<Shape>();
+    child->slots_ = slots_;
+    child->names_ = names_;
+    child->slots_.emplace(name, static_cast<uint32_t>(names_.size()));
+    child->names_.push_back(name);
+    transitions_.emplace(name, child);
+    return child;
+}
+
+}  // namespace izi
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace izi {
+
+// Hidden class describing an Instance's field layout: which field lives in
+// which slot of Instance::slots.  Instances that gained the same fields in the
+// same order share a Shape, so a (shape, slot) pair cached at a property access
+// site is valid for all of them.  A Shape never changes once published; adding
+// a field moves the instance to a child shape through a cached transition.
+class Shape {
+   public:
+    // Shared root for instances without a class-specific root shape
+    static std::shared_ptr<Shape> empty();
+
+    // Slot of `name`, or -1 if this shape has no such field
+    int slotOf(const std::string& name) const {
+        auto it = slots_.find(name);
+        return it == slots_.end() ? -1 : static_cast<int>(it->second);
+    }
+
+    size_t size() const { return names_.size(); }
+    const std::vector<std::string>& fieldNames() const { return names_; }
+
+    // Shape reached by appending `name` as the next slot
+    std::shared_ptr<Shape> withField(const std::string& name);
+
+   private:
+    std::unordered_map<std::string, uint32_t> slots_;
+    std::vector<std::string> names_;
+    std::unordered_map<std::string, std::shared_ptr<Shape>> transitions_;
+    std::mutex transitionsMutex_;  // Interpreter instances may grow on several threads
+};
+
+}  // namespace izi
@@ -0,0 +1,103 @@
+#include "common/trace.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+namespace izi {
+
+bool Trace::enabled_ = false;
+
+namespace {
+
+struct Event {
+    char phase;  // 'X' complete, 'B' begin, 'E' end
+    const char* category;
+    std::string name;
+    double start;
+    double duration;
+    uint32_t thread;
+};
+
+std::mutex eventsMutex;
+std::vector<Event> events;
+std::chrono::steady_clock::time_point origin;
+
+uint32_t currentThread() {
+    static std::atomic<uint32_t> nextThread{1};
+    thread_local uint32_t thread = nextThread++;
+    return thread;
+}
+
+void record(Event event) {
+    std::lock_guard<std::mutex> lock(eventsMutex);
+    events.push_back(std::move(event));
+}
+
+void writeJsonString(std::ostream& out, const std::string& str) {
+    out << '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+            out << escape;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+}  // namespace
+
+void Trace::start() {
+    std::lock_guard<std::mutex> lock(eventsMutex);
+    events.clear();
+    origin = std::chrono::steady_clock::now();
+    enabled_ = true;
+}
+
+double Trace::now() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void Trace::complete(const char* category, std::string name, double start, double duration) {
+    record({'X', category, std::move(name), start, duration, currentThread()});
+}
+
+void Trace::begin(const char* category, std::string name) {
+    record({'B', category, std::move(name), now(), 0.0, currentThread()});
+}
+
+void Trace::end() {
+    record({'E', nullptr, {}, now(), 0.0, currentThread()});
+}
+
+void Trace::stop(std::ostream& out) {
+    enabled_ = false;
+    std::lock_guard<std::mutex> lock(eventsMutex);
+    char number[32];
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << R"({"ph":"M","name":"process_name","pid":1,"args":{"name":"izi"}})";
+    for (const Event& event : events) {
+        out << ",\n{\"ph\":\"" << event.phase << "\",\"pid\":1,\"tid\":" << event.thread;
+        std::snprintf(number, sizeof(number), "%.3f", event.start);
+        out << ",\"ts\":" << number;
+        if (event.phase == 'X') {
+            std::snprintf(number, sizeof(number), "%.3f", event.duration);
+            out << ",\"dur\":" << number;
+        }
+        if (event.category) {
+            out << ",\"cat\":\"" << event.category << "\",\"name\":";
+            writeJsonString(out, event.name);
+        }
+        out << '}';
+    }
+    out << "\n]}\n";
+    events.clear();
+}
+
+}  // namespace izi
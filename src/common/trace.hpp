@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace izi {
+
+// Timeline of compiler and runtime phases for `--trace-out=trace.json`, in
+// the Chrome trace-event format (open it in chrome://tracing or Perfetto).
+//
+// Recording is off until start().  Every hook checks enabled() first, so a
+// run without --trace-out pays one load and branch per traced site.
+// Timestamps are microseconds since start(); each thread is its own track.
+class Trace {
+   public:
+    // Native calls shorter than this are left out of the trace
+    static constexpr double NATIVE_CALL_THRESHOLD_US = 50.0;
+
+    static bool enabled() { return enabled_; }
+
+    static void start();
+    // Stop recording and write the events as a JSON object
+    static void stop(std::ostream& out);
+
+    // Microseconds since start()
+    static double now();
+
+    // A finished slice: `category` is one of "compile", "module", "run",
+    // "call" or "native"
+    static void complete(const char* category, std::string name, double start, double duration);
+    // Open and close a slice on the calling thread (slices must nest)
+    static void begin(const char* category, std::string name);
+    static void end();
+
+   private:
+    static bool enabled_;
+};
+
+// Records the enclosing scope as one slice when tracing is on, optionally
+// only if it took at least `minDuration` microseconds.  The slice is named
+// `prefix` + `name`; the string is only built when tracing is on.
+class TraceScope {
+   public:
+    TraceScope(const char* category, std::string_view name, double minDuration = 0.0)
+        : TraceScope(category, "", name, minDuration) {}
+
+    TraceScope(const char* category, const char* prefix, std::string_view name, double minDuration = 0.0) {
+        if (Trace::enabled()) [[unlikely]] {
+            category_ = category;
+            name_ = prefix;
+            name_ += name;
+            minDuration_ = minDuration;
+            start_ = Trace::now();
+        }
+    }
+
+    ~TraceScope() {
+        if (category_) [[unlikely]] {
+            double duration = Trace::now() - start_;
+            if (duration >= minDuration_) {
+                Trace::complete(category_, std::move(name_), start_, duration);
+            }
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+   private:
+    const char* category_ = nullptr;  // Null when tracing was off on entry
+    std::string name_;
+    double start_ = 0.0;
+    double minDuration_ = 0.0;
+};
+
+}  // namespace izi
@@ -9,104 +9,134 @@
 namespace izi {
 
 std::string getInstanceClassName(const Instance& instance) {
-    if (std::holds_alternative<std::shared_ptr<IziClass>>(instance.klass)) {
-        return std::get<std::shared_ptr<IziClass>>(instance.klass)->name();
-    } else if (std::holds_alternative<std::shared_ptr<VmClass>>(instance.klass)) {
-        return std::get<std::shared_ptr<VmClass>>(instance.klass)->name();
+    if (std::holds_alternative<Ref<IziClass>>(instance.klass)) {
+        return std::get<Ref<IziClass>>(instance.klass)->name();
+    } else if (std::holds_alternative<Ref<VmClass>>(instance.klass)) {
+        return std::get<Ref<VmClass>>(instance.klass)->name();
     }
     return "unknown";
 }
 
+void Value::throwTypeMismatch(Type expected) const {
+    static const char* const names[] = {"nil",      "boolean",     "number",   "string",   "array",
+                                        "map",      "set",         "function", "function", "class",
+                                        "instance", "error",       "task",     "mutex"};
+    throw std::runtime_error(std::string("Type mismatch: expected ") + names[static_cast<size_t>(expected)] +
+                             " but got " + names[static_cast<size_t>(type_)] + ".");
+}
+
+static void writeNumber(std::ostream& out, double num) {
+    // Whole numbers print without a trailing .0
+    if (num == std::floor(num) && std::isfinite(num)) {
+        out << static_cast<long long>(num);
+    } else {
+        out << num;
+    }
+}
+
+static void writeTask(std::ostream& out, const Task& task) {
+    switch (task.state) {
+        case Task::State::Pending:  out << "<task: pending>"; break;
+        case Task::State::Running:  out << "<task: running>"; break;
+        case Task::State::Completed: out << "<task: completed>"; break;
+        case Task::State::Failed:   out << "<task: failed>"; break;
+    }
+}
+
 std::string valueToString(const Value& v) {
     std::ostringstream oss;
-    if (std::holds_alternative<Nil>(v)) {
-        oss << "nil";
-    } else if (std::holds_alternative<double>(v)) {
-        double num = std::get<double>(v);
-        // Check if it's a whole number to avoid trailing .0
-        if (num == std::floor(num) && std::isfinite(num)) {
-            oss << static_cast<long long>(num);
-        } else {
-            oss << num;
-        }
-    } else if (std::holds_alternative<bool>(v)) {
-        oss << (std::get<bool>(v) ? "true" : "false");
-    } else if (std::holds_alternative<std::string>(v)) {
-        oss << std::get<std::string>(v);
-    } else if (std::holds_alternative<std::shared_ptr<Callable>>(v)) {
-        oss << "<fn " << std::get<std::shared_ptr<Callable>>(v)->name() << ">";
-    } else if (std::holds_alternative<std::shared_ptr<Array>>(v)) {
-        oss << "[...]";  // Simplified for string interpolation
-    } else if (std::holds_alternative<std::shared_ptr<Map>>(v)) {
-        oss << "{...}";  // Simplified for string interpolation
-    } else if (std::holds_alternative<std::shared_ptr<Set>>(v)) {
-        oss << "Set(...)";  // Simplified for string interpolation
-    } else if (std::holds_alternative<std::shared_ptr<VmCallable>>(v)) {
-        oss << "<vm fn " << std::get<std::shared_ptr<VmCallable>>(v)->name() << ">";
-    } else if (std::holds_alternative<std::shared_ptr<Instance>>(v)) {
-        auto instance = std::get<std::shared_ptr<Instance>>(v);
-        oss << "<" << getInstanceClassName(*instance) << " instance>";
-    } else if (std::holds_alternative<std::shared_ptr<Error>>(v)) {
-        auto error = std::get<std::shared_ptr<Error>>(v);
-        oss << error->fullMessage();
-    } else if (std::holds_alternative<std::shared_ptr<Task>>(v)) {
-        auto task = std::get<std::shared_ptr<Task>>(v);
-        switch (task->state) {
-            case Task::State::Pending:  oss << "<task: pending>"; break;
-            case Task::State::Running:  oss << "<task: running>"; break;
-            case Task::State::Completed: oss << "<task: completed>"; break;
-            case Task::State::Failed:   oss << "<task: failed>"; break;
-        }
-    } else if (std::holds_alternative<std::shared_ptr<Mutex>>(v)) {
-        oss << "<mutex>";
-    } else {
-        oss << "<unknown>";
+    switch (v.type()) {
+        case Value::Type::Nil:
+            oss << "nil";
+            break;
+        case Value::Type::Number:
+            writeNumber(oss, v.asNumber());
+            break;
+        case Value::Type::Bool:
+            oss << (v.asBool() ? "true" : "false");
+            break;
+        case Value::Type::String:
+            return v.asString();
+        case Value::Type::Callable:
+            oss << "<fn " << v.asCallable()->name() << ">";
+            break;
+        case Value::Type::Array:
+            oss << "[...]";  // Simplified for string interpolation
+            break;
+        case Value::Type::Map:
+            oss << "{...}";  // Simplified for string interpolation
+            break;
+        case Value::Type::Set:
+            oss << "Set(...)";  // Simplified for string interpolation
+            break;
+        case Value::Type::VmCallable:
+            oss << "<vm fn " << v.asVmCallable()->name() << ">";
+            break;
+        case Value::Type::Instance:
+            oss << "<" << getInstanceClassName(*v.asInstance()) << " instance>";
+            break;
+        case Value::Type::Error:
+            oss << v.asError()->fullMessage();
+            break;
+        case Value::Type::Task:
+            writeTask(oss, *v.asTask());
+            break;
+        case Value::Type::Mutex:
+            oss << "<mutex>";
+            break;
+        default:
+            oss << "<unknown>";
+            break;
     }
     return oss.str();
 }
 
 void printValue(const Value& v) {
-    if (std::holds_alternative<Nil>(v)) {
-        std::cout << "nil";
-    } else if (std::holds_alternative<double>(v)) {
-        double num = std::get<double>(v);
-        if (num == std::floor(num) && std::isfinite(num)) {
-            std::cout << static_cast<long long>(num);
-        } else {
-            std::cout << num;
-        }
-    } else if (std::holds_alternative<bool>(v)) {
-        std::cout << (std::get<bool>(v) ? "true" : "false");
-    } else if (std::holds_alternative<std::string>(v)) {
-        std::cout << std::get<std::string>(v);
-    } else if (std::holds_alternative<std::shared_ptr<Callable>>(v)) {
-        std::cout << "<fn " << std::get<std::shared_ptr<Callable>>(v)->name() << ">";
-    } else if (std::holds_alternative<std::shared_ptr<Array>>(v)) {
-        printArray(*std::get<std::shared_ptr<Array>>(v));
-    } else if (std::holds_alternative<std::shared_ptr<Map>>(v)) {
-        printMap(*std::get<std::shared_ptr<Map>>(v));
-    } else if (std::holds_alternative<std::shared_ptr<Set>>(v)) {
-        printSet(*std::get<std::shared_ptr<Set>>(v));
-    } else if (std::holds_alternative<std::shared_ptr<VmCallable>>(v)) {
-        std::cout << "<vm fn " << std::get<std::shared_ptr<VmCallable>>(v)->name() << ">";
-    } else if (std::holds_alternative<std::shared_ptr<Instance>>(v)) {
-        auto instance = std::get<std::shared_ptr<Instance>>(v);
-        std::cout << "<" << getInstanceClassName(*instance) << " instance>";
-    } else if (std::holds_alternative<std::shared_ptr<Error>>(v)) {
-        auto error = std::get<std::shared_ptr<Error>>(v);
-        std::cout << error->fullMessage() << error->formatStackTrace();
-    } else if (std::holds_alternative<std::shared_ptr<Task>>(v)) {
-        auto task = std::get<std::shared_ptr<Task>>(v);
-        switch (task->state) {
-            case Task::State::Pending:  std::cout << "<task: pending>"; break;
-            case Task::State::Running:  std::cout << "<task: running>"; break;
-            case Task::State::Completed: std::cout << "<task: completed>"; break;
-            case Task::State::Failed:   std::cout << "<task: failed>"; break;
+    switch (v.type()) {
+        case Value::Type::Nil:
+            std::cout << "nil";
+            break;
+        case Value::Type::Number:
+            writeNumber(std::cout, v.asNumber());
+            break;
+        case Value::Type::Bool:
+            std::cout << (v.asBool() ? "true" : "false");
+            break;
+        case Value::Type::String:
+            std::cout << v.asString();
+            break;
+        case Value::Type::Callable:
+            std::cout << "<fn " << v.asCallable()->name() << ">";
+            break;
+        case Value::Type::Array:
+            printArray(*v.asArray());
+            break;
+        case Value::Type::Map:
+            printMap(*v.asMap());
+            break;
+        case Value::Type::Set:
+            printSet(*v.asSet());
+            break;
+        case Value::Type::VmCallable:
+            std::cout << "<vm fn " << v.asVmCallable()->name() << ">";
+            break;
+        case Value::Type::Instance:
+            std::cout << "<" << getInstanceClassName(*v.asInstance()) << " instance>";
+            break;
+        case Value::Type::Error: {
+            const auto& error = v.asError();
+            std::cout << error->fullMessage() << error->formatStackTrace();
+            break;
         }
-    } else if (std::holds_alternative<std::shared_ptr<Mutex>>(v)) {
-        std::cout << "<mutex>";
-    } else {
-        std::cout << "<unknown>";
+        case Value::Type::Task:
+            writeTask(std::cout, *v.asTask());
+            break;
+        case Value::Type::Mutex:
+            std::cout << "<mutex>";
+            break;
+        default:
+            std::cout << "<unknown>";
+            break;
     }
 }
 
@@ -1,15 +1,22 @@
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <future>
 #include <iostream>
 #include <memory>
 #include <mutex>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <variant>
 #include <vector>
 
+#include "gc.hpp"
+#include "ref.hpp"
+
 namespace izi {
 using Nil = std::monostate;
 
@@ -24,10 +31,242 @@ struct Error;
 struct Task;
 struct Mutex;
 
-using Value = std::variant<Nil, bool, double, std::string, std::shared_ptr<Array>, std::shared_ptr<Map>,
-                           std::shared_ptr<Set>, std::shared_ptr<Callable>, std::shared_ptr<VmCallable>,
-                           std::shared_ptr<VmClass>, std::shared_ptr<Instance>, std::shared_ptr<Error>,
-                           std::shared_ptr<Task>, std::shared_ptr<Mutex>>;
+// Type tag of a Value.  Everything from String onward is a pointer to a
+// RefCounted object.
+enum class ValueType : uint8_t {
+    Nil,
+    Bool,
+    Number,
+    String,
+    Array,
+    Map,
+    Set,
+    Callable,
+    VmCallable,
+    VmClass,
+    Instance,
+    Error,
+    Task,
+    Mutex,
+};
+
+namespace detail {
+
+// A string payload.  Copying a string Value shares the cell instead of
+// copying the characters.
+struct StringCell : RefCounted {
+    std::string value;
+
+    explicit StringCell(std::string s) : value(std::move(s)) {}
+};
+
+template <ValueType>
+struct PayloadOf;
+
+// clang-format off
+template <> struct PayloadOf<ValueType::Array> { using type = Array; };
+template <> struct PayloadOf<ValueType::Map> { using type = Map; };
+template <> struct PayloadOf<ValueType::Set> { using type = Set; };
+template <> struct PayloadOf<ValueType::Callable> { using type = Callable; };
+template <> struct PayloadOf<ValueType::VmCallable> { using type = VmCallable; };
+template <> struct PayloadOf<ValueType::VmClass> { using type = VmClass; };
+template <> struct PayloadOf<ValueType::Instance> { using type = Instance; };
+template <> struct PayloadOf<ValueType::Error> { using type = Error; };
+template <> struct PayloadOf<ValueType::Task> { using type = Task; };
+template <> struct PayloadOf<ValueType::Mutex> { using type = Mutex; };
+// clang-format on
+
+}  // namespace detail
+
+// Runtime value shared by the interpreter and the VM.
+//
+// Layout: a one-byte type tag and an 8-byte payload (16 bytes total).  nil,
+// booleans and numbers are stored inline; strings and heap objects are a
+// pointer straight at the intrusively counted object, so stack slots, array
+// elements and map entries stay small and cheap to copy.
+class Value {
+   public:
+    using Type = ValueType;
+
+   private:
+    template <typename T>
+    static constexpr Type heapTypeOf() {
+        if constexpr (std::is_same_v<T, Array>) return Type::Array;
+        else if constexpr (std::is_same_v<T, Map>) return Type::Map;
+        else if constexpr (std::is_same_v<T, Set>) return Type::Set;
+        else if constexpr (std::is_same_v<T, Instance>) return Type::Instance;
+        else if constexpr (std::is_same_v<T, Task>) return Type::Task;
+        else if constexpr (std::is_same_v<T, Mutex>) return Type::Mutex;
+        else if constexpr (std::is_same_v<T, Callable>) return Type::Callable;
+        else if constexpr (std::is_same_v<T, VmCallable>) return Type::VmCallable;
+        else if constexpr (std::is_same_v<T, VmClass>) return Type::VmClass;
+        else if constexpr (std::is_same_v<T, Error>) return Type::Error;
+        else if constexpr (std::is_base_of_v<VmClass, T>) return Type::VmClass;
+        else if constexpr (std::is_base_of_v<Callable, T>) return Type::Callable;
+        else if constexpr (std::is_base_of_v<VmCallable, T>) return Type::VmCallable;
+        else if constexpr (std::is_base_of_v<Error, T>) return Type::Error;
+        else return Type::Nil;
+    }
+
+   public:
+    Value() noexcept { bits_.number = 0; }
+    Value(Nil) noexcept : Value() {}
+    Value(bool b) noexcept : type_(Type::Bool) { bits_.boolean = b; }
+    Value(double d) noexcept : type_(Type::Number) { bits_.number = d; }
+    Value(const char* s) : Value(std::string(s)) {}
+    Value(std::string s) : type_(Type::String) {
+        bits_.cell = new detail::StringCell(std::move(s));
+        bits_.cell->retain();
+    }
+
+    // Heap objects: a Ref to any of the object types (or a subclass of
+    // Callable / VmCallable / VmClass / Error) is accepted.  A null Ref
+    // makes nil.
+    template <typename T, typename = std::enable_if_t<heapTypeOf<T>() != Type::Nil>>
+    Value(Ref<T> p) noexcept {
+        if (p.ptr_) {
+            type_ = heapTypeOf<T>();
+            bits_.cell = p.ptr_;
+            p.ptr_ = nullptr;
+        } else {
+            bits_.number = 0;
+        }
+    }
+
+    Value(const Value& other) noexcept : type_(other.type_), bits_(other.bits_) { retain(); }
+    Value(Value&& other) noexcept : type_(other.type_), bits_(other.bits_) { other.type_ = Type::Nil; }
+
+    Value& operator=(const Value& other) noexcept {
+        if (this != &other) {
+            other.retain();
+            release();
+            type_ = other.type_;
+            bits_ = other.bits_;
+        }
+        return *this;
+    }
+
+    Value& operator=(Value&& other) noexcept {
+        if (this != &other) {
+            release();
+            type_ = other.type_;
+            bits_ = other.bits_;
+            other.type_ = Type::Nil;
+        }
+        return *this;
+    }
+
+    ~Value() { release(); }
+
+    Type type() const noexcept { return type_; }
+    bool isHeap() const noexcept { return type_ >= Type::String; }
+
+    bool isNil() const noexcept { return type_ == Type::Nil; }
+    bool isBool() const noexcept { return type_ == Type::Bool; }
+    bool isNumber() const noexcept { return type_ == Type::Number; }
+    bool isString() const noexcept { return type_ == Type::String; }
+    bool isArray() const noexcept { return type_ == Type::Array; }
+    bool isMap() const noexcept { return type_ == Type::Map; }
+    bool isSet() const noexcept { return type_ == Type::Set; }
+    bool isCallable() const noexcept { return type_ == Type::Callable; }
+    bool isVmCallable() const noexcept { return type_ == Type::VmCallable; }
+    bool isVmClass() const noexcept { return type_ == Type::VmClass; }
+    bool isInstance() const noexcept { return type_ == Type::Instance; }
+    bool isError() const noexcept { return type_ == Type::Error; }
+    bool isTask() const noexcept { return type_ == Type::Task; }
+    bool isMutex() const noexcept { return type_ == Type::Mutex; }
+
+    // Checked accessors: throw std::runtime_error on a type mismatch.
+    bool asBool() const {
+        expect(Type::Bool);
+        return bits_.boolean;
+    }
+    double asNumber() const {
+        expect(Type::Number);
+        return bits_.number;
+    }
+    const std::string& asString() const {
+        expect(Type::String);
+        return static_cast<const detail::StringCell*>(bits_.cell)->value;
+    }
+
+    // Unchecked forms for callers that have already tested the type (the
+    // VM's quickened opcodes).  replaceInline() must only overwrite a value
+    // that holds no heap reference.
+    double numberUnchecked() const noexcept { return bits_.number; }
+    void replaceInline(double d) noexcept {
+        type_ = Type::Number;
+        bits_.number = d;
+    }
+    void replaceInline(bool b) noexcept {
+        type_ = Type::Bool;
+        bits_.boolean = b;
+    }
+    const Ref<Array>& asArray() const { return payload<Type::Array>(); }
+    const Ref<Map>& asMap() const { return payload<Type::Map>(); }
+    const Ref<Set>& asSet() const { return payload<Type::Set>(); }
+    const Ref<Callable>& asCallable() const { return payload<Type::Callable>(); }
+    const Ref<VmCallable>& asVmCallable() const { return payload<Type::VmCallable>(); }
+    const Ref<VmClass>& asVmClass() const { return payload<Type::VmClass>(); }
+    const Ref<Instance>& asInstance() const { return payload<Type::Instance>(); }
+    const Ref<Error>& asError() const { return payload<Type::Error>(); }
+    const Ref<Task>& asTask() const { return payload<Type::Task>(); }
+    const Ref<Mutex>& asMutex() const { return payload<Type::Mutex>(); }
+
+    // Same semantics as the std::variant this class replaced: values of
+    // different types are never equal, strings compare by content and heap
+    // objects by identity.
+    friend bool operator==(const Value& a, const Value& b) {
+        if (a.type_ != b.type_) return false;
+        switch (a.type_) {
+            case Type::Nil:
+                return true;
+            case Type::Bool:
+                return a.bits_.boolean == b.bits_.boolean;
+            case Type::Number:
+                return a.bits_.number == b.bits_.number;
+            case Type::String:
+                return a.bits_.cell == b.bits_.cell || a.asString() == b.asString();
+            default:
+                return a.bits_.cell == b.bits_.cell;
+        }
+    }
+
+   private:
+    friend class GcTracer;
+
+    // A Ref<T> is laid out as a single RefCounted*, the same as bits_.cell
+    template <Type T>
+    const Ref<typename detail::PayloadOf<T>::type>& payload() const {
+        expect(T);
+        return *reinterpret_cast<const Ref<typename detail::PayloadOf<T>::type>*>(&bits_.cell);
+    }
+
+    void expect(Type t) const {
+        if (type_ != t) [[unlikely]] {
+            throwTypeMismatch(t);
+        }
+    }
+
+    void retain() const noexcept {
+        if (isHeap()) bits_.cell->retain();
+    }
+
+    void release() noexcept {
+        if (isHeap()) bits_.cell->release();
+    }
+
+    [[noreturn]] void throwTypeMismatch(Type expected) const;
+
+    Type type_ = Type::Nil;
+    union Bits {
+        bool boolean;
+        double number;
+        RefCounted* cell;
+    } bits_;
+};
+
+static_assert(sizeof(Value) == 16, "Value must stay a 16-byte tag + payload");
 
 // Forward declare to avoid circular dependency
 }  // namespace izi
@@ -37,22 +276,46 @@ using Value = std::variant<Nil, bool, double, std::string, std::shared_ptr<Array
 
 namespace izi {
 
-struct Array {
+struct Array : RefCounted, GcObject {
     std::vector<Value> elements;
+
+    void traceRefs(GcTracer& tracer) const override {
+        for (const Value& element : elements) tracer.trace(element);
+    }
+    void clearRefs() override { elements.clear(); }
 };
-struct Map {
+struct Map : RefCounted, GcObject {
     std::unordered_map<std::string, Value> entries;
+    // Bumped whenever an entry is erased.  The VM's property caches hold
+    // pointers into `entries`, which only erasure invalidates.
+    uint32_t layoutVersion = 0;
+    // Tells this map apart from a later one allocated at its address; 0
+    // until a property cache first records it (see mapCacheId)
+    uint64_t cacheId = 0;
+
+    void traceRefs(GcTracer& tracer) const override {
+        for (const auto& [key, value] : entries) tracer.trace(value);
+    }
+    void clearRefs() override {
+        entries.clear();
+        ++layoutVersion;
+    }
 };
-struct Set {
+struct Set : RefCounted, GcObject {
     std::unordered_map<std::string, Value> values;  // Using string keys for uniqueness
+
+    void traceRefs(GcTracer& tracer) const override {
+        for (const auto& [key, value] : values) tracer.trace(value);
+    }
+    void clearRefs() override { values.clear(); }
 };
 
 // Task: represents a spawned unit of work for the cooperative scheduler
 // When osMutex/osCv are set, the task runs on an OS thread (via thread_spawn).
-struct Task {
+struct Task : RefCounted {
     enum class State { Pending, Running, Completed, Failed };
     State state = State::Pending;
-    std::shared_ptr<Callable> callable;
+    Ref<Callable> callable;
     Value result;
     std::string errorMessage;
     // OS thread support (non-null only for thread_spawn tasks)
@@ -62,7 +325,7 @@ struct Task {
 
 // Mutex: a mutual-exclusion lock for protecting shared mutable state between threads.
 // Created with mutex(), acquired with lock()/trylock(), released with unlock().
-struct Mutex {
+struct Mutex : RefCounted {
     std::shared_ptr<std::mutex> mtx = std::make_shared<std::mutex>();
 };
 
@@ -110,69 +373,68 @@ void printValue(const Value& v);
 std::string valueToString(const Value& v);
 
 inline bool isTruthy(const Value& v) {
-    if (std::holds_alternative<Nil>(v)) {
-        return false;
-    } else if (std::holds_alternative<bool>(v)) {
-        return std::get<bool>(v);
-    } else if (std::holds_alternative<double>(v)) {
-        return std::get<double>(v) != 0.0;
-    } else if (std::holds_alternative<std::string>(v)) {
-        return !std::get<std::string>(v).empty();
-    } else if (std::holds_alternative<std::shared_ptr<Array>>(v)) {
-        return !std::get<std::shared_ptr<Array>>(v)->elements.empty();
-    } else if (std::holds_alternative<std::shared_ptr<Map>>(v)) {
-        return !std::get<std::shared_ptr<Map>>(v)->entries.empty();
-    } else if (std::holds_alternative<std::shared_ptr<Set>>(v)) {
-        return !std::get<std::shared_ptr<Set>>(v)->values.empty();
-    } else if (std::holds_alternative<std::shared_ptr<Instance>>(v)) {
-        return true;  // Instances are always truthy
-    } else if (std::holds_alternative<std::shared_ptr<Error>>(v)) {
-        return true;  // Errors are always truthy
-    } else if (std::holds_alternative<std::shared_ptr<Task>>(v)) {
-        return true;  // Tasks are always truthy
-    } else if (std::holds_alternative<std::shared_ptr<Mutex>>(v)) {
-        return true;  // Mutexes are always truthy
-    }
-    return false;
+    switch (v.type()) {
+        case Value::Type::Nil:
+            return false;
+        case Value::Type::Bool:
+            return v.asBool();
+        case Value::Type::Number:
+            return v.asNumber() != 0.0;
+        case Value::Type::String:
+            return !v.asString().empty();
+        case Value::Type::Array:
+            return !v.asArray()->elements.empty();
+        case Value::Type::Map:
+            return !v.asMap()->entries.empty();
+        case Value::Type::Set:
+            return !v.asSet()->values.empty();
+        case Value::Type::Instance:
+        case Value::Type::Error:
+        case Value::Type::Task:
+        case Value::Type::Mutex:
+            return true;  // Instances, errors, tasks and mutexes are always truthy
+        default:
+            return false;
+    }
 }
 
 inline double asNumber(const Value& v) {
-    if (!std::holds_alternative<double>(v)) {
+    if (!v.isNumber()) {
         throw std::runtime_error("Expected number");
     }
 
-    return std::get<double>(v);
+    return v.asNumber();
 }
 
 inline std::string getTypeName(const Value& v) {
-    if (std::holds_alternative<Nil>(v)) {
-        return "nil";
-    } else if (std::holds_alternative<bool>(v)) {
-        return "boolean";
-    } else if (std::holds_alternative<double>(v)) {
-        return "number";
-    } else if (std::holds_alternative<std::string>(v)) {
-        return "string";
-    } else if (std::holds_alternative<std::shared_ptr<Array>>(v)) {
-        return "array";
-    } else if (std::holds_alternative<std::shared_ptr<Map>>(v)) {
-        return "map";
-    } else if (std::holds_alternative<std::shared_ptr<Set>>(v)) {
-        return "set";
-    } else if (std::holds_alternative<std::shared_ptr<Callable>>(v)) {
-        return "function";
-    } else if (std::holds_alternative<std::shared_ptr<VmCallable>>(v)) {
-        return "function";
-    } else if (std::holds_alternative<std::shared_ptr<VmClass>>(v)) {
-        return "class";
-    } else if (std::holds_alternative<std::shared_ptr<Instance>>(v)) {
-        return "instance";
-    } else if (std::holds_alternative<std::shared_ptr<Error>>(v)) {
-        return "error";
-    } else if (std::holds_alternative<std::shared_ptr<Task>>(v)) {
-        return "task";
-    } else if (std::holds_alternative<std::shared_ptr<Mutex>>(v)) {
-        return "mutex";
+    switch (v.type()) {
+        case Value::Type::Nil:
+            return "nil";
+        case Value::Type::Bool:
+            return "boolean";
+        case Value::Type::Number:
+            return "number";
+        case Value::Type::String:
+            return "string";
+        case Value::Type::Array:
+            return "array";
+        case Value::Type::Map:
+            return "map";
+        case Value::Type::Set:
+            return "set";
+        case Value::Type::Callable:
+        case Value::Type::VmCallable:
+            return "function";
+        case Value::Type::VmClass:
+            return "class";
+        case Value::Type::Instance:
+            return "instance";
+        case Value::Type::Error:
+            return "error";
+        case Value::Type::Task:
+            return "task";
+        case Value::Type::Mutex:
+            return "mutex";
     }
     return "unknown";
 }
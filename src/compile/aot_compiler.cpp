@@ -0,0 +1,405 @@
+#include "compile/aot_compiler.hpp"
+#include "bytecode/opcode.hpp"
+#include "bytecode/vm_class.hpp"
+#include "bytecode/vm_user_function.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace izi {
+
+std::string AotCompiler::stringLiteral(const std::string& str) {
+    // Octal escapes for everything but plain printable ASCII, so the literal
+    // round-trips any byte sequence
+    std::string literal = "std::string(\"";
+    for (unsigned char c : str) {
+        if (c >= 0x20 && c < 0x7F && c != '"' && c != '\\' && c != '?') {
+            literal += static_cast<char>(c);
+        } else {
+            char escaped[5];
+            std::snprintf(escaped, sizeof(escaped), "\\%03o", c);
+            literal += escaped;
+        }
+    }
+    literal += "\", " + std::to_string(str.size()) + ")";
+    return literal;
+}
+
+std::string AotCompiler::numberLiteral(double number) {
+    if (std::isnan(number)) {
+        return "std::numeric_limits<double>::quiet_NaN()";
+    }
+    if (std::isinf(number)) {
+        return number > 0 ? "std::numeric_limits<double>::infinity()" : "-std::numeric_limits<double>::infinity()";
+    }
+    char literal[64];
+    std::snprintf(literal, sizeof(literal), "%a", number);  // Exact
+    return literal;
+}
+
+size_t AotCompiler::collect(const Chunk& chunk) {
+    auto found = chunkIndex_.find(&chunk);
+    if (found != chunkIndex_.end()) {
+        return found->second;
+    }
+    size_t index = chunks_.size();
+    chunks_.push_back(&chunk);
+    chunkIndex_[&chunk] = index;
+    for (const auto& constant : chunk.constants) {
+        collectValue(constant);
+    }
+    return index;
+}
+
+void AotCompiler::collectValue(const Value& value) {
+    if (value.isVmCallable()) {
+        if (auto function = dynamicRefCast<VmUserFunction>(value.asVmCallable())) {
+            collect(function->getChunk());
+        }
+    } else if (value.isVmClass()) {
+        for (const auto& [name, method] : value.asVmClass()->methods) {
+            collectValue(Value(method));
+        }
+    }
+}
+
+std::string AotCompiler::functionExpression(const Value& value) {
+    auto function = dynamicRefCast<VmUserFunction>(value.asVmCallable());
+    if (!function) {
+        throw std::runtime_error("Cannot compile native function constant '" + value.asVmCallable()->name() + "'");
+    }
+    std::string params = "std::vector<std::string>{";
+    for (const auto& param : function->params()) {
+        params += stringLiteral(param) + ", ";
+    }
+    params += "}";
+    std::string upvalues = "std::vector<UpvalueDesc>{";
+    for (const auto& desc : function->upvalueDescs()) {
+        upvalues += "UpvalueDesc{" + std::to_string(desc.index) + ", " + (desc.isLocal ? "true" : "false") + "}, ";
+    }
+    upvalues += "}";
+    return "makeRef<VmUserFunction>(" + stringLiteral(function->name()) + ", " + params + ", chunk" +
+           std::to_string(chunkIndex_.at(&function->getChunk())) + "(), " + upvalues + ")";
+}
+
+std::string AotCompiler::valueExpression(const Value& value) {
+    if (value.isNil()) {
+        return "Value()";
+    }
+    if (value.isBool()) {
+        return value.asBool() ? "Value(true)" : "Value(false)";
+    }
+    if (value.isNumber()) {
+        return "Value(" + numberLiteral(value.asNumber()) + ")";
+    }
+    if (value.isString()) {
+        return "Value(" + stringLiteral(value.asString()) + ")";
+    }
+    if (value.isVmCallable()) {
+        return "Value(" + functionExpression(value) + ")";
+    }
+    if (value.isVmClass()) {
+        const auto& vmClass = value.asVmClass();
+        std::string fields = "std::vector<std::string>{";
+        for (const auto& field : vmClass->fieldNames) {
+            fields += stringLiteral(field) + ", ";
+        }
+        fields += "}";
+        std::string defaults = "std::unordered_map<std::string, Value>{";
+        for (const auto& [field, defaultValue] : vmClass->fieldDefaults) {
+            defaults += "{" + stringLiteral(field) + ", " + valueExpression(defaultValue) + "}, ";
+        }
+        defaults += "}";
+        std::string methods = "std::unordered_map<std::string, Ref<VmCallable>>{";
+        for (const auto& [name, method] : vmClass->methods) {
+            methods += "{" + stringLiteral(name) + ", " + functionExpression(Value(method)) + "}, ";
+        }
+        methods += "}";
+        return "Value(makeRef<VmClass>(" + stringLiteral(vmClass->className) + ", nullptr, " + fields +
+               ", " + defaults + ", " + methods + "))";
+    }
+    throw std::runtime_error("Cannot compile constant of this type ahead of time");
+}
+
+void AotCompiler::emitInstruction(const Chunk& chunk, size_t offset) {
+    const auto& code = chunk.code;
+    OpCode op = static_cast<OpCode>(code[offset]);
+    const std::string at = std::to_string(offset);
+    const std::string exit = "IZI_AOT_EXIT(" + at + ");";
+    const std::string room = "if (sp >= limit) " + exit;
+    uint8_t operand = operandBytes(op) > 0 ? code[offset + 1] : 0;
+    auto jumpTarget = [&](size_t base, uint16_t distance, bool backward) {
+        if (backward ? distance > base : base + distance > starts_.back()) {
+            return exit;  // Malformed: let the VM report it
+        }
+        size_t target = backward ? base - distance : base + distance;
+        if (target != starts_.back() && !std::binary_search(starts_.begin(), starts_.end(), target)) {
+            return exit;
+        }
+        return "goto op" + std::to_string(target) + ";";
+    };
+    auto readShort = [&](size_t position) { return static_cast<uint16_t>((code[position] << 8) | code[position + 1]); };
+    auto numberConstant = [&](uint8_t index) {
+        return index < chunk.constants.size() && chunk.constants[index].isNumber();
+    };
+    auto arithmetic = [&](const char* symbol) {
+        out_ << "        if (!sp[-2].isNumber() || !sp[-1].isNumber()) " << exit << "\n"
+             << "        sp[-2].replaceInline(sp[-2].numberUnchecked() " << symbol << " sp[-1].numberUnchecked());\n"
+             << "        --sp;\n";
+    };
+
+    switch (op) {
+        case OpCode::CONSTANT:
+            out_ << "        " << room << "\n";
+            if (operand < chunk.constants.size() && !chunk.constants[operand].isHeap()) {
+                out_ << "        *sp++ = " << valueExpression(chunk.constants[operand]) << ";\n";
+            } else {
+                out_ << "        *sp++ = constants[" << int(operand) << "];\n";
+            }
+            return;
+        case OpCode::NIL:
+        case OpCode::TRUE:
+        case OpCode::FALSE:
+            out_ << "        " << room << "\n"
+                 << "        *sp++ = "
+                 << (op == OpCode::NIL ? "Value()" : op == OpCode::TRUE ? "Value(true)" : "Value(false)") << ";\n";
+            return;
+        case OpCode::POP:
+            out_ << "        *--sp = Value();\n";
+            return;
+        case OpCode::GET_LOCAL:
+        case OpCode::GET_LOCAL_0:
+        case OpCode::GET_LOCAL_1:
+        case OpCode::GET_LOCAL_2:
+        case OpCode::GET_LOCAL_3: {
+            int slot = op == OpCode::GET_LOCAL ? operand
+                                               : static_cast<int>(op) - static_cast<int>(OpCode::GET_LOCAL_0);
+            out_ << "        " << room << "\n"
+                 << "        *sp++ = slots[" << slot << "];\n";
+            return;
+        }
+        case OpCode::SET_LOCAL:
+            out_ << "        slots[" << int(operand) << "] = sp[-1];\n";
+            return;
+        case OpCode::GET_GLOBAL:
+            out_ << "        if (sp >= limit || !JitRuntime::getGlobal(&context, sp, " << int(operand) << ")) " << exit
+                 << "\n"
+                 << "        ++sp;\n";
+            return;
+        case OpCode::SET_GLOBAL:
+            out_ << "        JitRuntime::setGlobal(&context, sp - 1, " << int(operand) << ");\n";
+            return;
+        case OpCode::SET_GLOBAL_POP:
+            out_ << "        JitRuntime::setGlobalPop(&context, --sp, " << int(operand) << ");\n";
+            return;
+        case OpCode::GET_UPVALUE:
+            out_ << "        " << room << "\n"
+                 << "        JitRuntime::getUpvalue(&context, sp++, " << int(operand) << ");\n";
+            return;
+        case OpCode::SET_UPVALUE:
+            out_ << "        JitRuntime::setUpvalue(&context, sp - 1, " << int(operand) << ");\n";
+            return;
+        case OpCode::ADD:
+        case OpCode::ADD_NUM:
+            arithmetic("+");  // Strings go to the VM
+            return;
+        case OpCode::SUBTRACT:
+            arithmetic("-");
+            return;
+        case OpCode::MULTIPLY:
+            arithmetic("*");
+            return;
+        case OpCode::DIVIDE:
+            arithmetic("/");
+            return;
+        case OpCode::ADD_CONST:
+            if (!numberConstant(operand)) {
+                break;
+            }
+            out_ << "        if (!sp[-1].isNumber()) " << exit << "\n"
+                 << "        sp[-1].replaceInline(sp[-1].numberUnchecked() + "
+                 << numberLiteral(chunk.constants[operand].asNumber()) << ");\n";
+            return;
+        case OpCode::MODULO:
+            out_ << "        if (!JitRuntime::modulo(sp - 2)) " << exit << "\n"
+                 << "        --sp;\n";
+            return;
+        case OpCode::NEGATE:
+            out_ << "        if (!sp[-1].isNumber()) " << exit << "\n"
+                 << "        sp[-1].replaceInline(-sp[-1].numberUnchecked());\n";
+            return;
+        case OpCode::LESS:
+        case OpCode::LESS_NUM:
+        case OpCode::LESS_EQUAL:
+        case OpCode::GREATER:
+        case OpCode::GREATER_EQUAL: {
+            const char* symbol = op == OpCode::LESS_EQUAL      ? "<="
+                                 : op == OpCode::GREATER       ? ">"
+                                 : op == OpCode::GREATER_EQUAL ? ">="
+                                                               : "<";
+            out_ << "        if (!sp[-2].isNumber() || !sp[-1].isNumber()) " << exit << "\n"
+                 << "        sp[-2].replaceInline(sp[-2].numberUnchecked() " << symbol
+                 << " sp[-1].numberUnchecked());\n"
+                 << "        --sp;\n";
+            return;
+        }
+        case OpCode::EQUAL:
+        case OpCode::NOT_EQUAL:
+            out_ << "        bool equal = sp[-2] == sp[-1];\n"
+                 << "        *--sp = Value();\n"
+                 << "        sp[-1] = Value(" << (op == OpCode::EQUAL ? "equal" : "!equal") << ");\n";
+            return;
+        case OpCode::NOT:
+            out_ << "        sp[-1] = Value(!isTruthy(sp[-1]));\n";
+            return;
+        case OpCode::INDEX:
+        case OpCode::INDEX_ARRAY_NUM:
+            out_ << "        if (!JitRuntime::indexArray(sp - 2)) " << exit << "\n"
+                 << "        --sp;\n";
+            return;
+        case OpCode::JUMP:
+            out_ << "        " << jumpTarget(offset + 3, readShort(offset + 1), false) << "\n";
+            return;
+        case OpCode::LOOP:
+            out_ << "        if (--context.backEdgesLeft == 0) " << exit << "  // Safepoint\n"
+                 << "        " << jumpTarget(offset + 3, readShort(offset + 1), true) << "\n";
+            return;
+        case OpCode::JUMP_IF_FALSE:
+            out_ << "        if (!isTruthy(sp[-1])) " << jumpTarget(offset + 3, readShort(offset + 1), false) << "\n";
+            return;
+        case OpCode::JUMP_IF_NOT_NIL:
+            out_ << "        if (!sp[-1].isNil()) " << jumpTarget(offset + 3, readShort(offset + 1), false) << "\n";
+            return;
+        case OpCode::POP_JUMP_IF_FALSE:
+            out_ << "        bool truthy = isTruthy(sp[-1]);\n"
+                 << "        *--sp = Value();\n"
+                 << "        if (!truthy) " << jumpTarget(offset + 3, readShort(offset + 1), false) << "\n";
+            return;
+        case OpCode::LESS_CONST_JUMP:
+            if (!numberConstant(operand)) {
+                break;
+            }
+            out_ << "        if (!sp[-1].isNumber()) " << exit << "\n"
+                 << "        double value = (--sp)->numberUnchecked();\n"
+                 << "        if (!(value < " << numberLiteral(chunk.constants[operand].asNumber()) << ")) "
+                 << jumpTarget(offset + 4, readShort(offset + 2), false) << "\n";
+            return;
+        default:
+            break;
+    }
+    // Calls, returns, property access, ...
+    out_ << "        " << exit << "\n";
+}
+
+void AotCompiler::emitNative(size_t index) {
+    const Chunk& chunk = *chunks_[index];
+    const auto& code = chunk.code;
+
+    // Instruction starts, then the end of the translated code (a truncated
+    // instruction ends the translation)
+    starts_.clear();
+    size_t end = 0;
+    while (end < code.size() && end + 1 + operandBytes(static_cast<OpCode>(code[end])) <= code.size()) {
+        starts_.push_back(end);
+        end += 1 + operandBytes(static_cast<OpCode>(code[end]));
+    }
+    std::vector<size_t> starts = starts_;
+    starts_.push_back(end);
+
+    out_ << "uint32_t native" << index << "(JitContext& context, uint32_t entry) {\n"
+         << "    Value* sp = context.sp;\n"
+         << "    Value* const slots = context.slots;\n"
+         << "    const Value* const constants = context.constants;\n"
+         << "    Value* const limit = context.stackLimit;\n"
+         << "    (void)slots;\n"
+         << "    (void)constants;\n"
+         << "    (void)limit;\n"
+         << "    switch (entry) {\n";
+    for (size_t offset : starts) {
+        out_ << "        case " << offset << ": goto op" << offset << ";\n";
+    }
+    out_ << "        default: return entry;\n"
+         << "    }\n";
+    for (size_t offset : starts) {
+        out_ << "op" << offset << ": {\n";
+        emitInstruction(chunk, offset);
+        out_ << "    }\n";
+    }
+    // Jumps may target the end of the code
+    out_ << "op" << end << ":\n"
+         << "    IZI_AOT_EXIT(" << end << ");\n"
+         << "}\n\n";
+}
+
+void AotCompiler::emitBuilder(size_t index) {
+    const Chunk& chunk = *chunks_[index];
+    out_ << "std::shared_ptr<Chunk> chunk" << index << "() {\n"
+         << "    auto chunk = std::make_shared<Chunk>();\n"
+         << "    chunk->code = {";
+    for (size_t i = 0; i < chunk.code.size(); ++i) {
+        out_ << (i % 24 == 0 ? "\n        " : " ") << int(chunk.code[i]) << ",";
+    }
+    out_ << "};\n"
+         << "    chunk->lines = {";
+    for (size_t i = 0; i < chunk.lines.size(); ++i) {
+        out_ << (i % 24 == 0 ? "\n        " : " ") << chunk.lines[i] << ",";
+    }
+    out_ << "};\n";
+    for (const auto& name : chunk.names) {
+        out_ << "    chunk->names.push_back(" << stringLiteral(name) << ");\n";
+    }
+    for (const auto& entry : chunk.exceptionTable) {
+        out_ << "    chunk->exceptionTable.push_back(ExceptionTableEntry{" << entry.start << ", " << entry.end << ", "
+             << entry.handler << ", " << entry.stackDepth << "});\n";
+    }
+    for (const auto& constant : chunk.constants) {
+        out_ << "    chunk->constants.push_back(" << valueExpression(constant) << ");\n";
+    }
+    out_ << "    chunk->jitCode = std::make_shared<JitCode>(&native" << index << ");\n"
+         << "    return chunk;\n"
+         << "}\n\n";
+}
+
+void AotCompiler::generate(const Chunk& script, std::ostream& out) {
+    AotCompiler compiler(out);
+    compiler.collect(script);
+
+    out << "// Generated by izi compile - do not edit\n"
+        << "#include \"bytecode/jit.hpp\"\n"
+        << "#include \"bytecode/vm.hpp\"\n"
+        << "#include \"bytecode/vm_class.hpp\"\n"
+        << "#include \"bytecode/vm_user_function.hpp\"\n"
+        << "#include <limits>\n"
+        << "#include <memory>\n"
+        << "#include <string>\n"
+        << "#include <unordered_map>\n"
+        << "#include <vector>\n"
+        << "\n"
+        << "using namespace izi;\n"
+        << "\n"
+        << "// Hand the instruction at `offset` to the VM\n"
+        << "#define IZI_AOT_EXIT(offset) \\\n"
+        << "    do {                     \\\n"
+        << "        context.sp = sp;     \\\n"
+        << "        return offset;       \\\n"
+        << "    } while (false)\n"
+        << "\n"
+        << "namespace {\n"
+        << "\n";
+    for (size_t i = 0; i < compiler.chunks_.size(); ++i) {
+        out << "std::shared_ptr<Chunk> chunk" << i << "();\n";
+    }
+    out << "\n";
+    for (size_t i = 0; i < compiler.chunks_.size(); ++i) {
+        compiler.emitNative(i);
+        compiler.emitBuilder(i);
+    }
+    out << "}  // namespace\n"
+        << "\n"
+        << "std::shared_ptr<Chunk> aotScriptChunk() {\n"
+        << "    return chunk0();\n"
+        << "}\n";
+}
+
+}  // namespace izi
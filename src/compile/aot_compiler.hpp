@@ -0,0 +1,59 @@
+#pragma once
+
+#include "bytecode/chunk.hpp"
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace izi {
+
+/**
+ * AotCompiler - Translates a compiled program into C++ for `izi compile`
+ *
+ * Every chunk (the script, each function and each method) becomes:
+ * - a C++ function with the NativeEntry contract of bytecode/jit.hpp: each
+ *   instruction is a labeled block, jumps and loops are gotos, and
+ *   arithmetic, comparisons, locals, globals, upvalues and array indexing
+ *   run inline.  Calls, returns, property access and operands of unexpected
+ *   types return to the VM at that instruction.
+ * - a builder that recreates the Chunk (code, constants, names, lines and
+ *   exception table) with that function attached, so the executable never
+ *   lexes, parses or compiles anything.
+ *
+ * The generated code defines `std::shared_ptr<izi::Chunk> aotScriptChunk()`;
+ * run it with a VM after VM::enableAotCode().
+ */
+class AotCompiler {
+   public:
+    /**
+     * Generate the C++ translation of a program
+     * @param script Top-level chunk from BytecodeCompiler (imports already inlined)
+     * @param out Stream receiving the generated code
+     * @throws std::runtime_error if a constant cannot be expressed in C++
+     */
+    static void generate(const Chunk& script, std::ostream& out);
+
+   private:
+    explicit AotCompiler(std::ostream& out) : out_(out) {}
+
+    std::ostream& out_;
+    std::vector<const Chunk*> chunks_;
+    std::unordered_map<const Chunk*, size_t> chunkIndex_;
+    std::vector<size_t> starts_;  // Instruction offsets of the chunk being emitted, then its end
+
+    // Number every chunk reachable through function and class constants
+    size_t collect(const Chunk& chunk);
+    void collectValue(const Value& value);
+
+    void emitNative(size_t index);
+    void emitInstruction(const Chunk& chunk, size_t offset);
+    void emitBuilder(size_t index);
+    std::string valueExpression(const Value& value);
+    std::string functionExpression(const Value& value);
+
+    static std::string stringLiteral(const std::string& str);
+    static std::string numberLiteral(double number);
+};
+
+}  // namespace izi
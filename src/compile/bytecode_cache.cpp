@@ -0,0 +1,181 @@
+#include "compile/bytecode_cache.hpp"
+#include "bytecode/chunk_serializer.hpp"
+#include "common/cli.hpp"
+#include "compile/compiler.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace izi {
+
+namespace {
+
+constexpr char CACHE_MAGIC[4] = {'I', 'Z', 'C', '\0'};
+constexpr uint32_t CACHE_VERSION = 1;
+
+void writeUint32(std::ostream& out, uint32_t value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void writeUint64(std::ostream& out, uint64_t value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void writeString(std::ostream& out, const std::string& str) {
+    writeUint32(out, static_cast<uint32_t>(str.size()));
+    out.write(str.data(), static_cast<std::streamsize>(str.size()));
+}
+
+// Readers return false on a truncated file
+bool readUint32(std::istream& in, uint32_t& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+bool readUint64(std::istream& in, uint64_t& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+bool readString(std::istream& in, std::string& str) {
+    uint32_t size;
+    if (!readUint32(in, size) || size > (1u << 20)) {
+        return false;
+    }
+    str.resize(size);
+    return static_cast<bool>(in.read(str.data(), size));
+}
+
+std::optional<std::string> readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return std::nullopt;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+}  // namespace
+
+uint64_t BytecodeCache::hash(std::string_view data) {
+    uint64_t value = 14695981039346656037ull;
+    for (unsigned char c : data) {
+        value ^= c;
+        value *= 1099511628211ull;
+    }
+    return value;
+}
+
+std::string BytecodeCache::cachePath(const std::string& scriptPath) {
+    fs::path script(scriptPath);
+    return (script.parent_path() / "__izicache__" / (script.filename().string() + ".izb")).string();
+}
+
+std::optional<Chunk> BytecodeCache::load(const std::string& scriptPath, const std::string& source) const {
+    std::ifstream in(cachePath(scriptPath), std::ios::binary);
+    if (!in) {
+        return std::nullopt;
+    }
+
+    char magic[4];
+    uint32_t version;
+    uint32_t formatVersion;
+    uint32_t revision;
+    std::string izilangVersion;
+    char optimized;
+    uint64_t sourceHash;
+    uint32_t importCount;
+    if (!in.read(magic, 4) || std::memcmp(magic, CACHE_MAGIC, 4) != 0 || !readUint32(in, version) ||
+        version != CACHE_VERSION || !readUint32(in, formatVersion) ||
+        formatVersion != ChunkSerializer::FORMAT_VERSION || !readUint32(in, revision) ||
+        revision != BytecodeCompiler::REVISION || !readString(in, izilangVersion) || izilangVersion != IZILANG_VERSION ||
+        !in.get(optimized) || (optimized != 0) != optimize_ || !readUint64(in, sourceHash) ||
+        sourceHash != hash(source) || !readUint32(in, importCount)) {
+        return std::nullopt;
+    }
+
+    for (uint32_t i = 0; i < importCount; ++i) {
+        std::string path;
+        uint64_t importHash;
+        if (!readString(in, path) || !readUint64(in, importHash)) {
+            return std::nullopt;
+        }
+        auto contents = readFile(path);
+        if (!contents || hash(*contents) != importHash) {
+            return std::nullopt;
+        }
+    }
+
+    try {
+        // The image that follows the header is mapped rather than read
+        return ChunkSerializer::deserializeFromFile(cachePath(scriptPath), static_cast<size_t>(in.tellg()));
+    } catch (const std::exception&) {
+        return std::nullopt;  // Truncated, or written by another format version
+    }
+}
+
+void BytecodeCache::store(const std::string& scriptPath, const std::string& source, const Chunk& chunk,
+                          const std::unordered_set<std::string>& imports) const {
+    // Sorted so that equal inputs produce identical files
+    std::vector<std::pair<std::string, uint64_t>> files;
+    for (const auto& path : imports) {
+        if (!fs::path(path).is_absolute()) {
+            continue;  // Native module name
+        }
+        auto contents = readFile(path);
+        if (!contents) {
+            return;
+        }
+        files.emplace_back(path, hash(*contents));
+    }
+    std::sort(files.begin(), files.end());
+
+    std::ostringstream entry(std::ios::binary);
+    try {
+        entry.write(CACHE_MAGIC, 4);
+        writeUint32(entry, CACHE_VERSION);
+        writeUint32(entry, ChunkSerializer::FORMAT_VERSION);
+        writeUint32(entry, BytecodeCompiler::REVISION);
+        writeString(entry, IZILANG_VERSION);
+        entry.put(optimize_ ? 1 : 0);
+        writeUint64(entry, hash(source));
+        writeUint32(entry, static_cast<uint32_t>(files.size()));
+        for (const auto& [path, fileHash] : files) {
+            writeString(entry, path);
+            writeUint64(entry, fileHash);
+        }
+        ChunkSerializer::serialize(chunk, entry);
+    } catch (const std::exception&) {
+        return;
+    }
+
+    // Write then rename, so concurrent runs never read a partial entry
+    std::error_code error;
+    fs::path target(cachePath(scriptPath));
+    fs::create_directories(target.parent_path(), error);
+    if (error) {
+        return;
+    }
+    fs::path temporary = target;
+    temporary += ".tmp" + std::to_string(std::random_device{}());
+    {
+        std::ofstream out(temporary, std::ios::binary);
+        const std::string bytes = entry.str();
+        if (!out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()))) {
+            out.close();
+            fs::remove(temporary, error);
+            return;
+        }
+    }
+    fs::rename(temporary, target, error);
+    if (error) {
+        fs::remove(temporary, error);
+    }
+}
+
+}  // namespace izi
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "bytecode/chunk.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace izi {
+
+// On-disk cache of compiled scripts for `izi run --vm`.
+//
+// The bytecode for <dir>/<file> is kept in <dir>/__izicache__/<file>.izb
+// together with the key it was compiled under: a hash of the source, the
+// IziLang version, the .izb format version, the compiler's REVISION and the
+// optimization flag.  Imported files are compiled into the same chunk, so
+// the entry also lists each of them with a hash of its contents.  Any
+// difference makes a lookup miss; the caller then compiles as usual and
+// stores a fresh entry.  A directory that cannot be written is skipped.
+class BytecodeCache {
+   public:
+    explicit BytecodeCache(bool optimize) : optimize_(optimize) {}
+
+    // Cache file for a script
+    static std::string cachePath(const std::string& scriptPath);
+
+    // The cached chunk for `scriptPath`, if it was compiled from `source`
+    // with the same flags and none of its imports changed since
+    std::optional<Chunk> load(const std::string& scriptPath, const std::string& source) const;
+
+    // Record a freshly compiled chunk.  `imports` is the set filled through
+    // BytecodeCompiler::setImportedModules; native module names in it are
+    // skipped.  Failures (read-only directory, a constant that cannot be
+    // serialized) leave no entry behind and are otherwise ignored.
+    void store(const std::string& scriptPath, const std::string& source, const Chunk& chunk,
+               const std::unordered_set<std::string>& imports) const;
+
+    // 64-bit FNV-1a
+    static uint64_t hash(std::string_view data);
+
+   private:
+    bool optimize_;
+};
+
+}  // namespace izi
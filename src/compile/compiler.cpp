@@ -1,6 +1,7 @@
 #include "compiler.hpp"
 #include "common/value.hpp"
 #include "common/module_path.hpp"
+#include "common/trace.hpp"
 #include "bytecode/vm_user_function.hpp"
 #include "bytecode/vm_class.hpp"
 #include "bytecode/vm_native_modules.hpp"
@@ -17,6 +18,7 @@
 
 namespace izi {
 Chunk BytecodeCompiler::compile(const std::vector<StmtPtr>& program) {
+    TraceScope trace("compile", "compile");
     for (const auto& stmt : program) {
         emitStatement(*stmt);
     }
@@ -46,7 +48,13 @@ void BytecodeCompiler::emitExpression(Expr& expr) {
     expr.accept(*this);
 }
 void BytecodeCompiler::emitStatement(Stmt& stmt) {
+    // Code after a nested statement (a loop's back-edge) belongs to the outer one
+    int enclosingLine = currentLine;
+    if (stmt.line > 0) {
+        currentLine = stmt.line;
+    }
     stmt.accept(*this);
+    currentLine = enclosingLine;
 }
 
 // control flow helpers
@@ -81,11 +89,112 @@ void BytecodeCompiler::emitLoop(size_t loopStart) {
 // Returns the slot index (0-based from the call frame base) or -1 if not local.
 int BytecodeCompiler::resolveLocal(const std::string& name) const {
     for (int i = static_cast<int>(locals.size()) - 1; i >= 0; --i) {
-        if (locals[static_cast<size_t>(i)] == name) return i;
+        if (locals[static_cast<size_t>(i)].name == name) return i;
     }
     return -1;
 }
 
+void BytecodeCompiler::addLocal(const std::string& name) {
+    if (locals.size() > UINT8_MAX) {
+        throw std::runtime_error("Too many local variables in function.");
+    }
+    locals.push_back(Local{name, scopeDepth});
+}
+
+void BytecodeCompiler::beginScope() {
+    ++scopeDepth;
+}
+
+void BytecodeCompiler::endScope() {
+    --scopeDepth;
+    size_t count = locals.size();
+    while (count > 0 && locals[count - 1].depth > scopeDepth) {
+        --count;
+    }
+    emitDiscardLocals(count);
+    locals.resize(count);
+}
+
+void BytecodeCompiler::emitDiscardLocals(size_t count) {
+    for (size_t i = locals.size(); i > count; --i) {
+        emitOp(locals[i - 1].isCaptured ? OpCode::CLOSE_UPVALUE : OpCode::POP);
+    }
+}
+
+// Resolve a variable declared in an enclosing function.  A local of the
+// direct parent is captured from its stack slot; anything further out is
+// threaded through the parent's own upvalues.
+int BytecodeCompiler::resolveUpvalue(const std::string& name) {
+    auto it = std::find(upvalueNames.begin(), upvalueNames.end(), name);
+    if (it != upvalueNames.end()) {
+        return static_cast<int>(std::distance(upvalueNames.begin(), it));
+    }
+    if (enclosing == nullptr) {
+        return -1;
+    }
+
+    UpvalueDesc desc{};
+    int local = enclosing->resolveLocal(name);
+    if (local >= 0) {
+        enclosing->locals[static_cast<size_t>(local)].isCaptured = true;
+        desc = UpvalueDesc{static_cast<uint8_t>(local), true};
+    } else {
+        int outer = enclosing->resolveUpvalue(name);
+        if (outer < 0) {
+            return -1;
+        }
+        desc = UpvalueDesc{static_cast<uint8_t>(outer), false};
+    }
+
+    if (upvalues.size() > UINT8_MAX) {
+        throw std::runtime_error("Too many closure variables in function.");
+    }
+    upvalues.push_back(desc);
+    upvalueNames.push_back(name);
+    return static_cast<int>(upvalues.size() - 1);
+}
+
+void BytecodeCompiler::emitFunction(const std::string& name, const std::vector<std::string>& params,
+                                    const std::vector<StmtPtr>& body) {
+    BytecodeCompiler functionCompiler;
+    functionCompiler.inFunction = true;
+    functionCompiler.enclosing = this;
+    functionCompiler.superclassName = superclassName;
+    functionCompiler.strict = strict;
+
+    // Register allocation: pre-register each parameter as a local variable slot.
+    // OpCode::CALL leaves the argument values on the VM stack in the same order
+    // and starts the new frame at the first one, so GET_LOCAL 0 retrieves the
+    // first argument, etc.
+    for (const auto& param : params) {
+        functionCompiler.addLocal(param);
+    }
+
+    // Fix the upvalue layout up front from the free variables of the body
+    // (including those of nested functions, which are threaded through here).
+    std::vector<std::string> freeNames = UpvalueCollector::collectFromStatements(body, params);
+    std::sort(freeNames.begin(), freeNames.end());
+    for (const auto& freeName : freeNames) {
+        functionCompiler.resolveUpvalue(freeName);
+    }
+
+    for (const auto& bodyStmt : body) {
+        functionCompiler.emitStatement(*bodyStmt);
+    }
+
+    // Ensure the function returns nil if it doesn't have an explicit return
+    functionCompiler.emitOp(OpCode::NIL);
+    functionCompiler.emitOp(OpCode::RETURN);
+
+    auto functionChunk = std::make_shared<Chunk>(std::move(functionCompiler.chunk));
+    auto vmFunction = makeRef<VmUserFunction>(name, params, functionChunk, functionCompiler.upvalues);
+
+    // Functions without captures are shared as-is; others get fresh cells per evaluation.
+    uint8_t constantIndex = makeConstant(vmFunction);
+    emitOp(functionCompiler.upvalues.empty() ? OpCode::CONSTANT : OpCode::CLOSURE);
+    emitByte(constantIndex);
+}
+
 //  --- ExprVisitor
 Value BytecodeCompiler::visit(BinaryExpr& expr) {
     // Short-circuit AND: left && right
@@ -123,6 +232,17 @@ Value BytecodeCompiler::visit(BinaryExpr& expr) {
         return Nil{};
     }
 
+    // `x + literal` (counters, string building) adds the constant in place
+    if (expr.op.type == TokenType::PLUS) {
+        auto* literal = dynamic_cast<LiteralExpr*>(expr.right.get());
+        if (literal && (literal->value.isNumber() || literal->value.isString())) {
+            emitExpression(*expr.left);
+            emitOp(OpCode::ADD_CONST);
+            emitByte(makeConstant(literal->value));
+            return Nil{};
+        }
+    }
+
     emitExpression(*expr.left);
     emitExpression(*expr.right);
 
@@ -185,6 +305,19 @@ Value BytecodeCompiler::visit(UnaryExpr& expr) {
 }
 
 Value BytecodeCompiler::visit(CallExpr& expr) {
+    // obj.name(args) becomes a single INVOKE: no bound method is created and
+    // the receiver is passed to the method as local 0.
+    if (auto* property = dynamic_cast<PropertyExpr*>(expr.callee.get())) {
+        emitExpression(*property->object);
+        for (const auto& arg : expr.args) {
+            emitExpression(*arg);
+        }
+        emitOp(OpCode::INVOKE);
+        emitByte(makeName(property->property));
+        emitByte(static_cast<uint8_t>(expr.args.size()));
+        return Nil{};
+    }
+
     emitExpression(*expr.callee);
     for (const auto& arg : expr.args) {
         emitExpression(*arg);
@@ -195,10 +328,10 @@ Value BytecodeCompiler::visit(CallExpr& expr) {
 }
 
 Value BytecodeCompiler::visit(LiteralExpr& expr) {
-    if (std::holds_alternative<Nil>(expr.value)) {
+    if (expr.value.isNil()) {
         emitOp(OpCode::NIL);
-    } else if (std::holds_alternative<bool>(expr.value)) {
-        if (std::get<bool>(expr.value)) {
+    } else if (expr.value.isBool()) {
+        if (expr.value.asBool()) {
             emitOp(OpCode::TRUE);
         } else {
             emitOp(OpCode::FALSE);
@@ -217,6 +350,9 @@ Value BytecodeCompiler::visit(AssignExpr& expr) {
     if (slot >= 0) {
         emitOp(OpCode::SET_LOCAL);
         emitByte(static_cast<uint8_t>(slot));
+    } else if ((slot = resolveUpvalue(expr.name)) >= 0) {
+        emitOp(OpCode::SET_UPVALUE);
+        emitByte(static_cast<uint8_t>(slot));
     } else {
         uint8_t nameIndex = makeName(expr.name);
         emitOp(OpCode::SET_GLOBAL);
@@ -226,16 +362,25 @@ Value BytecodeCompiler::visit(AssignExpr& expr) {
 }
 
 Value BytecodeCompiler::visit(VariableExpr& expr) {
-    int slot = resolveLocal(expr.name);
-    if (slot >= 0) {
+    emitGetVariable(expr.name);
+    return Nil{};
+}
+
+void BytecodeCompiler::emitGetVariable(const std::string& name) {
+    int slot = resolveLocal(name);
+    if (slot >= 0 && slot <= 3) {
+        emitOp(static_cast<OpCode>(static_cast<int>(OpCode::GET_LOCAL_0) + slot));
+    } else if (slot >= 0) {
         emitOp(OpCode::GET_LOCAL);
         emitByte(static_cast<uint8_t>(slot));
+    } else if ((slot = resolveUpvalue(name)) >= 0) {
+        emitOp(OpCode::GET_UPVALUE);
+        emitByte(static_cast<uint8_t>(slot));
     } else {
-        uint8_t nameIndex = makeName(expr.name);
+        uint8_t nameIndex = makeName(name);
         emitOp(OpCode::GET_GLOBAL);
         emitByte(nameIndex);
     }
-    return Nil{};
 }
 Value BytecodeCompiler::visit(GroupingExpr& expr) {
     emitExpression(*expr.expression);
@@ -285,39 +430,7 @@ Value BytecodeCompiler::visit(SetIndexExpr& expr) {
 
 Value BytecodeCompiler::visit(FunctionExpr& expr) {
     // Compile the function body into a separate chunk, just like FunctionStmt.
-    BytecodeCompiler functionCompiler;
-    functionCompiler.inFunction = true;
-
-    std::vector<std::string> seedLocals = expr.params;
-    std::vector<std::string> referencedNames = UpvalueCollector::collectFromStatements(expr.body, seedLocals);
-    std::vector<std::string> captureNames;
-    if (inFunction) {
-        for (const auto& name : referencedNames) {
-            if (resolveLocal(name) >= 0) {
-                captureNames.push_back(name);
-            }
-        }
-    }
-
-    for (const auto& param : expr.params) {
-        functionCompiler.locals.push_back(param);
-    }
-
-    for (const auto& bodyStmt : expr.body) {
-        functionCompiler.emitStatement(*bodyStmt);
-    }
-
-    functionCompiler.emitOp(OpCode::NIL);
-    functionCompiler.emitOp(OpCode::RETURN);
-
-    auto functionChunk = std::make_shared<Chunk>(std::move(functionCompiler.chunk));
-    auto vmFunction = std::make_shared<VmUserFunction>("<lambda>", expr.params, functionChunk,
-                                                       functionCompiler.locals, captureNames);
-
-    uint8_t constantIndex = makeConstant(vmFunction);
-    emitOp(OpCode::CONSTANT);
-    emitByte(constantIndex);
-
+    emitFunction("<lambda>", expr.params, expr.body);
     return Nil{};
 }
 
@@ -356,6 +469,16 @@ Value BytecodeCompiler::visit(MapExpr& expr) {
 }
 //  --- StmtVisitor
 void BytecodeCompiler::visit(ExprStmt& stmt) {
+    // Assignment to a global as a statement stores and pops in one step
+    if (auto* assign = dynamic_cast<AssignExpr*>(stmt.expr.get())) {
+        if (resolveLocal(assign->name) < 0 && resolveUpvalue(assign->name) < 0) {
+            emitExpression(*assign->value);
+            emitOp(OpCode::SET_GLOBAL_POP);
+            emitByte(makeName(assign->name));
+            return;
+        }
+    }
+
     emitExpression(*stmt.expr);
     emitOp(OpCode::POP);
 }
@@ -368,16 +491,31 @@ void BytecodeCompiler::visit(ReturnStmt& stmt) {
     emitOp(OpCode::RETURN);
 }
 
+size_t BytecodeCompiler::emitConditionJump(Expr& condition) {
+    // `x < number` compares and branches in one instruction
+    if (auto* binary = dynamic_cast<BinaryExpr*>(&condition); binary && binary->op.type == TokenType::LESS) {
+        auto* literal = dynamic_cast<LiteralExpr*>(binary->right.get());
+        if (literal && literal->value.isNumber()) {
+            emitExpression(*binary->left);
+            emitOp(OpCode::LESS_CONST_JUMP);
+            emitByte(makeConstant(literal->value));
+            emitByte(0xff);
+            emitByte(0xff);
+            return chunk.code.size() - 2;
+        }
+    }
+
+    emitExpression(condition);
+    return emitJump(OpCode::POP_JUMP_IF_FALSE);
+}
+
 void BytecodeCompiler::visit(IfStmt& stmt) {
-    emitExpression(*stmt.condition);
-    size_t thenJump = emitJump(OpCode::JUMP_IF_FALSE);
-    emitOp(OpCode::POP);  // Pop condition
+    size_t thenJump = emitConditionJump(*stmt.condition);
 
     emitStatement(*stmt.thenBranch);
     size_t elseJump = emitJump(OpCode::JUMP);
 
     patchJump(thenJump);
-    emitOp(OpCode::POP);  // Pop condition
 
     if (stmt.elseBranch) {
         emitStatement(*stmt.elseBranch);
@@ -388,18 +526,14 @@ void BytecodeCompiler::visit(WhileStmt& stmt) {
     size_t loopStart = chunk.code.size();
 
     // Push new loop context for break/continue
-    loopStack.push_back(LoopContext{{}, loopStart});
-
-    emitExpression(*stmt.condition);
+    loopStack.push_back(LoopContext{{}, loopStart, locals.size()});
 
-    size_t exitJump = emitJump(OpCode::JUMP_IF_FALSE);
-    emitOp(OpCode::POP);  // Pop condition
+    size_t exitJump = emitConditionJump(*stmt.condition);
 
     emitStatement(*stmt.body);
     emitLoop(loopStart);
 
     patchJump(exitJump);
-    emitOp(OpCode::POP);  // Pop condition
 
     // Patch all break jumps to exit the loop
     for (size_t breakJump : loopStack.back().breakJumps) {
@@ -410,9 +544,19 @@ void BytecodeCompiler::visit(WhileStmt& stmt) {
     loopStack.pop_back();
 }
 void BytecodeCompiler::visit(BlockStmt& stmt) {
+    // Top-level blocks declare globals; only function bodies track scopes.
+    if (!inFunction) {
+        for (const auto& statement : stmt.statements) {
+            emitStatement(*statement);
+        }
+        return;
+    }
+
+    beginScope();
     for (const auto& statement : stmt.statements) {
         emitStatement(*statement);
     }
+    endScope();
 }
 void BytecodeCompiler::visit(VarStmt& stmt) {
     // For now, bytecode compiler doesn't support destructuring
@@ -431,69 +575,27 @@ void BytecodeCompiler::visit(VarStmt& stmt) {
         // Inside a function body: allocate a local variable slot on the stack.
         // The initializer value is already on the stack; registering the name
         // in `locals` at the current position "claims" that stack slot.
-        locals.push_back(stmt.name);
+        addLocal(stmt.name);
         // Do NOT pop — the value stays on the stack as the local variable slot.
     } else {
         // Top-level: store as a global variable.
-        uint8_t nameIndex = makeName(stmt.name);
-        emitOp(OpCode::SET_GLOBAL);
-        emitByte(nameIndex);
-        emitOp(OpCode::POP);  // Pop the value left by SET_GLOBAL
+        emitOp(OpCode::SET_GLOBAL_POP);
+        emitByte(makeName(stmt.name));
     }
 }
 
 void BytecodeCompiler::visit(FunctionStmt& stmt) {
-    // Compile function body into a separate chunk
-    BytecodeCompiler functionCompiler;
-    functionCompiler.inFunction = true;
-
-    std::vector<std::string> seedLocals = stmt.params;
-    std::vector<std::string> referencedNames = UpvalueCollector::collectFromStatements(stmt.body, seedLocals);
-    std::vector<std::string> captureNames;
-    if (inFunction) {
-        for (const auto& name : referencedNames) {
-            if (resolveLocal(name) >= 0) {
-                captureNames.push_back(name);
-            }
-        }
-    }
-
-    // Register allocation: pre-register each parameter as a local variable slot.
-    // VmUserFunction::call() will push argument values onto the VM stack in the
-    // same order, so GET_LOCAL 0 retrieves the first argument, etc.
-    for (const auto& param : stmt.params) {
-        functionCompiler.locals.push_back(param);
-    }
-
-    // Compile the function body
-    for (const auto& bodyStmt : stmt.body) {
-        functionCompiler.emitStatement(*bodyStmt);
-    }
-
-    // Ensure the function returns nil if it doesn't have an explicit return
-    functionCompiler.emitOp(OpCode::NIL);
-    functionCompiler.emitOp(OpCode::RETURN);
-
-    // Create a VmUserFunction and store it as a constant
-    auto functionChunk = std::make_shared<Chunk>(std::move(functionCompiler.chunk));
-    auto vmFunction = std::make_shared<VmUserFunction>(stmt.name, stmt.params, functionChunk,
-                                                       functionCompiler.locals, captureNames);
-
-    // Store the function in a constant and push it
-    uint8_t constantIndex = makeConstant(vmFunction);
-    emitOp(OpCode::CONSTANT);
-    emitByte(constantIndex);
-
     if (inFunction) {
-        // Inside a function body: register the function as a local variable slot.
-        locals.push_back(stmt.name);
+        // Inside a function body: claim the local slot the function value will
+        // occupy before compiling it, so the body can capture itself for recursion.
+        addLocal(stmt.name);
+        emitFunction(stmt.name, stmt.params, stmt.body);
         // Do NOT pop — value stays on the stack as the local variable slot.
     } else {
         // Top-level: store it in a global variable.
-        uint8_t nameIndex = makeName(stmt.name);
-        emitOp(OpCode::SET_GLOBAL);
-        emitByte(nameIndex);
-        emitOp(OpCode::POP);  // Pop the value left by SET_GLOBAL
+        emitFunction(stmt.name, stmt.params, stmt.body);
+        emitOp(OpCode::SET_GLOBAL_POP);
+        emitByte(makeName(stmt.name));
     }
 }
 
@@ -544,6 +646,7 @@ void BytecodeCompiler::visit(ImportStmt& stmt) {
 
     // For file-based modules, resolve relative paths
     // Note: We handle extension resolution ourselves to support .izb files
+    TraceScope trace("module", "import ", stmt.module);
     std::string basePath = stmt.module;
 
     // If it's a relative path, resolve it relative to the importing file's directory
@@ -640,6 +743,7 @@ void BytecodeCompiler::visit(ImportStmt& stmt) {
                 codeEndPos -= 2;  // Skip the final NIL+RETURN
             }
 
+            size_t codeOffset = chunk.code.size();
             for (size_t i = 0; i < codeEndPos; ++i) {
                 uint8_t byte = moduleChunk.code[i];
                 OpCode op = static_cast<OpCode>(byte);
@@ -647,7 +751,7 @@ void BytecodeCompiler::visit(ImportStmt& stmt) {
                 chunk.code.push_back(byte);
 
                 // Check if this opcode is followed by a constant or name index
-                if (op == OpCode::CONSTANT) {
+                if (op == OpCode::CONSTANT || op == OpCode::CLOSURE || op == OpCode::ADD_CONST) {
                     // Next byte is a constant index
                     if (i + 1 < moduleChunk.code.size()) {
                         ++i;
@@ -656,7 +760,8 @@ void BytecodeCompiler::visit(ImportStmt& stmt) {
                         chunk.code.push_back(remappedIndex);
                     }
                 } else if (op == OpCode::GET_GLOBAL || op == OpCode::SET_GLOBAL || op == OpCode::GET_PROPERTY ||
-                           op == OpCode::SET_PROPERTY || op == OpCode::LOAD_MODULE) {
+                           op == OpCode::SET_PROPERTY || op == OpCode::LOAD_MODULE || op == OpCode::GET_SUPER_METHOD ||
+                           op == OpCode::SET_GLOBAL_POP) {
                     // Next byte is a name index
                     if (i + 1 < moduleChunk.code.size()) {
                         ++i;
@@ -664,41 +769,60 @@ void BytecodeCompiler::visit(ImportStmt& stmt) {
                         uint8_t remappedIndex = static_cast<uint8_t>(nameIndex + nameOffset);
                         chunk.code.push_back(remappedIndex);
                     }
-                } else if (op == OpCode::JUMP || op == OpCode::JUMP_IF_FALSE || op == OpCode::LOOP) {
-                    // Next 2 bytes are jump offset (no remapping needed, relative offset)
+                } else if (op == OpCode::INVOKE) {
+                    // Next bytes: name index (remapped), argument count
                     if (i + 2 < moduleChunk.code.size()) {
                         ++i;
-                        chunk.code.push_back(moduleChunk.code[i]);
+                        chunk.code.push_back(static_cast<uint8_t>(moduleChunk.code[i] + nameOffset));
                         ++i;
                         chunk.code.push_back(moduleChunk.code[i]);
                     }
-                } else if (op == OpCode::CALL) {
-                    // Next byte is argument count (no remapping needed)
-                    if (i + 1 < moduleChunk.code.size()) {
+                } else if (op == OpCode::GET_LOCAL_PROPERTY) {
+                    // Next bytes: slot, name index (remapped)
+                    if (i + 2 < moduleChunk.code.size()) {
                         ++i;
                         chunk.code.push_back(moduleChunk.code[i]);
+                        ++i;
+                        chunk.code.push_back(static_cast<uint8_t>(moduleChunk.code[i] + nameOffset));
                     }
-                } else if (op == OpCode::TRY) {
-                    // Next 5 bytes: catch offset (2), finally offset (2), catch var name index (1)
-                    if (i + 5 < moduleChunk.code.size()) {
+                } else if (op == OpCode::LESS_CONST_JUMP) {
+                    // Next bytes: constant index (remapped), 2-byte jump offset
+                    if (i + 3 < moduleChunk.code.size()) {
                         ++i;
-                        chunk.code.push_back(moduleChunk.code[i]);  // catch offset high
+                        chunk.code.push_back(static_cast<uint8_t>(moduleChunk.code[i] + constantOffset));
                         ++i;
-                        chunk.code.push_back(moduleChunk.code[i]);  // catch offset low
+                        chunk.code.push_back(moduleChunk.code[i]);
                         ++i;
-                        chunk.code.push_back(moduleChunk.code[i]);  // finally offset high
+                        chunk.code.push_back(moduleChunk.code[i]);
+                    }
+                } else if (op == OpCode::JUMP || op == OpCode::JUMP_IF_FALSE || op == OpCode::LOOP ||
+                           op == OpCode::JUMP_IF_NOT_NIL || op == OpCode::POP_JUMP_IF_FALSE) {
+                    // Next 2 bytes are jump offset (no remapping needed, relative offset)
+                    if (i + 2 < moduleChunk.code.size()) {
                         ++i;
-                        chunk.code.push_back(moduleChunk.code[i]);  // finally offset low
+                        chunk.code.push_back(moduleChunk.code[i]);
                         ++i;
-                        uint8_t catchVarIndex = moduleChunk.code[i];
-                        if (catchVarIndex != 0) {
-                            // Remap catch variable name index
-                            catchVarIndex = static_cast<uint8_t>(catchVarIndex + nameOffset);
-                        }
-                        chunk.code.push_back(catchVarIndex);
+                        chunk.code.push_back(moduleChunk.code[i]);
+                    }
+                } else if (op == OpCode::CALL || op == OpCode::GET_LOCAL || op == OpCode::SET_LOCAL ||
+                           op == OpCode::GET_UPVALUE || op == OpCode::SET_UPVALUE || op == OpCode::BUILD_ARRAY ||
+                           op == OpCode::BUILD_MAP) {
+                    // Next byte is an argument count, slot or element count (no remapping needed)
+                    if (i + 1 < moduleChunk.code.size()) {
+                        ++i;
+                        chunk.code.push_back(moduleChunk.code[i]);
                     }
                 }
             }
+
+            // Exception table ranges move with the code they protect
+            for (ExceptionTableEntry entry : moduleChunk.exceptionTable) {
+                entry.start += static_cast<uint32_t>(codeOffset);
+                entry.end += static_cast<uint32_t>(codeOffset);
+                entry.handler += static_cast<uint32_t>(codeOffset);
+                entry.stackDepth += static_cast<uint32_t>(locals.size());
+                chunk.exceptionTable.push_back(entry);
+            }
         } else {
             // Load and parse the module source
             std::string source = loadFile(actualPath);
@@ -755,7 +879,8 @@ void BytecodeCompiler::visit(BreakStmt& /*stmt*/) {
         throw std::runtime_error("'break' statement outside of loop.");
     }
 
-    // Record this jump to be patched when we exit the loop
+    // Drop the loop body's locals, then record this jump to be patched when we exit the loop
+    emitDiscardLocals(loopStack.back().localCount);
     size_t breakJump = emitJump(OpCode::JUMP);
     loopStack.back().breakJumps.push_back(breakJump);
 }
@@ -765,96 +890,56 @@ void BytecodeCompiler::visit(ContinueStmt& /*stmt*/) {
         throw std::runtime_error("'continue' statement outside of loop.");
     }
 
-    // Emit a LOOP instruction to jump back to loop start
+    // Drop the loop body's locals and jump back to loop start
+    emitDiscardLocals(loopStack.back().localCount);
     emitLoop(loopStack.back().loopStart);
 }
 
 void BytecodeCompiler::visit(TryStmt& stmt) {
-    // Emit TRY opcode with placeholders for offsets
-    size_t tryOpcodePos = chunk.code.size();
-    emitOp(OpCode::TRY);
-    size_t catchOffsetPos = chunk.code.size();
-    emitByte(0xff);  // Placeholder for catch offset high byte
-    emitByte(0xff);  // Placeholder for catch offset low byte
-    size_t finallyOffsetPos = chunk.code.size();
-    emitByte(0xff);  // Placeholder for finally offset high byte
-    emitByte(0xff);  // Placeholder for finally offset low byte
-
-    // Emit catch variable name index (0 if no catch)
-    uint8_t catchVarIndex = 0;
-    if (stmt.catchBlock != nullptr && !stmt.catchVariable.empty()) {
-        catchVarIndex = makeName(stmt.catchVariable);
-    }
-    emitByte(catchVarIndex);
-
-    // Now IP is at tryOpcodePos + 6 (1 opcode + 2 + 2 + 1 bytes)
-    size_t ipAfterTry = chunk.code.size();
-
-    // Emit try block
+    // The try block runs with no setup: an exception raised inside it is
+    // routed to the handler through the chunk's exception table.  The VM
+    // unwinds to the statement's locals and pushes the exception, so it
+    // lands in the next local slot: the catch variable, or a hidden local
+    // that is rethrown after the finally block when there is no catch.
+    size_t stackDepth = locals.size();
+    size_t tryStart = chunk.code.size();
     emitStatement(*stmt.tryBlock);
+    size_t tryEnd = chunk.code.size();
 
-    // Jump over catch and finally blocks after successful try execution
-    size_t tryEndJump = emitJump(OpCode::JUMP);
-
-    // Emit catch block if present
-    if (stmt.catchBlock != nullptr) {
-        size_t catchStart = chunk.code.size();
-        uint16_t catchOffset = catchStart - ipAfterTry;
-        chunk.code[catchOffsetPos] = (catchOffset >> 8) & 0xff;
-        chunk.code[catchOffsetPos + 1] = catchOffset & 0xff;
+    if (stmt.catchBlock == nullptr && stmt.finallyBlock == nullptr) {
+        return;
+    }
 
-        // Pop exception from stack - it was pushed by the exception handler
-        // and bound to the catch variable as a global
-        emitOp(OpCode::POP);
+    size_t skipHandler = emitJump(OpCode::JUMP);
+    size_t handlerStart = chunk.code.size();
 
-        // Emit catch block body
+    beginScope();
+    if (stmt.catchBlock != nullptr) {
+        addLocal(stmt.catchVariable);
         emitStatement(*stmt.catchBlock);
+        endScope();
+    } else {
+        addLocal("");
+        uint8_t exceptionSlot = static_cast<uint8_t>(locals.size() - 1);
+        emitStatement(*stmt.finallyBlock);
+        emitOp(OpCode::GET_LOCAL);
+        emitByte(exceptionSlot);
+        emitOp(OpCode::THROW);
+        // Control never falls out of the rethrow, so the slot needs no POP
+        --scopeDepth;
+        locals.pop_back();
+    }
 
-        // If there's no finally, jump to after the finally block
-        if (stmt.finallyBlock == nullptr) {
-            size_t catchEndJump = emitJump(OpCode::JUMP);
-            patchJump(tryEndJump);
-            patchJump(catchEndJump);
-        } else {
-            // On successful try execution, jump to finally start.
-            // On exception, execution enters catch and then falls through
-            // into finally naturally (no extra jump needed).
-            patchJump(tryEndJump);
-
-            // Emit finally block
-            size_t finallyStart = chunk.code.size();
-            uint16_t finallyOffset = finallyStart - ipAfterTry;
-            chunk.code[finallyOffsetPos] = (finallyOffset >> 8) & 0xff;
-            chunk.code[finallyOffsetPos + 1] = finallyOffset & 0xff;
-
-            emitStatement(*stmt.finallyBlock);
-        }
-    } else if (stmt.finallyBlock != nullptr) {
-        // No catch, but there's finally
-        // Set catch offset to 0 (no catch)
-        chunk.code[catchOffsetPos] = 0;
-        chunk.code[catchOffsetPos + 1] = 0;
-
-        patchJump(tryEndJump);
-
-        // Emit finally block
-        size_t finallyStart = chunk.code.size();
-        uint16_t finallyOffset = finallyStart - ipAfterTry;
-        chunk.code[finallyOffsetPos] = (finallyOffset >> 8) & 0xff;
-        chunk.code[finallyOffsetPos + 1] = finallyOffset & 0xff;
-
+    // A completed try (or catch) block runs the finally block inline
+    patchJump(skipHandler);
+    if (stmt.finallyBlock != nullptr) {
         emitStatement(*stmt.finallyBlock);
-    } else {
-        // No catch or finally - just patch the try end jump
-        chunk.code[catchOffsetPos] = 0;
-        chunk.code[catchOffsetPos + 1] = 0;
-        chunk.code[finallyOffsetPos] = 0;
-        chunk.code[finallyOffsetPos + 1] = 0;
-        patchJump(tryEndJump);
     }
 
-    // Emit END_TRY to clean up the exception handler
-    emitOp(OpCode::END_TRY);
+    // Appended after any nested try statement, so inner entries come first
+    chunk.exceptionTable.push_back(ExceptionTableEntry{static_cast<uint32_t>(tryStart), static_cast<uint32_t>(tryEnd),
+                                                       static_cast<uint32_t>(handlerStart),
+                                                       static_cast<uint32_t>(stackDepth)});
 }
 
 void BytecodeCompiler::visit(ThrowStmt& stmt) {
@@ -890,19 +975,22 @@ void BytecodeCompiler::visit(ClassStmt& stmt) {
     // 2. Create a VmClass with those methods
     // 3. Store the class as a global
 
-    std::unordered_map<std::string, std::shared_ptr<VmCallable>> methods;
+    std::unordered_map<std::string, Ref<VmCallable>> methods;
     std::vector<std::string> fieldNames;
     std::unordered_map<std::string, Value> fieldDefaults;
 
     // Compile methods
     for (const auto& method : stmt.methods) {
         BytecodeCompiler methodCompiler;
+        methodCompiler.inFunction = true;
+        methodCompiler.superclassName = stmt.superclass;
+        methodCompiler.strict = strict;
 
-        // Register allocation: pre-register each parameter as a local variable slot.
-        // VmUserFunction::call() will pass the arguments as initial locals to vm.run(),
-        // so GET_LOCAL 0 retrieves the first argument, etc.
+        // Register allocation: INVOKE (and VmBoundMethod::call) start the frame at
+        // the receiver, so local 0 is 'this' and the parameters follow it.
+        methodCompiler.addLocal("this");
         for (const auto& param : method->params) {
-            methodCompiler.locals.push_back(param);
+            methodCompiler.addLocal(param);
         }
 
         // Compile the method body
@@ -916,7 +1004,7 @@ void BytecodeCompiler::visit(ClassStmt& stmt) {
 
         // Create a VmUserFunction for the method
         auto methodChunk = std::make_shared<Chunk>(std::move(methodCompiler.chunk));
-        auto vmMethod = std::make_shared<VmUserFunction>(method->name, method->params, methodChunk);
+        auto vmMethod = makeRef<VmUserFunction>(method->name, method->params, methodChunk);
 
         methods[method->name] = vmMethod;
     }
@@ -925,12 +1013,15 @@ void BytecodeCompiler::visit(ClassStmt& stmt) {
     // Note: Field initializers are not yet supported in bytecode compilation
     // All fields are initialized to nil; initializers should be set in constructors
     for (const auto& field : stmt.fields) {
+        if (strict && field->initializer) {
+            throw std::runtime_error("Field initializers are not yet supported in bytecode mode.");
+        }
         fieldNames.push_back(field->name);
         fieldDefaults[field->name] = Nil{};
     }
 
     // Create the VmClass (with null superclass; resolved at runtime via INHERIT)
-    auto vmClass = std::make_shared<VmClass>(stmt.name, nullptr, fieldNames, fieldDefaults, methods);
+    auto vmClass = makeRef<VmClass>(stmt.name, nullptr, fieldNames, fieldDefaults, methods);
 
     // Store the class as a constant
     uint8_t constantIndex = makeConstant(vmClass);
@@ -946,14 +1037,27 @@ void BytecodeCompiler::visit(ClassStmt& stmt) {
     }
 
     // Store it in a global variable with the class name
-    uint8_t nameIndex = makeName(stmt.name);
-    emitOp(OpCode::SET_GLOBAL);
-    emitByte(nameIndex);
-    emitOp(OpCode::POP);  // Pop the value left by SET_GLOBAL
+    emitOp(OpCode::SET_GLOBAL_POP);
+    emitByte(makeName(stmt.name));
 }
 
 // v0.3: Property access
 Value BytecodeCompiler::visit(PropertyExpr& expr) {
+    // A property of a local (most often `this.field`) reads the slot directly
+    std::string receiverName;
+    if (auto* variable = dynamic_cast<VariableExpr*>(expr.object.get())) {
+        receiverName = variable->name;
+    } else if (dynamic_cast<ThisExpr*>(expr.object.get()) != nullptr) {
+        receiverName = "this";
+    }
+    int slot = receiverName.empty() ? -1 : resolveLocal(receiverName);
+    if (slot >= 0) {
+        emitOp(OpCode::GET_LOCAL_PROPERTY);
+        emitByte(static_cast<uint8_t>(slot));
+        emitByte(makeName(expr.property));
+        return Nil{};
+    }
+
     // Compile the object expression
     emitExpression(*expr.object);
 
@@ -983,34 +1087,24 @@ Value BytecodeCompiler::visit(SetPropertyExpr& expr) {
 
 // v0.3: This expression
 Value BytecodeCompiler::visit(ThisExpr& expr) {
-    // 'this' is implemented as a global variable lookup
-    // Note: This is a simplified implementation. It works for basic use cases
-    // but has limitations with nested method calls or recursion. See VmBoundMethod
-    // for details. A proper implementation would use local variables or call frames.
-    uint8_t nameIndex = makeName("this");
-    emitOp(OpCode::GET_GLOBAL);
-    emitByte(nameIndex);
-
-    return Nil{};  // Return value not used in visitor pattern
+    // 'this' is local 0 of a method frame; nested functions capture it as an upvalue.
+    // Outside a method this falls through to a global lookup that reports the error.
+    emitGetVariable("this");
+    return Nil{};
 }
 
 // v0.3: Super expression
 Value BytecodeCompiler::visit(SuperExpr& expr) {
-    // For bytecode VM, we implement super as:
-    // 1. Load 'super' (the superclass) - set in method closure during class creation
-    // 2. Load 'this' (the current instance) - bound when method is called
-    // 3. Get the method from the superclass and bind it to this
-    // Note: Both 'super' and 'this' are treated as globals in the simplified VM implementation
-
-    // Load super
-    uint8_t superIndex = makeName("super");
-    emitOp(OpCode::GET_GLOBAL);
-    emitByte(superIndex);
+    // super.method resolves `method` on the superclass the method captured
+    // when its class was created (VmClass::setSuperclass) and binds it to
+    // 'this', so reassigning the superclass's name afterwards does not matter:
+    // 1. Load 'this'
+    // 2. Get the method from the captured superclass and bind it to this
+    if (superclassName.empty()) {
+        throw std::runtime_error("Cannot use 'super' outside of a subclass method.");
+    }
 
-    // Load this
-    uint8_t thisIndex = makeName("this");
-    emitOp(OpCode::GET_GLOBAL);
-    emitByte(thisIndex);
+    emitGetVariable("this");
 
     // Get and bind the method
     uint8_t methodIndex = makeName(expr.method);
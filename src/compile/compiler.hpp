@@ -3,12 +3,17 @@
 #include "ast/stmt.hpp"
 #include "bytecode/opcode.hpp"
 #include "bytecode/chunk.hpp"
+#include "bytecode/vm_user_function.hpp"
 #include <unordered_set>
 #include <string>
 
 namespace izi {
 class BytecodeCompiler : public ExprVisitor, public StmtVisitor {
    public:
+    // Bump when the code emitted for a program changes without a change to
+    // the .izb format, so that cached bytecode (see BytecodeCache) is rebuilt
+    static constexpr uint32_t REVISION = 2;  // 2: every byte carries its source line
+
     BytecodeCompiler() = default;
     Chunk compile(const std::vector<StmtPtr>& program);
 
@@ -64,21 +69,45 @@ class BytecodeCompiler : public ExprVisitor, public StmtVisitor {
     // When non-empty, the compiler is inside a function body and uses
     // GET_LOCAL / SET_LOCAL instead of GET_GLOBAL / SET_GLOBAL for
     // variables whose names appear in this table.
-    std::vector<std::string> locals;  // locals[i] = name of local at slot i
+    struct Local {
+        std::string name;
+        int depth;  // Block nesting depth the local was declared at
+        bool isCaptured = false;  // Referenced by a nested closure; closed with CLOSE_UPVALUE
+    };
+    std::vector<Local> locals;  // locals[i] = local at slot i
+    int scopeDepth = 0;
+
+    // Closure support: the compiler of the lexically enclosing function (nullptr
+    // at top level) and this function's upvalue layout, in GET_UPVALUE index order.
+    BytecodeCompiler* enclosing = nullptr;
+    std::vector<UpvalueDesc> upvalues;
+    std::vector<std::string> upvalueNames;
+
+    // Name of the superclass while compiling a method (or a function nested
+    // in one); empty otherwise.  Used to reject `super` outside a subclass.
+    std::string superclassName;
 
     // True when this compiler instance is compiling a function body.
     // In this mode, VarStmt and FunctionStmt allocate local variable slots
     // on the stack instead of using global variables.
     bool inFunction = false;
 
+    // Reject constructs the VM would otherwise run with different semantics
+    // (class field initializers, which are dropped) instead of compiling them
+    bool strict = false;
+
     // Loop context for break/continue
     struct LoopContext {
         std::vector<size_t> breakJumps;
         size_t loopStart;
+        size_t localCount;  // Locals live when the loop was entered
     };
     std::vector<LoopContext> loopStack;
 
-    void emitByte(uint8_t byte) { chunk.write(byte); }
+    // Source line of the statement being compiled, recorded for every byte
+    int currentLine = 0;
+
+    void emitByte(uint8_t byte) { chunk.write(byte, currentLine); }
     void emitOp(OpCode op) { emitByte(static_cast<uint8_t>(op)); }
 
     uint8_t makeConstant(const Value& b);
@@ -91,10 +120,29 @@ class BytecodeCompiler : public ExprVisitor, public StmtVisitor {
     size_t emitJump(OpCode op);
     void patchJump(size_t offset);
     void emitLoop(size_t loopStart);
+    // Compile a condition followed by a jump taken when it is falsy; the
+    // condition is consumed on both paths.  Returns the offset to patch.
+    size_t emitConditionJump(Expr& condition);
 
     // Register allocation helpers
     // Returns the local slot index for the given name, or -1 if not a local.
     int resolveLocal(const std::string& name) const;
+    void addLocal(const std::string& name);
+    void beginScope();
+    void endScope();
+    // Emit POP / CLOSE_UPVALUE for locals above `count` without forgetting them
+    void emitDiscardLocals(size_t count);
+
+    // Push a variable: local slot, then upvalue, then global
+    void emitGetVariable(const std::string& name);
+
+    // Returns the upvalue index for a variable of an enclosing function, or -1.
+    int resolveUpvalue(const std::string& name);
+
+    // Compile a function body in a child compiler and emit CONSTANT (no
+    // captures) or CLOSURE to push it.
+    void emitFunction(const std::string& name, const std::vector<std::string>& params,
+                      const std::vector<StmtPtr>& body);
 
     // Import helpers
     std::string normalizeModulePath(const std::string& path);
@@ -104,5 +152,9 @@ class BytecodeCompiler : public ExprVisitor, public StmtVisitor {
     // Set current file for relative import resolution
     void setCurrentFile(const std::string& filename) { currentFile = filename; }
     const std::string& getCurrentFile() const { return currentFile; }
+
+    // Strict mode: see `strict`.  Used by `izi compile`, which can fall back
+    // to embedding the interpreter instead.
+    void setStrict(bool enabled) { strict = enabled; }
 };
 }  // namespace izi
@@ -152,10 +152,10 @@ std::string Formatter::formatPattern(const Pattern& pattern) const {
     }
     if (auto* lp = dynamic_cast<const LiteralPattern*>(&pattern)) {
         const Value& v = lp->value;
-        if (std::holds_alternative<Nil>(v)) return "nil";
-        if (std::holds_alternative<bool>(v)) return std::get<bool>(v) ? "true" : "false";
-        if (std::holds_alternative<double>(v)) {
-            double num = std::get<double>(v);
+        if (v.isNil()) return "nil";
+        if (v.isBool()) return v.asBool() ? "true" : "false";
+        if (v.isNumber()) {
+            double num = v.asNumber();
             std::ostringstream oss;
             if (num == std::floor(num) && std::isfinite(num)) {
                 oss << static_cast<long long>(num);
@@ -164,8 +164,8 @@ std::string Formatter::formatPattern(const Pattern& pattern) const {
             }
             return oss.str();
         }
-        if (std::holds_alternative<std::string>(v)) {
-            return "\"" + escapeString(std::get<std::string>(v)) + "\"";
+        if (v.isString()) {
+            return "\"" + escapeString(v.asString()) + "\"";
         }
         return "_";
     }
@@ -248,12 +248,12 @@ void Formatter::formatFunctionBody(const std::vector<std::string>& params,
 
 Value Formatter::visit(LiteralExpr& expr) {
     const Value& v = expr.value;
-    if (std::holds_alternative<Nil>(v)) {
+    if (v.isNil()) {
         currentExpr_ = "nil";
-    } else if (std::holds_alternative<bool>(v)) {
-        currentExpr_ = std::get<bool>(v) ? "true" : "false";
-    } else if (std::holds_alternative<double>(v)) {
-        double num = std::get<double>(v);
+    } else if (v.isBool()) {
+        currentExpr_ = v.asBool() ? "true" : "false";
+    } else if (v.isNumber()) {
+        double num = v.asNumber();
         std::ostringstream oss;
         if (num == std::floor(num) && std::isfinite(num)) {
             oss << static_cast<long long>(num);
@@ -261,8 +261,8 @@ Value Formatter::visit(LiteralExpr& expr) {
             oss << num;
         }
         currentExpr_ = oss.str();
-    } else if (std::holds_alternative<std::string>(v)) {
-        currentExpr_ = "\"" + escapeString(std::get<std::string>(v)) + "\"";
+    } else if (v.isString()) {
+        currentExpr_ = "\"" + escapeString(v.asString()) + "\"";
     } else {
         currentExpr_ = "nil";
     }
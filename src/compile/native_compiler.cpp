@@ -1,4 +1,13 @@
 #include "compile/native_compiler.hpp"
+#include "compile/aot_compiler.hpp"
+#include "compile/compiler.hpp"
+#include "compile/optimizer.hpp"
+#include "bytecode/chunk_serializer.hpp"
+#include "bytecode/vm.hpp"
+#include "bytecode/vm_class.hpp"
+#include "bytecode/vm_native.hpp"
+#include "bytecode/vm_user_function.hpp"
+#include "interp/interpreter.hpp"
 #include "parse/lexer.hpp"
 #include "parse/parser.hpp"
 #include "common/error_reporter.hpp"
@@ -9,40 +18,48 @@
 #include <cstdlib>
 #include <ctime>
 #include <algorithm>
+#include <unordered_set>
 #include <unistd.h>  // for getpid()
 
 namespace fs = std::filesystem;
 
 namespace izi {
 
-std::string NativeCompiler::escapeString(const std::string& str) {
-    std::string escaped;
-    escaped.reserve(str.size() * 1.2);  // Reserve some extra space
-
-    for (char c : str) {
-        switch (c) {
-            case '\\':
-                escaped += "\\\\";
-                break;
-            case '"':
-                escaped += "\\\"";
-                break;
-            case '\n':
-                escaped += "\\n";
-                break;
-            case '\r':
-                escaped += "\\r";
-                break;
-            case '\t':
-                escaped += "\\t";
-                break;
-            default:
-                escaped += c;
-                break;
-        }
+bool NativeCompiler::generateAotSource(const Chunk& script, const std::string& outputPath) {
+    std::ofstream out(outputPath);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot create generated source file: " << outputPath << "\n";
+        return false;
     }
 
-    return escaped;
+    try {
+        AotCompiler::generate(script, out);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return false;
+    }
+
+    // Startup goes straight to the VM: nothing is lexed, parsed or compiled
+    out << "\n";
+    out << "#include \"bytecode/vm_native.hpp\"\n";
+    out << "#include <iostream>\n";
+    out << "\n";
+    out << "int main() {\n";
+    out << "    try {\n";
+    out << "        std::shared_ptr<Chunk> script = aotScriptChunk();\n";
+    out << "        VM vm;\n";
+    out << "        registerVmNatives(vm);\n";
+    out << "        vm.enableAotCode();\n";
+    out << "        (void)vm.run(*script);\n";
+    out << "        return vm.hadUncaughtError() ? 1 : 0;\n";
+    out << "    } catch (const std::exception& e) {\n";
+    out << "        std::cerr << \"Error: \" << e.what() << '\\n';\n";
+    out << "        return 1;\n";
+    out << "    }\n";
+    out << "}\n";
+
+    out.close();
+    return out.good();
 }
 
 bool NativeCompiler::generateEmbeddedSource(const std::string& sourceCode, const std::string& outputPath) {
@@ -116,6 +133,99 @@ bool NativeCompiler::generateEmbeddedSource(const std::string& sourceCode, const
     return true;
 }
 
+bool NativeCompiler::generateBytecodeSource(const Chunk& script, const std::string& outputPath) {
+    std::string image;
+    try {
+        image = ChunkSerializer::serialize(script);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return false;
+    }
+
+    std::ofstream out(outputPath);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot create generated source file: " << outputPath << "\n";
+        return false;
+    }
+
+    out << "// Generated by izi compile --bytecode - do not edit\n";
+    out << "#include \"bytecode/chunk_serializer.hpp\"\n";
+    out << "#include \"bytecode/vm.hpp\"\n";
+    out << "#include \"bytecode/vm_native.hpp\"\n";
+    out << "#include <iostream>\n";
+    out << "\n";
+    out << "using namespace izi;\n";
+    out << "\n";
+    out << "// The program and every file it imports, in the .izb format\n";
+    out << "alignas(8) static const unsigned char PROGRAM[] = {";
+    for (size_t i = 0; i < image.size(); ++i) {
+        out << (i % 16 == 0 ? "\n    " : " ") << static_cast<unsigned>(static_cast<unsigned char>(image[i])) << ",";
+    }
+    out << "\n};\n";
+    out << "\n";
+    out << "int main() {\n";
+    out << "    try {\n";
+    out << "        // Read in place from .rodata: nothing is lexed, parsed or compiled\n";
+    out << "        Chunk script = ChunkSerializer::deserialize(PROGRAM, sizeof(PROGRAM));\n";
+    out << "        VM vm;\n";
+    out << "        registerVmNatives(vm);\n";
+    out << "        (void)vm.run(script);\n";
+    out << "        return vm.hadUncaughtError() ? 1 : 0;\n";
+    out << "    } catch (const std::exception& e) {\n";
+    out << "        std::cerr << \"Error: \" << e.what() << '\\n';\n";
+    out << "        return 1;\n";
+    out << "    }\n";
+    out << "}\n";
+
+    out.close();
+    return out.good();
+}
+
+std::string NativeCompiler::findInterpreterOnlyName(const Chunk& script) {
+    // Globals the interpreter defines but the VM does not (threads, str, ...)
+    Interpreter interp;
+    VM vm;
+    registerVmNatives(vm);
+    auto vmGlobals = vm.getGlobals();
+    std::unordered_set<std::string> interpreterOnly;
+    for (const auto& [name, value] : interp.getGlobals()->getAll()) {
+        if (vmGlobals.find(name) == vmGlobals.end()) {
+            interpreterOnly.insert(name);
+        }
+    }
+
+    // Names of the script and of every function and method nested in it.
+    // Property names are included too, which can only cause a needless fallback.
+    std::vector<const Chunk*> pending{&script};
+    std::unordered_set<const Chunk*> seen;
+    while (!pending.empty()) {
+        const Chunk* chunk = pending.back();
+        pending.pop_back();
+        if (!seen.insert(chunk).second) {
+            continue;
+        }
+        for (const auto& name : chunk->names) {
+            if (interpreterOnly.count(name) != 0) {
+                return name;
+            }
+        }
+        for (const auto& constant : chunk->constants) {
+            if (constant.isVmCallable()) {
+                if (auto function = dynamicRefCast<VmUserFunction>(constant.asVmCallable())) {
+                    pending.push_back(&function->getChunk());
+                }
+            } else if (constant.isVmClass()) {
+                for (const auto& [name, method] : constant.asVmClass()->methods) {
+                    if (auto function = dynamicRefCast<VmUserFunction>(method)) {
+                        pending.push_back(&function->getChunk());
+                    }
+                }
+            }
+        }
+    }
+    return "";
+}
+
 std::string NativeCompiler::getCompilerCommand() {
     // Try to detect available compiler
     // Note: Could cache this result for performance, but detection is fast enough
@@ -132,24 +242,16 @@ std::string NativeCompiler::getCompilerCommand() {
 }
 
 std::vector<std::string> NativeCompiler::getSourceFiles() {
-    // Get the source directory path relative to where the izi binary is
-    std::vector<std::string> sources = {"src/parse/lexer.cpp",
-                                        "src/parse/parser.cpp",
-                                        "src/interp/interpreter.cpp",
-                                        "src/interp/native.cpp",
-                                        "src/interp/user_function.cpp",
-                                        "src/interp/izi_class.cpp",
-                                        "src/interp/native_modules.cpp",
-                                        "src/compile/compiler.cpp",
-                                        "src/bytecode/vm.cpp",
-                                        "src/bytecode/vm_native.cpp",
-                                        "src/bytecode/vm_user_function.cpp",
-                                        "src/bytecode/vm_class.cpp",
-                                        "src/common/error_reporter.cpp",
-                                        "src/common/value.cpp",
-                                        "src/common/semantic_analyzer.cpp",
-                                        "src/ast/type.cpp"};
-
+    // The whole runtime except the CLI, relative to the source tree root
+    std::vector<std::string> sources;
+    std::error_code error;
+    for (const auto& entry : fs::recursive_directory_iterator("src", error)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".cpp" &&
+            entry.path() != fs::path("src") / "main.cpp") {
+            sources.push_back(entry.path().generic_string());
+        }
+    }
+    std::sort(sources.begin(), sources.end());
     return sources;
 }
 
@@ -194,7 +296,7 @@ bool NativeCompiler::compileToExecutable(const std::string& cppFile, const Compi
     cmd << "-o " << options.outputFile << " ";
 
     // Link libraries statically
-    cmd << "-lm -lpthread ";
+    cmd << "-lm -ldl -lpthread ";
 
     // Suppress warnings for a cleaner build
     cmd << "2>&1";
@@ -237,19 +339,36 @@ bool NativeCompiler::compile(const CompileOptions& options) {
     std::string sourceCode = buffer.str();
     inFile.close();
 
-    // Validate the source code by parsing it
+    // Compile to bytecode the way `izi run --vm` does; imports are inlined.
+    // Programs the VM cannot run as the interpreter would are embedded as
+    // source and run on the interpreter instead.
+    Chunk script;
+    std::string fallbackReason;
     try {
         if (options.verbose) {
-            std::cout << "Validating source code...\n";
+            std::cout << "Compiling to bytecode...\n";
         }
 
         Lexer lex(sourceCode);
         auto tokens = lex.scanTokens();
         Parser parser(std::move(tokens), sourceCode);
         auto program = parser.parse();
-
-        if (options.verbose) {
-            std::cout << "Source code validated successfully.\n";
+        Optimizer optimizer;
+        program = optimizer.optimize(std::move(program));
+
+        try {
+            std::unordered_set<std::string> importedModules;
+            BytecodeCompiler compiler;
+            compiler.setCurrentFile(fs::absolute(options.inputFile).string());
+            compiler.setImportedModules(&importedModules);
+            compiler.setStrict(true);
+            script = compiler.compile(program);
+            std::string name = findInterpreterOnlyName(script);
+            if (!name.empty()) {
+                fallbackReason = "'" + name + "' is only available in the interpreter.";
+            }
+        } catch (const std::runtime_error& e) {
+            fallbackReason = e.what();
         }
     } catch (const LexerError& e) {
         ErrorReporter reporter(sourceCode);
@@ -262,10 +381,14 @@ bool NativeCompiler::compile(const CompileOptions& options) {
         std::cerr << reporter.formatError(e.token, e.what(), "Parse Error") << '\n';
         return false;
     } catch (const std::exception& e) {
-        std::cerr << "Error validating source: " << e.what() << "\n";
+        std::cerr << "Error compiling source: " << e.what() << "\n";
         return false;
     }
 
+    if (!fallbackReason.empty()) {
+        std::cout << "Note: embedding the source for the interpreter: " << fallbackReason << "\n";
+    }
+
     // Create temporary directory for generated files
     // Use a combination of timestamp and process ID for uniqueness
     std::stringstream tempDirName;
@@ -277,13 +400,21 @@ bool NativeCompiler::compile(const CompileOptions& options) {
         std::cout << "Using temporary directory: " << tempDir << "\n";
     }
 
-    // Generate embedded source file
-    fs::path genCppFile = tempDir / "embedded_main.cpp";
+    // Translate the bytecode to C++, or embed the bytecode or the source
+    bool embedSource = !fallbackReason.empty();
+    fs::path genCppFile = tempDir / (embedSource        ? "embedded_main.cpp"
+                                     : options.bytecode ? "bytecode_main.cpp"
+                                                        : "aot_main.cpp");
     if (options.verbose) {
-        std::cout << "Generating embedded source file...\n";
+        std::cout << (embedSource        ? "Generating embedded source file...\n"
+                      : options.bytecode ? "Embedding bytecode...\n"
+                                         : "Generating C++ from bytecode...\n");
     }
 
-    if (!generateEmbeddedSource(sourceCode, genCppFile.string())) {
+    bool generated = embedSource        ? generateEmbeddedSource(sourceCode, genCppFile.string())
+                     : options.bytecode ? generateBytecodeSource(script, genCppFile.string())
+                                        : generateAotSource(script, genCppFile.string());
+    if (!generated) {
         fs::remove_all(tempDir);
         return false;
     }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "bytecode/chunk.hpp"
 #include <string>
 #include <vector>
 
@@ -9,9 +10,15 @@ namespace izi {
  * NativeCompiler - Compiles IziLang source code to native executables
  *
  * This compiler generates a standalone executable by:
- * 1. Embedding the source code into a C++ file
- * 2. Compiling that C++ file with the IziLang interpreter
- * 3. Statically linking all dependencies
+ * 1. Compiling the program (and the files it imports) to bytecode
+ * 2. Translating the bytecode to C++ (see AotCompiler), or with `bytecode`
+ *    set, embedding the serialized bytecode as a constant array
+ * 3. Compiling that C++ file against the VM runtime, statically linked
+ *
+ * Programs the VM cannot run the way the interpreter does (constructs the
+ * bytecode compiler rejects, interpreter-only natives) fall back to
+ * embedding the source and running it on the tree-walking interpreter.
+ * Either way the executable exits with 1 on an uncaught error.
  */
 class NativeCompiler {
    public:
@@ -20,6 +27,7 @@ class NativeCompiler {
         std::string outputFile;  // Output executable name
         bool debug = false;  // Include debug symbols
         bool verbose = false;  // Print compilation steps
+        bool bytecode = false;  // Embed bytecode for the VM instead of translating it to C++
     };
 
     /**
@@ -31,13 +39,36 @@ class NativeCompiler {
 
    private:
     /**
-     * Generate C++ code that embeds the IziLang source
+     * Generate the C++ translation of a program plus a main() that runs it
+     * @param script The program's top-level chunk
+     * @param outputPath Path to write the generated C++ file
+     * @return true if successful
+     */
+    static bool generateAotSource(const Chunk& script, const std::string& outputPath);
+
+    /**
+     * Generate C++ code that embeds the IziLang source for the interpreter
      * @param sourceCode The IziLang source code to embed
      * @param outputPath Path to write the generated C++ file
      * @return true if successful
      */
     static bool generateEmbeddedSource(const std::string& sourceCode, const std::string& outputPath);
 
+    /**
+     * Generate C++ that embeds the serialized program and runs it on the VM
+     * @param script The program's top-level chunk
+     * @param outputPath Path to write the generated C++ file
+     * @return true if successful
+     */
+    static bool generateBytecodeSource(const Chunk& script, const std::string& outputPath);
+
+    /**
+     * Find a global the program uses that only the interpreter defines
+     * @param script The program's top-level chunk
+     * @return The first such name, or an empty string if there is none
+     */
+    static std::string findInterpreterOnlyName(const Chunk& script);
+
     /**
      * Compile the generated C++ file to a native executable
      * @param cppFile Path to the generated C++ file
@@ -46,13 +77,6 @@ class NativeCompiler {
      */
     static bool compileToExecutable(const std::string& cppFile, const CompileOptions& options);
 
-    /**
-     * Escape a string for C++ string literal
-     * @param str String to escape
-     * @return Escaped string
-     */
-    static std::string escapeString(const std::string& str);
-
     /**
      * Get the compiler command for the current platform
      * @return Compiler command (e.g., "g++", "clang++")
@@ -1,9 +1,11 @@
 #include "optimizer.hpp"
+#include "common/trace.hpp"
 #include <cmath>
 
 namespace izi {
 
 std::vector<StmtPtr> Optimizer::optimize(std::vector<StmtPtr> program) {
+    TraceScope trace("compile", "optimize");
     std::vector<StmtPtr> optimized;
     for (auto& stmt : program) {
         auto opt = optimizeStmt(std::move(stmt));
@@ -30,6 +32,11 @@ StmtPtr Optimizer::optimizeStmt(StmtPtr stmt) {
     // Visit the statement to optimize it
     stmt->accept(*this);
 
+    // Rebuilt statements keep the source line (debugger, profiler, VM line table)
+    if (currentStmt && currentStmt->line == 0) {
+        currentStmt->line = stmt->line;
+    }
+
     // Return the optimized statement
     return std::move(currentStmt);
 }
@@ -40,12 +47,12 @@ bool Optimizer::isConstant(const Expr& expr) const {
 
 Value Optimizer::evaluateConstantBinary(const Value& left, TokenType op, const Value& right) {
     // Only handle number operations for now
-    if (!std::holds_alternative<double>(left) || !std::holds_alternative<double>(right)) {
+    if (!left.isNumber() || !right.isNumber()) {
         return Nil{};  // Not a constant we can fold
     }
 
-    double l = std::get<double>(left);
-    double r = std::get<double>(right);
+    double l = left.asNumber();
+    double r = right.asNumber();
 
     switch (op) {
         case TokenType::PLUS:
@@ -76,8 +83,8 @@ Value Optimizer::evaluateConstantBinary(const Value& left, TokenType op, const V
 Value Optimizer::evaluateConstantUnary(TokenType op, const Value& right) {
     switch (op) {
         case TokenType::MINUS:
-            if (std::holds_alternative<double>(right)) {
-                return -std::get<double>(right);
+            if (right.isNumber()) {
+                return -right.asNumber();
             }
             break;
         case TokenType::BANG:
@@ -103,7 +110,7 @@ Value Optimizer::visit(BinaryExpr& expr) {
         Value result = evaluateConstantBinary(leftLit->value, expr.op.type, rightLit->value);
 
         // If we got a valid result, return a literal expression
-        if (!std::holds_alternative<Nil>(result)) {
+        if (!result.isNil()) {
             currentExpr = std::make_unique<LiteralExpr>(result);
             return result;
         }
@@ -125,7 +132,7 @@ Value Optimizer::visit(UnaryExpr& expr) {
         auto* rightLit = static_cast<LiteralExpr*>(right.get());
         Value result = evaluateConstantUnary(expr.op.type, rightLit->value);
 
-        if (!std::holds_alternative<Nil>(result)) {
+        if (!result.isNil()) {
             currentExpr = std::make_unique<LiteralExpr>(result);
             return result;
         }
@@ -1,6 +1,8 @@
-// Simplified upvalue analysis for bytecode compilation
-// This visitor collects variable names referenced in an expression that
-// are not parameters or local declarations.
+// Upvalue analysis for bytecode compilation
+// This visitor collects the free variables of a function body: names that
+// are referenced (directly or by a nested function) but not declared as a
+// parameter or local in scope at the point of use.  The compiler resolves
+// each one against the enclosing functions to fix the closure's upvalue layout.
 
 #pragma once
 
@@ -92,8 +94,8 @@ class UpvalueCollector : public ExprVisitor, public StmtVisitor {
 
     Value visit(ConditionalExpr& expr) override {
         expr.condition->accept(*this);
-        expr.thenExpr->accept(*this);
-        expr.elseExpr->accept(*this);
+        expr.thenBranch->accept(*this);
+        expr.elseBranch->accept(*this);
         return Nil{};
     }
 
@@ -117,20 +119,23 @@ class UpvalueCollector : public ExprVisitor, public StmtVisitor {
     }
 
     Value visit(IndexExpr& expr) override {
-        expr.object->accept(*this);
+        expr.collection->accept(*this);
         expr.index->accept(*this);
         return Nil{};
     }
 
     Value visit(SetIndexExpr& expr) override {
-        expr.object->accept(*this);
+        expr.collection->accept(*this);
         expr.index->accept(*this);
         expr.value->accept(*this);
         return Nil{};
     }
 
     Value visit(FunctionExpr& expr) override {
-        // Don't descend into nested functions
+        // A nested function's free variables must be threaded through this one
+        for (const auto& name : collectFromStatements(expr.body, expr.params)) {
+            addIfNotLocal(name);
+        }
         return Nil{};
     }
 
@@ -152,15 +157,17 @@ class UpvalueCollector : public ExprVisitor, public StmtVisitor {
     }
 
     Value visit(ThisExpr& expr) override {
+        addIfNotLocal("this");
         return Nil{};
     }
 
     Value visit(SuperExpr& expr) override {
+        addIfNotLocal("this");
         return Nil{};
     }
 
     Value visit(AwaitExpr& expr) override {
-        expr.argument->accept(*this);
+        expr.value->accept(*this);
         return Nil{};
     }
 
@@ -185,9 +192,11 @@ class UpvalueCollector : public ExprVisitor, public StmtVisitor {
     }
 
     void visit(BlockStmt& stmt) override {
+        size_t scopeStart = locals_.size();
         for (const auto& s : stmt.statements) {
             s->accept(*this);
         }
+        locals_.resize(scopeStart);
     }
 
     void visit(VarStmt& stmt) override {
@@ -197,6 +206,9 @@ class UpvalueCollector : public ExprVisitor, public StmtVisitor {
 
     void visit(FunctionStmt& stmt) override {
         if (!stmt.name.empty()) locals_.push_back(stmt.name);
+        for (const auto& name : collectFromStatements(stmt.body, stmt.params)) {
+            addIfNotLocal(name);
+        }
     }
 
     void visit(ImportStmt& stmt) override {}
@@ -207,7 +219,13 @@ class UpvalueCollector : public ExprVisitor, public StmtVisitor {
 
     void visit(TryStmt& stmt) override {
         stmt.tryBlock->accept(*this);
-        if (stmt.catchBlock) stmt.catchBlock->accept(*this);
+        if (stmt.catchBlock) {
+            // The catch variable is a local of the catch block
+            size_t scopeStart = locals_.size();
+            locals_.push_back(stmt.catchVariable);
+            stmt.catchBlock->accept(*this);
+            locals_.resize(scopeStart);
+        }
         if (stmt.finallyBlock) stmt.finallyBlock->accept(*this);
     }
 
@@ -0,0 +1,475 @@
+#include "closure_compiler.hpp"
+
+#include <functional>
+#include <utility>
+
+#include "common/callable.hpp"
+#include "common/gc.hpp"
+
+namespace izi {
+
+namespace {
+
+using Type = Completion::Type;
+
+}  // namespace
+
+std::shared_ptr<CompiledBlock> ClosureCompiler::compile(const std::vector<StmtPtr>& statements) {
+    ClosureCompiler compiler;
+    return compiler.compileBlock(statements);
+}
+
+void ClosureCompiler::execute(const CompiledBlock& block, Interpreter& interp) {
+    for (const auto& statement : block.statements) {
+        if (interp.debugHook_ && statement.line > 0) {
+            interp.debugHook_->onStatement(statement.line, interp.currentFile);
+        }
+        statement.run(interp);
+        if (interp.completion_.abrupt()) {
+            return;
+        }
+    }
+}
+
+Completion ClosureCompiler::run(const CompiledBlock& block, Interpreter& interp, Environment* scope) {
+    executeIn(block, interp, scope);
+    if (!interp.completion_.abrupt()) {
+        return {};
+    }
+    return std::exchange(interp.completion_, Completion{});
+}
+
+void ClosureCompiler::executeIn(const CompiledBlock& block, Interpreter& interp, Environment* scope) {
+    Environment* previous = interp.env;
+    interp.env = scope;
+    try {
+        execute(block, interp);
+    } catch (...) {
+        interp.env = previous;
+        throw;
+    }
+    interp.env = previous;
+}
+
+CompiledExpr ClosureCompiler::compile(Expr& expr) {
+    expr.accept(*this);
+    return std::move(expr_);
+}
+
+CompiledStmt ClosureCompiler::compile(Stmt& stmt) {
+    stmt.accept(*this);
+    return std::move(stmt_);
+}
+
+std::shared_ptr<CompiledBlock> ClosureCompiler::compileBlock(const std::vector<StmtPtr>& statements) {
+    auto block = std::make_shared<CompiledBlock>();
+    block->statements.reserve(statements.size());
+    for (const auto& stmt : statements) {
+        if (stmt) {  // Skip null statements from parser errors
+            block->statements.push_back({compile(*stmt), stmt->line});
+        }
+    }
+    return block;
+}
+
+CompiledExpr ClosureCompiler::interpreted(Expr& expr) {
+    return [&expr](Interpreter& in) { return expr.accept(in); };
+}
+
+CompiledStmt ClosureCompiler::interpreted(Stmt& stmt) {
+    return [&stmt](Interpreter& in) { stmt.accept(in); };
+}
+
+// A number operator whose operands are numbers in the common case: those
+// skip the interpreter's type checks, anything else goes through them
+template <typename Op>
+CompiledExpr ClosureCompiler::numberOp(const BinaryExpr& expr, CompiledExpr left, CompiledExpr right) {
+    const Token& op = expr.op;
+    if (auto* literal = dynamic_cast<const LiteralExpr*>(expr.right.get()); literal && literal->value.isNumber()) {
+        // A number on the right, as in `n - 1` or `i < 10`
+        return [&op, left = std::move(left), constant = literal->value.asNumber()](Interpreter& in) -> Value {
+            Value l = left(in);
+            if (l.isNumber()) {
+                return Op{}(l.asNumber(), constant);
+            }
+            return in.binaryOp(op, l, Value{constant});
+        };
+    }
+    return [&op, left = std::move(left), right = std::move(right)](Interpreter& in) -> Value {
+        Value l = left(in);
+        Value r = right(in);
+        if (l.isNumber() && r.isNumber()) {
+            return Op{}(l.asNumber(), r.asNumber());
+        }
+        return in.binaryOp(op, l, r);
+    };
+}
+
+// Expressions
+
+Value ClosureCompiler::visit(BinaryExpr& expr) {
+    CompiledExpr left = compile(*expr.left);
+    CompiledExpr right = compile(*expr.right);
+
+    switch (expr.op.type) {
+        case TokenType::OR:
+            expr_ = [left = std::move(left), right = std::move(right)](Interpreter& in) {
+                Value l = left(in);
+                return isTruthy(l) ? l : right(in);
+            };
+            break;
+        case TokenType::AND:
+            expr_ = [left = std::move(left), right = std::move(right)](Interpreter& in) {
+                Value l = left(in);
+                return isTruthy(l) ? right(in) : l;
+            };
+            break;
+        case TokenType::QUESTION_QUESTION:
+            expr_ = [left = std::move(left), right = std::move(right)](Interpreter& in) {
+                Value l = left(in);
+                return l.isNil() ? right(in) : l;
+            };
+            break;
+        case TokenType::EQUAL_EQUAL:
+            expr_ = [left = std::move(left), right = std::move(right)](Interpreter& in) -> Value {
+                Value l = left(in);
+                return l == right(in);
+            };
+            break;
+        case TokenType::BANG_EQUAL:
+            expr_ = [left = std::move(left), right = std::move(right)](Interpreter& in) -> Value {
+                Value l = left(in);
+                return l != right(in);
+            };
+            break;
+        case TokenType::PLUS:
+            expr_ = numberOp<std::plus<double>>(expr, std::move(left), std::move(right));
+            break;
+        case TokenType::MINUS:
+            expr_ = numberOp<std::minus<double>>(expr, std::move(left), std::move(right));
+            break;
+        case TokenType::STAR:
+            expr_ = numberOp<std::multiplies<double>>(expr, std::move(left), std::move(right));
+            break;
+        case TokenType::SLASH:
+            expr_ = numberOp<std::divides<double>>(expr, std::move(left), std::move(right));
+            break;
+        case TokenType::GREATER:
+            expr_ = numberOp<std::greater<double>>(expr, std::move(left), std::move(right));
+            break;
+        case TokenType::GREATER_EQUAL:
+            expr_ = numberOp<std::greater_equal<double>>(expr, std::move(left), std::move(right));
+            break;
+        case TokenType::LESS:
+            expr_ = numberOp<std::less<double>>(expr, std::move(left), std::move(right));
+            break;
+        case TokenType::LESS_EQUAL:
+            expr_ = numberOp<std::less_equal<double>>(expr, std::move(left), std::move(right));
+            break;
+        default:
+            // `%` and anything the interpreter rejects
+            expr_ = [&op = expr.op, left = std::move(left), right = std::move(right)](Interpreter& in) {
+                Value l = left(in);
+                Value r = right(in);
+                return in.binaryOp(op, l, r);
+            };
+            break;
+    }
+    return Nil{};
+}
+
+Value ClosureCompiler::visit(UnaryExpr& expr) {
+    CompiledExpr right = compile(*expr.right);
+    switch (expr.op.type) {
+        case TokenType::MINUS:
+            expr_ = [&op = expr.op, right = std::move(right)](Interpreter& in) -> Value {
+                Value r = right(in);
+                return -(r.isNumber() ? r.asNumber() : in.toNumber(r, op));
+            };
+            break;
+        case TokenType::BANG:
+            expr_ = [right = std::move(right)](Interpreter& in) -> Value { return !isTruthy(right(in)); };
+            break;
+        default:
+            expr_ = interpreted(expr);
+            break;
+    }
+    return Nil{};
+}
+
+Value ClosureCompiler::visit(LiteralExpr& expr) {
+    expr_ = [value = expr.value](Interpreter&) { return value; };
+    return Nil{};
+}
+
+Value ClosureCompiler::visit(GroupingExpr& expr) {
+    expr_ = compile(*expr.expression);
+    return Nil{};
+}
+
+Value ClosureCompiler::visit(ConditionalExpr& expr) {
+    CompiledExpr condition = compile(*expr.condition);
+    CompiledExpr thenBranch = compile(*expr.thenBranch);
+    CompiledExpr elseBranch = compile(*expr.elseBranch);
+    expr_ = [condition = std::move(condition), thenBranch = std::move(thenBranch),
+             elseBranch = std::move(elseBranch)](Interpreter& in) {
+        return isTruthy(condition(in)) ? thenBranch(in) : elseBranch(in);
+    };
+    return Nil{};
+}
+
+Value ClosureCompiler::visit(CallExpr& expr) {
+    CompiledExpr callee = compile(*expr.callee);
+    std::vector<CompiledExpr> args;
+    args.reserve(expr.args.size());
+    for (const auto& arg : expr.args) {
+        args.push_back(compile(*arg));
+    }
+    expr_ = [callee = std::move(callee), args = std::move(args)](Interpreter& in) {
+        auto callable = in.calleeOf(callee(in));
+        std::vector<Value> arguments;
+        arguments.reserve(args.size());
+        for (const auto& arg : args) {
+            arguments.push_back(arg(in));
+        }
+        return in.callWith(*callable, arguments);
+    };
+    return Nil{};
+}
+
+Value ClosureCompiler::visit(VariableExpr& expr) {
+    const VarSlot slot = expr.slot;
+    if (slot.resolved() && !slot.checked) {
+        // Always defined where it is read: go straight to the slot
+        if (slot.depth == 0) {
+            expr_ = [index = slot.slot](Interpreter& in) { return in.env->at(index); };
+        } else {
+            expr_ = [slot](Interpreter& in) { return in.env->ancestor(slot.depth)->at(slot.slot); };
+        }
+    } else {
+        expr_ = [&expr](Interpreter& in) { return in.lookUp(expr.name, expr.slot); };
+    }
+    return Nil{};
+}
+
+Value ClosureCompiler::visit(AssignExpr& expr) {
+    CompiledExpr value = compile(*expr.value);
+    const VarSlot slot = expr.slot;
+    if (slot.resolved() && !slot.checked) {
+        expr_ = [slot, value = std::move(value)](Interpreter& in) {
+            Value v = value(in);
+            in.env->ancestor(slot.depth)->at(slot.slot) = v;
+            return v;
+        };
+    } else {
+        expr_ = [&expr, value = std::move(value)](Interpreter& in) {
+            Value v = value(in);
+            in.assignTo(expr.name, expr.slot, v);
+            return v;
+        };
+    }
+    return Nil{};
+}
+
+Value ClosureCompiler::visit(ArrayExpr& expr) {
+    expr_ = interpreted(expr);
+    return Nil{};
+}
+
+Value ClosureCompiler::visit(MapExpr& expr) {
+    expr_ = interpreted(expr);
+    return Nil{};
+}
+
+Value ClosureCompiler::visit(SpreadExpr& expr) {
+    expr_ = interpreted(expr);
+    return Nil{};
+}
+
+Value ClosureCompiler::visit(IndexExpr& expr) {
+    CompiledExpr collection = compile(*expr.collection);
+    CompiledExpr index = compile(*expr.index);
+    expr_ = [collection = std::move(collection), index = std::move(index)](Interpreter& in) {
+        Value c = collection(in);
+        Value i = index(in);
+        return in.getIndex(c, i);
+    };
+    return Nil{};
+}
+
+Value ClosureCompiler::visit(SetIndexExpr& expr) {
+    CompiledExpr collection = compile(*expr.collection);
+    CompiledExpr index = compile(*expr.index);
+    CompiledExpr value = compile(*expr.value);
+    expr_ = [collection = std::move(collection), index = std::move(index), value = std::move(value)](Interpreter& in) {
+        Value c = collection(in);
+        Value i = index(in);
+        Value v = value(in);
+        return in.setIndex(c, i, v);
+    };
+    return Nil{};
+}
+
+Value ClosureCompiler::visit(FunctionExpr& expr) {
+    expr_ = interpreted(expr);
+    return Nil{};
+}
+
+Value ClosureCompiler::visit(MatchExpr& expr) {
+    expr_ = interpreted(expr);
+    return Nil{};
+}
+
+Value ClosureCompiler::visit(PropertyExpr& expr) {
+    CompiledExpr object = compile(*expr.object);
+    expr_ = [&property = expr.property, object = std::move(object)](Interpreter& in) {
+        return in.getProperty(object(in), property);
+    };
+    return Nil{};
+}
+
+Value ClosureCompiler::visit(SetPropertyExpr& expr) {
+    CompiledExpr object = compile(*expr.object);
+    CompiledExpr value = compile(*expr.value);
+    expr_ = [&property = expr.property, object = std::move(object), value = std::move(value)](Interpreter& in) {
+        Value o = object(in);
+        Value v = value(in);
+        return in.setProperty(o, property, v);
+    };
+    return Nil{};
+}
+
+Value ClosureCompiler::visit(ThisExpr& expr) {
+    expr_ = interpreted(expr);
+    return Nil{};
+}
+
+Value ClosureCompiler::visit(SuperExpr& expr) {
+    expr_ = interpreted(expr);
+    return Nil{};
+}
+
+Value ClosureCompiler::visit(AwaitExpr& expr) {
+    expr_ = interpreted(expr);
+    return Nil{};
+}
+
+// Statements
+
+void ClosureCompiler::visit(ExprStmt& stmt) {
+    stmt_ = [expr = compile(*stmt.expr)](Interpreter& in) { expr(in); };
+}
+
+void ClosureCompiler::visit(BlockStmt& stmt) {
+    stmt_ = [&layout = stmt.scope, block = compileBlock(stmt.statements)](Interpreter& in) {
+        auto blockEnv = in.arena_.enter(in.env, layout);
+        executeIn(*block, in, blockEnv.get());
+    };
+}
+
+void ClosureCompiler::visit(VarStmt& stmt) {
+    if (stmt.pattern || stmt.slot == NO_SLOT) {
+        stmt_ = interpreted(stmt);
+        return;
+    }
+    uint32_t slot = stmt.slot;
+    if (!stmt.initializer) {
+        stmt_ = [slot](Interpreter& in) { in.env->defineAt(slot, Nil{}); };
+        return;
+    }
+    stmt_ = [slot, initializer = compile(*stmt.initializer)](Interpreter& in) {
+        in.env->defineAt(slot, initializer(in));
+    };
+}
+
+void ClosureCompiler::visit(WhileStmt& stmt) {
+    stmt_ = [condition = compile(*stmt.condition), body = compile(*stmt.body)](Interpreter& in) {
+        while (isTruthy(condition(in))) {
+            Gc::maybeCollect();
+            body(in);
+            Completion& completion = in.completion_;
+            if (completion.abrupt()) {
+                if (completion.type == Type::Break) {
+                    completion = {};
+                    break;
+                }
+                if (completion.type == Type::Continue) {
+                    completion = {};
+                    continue;
+                }
+                return;  // Returns and throws leave the loop too
+            }
+        }
+    };
+}
+
+void ClosureCompiler::visit(IfStmt& stmt) {
+    CompiledExpr condition = compile(*stmt.condition);
+    CompiledStmt thenBranch = compile(*stmt.thenBranch);
+    if (!stmt.elseBranch) {
+        stmt_ = [condition = std::move(condition), thenBranch = std::move(thenBranch)](Interpreter& in) {
+            if (isTruthy(condition(in))) {
+                thenBranch(in);
+            }
+        };
+        return;
+    }
+    stmt_ = [condition = std::move(condition), thenBranch = std::move(thenBranch),
+             elseBranch = compile(*stmt.elseBranch)](Interpreter& in) {
+        if (isTruthy(condition(in))) {
+            thenBranch(in);
+        } else {
+            elseBranch(in);
+        }
+    };
+}
+
+void ClosureCompiler::visit(FunctionStmt& stmt) {
+    stmt_ = interpreted(stmt);
+}
+
+void ClosureCompiler::visit(ReturnStmt& stmt) {
+    if (!stmt.value) {
+        stmt_ = [](Interpreter& in) { in.completion_ = Completion{Type::Return, Nil{}}; };
+        return;
+    }
+    stmt_ = [value = compile(*stmt.value)](Interpreter& in) {
+        in.completion_ = Completion{Type::Return, value(in)};
+    };
+}
+
+void ClosureCompiler::visit(ImportStmt& stmt) {
+    stmt_ = interpreted(stmt);
+}
+
+void ClosureCompiler::visit(ExportStmt& stmt) {
+    stmt_ = interpreted(stmt);
+}
+
+void ClosureCompiler::visit(ReExportStmt& stmt) {
+    stmt_ = interpreted(stmt);
+}
+
+void ClosureCompiler::visit(BreakStmt& /*stmt*/) {
+    stmt_ = [](Interpreter& in) { in.completion_.type = Type::Break; };
+}
+
+void ClosureCompiler::visit(ContinueStmt& /*stmt*/) {
+    stmt_ = [](Interpreter& in) { in.completion_.type = Type::Continue; };
+}
+
+void ClosureCompiler::visit(TryStmt& stmt) {
+    stmt_ = interpreted(stmt);
+}
+
+void ClosureCompiler::visit(ThrowStmt& stmt) {
+    stmt_ = [&keyword = stmt.keyword, value = compile(*stmt.value)](Interpreter& in) {
+        in.completion_ = Completion{Type::Throw, value(in), &keyword};
+    };
+}
+
+void ClosureCompiler::visit(ClassStmt& stmt) {
+    stmt_ = interpreted(stmt);
+}
+
+}  // namespace izi
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "ast/expr.hpp"
+#include "ast/stmt.hpp"
+#include "ast/visitor.hpp"
+#include "interpreter.hpp"
+
+namespace izi {
+
+// Code compiled from an expression: evaluates it in the interpreter's
+// current environment
+using CompiledExpr = std::function<Value(Interpreter&)>;
+// Code compiled from a statement: runs it, leaving an abrupt completion in
+// the interpreter like the statement visitors do
+using CompiledStmt = std::function<void(Interpreter&)>;
+
+// A statement list compiled by the ClosureCompiler
+struct CompiledBlock {
+    struct Statement {
+        CompiledStmt run;
+        int line;  // Reported to the debug hook before it runs
+    };
+    std::vector<Statement> statements;
+};
+
+// Closure compilation for `izi run --closure`.
+//
+// Turns a resolved tree into a tree of C++ closures, once, so that running
+// it skips the visitor's virtual dispatch: each closure is specialized for
+// its node when it is built, with its operator picked, its children already
+// compiled and its variable's environment depth and slot bound in, and
+// number operands take a fast path before the interpreter's checks.
+//
+// The kinds of node that dominate running time (operators, variables,
+// calls, indexing, properties, blocks and loops) are compiled; the others
+// (match, functions, classes, try, imports, async) call back into the
+// Interpreter's visitor for that node, so the two modes share every
+// semantic, the natives and the Callable objects.  Function bodies are
+// compiled the first time they are called and kept on their AST node.
+class ClosureCompiler : public ExprVisitor, public StmtVisitor {
+   public:
+    static std::shared_ptr<CompiledBlock> compile(const std::vector<StmtPtr>& statements);
+
+    // Run `block` in the current environment, leaving an abrupt completion
+    // in the interpreter
+    static void execute(const CompiledBlock& block, Interpreter& interp);
+    // Run `block` with `scope` as the current environment and return how
+    // it completed
+    static Completion run(const CompiledBlock& block, Interpreter& interp, Environment* scope);
+
+    // ExprVisitor
+    Value visit(BinaryExpr& expr) override;
+    Value visit(UnaryExpr& expr) override;
+    Value visit(LiteralExpr& expr) override;
+    Value visit(GroupingExpr& expr) override;
+    Value visit(ConditionalExpr& expr) override;
+    Value visit(CallExpr& expr) override;
+    Value visit(VariableExpr& expr) override;
+    Value visit(AssignExpr& expr) override;
+    Value visit(ArrayExpr& expr) override;
+    Value visit(MapExpr& expr) override;
+    Value visit(SpreadExpr& expr) override;
+    Value visit(IndexExpr& expr) override;
+    Value visit(SetIndexExpr& expr) override;
+    Value visit(FunctionExpr& expr) override;
+    Value visit(MatchExpr& expr) override;
+    Value visit(PropertyExpr& expr) override;
+    Value visit(SetPropertyExpr& expr) override;
+    Value visit(ThisExpr& expr) override;
+    Value visit(SuperExpr& expr) override;
+    Value visit(AwaitExpr& expr) override;
+
+    // StmtVisitor
+    void visit(ExprStmt& stmt) override;
+    void visit(BlockStmt& stmt) override;
+    void visit(VarStmt& stmt) override;
+    void visit(WhileStmt& stmt) override;
+    void visit(IfStmt& stmt) override;
+    void visit(FunctionStmt& stmt) override;
+    void visit(ReturnStmt& stmt) override;
+    void visit(ImportStmt& stmt) override;
+    void visit(ExportStmt& stmt) override;
+    void visit(ReExportStmt& stmt) override;
+    void visit(BreakStmt& stmt) override;
+    void visit(ContinueStmt& stmt) override;
+    void visit(TryStmt& stmt) override;
+    void visit(ThrowStmt& stmt) override;
+    void visit(ClassStmt& stmt) override;
+
+   private:
+    // The visitors leave the code they compile here
+    CompiledExpr expr_;
+    CompiledStmt stmt_;
+
+    CompiledExpr compile(Expr& expr);
+    CompiledStmt compile(Stmt& stmt);
+    std::shared_ptr<CompiledBlock> compileBlock(const std::vector<StmtPtr>& statements);
+
+    // Code that hands the node to the interpreter's visitor
+    static CompiledExpr interpreted(Expr& expr);
+    static CompiledStmt interpreted(Stmt& stmt);
+    template <typename Op>
+    static CompiledExpr numberOp(const BinaryExpr& expr, CompiledExpr left, CompiledExpr right);
+
+    static void executeIn(const CompiledBlock& block, Interpreter& interp, Environment* scope);
+};
+
+}  // namespace izi
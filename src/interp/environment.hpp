@@ -1,30 +1,119 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <stdexcept>
+#include <vector>
+#include "ast/scope.hpp"
 #include "common/value.hpp"
 
 namespace izi {
 
 // Ownership note:
-//   Environment instances are owned exclusively by an EnvironmentArena.
-//   The `parent` pointer is therefore a non-owning raw pointer – the arena
-//   guarantees that parent environments outlive their children for the
-//   duration of interpreter execution.  Do not delete Environment objects
-//   directly; let the arena manage their lifetime.
-class Environment {
+//   Environments come from an EnvironmentArena, in one of two kinds.  A
+//   scope the Resolver found no closure can capture gets an environment
+//   from the arena's region, lent for exactly the length of the scope, and
+//   its `parent` pointer is non-owning: the parent is in use for at least as
+//   long.  A captured scope's environment is shared: the closures created in
+//   it and its captured children hold it through Refs, and it goes
+//   when the last of them does.  Cycles between a shared environment and
+//   the closures stored in it are the cycle collector's to break, so shared
+//   environments are GcNodes.
+//
+// Storage:
+//   Variables live in a flat array of slots.  An environment created for a
+//   resolved scope starts with one slot per name of its ScopeLayout, and the
+//   Resolver's (depth, slot) pairs index them directly.  Names defined at run
+//   time instead (globals, natives, module top levels, imports) get further
+//   slots through a name table, and stay undefined until defined; the
+//   Resolver reserves slots there for top-level declarations.
+class Environment : public RefCounted, public GcNode {
    public:
     Environment() = default;
 
-    explicit Environment(Environment* enclosing) : parent(enclosing) {}
+    explicit Environment(Environment* enclosing, const ScopeLayout* layout = nullptr)
+        : slots(layout ? layout->names.size() : 0), layout(layout), layoutSize(slots.size()), parent(enclosing) {
+        if (layout) {
+            unset = layout->late;
+        }
+    }
+
+    // A shared environment owns its parent
+    Environment(Ref<Environment> enclosing, const ScopeLayout* layout)
+        : Environment(enclosing.get(), layout) {
+        parentRef = std::move(enclosing);
+    }
+
+    // The environment `depth` steps up the parent chain
+    Environment* ancestor(uint32_t depth) {
+        Environment* target = this;
+        while (depth-- > 0) {
+            target = target->parent;
+        }
+        return target;
+    }
+
+    Value& at(uint32_t slot) { return slots[slot]; }
+
+    // Named slots hold nothing until defined; layout slots do from the start,
+    // except the layout's late ones
+    bool isDefined(uint32_t slot) const {
+        if (slot < layoutSize) {
+            return slot >= unset.size() || !unset[slot];
+        }
+        return names->defined[slot - layoutSize];
+    }
+
+    void defineAt(uint32_t slot, const Value& value) {
+        slots[slot] = value;
+        if (slot >= layoutSize) {
+            names->defined[slot - layoutSize] = true;
+        } else if (!unset.empty()) [[unlikely]] {
+            if (slot < unset.size()) {
+                unset[slot] = false;
+            }
+        }
+    }
+
+    // Slot of `name` in this environment alone, or NO_SLOT
+    uint32_t find(const std::string& name) const {
+        for (size_t i = layoutSize; i-- > 0;) {
+            if (layout->names[i] == name) {
+                return static_cast<uint32_t>(i);
+            }
+        }
+        if (names) {
+            auto it = names->index.find(name);
+            if (it != names->index.end()) {
+                return it->second;
+            }
+        }
+        return NO_SLOT;
+    }
+
+    // Slot for `name`, adding an undefined named slot if there is none yet
+    uint32_t reserve(const std::string& name) {
+        uint32_t slot = find(name);
+        if (slot != NO_SLOT) {
+            return slot;
+        }
+        if (!names) {
+            names = std::make_unique<NameTable>();
+        }
+        slot = static_cast<uint32_t>(slots.size());
+        slots.emplace_back();
+        names->defined.push_back(false);
+        names->index.emplace(name, slot);
+        return slot;
+    }
 
-    void define(const std::string& name, const Value& value) { values[name] = value; }
+    void define(const std::string& name, const Value& value) { defineAt(reserve(name), value); }
 
     Value get(const std::string& name) const {
-        auto it = values.find(name);
-        if (it != values.end()) {
-            return it->second;
+        uint32_t slot = find(name);
+        if (slot != NO_SLOT && isDefined(slot)) {
+            return slots[slot];
         }
 
         if (parent != nullptr) {
@@ -35,9 +124,9 @@ class Environment {
     }
 
     void assign(const std::string& name, const Value& value) {
-        auto it = values.find(name);
-        if (it != values.end()) {
-            it->second = value;
+        uint32_t slot = find(name);
+        if (slot != NO_SLOT && isDefined(slot)) {
+            slots[slot] = value;
             return;
         }
 
@@ -49,14 +138,64 @@ class Environment {
         throw std::runtime_error("Undefined variable '" + name + "'.");
     }
 
-    // Get all variables in this environment (for REPL :vars command)
-    const std::unordered_map<std::string, Value>& getAll() const { return values; }
+    // Get all variables defined in this environment (for REPL :vars command)
+    std::unordered_map<std::string, Value> getAll() const {
+        std::unordered_map<std::string, Value> all;
+        for (size_t i = 0; i < layoutSize; ++i) {
+            if (isDefined(static_cast<uint32_t>(i))) {
+                all[layout->names[i]] = slots[i];
+            }
+        }
+        if (names) {
+            for (const auto& [name, slot] : names->index) {
+                if (isDefined(slot)) {
+                    all[name] = slots[slot];
+                }
+            }
+        }
+        return all;
+    }
 
     Environment* getParent() const { return parent; }
 
+    void traceRefs(GcTracer& tracer) const override {
+        tracer.trace(parentRef);
+        for (const Value& value : slots) tracer.trace(value);
+    }
+
    private:
-    std::unordered_map<std::string, Value> values;
+    friend class EnvironmentArena;
+
+    struct NameTable {
+        std::unordered_map<std::string, uint32_t> index;
+        std::vector<bool> defined;  // By slot, past the layout's
+    };
+
+    std::vector<Value> slots;
+    const ScopeLayout* layout = nullptr;
+    size_t layoutSize = 0;  // Slots named by the layout; the rest are named slots
+    std::vector<bool> unset;  // Late layout slots not defined yet, by slot
+    std::unique_ptr<NameTable> names;
     Environment* parent = nullptr;
+    Ref<Environment> parentRef;  // Shared environments only
+
+    // Region environments are reused: reset() readies one for a scope and
+    // clear() drops what the scope left in it, keeping the slots' storage
+    void reset(Environment* enclosing, const ScopeLayout* scopeLayout) {
+        layout = scopeLayout;
+        layoutSize = layout ? layout->names.size() : 0;
+        slots.resize(layoutSize);
+        if (layout) {
+            unset = layout->late;
+        }
+        parent = enclosing;
+    }
+
+    void clear() {
+        slots.clear();
+        unset.clear();
+        names.reset();
+    }
 };
 
-}  // namespace izi
\ No newline at end of file
+}  // namespace izi
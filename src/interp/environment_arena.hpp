@@ -1,58 +1,139 @@
 #pragma once
 
 #include <memory>
+#include <stdexcept>
 #include <vector>
 
 namespace izi {
 
 class Environment;
+struct ScopeLayout;
 
-// Arena allocator for Environment objects.
+// Allocator for Environment objects.
 //
-// Ownership model:
-//   The EnvironmentArena is the sole owner of all Environment instances created
-//   through it.  Callers receive raw (non-owning) pointers and must not delete
-//   them.  All environments are freed when the arena is destroyed (typically
-//   when the Interpreter that owns the arena goes out of scope).
+// Lifetime model:
+//   Most scopes (blocks, loop bodies, calls of functions that create no
+//   closures) can never be captured: the Resolver marks the ones that can,
+//   because a function, class or simple import appears inside them.  The
+//   others enter and leave in strict LIFO order, so their environments come
+//   from a region: a stack of Environment objects handed out by enter() and
+//   taken back, cleared, when the returned Scope ends.  The objects and
+//   their slot storage are reused, so a loop or a call allocates nothing
+//   once the region has grown to the deepest nesting it reaches.
 //
-// This eliminates the shared_ptr reference cycle that would otherwise exist
-// between UserFunction (which captures a closure environment) and Environment
-// (which can store Values that are UserFunction objects).  Because the arena
-// outlives every environment it allocates, raw pointers are always valid for
-// the lifetime of the interpreter.
+//   A captured scope's environment is reference counted instead, held by
+//   the closures created in it and by its captured children; reference
+//   counting frees it after the last of them, and the cycle collector breaks
+//   the cycles a closure stored in its own scope makes.  A region
+//   environment's count stays 0.
+//
+// Either way an environment lives exactly as long as something can reach
+// it, and a long-running loop does not accumulate them.
 class EnvironmentArena {
    public:
+    // An environment entered for the length of a scope
+    class Scope {
+       public:
+        Scope(Scope&& other) noexcept
+            : arena_(other.arena_), env_(other.env_), shared_(std::move(other.shared_)) {
+            other.arena_ = nullptr;
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        ~Scope() {
+            if (arena_) {
+                arena_->leave(env_);
+            }
+        }
+
+        Environment* get() const { return env_; }
+        Environment* operator->() const { return env_; }
+
+       private:
+        friend class EnvironmentArena;
+        Scope(EnvironmentArena* arena, Environment* env) : arena_(arena), env_(env) {}
+        explicit Scope(Ref<Environment> env) : env_(env.get()), shared_(std::move(env)) {}
+
+        EnvironmentArena* arena_ = nullptr;  // Set for region environments
+        Environment* env_;
+        Ref<Environment> shared_;
+    };
+
+    EnvironmentArena() = default;
+    EnvironmentArena(const EnvironmentArena&) = delete;
+    EnvironmentArena& operator=(const EnvironmentArena&) = delete;
+
     // Create a root environment (no parent).
-    Environment* create();
+    Ref<Environment> create();
 
-    // Create a child environment whose parent is `parent`.
-    Environment* create(Environment* parent);
+    // Create a shared environment whose parent is `parent`, with the slots
+    // of `layout` when the Resolver has laid out its scope.  `parent` must
+    // itself be shared.
+    Ref<Environment> create(Environment* parent, const ScopeLayout* layout = nullptr);
 
-    // Release all environments owned by this arena.
-    void reset() { envs_.clear(); }
+    // A shared environment's owning pointer, for a closure to hold
+    static Ref<Environment> share(Environment* env);
 
-    size_t size() const { return envs_.size(); }
+    // Enter a scope whose environment lives until the returned Scope ends,
+    // unless `captured`, when closures may keep it.
+    Scope enter(Environment* parent, const ScopeLayout* layout, bool captured);
+    Scope enter(Environment* parent, const ScopeLayout& layout);
+
+    // Region environments currently in use
+    size_t size() const { return top_; }
 
    private:
-    std::vector<std::unique_ptr<Environment>> envs_;
+    std::vector<std::unique_ptr<Environment>> region_;
+    size_t top_ = 0;
+
+    void leave(Environment* env);
 };
 
 }  // namespace izi
 
-// Include after the declaration so that EnvironmentArena::create() can
+// Include after the declaration so that EnvironmentArena's members can
 // construct Environment objects.
 #include "environment.hpp"
 
 namespace izi {
 
-inline Environment* EnvironmentArena::create() {
-    envs_.push_back(std::make_unique<Environment>());
-    return envs_.back().get();
+inline Ref<Environment> EnvironmentArena::create() {
+    return makeRef<Environment>();
+}
+
+inline Ref<Environment> EnvironmentArena::create(Environment* parent, const ScopeLayout* layout) {
+    return makeRef<Environment>(share(parent), layout);
+}
+
+inline Ref<Environment> EnvironmentArena::share(Environment* env) {
+    // Region environments are owned by the arena and never counted
+    if (env->refCount() == 0) {
+        throw std::logic_error("Closure over a scope the resolver did not mark captured.");
+    }
+    return Ref<Environment>(env);
+}
+
+inline EnvironmentArena::Scope EnvironmentArena::enter(Environment* parent, const ScopeLayout* layout,
+                                                       bool captured) {
+    if (captured) {
+        return Scope(create(parent, layout));
+    }
+    if (top_ == region_.size()) {
+        region_.push_back(std::make_unique<Environment>());
+    }
+    Environment* env = region_[top_++].get();
+    env->reset(parent, layout);
+    return Scope(this, env);
+}
+
+inline EnvironmentArena::Scope EnvironmentArena::enter(Environment* parent, const ScopeLayout& layout) {
+    return enter(parent, &layout, layout.captured);
 }
 
-inline Environment* EnvironmentArena::create(Environment* parent) {
-    envs_.push_back(std::make_unique<Environment>(parent));
-    return envs_.back().get();
+inline void EnvironmentArena::leave(Environment* env) {
+    // Scopes end in reverse order, so this is the top of the region
+    --top_;
+    env->clear();
 }
 
 }  // namespace izi
@@ -8,6 +8,7 @@
 #include <fstream>
 #include <string>
 #include <algorithm>
+#include <utility>
 
 #include "ast/expr.hpp"
 #include "ast/pattern.hpp"
@@ -16,23 +17,47 @@
 #include "common/token.hpp"
 #include "common/value.hpp"
 #include "common/module_path.hpp"
+#include "common/trace.hpp"
+#include "interp/closure_compiler.hpp"
 #include "interp/native.hpp"
 #include "interp/native_modules.hpp"
 #include "interp/izi_class.hpp"
+#include "interp/resolver.hpp"
 #include "parse/parser.hpp"
 #include "parse/lexer.hpp"
 namespace izi {
 
 // Constructor needs to be defined to call registerNativeFunctions
 Interpreter::Interpreter(std::string_view source)
-    : source_(source), globals(arena_.create()), env(globals) {
+    : source_(source), globals(arena_.create()), env(globals.get()) {
     registerNativeFunctions(*this);
 }
 
 void Interpreter::interpret(const std::vector<StmtPtr>& program) {
+    {
+        TraceScope trace("compile", "resolve");
+        Resolver resolver(env);
+        resolver.resolve(program);
+    }
+    if (closureCompilation_) {
+        std::shared_ptr<CompiledBlock> compiled;
+        {
+            TraceScope trace("compile", "closures");
+            compiled = ClosureCompiler::compile(program);
+        }
+        ClosureCompiler::execute(*compiled, *this);
+        if (completion_.abrupt()) {
+            finish(std::exchange(completion_, Completion{}));
+        }
+        return;
+    }
     for (auto& s : program) {
         if (s) {  // Skip null statements from parser errors
-            execute(*s);
+            Completion completion = execute(*s);
+            if (completion.abrupt()) {
+                finish(std::move(completion));
+                return;  // A top-level return ends the program
+            }
         }
     }
 }
@@ -40,27 +65,65 @@ void Interpreter::interpret(const std::vector<StmtPtr>& program) {
 Value Interpreter::evaluate(Expr& expr) {
     return expr.accept(*this);
 }
-void Interpreter::execute(Stmt& stmt) {
+Completion Interpreter::execute(Stmt& stmt) {
     if (debugHook_ && stmt.line > 0) {
         debugHook_->onStatement(stmt.line, currentFile);
     }
     stmt.accept(*this);
+    if (!completion_.abrupt()) {
+        return {};
+    }
+    return std::exchange(completion_, Completion{});
+}
+
+Value Interpreter::finish(Completion&& completion) {
+    switch (completion.type) {
+        case Completion::Type::Normal:
+            return Nil{};
+        case Completion::Type::Return:
+            return std::move(completion.value);
+        case Completion::Type::Break:
+            throw std::runtime_error("Break statement outside of loop.");
+        case Completion::Type::Continue:
+            throw std::runtime_error("Continue statement outside of loop.");
+        case Completion::Type::Throw:
+            throw ThrowSignal(std::move(completion.value), *completion.token);
+    }
+    return Nil{};
 }
 
 double Interpreter::toNumber(const Value& v, const Token& token) {
-    if (!std::holds_alternative<double>(v)) {
+    if (!v.isNumber()) {
         throw RuntimeError(token, "Expected number, got " + getTypeName(v) + ".");
     }
-    return std::get<double>(v);
+    return v.asNumber();
+}
+
+Value Interpreter::evaluateIn(Expr& expr, Environment* scope) {
+    Environment* previous = env;
+    env = scope;
+
+    try {
+        Value result = evaluate(expr);
+        env = previous;
+        return result;
+    } catch (...) {
+        env = previous;
+        throw;
+    }
 }
 
-void Interpreter::executeBlock(const std::vector<StmtPtr>& statements, Environment* newEnv) {
+Completion Interpreter::executeBlock(const std::vector<StmtPtr>& statements, Environment* newEnv) {
     Environment* previous = env;
     env = newEnv;
 
     try {
         for (const auto& stmt : statements) {
-            execute(*stmt);
+            Completion completion = execute(*stmt);
+            if (completion.abrupt()) {
+                env = previous;
+                return completion;
+            }
         }
     } catch (...) {
         env = previous;
@@ -68,6 +131,18 @@ void Interpreter::executeBlock(const std::vector<StmtPtr>& statements, Environme
     }
 
     env = previous;
+    return {};
+}
+
+Completion Interpreter::executeBody(const std::vector<StmtPtr>& body, std::shared_ptr<CompiledBlock>& compiled,
+                                    Environment* newEnv) {
+    if (!closureCompilation_) {
+        return executeBlock(body, newEnv);
+    }
+    if (!compiled) {
+        compiled = ClosureCompiler::compile(body);
+    }
+    return ClosureCompiler::run(*compiled, *this, newEnv);
 }
 
 Value Interpreter::visit(BinaryExpr& expr) {
@@ -90,7 +165,7 @@ Value Interpreter::visit(BinaryExpr& expr) {
 
     if (expr.op.type == TokenType::QUESTION_QUESTION) {
         Value left = evaluate(*expr.left);
-        if (!std::holds_alternative<Nil>(left)) {
+        if (!left.isNil()) {
             return left;  // Short-circuit: return left if not nil
         }
         return evaluate(*expr.right);  // Only evaluate right if left is nil
@@ -99,47 +174,50 @@ Value Interpreter::visit(BinaryExpr& expr) {
     // For all other operators, evaluate both operands
     Value left = evaluate(*expr.left);
     Value right = evaluate(*expr.right);
+    return binaryOp(expr.op, left, right);
+}
 
-    switch (expr.op.type) {
+Value Interpreter::binaryOp(const Token& op, const Value& left, const Value& right) {
+    switch (op.type) {
         case TokenType::PLUS:
-            if (std::holds_alternative<double>(left) && std::holds_alternative<double>(right)) {
-                return std::get<double>(left) + std::get<double>(right);
+            if (left.isNumber() && right.isNumber()) {
+                return left.asNumber() + right.asNumber();
             }
-            if (std::holds_alternative<std::string>(left) && std::holds_alternative<std::string>(right)) {
-                return std::get<std::string>(left) + std::get<std::string>(right);
+            if (left.isString() && right.isString()) {
+                return left.asString() + right.asString();
             }
-            throw RuntimeError(expr.op, "Cannot add " + getTypeName(left) + " and " + getTypeName(right) +
+            throw RuntimeError(op, "Cannot add " + getTypeName(left) + " and " + getTypeName(right) +
                                             ". Operands must be two numbers or two strings.");
 
         case TokenType::MINUS:
-            return Value{toNumber(left, expr.op) - toNumber(right, expr.op)};
+            return Value{toNumber(left, op) - toNumber(right, op)};
 
         case TokenType::STAR:
-            return toNumber(left, expr.op) * toNumber(right, expr.op);
+            return toNumber(left, op) * toNumber(right, op);
 
         case TokenType::SLASH:
-            return toNumber(left, expr.op) / toNumber(right, expr.op);
+            return toNumber(left, op) / toNumber(right, op);
 
         case TokenType::PERCENT: {
-            double l = toNumber(left, expr.op);
-            double r = toNumber(right, expr.op);
+            double l = toNumber(left, op);
+            double r = toNumber(right, op);
             if (r == 0.0) {
-                throw RuntimeError(expr.op, "Division by zero in modulo operation.");
+                throw RuntimeError(op, "Division by zero in modulo operation.");
             }
             return std::fmod(l, r);
         }
 
         case TokenType::GREATER:
-            return toNumber(left, expr.op) > toNumber(right, expr.op);
+            return toNumber(left, op) > toNumber(right, op);
 
         case TokenType::GREATER_EQUAL:
-            return toNumber(left, expr.op) >= toNumber(right, expr.op);
+            return toNumber(left, op) >= toNumber(right, op);
 
         case TokenType::LESS:
-            return toNumber(left, expr.op) < toNumber(right, expr.op);
+            return toNumber(left, op) < toNumber(right, op);
 
         case TokenType::LESS_EQUAL:
-            return toNumber(left, expr.op) <= toNumber(right, expr.op);
+            return toNumber(left, op) <= toNumber(right, op);
 
         case TokenType::EQUAL_EQUAL:
             return left == right;
@@ -148,7 +226,7 @@ Value Interpreter::visit(BinaryExpr& expr) {
             return left != right;
 
         default:
-            throw RuntimeError(expr.op, "Unknown binary operator.");
+            throw RuntimeError(op, "Unknown binary operator.");
     }
 }
 
@@ -169,27 +247,46 @@ Value Interpreter::visit(UnaryExpr& expr) {
 
 Value Interpreter::visit(AssignExpr& expr) {
     Value v = evaluate(*expr.value);
-    env->assign(expr.name, v);
+    assignTo(expr.name, expr.slot, v);
     return v;
 }
 
+void Interpreter::assignTo(const std::string& name, const VarSlot& slot, const Value& value) {
+    if (slot.resolved()) {
+        Environment* target = env->ancestor(slot.depth);
+        if (!slot.checked || target->isDefined(slot.slot)) {
+            target->at(slot.slot) = value;
+            return;
+        }
+    }
+    env->assign(name, value);
+}
+
 Value Interpreter::visit(CallExpr& expr) {
     Value calleVal = evaluate(*expr.callee);
-    if (!std::holds_alternative<std::shared_ptr<Callable>>(calleVal)) {
-        throw std::runtime_error("Can only call functions and classes.");
-    }
-    auto callable = std::get<std::shared_ptr<Callable>>(calleVal);
+    auto callable = calleeOf(calleVal);
     // evaluate arguments
     std::vector<Value> arguments;
     for (const auto& argExpr : expr.args) {
         arguments.push_back(evaluate(*argExpr));
     }
-    int arity = callable->arity();
+    return callWith(*callable, arguments);
+}
+
+Ref<Callable> Interpreter::calleeOf(const Value& callee) {
+    if (!callee.isCallable()) {
+        throw std::runtime_error("Can only call functions and classes.");
+    }
+    return callee.asCallable();
+}
+
+Value Interpreter::callWith(Callable& callable, const std::vector<Value>& arguments) {
+    int arity = callable.arity();
     if (arity >= 0 && arguments.size() != static_cast<size_t>(arity)) {
         throw std::runtime_error("Expected " + std::to_string(arity) + " arguments but got " +
                                  std::to_string(arguments.size()) + ".");
     }
-    return callable->call(*this, arguments);
+    return callable.call(*this, arguments);
 }
 
 Value Interpreter::visit(LiteralExpr& expr) {
@@ -209,19 +306,31 @@ Value Interpreter::visit(ConditionalExpr& expr) {
     }
 }
 
+Value Interpreter::lookUp(const std::string& name, const VarSlot& slot) {
+    if (slot.resolved()) {
+        Environment* target = env->ancestor(slot.depth);
+        if (!slot.checked || target->isDefined(slot.slot)) {
+            return target->at(slot.slot);
+        }
+    }
+    // Unresolved, or a top-level slot not defined yet: an outer scope may
+    // still have the name
+    return env->get(name);
+}
+
 Value Interpreter::visit(VariableExpr& expr) {
-    return env->get(expr.name);
+    return lookUp(expr.name, expr.slot);
 }
 
 Value Interpreter::visit(ArrayExpr& expr) {
-    auto array = std::make_shared<Array>();
+    auto array = makeRef<Array>();
     for (const auto& elementExpr : expr.elements) {
         // Check if this element is a spread expression
         if (auto* spreadExpr = dynamic_cast<SpreadExpr*>(elementExpr.get())) {
             Value spreadValue = evaluate(*spreadExpr->argument);
             // If it's an array, spread its elements
-            if (std::holds_alternative<std::shared_ptr<Array>>(spreadValue)) {
-                auto spreadArray = std::get<std::shared_ptr<Array>>(spreadValue);
+            if (spreadValue.isArray()) {
+                auto spreadArray = spreadValue.asArray();
                 for (const auto& elem : spreadArray->elements) {
                     array->elements.push_back(elem);
                 }
@@ -235,15 +344,15 @@ Value Interpreter::visit(ArrayExpr& expr) {
     return array;
 }
 Value Interpreter::visit(MapExpr& expr) {
-    auto map = std::make_shared<Map>();
+    auto map = makeRef<Map>();
     for (const auto& [key, valueExpr] : expr.entries) {
         // Check if this is a spread expression (indicated by empty key)
         if (key.empty()) {
             if (auto* spreadExpr = dynamic_cast<SpreadExpr*>(valueExpr.get())) {
                 Value spreadValue = evaluate(*spreadExpr->argument);
                 // If it's a map, spread its entries
-                if (std::holds_alternative<std::shared_ptr<Map>>(spreadValue)) {
-                    auto spreadMap = std::get<std::shared_ptr<Map>>(spreadValue);
+                if (spreadValue.isMap()) {
+                    auto spreadMap = spreadValue.asMap();
                     for (const auto& [k, v] : spreadMap->entries) {
                         map->entries[k] = v;
                     }
@@ -267,17 +376,20 @@ Value Interpreter::visit(SpreadExpr& expr) {
 Value Interpreter::visit(IndexExpr& expr) {
     Value collection = evaluate(*expr.collection);
     Value index = evaluate(*expr.index);
+    return getIndex(collection, index);
+}
 
-    if (std::holds_alternative<std::shared_ptr<Array>>(collection)) {
-        auto array = std::get<std::shared_ptr<Array>>(collection);
+Value Interpreter::getIndex(const Value& collection, const Value& index) {
+    if (collection.isArray()) {
+        auto array = collection.asArray();
         size_t idx = static_cast<size_t>(asNumber(index));
         if (idx >= array->elements.size()) {
             throw std::runtime_error("Array index out of bounds.");
         }
         return array->elements[idx];
-    } else if (std::holds_alternative<std::shared_ptr<Map>>(collection)) {
-        auto map = std::get<std::shared_ptr<Map>>(collection);
-        std::string key = std::get<std::string>(index);
+    } else if (collection.isMap()) {
+        auto map = collection.asMap();
+        std::string key = index.asString();
         auto it = map->entries.find(key);
         if (it == map->entries.end()) {
             throw std::runtime_error("Key '" + key + "' not found in map.");
@@ -292,9 +404,12 @@ Value Interpreter::visit(SetIndexExpr& expr) {
     Value collection = evaluate(*expr.collection);
     Value index = evaluate(*expr.index);
     Value value = evaluate(*expr.value);
+    return setIndex(collection, index, value);
+}
 
-    if (std::holds_alternative<std::shared_ptr<Array>>(collection)) {
-        auto array = std::get<std::shared_ptr<Array>>(collection);
+Value Interpreter::setIndex(const Value& collection, const Value& index, const Value& value) {
+    if (collection.isArray()) {
+        auto array = collection.asArray();
         size_t idx = static_cast<size_t>(asNumber(index));
         if (idx < 0) {
             throw std::runtime_error("Array index cannot be negative.");
@@ -306,12 +421,12 @@ Value Interpreter::visit(SetIndexExpr& expr) {
         return value;
     }
 
-    if (std::holds_alternative<std::shared_ptr<Map>>(collection)) {
-        auto map = std::get<std::shared_ptr<Map>>(collection);
-        if (!std::holds_alternative<std::string>(index)) {
+    if (collection.isMap()) {
+        auto map = collection.asMap();
+        if (!index.isString()) {
             throw std::runtime_error("Map keys must be strings.");
         }
-        std::string key = std::get<std::string>(index);
+        std::string key = index.asString();
         map->entries[key] = value;
         return value;
     }
@@ -322,7 +437,7 @@ Value Interpreter::visit(FunctionExpr& expr) {
     // Create a UserFunction that directly references the FunctionExpr
     // The FunctionExpr is part of the AST and lives for the duration of the program
     // so this pointer will remain valid
-    auto func = std::make_shared<UserFunction>(&expr, env);
+    auto func = makeRef<UserFunction>(&expr, EnvironmentArena::share(env));
     return func;
 }
 
@@ -355,18 +470,15 @@ Value Interpreter::visit(MatchExpr& expr) {
         // If pattern matched, check guard condition if present
         if (matched && matchCase.guard) {
             // Create a new environment for guard evaluation
-            auto guardEnv = arena_.create(env);
+            auto guardEnv = arena_.enter(env, matchCase.scope);
 
             // If variable pattern, bind the variable in guard scope
             if (!varName.empty()) {
-                guardEnv->define(varName, boundValue);
+                guardEnv->defineAt(0, boundValue);
             }
 
             // Evaluate guard in the new environment
-            auto previousEnv = env;
-            env = guardEnv;
-            Value guardResult = evaluate(*matchCase.guard);
-            env = previousEnv;
+            Value guardResult = evaluateIn(*matchCase.guard, guardEnv.get());
 
             // Check if guard evaluates to truthy value
             if (!isTruthy(guardResult)) {
@@ -377,20 +489,15 @@ Value Interpreter::visit(MatchExpr& expr) {
         // If everything matched, evaluate and return the result
         if (matched) {
             // Create a new environment for result evaluation
-            auto resultEnv = arena_.create(env);
+            auto resultEnv = arena_.enter(env, matchCase.scope);
 
             // If variable pattern, bind the variable in result scope
             if (!varName.empty()) {
-                resultEnv->define(varName, boundValue);
+                resultEnv->defineAt(0, boundValue);
             }
 
             // Evaluate result in the new environment
-            auto previousEnv = env;
-            env = resultEnv;
-            Value result = evaluate(*matchCase.result);
-            env = previousEnv;
-
-            return result;
+            return evaluateIn(*matchCase.result, resultEnv.get());
         }
     }
 
@@ -413,10 +520,10 @@ void Interpreter::visit(VarStmt& stmt) {
     if (stmt.pattern != nullptr) {
         // Array destructuring
         if (auto* arrayPattern = dynamic_cast<ArrayPattern*>(stmt.pattern.get())) {
-            if (!std::holds_alternative<std::shared_ptr<Array>>(value)) {
+            if (!value.isArray()) {
                 throw std::runtime_error("Array destructuring requires an array value.");
             }
-            auto array = std::get<std::shared_ptr<Array>>(value);
+            auto array = value.asArray();
 
             // Bind each variable in the pattern to corresponding array element
             for (size_t i = 0; i < arrayPattern->elements.size(); ++i) {
@@ -433,10 +540,10 @@ void Interpreter::visit(VarStmt& stmt) {
 
         // Map destructuring
         if (auto* mapPattern = dynamic_cast<MapPattern*>(stmt.pattern.get())) {
-            if (!std::holds_alternative<std::shared_ptr<Map>>(value)) {
+            if (!value.isMap()) {
                 throw std::runtime_error("Map destructuring requires a map value.");
             }
-            auto map = std::get<std::shared_ptr<Map>>(value);
+            auto map = value.asMap();
 
             // Bind each variable in the pattern to corresponding map entry
             for (const auto& key : mapPattern->keys) {
@@ -452,12 +559,16 @@ void Interpreter::visit(VarStmt& stmt) {
     }
 
     // Simple variable declaration
-    env->define(stmt.name, value);
+    if (stmt.slot != NO_SLOT) {
+        env->defineAt(stmt.slot, value);
+    } else {
+        env->define(stmt.name, value);
+    }
 }
 
 void Interpreter::visit(BlockStmt& stmt) {
-    auto blockEnv = arena_.create(env);
-    executeBlock(stmt.statements, blockEnv);
+    auto blockEnv = arena_.enter(env, stmt.scope);
+    completion_ = executeBlock(stmt.statements, blockEnv.get());
 }
 
 void Interpreter::visit(IfStmt& stmt) {
@@ -471,19 +582,29 @@ void Interpreter::visit(IfStmt& stmt) {
 
 void Interpreter::visit(WhileStmt& stmt) {
     while (isTruthy(evaluate(*stmt.condition))) {
-        try {
-            stmt.body->accept(*this);
-        } catch (const BreakSignal&) {
-            break;  // Exit the loop
-        } catch (const ContinueSignal&) {
-            continue;  // Continue to next iteration
+        Gc::maybeCollect();
+        stmt.body->accept(*this);
+        if (completion_.abrupt()) {
+            if (completion_.type == Completion::Type::Break) {
+                completion_ = {};
+                break;  // Exit the loop
+            }
+            if (completion_.type == Completion::Type::Continue) {
+                completion_ = {};
+                continue;  // Continue to next iteration
+            }
+            return;  // Returns and throws leave the loop too
         }
     }
 }
 
 void Interpreter::visit(FunctionStmt& stmt) {
-    auto fn = std::make_shared<UserFunction>(&stmt, env);
-    env->define(stmt.name, fn);
+    auto fn = makeRef<UserFunction>(&stmt, EnvironmentArena::share(env));
+    if (stmt.slot != NO_SLOT) {
+        env->defineAt(stmt.slot, fn);
+    } else {
+        env->define(stmt.name, fn);
+    }
 }
 
 void Interpreter::visit(ReturnStmt& stmt) {
@@ -491,17 +612,18 @@ void Interpreter::visit(ReturnStmt& stmt) {
     if (stmt.value) {
         v = evaluate(*stmt.value);
     }
-    throw ReturnSignal{v};
+    completion_ = Completion{Completion::Type::Return, std::move(v)};
 }
 
 void Interpreter::visit(ImportStmt& stmt) {
+    TraceScope trace("module", "import ", stmt.module);
     std::string modulePath = stmt.module;
 
     // Check if this is a native module
     if (isNativeModule(modulePath)) {
         // Handle native module import
         Value moduleValue = getNativeModule(modulePath, *this);
-        auto moduleMap = std::get<std::shared_ptr<Map>>(moduleValue);
+        auto moduleMap = moduleValue.asMap();
 
         if (stmt.isWildcard) {
             // import * as name from "math"
@@ -541,7 +663,7 @@ void Interpreter::visit(ImportStmt& stmt) {
 
         if (stmt.isWildcard) {
             // import * as alias from "./module" -> create namespace Map
-            auto map = std::make_shared<Map>();
+            auto map = makeRef<Map>();
             map->entries = exports;
             env->define(stmt.wildcardAlias, Value(map));
         } else {
@@ -644,14 +766,14 @@ std::unordered_map<std::string, Value> Interpreter::loadModuleWithExports(const
     cachedProgram = parser.parse();
 
     // Execute in isolated module scope
-    auto moduleEnv = arena_.create(globals);
+    auto moduleEnv = arena_.create(globals.get());
     std::unordered_map<std::string, Value> exports;
 
     auto prevEnv = env;
     auto prevFile = currentFile;
     auto* prevModuleExports = currentModuleExports_;
 
-    env = moduleEnv;
+    env = moduleEnv.get();
     currentFile = canonicalPath;
     currentModuleExports_ = &exports;
     importStack.push_back(canonicalPath);
@@ -760,72 +882,96 @@ void Interpreter::visit(ReExportStmt& stmt) {
 }
 
 void Interpreter::visit(BreakStmt& /*stmt*/) {
-    throw BreakSignal{};
+    completion_.type = Completion::Type::Break;
 }
 
 void Interpreter::visit(ContinueStmt& /*stmt*/) {
-    throw ContinueSignal{};
+    completion_.type = Completion::Type::Continue;
 }
 
 void Interpreter::visit(TryStmt& stmt) {
     bool exceptionCaught = false;
     Value caughtException;
+    // Where the exception was thrown: a throw statement in this function, or
+    // a copy of the token a ThrowSignal from a call carried
+    const Token* thrownAt = nullptr;
     Token exceptionToken(TokenType::ERROR, "", 0, 0);
 
     // Execute try block
+    Completion completion;
     try {
-        execute(*stmt.tryBlock);
+        completion = execute(*stmt.tryBlock);
     } catch (const ThrowSignal& e) {
         exceptionCaught = true;
         caughtException = e.exception;
         exceptionToken = e.token;
+    }
+    if (completion.type == Completion::Type::Throw) {
+        exceptionCaught = true;
+        caughtException = std::move(completion.value);
+        thrownAt = completion.token;
+    } else if (completion.abrupt()) {
+        // Returns, breaks and continues leave without running finally
+        completion_ = std::move(completion);
+        return;
+    }
 
-        // Execute catch block if present
-        if (stmt.catchBlock != nullptr) {
-            // Extract statements from BlockStmt
-            auto* blockPtr = dynamic_cast<BlockStmt*>(stmt.catchBlock.get());
-            if (blockPtr) {
-                // Create new environment for catch block with exception variable
-                auto catchEnv = arena_.create(env);
-
-                // Bind exception to catch variable
-                if (!stmt.catchVariable.empty()) {
-                    catchEnv->define(stmt.catchVariable, caughtException);
-                }
+    // Execute catch block if present
+    if (exceptionCaught && stmt.catchBlock != nullptr) {
+        // Extract statements from BlockStmt
+        auto* blockPtr = dynamic_cast<BlockStmt*>(stmt.catchBlock.get());
+        if (blockPtr) {
+            // Create new environment for catch block with exception variable
+            auto catchEnv = arena_.enter(env, stmt.catchScope);
+
+            // Bind exception to catch variable
+            if (!stmt.catchVariable.empty()) {
+                catchEnv->defineAt(0, caughtException);
+            }
 
-                executeBlock(blockPtr->statements, catchEnv);
-                exceptionCaught = false;  // Exception was handled
+            Completion handled = executeBlock(blockPtr->statements, catchEnv.get());
+            if (handled.abrupt()) {
+                completion_ = std::move(handled);
+                return;
             }
+            exceptionCaught = false;  // Exception was handled
         }
     }
 
-    // Execute finally block if present (always executes)
+    // Execute finally block if present (runs after normal and thrown completions)
     if (stmt.finallyBlock != nullptr) {
-        execute(*stmt.finallyBlock);
+        Completion finished = execute(*stmt.finallyBlock);
+        if (finished.abrupt()) {
+            completion_ = std::move(finished);
+            return;
+        }
     }
 
     // Re-throw if exception wasn't caught
     if (exceptionCaught) {
-        throw ThrowSignal(caughtException, exceptionToken);
+        if (!thrownAt) {
+            throw ThrowSignal(caughtException, exceptionToken);
+        }
+        completion_ = Completion{Completion::Type::Throw, std::move(caughtException), thrownAt};
     }
 }
 
 void Interpreter::visit(ThrowStmt& stmt) {
     Value exceptionValue = evaluate(*stmt.value);
-    throw ThrowSignal(exceptionValue, stmt.keyword);
+    completion_ = Completion{Completion::Type::Throw, std::move(exceptionValue), &stmt.keyword};
 }
 
 // v0.3: Class support
 void Interpreter::visit(ClassStmt& stmt) {
     // Get superclass if it exists
-    std::shared_ptr<IziClass> superclass = nullptr;
+    Ref<IziClass> superclass = nullptr;
     if (!stmt.superclass.empty()) {
-        Value superValue = env->get(stmt.superclass);
-        if (!std::holds_alternative<std::shared_ptr<Callable>>(superValue)) {
+        Value superValue = lookUp(stmt.superclass, stmt.superclassSlot);
+        if (!superValue.isCallable()) {
             throw RuntimeError(Token(TokenType::IDENTIFIER, stmt.superclass, 0, 0), "Superclass must be a class.");
         }
-        auto superCallable = std::get<std::shared_ptr<Callable>>(superValue);
-        superclass = std::dynamic_pointer_cast<IziClass>(superCallable);
+        auto superCallable = superValue.asCallable();
+        superclass = dynamicRefCast<IziClass>(superCallable);
         if (!superclass) {
             throw RuntimeError(Token(TokenType::IDENTIFIER, stmt.superclass, 0, 0), "Superclass must be a class.");
         }
@@ -846,96 +992,107 @@ void Interpreter::visit(ClassStmt& stmt) {
     // If we have a superclass, we need to define 'super' in the method's environment
     std::unordered_map<std::string, Value> methods;
     for (const auto& method : stmt.methods) {
-        Environment* methodEnv = env;
+        Ref<Environment> methodEnv;
 
         // If there's a superclass, create a new environment with 'super' defined
         if (superclass) {
-            methodEnv = arena_.create(env);
-            methodEnv->define("super", superclass);
+            methodEnv = arena_.create(env, &superScopeLayout());
+            methodEnv->defineAt(0, superclass);
+        } else {
+            methodEnv = EnvironmentArena::share(env);
         }
 
-        auto userFunc = std::make_shared<UserFunction>(method.get(), methodEnv);
+        auto userFunc = makeRef<UserFunction>(method.get(), methodEnv);
         methods[method->name] = userFunc;
     }
 
     // Create the class
-    auto klass = std::make_shared<IziClass>(stmt.name, superclass, std::move(fieldNames), std::move(fieldDefaults),
+    auto klass = makeRef<IziClass>(stmt.name, superclass, std::move(fieldNames), std::move(fieldDefaults),
                                             std::move(methods));
 
     // Define the class in the current environment
-    env->define(stmt.name, klass);
+    if (stmt.slot != NO_SLOT) {
+        env->defineAt(stmt.slot, klass);
+    } else {
+        env->define(stmt.name, klass);
+    }
 }
 
 // v0.3: Property access
 Value Interpreter::visit(PropertyExpr& expr) {
     Value object = expr.object->accept(*this);
+    return getProperty(object, expr.property);
+}
 
+Value Interpreter::getProperty(const Value& object, const std::string& property) {
     // Handle instance property access
-    if (std::holds_alternative<std::shared_ptr<Instance>>(object)) {
-        auto instance = std::get<std::shared_ptr<Instance>>(object);
+    if (object.isInstance()) {
+        auto instance = object.asInstance();
 
         // Check if it's a field
-        auto fieldIt = instance->fields.find(expr.property);
-        if (fieldIt != instance->fields.end()) {
-            return fieldIt->second;
+        if (const Value* field = instance->findField(property)) {
+            return *field;
         }
 
         // Check if it's a method
         Value method = Nil{};
-        if (std::holds_alternative<std::shared_ptr<IziClass>>(instance->klass)) {
-            auto klass = std::get<std::shared_ptr<IziClass>>(instance->klass);
-            method = klass->getMethod(expr.property, instance);
+        if (std::holds_alternative<Ref<IziClass>>(instance->klass)) {
+            auto klass = std::get<Ref<IziClass>>(instance->klass);
+            method = klass->getMethod(property, instance);
         } else {
-            throw RuntimeError(Token(TokenType::DOT, expr.property, 0, 0),
+            throw RuntimeError(Token(TokenType::DOT, property, 0, 0),
                                "Cannot access method from VM class in interpreter mode");
         }
-        if (!std::holds_alternative<Nil>(method)) {
+        if (!method.isNil()) {
             return method;
         }
 
-        throw RuntimeError(Token(TokenType::DOT, expr.property, 0, 0), "Undefined property '" + expr.property + "'.");
+        throw RuntimeError(Token(TokenType::DOT, property, 0, 0), "Undefined property '" + property + "'.");
     }
 
     // Handle map property access (backward compatibility)
-    if (std::holds_alternative<std::shared_ptr<Map>>(object)) {
-        auto map = std::get<std::shared_ptr<Map>>(object);
-        auto it = map->entries.find(expr.property);
+    if (object.isMap()) {
+        auto map = object.asMap();
+        auto it = map->entries.find(property);
         if (it != map->entries.end()) {
             return it->second;
         }
-        throw RuntimeError(Token(TokenType::DOT, expr.property, 0, 0), "Property '" + expr.property + "' not found.");
+        throw RuntimeError(Token(TokenType::DOT, property, 0, 0), "Property '" + property + "' not found.");
     }
 
-    throw RuntimeError(Token(TokenType::DOT, expr.property, 0, 0), "Only instances and maps support property access.");
+    throw RuntimeError(Token(TokenType::DOT, property, 0, 0), "Only instances and maps support property access.");
 }
 
 // v0.3: Property assignment
 Value Interpreter::visit(SetPropertyExpr& expr) {
     Value object = expr.object->accept(*this);
     Value value = expr.value->accept(*this);
+    return setProperty(object, expr.property, value);
+}
 
+Value Interpreter::setProperty(const Value& object, const std::string& property, const Value& value) {
     // Handle instance property assignment
-    if (std::holds_alternative<std::shared_ptr<Instance>>(object)) {
-        auto instance = std::get<std::shared_ptr<Instance>>(object);
-        instance->fields[expr.property] = value;
+    if (object.isInstance()) {
+        auto instance = object.asInstance();
+        instance->setField(property, value);
         return value;
     }
 
     // Handle map property assignment (backward compatibility)
-    if (std::holds_alternative<std::shared_ptr<Map>>(object)) {
-        auto map = std::get<std::shared_ptr<Map>>(object);
-        map->entries[expr.property] = value;
+    if (object.isMap()) {
+        auto map = object.asMap();
+        map->entries[property] = value;
         return value;
     }
 
-    throw RuntimeError(Token(TokenType::DOT, expr.property, 0, 0),
+    throw RuntimeError(Token(TokenType::DOT, property, 0, 0),
                        "Only instances and maps support property assignment.");
 }
 
 // v0.3: This expression
 Value Interpreter::visit(ThisExpr& expr) {
     try {
-        return env->get("this");
+        return lookUp("this", expr.slot);
     } catch (const std::runtime_error& e) {
         throw RuntimeError(Token(TokenType::THIS, "this", 0, 0), "Cannot use 'this' outside of a class method.");
     }
@@ -944,14 +1101,14 @@ Value Interpreter::visit(ThisExpr& expr) {
 // v0.3: Super expression
 Value Interpreter::visit(SuperExpr& expr) {
     // Get the superclass from the environment
-    std::shared_ptr<IziClass> superclass;
+    Ref<IziClass> superclass;
     try {
-        Value superValue = env->get("super");
-        if (!std::holds_alternative<std::shared_ptr<Callable>>(superValue)) {
+        Value superValue = lookUp("super", expr.superSlot);
+        if (!superValue.isCallable()) {
             throw RuntimeError(Token(TokenType::SUPER, "super", 0, 0), "Invalid superclass reference.");
         }
-        auto superCallable = std::get<std::shared_ptr<Callable>>(superValue);
-        superclass = std::dynamic_pointer_cast<IziClass>(superCallable);
+        auto superCallable = superValue.asCallable();
+        superclass = dynamicRefCast<IziClass>(superCallable);
         if (!superclass) {
             throw RuntimeError(Token(TokenType::SUPER, "super", 0, 0), "Invalid superclass reference.");
         }
@@ -960,20 +1117,20 @@ Value Interpreter::visit(SuperExpr& expr) {
     }
 
     // Get 'this' to bind the method to
-    std::shared_ptr<Instance> instance;
+    Ref<Instance> instance;
     try {
-        Value thisValue = env->get("this");
-        if (!std::holds_alternative<std::shared_ptr<Instance>>(thisValue)) {
+        Value thisValue = lookUp("this", expr.thisSlot);
+        if (!thisValue.isInstance()) {
             throw RuntimeError(Token(TokenType::SUPER, "super", 0, 0), "Cannot use 'super' without a valid instance.");
         }
-        instance = std::get<std::shared_ptr<Instance>>(thisValue);
+        instance = thisValue.asInstance();
     } catch (const std::runtime_error& e) {
         throw RuntimeError(Token(TokenType::SUPER, "super", 0, 0), "Cannot use 'super' outside of a class method.");
     }
 
     // Get the method from the superclass
     Value method = superclass->getMethod(expr.method, instance);
-    if (std::holds_alternative<Nil>(method)) {
+    if (method.isNil()) {
         throw RuntimeError(Token(TokenType::SUPER, "super", 0, 0),
                            "Undefined method '" + expr.method + "' in superclass.");
     }
@@ -985,8 +1142,8 @@ Value Interpreter::visit(AwaitExpr& expr) {
     Value val = evaluate(*expr.value);
 
     // If the value is a Task, run it and return its result
-    if (std::holds_alternative<std::shared_ptr<Task>>(val)) {
-        auto task = std::get<std::shared_ptr<Task>>(val);
+    if (val.isTask()) {
+        auto task = val.asTask();
 
         // OS-thread task: block until the thread signals completion
         if (task->osMutex != nullptr) {
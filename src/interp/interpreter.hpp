@@ -29,14 +29,21 @@ class RuntimeError : public std::runtime_error {
     void addFrame(const std::string& name, int line) { callStack.emplace_back(name, line); }
 };
 
-struct ReturnSignal {
-    Value value;
-};
+// How a statement finished.  `return`, `break`, `continue` and `throw`
+// complete abruptly: the statements around them stop and hand the record up
+// to the loop, function or try statement that handles it.
+struct Completion {
+    enum class Type : uint8_t { Normal, Return, Break, Continue, Throw };
 
-struct BreakSignal {};
+    Type type = Type::Normal;
+    Value value;                   // The returned or thrown value
+    const Token* token = nullptr;  // The throw statement's keyword
 
-struct ContinueSignal {};
+    bool abrupt() const { return type != Type::Normal; }
+};
 
+// A thrown value unwinding the C++ stack, once it leaves the function that
+// threw it
 struct ThrowSignal {
     Value exception;
     Token token;  // For error reporting
@@ -68,8 +75,12 @@ class Interpreter : public ExprVisitor, public StmtVisitor {
     const std::vector<std::string>& getCommandLineArgs() const { return commandLineArgs; }
 
     // Get global environment (for REPL :vars command).
-    // Returns a non-owning pointer; the environment is owned by arena_.
-    const Environment* getGlobals() const { return globals; }
+    // Returns a non-owning pointer; the interpreter owns the globals.
+    const Environment* getGlobals() const { return globals.get(); }
+
+    // Run programs through closures compiled from their resolved trees
+    // (`izi run --closure`) instead of visiting the nodes
+    void setClosureCompilation(bool enabled) { closureCompilation_ = enabled; }
 
     // Set a debug hook to receive execution events (for DAP support).
     // The hook must outlive the interpreter. Pass nullptr to disable.
@@ -127,30 +138,61 @@ class Interpreter : public ExprVisitor, public StmtVisitor {
     void visit(ThrowStmt&) override;
     void visit(ClassStmt&) override;  // v0.3
 
-    void executeBlock(const std::vector<StmtPtr>& statements, Environment* newEnv);
+    Completion executeBlock(const std::vector<StmtPtr>& statements, Environment* newEnv);
+    // Run a function body in `newEnv`; in closure mode the body is compiled
+    // into `compiled` the first time
+    Completion executeBody(const std::vector<StmtPtr>& body, std::shared_ptr<CompiledBlock>& compiled,
+                           Environment* newEnv);
+    // The value a function body or a program produces when it ends with
+    // `completion`; a thrown value is rethrown as a ThrowSignal
+    Value finish(Completion&& completion);
 
     // Runtime safety tracking (public so UserFunction can access it)
     size_t callDepth = 0;
 
-    // Arena that owns all Environment objects created during interpretation.
+    // Allocator for the environments created during interpretation.
     // Exposed so that UserFunction::call and BoundMethod::call can allocate
     // call-frame environments without going through a separate factory.
     EnvironmentArena arena_;
 
    private:
+    friend class ClosureCompiler;
+
     std::string_view source_;
-    Environment* globals;  // Non-owning; owned by arena_
-    Environment* env;      // Non-owning; owned by arena_
+    Ref<Environment> globals;
+    Environment* env;  // Non-owning; the scope that entered it keeps it alive
 
     // Debug hook (optional, not owned)
     DebugHook* debugHook_ = nullptr;
 
+    bool closureCompilation_ = false;
+
+    // How the statement being executed completed, when abruptly; statement
+    // visitors return nothing, so they leave it here for execute() to take
+    Completion completion_;
+
     Value evaluate(Expr& expr);
-    void execute(Stmt& expr);
+    Completion execute(Stmt& stmt);
+
+    // Read or write a variable through its resolved slot, or by name
+    Value lookUp(const std::string& name, const VarSlot& slot);
+    void assignTo(const std::string& name, const VarSlot& slot, const Value& value);
+    // Evaluate with `scope` as the current environment
+    Value evaluateIn(Expr& expr, Environment* scope);
 
     // Helper to convert value to number with proper error
     double toNumber(const Value& v, const Token& token);
 
+    // The operations behind the expression visitors, on evaluated operands;
+    // shared with the ClosureCompiler's code
+    Value binaryOp(const Token& op, const Value& left, const Value& right);
+    Ref<Callable> calleeOf(const Value& callee);
+    Value callWith(Callable& callable, const std::vector<Value>& arguments);
+    Value getIndex(const Value& collection, const Value& index);
+    Value setIndex(const Value& collection, const Value& index, const Value& value);
+    Value getProperty(const Value& object, const std::string& property);
+    Value setProperty(const Value& object, const std::string& property, const Value& value);
+
     // for imports
     std::unordered_set<std::string> importedModules;
     std::vector<std::string> importStack;  // Track files being imported (for circular detection)
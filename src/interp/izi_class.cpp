@@ -1,43 +1,59 @@
 #include "izi_class.hpp"
 #include "interpreter.hpp"
 #include "user_function.hpp"
+#include "bytecode/vm_class.hpp"
 
 namespace izi {
 
+void Instance::traceRefs(GcTracer& tracer) const {
+    std::visit([&](const auto& cls) { tracer.trace(cls); }, klass);
+    for (const Value& slot : slots) tracer.trace(slot);
+}
+
+void Instance::clearRefs() {
+    klass = Ref<IziClass>();
+    shape = Shape::empty();
+    slots.clear();
+}
+
 Value BoundMethod::call(Interpreter& interp, const std::vector<Value>& arguments) {
-    // To properly bind 'this', we create a new environment with 'this' defined
-    // and the method's closure as its parent
+    // To properly bind 'this', the method runs in an environment with 'this'
+    // defined, between the method's closure and its call environment
 
-    auto userFunc = std::dynamic_pointer_cast<UserFunction>(method);
+    auto userFunc = dynamicRefCast<UserFunction>(method);
     if (!userFunc) {
         // If it's not a UserFunction, just call it directly
         return method->call(interp, arguments);
     }
 
-    // Create a new environment with 'this' defined, using the method's closure as parent
-    auto thisEnv = interp.arena_.create(userFunc->getClosure());
-    thisEnv->define("this", instance);
-
-    // Create a temporary UserFunction with the new closure
-    std::shared_ptr<UserFunction> boundFunc;
-    if (userFunc->getDecl()) {
-        boundFunc = std::make_shared<UserFunction>(userFunc->getDecl(), thisEnv);
-    } else if (userFunc->getFuncExpr()) {
-        boundFunc = std::make_shared<UserFunction>(userFunc->getFuncExpr(), thisEnv);
-    } else {
-        throw std::runtime_error("Invalid UserFunction: no declaration or expression");
+    if (userFunc->getIsAsync()) {
+        // The task runs later, so it gets a function of its own closing over
+        // a shared 'this' environment
+        auto thisEnv = interp.arena_.create(userFunc->getClosure(), &thisScopeLayout());
+        thisEnv->defineAt(0, instance);
+        Ref<UserFunction> boundFunc;
+        if (userFunc->getDecl()) {
+            boundFunc = makeRef<UserFunction>(userFunc->getDecl(), thisEnv);
+        } else if (userFunc->getFuncExpr()) {
+            boundFunc = makeRef<UserFunction>(userFunc->getFuncExpr(), thisEnv);
+        } else {
+            throw std::runtime_error("Invalid UserFunction: no declaration or expression");
+        }
+        return boundFunc->call(interp, arguments);
     }
 
-    // Call the bound function
-    return boundFunc->call(interp, arguments);
+    // Closures created in the body capture 'this' along with the call
+    auto thisEnv = interp.arena_.enter(userFunc->getClosure(), &thisScopeLayout(), userFunc->getScope().captured);
+    thisEnv->defineAt(0, instance);
+    return userFunc->callWithin(interp, arguments, thisEnv.get());
 }
 
 int IziClass::arity() const {
     // Check if there's an init method (preferred) or constructor method
     auto initIt = methods.find("init");
     if (initIt != methods.end()) {
-        if (std::holds_alternative<std::shared_ptr<Callable>>(initIt->second)) {
-            auto init = std::get<std::shared_ptr<Callable>>(initIt->second);
+        if (initIt->second.isCallable()) {
+            auto init = initIt->second.asCallable();
             return init->arity();
         }
     }
@@ -45,8 +61,8 @@ int IziClass::arity() const {
     auto constructorIt = methods.find("constructor");
     if (constructorIt != methods.end()) {
         // Get the arity from the constructor
-        if (std::holds_alternative<std::shared_ptr<Callable>>(constructorIt->second)) {
-            auto constructor = std::get<std::shared_ptr<Callable>>(constructorIt->second);
+        if (constructorIt->second.isCallable()) {
+            auto constructor = constructorIt->second.asCallable();
             return constructor->arity();
         }
     }
@@ -60,7 +76,7 @@ int IziClass::arity() const {
 }
 
 // Helper method to recursively initialize fields from the entire inheritance chain
-void initializeFieldsRecursive(const IziClass* klass, std::shared_ptr<Instance> instance) {
+void initializeFieldsRecursive(const IziClass* klass, Ref<Instance> instance) {
     // First initialize superclass fields (depth-first)
     if (klass->superclass) {
         initializeFieldsRecursive(klass->superclass.get(), instance);
@@ -70,11 +86,11 @@ void initializeFieldsRecursive(const IziClass* klass, std::shared_ptr<Instance>
     for (const auto& fieldName : klass->fieldNames) {
         auto it = klass->fieldDefaults.find(fieldName);
         if (it != klass->fieldDefaults.end()) {
-            instance->fields[fieldName] = it->second;
+            instance->setField(fieldName, it->second);
         } else {
             // Only initialize to Nil if not already initialized by a parent class
-            if (instance->fields.find(fieldName) == instance->fields.end()) {
-                instance->fields[fieldName] = Nil{};
+            if (instance->findField(fieldName) == nullptr) {
+                instance->setField(fieldName, Nil{});
             }
         }
     }
@@ -82,7 +98,7 @@ void initializeFieldsRecursive(const IziClass* klass, std::shared_ptr<Instance>
 
 Value IziClass::call(Interpreter& interp, const std::vector<Value>& arguments) {
     // Create a new instance
-    auto instance = std::make_shared<Instance>(shared_from_this());
+    auto instance = makeRef<Instance>(Ref<IziClass>(this));
 
     // Initialize fields from the entire inheritance chain (recursive)
     initializeFieldsRecursive(this, instance);
@@ -90,16 +106,16 @@ Value IziClass::call(Interpreter& interp, const std::vector<Value>& arguments) {
     // Look for constructor or init method (init takes precedence for OOP convention)
     // Use getMethod to check the entire inheritance chain
     Value init = getMethod("init", instance);
-    if (!std::holds_alternative<Nil>(init)) {
-        if (std::holds_alternative<std::shared_ptr<Callable>>(init)) {
-            auto initCallable = std::get<std::shared_ptr<Callable>>(init);
+    if (!init.isNil()) {
+        if (init.isCallable()) {
+            auto initCallable = init.asCallable();
             initCallable->call(interp, arguments);
         }
     } else {
         Value constructor = getMethod("constructor", instance);
-        if (!std::holds_alternative<Nil>(constructor)) {
-            if (std::holds_alternative<std::shared_ptr<Callable>>(constructor)) {
-                auto constructorCallable = std::get<std::shared_ptr<Callable>>(constructor);
+        if (!constructor.isNil()) {
+            if (constructor.isCallable()) {
+                auto constructorCallable = constructor.asCallable();
                 constructorCallable->call(interp, arguments);
             }
         }
@@ -108,14 +124,14 @@ Value IziClass::call(Interpreter& interp, const std::vector<Value>& arguments) {
     return instance;
 }
 
-Value IziClass::getMethod(const std::string& name, std::shared_ptr<Instance> instance) {
+Value IziClass::getMethod(const std::string& name, Ref<Instance> instance) {
     // First check this class's methods
     auto it = methods.find(name);
     if (it != methods.end()) {
         // Bind the method to the instance
-        if (std::holds_alternative<std::shared_ptr<Callable>>(it->second)) {
-            auto callable = std::get<std::shared_ptr<Callable>>(it->second);
-            return std::make_shared<BoundMethod>(instance, callable);
+        if (it->second.isCallable()) {
+            auto callable = it->second.asCallable();
+            return makeRef<BoundMethod>(instance, callable);
         }
         return it->second;
     }
@@ -128,4 +144,16 @@ Value IziClass::getMethod(const std::string& name, std::shared_ptr<Instance> ins
     return Nil{};
 }
 
+void IziClass::traceRefs(GcTracer& tracer) const {
+    tracer.trace(superclass);
+    for (const auto& [name, method] : methods) tracer.trace(method);
+    for (const auto& [name, value] : fieldDefaults) tracer.trace(value);
+}
+
+void IziClass::clearRefs() {
+    superclass.reset();
+    methods.clear();
+    fieldDefaults.clear();
+}
+
 }  // namespace izi
@@ -7,6 +7,7 @@
 #include <variant>
 
 #include "common/callable.hpp"
+#include "common/shape.hpp"
 #include "common/value.hpp"
 #include "ast/stmt.hpp"
 #include "environment.hpp"
@@ -17,22 +18,43 @@ class Interpreter;
 class IziClass;
 class VmClass;
 
-// Represents an instance of a class
-struct Instance {
-    std::variant<std::shared_ptr<IziClass>, std::shared_ptr<VmClass>> klass;
-    std::unordered_map<std::string, Value> fields;
-
-    explicit Instance(std::shared_ptr<IziClass> k) : klass(std::move(k)) {}
-    explicit Instance(std::shared_ptr<VmClass> k) : klass(std::move(k)) {}
+// Represents an instance of a class.  Field values live in `slots`, laid out
+// by `shape`; use findField/setField for access by name.
+struct Instance : RefCounted, GcObject {
+    std::variant<Ref<IziClass>, Ref<VmClass>> klass;
+    std::shared_ptr<Shape> shape;
+    std::vector<Value> slots;
+
+    explicit Instance(Ref<IziClass> k) : klass(std::move(k)), shape(Shape::empty()) {}
+    explicit Instance(Ref<VmClass> k) : klass(std::move(k)), shape(Shape::empty()) {}
+    Instance(Ref<VmClass> k, std::shared_ptr<Shape> s, std::vector<Value> initialSlots)
+        : klass(std::move(k)), shape(std::move(s)), slots(std::move(initialSlots)) {}
+
+    Value* findField(const std::string& name) {
+        int slot = shape->slotOf(name);
+        return slot < 0 ? nullptr : &slots[static_cast<size_t>(slot)];
+    }
+
+    void setField(const std::string& name, Value value) {
+        if (Value* field = findField(name)) {
+            *field = std::move(value);
+            return;
+        }
+        shape = shape->withField(name);
+        slots.push_back(std::move(value));
+    }
+
+    void traceRefs(GcTracer& tracer) const override;
+    void clearRefs() override;
 };
 
 // Binds a method to an instance
-class BoundMethod : public Callable {
+class BoundMethod : public Callable, public GcObject {
    public:
-    std::shared_ptr<Instance> instance;
-    std::shared_ptr<Callable> method;
+    Ref<Instance> instance;
+    Ref<Callable> method;
 
-    BoundMethod(std::shared_ptr<Instance> inst, std::shared_ptr<Callable> meth)
+    BoundMethod(Ref<Instance> inst, Ref<Callable> meth)
         : instance(std::move(inst)), method(std::move(meth)) {}
 
     std::string name() const override { return method->name(); }
@@ -40,18 +62,27 @@ class BoundMethod : public Callable {
     int arity() const override { return method->arity(); }
 
     Value call(Interpreter& interp, const std::vector<Value>& arguments) override;
+
+    void traceRefs(GcTracer& tracer) const override {
+        tracer.trace(instance);
+        tracer.trace(method);
+    }
+    void clearRefs() override {
+        instance.reset();
+        method.reset();
+    }
 };
 
 // Represents a class definition (callable to construct instances)
-class IziClass : public Callable, public std::enable_shared_from_this<IziClass> {
+class IziClass : public Callable, public GcObject {
    public:
     std::string className;
-    std::shared_ptr<IziClass> superclass;  // Parent class for inheritance
+    Ref<IziClass> superclass;  // Parent class for inheritance
     std::unordered_map<std::string, Value> methods;
     std::vector<std::string> fieldNames;
     std::unordered_map<std::string, Value> fieldDefaults;
 
-    IziClass(std::string name, std::shared_ptr<IziClass> super, std::vector<std::string> fields,
+    IziClass(std::string name, Ref<IziClass> super, std::vector<std::string> fields,
              std::unordered_map<std::string, Value> defaults, std::unordered_map<std::string, Value> meths)
         : className(std::move(name)),
           superclass(std::move(super)),
@@ -65,7 +96,10 @@ class IziClass : public Callable, public std::enable_shared_from_this<IziClass>
 
     Value call(Interpreter& interp, const std::vector<Value>& arguments) override;
 
-    Value getMethod(const std::string& name, std::shared_ptr<Instance> instance);
+    Value getMethod(const std::string& name, Ref<Instance> instance);
+
+    void traceRefs(GcTracer& tracer) const override;
+    void clearRefs() override;
 };
 
 }  // namespace izi
@@ -47,17 +47,17 @@ auto nativeLen(Interpreter& interp, const std::vector<Value>& arguments) -> Valu
         throw std::runtime_error("len() takes exactly one argument.");
     }
     const Value& arg = arguments[0];
-    if (std::holds_alternative<std::shared_ptr<Array>>(arg)) {
-        auto arr = std::get<std::shared_ptr<Array>>(arg);
+    if (arg.isArray()) {
+        auto arr = arg.asArray();
         return static_cast<double>(arr->elements.size());
-    } else if (std::holds_alternative<std::shared_ptr<Map>>(arg)) {
-        auto map = std::get<std::shared_ptr<Map>>(arg);
+    } else if (arg.isMap()) {
+        auto map = arg.asMap();
         return static_cast<double>(map->entries.size());
-    } else if (std::holds_alternative<std::shared_ptr<Set>>(arg)) {
-        auto set = std::get<std::shared_ptr<Set>>(arg);
+    } else if (arg.isSet()) {
+        auto set = arg.asSet();
         return static_cast<double>(set->values.size());
-    } else if (std::holds_alternative<std::string>(arg)) {
-        auto str = std::get<std::string>(arg);
+    } else if (arg.isString()) {
+        auto str = arg.asString();
         return static_cast<double>(str.size());
     }
 
@@ -77,10 +77,10 @@ auto nativePush(Interpreter& interp, const std::vector<Value>& arguments) -> Val
     }
     const Value& arrVal = arguments[0];
     const Value& elem = arguments[1];
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arrVal)) {
+    if (!arrVal.isArray()) {
         throw std::runtime_error("First argument to push() must be an array.");
     }
-    auto arr = std::get<std::shared_ptr<Array>>(arrVal);
+    auto arr = arrVal.asArray();
     arr->elements.push_back(elem);
     return arr;
 }
@@ -90,10 +90,10 @@ auto nativePop(Interpreter& interp, const std::vector<Value>& arguments) -> Valu
         throw std::runtime_error("pop() takes exactly one argument.");
     }
     const Value& arrVal = arguments[0];
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arrVal)) {
+    if (!arrVal.isArray()) {
         throw std::runtime_error("Argument to pop() must be an array.");
     }
-    auto arr = std::get<std::shared_ptr<Array>>(arrVal);
+    auto arr = arrVal.asArray();
     if (arr->elements.empty()) {
         throw std::runtime_error("Cannot pop from an empty array.");
     }
@@ -106,11 +106,11 @@ auto nativeKeys(Interpreter& interp, const std::vector<Value>& arguments) -> Val
         throw std::runtime_error("keys() takes exactly one argument.");
     }
     const Value& mapVal = arguments[0];
-    if (!std::holds_alternative<std::shared_ptr<Map>>(mapVal)) {
+    if (!mapVal.isMap()) {
         throw std::runtime_error("Argument to keys() must be a map.");
     }
-    auto map = std::get<std::shared_ptr<Map>>(mapVal);
-    auto keysArray = std::make_shared<Array>();
+    auto map = mapVal.asMap();
+    auto keysArray = makeRef<Array>();
     for (const auto& [key, _] : map->entries) {
         keysArray->elements.push_back(key);
     }
@@ -122,11 +122,11 @@ auto nativeValues(Interpreter& interp, const std::vector<Value>& arguments) -> V
         throw std::runtime_error("values() takes exactly one argument.");
     }
     const Value& mapVal = arguments[0];
-    if (!std::holds_alternative<std::shared_ptr<Map>>(mapVal)) {
+    if (!mapVal.isMap()) {
         throw std::runtime_error("Argument to values() must be a map.");
     }
-    auto map = std::get<std::shared_ptr<Map>>(mapVal);
-    auto valuesArray = std::make_shared<Array>();
+    auto map = mapVal.asMap();
+    auto valuesArray = makeRef<Array>();
     for (const auto& [_, value] : map->entries) {
         valuesArray->elements.push_back(value);
     }
@@ -139,14 +139,14 @@ auto nativeHasKey(Interpreter& interp, const std::vector<Value>& arguments) -> V
     }
     const Value& mapVal = arguments[0];
     const Value& keyVal = arguments[1];
-    if (!std::holds_alternative<std::shared_ptr<Map>>(mapVal)) {
+    if (!mapVal.isMap()) {
         throw std::runtime_error("First argument to hasKey() must be a map.");
     }
-    if (!std::holds_alternative<std::string>(keyVal)) {
+    if (!keyVal.isString()) {
         throw std::runtime_error("Second argument to hasKey() must be a string.");
     }
-    auto map = std::get<std::shared_ptr<Map>>(mapVal);
-    std::string key = std::get<std::string>(keyVal);
+    auto map = mapVal.asMap();
+    std::string key = keyVal.asString();
     bool hasKey = (map->entries.find(key) != map->entries.end());
     return hasKey;
 }
@@ -156,10 +156,10 @@ auto nativeShift(Interpreter& interp, const std::vector<Value>& arguments) -> Va
         throw std::runtime_error("shift() takes exactly one argument.");
     }
     const Value& arrVal = arguments[0];
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arrVal)) {
+    if (!arrVal.isArray()) {
         throw std::runtime_error("Argument to shift() must be an array.");
     }
-    auto arr = std::get<std::shared_ptr<Array>>(arrVal);
+    auto arr = arrVal.asArray();
     if (arr->elements.empty()) {
         throw std::runtime_error("Cannot shift from an empty array.");
     }
@@ -174,10 +174,10 @@ auto nativeUnshift(Interpreter& interp, const std::vector<Value>& arguments) ->
     }
     const Value& arrVal = arguments[0];
     const Value& elem = arguments[1];
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arrVal)) {
+    if (!arrVal.isArray()) {
         throw std::runtime_error("First argument to unshift() must be an array.");
     }
-    auto arr = std::get<std::shared_ptr<Array>>(arrVal);
+    auto arr = arrVal.asArray();
     arr->elements.insert(arr->elements.begin(), elem);
     return arr;
 }
@@ -187,15 +187,15 @@ auto nativeSplice(Interpreter& interp, const std::vector<Value>& arguments) -> V
         throw std::runtime_error("splice() takes 2 or 3 arguments.");
     }
     const Value& arrVal = arguments[0];
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arrVal)) {
+    if (!arrVal.isArray()) {
         throw std::runtime_error("First argument to splice() must be an array.");
     }
 
-    auto arr = std::get<std::shared_ptr<Array>>(arrVal);
+    auto arr = arrVal.asArray();
     size_t start = static_cast<size_t>(asNumber(arguments[1]));
 
     if (start >= arr->elements.size()) {
-        return std::make_shared<Array>();
+        return makeRef<Array>();
     }
 
     size_t deleteCount;
@@ -206,7 +206,7 @@ auto nativeSplice(Interpreter& interp, const std::vector<Value>& arguments) -> V
     }
 
     // Create result array with removed elements
-    auto result = std::make_shared<Array>();
+    auto result = makeRef<Array>();
     size_t end = std::min(start + deleteCount, arr->elements.size());
 
     for (size_t i = start; i < end; ++i) {
@@ -230,17 +230,18 @@ auto nativeDelete(Interpreter& interp, const std::vector<Value>& arguments) -> V
     }
     const Value& mapVal = arguments[0];
     const Value& keyVal = arguments[1];
-    if (!std::holds_alternative<std::shared_ptr<Map>>(mapVal)) {
+    if (!mapVal.isMap()) {
         throw std::runtime_error("First argument to delete() must be a map.");
     }
-    if (!std::holds_alternative<std::string>(keyVal)) {
+    if (!keyVal.isString()) {
         throw std::runtime_error("Second argument to delete() must be a string.");
     }
-    auto map = std::get<std::shared_ptr<Map>>(mapVal);
-    std::string key = std::get<std::string>(keyVal);
+    auto map = mapVal.asMap();
+    std::string key = keyVal.asString();
     bool existed = (map->entries.find(key) != map->entries.end());
     if (existed) {
         map->entries.erase(key);
+        ++map->layoutVersion;
     }
     return existed;
 }
@@ -250,13 +251,13 @@ auto nativeEntries(Interpreter& interp, const std::vector<Value>& arguments) ->
         throw std::runtime_error("entries() takes exactly one argument.");
     }
     const Value& mapVal = arguments[0];
-    if (!std::holds_alternative<std::shared_ptr<Map>>(mapVal)) {
+    if (!mapVal.isMap()) {
         throw std::runtime_error("Argument to entries() must be a map.");
     }
-    auto map = std::get<std::shared_ptr<Map>>(mapVal);
-    auto entriesArray = std::make_shared<Array>();
+    auto map = mapVal.asMap();
+    auto entriesArray = makeRef<Array>();
     for (const auto& [key, value] : map->entries) {
-        auto entry = std::make_shared<Array>();
+        auto entry = makeRef<Array>();
         entry->elements.push_back(key);
         entry->elements.push_back(value);
         entriesArray->elements.push_back(entry);
@@ -272,24 +273,24 @@ auto nativeSetAdd(Interpreter& interp, const std::vector<Value>& arguments) -> V
     }
     const Value& setVal = arguments[0];
     const Value& valueVal = arguments[1];
-    if (!std::holds_alternative<std::shared_ptr<Set>>(setVal)) {
+    if (!setVal.isSet()) {
         throw std::runtime_error("First argument to setAdd() must be a set.");
     }
 
-    auto set = std::get<std::shared_ptr<Set>>(setVal);
+    auto set = setVal.asSet();
 
     // Convert value to string for key (using a simple serialization)
     std::string key;
-    if (std::holds_alternative<std::string>(valueVal)) {
-        key = std::get<std::string>(valueVal);
-    } else if (std::holds_alternative<double>(valueVal)) {
+    if (valueVal.isString()) {
+        key = valueVal.asString();
+    } else if (valueVal.isNumber()) {
         // Use stringstream for consistent number formatting
         std::ostringstream oss;
-        oss << std::fixed << std::setprecision(15) << std::get<double>(valueVal);
+        oss << std::fixed << std::setprecision(15) << valueVal.asNumber();
         key = oss.str();
-    } else if (std::holds_alternative<bool>(valueVal)) {
-        key = std::get<bool>(valueVal) ? "true" : "false";
-    } else if (std::holds_alternative<Nil>(valueVal)) {
+    } else if (valueVal.isBool()) {
+        key = valueVal.asBool() ? "true" : "false";
+    } else if (valueVal.isNil()) {
         key = "nil";
     } else {
         throw std::runtime_error("setAdd() only supports primitive types (string, number, boolean, nil), but got: " +
@@ -306,24 +307,24 @@ auto nativeSetHas(Interpreter& interp, const std::vector<Value>& arguments) -> V
     }
     const Value& setVal = arguments[0];
     const Value& valueVal = arguments[1];
-    if (!std::holds_alternative<std::shared_ptr<Set>>(setVal)) {
+    if (!setVal.isSet()) {
         throw std::runtime_error("First argument to setHas() must be a set.");
     }
 
-    auto set = std::get<std::shared_ptr<Set>>(setVal);
+    auto set = setVal.asSet();
 
     // Convert value to string for key lookup
     std::string key;
-    if (std::holds_alternative<std::string>(valueVal)) {
-        key = std::get<std::string>(valueVal);
-    } else if (std::holds_alternative<double>(valueVal)) {
+    if (valueVal.isString()) {
+        key = valueVal.asString();
+    } else if (valueVal.isNumber()) {
         // Use stringstream for consistent number formatting
         std::ostringstream oss;
-        oss << std::fixed << std::setprecision(15) << std::get<double>(valueVal);
+        oss << std::fixed << std::setprecision(15) << valueVal.asNumber();
         key = oss.str();
-    } else if (std::holds_alternative<bool>(valueVal)) {
-        key = std::get<bool>(valueVal) ? "true" : "false";
-    } else if (std::holds_alternative<Nil>(valueVal)) {
+    } else if (valueVal.isBool()) {
+        key = valueVal.asBool() ? "true" : "false";
+    } else if (valueVal.isNil()) {
         key = "nil";
     } else {
         return false;
@@ -338,24 +339,24 @@ auto nativeSetDelete(Interpreter& interp, const std::vector<Value>& arguments) -
     }
     const Value& setVal = arguments[0];
     const Value& valueVal = arguments[1];
-    if (!std::holds_alternative<std::shared_ptr<Set>>(setVal)) {
+    if (!setVal.isSet()) {
         throw std::runtime_error("First argument to setDelete() must be a set.");
     }
 
-    auto set = std::get<std::shared_ptr<Set>>(setVal);
+    auto set = setVal.asSet();
 
     // Convert value to string for key lookup
     std::string key;
-    if (std::holds_alternative<std::string>(valueVal)) {
-        key = std::get<std::string>(valueVal);
-    } else if (std::holds_alternative<double>(valueVal)) {
+    if (valueVal.isString()) {
+        key = valueVal.asString();
+    } else if (valueVal.isNumber()) {
         // Use stringstream for consistent number formatting
         std::ostringstream oss;
-        oss << std::fixed << std::setprecision(15) << std::get<double>(valueVal);
+        oss << std::fixed << std::setprecision(15) << valueVal.asNumber();
         key = oss.str();
-    } else if (std::holds_alternative<bool>(valueVal)) {
-        key = std::get<bool>(valueVal) ? "true" : "false";
-    } else if (std::holds_alternative<Nil>(valueVal)) {
+    } else if (valueVal.isBool()) {
+        key = valueVal.asBool() ? "true" : "false";
+    } else if (valueVal.isNil()) {
         key = "nil";
     } else {
         return false;
@@ -373,10 +374,10 @@ auto nativeSetSize(Interpreter& interp, const std::vector<Value>& arguments) ->
         throw std::runtime_error("setSize() takes exactly one argument.");
     }
     const Value& setVal = arguments[0];
-    if (!std::holds_alternative<std::shared_ptr<Set>>(setVal)) {
+    if (!setVal.isSet()) {
         throw std::runtime_error("Argument to setSize() must be a set.");
     }
-    auto set = std::get<std::shared_ptr<Set>>(setVal);
+    auto set = setVal.asSet();
     return static_cast<double>(set->values.size());
 }
 
@@ -384,7 +385,7 @@ auto nativeSet(Interpreter& interp, const std::vector<Value>& arguments) -> Valu
     if (arguments.size() != 0) {
         throw std::runtime_error("Set() takes no arguments.");
     }
-    return std::make_shared<Set>();
+    return makeRef<Set>();
 }
 
 // ============ std.math functions ============
@@ -617,10 +618,10 @@ auto nativeSubstring(Interpreter& interp, const std::vector<Value>& arguments) -
     if (arguments.size() < 2 || arguments.size() > 3) {
         throw std::runtime_error("substring() takes 2 or 3 arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("First argument to substring() must be a string.");
     }
-    std::string str = std::get<std::string>(arguments[0]);
+    std::string str = arguments[0].asString();
     size_t start = static_cast<size_t>(asNumber(arguments[1]));
     size_t length = (arguments.size() == 3) ? static_cast<size_t>(asNumber(arguments[2])) : str.length() - start;
 
@@ -634,13 +635,13 @@ auto nativeSplit(Interpreter& interp, const std::vector<Value>& arguments) -> Va
     if (arguments.size() != 2) {
         throw std::runtime_error("split() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to split() must be strings.");
     }
-    std::string str = std::get<std::string>(arguments[0]);
-    std::string delim = std::get<std::string>(arguments[1]);
+    std::string str = arguments[0].asString();
+    std::string delim = arguments[1].asString();
 
-    auto result = std::make_shared<Array>();
+    auto result = makeRef<Array>();
     if (delim.empty()) {
         for (char c : str) {
             result->elements.push_back(std::string(1, c));
@@ -663,19 +664,19 @@ auto nativeJoin(Interpreter& interp, const std::vector<Value>& arguments) -> Val
     if (arguments.size() != 2) {
         throw std::runtime_error("join() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arguments[0]) ||
-        !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isArray() ||
+        !arguments[1].isString()) {
         throw std::runtime_error("join() requires an array and a string separator.");
     }
-    auto arr = std::get<std::shared_ptr<Array>>(arguments[0]);
-    std::string sep = std::get<std::string>(arguments[1]);
+    auto arr = arguments[0].asArray();
+    std::string sep = arguments[1].asString();
 
     std::stringstream ss;
     for (size_t i = 0; i < arr->elements.size(); ++i) {
-        if (std::holds_alternative<std::string>(arr->elements[i])) {
-            ss << std::get<std::string>(arr->elements[i]);
-        } else if (std::holds_alternative<double>(arr->elements[i])) {
-            ss << std::get<double>(arr->elements[i]);
+        if (arr->elements[i].isString()) {
+            ss << arr->elements[i].asString();
+        } else if (arr->elements[i].isNumber()) {
+            ss << arr->elements[i].asNumber();
         }
         if (i + 1 < arr->elements.size()) {
             ss << sep;
@@ -688,10 +689,10 @@ auto nativeToUpper(Interpreter& interp, const std::vector<Value>& arguments) ->
     if (arguments.size() != 1) {
         throw std::runtime_error("toUpper() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("Argument to toUpper() must be a string.");
     }
-    std::string str = std::get<std::string>(arguments[0]);
+    std::string str = arguments[0].asString();
     std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) { return std::toupper(c); });
     return str;
 }
@@ -700,10 +701,10 @@ auto nativeToLower(Interpreter& interp, const std::vector<Value>& arguments) ->
     if (arguments.size() != 1) {
         throw std::runtime_error("toLower() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("Argument to toLower() must be a string.");
     }
-    std::string str = std::get<std::string>(arguments[0]);
+    std::string str = arguments[0].asString();
     std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) { return std::tolower(c); });
     return str;
 }
@@ -712,10 +713,10 @@ auto nativeTrim(Interpreter& interp, const std::vector<Value>& arguments) -> Val
     if (arguments.size() != 1) {
         throw std::runtime_error("trim() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("Argument to trim() must be a string.");
     }
-    std::string str = std::get<std::string>(arguments[0]);
+    std::string str = arguments[0].asString();
 
     // Trim from start
     str.erase(str.begin(), std::find_if(str.begin(), str.end(), [](unsigned char ch) { return !std::isspace(ch); }));
@@ -731,13 +732,13 @@ auto nativeReplace(Interpreter& interp, const std::vector<Value>& arguments) ->
     if (arguments.size() != 3) {
         throw std::runtime_error("replace() takes exactly three arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1]) ||
-        !std::holds_alternative<std::string>(arguments[2])) {
+    if (!arguments[0].isString() || !arguments[1].isString() ||
+        !arguments[2].isString()) {
         throw std::runtime_error("All arguments to replace() must be strings.");
     }
-    std::string str = std::get<std::string>(arguments[0]);
-    std::string from = std::get<std::string>(arguments[1]);
-    std::string to = std::get<std::string>(arguments[2]);
+    std::string str = arguments[0].asString();
+    std::string from = arguments[1].asString();
+    std::string to = arguments[2].asString();
 
     if (from.empty()) return str;
 
@@ -753,11 +754,11 @@ auto nativeStartsWith(Interpreter& interp, const std::vector<Value>& arguments)
     if (arguments.size() != 2) {
         throw std::runtime_error("startsWith() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to startsWith() must be strings.");
     }
-    std::string str = std::get<std::string>(arguments[0]);
-    std::string prefix = std::get<std::string>(arguments[1]);
+    std::string str = arguments[0].asString();
+    std::string prefix = arguments[1].asString();
     return str.rfind(prefix, 0) == 0;
 }
 
@@ -765,11 +766,11 @@ auto nativeEndsWith(Interpreter& interp, const std::vector<Value>& arguments) ->
     if (arguments.size() != 2) {
         throw std::runtime_error("endsWith() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to endsWith() must be strings.");
     }
-    std::string str = std::get<std::string>(arguments[0]);
-    std::string suffix = std::get<std::string>(arguments[1]);
+    std::string str = arguments[0].asString();
+    std::string suffix = arguments[1].asString();
     if (suffix.length() > str.length()) return false;
     return str.compare(str.length() - suffix.length(), suffix.length(), suffix) == 0;
 }
@@ -778,11 +779,11 @@ auto nativeIndexOf(Interpreter& interp, const std::vector<Value>& arguments) ->
     if (arguments.size() != 2) {
         throw std::runtime_error("indexOf() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to indexOf() must be strings.");
     }
-    std::string str = std::get<std::string>(arguments[0]);
-    std::string substr = std::get<std::string>(arguments[1]);
+    std::string str = arguments[0].asString();
+    std::string substr = arguments[1].asString();
     size_t pos = str.find(substr);
     if (pos == std::string::npos) {
         return -1.0;
@@ -794,11 +795,11 @@ auto nativeContains(Interpreter& interp, const std::vector<Value>& arguments) ->
     if (arguments.size() != 2) {
         throw std::runtime_error("contains() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to contains() must be strings.");
     }
-    const std::string& str = std::get<std::string>(arguments[0]);
-    const std::string& substr = std::get<std::string>(arguments[1]);
+    const std::string& str = arguments[0].asString();
+    const std::string& substr = arguments[1].asString();
     return str.find(substr) != std::string::npos;
 }
 
@@ -808,16 +809,16 @@ auto nativeMap(Interpreter& interp, const std::vector<Value>& arguments) -> Valu
     if (arguments.size() != 2) {
         throw std::runtime_error("map() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arguments[0])) {
+    if (!arguments[0].isArray()) {
         throw std::runtime_error("First argument to map() must be an array.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Callable>>(arguments[1])) {
+    if (!arguments[1].isCallable()) {
         throw std::runtime_error("Second argument to map() must be a function.");
     }
 
-    auto arr = std::get<std::shared_ptr<Array>>(arguments[0]);
-    auto func = std::get<std::shared_ptr<Callable>>(arguments[1]);
-    auto result = std::make_shared<Array>();
+    auto arr = arguments[0].asArray();
+    auto func = arguments[1].asCallable();
+    auto result = makeRef<Array>();
 
     for (const auto& elem : arr->elements) {
         result->elements.push_back(func->call(interp, {elem}));
@@ -829,16 +830,16 @@ auto nativeFilter(Interpreter& interp, const std::vector<Value>& arguments) -> V
     if (arguments.size() != 2) {
         throw std::runtime_error("filter() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arguments[0])) {
+    if (!arguments[0].isArray()) {
         throw std::runtime_error("First argument to filter() must be an array.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Callable>>(arguments[1])) {
+    if (!arguments[1].isCallable()) {
         throw std::runtime_error("Second argument to filter() must be a function.");
     }
 
-    auto arr = std::get<std::shared_ptr<Array>>(arguments[0]);
-    auto func = std::get<std::shared_ptr<Callable>>(arguments[1]);
-    auto result = std::make_shared<Array>();
+    auto arr = arguments[0].asArray();
+    auto func = arguments[1].asCallable();
+    auto result = makeRef<Array>();
 
     for (const auto& elem : arr->elements) {
         Value testResult = func->call(interp, {elem});
@@ -853,15 +854,15 @@ auto nativeReduce(Interpreter& interp, const std::vector<Value>& arguments) -> V
     if (arguments.size() < 2 || arguments.size() > 3) {
         throw std::runtime_error("reduce() takes 2 or 3 arguments.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arguments[0])) {
+    if (!arguments[0].isArray()) {
         throw std::runtime_error("First argument to reduce() must be an array.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Callable>>(arguments[1])) {
+    if (!arguments[1].isCallable()) {
         throw std::runtime_error("Second argument to reduce() must be a function.");
     }
 
-    auto arr = std::get<std::shared_ptr<Array>>(arguments[0]);
-    auto func = std::get<std::shared_ptr<Callable>>(arguments[1]);
+    auto arr = arguments[0].asArray();
+    auto func = arguments[1].asCallable();
 
     if (arr->elements.empty()) {
         if (arguments.size() == 3) {
@@ -891,29 +892,29 @@ auto nativeSort(Interpreter& interp, const std::vector<Value>& arguments) -> Val
     if (arguments.size() < 1 || arguments.size() > 2) {
         throw std::runtime_error("sort() takes 1 or 2 arguments.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arguments[0])) {
+    if (!arguments[0].isArray()) {
         throw std::runtime_error("Argument to sort() must be an array.");
     }
 
-    auto arr = std::get<std::shared_ptr<Array>>(arguments[0]);
-    auto result = std::make_shared<Array>(*arr);
+    auto arr = arguments[0].asArray();
+    auto result = makeRef<Array>(*arr);
 
     if (arguments.size() == 2) {
-        if (!std::holds_alternative<std::shared_ptr<Callable>>(arguments[1])) {
+        if (!arguments[1].isCallable()) {
             throw std::runtime_error("Second argument to sort() must be a function.");
         }
-        auto comparator = std::get<std::shared_ptr<Callable>>(arguments[1]);
+        auto comparator = arguments[1].asCallable();
         std::sort(result->elements.begin(), result->elements.end(), [&](const Value& a, const Value& b) {
             Value cmpResult = comparator->call(interp, {a, b});
             return asNumber(cmpResult) < 0;
         });
     } else {
         std::sort(result->elements.begin(), result->elements.end(), [](const Value& a, const Value& b) {
-            if (std::holds_alternative<double>(a) && std::holds_alternative<double>(b)) {
-                return std::get<double>(a) < std::get<double>(b);
+            if (a.isNumber() && b.isNumber()) {
+                return a.asNumber() < b.asNumber();
             }
-            if (std::holds_alternative<std::string>(a) && std::holds_alternative<std::string>(b)) {
-                return std::get<std::string>(a) < std::get<std::string>(b);
+            if (a.isString() && b.isString()) {
+                return a.asString() < b.asString();
             }
             return false;
         });
@@ -925,12 +926,12 @@ auto nativeReverse(Interpreter& interp, const std::vector<Value>& arguments) ->
     if (arguments.size() != 1) {
         throw std::runtime_error("reverse() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arguments[0])) {
+    if (!arguments[0].isArray()) {
         throw std::runtime_error("Argument to reverse() must be an array.");
     }
 
-    auto arr = std::get<std::shared_ptr<Array>>(arguments[0]);
-    auto result = std::make_shared<Array>();
+    auto arr = arguments[0].asArray();
+    auto result = makeRef<Array>();
     result->elements.assign(arr->elements.rbegin(), arr->elements.rend());
     return result;
 }
@@ -939,14 +940,14 @@ auto nativeConcat(Interpreter& interp, const std::vector<Value>& arguments) -> V
     if (arguments.size() != 2) {
         throw std::runtime_error("concat() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arguments[0]) ||
-        !std::holds_alternative<std::shared_ptr<Array>>(arguments[1])) {
+    if (!arguments[0].isArray() ||
+        !arguments[1].isArray()) {
         throw std::runtime_error("Both arguments to concat() must be arrays.");
     }
 
-    auto arr1 = std::get<std::shared_ptr<Array>>(arguments[0]);
-    auto arr2 = std::get<std::shared_ptr<Array>>(arguments[1]);
-    auto result = std::make_shared<Array>();
+    auto arr1 = arguments[0].asArray();
+    auto arr2 = arguments[1].asArray();
+    auto result = makeRef<Array>();
 
     result->elements.insert(result->elements.end(), arr1->elements.begin(), arr1->elements.end());
     result->elements.insert(result->elements.end(), arr2->elements.begin(), arr2->elements.end());
@@ -957,15 +958,15 @@ auto nativeSlice(Interpreter& interp, const std::vector<Value>& arguments) -> Va
     if (arguments.size() < 2 || arguments.size() > 3) {
         throw std::runtime_error("slice() takes 2 or 3 arguments.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Array>>(arguments[0])) {
+    if (!arguments[0].isArray()) {
         throw std::runtime_error("First argument to slice() must be an array.");
     }
 
-    auto arr = std::get<std::shared_ptr<Array>>(arguments[0]);
+    auto arr = arguments[0].asArray();
     size_t start = static_cast<size_t>(asNumber(arguments[1]));
     size_t end = (arguments.size() == 3) ? static_cast<size_t>(asNumber(arguments[2])) : arr->elements.size();
 
-    auto result = std::make_shared<Array>();
+    auto result = makeRef<Array>();
     if (start >= arr->elements.size()) {
         return result;
     }
@@ -981,11 +982,11 @@ auto nativeReadFile(Interpreter& interp, const std::vector<Value>& arguments) ->
     if (arguments.size() != 1) {
         throw std::runtime_error("readFile() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("Argument to readFile() must be a string.");
     }
 
-    std::string filename = std::get<std::string>(arguments[0]);
+    std::string filename = arguments[0].asString();
     std::ifstream file(filename);
     if (!file.is_open()) {
         throw std::runtime_error("Failed to open file: " + filename);
@@ -1000,12 +1001,12 @@ auto nativeWriteFile(Interpreter& interp, const std::vector<Value>& arguments) -
     if (arguments.size() != 2) {
         throw std::runtime_error("writeFile() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to writeFile() must be strings.");
     }
 
-    std::string filename = std::get<std::string>(arguments[0]);
-    std::string content = std::get<std::string>(arguments[1]);
+    std::string filename = arguments[0].asString();
+    std::string content = arguments[1].asString();
 
     std::ofstream file(filename);
     if (!file.is_open()) {
@@ -1020,12 +1021,12 @@ auto nativeAppendFile(Interpreter& interp, const std::vector<Value>& arguments)
     if (arguments.size() != 2) {
         throw std::runtime_error("appendFile() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to appendFile() must be strings.");
     }
 
-    std::string filename = std::get<std::string>(arguments[0]);
-    std::string content = std::get<std::string>(arguments[1]);
+    std::string filename = arguments[0].asString();
+    std::string content = arguments[1].asString();
 
     std::ofstream file(filename, std::ios::app);
     if (!file.is_open()) {
@@ -1040,11 +1041,11 @@ auto nativeFileExists(Interpreter& interp, const std::vector<Value>& arguments)
     if (arguments.size() != 1) {
         throw std::runtime_error("fileExists() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("Argument to fileExists() must be a string.");
     }
 
-    std::string filename = std::get<std::string>(arguments[0]);
+    std::string filename = arguments[0].asString();
     struct stat buffer;
     return (stat(filename.c_str(), &buffer) == 0);
 }
@@ -1094,10 +1095,10 @@ auto nativeAssertOk(Interpreter& interp, const std::vector<Value>& arguments) ->
     if (!condition) {
         std::string message = "Assertion failed";
         if (arguments.size() == 2) {
-            if (!std::holds_alternative<std::string>(arguments[1])) {
+            if (!arguments[1].isString()) {
                 throw std::runtime_error("Second argument to assert.ok() must be a string.");
             }
-            message = std::get<std::string>(arguments[1]);
+            message = arguments[1].asString();
         }
         throw std::runtime_error(message);
     }
@@ -1144,11 +1145,11 @@ auto nativeEnvGet(Interpreter& interp, const std::vector<Value>& arguments) -> V
         throw std::runtime_error("env.get() takes exactly one argument.");
     }
 
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("env.get() argument must be a string.");
     }
 
-    const std::string& name = std::get<std::string>(arguments[0]);
+    const std::string& name = arguments[0].asString();
     const char* value = std::getenv(name.c_str());
 
     if (value == nullptr) {
@@ -1163,16 +1164,16 @@ auto nativeEnvSet(Interpreter& interp, const std::vector<Value>& arguments) -> V
         throw std::runtime_error("env.set() takes exactly two arguments.");
     }
 
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("env.set() first argument must be a string.");
     }
 
-    if (!std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[1].isString()) {
         throw std::runtime_error("env.set() second argument must be a string.");
     }
 
-    const std::string& name = std::get<std::string>(arguments[0]);
-    const std::string& value = std::get<std::string>(arguments[1]);
+    const std::string& name = arguments[0].asString();
+    const std::string& value = arguments[1].asString();
 
     // Use setenv for POSIX systems (Linux, macOS)
     int result;
@@ -1194,11 +1195,11 @@ auto nativeEnvExists(Interpreter& interp, const std::vector<Value>& arguments) -
         throw std::runtime_error("env.exists() takes exactly one argument.");
     }
 
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("env.exists() argument must be a string.");
     }
 
-    const std::string& name = std::get<std::string>(arguments[0]);
+    const std::string& name = arguments[0].asString();
     const char* value = std::getenv(name.c_str());
 
     return value != nullptr;
@@ -1210,11 +1211,11 @@ auto nativeProcessExit(Interpreter& interp, const std::vector<Value>& arguments)
         throw std::runtime_error("process.exit() takes exactly one argument.");
     }
 
-    if (!std::holds_alternative<double>(arguments[0])) {
+    if (!arguments[0].isNumber()) {
         throw std::runtime_error("process.exit() argument must be a number.");
     }
 
-    int exitCode = static_cast<int>(std::get<double>(arguments[0]));
+    int exitCode = static_cast<int>(arguments[0].asNumber());
     std::exit(exitCode);
 
     // This line will never be reached, but is here to satisfy the compiler
@@ -1237,7 +1238,7 @@ auto nativeProcessArgs(Interpreter& interp, const std::vector<Value>& arguments)
     }
 
     const auto& cmdArgs = interp.getCommandLineArgs();
-    auto argsArray = std::make_shared<Array>();
+    auto argsArray = makeRef<Array>();
 
     for (const auto& arg : cmdArgs) {
         argsArray->elements.push_back(arg);
@@ -1255,11 +1256,11 @@ auto nativePathJoin(Interpreter& interp, const std::vector<Value>& arguments) ->
     std::string result;
 
     for (size_t i = 0; i < arguments.size(); ++i) {
-        if (!std::holds_alternative<std::string>(arguments[i])) {
+        if (!arguments[i].isString()) {
             throw std::runtime_error("path.join() requires all arguments to be strings.");
         }
 
-        std::string part = std::get<std::string>(arguments[i]);
+        std::string part = arguments[i].asString();
 
         // Skip empty parts
         if (part.empty()) {
@@ -1287,11 +1288,11 @@ auto nativePathBasename(Interpreter& interp, const std::vector<Value>& arguments
         throw std::runtime_error("path.basename() takes exactly one argument.");
     }
 
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("path.basename() requires a string argument.");
     }
 
-    std::string path = std::get<std::string>(arguments[0]);
+    std::string path = arguments[0].asString();
 
     // Remove trailing slashes
     while (!path.empty() && path.back() == '/') {
@@ -1317,11 +1318,11 @@ auto nativePathDirname(Interpreter& interp, const std::vector<Value>& arguments)
         throw std::runtime_error("path.dirname() takes exactly one argument.");
     }
 
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("path.dirname() requires a string argument.");
     }
 
-    std::string path = std::get<std::string>(arguments[0]);
+    std::string path = arguments[0].asString();
 
     // Remove trailing slashes
     while (!path.empty() && path.back() == '/') {
@@ -1352,11 +1353,11 @@ auto nativePathExtname(Interpreter& interp, const std::vector<Value>& arguments)
         throw std::runtime_error("path.extname() takes exactly one argument.");
     }
 
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("path.extname() requires a string argument.");
     }
 
-    std::string path = std::get<std::string>(arguments[0]);
+    std::string path = arguments[0].asString();
 
     // Get the basename first
     size_t slashPos = path.find_last_of('/');
@@ -1378,11 +1379,11 @@ auto nativePathNormalize(Interpreter& interp, const std::vector<Value>& argument
         throw std::runtime_error("path.normalize() takes exactly one argument.");
     }
 
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("path.normalize() requires a string argument.");
     }
 
-    std::string path = std::get<std::string>(arguments[0]);
+    std::string path = arguments[0].asString();
 
     // Handle empty path
     if (path.empty()) {
@@ -1455,11 +1456,11 @@ auto nativeFsExists(Interpreter& interp, const std::vector<Value>& arguments) ->
     if (arguments.size() != 1) {
         throw std::runtime_error("fs.exists() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("Argument to fs.exists() must be a string.");
     }
 
-    std::string path = std::get<std::string>(arguments[0]);
+    std::string path = arguments[0].asString();
     struct stat buffer;
     return (stat(path.c_str(), &buffer) == 0);
 }
@@ -1468,11 +1469,11 @@ auto nativeFsRead(Interpreter& interp, const std::vector<Value>& arguments) -> V
     if (arguments.size() != 1) {
         throw std::runtime_error("fs.read() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("Argument to fs.read() must be a string.");
     }
 
-    std::string path = std::get<std::string>(arguments[0]);
+    std::string path = arguments[0].asString();
     std::ifstream file(path);
     if (!file.is_open()) {
         throw std::runtime_error("Failed to open file for reading: " + path);
@@ -1487,12 +1488,12 @@ auto nativeFsWrite(Interpreter& interp, const std::vector<Value>& arguments) ->
     if (arguments.size() != 2) {
         throw std::runtime_error("fs.write() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to fs.write() must be strings.");
     }
 
-    std::string path = std::get<std::string>(arguments[0]);
-    std::string content = std::get<std::string>(arguments[1]);
+    std::string path = arguments[0].asString();
+    std::string content = arguments[1].asString();
 
     std::ofstream file(path);
     if (!file.is_open()) {
@@ -1511,12 +1512,12 @@ auto nativeFsAppend(Interpreter& interp, const std::vector<Value>& arguments) ->
     if (arguments.size() != 2) {
         throw std::runtime_error("fs.append() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to fs.append() must be strings.");
     }
 
-    std::string path = std::get<std::string>(arguments[0]);
-    std::string content = std::get<std::string>(arguments[1]);
+    std::string path = arguments[0].asString();
+    std::string content = arguments[1].asString();
 
     std::ofstream file(path, std::ios::app);
     if (!file.is_open()) {
@@ -1535,11 +1536,11 @@ auto nativeFsRemove(Interpreter& interp, const std::vector<Value>& arguments) ->
     if (arguments.size() != 1) {
         throw std::runtime_error("fs.remove() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("Argument to fs.remove() must be a string.");
     }
 
-    std::string path = std::get<std::string>(arguments[0]);
+    std::string path = arguments[0].asString();
 
     if (std::remove(path.c_str()) != 0) {
         throw std::runtime_error("Failed to remove file: " + path);
@@ -1564,11 +1565,11 @@ auto nativeTimeSleep(Interpreter& interp, const std::vector<Value>& arguments) -
     if (arguments.size() != 1) {
         throw std::runtime_error("time.sleep() takes exactly one argument.");
     }
-    if (!std::holds_alternative<double>(arguments[0])) {
+    if (!arguments[0].isNumber()) {
         throw std::runtime_error("Argument to time.sleep() must be a number (seconds).");
     }
 
-    double seconds = std::get<double>(arguments[0]);
+    double seconds = arguments[0].asNumber();
     if (seconds < 0) {
         throw std::runtime_error("time.sleep() argument must be non-negative.");
     }
@@ -1583,18 +1584,18 @@ auto nativeTimeFormat(Interpreter& interp, const std::vector<Value>& arguments)
     if (arguments.size() < 1 || arguments.size() > 2) {
         throw std::runtime_error("time.format() takes 1 or 2 arguments.");
     }
-    if (!std::holds_alternative<double>(arguments[0])) {
+    if (!arguments[0].isNumber()) {
         throw std::runtime_error("First argument to time.format() must be a number (timestamp).");
     }
 
-    double timestamp = std::get<double>(arguments[0]);
+    double timestamp = arguments[0].asNumber();
     std::string format = "%Y-%m-%d %H:%M:%S";
 
     if (arguments.size() == 2) {
-        if (!std::holds_alternative<std::string>(arguments[1])) {
+        if (!arguments[1].isString()) {
             throw std::runtime_error("Second argument to time.format() must be a string (format).");
         }
-        format = std::get<std::string>(arguments[1]);
+        format = arguments[1].asString();
     }
 
     std::time_t time = static_cast<std::time_t>(timestamp);
@@ -1716,7 +1717,7 @@ static Value parseJsonArray(const std::string& str, size_t& pos) {
     }
     ++pos;
 
-    auto arr = std::make_shared<Array>();
+    auto arr = makeRef<Array>();
     skipWhitespace(str, pos);
 
     if (pos < str.size() && str[pos] == ']') {
@@ -1753,7 +1754,7 @@ static Value parseJsonObject(const std::string& str, size_t& pos) {
     }
     ++pos;
 
-    auto map = std::make_shared<Map>();
+    auto map = makeRef<Map>();
     skipWhitespace(str, pos);
 
     if (pos < str.size() && str[pos] == '}') {
@@ -1769,7 +1770,7 @@ static Value parseJsonObject(const std::string& str, size_t& pos) {
         }
 
         Value keyVal = parseJsonString(str, pos);
-        std::string key = std::get<std::string>(keyVal);
+        std::string key = keyVal.asString();
 
         skipWhitespace(str, pos);
         if (pos >= str.size() || str[pos] != ':') {
@@ -1821,12 +1822,12 @@ static Value jsonValueFromString(const std::string& jsonStr, size_t& pos) {
 }
 
 static std::string valueToJson(const Value& value) {
-    if (std::holds_alternative<Nil>(value)) {
+    if (value.isNil()) {
         return "null";
-    } else if (std::holds_alternative<bool>(value)) {
-        return std::get<bool>(value) ? "true" : "false";
-    } else if (std::holds_alternative<double>(value)) {
-        double d = std::get<double>(value);
+    } else if (value.isBool()) {
+        return value.asBool() ? "true" : "false";
+    } else if (value.isNumber()) {
+        double d = value.asNumber();
         if (std::isnan(d) || std::isinf(d)) {
             return "null";
         }
@@ -1842,8 +1843,8 @@ static std::string valueToJson(const Value& value) {
             }
         }
         return str;
-    } else if (std::holds_alternative<std::string>(value)) {
-        std::string str = std::get<std::string>(value);
+    } else if (value.isString()) {
+        std::string str = value.asString();
         std::ostringstream oss;
         oss << '"';
         for (char c : str) {
@@ -1876,8 +1877,8 @@ static std::string valueToJson(const Value& value) {
         }
         oss << '"';
         return oss.str();
-    } else if (std::holds_alternative<std::shared_ptr<Array>>(value)) {
-        auto arr = std::get<std::shared_ptr<Array>>(value);
+    } else if (value.isArray()) {
+        auto arr = value.asArray();
         std::ostringstream oss;
         oss << '[';
         for (size_t i = 0; i < arr->elements.size(); ++i) {
@@ -1886,8 +1887,8 @@ static std::string valueToJson(const Value& value) {
         }
         oss << ']';
         return oss.str();
-    } else if (std::holds_alternative<std::shared_ptr<Map>>(value)) {
-        auto map = std::get<std::shared_ptr<Map>>(value);
+    } else if (value.isMap()) {
+        auto map = value.asMap();
         std::ostringstream oss;
         oss << '{';
         bool first = true;
@@ -1907,11 +1908,11 @@ auto nativeJsonParse(Interpreter& interp, const std::vector<Value>& arguments) -
     if (arguments.size() != 1) {
         throw std::runtime_error("json.parse() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0])) {
+    if (!arguments[0].isString()) {
         throw std::runtime_error("Argument to json.parse() must be a string.");
     }
 
-    std::string jsonStr = std::get<std::string>(arguments[0]);
+    std::string jsonStr = arguments[0].asString();
     size_t pos = 0;
 
     try {
@@ -1943,16 +1944,16 @@ auto nativeRegexMatch(Interpreter& interp, const std::vector<Value>& arguments)
     if (arguments.size() != 2) {
         throw std::runtime_error("regex.match() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to regex.match() must be strings.");
     }
 
-    std::string text = std::get<std::string>(arguments[0]);
-    std::string pattern = std::get<std::string>(arguments[1]);
+    std::string text = arguments[0].asString();
+    std::string pattern = arguments[1].asString();
 
     try {
         std::regex re(pattern);
-        auto result = std::make_shared<Array>();
+        auto result = makeRef<Array>();
         auto searchStart = text.cbegin();
         std::smatch match;
         while (std::regex_search(searchStart, text.cend(), match, re)) {
@@ -1975,14 +1976,14 @@ auto nativeRegexReplace(Interpreter& interp, const std::vector<Value>& arguments
     if (arguments.size() != 3) {
         throw std::runtime_error("regex.replace() takes exactly three arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1]) ||
-        !std::holds_alternative<std::string>(arguments[2])) {
+    if (!arguments[0].isString() || !arguments[1].isString() ||
+        !arguments[2].isString()) {
         throw std::runtime_error("All arguments to regex.replace() must be strings.");
     }
 
-    std::string text = std::get<std::string>(arguments[0]);
-    std::string pattern = std::get<std::string>(arguments[1]);
-    std::string replacement = std::get<std::string>(arguments[2]);
+    std::string text = arguments[0].asString();
+    std::string pattern = arguments[1].asString();
+    std::string replacement = arguments[2].asString();
 
     try {
         std::regex re(pattern);
@@ -1996,12 +1997,12 @@ auto nativeRegexTest(Interpreter& interp, const std::vector<Value>& arguments) -
     if (arguments.size() != 2) {
         throw std::runtime_error("regex.test() takes exactly two arguments.");
     }
-    if (!std::holds_alternative<std::string>(arguments[0]) || !std::holds_alternative<std::string>(arguments[1])) {
+    if (!arguments[0].isString() || !arguments[1].isString()) {
         throw std::runtime_error("Both arguments to regex.test() must be strings.");
     }
 
-    std::string text = std::get<std::string>(arguments[0]);
-    std::string pattern = std::get<std::string>(arguments[1]);
+    std::string text = arguments[0].asString();
+    std::string pattern = arguments[1].asString();
 
     try {
         std::regex re(pattern);
@@ -2126,7 +2127,7 @@ static std::string httpSendRequest(const std::string& method, const std::string&
 }
 
 static Value httpParseResponse(const std::string& response) {
-    auto result = std::make_shared<Map>();
+    auto result = makeRef<Map>();
 
     size_t headerEnd = response.find("\r\n\r\n");
     std::string headerSection;
@@ -2157,7 +2158,7 @@ static Value httpParseResponse(const std::string& response) {
         }
     }
 
-    auto headersMap = std::make_shared<Map>();
+    auto headersMap = makeRef<Map>();
     size_t pos = (firstLineEnd != std::string::npos) ? firstLineEnd + 2 : headerSection.size();
     while (pos < headerSection.size()) {
         size_t lineEnd = headerSection.find("\r\n", pos);
@@ -2184,33 +2185,33 @@ static Value httpParseResponse(const std::string& response) {
 
 // std.http functions
 auto nativeHttpGet(Interpreter& interp, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() < 1 || !std::holds_alternative<std::string>(arguments[0])) {
+    if (arguments.size() < 1 || !arguments[0].isString()) {
         throw std::runtime_error("http.get() requires a URL string argument.");
     }
-    const std::string& url = std::get<std::string>(arguments[0]);
+    const std::string& url = arguments[0].asString();
     std::string response = httpSendRequest("GET", url, "", "");
     return httpParseResponse(response);
 }
 
 auto nativeHttpPost(Interpreter& interp, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() < 2 || !std::holds_alternative<std::string>(arguments[0])) {
+    if (arguments.size() < 2 || !arguments[0].isString()) {
         throw std::runtime_error("http.post() requires a URL string and body argument.");
     }
-    const std::string& url = std::get<std::string>(arguments[0]);
+    const std::string& url = arguments[0].asString();
     std::string body = valueToString(arguments[1]);
     std::string contentType = "application/x-www-form-urlencoded";
-    if (arguments.size() >= 3 && std::holds_alternative<std::string>(arguments[2])) {
-        contentType = std::get<std::string>(arguments[2]);
+    if (arguments.size() >= 3 && arguments[2].isString()) {
+        contentType = arguments[2].asString();
     }
     std::string response = httpSendRequest("POST", url, body, contentType);
     return httpParseResponse(response);
 }
 
 auto nativeHttpRequest(Interpreter& interp, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() < 1 || !std::holds_alternative<std::shared_ptr<Map>>(arguments[0])) {
+    if (arguments.size() < 1 || !arguments[0].isMap()) {
         throw std::runtime_error("http.request() requires an options map argument.");
     }
-    auto options = std::get<std::shared_ptr<Map>>(arguments[0]);
+    auto options = arguments[0].asMap();
 
     std::string method = "GET";
     std::string url;
@@ -2224,10 +2225,10 @@ auto nativeHttpRequest(Interpreter& interp, const std::vector<Value>& arguments)
     }
 
     it = options->entries.find("url");
-    if (it == options->entries.end() || !std::holds_alternative<std::string>(it->second)) {
+    if (it == options->entries.end() || !it->second.isString()) {
         throw std::runtime_error("http.request() options map must contain a 'url' string.");
     }
-    url = std::get<std::string>(it->second);
+    url = it->second.asString();
 
     it = options->entries.find("body");
     if (it != options->entries.end()) {
@@ -2248,11 +2249,11 @@ auto nativeSpawn(Interpreter& /*interp*/, const std::vector<Value>& arguments) -
     if (arguments.size() != 1) {
         throw std::runtime_error("spawn() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Callable>>(arguments[0])) {
+    if (!arguments[0].isCallable()) {
         throw std::runtime_error("spawn() argument must be a callable.");
     }
-    auto task = std::make_shared<Task>();
-    task->callable = std::get<std::shared_ptr<Callable>>(arguments[0]);
+    auto task = makeRef<Task>();
+    task->callable = arguments[0].asCallable();
     task->state = Task::State::Pending;
     return task;
 }
@@ -2262,10 +2263,10 @@ auto nativeAwait(Interpreter& interp, const std::vector<Value>& arguments) -> Va
     if (arguments.size() != 1) {
         throw std::runtime_error("await() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Task>>(arguments[0])) {
+    if (!arguments[0].isTask()) {
         throw std::runtime_error("await() argument must be a task.");
     }
-    auto task = std::get<std::shared_ptr<Task>>(arguments[0]);
+    auto task = arguments[0].asTask();
     if (task->state == Task::State::Running) {
         throw std::runtime_error("await() called re-entrantly on an already running task.");
     }
@@ -2328,13 +2329,13 @@ static void ipcFreeHandle(int id) {
 
 // ipc.createPipe(name) - creates a named pipe (FIFO) for IPC
 auto nativeIpcCreatePipe(Interpreter& /*interp*/, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() != 1 || !std::holds_alternative<std::string>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isString()) {
         throw std::runtime_error("ipc.createPipe() takes exactly one string argument (pipe name).");
     }
 #ifdef _WIN32
     throw std::runtime_error("ipc.createPipe() is not supported on Windows.");
 #else
-    const std::string& name = std::get<std::string>(arguments[0]);
+    const std::string& name = arguments[0].asString();
     std::string path = ipcPipePath(name);
     if (mkfifo(path.c_str(), 0600) != 0 && errno != EEXIST) {
         throw std::runtime_error("ipc.createPipe() failed to create pipe '" + name + "': " + strerror(errno));
@@ -2345,13 +2346,13 @@ auto nativeIpcCreatePipe(Interpreter& /*interp*/, const std::vector<Value>& argu
 
 // ipc.openRead(name) - opens a named pipe for reading; returns a handle number
 auto nativeIpcOpenRead(Interpreter& /*interp*/, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() != 1 || !std::holds_alternative<std::string>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isString()) {
         throw std::runtime_error("ipc.openRead() takes exactly one string argument (pipe name).");
     }
 #ifdef _WIN32
     throw std::runtime_error("ipc.openRead() is not supported on Windows.");
 #else
-    const std::string& name = std::get<std::string>(arguments[0]);
+    const std::string& name = arguments[0].asString();
     std::string path = ipcPipePath(name);
     int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK);
     if (fd < 0) {
@@ -2367,13 +2368,13 @@ auto nativeIpcOpenRead(Interpreter& /*interp*/, const std::vector<Value>& argume
 
 // ipc.openWrite(name) - opens a named pipe for writing; returns a handle number
 auto nativeIpcOpenWrite(Interpreter& /*interp*/, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() != 1 || !std::holds_alternative<std::string>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isString()) {
         throw std::runtime_error("ipc.openWrite() takes exactly one string argument (pipe name).");
     }
 #ifdef _WIN32
     throw std::runtime_error("ipc.openWrite() is not supported on Windows.");
 #else
-    const std::string& name = std::get<std::string>(arguments[0]);
+    const std::string& name = arguments[0].asString();
     std::string path = ipcPipePath(name);
     int fd = open(path.c_str(), O_WRONLY | O_NONBLOCK);
     if (fd < 0) {
@@ -2391,15 +2392,15 @@ auto nativeIpcOpenWrite(Interpreter& /*interp*/, const std::vector<Value>& argum
 
 // ipc.send(handle, message) - sends a length-prefixed message through a pipe handle
 auto nativeIpcSend(Interpreter& /*interp*/, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() != 2 || !std::holds_alternative<double>(arguments[0]) ||
-        !std::holds_alternative<std::string>(arguments[1])) {
+    if (arguments.size() != 2 || !arguments[0].isNumber() ||
+        !arguments[1].isString()) {
         throw std::runtime_error("ipc.send() takes a handle (number) and a message (string).");
     }
 #ifdef _WIN32
     throw std::runtime_error("ipc.send() is not supported on Windows.");
 #else
-    int handle = static_cast<int>(std::get<double>(arguments[0]));
-    const std::string& message = std::get<std::string>(arguments[1]);
+    int handle = static_cast<int>(arguments[0].asNumber());
+    const std::string& message = arguments[1].asString();
     IpcHandle h = ipcGetHandle(handle);
     if (h.is_read) {
         throw std::runtime_error("ipc.send() called on a read-only handle.");
@@ -2424,13 +2425,13 @@ auto nativeIpcSend(Interpreter& /*interp*/, const std::vector<Value>& arguments)
 
 // ipc.recv(handle) - blocking receive of a length-prefixed message
 auto nativeIpcRecv(Interpreter& /*interp*/, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() != 1 || !std::holds_alternative<double>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isNumber()) {
         throw std::runtime_error("ipc.recv() takes exactly one handle (number) argument.");
     }
 #ifdef _WIN32
     throw std::runtime_error("ipc.recv() is not supported on Windows.");
 #else
-    int handle = static_cast<int>(std::get<double>(arguments[0]));
+    int handle = static_cast<int>(arguments[0].asNumber());
     IpcHandle h = ipcGetHandle(handle);
     if (!h.is_read) {
         throw std::runtime_error("ipc.recv() called on a write-only handle.");
@@ -2462,13 +2463,13 @@ auto nativeIpcRecv(Interpreter& /*interp*/, const std::vector<Value>& arguments)
 
 // ipc.tryRecv(handle) - non-blocking receive; returns nil if no message is ready
 auto nativeIpcTryRecv(Interpreter& /*interp*/, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() != 1 || !std::holds_alternative<double>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isNumber()) {
         throw std::runtime_error("ipc.tryRecv() takes exactly one handle (number) argument.");
     }
 #ifdef _WIN32
     throw std::runtime_error("ipc.tryRecv() is not supported on Windows.");
 #else
-    int handle = static_cast<int>(std::get<double>(arguments[0]));
+    int handle = static_cast<int>(arguments[0].asNumber());
     IpcHandle h = ipcGetHandle(handle);
     if (!h.is_read) {
         throw std::runtime_error("ipc.tryRecv() called on a write-only handle.");
@@ -2509,13 +2510,13 @@ auto nativeIpcTryRecv(Interpreter& /*interp*/, const std::vector<Value>& argumen
 
 // ipc.close(handle) - closes an IPC pipe handle
 auto nativeIpcClose(Interpreter& /*interp*/, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() != 1 || !std::holds_alternative<double>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isNumber()) {
         throw std::runtime_error("ipc.close() takes exactly one handle (number) argument.");
     }
 #ifdef _WIN32
     throw std::runtime_error("ipc.close() is not supported on Windows.");
 #else
-    int handle = static_cast<int>(std::get<double>(arguments[0]));
+    int handle = static_cast<int>(arguments[0].asNumber());
     IpcHandle h = ipcGetHandle(handle);
     close(h.fd);
     ipcFreeHandle(handle);
@@ -2525,13 +2526,13 @@ auto nativeIpcClose(Interpreter& /*interp*/, const std::vector<Value>& arguments
 
 // ipc.removePipe(name) - removes a named pipe from the filesystem
 auto nativeIpcRemovePipe(Interpreter& /*interp*/, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() != 1 || !std::holds_alternative<std::string>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isString()) {
         throw std::runtime_error("ipc.removePipe() takes exactly one string argument (pipe name).");
     }
 #ifdef _WIN32
     throw std::runtime_error("ipc.removePipe() is not supported on Windows.");
 #else
-    const std::string& name = std::get<std::string>(arguments[0]);
+    const std::string& name = arguments[0].asString();
     std::string path = ipcPipePath(name);
     if (unlink(path.c_str()) != 0 && errno != ENOENT) {
         throw std::runtime_error("ipc.removePipe() failed to remove pipe '" + name + "': " + strerror(errno));
@@ -2578,12 +2579,12 @@ static void netFreeHandle(int id) {
 
 // net.connect(host, port) - connects to a TCP server; returns a socket handle
 auto nativeNetConnect(Interpreter& /*interp*/, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() != 2 || !std::holds_alternative<std::string>(arguments[0]) ||
-        !std::holds_alternative<double>(arguments[1])) {
+    if (arguments.size() != 2 || !arguments[0].isString() ||
+        !arguments[1].isNumber()) {
         throw std::runtime_error("net.connect() takes a host (string) and port (number).");
     }
-    const std::string& host = std::get<std::string>(arguments[0]);
-    int port = static_cast<int>(std::get<double>(arguments[1]));
+    const std::string& host = arguments[0].asString();
+    int port = static_cast<int>(arguments[1].asNumber());
     if (port <= 0 || port > 65535) {
         throw std::runtime_error("net.connect(): port must be between 1 and 65535.");
     }
@@ -2617,10 +2618,10 @@ auto nativeNetConnect(Interpreter& /*interp*/, const std::vector<Value>& argumen
 
 // net.listen(port) - creates a TCP server socket bound to the given port; returns a server handle
 auto nativeNetListen(Interpreter& /*interp*/, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() != 1 || !std::holds_alternative<double>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isNumber()) {
         throw std::runtime_error("net.listen() takes exactly one numeric argument (port).");
     }
-    int port = static_cast<int>(std::get<double>(arguments[0]));
+    int port = static_cast<int>(arguments[0].asNumber());
     if (port <= 0 || port > 65535) {
         throw std::runtime_error("net.listen(): port must be between 1 and 65535.");
     }
@@ -2672,10 +2673,10 @@ auto nativeNetListen(Interpreter& /*interp*/, const std::vector<Value>& argument
 
 // net.accept(serverHandle [, timeoutMs]) - accepts a TCP connection; returns client handle or nil on timeout
 auto nativeNetAccept(Interpreter& /*interp*/, const std::vector<Value>& arguments) -> Value {
-    if (arguments.empty() || !std::holds_alternative<double>(arguments[0])) {
+    if (arguments.empty() || !arguments[0].isNumber()) {
         throw std::runtime_error("net.accept() takes a server handle (number) and an optional timeout (number).");
     }
-    int handle = static_cast<int>(std::get<double>(arguments[0]));
+    int handle = static_cast<int>(arguments[0].asNumber());
     NetSocket srv = netGetHandle(handle);
     if (!srv.is_server) {
         throw std::runtime_error("net.accept(): handle is not a server socket.");
@@ -2684,10 +2685,10 @@ auto nativeNetAccept(Interpreter& /*interp*/, const std::vector<Value>& argument
     // Optional timeout in milliseconds
     int timeoutMs = -1;
     if (arguments.size() >= 2) {
-        if (!std::holds_alternative<double>(arguments[1])) {
+        if (!arguments[1].isNumber()) {
             throw std::runtime_error("net.accept(): timeout must be a number.");
         }
-        timeoutMs = static_cast<int>(std::get<double>(arguments[1]));
+        timeoutMs = static_cast<int>(arguments[1].asNumber());
     }
 
     if (timeoutMs >= 0) {
@@ -2714,12 +2715,12 @@ auto nativeNetAccept(Interpreter& /*interp*/, const std::vector<Value>& argument
 
 // net.send(handle, data) - sends a string over a TCP socket
 auto nativeNetSend(Interpreter& /*interp*/, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() != 2 || !std::holds_alternative<double>(arguments[0]) ||
-        !std::holds_alternative<std::string>(arguments[1])) {
+    if (arguments.size() != 2 || !arguments[0].isNumber() ||
+        !arguments[1].isString()) {
         throw std::runtime_error("net.send() takes a socket handle (number) and data (string).");
     }
-    int handle = static_cast<int>(std::get<double>(arguments[0]));
-    const std::string& data = std::get<std::string>(arguments[1]);
+    int handle = static_cast<int>(arguments[0].asNumber());
+    const std::string& data = arguments[1].asString();
     NetSocket sock = netGetHandle(handle);
     if (sock.is_server) {
         throw std::runtime_error("net.send(): cannot send on a server (listening) socket.");
@@ -2745,16 +2746,16 @@ auto nativeNetSend(Interpreter& /*interp*/, const std::vector<Value>& arguments)
 
 // net.recv(handle [, bufsize]) - receives data from a TCP socket; returns empty string on connection close
 auto nativeNetRecv(Interpreter& /*interp*/, const std::vector<Value>& arguments) -> Value {
-    if (arguments.empty() || !std::holds_alternative<double>(arguments[0])) {
+    if (arguments.empty() || !arguments[0].isNumber()) {
         throw std::runtime_error("net.recv() takes a socket handle (number) and an optional buffer size (number).");
     }
-    int handle = static_cast<int>(std::get<double>(arguments[0]));
+    int handle = static_cast<int>(arguments[0].asNumber());
     int bufsize = 4096;
     if (arguments.size() >= 2) {
-        if (!std::holds_alternative<double>(arguments[1])) {
+        if (!arguments[1].isNumber()) {
             throw std::runtime_error("net.recv(): buffer size must be a number.");
         }
-        bufsize = static_cast<int>(std::get<double>(arguments[1]));
+        bufsize = static_cast<int>(arguments[1].asNumber());
         if (bufsize <= 0) throw std::runtime_error("net.recv(): buffer size must be positive.");
     }
     NetSocket sock = netGetHandle(handle);
@@ -2776,10 +2777,10 @@ auto nativeNetRecv(Interpreter& /*interp*/, const std::vector<Value>& arguments)
 
 // net.close(handle) - closes a TCP socket handle
 auto nativeNetClose(Interpreter& /*interp*/, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() != 1 || !std::holds_alternative<double>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isNumber()) {
         throw std::runtime_error("net.close() takes exactly one socket handle (number).");
     }
-    int handle = static_cast<int>(std::get<double>(arguments[0]));
+    int handle = static_cast<int>(arguments[0].asNumber());
     NetSocket sock = netGetHandle(handle);
     ::close(sock.fd);
     netFreeHandle(handle);
@@ -2788,12 +2789,12 @@ auto nativeNetClose(Interpreter& /*interp*/, const std::vector<Value>& arguments
 
 // net.setTimeout(handle, milliseconds) - sets send/recv timeout on a socket
 auto nativeNetSetTimeout(Interpreter& /*interp*/, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() != 2 || !std::holds_alternative<double>(arguments[0]) ||
-        !std::holds_alternative<double>(arguments[1])) {
+    if (arguments.size() != 2 || !arguments[0].isNumber() ||
+        !arguments[1].isNumber()) {
         throw std::runtime_error("net.setTimeout() takes a socket handle (number) and timeout in ms (number).");
     }
-    int handle = static_cast<int>(std::get<double>(arguments[0]));
-    int ms = static_cast<int>(std::get<double>(arguments[1]));
+    int handle = static_cast<int>(arguments[0].asNumber());
+    int ms = static_cast<int>(arguments[1].asNumber());
     if (ms < 0) throw std::runtime_error("net.setTimeout(): timeout must be non-negative.");
     NetSocket sock = netGetHandle(handle);
 
@@ -2807,10 +2808,10 @@ auto nativeNetSetTimeout(Interpreter& /*interp*/, const std::vector<Value>& argu
 
 // sleep(ms): pause execution for the given number of milliseconds
 auto nativeSleep(Interpreter& /*interp*/, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() != 1 || !std::holds_alternative<double>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isNumber()) {
         throw std::runtime_error("sleep() takes exactly one numeric argument (milliseconds).");
     }
-    double ms = std::get<double>(arguments[0]);
+    double ms = arguments[0].asNumber();
     if (ms < 0) {
         throw std::runtime_error("sleep() argument must be non-negative.");
     }
@@ -2820,33 +2821,33 @@ auto nativeSleep(Interpreter& /*interp*/, const std::vector<Value>& arguments) -
 
 // mutex(): create a new mutual-exclusion lock for protecting shared mutable state
 auto nativeMutex(Interpreter& /*interp*/, const std::vector<Value>& /*arguments*/) -> Value {
-    return std::make_shared<Mutex>();
+    return makeRef<Mutex>();
 }
 
 // lock(m): acquire a mutex; blocks until the lock is available
 auto nativeLock(Interpreter& /*interp*/, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() != 1 || !std::holds_alternative<std::shared_ptr<Mutex>>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isMutex()) {
         throw std::runtime_error("lock() takes exactly one mutex argument.");
     }
-    std::get<std::shared_ptr<Mutex>>(arguments[0])->mtx->lock();
+    arguments[0].asMutex()->mtx->lock();
     return Nil{};
 }
 
 // unlock(m): release a previously acquired mutex
 auto nativeUnlock(Interpreter& /*interp*/, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() != 1 || !std::holds_alternative<std::shared_ptr<Mutex>>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isMutex()) {
         throw std::runtime_error("unlock() takes exactly one mutex argument.");
     }
-    std::get<std::shared_ptr<Mutex>>(arguments[0])->mtx->unlock();
+    arguments[0].asMutex()->mtx->unlock();
     return Nil{};
 }
 
 // trylock(m): try to acquire a mutex without blocking; returns true if acquired, false otherwise
 auto nativeTryLock(Interpreter& /*interp*/, const std::vector<Value>& arguments) -> Value {
-    if (arguments.size() != 1 || !std::holds_alternative<std::shared_ptr<Mutex>>(arguments[0])) {
+    if (arguments.size() != 1 || !arguments[0].isMutex()) {
         throw std::runtime_error("trylock() takes exactly one mutex argument.");
     }
-    return std::get<std::shared_ptr<Mutex>>(arguments[0])->mtx->try_lock();
+    return arguments[0].asMutex()->mtx->try_lock();
 }
 
 // thread_spawn(callable): spawn a callable on a new OS thread; returns a Task that can be awaited
@@ -2857,29 +2858,40 @@ auto nativeThreadSpawn(Interpreter& /*interp*/, const std::vector<Value>& argume
     if (arguments.size() != 1) {
         throw std::runtime_error("thread_spawn() takes exactly one argument.");
     }
-    if (!std::holds_alternative<std::shared_ptr<Callable>>(arguments[0])) {
+    if (!arguments[0].isCallable()) {
         throw std::runtime_error("thread_spawn() argument must be a callable.");
     }
-    auto callable = std::get<std::shared_ptr<Callable>>(arguments[0]);
-    auto task = std::make_shared<Task>();
+    auto callable = arguments[0].asCallable();
+    auto task = makeRef<Task>();
     task->osMutex = std::make_shared<std::mutex>();
     task->osCv = std::make_shared<std::condition_variable>();
     task->state = Task::State::Running;
 
-    std::thread t([task, callable]() {
-        Interpreter threadInterp;
-        // Note: Interpreter constructor already registers native functions
-        try {
-            Value result = callable->call(threadInterp, {});
-            std::lock_guard<std::mutex> lock(*task->osMutex);
-            task->result = std::move(result);
-            task->state = Task::State::Completed;
-        } catch (const std::exception& e) {
-            std::lock_guard<std::mutex> lock(*task->osMutex);
-            task->errorMessage = e.what();
-            task->state = Task::State::Failed;
+    // From here on objects may be shared with the worker, so reference
+    // counts must change atomically
+    RefCounted::shareAcrossThreads();
+    // The cycle collector stays off until the worker has dropped every
+    // reference it took, including the ones captured here
+    Gc::enterThread();
+    std::thread t([task, callable]() mutable {
+        {
+            Interpreter threadInterp;
+            // Note: Interpreter constructor already registers native functions
+            try {
+                Value result = callable->call(threadInterp, {});
+                std::lock_guard<std::mutex> lock(*task->osMutex);
+                task->result = std::move(result);
+                task->state = Task::State::Completed;
+            } catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(*task->osMutex);
+                task->errorMessage = e.what();
+                task->state = Task::State::Failed;
+            }
+            task->osCv->notify_all();
+            callable.reset();
+            task.reset();
         }
-        task->osCv->notify_all();
+        Gc::exitThread();
     });
     t.detach();
     return task;
@@ -2887,92 +2899,92 @@ auto nativeThreadSpawn(Interpreter& /*interp*/, const std::vector<Value>& argume
 
 void registerNativeFunctions(Interpreter& interp) {
     // Core functions
-    interp.defineGlobal("print", Value{std::make_shared<NativeFunction>("print", -1, nativePrint)});
-    interp.defineGlobal("clock", Value{std::make_shared<NativeFunction>("clock", 0, nativeClock)});
-    interp.defineGlobal("len", Value{std::make_shared<NativeFunction>("len", 1, nativeLen)});
-    interp.defineGlobal("str", Value{std::make_shared<NativeFunction>("str", 1, nativeStr)});
+    interp.defineGlobal("print", Value{makeRef<NativeFunction>("print", -1, nativePrint)});
+    interp.defineGlobal("clock", Value{makeRef<NativeFunction>("clock", 0, nativeClock)});
+    interp.defineGlobal("len", Value{makeRef<NativeFunction>("len", 1, nativeLen)});
+    interp.defineGlobal("str", Value{makeRef<NativeFunction>("str", 1, nativeStr)});
 
     // Concurrency functions
-    interp.defineGlobal("spawn", Value{std::make_shared<NativeFunction>("spawn", 1, nativeSpawn)});
-    interp.defineGlobal("await", Value{std::make_shared<NativeFunction>("await", 1, nativeAwait)});
-    interp.defineGlobal("sleep", Value{std::make_shared<NativeFunction>("sleep", 1, nativeSleep)});
-    interp.defineGlobal("mutex", Value{std::make_shared<NativeFunction>("mutex", 0, nativeMutex)});
-    interp.defineGlobal("lock", Value{std::make_shared<NativeFunction>("lock", 1, nativeLock)});
-    interp.defineGlobal("unlock", Value{std::make_shared<NativeFunction>("unlock", 1, nativeUnlock)});
-    interp.defineGlobal("trylock", Value{std::make_shared<NativeFunction>("trylock", 1, nativeTryLock)});
-    interp.defineGlobal("thread_spawn", Value{std::make_shared<NativeFunction>("thread_spawn", 1, nativeThreadSpawn)});
+    interp.defineGlobal("spawn", Value{makeRef<NativeFunction>("spawn", 1, nativeSpawn)});
+    interp.defineGlobal("await", Value{makeRef<NativeFunction>("await", 1, nativeAwait)});
+    interp.defineGlobal("sleep", Value{makeRef<NativeFunction>("sleep", 1, nativeSleep)});
+    interp.defineGlobal("mutex", Value{makeRef<NativeFunction>("mutex", 0, nativeMutex)});
+    interp.defineGlobal("lock", Value{makeRef<NativeFunction>("lock", 1, nativeLock)});
+    interp.defineGlobal("unlock", Value{makeRef<NativeFunction>("unlock", 1, nativeUnlock)});
+    interp.defineGlobal("trylock", Value{makeRef<NativeFunction>("trylock", 1, nativeTryLock)});
+    interp.defineGlobal("thread_spawn", Value{makeRef<NativeFunction>("thread_spawn", 1, nativeThreadSpawn)});
 
     // Array functions
-    interp.defineGlobal("push", Value{std::make_shared<NativeFunction>("push", 2, nativePush)});
-    interp.defineGlobal("pop", Value{std::make_shared<NativeFunction>("pop", 1, nativePop)});
-    interp.defineGlobal("shift", Value{std::make_shared<NativeFunction>("shift", 1, nativeShift)});
-    interp.defineGlobal("unshift", Value{std::make_shared<NativeFunction>("unshift", 2, nativeUnshift)});
-    interp.defineGlobal("splice", Value{std::make_shared<NativeFunction>("splice", -1, nativeSplice)});
+    interp.defineGlobal("push", Value{makeRef<NativeFunction>("push", 2, nativePush)});
+    interp.defineGlobal("pop", Value{makeRef<NativeFunction>("pop", 1, nativePop)});
+    interp.defineGlobal("shift", Value{makeRef<NativeFunction>("shift", 1, nativeShift)});
+    interp.defineGlobal("unshift", Value{makeRef<NativeFunction>("unshift", 2, nativeUnshift)});
+    interp.defineGlobal("splice", Value{makeRef<NativeFunction>("splice", -1, nativeSplice)});
 
     // Map functions
-    interp.defineGlobal("keys", Value{std::make_shared<NativeFunction>("keys", 1, nativeKeys)});
-    interp.defineGlobal("values", Value{std::make_shared<NativeFunction>("values", 1, nativeValues)});
-    interp.defineGlobal("hasKey", Value{std::make_shared<NativeFunction>("hasKey", 2, nativeHasKey)});
-    interp.defineGlobal("has", Value{std::make_shared<NativeFunction>("has", 2, nativeHas)});
-    interp.defineGlobal("delete", Value{std::make_shared<NativeFunction>("delete", 2, nativeDelete)});
-    interp.defineGlobal("entries", Value{std::make_shared<NativeFunction>("entries", 1, nativeEntries)});
+    interp.defineGlobal("keys", Value{makeRef<NativeFunction>("keys", 1, nativeKeys)});
+    interp.defineGlobal("values", Value{makeRef<NativeFunction>("values", 1, nativeValues)});
+    interp.defineGlobal("hasKey", Value{makeRef<NativeFunction>("hasKey", 2, nativeHasKey)});
+    interp.defineGlobal("has", Value{makeRef<NativeFunction>("has", 2, nativeHas)});
+    interp.defineGlobal("delete", Value{makeRef<NativeFunction>("delete", 2, nativeDelete)});
+    interp.defineGlobal("entries", Value{makeRef<NativeFunction>("entries", 1, nativeEntries)});
 
     // Set functions
-    interp.defineGlobal("Set", Value{std::make_shared<NativeFunction>("Set", 0, nativeSet)});
-    interp.defineGlobal("setAdd", Value{std::make_shared<NativeFunction>("setAdd", 2, nativeSetAdd)});
-    interp.defineGlobal("setHas", Value{std::make_shared<NativeFunction>("setHas", 2, nativeSetHas)});
-    interp.defineGlobal("setDelete", Value{std::make_shared<NativeFunction>("setDelete", 2, nativeSetDelete)});
-    interp.defineGlobal("setSize", Value{std::make_shared<NativeFunction>("setSize", 1, nativeSetSize)});
+    interp.defineGlobal("Set", Value{makeRef<NativeFunction>("Set", 0, nativeSet)});
+    interp.defineGlobal("setAdd", Value{makeRef<NativeFunction>("setAdd", 2, nativeSetAdd)});
+    interp.defineGlobal("setHas", Value{makeRef<NativeFunction>("setHas", 2, nativeSetHas)});
+    interp.defineGlobal("setDelete", Value{makeRef<NativeFunction>("setDelete", 2, nativeSetDelete)});
+    interp.defineGlobal("setSize", Value{makeRef<NativeFunction>("setSize", 1, nativeSetSize)});
 
     // std.math functions
-    interp.defineGlobal("sqrt", Value{std::make_shared<NativeFunction>("sqrt", 1, nativeSqrt)});
-    interp.defineGlobal("pow", Value{std::make_shared<NativeFunction>("pow", 2, nativePow)});
-    interp.defineGlobal("abs", Value{std::make_shared<NativeFunction>("abs", 1, nativeAbs)});
-    interp.defineGlobal("floor", Value{std::make_shared<NativeFunction>("floor", 1, nativeFloor)});
-    interp.defineGlobal("ceil", Value{std::make_shared<NativeFunction>("ceil", 1, nativeCeil)});
-    interp.defineGlobal("round", Value{std::make_shared<NativeFunction>("round", 1, nativeRound)});
-    interp.defineGlobal("trunc", Value{std::make_shared<NativeFunction>("trunc", 1, nativeTrunc)});
-    interp.defineGlobal("log", Value{std::make_shared<NativeFunction>("log", 1, nativeLog)});
-    interp.defineGlobal("log2", Value{std::make_shared<NativeFunction>("log2", 1, nativeLog2)});
-    interp.defineGlobal("log10", Value{std::make_shared<NativeFunction>("log10", 1, nativeLog10)});
-    interp.defineGlobal("sin", Value{std::make_shared<NativeFunction>("sin", 1, nativeSin)});
-    interp.defineGlobal("cos", Value{std::make_shared<NativeFunction>("cos", 1, nativeCos)});
-    interp.defineGlobal("tan", Value{std::make_shared<NativeFunction>("tan", 1, nativeTan)});
-    interp.defineGlobal("asin", Value{std::make_shared<NativeFunction>("asin", 1, nativeAsin)});
-    interp.defineGlobal("acos", Value{std::make_shared<NativeFunction>("acos", 1, nativeAcos)});
-    interp.defineGlobal("atan", Value{std::make_shared<NativeFunction>("atan", 1, nativeAtan)});
-    interp.defineGlobal("atan2", Value{std::make_shared<NativeFunction>("atan2", 2, nativeAtan2)});
-    interp.defineGlobal("hypot", Value{std::make_shared<NativeFunction>("hypot", -1, nativeHypot)});
-    interp.defineGlobal("min", Value{std::make_shared<NativeFunction>("min", -1, nativeMin)});
-    interp.defineGlobal("max", Value{std::make_shared<NativeFunction>("max", -1, nativeMax)});
+    interp.defineGlobal("sqrt", Value{makeRef<NativeFunction>("sqrt", 1, nativeSqrt)});
+    interp.defineGlobal("pow", Value{makeRef<NativeFunction>("pow", 2, nativePow)});
+    interp.defineGlobal("abs", Value{makeRef<NativeFunction>("abs", 1, nativeAbs)});
+    interp.defineGlobal("floor", Value{makeRef<NativeFunction>("floor", 1, nativeFloor)});
+    interp.defineGlobal("ceil", Value{makeRef<NativeFunction>("ceil", 1, nativeCeil)});
+    interp.defineGlobal("round", Value{makeRef<NativeFunction>("round", 1, nativeRound)});
+    interp.defineGlobal("trunc", Value{makeRef<NativeFunction>("trunc", 1, nativeTrunc)});
+    interp.defineGlobal("log", Value{makeRef<NativeFunction>("log", 1, nativeLog)});
+    interp.defineGlobal("log2", Value{makeRef<NativeFunction>("log2", 1, nativeLog2)});
+    interp.defineGlobal("log10", Value{makeRef<NativeFunction>("log10", 1, nativeLog10)});
+    interp.defineGlobal("sin", Value{makeRef<NativeFunction>("sin", 1, nativeSin)});
+    interp.defineGlobal("cos", Value{makeRef<NativeFunction>("cos", 1, nativeCos)});
+    interp.defineGlobal("tan", Value{makeRef<NativeFunction>("tan", 1, nativeTan)});
+    interp.defineGlobal("asin", Value{makeRef<NativeFunction>("asin", 1, nativeAsin)});
+    interp.defineGlobal("acos", Value{makeRef<NativeFunction>("acos", 1, nativeAcos)});
+    interp.defineGlobal("atan", Value{makeRef<NativeFunction>("atan", 1, nativeAtan)});
+    interp.defineGlobal("atan2", Value{makeRef<NativeFunction>("atan2", 2, nativeAtan2)});
+    interp.defineGlobal("hypot", Value{makeRef<NativeFunction>("hypot", -1, nativeHypot)});
+    interp.defineGlobal("min", Value{makeRef<NativeFunction>("min", -1, nativeMin)});
+    interp.defineGlobal("max", Value{makeRef<NativeFunction>("max", -1, nativeMax)});
 
     // std.string functions
-    interp.defineGlobal("substring", Value{std::make_shared<NativeFunction>("substring", -1, nativeSubstring)});
-    interp.defineGlobal("split", Value{std::make_shared<NativeFunction>("split", 2, nativeSplit)});
-    interp.defineGlobal("join", Value{std::make_shared<NativeFunction>("join", 2, nativeJoin)});
-    interp.defineGlobal("toUpper", Value{std::make_shared<NativeFunction>("toUpper", 1, nativeToUpper)});
-    interp.defineGlobal("toLower", Value{std::make_shared<NativeFunction>("toLower", 1, nativeToLower)});
-    interp.defineGlobal("trim", Value{std::make_shared<NativeFunction>("trim", 1, nativeTrim)});
-    interp.defineGlobal("replace", Value{std::make_shared<NativeFunction>("replace", 3, nativeReplace)});
-    interp.defineGlobal("startsWith", Value{std::make_shared<NativeFunction>("startsWith", 2, nativeStartsWith)});
-    interp.defineGlobal("endsWith", Value{std::make_shared<NativeFunction>("endsWith", 2, nativeEndsWith)});
-    interp.defineGlobal("indexOf", Value{std::make_shared<NativeFunction>("indexOf", 2, nativeIndexOf)});
-    interp.defineGlobal("contains", Value{std::make_shared<NativeFunction>("contains", 2, nativeContains)});
+    interp.defineGlobal("substring", Value{makeRef<NativeFunction>("substring", -1, nativeSubstring)});
+    interp.defineGlobal("split", Value{makeRef<NativeFunction>("split", 2, nativeSplit)});
+    interp.defineGlobal("join", Value{makeRef<NativeFunction>("join", 2, nativeJoin)});
+    interp.defineGlobal("toUpper", Value{makeRef<NativeFunction>("toUpper", 1, nativeToUpper)});
+    interp.defineGlobal("toLower", Value{makeRef<NativeFunction>("toLower", 1, nativeToLower)});
+    interp.defineGlobal("trim", Value{makeRef<NativeFunction>("trim", 1, nativeTrim)});
+    interp.defineGlobal("replace", Value{makeRef<NativeFunction>("replace", 3, nativeReplace)});
+    interp.defineGlobal("startsWith", Value{makeRef<NativeFunction>("startsWith", 2, nativeStartsWith)});
+    interp.defineGlobal("endsWith", Value{makeRef<NativeFunction>("endsWith", 2, nativeEndsWith)});
+    interp.defineGlobal("indexOf", Value{makeRef<NativeFunction>("indexOf", 2, nativeIndexOf)});
+    interp.defineGlobal("contains", Value{makeRef<NativeFunction>("contains", 2, nativeContains)});
 
     // std.array functions
-    interp.defineGlobal("map", Value{std::make_shared<NativeFunction>("map", 2, nativeMap)});
-    interp.defineGlobal("filter", Value{std::make_shared<NativeFunction>("filter", 2, nativeFilter)});
-    interp.defineGlobal("reduce", Value{std::make_shared<NativeFunction>("reduce", -1, nativeReduce)});
-    interp.defineGlobal("sort", Value{std::make_shared<NativeFunction>("sort", -1, nativeSort)});
-    interp.defineGlobal("reverse", Value{std::make_shared<NativeFunction>("reverse", 1, nativeReverse)});
-    interp.defineGlobal("concat", Value{std::make_shared<NativeFunction>("concat", 2, nativeConcat)});
-    interp.defineGlobal("slice", Value{std::make_shared<NativeFunction>("slice", -1, nativeSlice)});
+    interp.defineGlobal("map", Value{makeRef<NativeFunction>("map", 2, nativeMap)});
+    interp.defineGlobal("filter", Value{makeRef<NativeFunction>("filter", 2, nativeFilter)});
+    interp.defineGlobal("reduce", Value{makeRef<NativeFunction>("reduce", -1, nativeReduce)});
+    interp.defineGlobal("sort", Value{makeRef<NativeFunction>("sort", -1, nativeSort)});
+    interp.defineGlobal("reverse", Value{makeRef<NativeFunction>("reverse", 1, nativeReverse)});
+    interp.defineGlobal("concat", Value{makeRef<NativeFunction>("concat", 2, nativeConcat)});
+    interp.defineGlobal("slice", Value{makeRef<NativeFunction>("slice", -1, nativeSlice)});
 
     // std.io functions
-    interp.defineGlobal("readFile", Value{std::make_shared<NativeFunction>("readFile", 1, nativeReadFile)});
-    interp.defineGlobal("writeFile", Value{std::make_shared<NativeFunction>("writeFile", 2, nativeWriteFile)});
-    interp.defineGlobal("appendFile", Value{std::make_shared<NativeFunction>("appendFile", 2, nativeAppendFile)});
-    interp.defineGlobal("fileExists", Value{std::make_shared<NativeFunction>("fileExists", 1, nativeFileExists)});
+    interp.defineGlobal("readFile", Value{makeRef<NativeFunction>("readFile", 1, nativeReadFile)});
+    interp.defineGlobal("writeFile", Value{makeRef<NativeFunction>("writeFile", 2, nativeWriteFile)});
+    interp.defineGlobal("appendFile", Value{makeRef<NativeFunction>("appendFile", 2, nativeAppendFile)});
+    interp.defineGlobal("fileExists", Value{makeRef<NativeFunction>("fileExists", 1, nativeFileExists)});
 }
 
 }  // namespace izi
\ No newline at end of file
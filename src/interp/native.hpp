@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 
+#include "../common/trace.hpp"
 #include "../common/value.hpp"
 #include "interpreter.hpp"
 
@@ -19,7 +20,13 @@ class NativeFunction : public Callable {
     std::string name() const { return name_; }
     int arity() const override { return arity_; }
 
-    Value call(Interpreter& interp, const std::vector<Value>& arguments) override { return fn_(interp, arguments); }
+    Value call(Interpreter& interp, const std::vector<Value>& arguments) override {
+        if (Trace::enabled()) [[unlikely]] {
+            TraceScope trace("native", name_, Trace::NATIVE_CALL_THRESHOLD_US);
+            return fn_(interp, arguments);
+        }
+        return fn_(interp, arguments);
+    }
 
    private:
     std::string name_;
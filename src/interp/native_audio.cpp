@@ -88,38 +88,38 @@ struct MusicHandle {
 // ---------------------------------------------------------------------------
 #ifdef HAVE_RAYLIB
 static Value buildSoundObject(std::shared_ptr<SoundHandle> handle) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
-    obj->entries["play"] = Value{std::make_shared<NativeFunction>("play", 0,
+    obj->entries["play"] = Value{makeRef<NativeFunction>("play", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) PlaySound(handle->sound);
             return Nil{};
         })};
 
-    obj->entries["stop"] = Value{std::make_shared<NativeFunction>("stop", 0,
+    obj->entries["stop"] = Value{makeRef<NativeFunction>("stop", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) StopSound(handle->sound);
             return Nil{};
         })};
 
-    obj->entries["pause"] = Value{std::make_shared<NativeFunction>("pause", 0,
+    obj->entries["pause"] = Value{makeRef<NativeFunction>("pause", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) PauseSound(handle->sound);
             return Nil{};
         })};
 
-    obj->entries["resume"] = Value{std::make_shared<NativeFunction>("resume", 0,
+    obj->entries["resume"] = Value{makeRef<NativeFunction>("resume", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ResumeSound(handle->sound);
             return Nil{};
         })};
 
-    obj->entries["isPlaying"] = Value{std::make_shared<NativeFunction>("isPlaying", 0,
+    obj->entries["isPlaying"] = Value{makeRef<NativeFunction>("isPlaying", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             return handle->loaded && static_cast<bool>(IsSoundPlaying(handle->sound));
         })};
 
-    obj->entries["setVolume"] = Value{std::make_shared<NativeFunction>("setVolume", 1,
+    obj->entries["setVolume"] = Value{makeRef<NativeFunction>("setVolume", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("sound.setVolume() takes 1 argument (volume).");
@@ -128,7 +128,7 @@ static Value buildSoundObject(std::shared_ptr<SoundHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["setPitch"] = Value{std::make_shared<NativeFunction>("setPitch", 1,
+    obj->entries["setPitch"] = Value{makeRef<NativeFunction>("setPitch", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("sound.setPitch() takes 1 argument (pitch).");
@@ -137,7 +137,7 @@ static Value buildSoundObject(std::shared_ptr<SoundHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["setPan"] = Value{std::make_shared<NativeFunction>("setPan", 1,
+    obj->entries["setPan"] = Value{makeRef<NativeFunction>("setPan", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("sound.setPan() takes 1 argument (pan).");
@@ -146,7 +146,7 @@ static Value buildSoundObject(std::shared_ptr<SoundHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["unload"] = Value{std::make_shared<NativeFunction>("unload", 0,
+    obj->entries["unload"] = Value{makeRef<NativeFunction>("unload", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) {
                 UnloadSound(handle->sound);
@@ -159,38 +159,38 @@ static Value buildSoundObject(std::shared_ptr<SoundHandle> handle) {
 }
 #else
 static Value buildSoundObject(std::shared_ptr<SoundHandle> handle) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
-    obj->entries["play"] = Value{std::make_shared<NativeFunction>("play", 0,
+    obj->entries["play"] = Value{makeRef<NativeFunction>("play", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ma_sound_start(&handle->sound);
             return Nil{};
         })};
 
-    obj->entries["stop"] = Value{std::make_shared<NativeFunction>("stop", 0,
+    obj->entries["stop"] = Value{makeRef<NativeFunction>("stop", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ma_sound_stop(&handle->sound);
             return Nil{};
         })};
 
-    obj->entries["pause"] = Value{std::make_shared<NativeFunction>("pause", 0,
+    obj->entries["pause"] = Value{makeRef<NativeFunction>("pause", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ma_sound_stop(&handle->sound);
             return Nil{};
         })};
 
-    obj->entries["resume"] = Value{std::make_shared<NativeFunction>("resume", 0,
+    obj->entries["resume"] = Value{makeRef<NativeFunction>("resume", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ma_sound_start(&handle->sound);
             return Nil{};
         })};
 
-    obj->entries["isPlaying"] = Value{std::make_shared<NativeFunction>("isPlaying", 0,
+    obj->entries["isPlaying"] = Value{makeRef<NativeFunction>("isPlaying", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             return handle->loaded && static_cast<bool>(ma_sound_is_playing(&handle->sound));
         })};
 
-    obj->entries["setVolume"] = Value{std::make_shared<NativeFunction>("setVolume", 1,
+    obj->entries["setVolume"] = Value{makeRef<NativeFunction>("setVolume", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("sound.setVolume() takes 1 argument (volume).");
@@ -199,7 +199,7 @@ static Value buildSoundObject(std::shared_ptr<SoundHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["setPitch"] = Value{std::make_shared<NativeFunction>("setPitch", 1,
+    obj->entries["setPitch"] = Value{makeRef<NativeFunction>("setPitch", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("sound.setPitch() takes 1 argument (pitch).");
@@ -208,7 +208,7 @@ static Value buildSoundObject(std::shared_ptr<SoundHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["setPan"] = Value{std::make_shared<NativeFunction>("setPan", 1,
+    obj->entries["setPan"] = Value{makeRef<NativeFunction>("setPan", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("sound.setPan() takes 1 argument (pan).");
@@ -217,7 +217,7 @@ static Value buildSoundObject(std::shared_ptr<SoundHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["unload"] = Value{std::make_shared<NativeFunction>("unload", 0,
+    obj->entries["unload"] = Value{makeRef<NativeFunction>("unload", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) {
                 ma_sound_uninit(&handle->sound);
@@ -235,44 +235,44 @@ static Value buildSoundObject(std::shared_ptr<SoundHandle> handle) {
 // ---------------------------------------------------------------------------
 #ifdef HAVE_RAYLIB
 static Value buildMusicObject(std::shared_ptr<MusicHandle> handle) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
-    obj->entries["play"] = Value{std::make_shared<NativeFunction>("play", 0,
+    obj->entries["play"] = Value{makeRef<NativeFunction>("play", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) PlayMusicStream(handle->music);
             return Nil{};
         })};
 
-    obj->entries["stop"] = Value{std::make_shared<NativeFunction>("stop", 0,
+    obj->entries["stop"] = Value{makeRef<NativeFunction>("stop", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) StopMusicStream(handle->music);
             return Nil{};
         })};
 
-    obj->entries["pause"] = Value{std::make_shared<NativeFunction>("pause", 0,
+    obj->entries["pause"] = Value{makeRef<NativeFunction>("pause", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) PauseMusicStream(handle->music);
             return Nil{};
         })};
 
-    obj->entries["resume"] = Value{std::make_shared<NativeFunction>("resume", 0,
+    obj->entries["resume"] = Value{makeRef<NativeFunction>("resume", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ResumeMusicStream(handle->music);
             return Nil{};
         })};
 
-    obj->entries["update"] = Value{std::make_shared<NativeFunction>("update", 0,
+    obj->entries["update"] = Value{makeRef<NativeFunction>("update", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) UpdateMusicStream(handle->music);
             return Nil{};
         })};
 
-    obj->entries["isPlaying"] = Value{std::make_shared<NativeFunction>("isPlaying", 0,
+    obj->entries["isPlaying"] = Value{makeRef<NativeFunction>("isPlaying", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             return handle->loaded && static_cast<bool>(IsMusicStreamPlaying(handle->music));
         })};
 
-    obj->entries["setVolume"] = Value{std::make_shared<NativeFunction>("setVolume", 1,
+    obj->entries["setVolume"] = Value{makeRef<NativeFunction>("setVolume", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("music.setVolume() takes 1 argument (volume).");
@@ -281,7 +281,7 @@ static Value buildMusicObject(std::shared_ptr<MusicHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["setPitch"] = Value{std::make_shared<NativeFunction>("setPitch", 1,
+    obj->entries["setPitch"] = Value{makeRef<NativeFunction>("setPitch", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("music.setPitch() takes 1 argument (pitch).");
@@ -290,7 +290,7 @@ static Value buildMusicObject(std::shared_ptr<MusicHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["setPan"] = Value{std::make_shared<NativeFunction>("setPan", 1,
+    obj->entries["setPan"] = Value{makeRef<NativeFunction>("setPan", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("music.setPan() takes 1 argument (pan).");
@@ -299,7 +299,7 @@ static Value buildMusicObject(std::shared_ptr<MusicHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["seek"] = Value{std::make_shared<NativeFunction>("seek", 1,
+    obj->entries["seek"] = Value{makeRef<NativeFunction>("seek", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("music.seek() takes 1 argument (position).");
@@ -308,19 +308,19 @@ static Value buildMusicObject(std::shared_ptr<MusicHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["getLength"] = Value{std::make_shared<NativeFunction>("getLength", 0,
+    obj->entries["getLength"] = Value{makeRef<NativeFunction>("getLength", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (!handle->loaded) return 0.0;
             return static_cast<double>(GetMusicTimeLength(handle->music));
         })};
 
-    obj->entries["getTimePlayed"] = Value{std::make_shared<NativeFunction>("getTimePlayed", 0,
+    obj->entries["getTimePlayed"] = Value{makeRef<NativeFunction>("getTimePlayed", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (!handle->loaded) return 0.0;
             return static_cast<double>(GetMusicTimePlayed(handle->music));
         })};
 
-    obj->entries["unload"] = Value{std::make_shared<NativeFunction>("unload", 0,
+    obj->entries["unload"] = Value{makeRef<NativeFunction>("unload", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) {
                 UnloadMusicStream(handle->music);
@@ -333,44 +333,44 @@ static Value buildMusicObject(std::shared_ptr<MusicHandle> handle) {
 }
 #else
 static Value buildMusicObject(std::shared_ptr<MusicHandle> handle) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
-    obj->entries["play"] = Value{std::make_shared<NativeFunction>("play", 0,
+    obj->entries["play"] = Value{makeRef<NativeFunction>("play", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ma_sound_start(&handle->sound);
             return Nil{};
         })};
 
-    obj->entries["stop"] = Value{std::make_shared<NativeFunction>("stop", 0,
+    obj->entries["stop"] = Value{makeRef<NativeFunction>("stop", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ma_sound_stop(&handle->sound);
             return Nil{};
         })};
 
-    obj->entries["pause"] = Value{std::make_shared<NativeFunction>("pause", 0,
+    obj->entries["pause"] = Value{makeRef<NativeFunction>("pause", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ma_sound_stop(&handle->sound);
             return Nil{};
         })};
 
-    obj->entries["resume"] = Value{std::make_shared<NativeFunction>("resume", 0,
+    obj->entries["resume"] = Value{makeRef<NativeFunction>("resume", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) ma_sound_start(&handle->sound);
             return Nil{};
         })};
 
-    obj->entries["update"] = Value{std::make_shared<NativeFunction>("update", 0,
+    obj->entries["update"] = Value{makeRef<NativeFunction>("update", 0,
         [](Interpreter&, const std::vector<Value>&) -> Value {
             // miniaudio streams are updated automatically on a background thread.
             return Nil{};
         })};
 
-    obj->entries["isPlaying"] = Value{std::make_shared<NativeFunction>("isPlaying", 0,
+    obj->entries["isPlaying"] = Value{makeRef<NativeFunction>("isPlaying", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             return handle->loaded && static_cast<bool>(ma_sound_is_playing(&handle->sound));
         })};
 
-    obj->entries["setVolume"] = Value{std::make_shared<NativeFunction>("setVolume", 1,
+    obj->entries["setVolume"] = Value{makeRef<NativeFunction>("setVolume", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("music.setVolume() takes 1 argument (volume).");
@@ -379,7 +379,7 @@ static Value buildMusicObject(std::shared_ptr<MusicHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["setPitch"] = Value{std::make_shared<NativeFunction>("setPitch", 1,
+    obj->entries["setPitch"] = Value{makeRef<NativeFunction>("setPitch", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("music.setPitch() takes 1 argument (pitch).");
@@ -388,7 +388,7 @@ static Value buildMusicObject(std::shared_ptr<MusicHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["setPan"] = Value{std::make_shared<NativeFunction>("setPan", 1,
+    obj->entries["setPan"] = Value{makeRef<NativeFunction>("setPan", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("music.setPan() takes 1 argument (pan).");
@@ -397,7 +397,7 @@ static Value buildMusicObject(std::shared_ptr<MusicHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["seek"] = Value{std::make_shared<NativeFunction>("seek", 1,
+    obj->entries["seek"] = Value{makeRef<NativeFunction>("seek", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("music.seek() takes 1 argument (position).");
@@ -408,7 +408,7 @@ static Value buildMusicObject(std::shared_ptr<MusicHandle> handle) {
             return Nil{};
         })};
 
-    obj->entries["getLength"] = Value{std::make_shared<NativeFunction>("getLength", 0,
+    obj->entries["getLength"] = Value{makeRef<NativeFunction>("getLength", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (!handle->loaded) return 0.0;
             float len = 0.0f;
@@ -416,7 +416,7 @@ static Value buildMusicObject(std::shared_ptr<MusicHandle> handle) {
             return static_cast<double>(len);
         })};
 
-    obj->entries["getTimePlayed"] = Value{std::make_shared<NativeFunction>("getTimePlayed", 0,
+    obj->entries["getTimePlayed"] = Value{makeRef<NativeFunction>("getTimePlayed", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (!handle->loaded) return 0.0;
             float t = 0.0f;
@@ -424,7 +424,7 @@ static Value buildMusicObject(std::shared_ptr<MusicHandle> handle) {
             return static_cast<double>(t);
         })};
 
-    obj->entries["unload"] = Value{std::make_shared<NativeFunction>("unload", 0,
+    obj->entries["unload"] = Value{makeRef<NativeFunction>("unload", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) {
                 ma_sound_uninit(&handle->sound);
@@ -441,10 +441,10 @@ static Value buildMusicObject(std::shared_ptr<MusicHandle> handle) {
 // Build the top-level audio module Map
 // ---------------------------------------------------------------------------
 Value createAudioModule(Interpreter& /*interp*/) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // audio.initDevice()
-    module->entries["initDevice"] = Value{std::make_shared<NativeFunction>("initDevice", 0,
+    module->entries["initDevice"] = Value{makeRef<NativeFunction>("initDevice", 0,
         [](Interpreter&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             InitAudioDevice();
@@ -463,7 +463,7 @@ Value createAudioModule(Interpreter& /*interp*/) {
         })};
 
     // audio.closeDevice()
-    module->entries["closeDevice"] = Value{std::make_shared<NativeFunction>("closeDevice", 0,
+    module->entries["closeDevice"] = Value{makeRef<NativeFunction>("closeDevice", 0,
         [](Interpreter&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             CloseAudioDevice();
@@ -478,7 +478,7 @@ Value createAudioModule(Interpreter& /*interp*/) {
         })};
 
     // audio.isDeviceReady() -> bool
-    module->entries["isDeviceReady"] = Value{std::make_shared<NativeFunction>("isDeviceReady", 0,
+    module->entries["isDeviceReady"] = Value{makeRef<NativeFunction>("isDeviceReady", 0,
         [](Interpreter&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             return static_cast<bool>(IsAudioDeviceReady());
@@ -488,7 +488,7 @@ Value createAudioModule(Interpreter& /*interp*/) {
         })};
 
     // audio.setMasterVolume(volume)
-    module->entries["setMasterVolume"] = Value{std::make_shared<NativeFunction>("setMasterVolume", 1,
+    module->entries["setMasterVolume"] = Value{makeRef<NativeFunction>("setMasterVolume", 1,
         [](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("audio.setMasterVolume() takes 1 argument (volume).");
@@ -505,11 +505,11 @@ Value createAudioModule(Interpreter& /*interp*/) {
         })};
 
     // audio.loadSound(path) -> sound object
-    module->entries["loadSound"] = Value{std::make_shared<NativeFunction>("loadSound", 1,
+    module->entries["loadSound"] = Value{makeRef<NativeFunction>("loadSound", 1,
         [](Interpreter&, const std::vector<Value>& args) -> Value {
-            if (args.size() != 1 || !std::holds_alternative<std::string>(args[0]))
+            if (args.size() != 1 || !args[0].isString())
                 throw std::runtime_error("audio.loadSound() takes 1 string argument (path).");
-            const std::string& path = std::get<std::string>(args[0]);
+            const std::string& path = args[0].asString();
 #ifdef HAVE_RAYLIB
             auto handle = std::make_shared<SoundHandle>();
             handle->sound = LoadSound(path.c_str());
@@ -533,11 +533,11 @@ Value createAudioModule(Interpreter& /*interp*/) {
         })};
 
     // audio.loadMusic(path) -> music stream object
-    module->entries["loadMusic"] = Value{std::make_shared<NativeFunction>("loadMusic", 1,
+    module->entries["loadMusic"] = Value{makeRef<NativeFunction>("loadMusic", 1,
         [](Interpreter&, const std::vector<Value>& args) -> Value {
-            if (args.size() != 1 || !std::holds_alternative<std::string>(args[0]))
+            if (args.size() != 1 || !args[0].isString())
                 throw std::runtime_error("audio.loadMusic() takes 1 string argument (path).");
-            const std::string& path = std::get<std::string>(args[0]);
+            const std::string& path = args[0].asString();
 #ifdef HAVE_RAYLIB
             auto handle = std::make_shared<MusicHandle>();
             handle->music = LoadMusicStream(path.c_str());
@@ -114,21 +114,21 @@ static Value buildImageObject(std::shared_ptr<ImageHandle> handle);
 
 #ifdef HAVE_RAYLIB
 static Value buildImageObject(std::shared_ptr<ImageHandle> handle) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
-    obj->entries["getWidth"] = Value{std::make_shared<NativeFunction>("getWidth", 0,
+    obj->entries["getWidth"] = Value{makeRef<NativeFunction>("getWidth", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (!handle->loaded) return 0.0;
             return static_cast<double>(handle->image.width);
         })};
 
-    obj->entries["getHeight"] = Value{std::make_shared<NativeFunction>("getHeight", 0,
+    obj->entries["getHeight"] = Value{makeRef<NativeFunction>("getHeight", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (!handle->loaded) return 0.0;
             return static_cast<double>(handle->image.height);
         })};
 
-    obj->entries["resize"] = Value{std::make_shared<NativeFunction>("resize", 2,
+    obj->entries["resize"] = Value{makeRef<NativeFunction>("resize", 2,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 2)
                 throw std::runtime_error("image.resize() takes 2 arguments (width, height).");
@@ -142,7 +142,7 @@ static Value buildImageObject(std::shared_ptr<ImageHandle> handle) {
             return buildImageObject(newHandle);
         })};
 
-    obj->entries["crop"] = Value{std::make_shared<NativeFunction>("crop", 4,
+    obj->entries["crop"] = Value{makeRef<NativeFunction>("crop", 4,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 4)
                 throw std::runtime_error("image.crop() takes 4 arguments (x, y, width, height).");
@@ -160,7 +160,7 @@ static Value buildImageObject(std::shared_ptr<ImageHandle> handle) {
             return buildImageObject(newHandle);
         })};
 
-    obj->entries["rotate"] = Value{std::make_shared<NativeFunction>("rotate", 1,
+    obj->entries["rotate"] = Value{makeRef<NativeFunction>("rotate", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("image.rotate() takes 1 argument (degrees).");
@@ -172,7 +172,7 @@ static Value buildImageObject(std::shared_ptr<ImageHandle> handle) {
             return buildImageObject(newHandle);
         })};
 
-    obj->entries["flipHorizontal"] = Value{std::make_shared<NativeFunction>("flipHorizontal", 0,
+    obj->entries["flipHorizontal"] = Value{makeRef<NativeFunction>("flipHorizontal", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (!handle->loaded)
                 throw std::runtime_error("image.flipHorizontal(): image is not loaded.");
@@ -183,7 +183,7 @@ static Value buildImageObject(std::shared_ptr<ImageHandle> handle) {
             return buildImageObject(newHandle);
         })};
 
-    obj->entries["flipVertical"] = Value{std::make_shared<NativeFunction>("flipVertical", 0,
+    obj->entries["flipVertical"] = Value{makeRef<NativeFunction>("flipVertical", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (!handle->loaded)
                 throw std::runtime_error("image.flipVertical(): image is not loaded.");
@@ -194,7 +194,7 @@ static Value buildImageObject(std::shared_ptr<ImageHandle> handle) {
             return buildImageObject(newHandle);
         })};
 
-    obj->entries["blur"] = Value{std::make_shared<NativeFunction>("blur", 1,
+    obj->entries["blur"] = Value{makeRef<NativeFunction>("blur", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("image.blur() takes 1 argument (blurSize).");
@@ -206,16 +206,16 @@ static Value buildImageObject(std::shared_ptr<ImageHandle> handle) {
             return buildImageObject(newHandle);
         })};
 
-    obj->entries["save"] = Value{std::make_shared<NativeFunction>("save", 1,
+    obj->entries["save"] = Value{makeRef<NativeFunction>("save", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
-            if (args.size() != 1 || !std::holds_alternative<std::string>(args[0]))
+            if (args.size() != 1 || !args[0].isString())
                 throw std::runtime_error("image.save() takes 1 string argument (path).");
             if (!handle->loaded) throw std::runtime_error("image.save(): image is not loaded.");
-            ExportImage(handle->image, std::get<std::string>(args[0]).c_str());
+            ExportImage(handle->image, args[0].asString().c_str());
             return Nil{};
         })};
 
-    obj->entries["unload"] = Value{std::make_shared<NativeFunction>("unload", 0,
+    obj->entries["unload"] = Value{makeRef<NativeFunction>("unload", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (handle->loaded) {
                 UnloadImage(handle->image);
@@ -230,21 +230,21 @@ static Value buildImageObject(std::shared_ptr<ImageHandle> handle) {
 #else  // !HAVE_RAYLIB — stb_image-backed implementation
 
 static Value buildImageObject(std::shared_ptr<ImageHandle> handle) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
-    obj->entries["getWidth"] = Value{std::make_shared<NativeFunction>("getWidth", 0,
+    obj->entries["getWidth"] = Value{makeRef<NativeFunction>("getWidth", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (!handle->loaded) return 0.0;
             return static_cast<double>(handle->width);
         })};
 
-    obj->entries["getHeight"] = Value{std::make_shared<NativeFunction>("getHeight", 0,
+    obj->entries["getHeight"] = Value{makeRef<NativeFunction>("getHeight", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (!handle->loaded) return 0.0;
             return static_cast<double>(handle->height);
         })};
 
-    obj->entries["resize"] = Value{std::make_shared<NativeFunction>("resize", 2,
+    obj->entries["resize"] = Value{makeRef<NativeFunction>("resize", 2,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 2)
                 throw std::runtime_error("image.resize() takes 2 arguments (width, height).");
@@ -266,7 +266,7 @@ static Value buildImageObject(std::shared_ptr<ImageHandle> handle) {
             return buildImageObject(newHandle);
         })};
 
-    obj->entries["crop"] = Value{std::make_shared<NativeFunction>("crop", 4,
+    obj->entries["crop"] = Value{makeRef<NativeFunction>("crop", 4,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 4)
                 throw std::runtime_error("image.crop() takes 4 arguments (x, y, width, height).");
@@ -295,7 +295,7 @@ static Value buildImageObject(std::shared_ptr<ImageHandle> handle) {
             return buildImageObject(newHandle);
         })};
 
-    obj->entries["rotate"] = Value{std::make_shared<NativeFunction>("rotate", 1,
+    obj->entries["rotate"] = Value{makeRef<NativeFunction>("rotate", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("image.rotate() takes 1 argument (degrees).");
@@ -317,7 +317,7 @@ static Value buildImageObject(std::shared_ptr<ImageHandle> handle) {
             return buildImageObject(newHandle);
         })};
 
-    obj->entries["flipHorizontal"] = Value{std::make_shared<NativeFunction>("flipHorizontal", 0,
+    obj->entries["flipHorizontal"] = Value{makeRef<NativeFunction>("flipHorizontal", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (!handle->loaded)
                 throw std::runtime_error("image.flipHorizontal(): image is not loaded.");
@@ -341,7 +341,7 @@ static Value buildImageObject(std::shared_ptr<ImageHandle> handle) {
             return buildImageObject(newHandle);
         })};
 
-    obj->entries["flipVertical"] = Value{std::make_shared<NativeFunction>("flipVertical", 0,
+    obj->entries["flipVertical"] = Value{makeRef<NativeFunction>("flipVertical", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             if (!handle->loaded)
                 throw std::runtime_error("image.flipVertical(): image is not loaded.");
@@ -362,7 +362,7 @@ static Value buildImageObject(std::shared_ptr<ImageHandle> handle) {
             return buildImageObject(newHandle);
         })};
 
-    obj->entries["blur"] = Value{std::make_shared<NativeFunction>("blur", 1,
+    obj->entries["blur"] = Value{makeRef<NativeFunction>("blur", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1)
                 throw std::runtime_error("image.blur() takes 1 argument (blurSize).");
@@ -378,17 +378,17 @@ static Value buildImageObject(std::shared_ptr<ImageHandle> handle) {
             return buildImageObject(newHandle);
         })};
 
-    obj->entries["save"] = Value{std::make_shared<NativeFunction>("save", 1,
+    obj->entries["save"] = Value{makeRef<NativeFunction>("save", 1,
         [handle](Interpreter&, const std::vector<Value>& args) -> Value {
-            if (args.size() != 1 || !std::holds_alternative<std::string>(args[0]))
+            if (args.size() != 1 || !args[0].isString())
                 throw std::runtime_error("image.save() takes 1 string argument (path).");
             if (!handle->loaded) throw std::runtime_error("image.save(): image is not loaded.");
-            saveImageToFile(std::get<std::string>(args[0]),
+            saveImageToFile(args[0].asString(),
                             handle->pixels.data(), handle->width, handle->height, handle->channels);
             return Nil{};
         })};
 
-    obj->entries["unload"] = Value{std::make_shared<NativeFunction>("unload", 0,
+    obj->entries["unload"] = Value{makeRef<NativeFunction>("unload", 0,
         [handle](Interpreter&, const std::vector<Value>&) -> Value {
             handle->pixels.clear();
             handle->pixels.shrink_to_fit();
@@ -404,14 +404,14 @@ static Value buildImageObject(std::shared_ptr<ImageHandle> handle) {
 // Build the top-level image module Map
 // ---------------------------------------------------------------------------
 Value createImageModule(Interpreter& /*interp*/) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // image.load(path) -> image object
-    module->entries["load"] = Value{std::make_shared<NativeFunction>("load", 1,
+    module->entries["load"] = Value{makeRef<NativeFunction>("load", 1,
         [](Interpreter&, const std::vector<Value>& args) -> Value {
-            if (args.size() != 1 || !std::holds_alternative<std::string>(args[0]))
+            if (args.size() != 1 || !args[0].isString())
                 throw std::runtime_error("image.load() takes 1 string argument (path).");
-            const std::string& path = std::get<std::string>(args[0]);
+            const std::string& path = args[0].asString();
 #ifdef HAVE_RAYLIB
             auto handle = std::make_shared<ImageHandle>();
             handle->image = LoadImage(path.c_str());
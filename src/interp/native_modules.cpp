@@ -10,7 +10,7 @@
 namespace izi {
 
 Value createMathModule(Interpreter& interp) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // Constants
     module->entries["pi"] = M_PI;
@@ -25,229 +25,229 @@ Value createMathModule(Interpreter& interp) {
     module->entries["INF"] = std::numeric_limits<double>::infinity();
 
     // Functions
-    module->entries["sqrt"] = Value{std::make_shared<NativeFunction>("sqrt", 1, nativeSqrt)};
-    module->entries["pow"] = Value{std::make_shared<NativeFunction>("pow", 2, nativePow)};
-    module->entries["abs"] = Value{std::make_shared<NativeFunction>("abs", 1, nativeAbs)};
-    module->entries["floor"] = Value{std::make_shared<NativeFunction>("floor", 1, nativeFloor)};
-    module->entries["ceil"] = Value{std::make_shared<NativeFunction>("ceil", 1, nativeCeil)};
-    module->entries["round"] = Value{std::make_shared<NativeFunction>("round", 1, nativeRound)};
-    module->entries["trunc"] = Value{std::make_shared<NativeFunction>("trunc", 1, nativeTrunc)};
-    module->entries["log"] = Value{std::make_shared<NativeFunction>("log", 1, nativeLog)};
-    module->entries["log2"] = Value{std::make_shared<NativeFunction>("log2", 1, nativeLog2)};
-    module->entries["log10"] = Value{std::make_shared<NativeFunction>("log10", 1, nativeLog10)};
-    module->entries["random"] = Value{std::make_shared<NativeFunction>("random", 0, nativeRandom)};
-    module->entries["sin"] = Value{std::make_shared<NativeFunction>("sin", 1, nativeSin)};
-    module->entries["cos"] = Value{std::make_shared<NativeFunction>("cos", 1, nativeCos)};
-    module->entries["tan"] = Value{std::make_shared<NativeFunction>("tan", 1, nativeTan)};
-    module->entries["asin"] = Value{std::make_shared<NativeFunction>("asin", 1, nativeAsin)};
-    module->entries["acos"] = Value{std::make_shared<NativeFunction>("acos", 1, nativeAcos)};
-    module->entries["atan"] = Value{std::make_shared<NativeFunction>("atan", 1, nativeAtan)};
-    module->entries["atan2"] = Value{std::make_shared<NativeFunction>("atan2", 2, nativeAtan2)};
-    module->entries["hypot"] = Value{std::make_shared<NativeFunction>("hypot", -1, nativeHypot)};
-    module->entries["min"] = Value{std::make_shared<NativeFunction>("min", -1, nativeMin)};
-    module->entries["max"] = Value{std::make_shared<NativeFunction>("max", -1, nativeMax)};
-    module->entries["clamp"] = Value{std::make_shared<NativeFunction>("clamp", 3, nativeClamp)};
-    module->entries["sign"] = Value{std::make_shared<NativeFunction>("sign", 1, nativeSign)};
-    module->entries["isFinite"] = Value{std::make_shared<NativeFunction>("isFinite", 1, nativeIsFinite)};
-    module->entries["isNaN"] = Value{std::make_shared<NativeFunction>("isNaN", 1, nativeIsNaN)};
+    module->entries["sqrt"] = Value{makeRef<NativeFunction>("sqrt", 1, nativeSqrt)};
+    module->entries["pow"] = Value{makeRef<NativeFunction>("pow", 2, nativePow)};
+    module->entries["abs"] = Value{makeRef<NativeFunction>("abs", 1, nativeAbs)};
+    module->entries["floor"] = Value{makeRef<NativeFunction>("floor", 1, nativeFloor)};
+    module->entries["ceil"] = Value{makeRef<NativeFunction>("ceil", 1, nativeCeil)};
+    module->entries["round"] = Value{makeRef<NativeFunction>("round", 1, nativeRound)};
+    module->entries["trunc"] = Value{makeRef<NativeFunction>("trunc", 1, nativeTrunc)};
+    module->entries["log"] = Value{makeRef<NativeFunction>("log", 1, nativeLog)};
+    module->entries["log2"] = Value{makeRef<NativeFunction>("log2", 1, nativeLog2)};
+    module->entries["log10"] = Value{makeRef<NativeFunction>("log10", 1, nativeLog10)};
+    module->entries["random"] = Value{makeRef<NativeFunction>("random", 0, nativeRandom)};
+    module->entries["sin"] = Value{makeRef<NativeFunction>("sin", 1, nativeSin)};
+    module->entries["cos"] = Value{makeRef<NativeFunction>("cos", 1, nativeCos)};
+    module->entries["tan"] = Value{makeRef<NativeFunction>("tan", 1, nativeTan)};
+    module->entries["asin"] = Value{makeRef<NativeFunction>("asin", 1, nativeAsin)};
+    module->entries["acos"] = Value{makeRef<NativeFunction>("acos", 1, nativeAcos)};
+    module->entries["atan"] = Value{makeRef<NativeFunction>("atan", 1, nativeAtan)};
+    module->entries["atan2"] = Value{makeRef<NativeFunction>("atan2", 2, nativeAtan2)};
+    module->entries["hypot"] = Value{makeRef<NativeFunction>("hypot", -1, nativeHypot)};
+    module->entries["min"] = Value{makeRef<NativeFunction>("min", -1, nativeMin)};
+    module->entries["max"] = Value{makeRef<NativeFunction>("max", -1, nativeMax)};
+    module->entries["clamp"] = Value{makeRef<NativeFunction>("clamp", 3, nativeClamp)};
+    module->entries["sign"] = Value{makeRef<NativeFunction>("sign", 1, nativeSign)};
+    module->entries["isFinite"] = Value{makeRef<NativeFunction>("isFinite", 1, nativeIsFinite)};
+    module->entries["isNaN"] = Value{makeRef<NativeFunction>("isNaN", 1, nativeIsNaN)};
 
     return Value{module};
 }
 
 Value createStringModule(Interpreter& interp) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // String manipulation functions
-    module->entries["substring"] = Value{std::make_shared<NativeFunction>("substring", -1, nativeSubstring)};
-    module->entries["split"] = Value{std::make_shared<NativeFunction>("split", 2, nativeSplit)};
-    module->entries["join"] = Value{std::make_shared<NativeFunction>("join", 2, nativeJoin)};
-    module->entries["toUpper"] = Value{std::make_shared<NativeFunction>("toUpper", 1, nativeToUpper)};
-    module->entries["toLower"] = Value{std::make_shared<NativeFunction>("toLower", 1, nativeToLower)};
-    module->entries["trim"] = Value{std::make_shared<NativeFunction>("trim", 1, nativeTrim)};
-    module->entries["replace"] = Value{std::make_shared<NativeFunction>("replace", 3, nativeReplace)};
-    module->entries["startsWith"] = Value{std::make_shared<NativeFunction>("startsWith", 2, nativeStartsWith)};
-    module->entries["endsWith"] = Value{std::make_shared<NativeFunction>("endsWith", 2, nativeEndsWith)};
-    module->entries["indexOf"] = Value{std::make_shared<NativeFunction>("indexOf", 2, nativeIndexOf)};
-    module->entries["contains"] = Value{std::make_shared<NativeFunction>("contains", 2, nativeContains)};
+    module->entries["substring"] = Value{makeRef<NativeFunction>("substring", -1, nativeSubstring)};
+    module->entries["split"] = Value{makeRef<NativeFunction>("split", 2, nativeSplit)};
+    module->entries["join"] = Value{makeRef<NativeFunction>("join", 2, nativeJoin)};
+    module->entries["toUpper"] = Value{makeRef<NativeFunction>("toUpper", 1, nativeToUpper)};
+    module->entries["toLower"] = Value{makeRef<NativeFunction>("toLower", 1, nativeToLower)};
+    module->entries["trim"] = Value{makeRef<NativeFunction>("trim", 1, nativeTrim)};
+    module->entries["replace"] = Value{makeRef<NativeFunction>("replace", 3, nativeReplace)};
+    module->entries["startsWith"] = Value{makeRef<NativeFunction>("startsWith", 2, nativeStartsWith)};
+    module->entries["endsWith"] = Value{makeRef<NativeFunction>("endsWith", 2, nativeEndsWith)};
+    module->entries["indexOf"] = Value{makeRef<NativeFunction>("indexOf", 2, nativeIndexOf)};
+    module->entries["contains"] = Value{makeRef<NativeFunction>("contains", 2, nativeContains)};
 
     return Value{module};
 }
 
 Value createArrayModule(Interpreter& interp) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // Array manipulation functions
-    module->entries["map"] = Value{std::make_shared<NativeFunction>("map", 2, nativeMap)};
-    module->entries["filter"] = Value{std::make_shared<NativeFunction>("filter", 2, nativeFilter)};
-    module->entries["reduce"] = Value{std::make_shared<NativeFunction>("reduce", -1, nativeReduce)};
-    module->entries["sort"] = Value{std::make_shared<NativeFunction>("sort", -1, nativeSort)};
-    module->entries["reverse"] = Value{std::make_shared<NativeFunction>("reverse", 1, nativeReverse)};
-    module->entries["concat"] = Value{std::make_shared<NativeFunction>("concat", 2, nativeConcat)};
-    module->entries["slice"] = Value{std::make_shared<NativeFunction>("slice", -1, nativeSlice)};
-    module->entries["push"] = Value{std::make_shared<NativeFunction>("push", 2, nativePush)};
-    module->entries["pop"] = Value{std::make_shared<NativeFunction>("pop", 1, nativePop)};
-    module->entries["shift"] = Value{std::make_shared<NativeFunction>("shift", 1, nativeShift)};
-    module->entries["unshift"] = Value{std::make_shared<NativeFunction>("unshift", 2, nativeUnshift)};
-    module->entries["splice"] = Value{std::make_shared<NativeFunction>("splice", -1, nativeSplice)};
+    module->entries["map"] = Value{makeRef<NativeFunction>("map", 2, nativeMap)};
+    module->entries["filter"] = Value{makeRef<NativeFunction>("filter", 2, nativeFilter)};
+    module->entries["reduce"] = Value{makeRef<NativeFunction>("reduce", -1, nativeReduce)};
+    module->entries["sort"] = Value{makeRef<NativeFunction>("sort", -1, nativeSort)};
+    module->entries["reverse"] = Value{makeRef<NativeFunction>("reverse", 1, nativeReverse)};
+    module->entries["concat"] = Value{makeRef<NativeFunction>("concat", 2, nativeConcat)};
+    module->entries["slice"] = Value{makeRef<NativeFunction>("slice", -1, nativeSlice)};
+    module->entries["push"] = Value{makeRef<NativeFunction>("push", 2, nativePush)};
+    module->entries["pop"] = Value{makeRef<NativeFunction>("pop", 1, nativePop)};
+    module->entries["shift"] = Value{makeRef<NativeFunction>("shift", 1, nativeShift)};
+    module->entries["unshift"] = Value{makeRef<NativeFunction>("unshift", 2, nativeUnshift)};
+    module->entries["splice"] = Value{makeRef<NativeFunction>("splice", -1, nativeSplice)};
 
     return Value{module};
 }
 
 Value createIOModule(Interpreter& interp) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // I/O functions
-    module->entries["readFile"] = Value{std::make_shared<NativeFunction>("readFile", 1, nativeReadFile)};
-    module->entries["writeFile"] = Value{std::make_shared<NativeFunction>("writeFile", 2, nativeWriteFile)};
-    module->entries["appendFile"] = Value{std::make_shared<NativeFunction>("appendFile", 2, nativeAppendFile)};
-    module->entries["fileExists"] = Value{std::make_shared<NativeFunction>("fileExists", 1, nativeFileExists)};
-    module->entries["exists"] = Value{std::make_shared<NativeFunction>("exists", 1, nativeFileExists)};
+    module->entries["readFile"] = Value{makeRef<NativeFunction>("readFile", 1, nativeReadFile)};
+    module->entries["writeFile"] = Value{makeRef<NativeFunction>("writeFile", 2, nativeWriteFile)};
+    module->entries["appendFile"] = Value{makeRef<NativeFunction>("appendFile", 2, nativeAppendFile)};
+    module->entries["fileExists"] = Value{makeRef<NativeFunction>("fileExists", 1, nativeFileExists)};
+    module->entries["exists"] = Value{makeRef<NativeFunction>("exists", 1, nativeFileExists)};
 
     return Value{module};
 }
 
 Value createLogModule(Interpreter& interp) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // Logging functions
-    module->entries["info"] = Value{std::make_shared<NativeFunction>("info", 1, nativeLogInfo)};
-    module->entries["warn"] = Value{std::make_shared<NativeFunction>("warn", 1, nativeLogWarn)};
-    module->entries["error"] = Value{std::make_shared<NativeFunction>("error", 1, nativeLogError)};
-    module->entries["debug"] = Value{std::make_shared<NativeFunction>("debug", 1, nativeLogDebug)};
+    module->entries["info"] = Value{makeRef<NativeFunction>("info", 1, nativeLogInfo)};
+    module->entries["warn"] = Value{makeRef<NativeFunction>("warn", 1, nativeLogWarn)};
+    module->entries["error"] = Value{makeRef<NativeFunction>("error", 1, nativeLogError)};
+    module->entries["debug"] = Value{makeRef<NativeFunction>("debug", 1, nativeLogDebug)};
 
     return Value{module};
 }
 
 Value createAssertModule(Interpreter& interp) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // Assertion functions
-    module->entries["ok"] = Value{std::make_shared<NativeFunction>("ok", -1, nativeAssertOk)};
-    module->entries["eq"] = Value{std::make_shared<NativeFunction>("eq", 2, nativeAssertEq)};
-    module->entries["ne"] = Value{std::make_shared<NativeFunction>("ne", 2, nativeAssertNe)};
+    module->entries["ok"] = Value{makeRef<NativeFunction>("ok", -1, nativeAssertOk)};
+    module->entries["eq"] = Value{makeRef<NativeFunction>("eq", 2, nativeAssertEq)};
+    module->entries["ne"] = Value{makeRef<NativeFunction>("ne", 2, nativeAssertNe)};
 
     return Value{module};
 }
 
 Value createEnvModule(Interpreter& interp) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // Environment variable functions
-    module->entries["get"] = Value{std::make_shared<NativeFunction>("get", 1, nativeEnvGet)};
-    module->entries["set"] = Value{std::make_shared<NativeFunction>("set", 2, nativeEnvSet)};
-    module->entries["exists"] = Value{std::make_shared<NativeFunction>("exists", 1, nativeEnvExists)};
+    module->entries["get"] = Value{makeRef<NativeFunction>("get", 1, nativeEnvGet)};
+    module->entries["set"] = Value{makeRef<NativeFunction>("set", 2, nativeEnvSet)};
+    module->entries["exists"] = Value{makeRef<NativeFunction>("exists", 1, nativeEnvExists)};
 
     return Value{module};
 }
 
 Value createProcessModule(Interpreter& interp) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // Process control functions
-    module->entries["exit"] = Value{std::make_shared<NativeFunction>("exit", 1, nativeProcessExit)};
-    module->entries["status"] = Value{std::make_shared<NativeFunction>("status", 0, nativeProcessStatus)};
-    module->entries["args"] = Value{std::make_shared<NativeFunction>("args", 0, nativeProcessArgs)};
+    module->entries["exit"] = Value{makeRef<NativeFunction>("exit", 1, nativeProcessExit)};
+    module->entries["status"] = Value{makeRef<NativeFunction>("status", 0, nativeProcessStatus)};
+    module->entries["args"] = Value{makeRef<NativeFunction>("args", 0, nativeProcessArgs)};
 
     return Value{module};
 }
 
 Value createPathModule(Interpreter& interp) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // Path manipulation functions
-    module->entries["join"] = Value{std::make_shared<NativeFunction>("join", -1, nativePathJoin)};
-    module->entries["basename"] = Value{std::make_shared<NativeFunction>("basename", 1, nativePathBasename)};
-    module->entries["dirname"] = Value{std::make_shared<NativeFunction>("dirname", 1, nativePathDirname)};
-    module->entries["extname"] = Value{std::make_shared<NativeFunction>("extname", 1, nativePathExtname)};
-    module->entries["normalize"] = Value{std::make_shared<NativeFunction>("normalize", 1, nativePathNormalize)};
+    module->entries["join"] = Value{makeRef<NativeFunction>("join", -1, nativePathJoin)};
+    module->entries["basename"] = Value{makeRef<NativeFunction>("basename", 1, nativePathBasename)};
+    module->entries["dirname"] = Value{makeRef<NativeFunction>("dirname", 1, nativePathDirname)};
+    module->entries["extname"] = Value{makeRef<NativeFunction>("extname", 1, nativePathExtname)};
+    module->entries["normalize"] = Value{makeRef<NativeFunction>("normalize", 1, nativePathNormalize)};
 
     return Value{module};
 }
 
 Value createFsModule(Interpreter& interp) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // Filesystem functions
-    module->entries["exists"] = Value{std::make_shared<NativeFunction>("exists", 1, nativeFsExists)};
-    module->entries["read"] = Value{std::make_shared<NativeFunction>("read", 1, nativeFsRead)};
-    module->entries["write"] = Value{std::make_shared<NativeFunction>("write", 2, nativeFsWrite)};
-    module->entries["append"] = Value{std::make_shared<NativeFunction>("append", 2, nativeFsAppend)};
-    module->entries["remove"] = Value{std::make_shared<NativeFunction>("remove", 1, nativeFsRemove)};
+    module->entries["exists"] = Value{makeRef<NativeFunction>("exists", 1, nativeFsExists)};
+    module->entries["read"] = Value{makeRef<NativeFunction>("read", 1, nativeFsRead)};
+    module->entries["write"] = Value{makeRef<NativeFunction>("write", 2, nativeFsWrite)};
+    module->entries["append"] = Value{makeRef<NativeFunction>("append", 2, nativeFsAppend)};
+    module->entries["remove"] = Value{makeRef<NativeFunction>("remove", 1, nativeFsRemove)};
 
     return Value{module};
 }
 
 Value createHttpModule(Interpreter& interp) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // HTTP client functions
-    module->entries["get"] = Value{std::make_shared<NativeFunction>("get", 1, nativeHttpGet)};
+    module->entries["get"] = Value{makeRef<NativeFunction>("get", 1, nativeHttpGet)};
     // post accepts 2 required args (url, body) and 1 optional arg (contentType)
-    module->entries["post"] = Value{std::make_shared<NativeFunction>("post", -1, nativeHttpPost)};
-    module->entries["request"] = Value{std::make_shared<NativeFunction>("request", 1, nativeHttpRequest)};
+    module->entries["post"] = Value{makeRef<NativeFunction>("post", -1, nativeHttpPost)};
+    module->entries["request"] = Value{makeRef<NativeFunction>("request", 1, nativeHttpRequest)};
 
     return Value{module};
 }
 
 Value createNetModule(Interpreter& interp) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // TCP client/server functions
-    module->entries["connect"]    = Value{std::make_shared<NativeFunction>("connect", 2, nativeNetConnect)};
-    module->entries["listen"]     = Value{std::make_shared<NativeFunction>("listen", 1, nativeNetListen)};
-    module->entries["accept"]     = Value{std::make_shared<NativeFunction>("accept", -1, nativeNetAccept)};
-    module->entries["send"]       = Value{std::make_shared<NativeFunction>("send", 2, nativeNetSend)};
-    module->entries["recv"]       = Value{std::make_shared<NativeFunction>("recv", -1, nativeNetRecv)};
-    module->entries["close"]      = Value{std::make_shared<NativeFunction>("close", 1, nativeNetClose)};
-    module->entries["setTimeout"] = Value{std::make_shared<NativeFunction>("setTimeout", 2, nativeNetSetTimeout)};
+    module->entries["connect"]    = Value{makeRef<NativeFunction>("connect", 2, nativeNetConnect)};
+    module->entries["listen"]     = Value{makeRef<NativeFunction>("listen", 1, nativeNetListen)};
+    module->entries["accept"]     = Value{makeRef<NativeFunction>("accept", -1, nativeNetAccept)};
+    module->entries["send"]       = Value{makeRef<NativeFunction>("send", 2, nativeNetSend)};
+    module->entries["recv"]       = Value{makeRef<NativeFunction>("recv", -1, nativeNetRecv)};
+    module->entries["close"]      = Value{makeRef<NativeFunction>("close", 1, nativeNetClose)};
+    module->entries["setTimeout"] = Value{makeRef<NativeFunction>("setTimeout", 2, nativeNetSetTimeout)};
 
     return Value{module};
 }
 
 Value createIpcModule(Interpreter& interp) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // IPC functions
-    module->entries["createPipe"] = Value{std::make_shared<NativeFunction>("createPipe", 1, nativeIpcCreatePipe)};
-    module->entries["openRead"]   = Value{std::make_shared<NativeFunction>("openRead", 1, nativeIpcOpenRead)};
-    module->entries["openWrite"]  = Value{std::make_shared<NativeFunction>("openWrite", 1, nativeIpcOpenWrite)};
-    module->entries["send"]       = Value{std::make_shared<NativeFunction>("send", 2, nativeIpcSend)};
-    module->entries["recv"]       = Value{std::make_shared<NativeFunction>("recv", 1, nativeIpcRecv)};
-    module->entries["tryRecv"]    = Value{std::make_shared<NativeFunction>("tryRecv", 1, nativeIpcTryRecv)};
-    module->entries["close"]      = Value{std::make_shared<NativeFunction>("close", 1, nativeIpcClose)};
-    module->entries["removePipe"] = Value{std::make_shared<NativeFunction>("removePipe", 1, nativeIpcRemovePipe)};
+    module->entries["createPipe"] = Value{makeRef<NativeFunction>("createPipe", 1, nativeIpcCreatePipe)};
+    module->entries["openRead"]   = Value{makeRef<NativeFunction>("openRead", 1, nativeIpcOpenRead)};
+    module->entries["openWrite"]  = Value{makeRef<NativeFunction>("openWrite", 1, nativeIpcOpenWrite)};
+    module->entries["send"]       = Value{makeRef<NativeFunction>("send", 2, nativeIpcSend)};
+    module->entries["recv"]       = Value{makeRef<NativeFunction>("recv", 1, nativeIpcRecv)};
+    module->entries["tryRecv"]    = Value{makeRef<NativeFunction>("tryRecv", 1, nativeIpcTryRecv)};
+    module->entries["close"]      = Value{makeRef<NativeFunction>("close", 1, nativeIpcClose)};
+    module->entries["removePipe"] = Value{makeRef<NativeFunction>("removePipe", 1, nativeIpcRemovePipe)};
 
     return Value{module};
 }
 
 Value createTimeModule(Interpreter& interp) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // Time functions
-    module->entries["now"] = Value{std::make_shared<NativeFunction>("now", 0, nativeTimeNow)};
-    module->entries["sleep"] = Value{std::make_shared<NativeFunction>("sleep", 1, nativeTimeSleep)};
-    module->entries["format"] = Value{std::make_shared<NativeFunction>("format", -1, nativeTimeFormat)};
+    module->entries["now"] = Value{makeRef<NativeFunction>("now", 0, nativeTimeNow)};
+    module->entries["sleep"] = Value{makeRef<NativeFunction>("sleep", 1, nativeTimeSleep)};
+    module->entries["format"] = Value{makeRef<NativeFunction>("format", -1, nativeTimeFormat)};
 
     return Value{module};
 }
 
 Value createJsonModule(Interpreter& interp) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // JSON functions
-    module->entries["parse"] = Value{std::make_shared<NativeFunction>("parse", 1, nativeJsonParse)};
-    module->entries["stringify"] = Value{std::make_shared<NativeFunction>("stringify", 1, nativeJsonStringify)};
+    module->entries["parse"] = Value{makeRef<NativeFunction>("parse", 1, nativeJsonParse)};
+    module->entries["stringify"] = Value{makeRef<NativeFunction>("stringify", 1, nativeJsonStringify)};
 
     return Value{module};
 }
 
 Value createRegexModule(Interpreter& interp) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // Regex functions
-    module->entries["match"] = Value{std::make_shared<NativeFunction>("match", 2, nativeRegexMatch)};
-    module->entries["replace"] = Value{std::make_shared<NativeFunction>("replace", 3, nativeRegexReplace)};
-    module->entries["test"] = Value{std::make_shared<NativeFunction>("test", 2, nativeRegexTest)};
+    module->entries["match"] = Value{makeRef<NativeFunction>("match", 2, nativeRegexMatch)};
+    module->entries["replace"] = Value{makeRef<NativeFunction>("replace", 3, nativeRegexReplace)};
+    module->entries["test"] = Value{makeRef<NativeFunction>("test", 2, nativeRegexTest)};
 
     return Value{module};
 }
@@ -266,6 +266,7 @@ bool isNativeModule(const std::string& path) {
 }
 
 Value getNativeModule(const std::string& name, Interpreter& interp) {
+    TraceScope trace("module", "native module ", name);
     if (name == "math" || name == "std.math") {
         return createMathModule(interp);
     } else if (name == "string" || name == "std.string") {
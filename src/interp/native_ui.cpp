@@ -32,7 +32,7 @@ struct UiPanel {
 
 // Make a color Map value with r, g, b, a fields
 static Value makeColorValue(int r, int g, int b, int a = 255) {
-    auto m = std::make_shared<Map>();
+    auto m = makeRef<Map>();
     m->entries["r"] = static_cast<double>(r);
     m->entries["g"] = static_cast<double>(g);
     m->entries["b"] = static_cast<double>(b);
@@ -43,14 +43,14 @@ static Value makeColorValue(int r, int g, int b, int a = 255) {
 #ifdef HAVE_RAYLIB
 // Extract a raylib Color from a color Map value
 static ::Color extractRaylibColor(const Value& v) {
-    if (!std::holds_alternative<std::shared_ptr<Map>>(v)) {
+    if (!v.isMap()) {
         throw std::runtime_error("Expected a color value from ui.color().");
     }
-    auto m = std::get<std::shared_ptr<Map>>(v);
+    auto m = v.asMap();
     auto getChannel = [&](const std::string& key, int defaultValue) -> unsigned char {
         auto it = m->entries.find(key);
-        if (it != m->entries.end() && std::holds_alternative<double>(it->second)) {
-            return static_cast<unsigned char>(std::get<double>(it->second));
+        if (it != m->entries.end() && it->second.isNumber()) {
+            return static_cast<unsigned char>(it->second.asNumber());
         }
         return static_cast<unsigned char>(defaultValue);
     };
@@ -137,7 +137,7 @@ static Value nativeUiGetMousePosition(Interpreter& /*interp*/, const std::vector
     (void)args;
 #ifdef HAVE_RAYLIB
     ::Vector2 pos = GetMousePosition();
-    auto m = std::make_shared<Map>();
+    auto m = makeRef<Map>();
     m->entries["x"] = static_cast<double>(pos.x);
     m->entries["y"] = static_cast<double>(pos.y);
     return Value{m};
@@ -175,10 +175,10 @@ static Value nativeUiGetCharPressed(Interpreter& /*interp*/, const std::vector<V
 // ---------------------------------------------------------------------------
 
 static Value buildPanelObject(std::shared_ptr<UiPanel> panel) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
     // panel.begin() - activate scissor clipping for this panel
-    obj->entries["begin"] = Value{std::make_shared<NativeFunction>("begin", 0,
+    obj->entries["begin"] = Value{makeRef<NativeFunction>("begin", 0,
         [panel](Interpreter&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             BeginScissorMode(panel->x, panel->y, panel->width, panel->height);
@@ -187,7 +187,7 @@ static Value buildPanelObject(std::shared_ptr<UiPanel> panel) {
         })};
 
     // panel.end() - deactivate scissor clipping
-    obj->entries["end"] = Value{std::make_shared<NativeFunction>("end", 0,
+    obj->entries["end"] = Value{makeRef<NativeFunction>("end", 0,
         [](Interpreter&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             EndScissorMode();
@@ -196,9 +196,9 @@ static Value buildPanelObject(std::shared_ptr<UiPanel> panel) {
         })};
 
     // panel.getMousePosition() -> Map {x, y} in panel-local coordinates
-    obj->entries["getMousePosition"] = Value{std::make_shared<NativeFunction>("getMousePosition", 0,
+    obj->entries["getMousePosition"] = Value{makeRef<NativeFunction>("getMousePosition", 0,
         [panel](Interpreter&, const std::vector<Value>&) -> Value {
-            auto m = std::make_shared<Map>();
+            auto m = makeRef<Map>();
 #ifdef HAVE_RAYLIB
             ::Vector2 pos = GetMousePosition();
             m->entries["x"] = static_cast<double>(pos.x - panel->x);
@@ -211,7 +211,7 @@ static Value buildPanelObject(std::shared_ptr<UiPanel> panel) {
         })};
 
     // panel.containsMouse() -> bool
-    obj->entries["containsMouse"] = Value{std::make_shared<NativeFunction>("containsMouse", 0,
+    obj->entries["containsMouse"] = Value{makeRef<NativeFunction>("containsMouse", 0,
         [panel](Interpreter&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             ::Vector2 pos = GetMousePosition();
@@ -225,7 +225,7 @@ static Value buildPanelObject(std::shared_ptr<UiPanel> panel) {
         })};
 
     // panel.drawText(x, y, text, fontSize, color) - panel-local coordinates
-    obj->entries["drawText"] = Value{std::make_shared<NativeFunction>("drawText", 5,
+    obj->entries["drawText"] = Value{makeRef<NativeFunction>("drawText", 5,
         [panel](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 5) {
                 throw std::runtime_error(
@@ -234,8 +234,8 @@ static Value buildPanelObject(std::shared_ptr<UiPanel> panel) {
 #ifdef HAVE_RAYLIB
             int x = static_cast<int>(asNumber(args[0])) + panel->x;
             int y = static_cast<int>(asNumber(args[1])) + panel->y;
-            std::string text = std::holds_alternative<std::string>(args[2])
-                                   ? std::get<std::string>(args[2])
+            std::string text = args[2].isString()
+                                   ? args[2].asString()
                                    : valueToString(args[2]);
             int fontSize = static_cast<int>(asNumber(args[3]));
             ::Color color = extractRaylibColor(args[4]);
@@ -247,7 +247,7 @@ static Value buildPanelObject(std::shared_ptr<UiPanel> panel) {
         })};
 
     // panel.fillRect(x, y, width, height, color) - panel-local coordinates
-    obj->entries["fillRect"] = Value{std::make_shared<NativeFunction>("fillRect", 5,
+    obj->entries["fillRect"] = Value{makeRef<NativeFunction>("fillRect", 5,
         [panel](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 5) {
                 throw std::runtime_error(
@@ -267,7 +267,7 @@ static Value buildPanelObject(std::shared_ptr<UiPanel> panel) {
         })};
 
     // panel.drawRect(x, y, width, height, color) - panel-local coordinates
-    obj->entries["drawRect"] = Value{std::make_shared<NativeFunction>("drawRect", 5,
+    obj->entries["drawRect"] = Value{makeRef<NativeFunction>("drawRect", 5,
         [panel](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 5) {
                 throw std::runtime_error(
@@ -287,7 +287,7 @@ static Value buildPanelObject(std::shared_ptr<UiPanel> panel) {
         })};
 
     // panel.drawLine(x1, y1, x2, y2, thickness, color) - panel-local coordinates
-    obj->entries["drawLine"] = Value{std::make_shared<NativeFunction>("drawLine", 6,
+    obj->entries["drawLine"] = Value{makeRef<NativeFunction>("drawLine", 6,
         [panel](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 6) {
                 throw std::runtime_error(
@@ -309,7 +309,7 @@ static Value buildPanelObject(std::shared_ptr<UiPanel> panel) {
         })};
 
     // panel.drawCircle(x, y, radius, color) - panel-local coordinates
-    obj->entries["drawCircle"] = Value{std::make_shared<NativeFunction>("drawCircle", 4,
+    obj->entries["drawCircle"] = Value{makeRef<NativeFunction>("drawCircle", 4,
         [panel](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 4) {
                 throw std::runtime_error(
@@ -328,7 +328,7 @@ static Value buildPanelObject(std::shared_ptr<UiPanel> panel) {
         })};
 
     // panel.drawCircleLines(x, y, radius, color) - panel-local coordinates
-    obj->entries["drawCircleLines"] = Value{std::make_shared<NativeFunction>("drawCircleLines", 4,
+    obj->entries["drawCircleLines"] = Value{makeRef<NativeFunction>("drawCircleLines", 4,
         [panel](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 4) {
                 throw std::runtime_error(
@@ -347,7 +347,7 @@ static Value buildPanelObject(std::shared_ptr<UiPanel> panel) {
         })};
 
     // panel.fillRectRounded(x, y, width, height, roundness, color) - panel-local coordinates
-    obj->entries["fillRectRounded"] = Value{std::make_shared<NativeFunction>("fillRectRounded", 6,
+    obj->entries["fillRectRounded"] = Value{makeRef<NativeFunction>("fillRectRounded", 6,
         [panel](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 6) {
                 throw std::runtime_error(
@@ -368,7 +368,7 @@ static Value buildPanelObject(std::shared_ptr<UiPanel> panel) {
         })};
 
     // panel.drawRectRounded(x, y, width, height, roundness, color) - panel-local coordinates
-    obj->entries["drawRectRounded"] = Value{std::make_shared<NativeFunction>("drawRectRounded", 6,
+    obj->entries["drawRectRounded"] = Value{makeRef<NativeFunction>("drawRectRounded", 6,
         [panel](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 6) {
                 throw std::runtime_error(
@@ -389,15 +389,15 @@ static Value buildPanelObject(std::shared_ptr<UiPanel> panel) {
         })};
 
     // panel.measureText(text, fontSize) -> number
-    obj->entries["measureText"] = Value{std::make_shared<NativeFunction>("measureText", 2,
+    obj->entries["measureText"] = Value{makeRef<NativeFunction>("measureText", 2,
         [](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 2) {
                 throw std::runtime_error(
                     "panel.measureText() takes 2 arguments (text, fontSize).");
             }
 #ifdef HAVE_RAYLIB
-            std::string text = std::holds_alternative<std::string>(args[0])
-                                   ? std::get<std::string>(args[0])
+            std::string text = args[0].isString()
+                                   ? args[0].asString()
                                    : valueToString(args[0]);
             int fontSize = static_cast<int>(asNumber(args[1]));
             return static_cast<double>(MeasureText(text.c_str(), fontSize));
@@ -414,10 +414,10 @@ static Value buildPanelObject(std::shared_ptr<UiPanel> panel) {
 // ---------------------------------------------------------------------------
 
 static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
     // win.isOpen() -> bool
-    obj->entries["isOpen"] = Value{std::make_shared<NativeFunction>("isOpen", 0,
+    obj->entries["isOpen"] = Value{makeRef<NativeFunction>("isOpen", 0,
         [win](Interpreter&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             if (win->open) {
@@ -428,7 +428,7 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.close()
-    obj->entries["close"] = Value{std::make_shared<NativeFunction>("close", 0,
+    obj->entries["close"] = Value{makeRef<NativeFunction>("close", 0,
         [win](Interpreter&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             if (win->open) {
@@ -440,7 +440,7 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.beginDrawing()
-    obj->entries["beginDrawing"] = Value{std::make_shared<NativeFunction>("beginDrawing", 0,
+    obj->entries["beginDrawing"] = Value{makeRef<NativeFunction>("beginDrawing", 0,
         [](Interpreter&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             BeginDrawing();
@@ -451,7 +451,7 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.endDrawing()
-    obj->entries["endDrawing"] = Value{std::make_shared<NativeFunction>("endDrawing", 0,
+    obj->entries["endDrawing"] = Value{makeRef<NativeFunction>("endDrawing", 0,
         [](Interpreter&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             EndDrawing();
@@ -462,7 +462,7 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.clear(color)
-    obj->entries["clear"] = Value{std::make_shared<NativeFunction>("clear", 1,
+    obj->entries["clear"] = Value{makeRef<NativeFunction>("clear", 1,
         [](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1) {
                 throw std::runtime_error("win.clear() takes 1 argument.");
@@ -476,12 +476,12 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.setTitle(title)
-    obj->entries["setTitle"] = Value{std::make_shared<NativeFunction>("setTitle", 1,
+    obj->entries["setTitle"] = Value{makeRef<NativeFunction>("setTitle", 1,
         [win](Interpreter&, const std::vector<Value>& args) -> Value {
-            if (args.size() != 1 || !std::holds_alternative<std::string>(args[0])) {
+            if (args.size() != 1 || !args[0].isString()) {
                 throw std::runtime_error("win.setTitle() takes 1 string argument.");
             }
-            win->title = std::get<std::string>(args[0]);
+            win->title = args[0].asString();
 #ifdef HAVE_RAYLIB
             SetWindowTitle(win->title.c_str());
 #endif
@@ -489,9 +489,9 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.getSize() -> Map {width, height}
-    obj->entries["getSize"] = Value{std::make_shared<NativeFunction>("getSize", 0,
+    obj->entries["getSize"] = Value{makeRef<NativeFunction>("getSize", 0,
         [win](Interpreter&, const std::vector<Value>&) -> Value {
-            auto m = std::make_shared<Map>();
+            auto m = makeRef<Map>();
 #ifdef HAVE_RAYLIB
             win->width = GetScreenWidth();
             win->height = GetScreenHeight();
@@ -502,7 +502,7 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.getFps() -> int
-    obj->entries["getFps"] = Value{std::make_shared<NativeFunction>("getFps", 0,
+    obj->entries["getFps"] = Value{makeRef<NativeFunction>("getFps", 0,
         [](Interpreter&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             return static_cast<double>(GetFPS());
@@ -512,7 +512,7 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.setTargetFPS(fps) - set the target frames-per-second for the game loop
-    obj->entries["setTargetFPS"] = Value{std::make_shared<NativeFunction>("setTargetFPS", 1,
+    obj->entries["setTargetFPS"] = Value{makeRef<NativeFunction>("setTargetFPS", 1,
         [](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1) {
                 throw std::runtime_error("win.setTargetFPS() takes 1 argument (fps).");
@@ -526,7 +526,7 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.getFrameTime() -> float - get time in seconds for last frame drawn (delta time)
-    obj->entries["getFrameTime"] = Value{std::make_shared<NativeFunction>("getFrameTime", 0,
+    obj->entries["getFrameTime"] = Value{makeRef<NativeFunction>("getFrameTime", 0,
         [](Interpreter&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             return static_cast<double>(GetFrameTime());
@@ -536,7 +536,7 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.drawText(x, y, text, fontSize, color)
-    obj->entries["drawText"] = Value{std::make_shared<NativeFunction>("drawText", 5,
+    obj->entries["drawText"] = Value{makeRef<NativeFunction>("drawText", 5,
         [](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 5) {
                 throw std::runtime_error("win.drawText() takes 5 arguments (x, y, text, fontSize, color).");
@@ -544,8 +544,8 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
 #ifdef HAVE_RAYLIB
             int x = static_cast<int>(asNumber(args[0]));
             int y = static_cast<int>(asNumber(args[1]));
-            std::string text = std::holds_alternative<std::string>(args[2])
-                                   ? std::get<std::string>(args[2])
+            std::string text = args[2].isString()
+                                   ? args[2].asString()
                                    : valueToString(args[2]);
             int fontSize = static_cast<int>(asNumber(args[3]));
             ::Color color = extractRaylibColor(args[4]);
@@ -557,7 +557,7 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.drawRect(x, y, width, height, color)
-    obj->entries["drawRect"] = Value{std::make_shared<NativeFunction>("drawRect", 5,
+    obj->entries["drawRect"] = Value{makeRef<NativeFunction>("drawRect", 5,
         [](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 5) {
                 throw std::runtime_error("win.drawRect() takes 5 arguments (x, y, width, height, color).");
@@ -576,7 +576,7 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.fillRect(x, y, width, height, color)
-    obj->entries["fillRect"] = Value{std::make_shared<NativeFunction>("fillRect", 5,
+    obj->entries["fillRect"] = Value{makeRef<NativeFunction>("fillRect", 5,
         [](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 5) {
                 throw std::runtime_error("win.fillRect() takes 5 arguments (x, y, width, height, color).");
@@ -595,7 +595,7 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.drawLine(x1, y1, x2, y2, thickness, color)
-    obj->entries["drawLine"] = Value{std::make_shared<NativeFunction>("drawLine", 6,
+    obj->entries["drawLine"] = Value{makeRef<NativeFunction>("drawLine", 6,
         [](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 6) {
                 throw std::runtime_error("win.drawLine() takes 6 arguments (x1, y1, x2, y2, thickness, color).");
@@ -616,7 +616,7 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.drawCircle(x, y, radius, color)
-    obj->entries["drawCircle"] = Value{std::make_shared<NativeFunction>("drawCircle", 4,
+    obj->entries["drawCircle"] = Value{makeRef<NativeFunction>("drawCircle", 4,
         [](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 4) {
                 throw std::runtime_error("win.drawCircle() takes 4 arguments (x, y, radius, color).");
@@ -634,7 +634,7 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.drawCircleLines(x, y, radius, color)
-    obj->entries["drawCircleLines"] = Value{std::make_shared<NativeFunction>("drawCircleLines", 4,
+    obj->entries["drawCircleLines"] = Value{makeRef<NativeFunction>("drawCircleLines", 4,
         [](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 4) {
                 throw std::runtime_error("win.drawCircleLines() takes 4 arguments (x, y, radius, color).");
@@ -652,7 +652,7 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.fillRectRounded(x, y, width, height, roundness, color)
-    obj->entries["fillRectRounded"] = Value{std::make_shared<NativeFunction>("fillRectRounded", 6,
+    obj->entries["fillRectRounded"] = Value{makeRef<NativeFunction>("fillRectRounded", 6,
         [](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 6) {
                 throw std::runtime_error("win.fillRectRounded() takes 6 arguments (x, y, width, height, roundness, color).");
@@ -672,7 +672,7 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.drawRectRounded(x, y, width, height, roundness, color)
-    obj->entries["drawRectRounded"] = Value{std::make_shared<NativeFunction>("drawRectRounded", 6,
+    obj->entries["drawRectRounded"] = Value{makeRef<NativeFunction>("drawRectRounded", 6,
         [](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 6) {
                 throw std::runtime_error("win.drawRectRounded() takes 6 arguments (x, y, width, height, roundness, color).");
@@ -692,14 +692,14 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.measureText(text, fontSize) -> number
-    obj->entries["measureText"] = Value{std::make_shared<NativeFunction>("measureText", 2,
+    obj->entries["measureText"] = Value{makeRef<NativeFunction>("measureText", 2,
         [](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 2) {
                 throw std::runtime_error("win.measureText() takes 2 arguments (text, fontSize).");
             }
 #ifdef HAVE_RAYLIB
-            std::string text = std::holds_alternative<std::string>(args[0])
-                                   ? std::get<std::string>(args[0])
+            std::string text = args[0].isString()
+                                   ? args[0].asString()
                                    : valueToString(args[0]);
             int fontSize = static_cast<int>(asNumber(args[1]));
             return static_cast<double>(MeasureText(text.c_str(), fontSize));
@@ -709,7 +709,7 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.toggleFullscreen()
-    obj->entries["toggleFullscreen"] = Value{std::make_shared<NativeFunction>("toggleFullscreen", 0,
+    obj->entries["toggleFullscreen"] = Value{makeRef<NativeFunction>("toggleFullscreen", 0,
         [](Interpreter&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             ToggleFullscreen();
@@ -720,7 +720,7 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.isWindowFocused() -> bool
-    obj->entries["isWindowFocused"] = Value{std::make_shared<NativeFunction>("isWindowFocused", 0,
+    obj->entries["isWindowFocused"] = Value{makeRef<NativeFunction>("isWindowFocused", 0,
         [](Interpreter&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             return static_cast<bool>(IsWindowFocused());
@@ -730,7 +730,7 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.setWindowMinSize(width, height)
-    obj->entries["setWindowMinSize"] = Value{std::make_shared<NativeFunction>("setWindowMinSize", 2,
+    obj->entries["setWindowMinSize"] = Value{makeRef<NativeFunction>("setWindowMinSize", 2,
         [](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 2) {
                 throw std::runtime_error("win.setWindowMinSize() takes 2 arguments (width, height).");
@@ -744,7 +744,7 @@ static Value buildWindowObject(std::shared_ptr<UiWindow> win) {
         })};
 
     // win.createPanel(x, y, width, height) -> Panel
-    obj->entries["createPanel"] = Value{std::make_shared<NativeFunction>("createPanel", 4,
+    obj->entries["createPanel"] = Value{makeRef<NativeFunction>("createPanel", 4,
         [](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 4) {
                 throw std::runtime_error(
@@ -772,9 +772,9 @@ struct UiCamera2D {
 };
 
 static Value buildCamera2DObject(std::shared_ptr<UiCamera2D> cam) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
-    obj->entries["setTarget"] = Value{std::make_shared<NativeFunction>("setTarget", 2,
+    obj->entries["setTarget"] = Value{makeRef<NativeFunction>("setTarget", 2,
         [cam](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 2) {
                 throw std::runtime_error("camera.setTarget() takes 2 arguments (x, y).");
@@ -784,7 +784,7 @@ static Value buildCamera2DObject(std::shared_ptr<UiCamera2D> cam) {
             return Nil{};
         })};
 
-    obj->entries["setOffset"] = Value{std::make_shared<NativeFunction>("setOffset", 2,
+    obj->entries["setOffset"] = Value{makeRef<NativeFunction>("setOffset", 2,
         [cam](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 2) {
                 throw std::runtime_error("camera.setOffset() takes 2 arguments (x, y).");
@@ -794,7 +794,7 @@ static Value buildCamera2DObject(std::shared_ptr<UiCamera2D> cam) {
             return Nil{};
         })};
 
-    obj->entries["setRotation"] = Value{std::make_shared<NativeFunction>("setRotation", 1,
+    obj->entries["setRotation"] = Value{makeRef<NativeFunction>("setRotation", 1,
         [cam](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1) {
                 throw std::runtime_error("camera.setRotation() takes 1 argument (degrees).");
@@ -804,7 +804,7 @@ static Value buildCamera2DObject(std::shared_ptr<UiCamera2D> cam) {
             return Nil{};
         })};
 
-    obj->entries["setZoom"] = Value{std::make_shared<NativeFunction>("setZoom", 1,
+    obj->entries["setZoom"] = Value{makeRef<NativeFunction>("setZoom", 1,
         [cam](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 1) {
                 throw std::runtime_error("camera.setZoom() takes 1 argument (zoom).");
@@ -813,7 +813,7 @@ static Value buildCamera2DObject(std::shared_ptr<UiCamera2D> cam) {
             return Nil{};
         })};
 
-    obj->entries["beginMode"] = Value{std::make_shared<NativeFunction>("beginMode", 0,
+    obj->entries["beginMode"] = Value{makeRef<NativeFunction>("beginMode", 0,
         [cam](Interpreter&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             ::Camera2D c{};
@@ -828,7 +828,7 @@ static Value buildCamera2DObject(std::shared_ptr<UiCamera2D> cam) {
             return Nil{};
         })};
 
-    obj->entries["endMode"] = Value{std::make_shared<NativeFunction>("endMode", 0,
+    obj->entries["endMode"] = Value{makeRef<NativeFunction>("endMode", 0,
         [](Interpreter&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             EndMode2D();
@@ -838,12 +838,12 @@ static Value buildCamera2DObject(std::shared_ptr<UiCamera2D> cam) {
             return Nil{};
         })};
 
-    obj->entries["getWorldToScreen"] = Value{std::make_shared<NativeFunction>("getWorldToScreen", 2,
+    obj->entries["getWorldToScreen"] = Value{makeRef<NativeFunction>("getWorldToScreen", 2,
         [cam](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 2) {
                 throw std::runtime_error("camera.getWorldToScreen() takes 2 arguments (x, y).");
             }
-            auto m = std::make_shared<Map>();
+            auto m = makeRef<Map>();
 #ifdef HAVE_RAYLIB
             ::Camera2D c{};
             c.offset = {cam->offsetX, cam->offsetY};
@@ -862,12 +862,12 @@ static Value buildCamera2DObject(std::shared_ptr<UiCamera2D> cam) {
             return Value{m};
         })};
 
-    obj->entries["getScreenToWorld"] = Value{std::make_shared<NativeFunction>("getScreenToWorld", 2,
+    obj->entries["getScreenToWorld"] = Value{makeRef<NativeFunction>("getScreenToWorld", 2,
         [cam](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 2) {
                 throw std::runtime_error("camera.getScreenToWorld() takes 2 arguments (x, y).");
             }
-            auto m = std::make_shared<Map>();
+            auto m = makeRef<Map>();
 #ifdef HAVE_RAYLIB
             ::Camera2D c{};
             c.offset = {cam->offsetX, cam->offsetY};
@@ -905,19 +905,19 @@ struct UiTexture {
 };
 
 static Value buildTextureObject(std::shared_ptr<UiTexture> tex) {
-    auto obj = std::make_shared<Map>();
+    auto obj = makeRef<Map>();
 
-    obj->entries["getWidth"] = Value{std::make_shared<NativeFunction>("getWidth", 0,
+    obj->entries["getWidth"] = Value{makeRef<NativeFunction>("getWidth", 0,
         [tex](Interpreter&, const std::vector<Value>&) -> Value {
             return tex->loaded ? static_cast<double>(tex->texture.width) : 0.0;
         })};
 
-    obj->entries["getHeight"] = Value{std::make_shared<NativeFunction>("getHeight", 0,
+    obj->entries["getHeight"] = Value{makeRef<NativeFunction>("getHeight", 0,
         [tex](Interpreter&, const std::vector<Value>&) -> Value {
             return tex->loaded ? static_cast<double>(tex->texture.height) : 0.0;
         })};
 
-    obj->entries["draw"] = Value{std::make_shared<NativeFunction>("draw", 3,
+    obj->entries["draw"] = Value{makeRef<NativeFunction>("draw", 3,
         [tex](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 3) {
                 throw std::runtime_error("texture.draw() takes 3 arguments (x, y, tint).");
@@ -931,7 +931,7 @@ static Value buildTextureObject(std::shared_ptr<UiTexture> tex) {
             return Nil{};
         })};
 
-    obj->entries["drawEx"] = Value{std::make_shared<NativeFunction>("drawEx", 5,
+    obj->entries["drawEx"] = Value{makeRef<NativeFunction>("drawEx", 5,
         [tex](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 5) {
                 throw std::runtime_error(
@@ -948,7 +948,7 @@ static Value buildTextureObject(std::shared_ptr<UiTexture> tex) {
             return Nil{};
         })};
 
-    obj->entries["drawRec"] = Value{std::make_shared<NativeFunction>("drawRec", 4,
+    obj->entries["drawRec"] = Value{makeRef<NativeFunction>("drawRec", 4,
         [tex](Interpreter&, const std::vector<Value>& args) -> Value {
             if (args.size() != 4) {
                 throw std::runtime_error(
@@ -956,16 +956,16 @@ static Value buildTextureObject(std::shared_ptr<UiTexture> tex) {
                     "srcRec and position are {x, y, width, height} and {x, y} maps respectively.");
             }
             if (tex->loaded) {
-                if (!std::holds_alternative<std::shared_ptr<Map>>(args[0]) ||
-                    !std::holds_alternative<std::shared_ptr<Map>>(args[1])) {
+                if (!args[0].isMap() ||
+                    !args[1].isMap()) {
                     throw std::runtime_error("texture.drawRec(): srcRec and position must be maps.");
                 }
-                auto srcMap = std::get<std::shared_ptr<Map>>(args[0]);
-                auto posMap = std::get<std::shared_ptr<Map>>(args[1]);
-                auto getNum = [](const std::shared_ptr<Map>& m, const std::string& k) -> float {
+                auto srcMap = args[0].asMap();
+                auto posMap = args[1].asMap();
+                auto getNum = [](const Ref<Map>& m, const std::string& k) -> float {
                     auto it = m->entries.find(k);
-                    return (it != m->entries.end() && std::holds_alternative<double>(it->second))
-                               ? static_cast<float>(std::get<double>(it->second))
+                    return (it != m->entries.end() && it->second.isNumber())
+                               ? static_cast<float>(it->second.asNumber())
                                : 0.0f;
                 };
                 ::Rectangle src{getNum(srcMap, "x"), getNum(srcMap, "y"),
@@ -978,7 +978,7 @@ static Value buildTextureObject(std::shared_ptr<UiTexture> tex) {
             return Nil{};
         })};
 
-    obj->entries["unload"] = Value{std::make_shared<NativeFunction>("unload", 0,
+    obj->entries["unload"] = Value{makeRef<NativeFunction>("unload", 0,
         [tex](Interpreter&, const std::vector<Value>&) -> Value {
             if (tex->loaded) {
                 UnloadTexture(tex->texture);
@@ -1013,11 +1013,11 @@ static Value nativeUiCreateCamera2D(Interpreter& /*interp*/, const std::vector<V
 // ui.loadTexture(path) -> texture object
 // ---------------------------------------------------------------------------
 static Value nativeUiLoadTexture(Interpreter& /*interp*/, const std::vector<Value>& args) {
-    if (args.size() != 1 || !std::holds_alternative<std::string>(args[0])) {
+    if (args.size() != 1 || !args[0].isString()) {
         throw std::runtime_error("ui.loadTexture() takes 1 string argument (path).");
     }
 #ifdef HAVE_RAYLIB
-    const std::string& path = std::get<std::string>(args[0]);
+    const std::string& path = args[0].asString();
     auto tex = std::make_shared<UiTexture>();
     tex->texture = LoadTexture(path.c_str());
     tex->loaded = true;
@@ -1034,10 +1034,10 @@ static Value nativeUiCreateWindow(Interpreter& /*interp*/, const std::vector<Val
     if (args.size() != 3) {
         throw std::runtime_error("ui.createWindow() takes 3 arguments (title, width, height).");
     }
-    if (!std::holds_alternative<std::string>(args[0])) {
+    if (!args[0].isString()) {
         throw std::runtime_error("ui.createWindow(): title must be a string.");
     }
-    std::string title = std::get<std::string>(args[0]);
+    std::string title = args[0].asString();
     int width = static_cast<int>(asNumber(args[1]));
     int height = static_cast<int>(asNumber(args[2]));
     auto win = std::make_shared<UiWindow>();
@@ -1064,39 +1064,39 @@ static Value nativeUiCreateWindow(Interpreter& /*interp*/, const std::vector<Val
 // Build the top-level ui module Map
 // ---------------------------------------------------------------------------
 Value createUiModule(Interpreter& interp) {
-    auto module = std::make_shared<Map>();
+    auto module = makeRef<Map>();
 
     // Window creation
     module->entries["createWindow"] =
-        Value{std::make_shared<NativeFunction>("createWindow", 3, nativeUiCreateWindow)};
+        Value{makeRef<NativeFunction>("createWindow", 3, nativeUiCreateWindow)};
 
     // Color
-    module->entries["color"] = Value{std::make_shared<NativeFunction>("color", -1, nativeUiColor)};
+    module->entries["color"] = Value{makeRef<NativeFunction>("color", -1, nativeUiColor)};
 
     // Keyboard input
-    module->entries["keyDown"] = Value{std::make_shared<NativeFunction>("keyDown", 1, nativeUiKeyDown)};
-    module->entries["keyPressed"] = Value{std::make_shared<NativeFunction>("keyPressed", 1, nativeUiKeyPressed)};
+    module->entries["keyDown"] = Value{makeRef<NativeFunction>("keyDown", 1, nativeUiKeyDown)};
+    module->entries["keyPressed"] = Value{makeRef<NativeFunction>("keyPressed", 1, nativeUiKeyPressed)};
 
     // Mouse input
-    module->entries["mouseDown"] = Value{std::make_shared<NativeFunction>("mouseDown", 1, nativeUiMouseDown)};
-    module->entries["mousePressed"] = Value{std::make_shared<NativeFunction>("mousePressed", 1, nativeUiMousePressed)};
+    module->entries["mouseDown"] = Value{makeRef<NativeFunction>("mouseDown", 1, nativeUiMouseDown)};
+    module->entries["mousePressed"] = Value{makeRef<NativeFunction>("mousePressed", 1, nativeUiMousePressed)};
     module->entries["getMousePosition"] =
-        Value{std::make_shared<NativeFunction>("getMousePosition", 0, nativeUiGetMousePosition)};
+        Value{makeRef<NativeFunction>("getMousePosition", 0, nativeUiGetMousePosition)};
     module->entries["getMouseWheelMove"] =
-        Value{std::make_shared<NativeFunction>("getMouseWheelMove", 0, nativeUiGetMouseWheelMove)};
+        Value{makeRef<NativeFunction>("getMouseWheelMove", 0, nativeUiGetMouseWheelMove)};
     module->entries["getCharPressed"] =
-        Value{std::make_shared<NativeFunction>("getCharPressed", 0, nativeUiGetCharPressed)};
+        Value{makeRef<NativeFunction>("getCharPressed", 0, nativeUiGetCharPressed)};
 
     // Camera 2D
     module->entries["createCamera2D"] =
-        Value{std::make_shared<NativeFunction>("createCamera2D", 6, nativeUiCreateCamera2D)};
+        Value{makeRef<NativeFunction>("createCamera2D", 6, nativeUiCreateCamera2D)};
 
     // Texture loading
     module->entries["loadTexture"] =
-        Value{std::make_shared<NativeFunction>("loadTexture", 1, nativeUiLoadTexture)};
+        Value{makeRef<NativeFunction>("loadTexture", 1, nativeUiLoadTexture)};
 
     // ui.getTime() -> number  (seconds since window was initialized)
-    module->entries["getTime"] = Value{std::make_shared<NativeFunction>("getTime", 0,
+    module->entries["getTime"] = Value{makeRef<NativeFunction>("getTime", 0,
         [](Interpreter&, const std::vector<Value>&) -> Value {
 #ifdef HAVE_RAYLIB
             return static_cast<double>(GetTime());
@@ -1107,7 +1107,7 @@ Value createUiModule(Interpreter& interp) {
 
     // Key constants sub-map
     {
-        auto keys = std::make_shared<Map>();
+        auto keys = makeRef<Map>();
 #ifdef HAVE_RAYLIB
         keys->entries["escape"] = static_cast<double>(KEY_ESCAPE);
         keys->entries["enter"] = static_cast<double>(KEY_ENTER);
@@ -1225,7 +1225,7 @@ Value createUiModule(Interpreter& interp) {
 
     // Mouse button constants sub-map
     {
-        auto mouse = std::make_shared<Map>();
+        auto mouse = makeRef<Map>();
 #ifdef HAVE_RAYLIB
         mouse->entries["left"] = static_cast<double>(MOUSE_BUTTON_LEFT);
         mouse->entries["right"] = static_cast<double>(MOUSE_BUTTON_RIGHT);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common/profiler.hpp"
+#include "interpreter.hpp"
+
+namespace izi {
+
+// DebugHook that feeds the interpreter's call stack to a Profiler: it keeps
+// the name and current line of every active function and records them at
+// the first statement after each timer tick.
+class ProfilerHook : public DebugHook {
+   public:
+    explicit ProfilerHook(Profiler& profiler) : profiler_(profiler) { stack_.push_back({"<script>", 0}); }
+
+    void onStatement(int line, const std::string& /*file*/) override {
+        stack_.back().line = line;
+        if (Profiler::pending()) {
+            profiler_.beginSample();
+            for (const auto& frame : stack_) {
+                profiler_.addFrame(frame.name, frame.line);
+            }
+            profiler_.endSample();
+        }
+    }
+
+    void onFunctionEnter(const std::string& name, int line, const std::string& /*file*/) override {
+        stack_.push_back({name, line});
+    }
+
+    void onFunctionExit() override {
+        if (stack_.size() > 1) {
+            stack_.pop_back();
+        }
+    }
+
+   private:
+    struct Frame {
+        std::string name;
+        int line;
+    };
+
+    Profiler& profiler_;
+    std::vector<Frame> stack_;  // Outermost first; the script is always at the bottom
+};
+
+}  // namespace izi
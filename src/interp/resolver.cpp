@@ -0,0 +1,425 @@
+#include "resolver.hpp"
+
+#include <algorithm>
+
+#include "ast/pattern.hpp"
+#include "environment.hpp"
+
+namespace izi {
+
+void Resolver::resolve(const std::vector<StmtPtr>& program) {
+    // Reserve the top level's declarations first: function bodies may use
+    // names declared further down, and code before a declaration must find
+    // its slot still undefined rather than miss it
+    for (const auto& stmt : program) {
+        Stmt* decl = stmt.get();
+        if (auto* exportStmt = dynamic_cast<ExportStmt*>(decl)) {
+            decl = exportStmt->declaration.get();
+        }
+        if (auto* varStmt = dynamic_cast<VarStmt*>(decl)) {
+            if (varStmt->pattern) {
+                declarePattern(varStmt->pattern.get());
+            } else {
+                declare(varStmt->name);
+            }
+        } else if (auto* fnStmt = dynamic_cast<FunctionStmt*>(decl)) {
+            declare(fnStmt->name);
+        } else if (auto* classStmt = dynamic_cast<ClassStmt*>(decl)) {
+            declare(classStmt->name);
+        }
+    }
+
+    for (const auto& stmt : program) {
+        resolve(stmt.get());
+    }
+    runDeferred(deferredTop_);
+}
+
+void Resolver::beginScope(ScopeLayout& layout) {
+    layout.names.clear();
+    layout.late.clear();
+    layout.captured = false;
+    scopes_.push_back(Scope{&layout, {}});
+}
+
+void Resolver::endScope() {
+    runDeferred(scopes_.back().deferred);
+    scopes_.pop_back();
+}
+
+void Resolver::runDeferred(std::vector<std::function<void()>>& deferred) {
+    // Bodies are resolved with the declaring scope still innermost; each
+    // defers its own nested functions to its own scope
+    std::vector<std::function<void()>> pending;
+    pending.swap(deferred);
+    for (auto& body : pending) {
+        body();
+    }
+}
+
+void Resolver::capture() {
+    // A closure created here holds on to every enclosing environment
+    for (auto& scope : scopes_) {
+        scope.layout->captured = true;
+    }
+}
+
+void Resolver::defer(std::function<void()> body) {
+    // The body is resolved with the same scopes enclosing it, but they will
+    // have declared the rest of their names by then
+    std::vector<size_t> declaredBefore;
+    declaredBefore.reserve(scopes_.size());
+    for (const auto& scope : scopes_) {
+        declaredBefore.push_back(std::min(scope.declaredBefore, scope.layout->names.size()));
+    }
+    auto resolveBody = [this, declaredBefore = std::move(declaredBefore), body = std::move(body)]() mutable {
+        for (size_t i = 0; i < declaredBefore.size(); ++i) {
+            std::swap(scopes_[i].declaredBefore, declaredBefore[i]);
+        }
+        body();
+        for (size_t i = 0; i < declaredBefore.size(); ++i) {
+            std::swap(scopes_[i].declaredBefore, declaredBefore[i]);
+        }
+    };
+    if (scopes_.empty()) {
+        deferredTop_.push_back(std::move(resolveBody));
+    } else {
+        scopes_.back().deferred.push_back(std::move(resolveBody));
+    }
+}
+
+uint32_t Resolver::declare(const std::string& name) {
+    if (scopes_.empty()) {
+        return top_->reserve(name);
+    }
+    auto& names = scopes_.back().layout->names;
+    for (size_t i = names.size(); i-- > 0;) {
+        if (names[i] == name) {
+            return static_cast<uint32_t>(i);
+        }
+    }
+    names.push_back(name);
+    return static_cast<uint32_t>(names.size() - 1);
+}
+
+void Resolver::declarePattern(const Pattern* pattern) {
+    if (auto* arrayPattern = dynamic_cast<const ArrayPattern*>(pattern)) {
+        for (const auto& element : arrayPattern->elements) {
+            if (auto* varPattern = dynamic_cast<const VariablePattern*>(element.get())) {
+                declare(varPattern->name);
+            }
+        }
+    } else if (auto* mapPattern = dynamic_cast<const MapPattern*>(pattern)) {
+        for (const auto& key : mapPattern->keys) {
+            declare(key);
+        }
+    }
+}
+
+VarSlot Resolver::lookup(const std::string& name) {
+    for (size_t scope = scopes_.size(); scope-- > 0;) {
+        ScopeLayout& layout = *scopes_[scope].layout;
+        for (size_t i = layout.names.size(); i-- > 0;) {
+            if (layout.names[i] == name) {
+                // Declared after the function being resolved: the slot may
+                // not be defined yet when the function runs
+                bool late = i >= scopes_[scope].declaredBefore;
+                if (late) {
+                    layout.late.resize(layout.names.size());
+                    layout.late[i] = true;
+                }
+                return VarSlot{static_cast<uint32_t>(scopes_.size() - 1 - scope), static_cast<uint32_t>(i), late};
+            }
+        }
+    }
+    uint32_t depth = static_cast<uint32_t>(scopes_.size());
+    for (const Environment* env = top_; env; env = env->getParent(), ++depth) {
+        uint32_t slot = env->find(name);
+        if (slot != NO_SLOT) {
+            return VarSlot{depth, slot, true};
+        }
+    }
+    return VarSlot{};
+}
+
+void Resolver::resolveFunction(const std::vector<std::string>& params, const std::vector<StmtPtr>& body,
+                               ScopeLayout& scope) {
+    beginScope(scope);
+    // Parameters take the first slots in order, even when a name repeats
+    for (const auto& param : params) {
+        scope.names.push_back(param);
+    }
+    for (const auto& stmt : body) {
+        resolve(stmt.get());
+    }
+    endScope();
+}
+
+void Resolver::resolve(Expr* expr) {
+    if (expr) {
+        expr->accept(*this);
+    }
+}
+
+void Resolver::resolve(Stmt* stmt) {
+    if (stmt) {
+        stmt->accept(*this);
+    }
+}
+
+// Expressions
+
+Value Resolver::visit(BinaryExpr& expr) {
+    resolve(expr.left.get());
+    resolve(expr.right.get());
+    return Nil{};
+}
+
+Value Resolver::visit(UnaryExpr& expr) {
+    resolve(expr.right.get());
+    return Nil{};
+}
+
+Value Resolver::visit(LiteralExpr& /*expr*/) {
+    return Nil{};
+}
+
+Value Resolver::visit(GroupingExpr& expr) {
+    resolve(expr.expression.get());
+    return Nil{};
+}
+
+Value Resolver::visit(ConditionalExpr& expr) {
+    resolve(expr.condition.get());
+    resolve(expr.thenBranch.get());
+    resolve(expr.elseBranch.get());
+    return Nil{};
+}
+
+Value Resolver::visit(CallExpr& expr) {
+    resolve(expr.callee.get());
+    for (const auto& arg : expr.args) {
+        resolve(arg.get());
+    }
+    return Nil{};
+}
+
+Value Resolver::visit(VariableExpr& expr) {
+    resolve(expr.value.get());
+    expr.slot = lookup(expr.name);
+    return Nil{};
+}
+
+Value Resolver::visit(AssignExpr& expr) {
+    resolve(expr.value.get());
+    expr.slot = lookup(expr.name);
+    return Nil{};
+}
+
+Value Resolver::visit(ArrayExpr& expr) {
+    for (const auto& element : expr.elements) {
+        resolve(element.get());
+    }
+    return Nil{};
+}
+
+Value Resolver::visit(MapExpr& expr) {
+    for (const auto& [key, value] : expr.entries) {
+        resolve(value.get());
+    }
+    return Nil{};
+}
+
+Value Resolver::visit(SpreadExpr& expr) {
+    resolve(expr.argument.get());
+    return Nil{};
+}
+
+Value Resolver::visit(IndexExpr& expr) {
+    resolve(expr.collection.get());
+    resolve(expr.index.get());
+    return Nil{};
+}
+
+Value Resolver::visit(SetIndexExpr& expr) {
+    resolve(expr.collection.get());
+    resolve(expr.index.get());
+    resolve(expr.value.get());
+    return Nil{};
+}
+
+Value Resolver::visit(FunctionExpr& expr) {
+    capture();
+    defer([this, &expr] { resolveFunction(expr.params, expr.body, expr.scope); });
+    return Nil{};
+}
+
+Value Resolver::visit(MatchExpr& expr) {
+    resolve(expr.value.get());
+    for (auto& matchCase : expr.cases) {
+        // The guard and the result each get an environment holding the
+        // pattern's binding; both have the same layout
+        beginScope(matchCase.scope);
+        if (auto* variable = dynamic_cast<VariablePattern*>(matchCase.pattern.get())) {
+            declare(variable->name);
+        }
+        resolve(matchCase.guard.get());
+        resolve(matchCase.result.get());
+        endScope();
+    }
+    return Nil{};
+}
+
+Value Resolver::visit(PropertyExpr& expr) {
+    resolve(expr.object.get());
+    return Nil{};
+}
+
+Value Resolver::visit(SetPropertyExpr& expr) {
+    resolve(expr.object.get());
+    resolve(expr.value.get());
+    return Nil{};
+}
+
+Value Resolver::visit(ThisExpr& expr) {
+    expr.slot = lookup("this");
+    return Nil{};
+}
+
+Value Resolver::visit(SuperExpr& expr) {
+    expr.superSlot = lookup("super");
+    expr.thisSlot = lookup("this");
+    return Nil{};
+}
+
+Value Resolver::visit(AwaitExpr& expr) {
+    resolve(expr.value.get());
+    return Nil{};
+}
+
+// Statements
+
+void Resolver::visit(ExprStmt& stmt) {
+    resolve(stmt.expr.get());
+}
+
+void Resolver::visit(BlockStmt& stmt) {
+    beginScope(stmt.scope);
+    for (const auto& inner : stmt.statements) {
+        resolve(inner.get());
+    }
+    endScope();
+}
+
+void Resolver::visit(VarStmt& stmt) {
+    // The initializer runs before the name exists in this scope
+    resolve(stmt.initializer.get());
+    if (stmt.pattern) {
+        declarePattern(stmt.pattern.get());
+    } else {
+        stmt.slot = declare(stmt.name);
+    }
+}
+
+void Resolver::visit(WhileStmt& stmt) {
+    resolve(stmt.condition.get());
+    resolve(stmt.body.get());
+}
+
+void Resolver::visit(IfStmt& stmt) {
+    resolve(stmt.condition.get());
+    resolve(stmt.thenBranch.get());
+    resolve(stmt.elseBranch.get());
+}
+
+void Resolver::visit(FunctionStmt& stmt) {
+    stmt.slot = declare(stmt.name);
+    capture();
+    defer([this, &stmt] { resolveFunction(stmt.params, stmt.body, stmt.scope); });
+}
+
+void Resolver::visit(ReturnStmt& stmt) {
+    resolve(stmt.value.get());
+}
+
+void Resolver::visit(ImportStmt& stmt) {
+    // A simple import of a file runs the module's top level in this scope:
+    // it defines whatever the module declares, which is only known once it
+    // runs and is found by name, and its functions capture the scope
+    if (!stmt.isWildcard && stmt.namedImports.empty()) {
+        capture();
+    }
+    if (stmt.isWildcard) {
+        declare(stmt.wildcardAlias);
+    }
+    for (size_t i = 0; i < stmt.namedImports.size(); ++i) {
+        bool aliased = i < stmt.namedAliases.size() && !stmt.namedAliases[i].empty();
+        declare(aliased ? stmt.namedAliases[i] : stmt.namedImports[i]);
+    }
+}
+
+void Resolver::visit(ExportStmt& stmt) {
+    resolve(stmt.declaration.get());
+    resolve(stmt.defaultExpr.get());
+}
+
+void Resolver::visit(ReExportStmt& /*stmt*/) {}
+
+void Resolver::visit(BreakStmt& /*stmt*/) {}
+
+void Resolver::visit(ContinueStmt& /*stmt*/) {}
+
+void Resolver::visit(TryStmt& stmt) {
+    resolve(stmt.tryBlock.get());
+    // The catch block's statements run directly in the environment that
+    // holds the caught value
+    if (auto* block = dynamic_cast<BlockStmt*>(stmt.catchBlock.get())) {
+        beginScope(stmt.catchScope);
+        if (!stmt.catchVariable.empty()) {
+            declare(stmt.catchVariable);
+        }
+        for (const auto& inner : block->statements) {
+            resolve(inner.get());
+        }
+        endScope();
+    }
+    resolve(stmt.finallyBlock.get());
+}
+
+void Resolver::visit(ThrowStmt& stmt) {
+    resolve(stmt.value.get());
+}
+
+void Resolver::visit(ClassStmt& stmt) {
+    if (!stmt.superclass.empty()) {
+        stmt.superclassSlot = lookup(stmt.superclass);
+    }
+    for (const auto& field : stmt.fields) {
+        resolve(field->initializer.get());
+    }
+    stmt.slot = declare(stmt.name);
+    capture();
+
+    // A method runs in its call environment, inside the bound method's
+    // `this` environment, inside the subclass's `super` environment
+    bool hasSuper = !stmt.superclass.empty();
+    defer([this, &stmt, hasSuper] {
+        for (const auto& method : stmt.methods) {
+            ScopeLayout superScope;
+            ScopeLayout thisScope;
+            if (hasSuper) {
+                beginScope(superScope);
+                declare("super");
+            }
+            beginScope(thisScope);
+            declare("this");
+            resolveFunction(method->params, method->body, method->scope);
+            endScope();
+            if (hasSuper) {
+                endScope();
+            }
+        }
+    });
+}
+
+}  // namespace izi
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "ast/expr.hpp"
+#include "ast/stmt.hpp"
+#include "ast/visitor.hpp"
+
+namespace izi {
+
+class Environment;
+
+// Static scope resolution for the tree-walking interpreter.
+//
+// Runs over a program before it executes and mirrors the environments the
+// Interpreter creates for it: one per block, function call, catch clause and
+// match arm, plus the `this` and `super` scopes around class methods.  The
+// names each scope declares get slots in its ScopeLayout, and every variable
+// reference is annotated with how many environments out its variable lives
+// and at which slot, so that reading it indexes arrays instead of hashing the
+// name at every level.
+//
+// The program's top level runs in an existing environment (the globals, a
+// module's scope), so its declarations get named slots reserved there, and
+// references that leave the innermost scope resolve against that environment
+// and its parents.  Names found nowhere stay unresolved and are looked up by
+// name at run time, as imports and natives registered later may define them.
+//
+// Function bodies are resolved when the scope declaring them ends, so that
+// they see every name the scope declares, as they do when they are called.
+// A name an enclosing scope declares after the function may still be
+// undefined when it is called, and the function then reads the name from
+// further out: such references are checked, and the slots marked late.
+//
+// Scopes that create closures are marked captured; the others' environments
+// are recycled as soon as they end (see EnvironmentArena).
+class Resolver : public ExprVisitor, public StmtVisitor {
+   public:
+    explicit Resolver(Environment* top) : top_(top) {}
+
+    void resolve(const std::vector<StmtPtr>& program);
+
+    // ExprVisitor
+    Value visit(BinaryExpr& expr) override;
+    Value visit(UnaryExpr& expr) override;
+    Value visit(LiteralExpr& expr) override;
+    Value visit(GroupingExpr& expr) override;
+    Value visit(ConditionalExpr& expr) override;
+    Value visit(CallExpr& expr) override;
+    Value visit(VariableExpr& expr) override;
+    Value visit(AssignExpr& expr) override;
+    Value visit(ArrayExpr& expr) override;
+    Value visit(MapExpr& expr) override;
+    Value visit(SpreadExpr& expr) override;
+    Value visit(IndexExpr& expr) override;
+    Value visit(SetIndexExpr& expr) override;
+    Value visit(FunctionExpr& expr) override;
+    Value visit(MatchExpr& expr) override;
+    Value visit(PropertyExpr& expr) override;
+    Value visit(SetPropertyExpr& expr) override;
+    Value visit(ThisExpr& expr) override;
+    Value visit(SuperExpr& expr) override;
+    Value visit(AwaitExpr& expr) override;
+
+    // StmtVisitor
+    void visit(ExprStmt& stmt) override;
+    void visit(BlockStmt& stmt) override;
+    void visit(VarStmt& stmt) override;
+    void visit(WhileStmt& stmt) override;
+    void visit(IfStmt& stmt) override;
+    void visit(FunctionStmt& stmt) override;
+    void visit(ReturnStmt& stmt) override;
+    void visit(ImportStmt& stmt) override;
+    void visit(ExportStmt& stmt) override;
+    void visit(ReExportStmt& stmt) override;
+    void visit(BreakStmt& stmt) override;
+    void visit(ContinueStmt& stmt) override;
+    void visit(TryStmt& stmt) override;
+    void visit(ThrowStmt& stmt) override;
+    void visit(ClassStmt& stmt) override;
+
+   private:
+    struct Scope {
+        ScopeLayout* layout;
+        std::vector<std::function<void()>> deferred;  // Function bodies declared here
+        // While a function body is resolved: how many of the names were
+        // declared before the function was
+        size_t declaredBefore = SIZE_MAX;
+    };
+
+    Environment* top_;
+    std::vector<Scope> scopes_;
+    std::vector<std::function<void()>> deferredTop_;
+
+    void beginScope(ScopeLayout& layout);
+    void endScope();
+    void runDeferred(std::vector<std::function<void()>>& deferred);
+    void capture();
+    void defer(std::function<void()> body);
+
+    // Slot of `name` in the innermost scope, adding it if needed
+    uint32_t declare(const std::string& name);
+    void declarePattern(const Pattern* pattern);
+    VarSlot lookup(const std::string& name);
+
+    void resolveFunction(const std::vector<std::string>& params, const std::vector<StmtPtr>& body,
+                         ScopeLayout& scope);
+    void resolve(Expr* expr);
+    void resolve(Stmt* stmt);
+};
+
+}  // namespace izi
@@ -1,12 +1,15 @@
 #include "user_function.hpp"
 #include "interpreter.hpp"
+#include "common/trace.hpp"
+
+#include <algorithm>
 
 namespace izi {
 
 // Helper: create a bound callable (function + captured args) as a Task
 class BoundCall : public Callable {
    public:
-    BoundCall(std::shared_ptr<Callable> fn, std::vector<Value> args)
+    BoundCall(Ref<Callable> fn, std::vector<Value> args)
         : fn_(std::move(fn)), args_(std::move(args)) {}
 
     int arity() const override { return 0; }
@@ -17,7 +20,7 @@ class BoundCall : public Callable {
     }
 
    private:
-    std::shared_ptr<Callable> fn_;
+    Ref<Callable> fn_;
     std::vector<Value> args_;
 };
 
@@ -27,39 +30,51 @@ Value UserFunction::call(Interpreter& interp, const std::vector<Value>& argument
     // Task is later executed (via await), it runs the body directly without
     // wrapping again (which would cause infinite recursion / re-wrapping).
     if (isAsync_) {
-        // We need a shared_ptr to this; create a copy wrapped as shared_ptr
+        // Wrap a copy of this function, which the task then owns
         // We capture arguments in a BoundCall so the task can be awaited later
-        auto self = std::make_shared<UserFunction>(*this);
+        auto self = makeRef<UserFunction>(*this);
         self->isAsync_ = false;  // Run body directly when the task executes
-        auto task = std::make_shared<Task>();
-        task->callable = std::make_shared<BoundCall>(std::move(self), arguments);
+        auto task = makeRef<Task>();
+        task->callable = makeRef<BoundCall>(std::move(self), arguments);
         task->state = Task::State::Pending;
         return task;
     }
 
+    return callWithin(interp, arguments, closure.get());
+}
+
+Value UserFunction::callWithin(Interpreter& interp, const std::vector<Value>& arguments, Environment* enclosing) {
     // Check call depth to prevent stack overflow
     if (interp.callDepth >= MAX_CALL_DEPTH) {
         throw std::runtime_error("Stack overflow: Maximum call depth of " + std::to_string(MAX_CALL_DEPTH) +
                                  " exceeded.");
     }
 
+    Gc::maybeCollect();
+
     // Increment call depth
     interp.callDepth++;
 
     // Get params and body from either decl or funcExpr
     const std::vector<std::string>* params = nullptr;
     const std::vector<StmtPtr>* body = nullptr;
+    const ScopeLayout* scope = nullptr;
+    std::shared_ptr<CompiledBlock>* compiled = nullptr;
     std::string funcName;
     int funcLine = 0;
 
     if (decl) {
         params = &decl->params;
         body = &decl->body;
+        scope = &decl->scope;
+        compiled = &decl->compiled;
         funcName = decl->name.empty() ? "<anonymous>" : decl->name;
         funcLine = decl->line;
     } else if (funcExpr) {
         params = &funcExpr->params;
         body = &funcExpr->body;
+        scope = &funcExpr->scope;
+        compiled = &funcExpr->compiled;
         funcName = "<anonymous>";
     } else {
         interp.callDepth--;  // Restore call depth before throwing
@@ -68,22 +83,20 @@ Value UserFunction::call(Interpreter& interp, const std::vector<Value>& argument
 
     // Notify debug hook of function entry
     interp.notifyFunctionEnter(funcName, funcLine);
+    TraceScope trace("call", funcName);
 
-    auto localEnv = interp.arena_.create(closure);
-
-    for (size_t i = 0; i < params->size(); ++i) {
-        const std::string& paramName = (*params)[i];
-        Value argVal = (i < arguments.size()) ? arguments[i] : Nil{};
+    // The Resolver put the parameters in the scope's first slots; missing
+    // arguments stay nil
+    auto localEnv = interp.arena_.enter(enclosing, *scope);
 
-        localEnv->define(paramName, argVal);
+    size_t bound = std::min(params->size(), arguments.size());
+    for (size_t i = 0; i < bound; ++i) {
+        localEnv->at(static_cast<uint32_t>(i)) = arguments[i];
     }
 
+    Completion completion;
     try {
-        interp.executeBlock(*body, localEnv);
-    } catch (const ReturnSignal& returnValue) {
-        interp.callDepth--;  // Restore call depth on return
-        interp.notifyFunctionExit();
-        return returnValue.value;
+        completion = interp.executeBody(*body, *compiled, localEnv.get());
     } catch (RuntimeError& e) {
         interp.callDepth--;  // Restore call depth on exception
         interp.notifyFunctionExit();
@@ -95,8 +108,8 @@ Value UserFunction::call(Interpreter& interp, const std::vector<Value>& argument
         throw;
     }
 
-    interp.callDepth--;  // Restore call depth on normal exit
+    interp.callDepth--;  // Restore call depth on return
     interp.notifyFunctionExit();
-    return Nil{};
+    return interp.finish(std::move(completion));
 }
 }  // namespace izi
\ No newline at end of file
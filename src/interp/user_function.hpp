@@ -11,20 +11,19 @@ namespace izi {
 class Interpreter;
 
 // Ownership note:
-//   UserFunction holds a non-owning raw pointer to its closure Environment.
-//   The Environment is owned by the EnvironmentArena inside the Interpreter
-//   and therefore outlives the UserFunction for the duration of any given
-//   interpreter session.  This avoids the shared_ptr reference cycle that
-//   would otherwise exist between UserFunction and Environment.
-class UserFunction : public Callable {
+//   UserFunction shares ownership of its closure Environment, which lives as
+//   long as any function created in it.  A function stored in the scope it
+//   closes over makes a reference cycle; UserFunction is a GcObject so that
+//   the cycle collector can break it.
+class UserFunction : public Callable, public GcObject {
    public:
     // Constructor for function statements (named functions)
-    UserFunction(FunctionStmt* declaration, Environment* closure)
-        : decl(declaration), closure(closure), funcExpr(nullptr), isAsync_(declaration->isAsync) {}
+    UserFunction(FunctionStmt* declaration, Ref<Environment> closure)
+        : decl(declaration), funcExpr(nullptr), closure(std::move(closure)), isAsync_(declaration->isAsync) {}
 
     // Constructor for function expressions (anonymous functions)
-    UserFunction(FunctionExpr* expression, Environment* closure)
-        : decl(nullptr), closure(closure), funcExpr(expression), isAsync_(expression->isAsync) {}
+    UserFunction(FunctionExpr* expression, Ref<Environment> closure)
+        : decl(nullptr), funcExpr(expression), closure(std::move(closure)), isAsync_(expression->isAsync) {}
 
     std::string name() const override {
         if (decl) return decl->name.empty() ? "<anonymous>" : decl->name;
@@ -39,19 +38,29 @@ class UserFunction : public Callable {
 
     Value call(Interpreter& interp, const std::vector<Value>& arguments) override;
 
+    // Run the body synchronously in a call environment whose parent is
+    // `enclosing` rather than the closure (a bound method's `this` scope)
+    Value callWithin(Interpreter& interp, const std::vector<Value>& arguments, Environment* enclosing);
+
     bool getIsAsync() const { return isAsync_; }
 
     // Get the closure (needed for binding methods)
-    Environment* getClosure() const { return closure; }
+    Environment* getClosure() const { return closure.get(); }
+
+    // The call environment's layout: parameters, then the body's locals
+    const ScopeLayout& getScope() const { return decl ? decl->scope : funcExpr->scope; }
 
     // Get the function declaration (needed for creating bound methods)
     FunctionStmt* getDecl() const { return decl; }
     FunctionExpr* getFuncExpr() const { return funcExpr; }
 
+    void traceRefs(GcTracer& tracer) const override { tracer.trace(closure); }
+    void clearRefs() override { closure.reset(); }
+
    private:
     FunctionStmt* decl;  // For named functions (from statements)
     FunctionExpr* funcExpr;  // For anonymous functions (from expressions)
-    Environment* closure;  // Non-owning; owned by EnvironmentArena
+    Ref<Environment> closure;
     bool isAsync_ = false;
 };
 
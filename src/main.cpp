@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <cctype>
 #include <cstring>
+#include <optional>
 
 #ifdef HAVE_READLINE
 #include <readline/readline.h>
@@ -21,26 +22,154 @@
 #endif
 
 #include "interp/interpreter.hpp"
+#include "interp/profiler_hook.hpp"
 #include "parse/lexer.hpp"
 #include "parse/parser.hpp"
 #include "compile/compiler.hpp"
 #include "compile/formatter.hpp"
 #include "compile/optimizer.hpp"
 #include "compile/native_compiler.hpp"
+#include "compile/bytecode_cache.hpp"
 #include "bytecode/vm.hpp"
 #include "bytecode/vm_native.hpp"
 #include "bytecode/chunk_serializer.hpp"
+#include "bytecode/heap_snapshot.hpp"
+#include "bytecode/op_stats.hpp"
 #include "common/error_reporter.hpp"
 #include "common/diagnostics.hpp"
 #include "common/cli.hpp"
 #include "common/semantic_analyzer.hpp"
 #include "common/memory_metrics.hpp"
+#include "common/profiler.hpp"
+#include "common/trace.hpp"
 
 using namespace izi;
 namespace fs = std::filesystem;
 
+// VM options from the command line, applied to every VM `izi run` creates
+static bool g_vmJit = false;
+static bool g_bytecodeCache = true;
+// Interpreter option: run through closures compiled from the tree (--closure)
+static bool g_closureCompile = false;
+static Profiler* g_profiler = nullptr;
+static OpStats* g_opStats = nullptr;
+
+static void prepareVm(VM& vm) {
+    registerVmNatives(vm);
+    vm.setProfiler(g_profiler);
+    if (g_vmJit && !vm.enableJit()) {
+        std::cerr << "Warning: --jit is only supported on x86-64 Linux; running without it\n";
+        g_vmJit = false;
+    }
+    vm.setOpStats(g_opStats);
+}
+
+// `izi run --profile`: samples every VM and interpreter the run creates and
+// reports when the run ends, however it ends
+class ProfileSession {
+   public:
+    ProfileSession(int hz, const std::string& input) : input_(input) {
+        if (hz <= 0) {
+            return;
+        }
+        profiler_.emplace(hz);
+        if (!profiler_->start()) {
+            std::cerr << "Warning: --profile is not supported on this platform; running without it\n";
+            profiler_.reset();
+            return;
+        }
+        g_profiler = &*profiler_;
+    }
+
+    ~ProfileSession() {
+        if (!profiler_) {
+            return;
+        }
+        profiler_->stop();
+        g_profiler = nullptr;
+
+        std::string path = fs::path(input_).stem().string() + ".folded";
+        std::ofstream out(path);
+        profiler_->writeFolded(out);
+        std::cerr << '\n';
+        profiler_->writeTable(std::cerr);
+        if (out) {
+            std::cerr << "Folded stacks written to " << path << '\n';
+        } else {
+            std::cerr << "Warning: could not write " << path << '\n';
+        }
+    }
+
+   private:
+    std::string input_;
+    std::optional<Profiler> profiler_;
+};
+
+// `izi run --vm --opstats`: counts the instructions of every VM the run
+// creates and reports them when the run ends
+class OpStatsSession {
+   public:
+    OpStatsSession(bool enabled, std::string jsonPath) : jsonPath_(std::move(jsonPath)) {
+        if (enabled) {
+            stats_.emplace();
+            g_opStats = &*stats_;
+        }
+    }
+
+    ~OpStatsSession() {
+        if (!stats_) {
+            return;
+        }
+        g_opStats = nullptr;
+        std::cerr << '\n';
+        stats_->writeTable(std::cerr);
+        if (!jsonPath_.empty()) {
+            std::ofstream out(jsonPath_);
+            stats_->writeJson(out);
+            if (!out) {
+                std::cerr << "Warning: could not write " << jsonPath_ << '\n';
+            }
+        }
+    }
+
+   private:
+    std::string jsonPath_;
+    std::optional<OpStats> stats_;
+};
+
 void runCode(const std::string& src, bool useVM, bool debug, bool optimize, const std::string& filename = "<stdin>",
              const std::vector<std::string>& args = {}) {
+    // Warm start: bytecode cached by an earlier run of this file skips the
+    // lexer, parser, optimizer and compiler
+    const bool cacheable = useVM && g_bytecodeCache && fs::is_regular_file(filename);
+    if (cacheable) {
+        std::optional<Chunk> cached;
+        {
+            TraceScope trace("compile", "bytecode cache load");
+            cached = BytecodeCache(optimize).load(filename, src);
+        }
+        if (cached) {
+            if (debug) {
+                std::cout << "[DEBUG] Using cached bytecode " << BytecodeCache::cachePath(filename) << "\n";
+            }
+            bool uncaught = false;
+            try {
+                VM vm;
+                prepareVm(vm);
+                Value result = vm.run(*cached);
+                uncaught = vm.hadUncaughtError();
+            } catch (const std::runtime_error& e) {
+                std::cerr << "In file '" << filename << "':\n";
+                std::cerr << "Error: " << e.what() << '\n';
+                throw;
+            }
+            if (uncaught) {
+                throw std::runtime_error("uncaught error");  // Already reported by the VM
+            }
+            return;
+        }
+    }
+
     if (debug) {
         std::cout << "[DEBUG] Lexing and parsing...\n";
     }
@@ -68,6 +197,7 @@ void runCode(const std::string& src, bool useVM, bool debug, bool optimize, cons
     }
 
     // Phase 2: Execute the parsed program.
+    bool uncaught = false;
     try {
         // Apply optimizations if enabled
         if (optimize) {
@@ -79,13 +209,20 @@ void runCode(const std::string& src, bool useVM, bool debug, bool optimize, cons
         }
 
         if (debug) {
-            std::cout << "[DEBUG] Execution mode: " << (useVM ? "VM" : "Interpreter") << "\n";
+            std::cout << "[DEBUG] Execution mode: "
+                      << (useVM ? "VM" : g_closureCompile ? "Interpreter (closures)" : "Interpreter") << "\n";
         }
 
         if (!useVM) {
+            std::optional<ProfilerHook> profilerHook;
+            if (g_profiler) {
+                profilerHook.emplace(*g_profiler);
+            }
             Interpreter interp(src);
             interp.setCurrentFile(filename);  // Set current file for relative imports
             interp.setCommandLineArgs(args);
+            interp.setDebugHook(profilerHook ? &*profilerHook : nullptr);
+            interp.setClosureCompilation(g_closureCompile);
             interp.interpret(program);
         } else {
             std::unordered_set<std::string> importedModules;
@@ -93,9 +230,14 @@ void runCode(const std::string& src, bool useVM, bool debug, bool optimize, cons
             compiler.setCurrentFile(filename);  // Set current file for relative imports
             compiler.setImportedModules(&importedModules);
             Chunk chunk = compiler.compile(program);
+            if (cacheable) {
+                TraceScope trace("compile", "bytecode cache store");
+                BytecodeCache(optimize).store(filename, src, chunk, importedModules);
+            }
             VM vm;
-            registerVmNatives(vm);
+            prepareVm(vm);
             Value result = vm.run(chunk);
+            uncaught = vm.hadUncaughtError();
         }
     } catch (const ParserError& e) {
         ErrorReporter reporter(src);
@@ -125,6 +267,9 @@ void runCode(const std::string& src, bool useVM, bool debug, bool optimize, cons
         std::cerr << "Error: " << e.what() << '\n';
         throw;
     }
+    if (uncaught) {
+        throw std::runtime_error("uncaught error");  // Already reported by the VM
+    }
 }
 
 void runReplLine(const std::string& src, Interpreter* interp, VM* vm, bool useVM, bool debug, bool optimize,
@@ -834,8 +979,34 @@ int runBenchmark(const CliOptions& options) {
     return 0;
 }
 
+// `--trace-out`: records the timeline for the whole command and writes it
+// however the command ends
+class TraceSession {
+   public:
+    explicit TraceSession(std::string path) : path_(std::move(path)) {
+        if (!path_.empty()) {
+            Trace::start();
+        }
+    }
+
+    ~TraceSession() {
+        if (path_.empty()) {
+            return;
+        }
+        std::ofstream out(path_);
+        Trace::stop(out);
+        if (!out) {
+            std::cerr << "Warning: could not write " << path_ << '\n';
+        }
+    }
+
+   private:
+    std::string path_;
+};
+
 int main(int argc, char** argv) {
     CliOptions options = CliOptions::parse(argc, argv);
+    TraceSession trace(options.traceOut);
 
     // Initialize memory tracking if requested
     if (options.memoryStats) {
@@ -998,6 +1169,7 @@ int main(int argc, char** argv) {
         compileOpts.inputFile = options.input;
         compileOpts.debug = options.debug;
         compileOpts.verbose = options.debug;
+        compileOpts.bytecode = options.bytecode;
 
         // Determine output filename
         if (!options.output.empty()) {
@@ -1013,8 +1185,10 @@ int main(int argc, char** argv) {
         return success ? 0 : 1;
     }
 
-    // Handle chunk command (compile to .izb bytecode)
-    if (options.command == CliOptions::Command::Chunk) {
+    // Handle chunk command (compile to .izb bytecode) and snapshot command
+    // (compile, run the top level, save the heap to .izs)
+    if (options.command == CliOptions::Command::Chunk || options.command == CliOptions::Command::Snapshot) {
+        const bool snapshot = options.command == CliOptions::Command::Snapshot;
         try {
             if (options.debug) {
                 std::cout << "[DEBUG] Compiling to bytecode chunk...\n";
@@ -1089,9 +1263,28 @@ int main(int argc, char** argv) {
             if (!options.output.empty()) {
                 outputFile = options.output;
             } else {
-                // Default: replace .iz with .izb
+                // Default: replace .iz with .izb (.izs for snapshots)
                 fs::path inputPath(options.input);
-                outputFile = inputPath.stem().string() + ".izb";
+                outputFile = inputPath.stem().string() + (snapshot ? ".izs" : ".izb");
+            }
+
+            if (snapshot) {
+                VM vm;
+                prepareVm(vm);
+                try {
+                    Value result = vm.run(chunk);
+                } catch (const std::runtime_error& e) {
+                    std::cerr << "In file '" << options.input << "':\n";
+                    std::cerr << "Runtime Error: " << e.what() << '\n';
+                    return 1;
+                }
+                if (vm.hadUncaughtError()) {
+                    std::cerr << "Snapshot not written: the top level of '" << options.input << "' failed\n";
+                    return 1;
+                }
+                HeapSnapshot::saveToFile(vm, outputFile);
+                std::cout << "Successfully wrote snapshot: " << outputFile << "\n";
+                return 0;
             }
 
             // Serialize to file
@@ -1118,6 +1311,43 @@ int main(int argc, char** argv) {
         return 0;
     }
 
+    // Run from a heap snapshot: restore the globals, then call main()
+    if (options.command == CliOptions::Command::Run && !options.snapshot.empty()) {
+        g_vmJit = options.jit && !options.opStats;  // JIT code is not counted
+        ProfileSession profile(options.profileHz, options.snapshot);
+        OpStatsSession opStats(options.opStats, options.opStatsJson);
+        try {
+            VM vm;
+            prepareVm(vm);
+            HeapSnapshot::restoreFromFile(vm, options.snapshot);
+            if (options.debug) {
+                std::cout << "[DEBUG] Restored snapshot " << options.snapshot << "\n";
+            }
+
+            auto globals = vm.getGlobals();
+            auto entry = globals.find("main");
+            if (entry != globals.end() && entry->second.isVmCallable()) {
+                // main(args) receives the script arguments, like the interpreter's args list
+                std::vector<Value> arguments;
+                if (entry->second.asVmCallable()->arity() == 1) {
+                    auto list = makeRef<Array>();
+                    for (const auto& arg : options.args) {
+                        list->elements.push_back(arg);
+                    }
+                    arguments.push_back(list);
+                }
+                Value result = entry->second.asVmCallable()->call(vm, arguments);
+            }
+            if (vm.hadUncaughtError()) {
+                return 1;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << '\n';
+            return 1;
+        }
+        return 0;
+    }
+
     // Get source code from file (skip for .izb files)
     std::ifstream f(options.input);
     if (!f.is_open()) {
@@ -1139,6 +1369,22 @@ int main(int argc, char** argv) {
 
     // Handle different commands
     if (options.command == CliOptions::Command::Run) {
+        g_vmJit = options.jit;
+        g_bytecodeCache = options.cache;
+        g_closureCompile = options.engine == CliOptions::Engine::Closure;
+        if (options.jit && !useVM) {
+            std::cerr << "Warning: --jit only applies to the VM (use --vm --jit)\n";
+        }
+        if (options.opStats && !useVM) {
+            std::cerr << "Warning: --opstats only applies to the VM (use --vm --opstats)\n";
+        }
+        if (options.opStats && useVM && options.jit) {
+            std::cerr << "Warning: --opstats counts interpreted instructions only; running without --jit\n";
+            g_vmJit = false;
+        }
+        ProfileSession profile(options.profileHz, options.input);
+        OpStatsSession opStats(options.opStats && useVM, options.opStatsJson);
+
         // Check if input is a .izb bytecode file
         fs::path inputPath(options.input);
         if (inputPath.extension() == ".izb") {
@@ -1164,7 +1410,7 @@ int main(int argc, char** argv) {
                 }
 
                 VM vm;
-                registerVmNatives(vm);
+                prepareVm(vm);
                 Value result = vm.run(chunk);
 
                 if (options.debug) {
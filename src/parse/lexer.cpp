@@ -3,9 +3,12 @@
 #include <cctype>
 #include <stdexcept>
 
+#include "common/trace.hpp"
+
 namespace izi {
 
 std::vector<Token> Lexer::scanTokens() {
+    TraceScope trace("compile", "lex");
     while (!isAtEnd()) {
         start = current;
         startLine = line;
@@ -14,7 +17,7 @@ std::vector<Token> Lexer::scanTokens() {
     }
 
     tokens.emplace_back(TokenType::END_OF_FILE, "", line, column);
-    return tokens;
+    return std::move(tokens);
 }
 
 void Lexer::scanToken() {
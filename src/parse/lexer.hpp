@@ -24,6 +24,7 @@ class Lexer {
     explicit Lexer(std::string source, DiagnosticEngine* diags = nullptr)
         : source(std::move(source)), diags_(diags) {}
 
+    // Scans the whole source and hands over the tokens; call once
     std::vector<Token> scanTokens();
 
    private:
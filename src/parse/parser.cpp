@@ -6,10 +6,13 @@
 
 #include "ast/expr.hpp"
 #include "ast/stmt.hpp"
+#include "common/trace.hpp"
 
 namespace izi {
 
 std::vector<StmtPtr> Parser::parse() {
+    TraceScope trace("compile", "parse");
+    AstArenaScope arena;  // The tree's nodes live in an arena of this parse
     std::vector<StmtPtr> statements;
     while (!isAtEnd()) {
         statements.push_back(declaration());
@@ -797,7 +800,7 @@ ExprPtr Parser::assignment() {
     ExprPtr expr = conditional();
 
     if (match({TokenType::EQUAL})) {
-        const Token& equals = previous();
+        Token equals = previous();  // The value may expand a macro
         ExprPtr value = assignment();
 
         // Variable assignment
@@ -1216,7 +1219,7 @@ bool Parser::check(TokenType type) const {
     return peek().type == type;
 }
 
-Token Parser::advance() {
+const Token& Parser::advance() {
     if (!isAtEnd()) current++;
     return previous();
 }
@@ -1225,15 +1228,15 @@ bool Parser::isAtEnd() const {
     return peek().type == TokenType::END_OF_FILE;
 }
 
-Token Parser::peek() const {
+const Token& Parser::peek() const {
     return tokens[current];
 }
 
-Token Parser::previous() const {
+const Token& Parser::previous() const {
     return tokens[current - 1];
 }
 
-Token Parser::consume(TokenType type, const std::string& message) {
+const Token& Parser::consume(TokenType type, const std::string& message) {
     if (check(type)) return advance();
     throw error(peek(), message);
 }
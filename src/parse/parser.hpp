@@ -88,11 +88,13 @@ class Parser {
     // Helper methods
     bool match(std::initializer_list<TokenType> types);
     bool check(TokenType type) const;
-    Token advance();
+    // Tokens are returned by reference into `tokens`; copy one that must
+    // outlive a macro expansion, which inserts into it
+    const Token& advance();
     bool isAtEnd() const;
-    Token peek() const;
-    Token previous() const;
-    Token consume(TokenType type, const std::string& message);
+    const Token& peek() const;
+    const Token& previous() const;
+    const Token& consume(TokenType type, const std::string& message);
     void consumeSemicolonIfNeeded();
     void synchronize();
 
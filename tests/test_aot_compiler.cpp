@@ -0,0 +1,165 @@
+#include "catch.hpp"
+#include "parse/lexer.hpp"
+#include "parse/parser.hpp"
+#include "compile/aot_compiler.hpp"
+#include "compile/compiler.hpp"
+#include "bytecode/chunk_serializer.hpp"
+#include "bytecode/jit.hpp"
+#include "bytecode/vm.hpp"
+#include "bytecode/vm_native.hpp"
+
+#include <sstream>
+
+using namespace izi;
+
+namespace {
+
+Chunk compileSource(const std::string& source) {
+    Lexer lexer(source);
+    auto tokens = lexer.scanTokens();
+    Parser parser(std::move(tokens), source);
+    auto program = parser.parse();
+    BytecodeCompiler compiler;
+    return compiler.compile(program);
+}
+
+std::string generate(const std::string& source) {
+    Chunk chunk = compileSource(source);
+    std::ostringstream out;
+    AotCompiler::generate(chunk, out);
+    return out.str();
+}
+
+uint32_t entriesSeen = 0;
+
+// Stand-in for generated code: runs nothing, hands every instruction back
+uint32_t countingEntry(JitContext&, uint32_t offset) {
+    ++entriesSeen;
+    return offset;
+}
+
+}  // namespace
+
+TEST_CASE("AOT: every chunk gets native code and a builder", "[aot]") {
+    std::string code = generate(R"(
+        fn square(x) { return x * x; }
+        class Box {
+            fn init(v) { this.v = v; }
+            fn get() { return this.v; }
+        }
+        print(square(3), Box(4).get());
+    )");
+    // Script, square, init and get
+    for (const char* name : {"native0", "native1", "native2", "native3", "chunk3()"}) {
+        REQUIRE(code.find(name) != std::string::npos);
+    }
+    REQUIRE(code.find("native4") == std::string::npos);
+    REQUIRE(code.find("std::shared_ptr<Chunk> aotScriptChunk()") != std::string::npos);
+    REQUIRE(code.find("makeRef<VmClass>(std::string(\"Box\", 3)") != std::string::npos);
+}
+
+TEST_CASE("AOT: loops and arithmetic become native control flow", "[aot]") {
+    std::string code = generate(R"(
+        fn run(n) {
+            var sum = 0;
+            var i = 0;
+            while (i < n) { sum = sum + i * 2.5; i = i + 1; }
+            return sum;
+        }
+        print(run(10));
+    )");
+    REQUIRE(code.find("goto op") != std::string::npos);
+    REQUIRE(code.find("sp[-2].numberUnchecked() * sp[-1].numberUnchecked()") != std::string::npos);
+    REQUIRE(code.find("Value(0x1.4p+1)") != std::string::npos);  // 2.5, exactly
+}
+
+TEST_CASE("AOT: string constants keep every byte", "[aot]") {
+    std::string code = generate("print(\"a?\nb\t\xC3\xA9\");");
+    REQUIRE(code.find(R"(std::string("a\077\012b\011\303\251", 7))") != std::string::npos);
+}
+
+TEST_CASE("AOT: the VM runs native code attached to chunks", "[aot]") {
+    Chunk chunk = compileSource(R"(
+        var i = 0;
+        while (i < 3) { i = i + 1; }
+        print(i);
+    )");
+    chunk.jitCode = std::make_shared<JitCode>(&countingEntry);
+    REQUIRE(chunk.jitCode->compiled());
+
+    std::ostringstream out;
+    std::streambuf* old = std::cout.rdbuf(out.rdbuf());
+    entriesSeen = 0;
+    VM vm;
+    registerVmNatives(vm);
+    vm.enableAotCode();
+    (void)vm.run(chunk);
+    std::cout.rdbuf(old);
+
+    REQUIRE(out.str() == "3\n");
+    REQUIRE(entriesSeen >= 4);  // Script entry and each back-edge
+}
+
+TEST_CASE("Bytecode images: in-memory round trip runs like the original", "[aot]") {
+    Chunk chunk = compileSource(R"(
+        fn add(a, b) { return a + b; }
+        class P { fn init(x) { this.x = x; } }
+        try { throw "t"; } catch (e) { print(e); }
+        print(add(1, 2), P(5).x, "s" + "t");
+    )");
+    std::string image = ChunkSerializer::serialize(chunk);
+    Chunk loaded = ChunkSerializer::deserialize(image.data(), image.size());
+    REQUIRE(loaded.code == chunk.code);
+    REQUIRE(loaded.exceptionTable.size() == chunk.exceptionTable.size());
+
+    std::ostringstream out;
+    std::streambuf* old = std::cout.rdbuf(out.rdbuf());
+    VM vm;
+    registerVmNatives(vm);
+    (void)vm.run(loaded);
+    std::cout.rdbuf(old);
+    REQUIRE(out.str() == "t\n3 5 st\n");
+
+    REQUIRE_THROWS_AS(ChunkSerializer::deserialize(image.data(), image.size() / 2), std::runtime_error);
+}
+
+TEST_CASE("AOT: compiled programs can report uncaught errors", "[aot]") {
+    std::ostringstream err;
+    std::streambuf* old = std::cerr.rdbuf(err.rdbuf());
+    VM vm;
+    registerVmNatives(vm);
+    (void)vm.run(compileSource("throw \"boom\";"));
+    bool thrown = vm.hadUncaughtError();
+    (void)vm.run(compileSource("var x = 1;"));
+    bool clean = vm.hadUncaughtError();
+    std::cerr.rdbuf(old);
+
+    REQUIRE(thrown);
+    REQUIRE_FALSE(clean);
+    REQUIRE(err.str().find("boom") != std::string::npos);
+}
+
+TEST_CASE("AOT: strict compilation rejects field initializers", "[aot]") {
+    std::string source = "class P { var x = 1; }";
+    Lexer lexer(source);
+    Parser parser(lexer.scanTokens(), source);
+    auto program = parser.parse();
+    BytecodeCompiler compiler;
+    compiler.setStrict(true);
+    REQUIRE_THROWS_WITH(compiler.compile(program), Catch::Contains("Field initializers"));
+}
+
+TEST_CASE("Bytecode images: an uncaught error is reported to the caller", "[aot]") {
+    std::string image = ChunkSerializer::serialize(compileSource("var a = [1]; print(a[3]);"));
+    Chunk loaded = ChunkSerializer::deserialize(image.data(), image.size());
+
+    std::ostringstream err;
+    std::streambuf* old = std::cerr.rdbuf(err.rdbuf());
+    VM vm;
+    registerVmNatives(vm);
+    (void)vm.run(loaded);
+    std::cerr.rdbuf(old);
+
+    REQUIRE(vm.hadUncaughtError());
+    REQUIRE(err.str().find("out of bounds") != std::string::npos);
+}
@@ -35,8 +35,8 @@ TEST_CASE("AstPrinter: literal expressions", "[ast_printer]") {
         REQUIRE(es != nullptr);
         auto* lit = dynamic_cast<LiteralExpr*>(es->expr.get());
         REQUIRE(lit != nullptr);
-        REQUIRE(std::holds_alternative<double>(lit->value));
-        REQUIRE(std::get<double>(lit->value) == 42.0);
+        REQUIRE(lit->value.isNumber());
+        REQUIRE(lit->value.asNumber() == 42.0);
         AstPrinter printer;
         REQUIRE(printer.printExpr(*es->expr) == "42");
     }
@@ -152,8 +152,8 @@ TEST_CASE("Interpreter: async fn returns a Task", "[interpreter][async]") {
         interp.interpret(stmts);
 
         Value t = interp.getGlobals()->get("t");
-        REQUIRE(std::holds_alternative<std::shared_ptr<Task>>(t));
-        auto task = std::get<std::shared_ptr<Task>>(t);
+        REQUIRE(t.isTask());
+        auto task = t.asTask();
         REQUIRE(task->state == Task::State::Pending);
     }
 
@@ -173,8 +173,8 @@ TEST_CASE("Interpreter: async fn returns a Task", "[interpreter][async]") {
         interp.interpret(stmts);
 
         Value result = interp.getGlobals()->get("result");
-        REQUIRE(std::holds_alternative<double>(result));
-        REQUIRE(std::get<double>(result) == 99.0);
+        REQUIRE(result.isNumber());
+        REQUIRE(result.asNumber() == 99.0);
     }
 
     SECTION("await on non-task value returns value unchanged") {
@@ -190,8 +190,8 @@ TEST_CASE("Interpreter: async fn returns a Task", "[interpreter][async]") {
         interp.interpret(stmts);
 
         Value result = interp.getGlobals()->get("result");
-        REQUIRE(std::holds_alternative<double>(result));
-        REQUIRE(std::get<double>(result) == 42.0);
+        REQUIRE(result.isNumber());
+        REQUIRE(result.asNumber() == 42.0);
     }
 
     SECTION("async fn with parameters works correctly when awaited") {
@@ -210,8 +210,8 @@ TEST_CASE("Interpreter: async fn returns a Task", "[interpreter][async]") {
         interp.interpret(stmts);
 
         Value result = interp.getGlobals()->get("result");
-        REQUIRE(std::holds_alternative<double>(result));
-        REQUIRE(std::get<double>(result) == 7.0);
+        REQUIRE(result.isNumber());
+        REQUIRE(result.asNumber() == 7.0);
     }
 
     SECTION("async fn calling another async fn with await") {
@@ -234,8 +234,8 @@ TEST_CASE("Interpreter: async fn returns a Task", "[interpreter][async]") {
         interp.interpret(stmts);
 
         Value result = interp.getGlobals()->get("result");
-        REQUIRE(std::holds_alternative<double>(result));
-        REQUIRE(std::get<double>(result) == 20.0);
+        REQUIRE(result.isNumber());
+        REQUIRE(result.asNumber() == 20.0);
     }
 
     SECTION("await on regular function call returns value directly") {
@@ -254,8 +254,8 @@ TEST_CASE("Interpreter: async fn returns a Task", "[interpreter][async]") {
         interp.interpret(stmts);
 
         Value result = interp.getGlobals()->get("result");
-        REQUIRE(std::holds_alternative<double>(result));
-        REQUIRE(std::get<double>(result) == 11.0);
+        REQUIRE(result.isNumber());
+        REQUIRE(result.asNumber() == 11.0);
     }
 }
 
@@ -273,7 +273,7 @@ TEST_CASE("Interpreter: async fn interacts with spawn/await native functions", "
         interp.interpret(stmts);
 
         Value t = interp.getGlobals()->get("t");
-        REQUIRE(std::holds_alternative<std::shared_ptr<Task>>(t));
+        REQUIRE(t.isTask());
     }
 }
 
@@ -291,7 +291,7 @@ TEST_CASE("Interpreter: mutex() creates a Mutex value", "[interpreter][concurren
         interp.interpret(stmts);
 
         Value m = interp.getGlobals()->get("m");
-        REQUIRE(std::holds_alternative<std::shared_ptr<Mutex>>(m));
+        REQUIRE(m.isMutex());
     }
 
     SECTION("lock() and unlock() work on a mutex") {
@@ -324,8 +324,8 @@ TEST_CASE("Interpreter: mutex() creates a Mutex value", "[interpreter][concurren
         interp.interpret(stmts);
 
         Value acquired = interp.getGlobals()->get("acquired");
-        REQUIRE(std::holds_alternative<bool>(acquired));
-        REQUIRE(std::get<bool>(acquired) == true);
+        REQUIRE(acquired.isBool());
+        REQUIRE(acquired.asBool() == true);
     }
 }
 
@@ -344,8 +344,8 @@ TEST_CASE("Interpreter: thread_spawn runs callable on OS thread", "[interpreter]
         interp.interpret(stmts);
 
         Value t = interp.getGlobals()->get("t");
-        REQUIRE(std::holds_alternative<std::shared_ptr<Task>>(t));
-        auto task = std::get<std::shared_ptr<Task>>(t);
+        REQUIRE(t.isTask());
+        auto task = t.asTask();
         REQUIRE(task->osMutex != nullptr);
         REQUIRE(task->osCv != nullptr);
         REQUIRE(task->state == Task::State::Completed);
@@ -365,8 +365,8 @@ TEST_CASE("Interpreter: thread_spawn runs callable on OS thread", "[interpreter]
         interp.interpret(stmts);
 
         Value result = interp.getGlobals()->get("result");
-        REQUIRE(std::holds_alternative<double>(result));
-        REQUIRE(std::get<double>(result) == 99.0);
+        REQUIRE(result.isNumber());
+        REQUIRE(result.asNumber() == 99.0);
     }
 
     SECTION("thread_spawn with arithmetic returns correct result") {
@@ -383,8 +383,8 @@ TEST_CASE("Interpreter: thread_spawn runs callable on OS thread", "[interpreter]
         interp.interpret(stmts);
 
         Value result = interp.getGlobals()->get("result");
-        REQUIRE(std::holds_alternative<double>(result));
-        REQUIRE(std::get<double>(result) == 7.0);
+        REQUIRE(result.isNumber());
+        REQUIRE(result.asNumber() == 7.0);
     }
 
     SECTION("multiple thread_spawn tasks run concurrently") {
@@ -404,10 +404,10 @@ TEST_CASE("Interpreter: thread_spawn runs callable on OS thread", "[interpreter]
 
         Value r1 = interp.getGlobals()->get("r1");
         Value r2 = interp.getGlobals()->get("r2");
-        REQUIRE(std::holds_alternative<double>(r1));
-        REQUIRE(std::holds_alternative<double>(r2));
-        REQUIRE(std::get<double>(r1) == 10.0);
-        REQUIRE(std::get<double>(r2) == 20.0);
+        REQUIRE(r1.isNumber());
+        REQUIRE(r2.isNumber());
+        REQUIRE(r1.asNumber() == 10.0);
+        REQUIRE(r2.asNumber() == 20.0);
     }
 
     SECTION("thread_spawn with shared Array and mutex provides atomic increments") {
@@ -436,10 +436,10 @@ TEST_CASE("Interpreter: thread_spawn runs callable on OS thread", "[interpreter]
         interp.interpret(stmts);
 
         Value counter = interp.getGlobals()->get("counter");
-        REQUIRE(std::holds_alternative<std::shared_ptr<Array>>(counter));
-        auto arr = std::get<std::shared_ptr<Array>>(counter);
+        REQUIRE(counter.isArray());
+        auto arr = counter.asArray();
         REQUIRE(arr->elements.size() == 1);
-        REQUIRE(std::holds_alternative<double>(arr->elements[0]));
-        REQUIRE(std::get<double>(arr->elements[0]) == 2.0);
+        REQUIRE(arr->elements[0].isNumber());
+        REQUIRE(arr->elements[0].asNumber() == 2.0);
     }
 }
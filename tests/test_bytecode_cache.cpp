@@ -0,0 +1,114 @@
+#include "catch.hpp"
+#include "parse/lexer.hpp"
+#include "parse/parser.hpp"
+#include "compile/bytecode_cache.hpp"
+#include "compile/compiler.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace izi;
+namespace fs = std::filesystem;
+
+namespace {
+
+void writeFile(const fs::path& path, const std::string& contents) {
+    std::ofstream out(path, std::ios::binary);
+    out << contents;
+}
+
+struct CompiledScript {
+    Chunk chunk;
+    std::unordered_set<std::string> imports;
+};
+
+CompiledScript compileFile(const fs::path& path, const std::string& source) {
+    Lexer lexer(source);
+    auto tokens = lexer.scanTokens();
+    Parser parser(std::move(tokens), source);
+    auto program = parser.parse();
+    CompiledScript script;
+    BytecodeCompiler compiler;
+    compiler.setCurrentFile(fs::absolute(path).string());
+    compiler.setImportedModules(&script.imports);
+    script.chunk = compiler.compile(program);
+    return script;
+}
+
+}  // namespace
+
+TEST_CASE("Bytecode cache: entries are reused until an input changes", "[cache]") {
+    fs::path dir = fs::temp_directory_path() / "test_bytecode_cache";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    fs::path script = dir / "main.iz";
+    fs::path helper = dir / "helper.iz";
+
+    writeFile(helper, "fn twice(x) { return x * 2; }\n");
+    const std::string source = "import \"./helper.iz\";\nprint(twice(21));\n";
+    writeFile(script, source);
+
+    CompiledScript compiled = compileFile(script, source);
+    BytecodeCache cache(true);
+    REQUIRE_FALSE(cache.load(script.string(), source).has_value());
+
+    cache.store(script.string(), source, compiled.chunk, compiled.imports);
+    REQUIRE(fs::exists(BytecodeCache::cachePath(script.string())));
+
+    SECTION("Same inputs hit, with code and lines intact") {
+        auto cached = cache.load(script.string(), source);
+        REQUIRE(cached.has_value());
+        REQUIRE(cached->code == compiled.chunk.code);
+        REQUIRE(cached->lines == compiled.chunk.lines);
+    }
+
+    SECTION("An edited script misses") {
+        REQUIRE_FALSE(cache.load(script.string(), source + "print(1);\n").has_value());
+    }
+
+    SECTION("An edited import misses") {
+        writeFile(helper, "fn twice(x) { return x + x; }\n");
+        REQUIRE_FALSE(cache.load(script.string(), source).has_value());
+    }
+
+    SECTION("Different optimization flags miss") {
+        REQUIRE_FALSE(BytecodeCache(false).load(script.string(), source).has_value());
+    }
+
+    SECTION("Entries from another compiler revision miss") {
+        // Magic, cache version and .izb format version, then the compiler revision
+        fs::path entry = BytecodeCache::cachePath(script.string());
+        std::fstream file(entry, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(12);
+        file.put(static_cast<char>(BytecodeCompiler::REVISION + 1));
+        file.close();
+        REQUIRE_FALSE(cache.load(script.string(), source).has_value());
+    }
+
+    SECTION("Truncated entries miss") {
+        fs::path entry = BytecodeCache::cachePath(script.string());
+        fs::resize_file(entry, fs::file_size(entry) - 5);
+        REQUIRE_FALSE(cache.load(script.string(), source).has_value());
+        fs::resize_file(entry, 3);
+        REQUIRE_FALSE(cache.load(script.string(), source).has_value());
+    }
+
+    fs::remove_all(dir);
+}
+
+TEST_CASE("Bytecode cache: an unwritable cache directory is skipped quietly", "[cache]") {
+    fs::path dir = fs::temp_directory_path() / "test_bytecode_cache_blocked";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    fs::path script = dir / "main.iz";
+    const std::string source = "print(1);\n";
+    writeFile(script, source);
+    writeFile(dir / "__izicache__", "");  // A file where the directory should go
+
+    CompiledScript compiled = compileFile(script, source);
+    BytecodeCache cache(true);
+    REQUIRE_NOTHROW(cache.store(script.string(), source, compiled.chunk, compiled.imports));
+    REQUIRE_FALSE(cache.load(script.string(), source).has_value());
+
+    fs::remove_all(dir);
+}
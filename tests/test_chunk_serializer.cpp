@@ -0,0 +1,181 @@
+#include "catch.hpp"
+#include "parse/lexer.hpp"
+#include "parse/parser.hpp"
+#include "compile/compiler.hpp"
+#include "bytecode/chunk_serializer.hpp"
+#include "bytecode/vm.hpp"
+#include "bytecode/vm_class.hpp"
+#include "bytecode/vm_native.hpp"
+#include "bytecode/vm_user_function.hpp"
+#include "common/error.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace izi;
+namespace fs = std::filesystem;
+
+namespace {
+
+Chunk compileSource(const std::string& source) {
+    Lexer lexer(source);
+    auto tokens = lexer.scanTokens();
+    Parser parser(std::move(tokens), source);
+    auto program = parser.parse();
+    BytecodeCompiler compiler;
+    return compiler.compile(program);
+}
+
+std::string run(const Chunk& chunk) {
+    std::ostringstream out;
+    std::streambuf* old = std::cout.rdbuf(out.rdbuf());
+    try {
+        VM vm;
+        registerVmNatives(vm);
+        (void)vm.run(chunk);
+    } catch (...) {
+        std::cout.rdbuf(old);
+        throw;
+    }
+    std::cout.rdbuf(old);
+    return out.str();
+}
+
+const char* PROGRAM = R"(
+    fn counter() {
+        var n = 0;
+        fn next() { n = n + 1; return n; }
+        return next;
+    }
+    class Animal {
+        var name;
+        fn init(name) { this.name = name; }
+        fn speak() { return this.name + " makes a sound"; }
+    }
+    class Dog extends Animal {
+        fn speak() { return this.name + " barks"; }
+    }
+    var next = counter();
+    next();
+    try { throw "oops"; } catch (e) { print(e); }
+    print(next(), Dog("Rex").speak(), Animal("Cat").speak());
+)";
+
+}  // namespace
+
+TEST_CASE("Bytecode images: nested functions, classes and lines round trip", "[serializer]") {
+    Chunk chunk = compileSource(PROGRAM);
+    const std::string expected = run(chunk);
+    REQUIRE(expected == "oops\n2 Rex barks Cat makes a sound\n");
+
+    std::string image = ChunkSerializer::serialize(chunk);
+    REQUIRE(image.size() % 8 == 0);
+    Chunk loaded = ChunkSerializer::deserialize(image.data(), image.size());
+    REQUIRE(loaded.code == chunk.code);
+    REQUIRE(loaded.names == chunk.names);
+    REQUIRE(loaded.lines == chunk.lines);
+    REQUIRE(loaded.exceptionTable.size() == chunk.exceptionTable.size());
+
+    // Method chunks keep their own code and line tables
+    for (const auto& constant : chunk.constants) {
+        if (constant.isVmClass() && constant.asVmClass()->className == "Dog") {
+            auto original = dynamicRefCast<VmUserFunction>(constant.asVmClass()->methods.at("speak"));
+            for (const auto& other : loaded.constants) {
+                if (other.isVmClass() && other.asVmClass()->className == "Dog") {
+                    auto copy = dynamicRefCast<VmUserFunction>(other.asVmClass()->methods.at("speak"));
+                    REQUIRE(copy->getChunk().code == original->getChunk().code);
+                    REQUIRE(copy->getChunk().lines == original->getChunk().lines);
+                }
+            }
+        }
+    }
+
+    REQUIRE(run(loaded) == expected);
+}
+
+TEST_CASE("Bytecode images: nested constant values round trip", "[serializer]") {
+    Chunk chunk;
+    auto inner = makeRef<Array>();
+    inner->elements = {Value(1.5), Value("x"), Value(true)};
+    auto map = makeRef<Map>();
+    map->entries["list"] = Value(inner);
+    map->entries["name"] = Value("x");
+    chunk.addConstant(Value(map));
+    chunk.addConstant(Value(makeRef<Error>("bad", "TypeError")));
+    chunk.addConstant(Nil{});
+
+    std::string image = ChunkSerializer::serialize(chunk);
+    Chunk loaded = ChunkSerializer::deserialize(image.data(), image.size());
+    REQUIRE(loaded.constants.size() == 3);
+    const auto& entries = loaded.constants[0].asMap()->entries;
+    REQUIRE(entries.at("name").asString() == "x");
+    const auto& elements = entries.at("list").asArray()->elements;
+    REQUIRE(elements.size() == 3);
+    REQUIRE(elements[0].asNumber() == 1.5);
+    REQUIRE(elements[1].asString() == "x");
+    REQUIRE(elements[2].asBool());
+    REQUIRE(loaded.constants[1].asError()->message == "bad");
+    REQUIRE(loaded.constants[1].asError()->type == "TypeError");
+    REQUIRE(loaded.constants[2].isNil());
+}
+
+TEST_CASE("Bytecode images: damaged images are rejected", "[serializer]") {
+    Chunk chunk = compileSource(PROGRAM);
+    std::string image = ChunkSerializer::serialize(chunk);
+
+    SECTION("Flipped byte") {
+        image[image.size() / 2] ^= 0x40;
+        REQUIRE_THROWS_WITH(ChunkSerializer::deserialize(image.data(), image.size()),
+                            Catch::Contains("checksum mismatch"));
+    }
+
+    SECTION("Truncated") {
+        REQUIRE_THROWS_AS(ChunkSerializer::deserialize(image.data(), image.size() - 8), std::runtime_error);
+        REQUIRE_THROWS_AS(ChunkSerializer::deserialize(image.data(), 10), std::runtime_error);
+    }
+
+    SECTION("Other format version") {
+        image[4] = 3;
+        REQUIRE_THROWS_WITH(ChunkSerializer::deserialize(image.data(), image.size()),
+                            Catch::Contains("Incompatible bytecode version"));
+    }
+}
+
+TEST_CASE("Bytecode images: files load through the mapped reader", "[serializer]") {
+    fs::path path = fs::temp_directory_path() / "test_chunk_serializer.izb";
+    Chunk chunk = compileSource(PROGRAM);
+    REQUIRE(ChunkSerializer::serializeToFile(chunk, path.string()));
+    Chunk loaded = ChunkSerializer::deserializeFromFile(path.string());
+    REQUIRE(run(loaded) == run(chunk));
+    fs::remove(path);
+
+    REQUIRE_THROWS_AS(ChunkSerializer::deserializeFromFile(path.string()), std::runtime_error);
+}
+
+TEST_CASE("Bytecode images: function chunks decode on first use", "[serializer]") {
+    fs::path path = fs::temp_directory_path() / "test_chunk_serializer_lazy.izb";
+    Chunk chunk = compileSource(PROGRAM);
+    REQUIRE(ChunkSerializer::serializeToFile(chunk, path.string()));
+    std::string before = ChunkSerializer::serialize(chunk);
+
+    Chunk loaded = ChunkSerializer::deserializeFromFile(path.string());
+    Ref<VmUserFunction> counter;
+    for (const auto& constant : loaded.constants) {
+        if (constant.isVmCallable()) {
+            counter = dynamicRefCast<VmUserFunction>(constant.asVmCallable());
+        }
+    }
+    REQUIRE(counter);
+    REQUIRE(!counter->decoded());
+    REQUIRE(run(loaded) == "oops\n2 Rex barks Cat makes a sound\n");
+    REQUIRE(counter->decoded());
+    REQUIRE(!counter->getChunk().constants.empty());
+
+    // Quickening wrote the private mapping, not the file
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream after;
+    after << file.rdbuf();
+    REQUIRE(after.str() == before);
+    fs::remove(path);
+}
@@ -0,0 +1,142 @@
+#include "catch.hpp"
+#include "parse/lexer.hpp"
+#include "parse/parser.hpp"
+#include "interp/interpreter.hpp"
+#include <sstream>
+
+using namespace izi;
+
+namespace {
+
+std::string run(const std::string& source, bool closures) {
+    Lexer lexer(source);
+    auto tokens = lexer.scanTokens();
+    Parser parser(std::move(tokens), source);
+    auto program = parser.parse();
+
+    std::stringstream buffer;
+    std::streambuf* old = std::cout.rdbuf(buffer.rdbuf());
+    try {
+        Interpreter interp(source);
+        interp.setClosureCompilation(closures);
+        interp.interpret(program);
+    } catch (...) {
+        std::cout.rdbuf(old);
+        throw;
+    }
+    std::cout.rdbuf(old);
+    return buffer.str();
+}
+
+// Runs `source` through compiled closures, checking the interpreter agrees
+std::string runCompiled(const std::string& source) {
+    std::string output = run(source, true);
+    REQUIRE(output == run(source, false));
+    return output;
+}
+
+}  // namespace
+
+TEST_CASE("ClosureCompiler: operators, variables and control flow", "[interp][closure]") {
+    SECTION("Arithmetic, comparison and short-circuiting") {
+        REQUIRE(runCompiled(R"(
+            var a = 7;
+            var b = 2;
+            print(a + b * 3 - a / b);
+            print(a % b, -a, !a, a >= 7, a < b, a == 7, a != 7);
+            print("x" + "y", nil ?? "default", false or "or", 0 and "and");
+            print(a > 5 ? "big" : "small");
+        )") == "9.5\n1 -7 false true false true false\nxy default or 0\nbig\n");
+    }
+
+    SECTION("Operators reject operands the interpreter rejects") {
+        REQUIRE_THROWS(run("print(1 - \"a\");", true));
+        REQUIRE_THROWS(run("print(-\"a\");", true));
+        REQUIRE_THROWS_WITH(run("var f = 3; f();", true), "Can only call functions and classes.");
+    }
+
+    SECTION("Loops, blocks, break and continue") {
+        REQUIRE(runCompiled(R"(
+            var sum = 0;
+            var i = 0;
+            while (i < 3) {
+                i = i + 1;
+                var j = 0;
+                while (true) {
+                    j = j + 1;
+                    if (j == 2) { continue; }
+                    if (j > 3) { break; }
+                    sum = sum + i * 10 + j;
+                }
+            }
+            { var shadow = sum; print(shadow); }
+            for (var k = 0; k < 3; k = k + 1) { print(k); }
+        )") == "132\n0\n1\n2\n");
+    }
+
+    SECTION("Collections, destructuring and top-level return") {
+        REQUIRE(runCompiled(R"(
+            var xs = [1, 2, 3];
+            xs[1] = xs[0] + xs[2];
+            var m = {"k": xs[1]};
+            m["k"] = m["k"] * 10;
+            var [p, q] = xs;
+            print(xs, m["k"], p + q);
+            return;
+            print("unreachable");
+        )") == "[1, 4, 3] 40 5\n");
+    }
+}
+
+TEST_CASE("ClosureCompiler: functions, classes and the interpreted nodes", "[interp][closure]") {
+    SECTION("Recursion and closures") {
+        REQUIRE(runCompiled(R"(
+            fn fib(n) { if (n < 2) { return n; } return fib(n - 1) + fib(n - 2); }
+            fn counter() {
+                var count = 0;
+                return fn() { count = count + 1; return count; };
+            }
+            var next = counter();
+            next();
+            print(fib(15), next());
+        )") == "610 2\n");
+    }
+
+    SECTION("Classes, inheritance and super") {
+        REQUIRE(runCompiled(R"izi(
+            class Animal {
+                fn init(name) { this.name = name; }
+                fn speak() { return this.name + " makes a sound"; }
+            }
+            class Dog extends Animal {
+                fn init(name) { super.init(name); this.tricks = 0; }
+                fn speak() { return super.speak() + " (woof)"; }
+            }
+            var d = Dog("Rex");
+            d.tricks = d.tricks + 2;
+            print(d.speak(), d.tricks);
+        )izi") == "Rex makes a sound (woof) 2\n");
+    }
+
+    SECTION("Match, try and async") {
+        REQUIRE(runCompiled(R"(
+            fn describe(x) { return match x { 0 => "zero", 1 => "one", _ => "many" }; }
+            fn risky(n) { if (n > 1) { throw "too big"; } return n; }
+            fn attempt(n) {
+                var result = nil;
+                try { result = risky(n); } catch (e) { result = e; } finally { print("finally"); }
+                return result;
+            }
+            async fn double(n) { return n * 2; }
+            print(describe(0), describe(5));
+            print(attempt(1));
+            print(attempt(2));
+            print(await double(21));
+        )") == "zero many\nfinally\n1\nfinally\ntoo big\n42\n");
+    }
+
+    SECTION("Uncaught throws and stray breaks fail as in the interpreter") {
+        REQUIRE_THROWS_AS(run("fn f() { throw 1; } f();", true), ThrowSignal);
+        REQUIRE_THROWS_WITH(run("fn f() { break; } f();", true), "Break statement outside of loop.");
+    }
+}
@@ -6,63 +6,63 @@ using namespace izi;
 // ============ Array Method Tests ============
 
 TEST_CASE("Array shift() removes and returns first element", "[collections][array]") {
-    auto arr = std::make_shared<Array>();
+    auto arr = makeRef<Array>();
     arr->elements = {1.0, 2.0, 3.0, 4.0, 5.0};
 
     SECTION("Shift from non-empty array") {
         Value first = arr->elements.front();
         arr->elements.erase(arr->elements.begin());
 
-        REQUIRE(std::get<double>(first) == 1.0);
+        REQUIRE(first.asNumber() == 1.0);
         REQUIRE(arr->elements.size() == 4);
-        REQUIRE(std::get<double>(arr->elements[0]) == 2.0);
+        REQUIRE(arr->elements[0].asNumber() == 2.0);
     }
 }
 
 TEST_CASE("Array unshift() adds element to beginning", "[collections][array]") {
-    auto arr = std::make_shared<Array>();
+    auto arr = makeRef<Array>();
     arr->elements = {2.0, 3.0, 4.0};
 
     SECTION("Unshift to non-empty array") {
         arr->elements.insert(arr->elements.begin(), 1.0);
 
         REQUIRE(arr->elements.size() == 4);
-        REQUIRE(std::get<double>(arr->elements[0]) == 1.0);
-        REQUIRE(std::get<double>(arr->elements[1]) == 2.0);
+        REQUIRE(arr->elements[0].asNumber() == 1.0);
+        REQUIRE(arr->elements[1].asNumber() == 2.0);
     }
 }
 
 TEST_CASE("Array splice() removes elements from array", "[collections][array]") {
     SECTION("Splice with start and deleteCount") {
-        auto arr = std::make_shared<Array>();
+        auto arr = makeRef<Array>();
         arr->elements = {1.0, 2.0, 3.0, 4.0, 5.0};
 
         size_t start = 2;
         size_t deleteCount = 2;
         size_t end = std::min(start + deleteCount, arr->elements.size());
 
-        auto result = std::make_shared<Array>();
+        auto result = makeRef<Array>();
         for (size_t i = start; i < end; ++i) {
             result->elements.push_back(arr->elements[i]);
         }
         arr->elements.erase(arr->elements.begin() + start, arr->elements.begin() + end);
 
         REQUIRE(result->elements.size() == 2);
-        REQUIRE(std::get<double>(result->elements[0]) == 3.0);
-        REQUIRE(std::get<double>(result->elements[1]) == 4.0);
+        REQUIRE(result->elements[0].asNumber() == 3.0);
+        REQUIRE(result->elements[1].asNumber() == 4.0);
         REQUIRE(arr->elements.size() == 3);
-        REQUIRE(std::get<double>(arr->elements[0]) == 1.0);
-        REQUIRE(std::get<double>(arr->elements[2]) == 5.0);
+        REQUIRE(arr->elements[0].asNumber() == 1.0);
+        REQUIRE(arr->elements[2].asNumber() == 5.0);
     }
 
     SECTION("Splice with only start (remove to end)") {
-        auto arr = std::make_shared<Array>();
+        auto arr = makeRef<Array>();
         arr->elements = {10.0, 20.0, 30.0, 40.0};
 
         size_t start = 1;
         size_t end = arr->elements.size();
 
-        auto result = std::make_shared<Array>();
+        auto result = makeRef<Array>();
         for (size_t i = start; i < end; ++i) {
             result->elements.push_back(arr->elements[i]);
         }
@@ -70,14 +70,14 @@ TEST_CASE("Array splice() removes elements from array", "[collections][array]")
 
         REQUIRE(result->elements.size() == 3);
         REQUIRE(arr->elements.size() == 1);
-        REQUIRE(std::get<double>(arr->elements[0]) == 10.0);
+        REQUIRE(arr->elements[0].asNumber() == 10.0);
     }
 }
 
 // ============ Map Method Tests ============
 
 TEST_CASE("Map has() checks for key existence", "[collections][map]") {
-    auto map = std::make_shared<Map>();
+    auto map = makeRef<Map>();
     map->entries["name"] = std::string("Alice");
     map->entries["age"] = 30.0;
 
@@ -93,7 +93,7 @@ TEST_CASE("Map has() checks for key existence", "[collections][map]") {
 }
 
 TEST_CASE("Map delete() removes key-value pair", "[collections][map]") {
-    auto map = std::make_shared<Map>();
+    auto map = makeRef<Map>();
     map->entries["name"] = std::string("Alice");
     map->entries["age"] = 30.0;
     map->entries["city"] = std::string("NYC");
@@ -116,14 +116,14 @@ TEST_CASE("Map delete() removes key-value pair", "[collections][map]") {
 }
 
 TEST_CASE("Map entries() returns array of key-value pairs", "[collections][map]") {
-    auto map = std::make_shared<Map>();
+    auto map = makeRef<Map>();
     map->entries["name"] = std::string("Alice");
     map->entries["age"] = 30.0;
 
     SECTION("Entries returns correct structure") {
-        auto entriesArray = std::make_shared<Array>();
+        auto entriesArray = makeRef<Array>();
         for (const auto& [key, value] : map->entries) {
-            auto entry = std::make_shared<Array>();
+            auto entry = makeRef<Array>();
             entry->elements.push_back(key);
             entry->elements.push_back(value);
             entriesArray->elements.push_back(entry);
@@ -132,10 +132,10 @@ TEST_CASE("Map entries() returns array of key-value pairs", "[collections][map]"
         REQUIRE(entriesArray->elements.size() == 2);
         // Check that each entry is an array with 2 elements
         for (const auto& entryVal : entriesArray->elements) {
-            REQUIRE(std::holds_alternative<std::shared_ptr<Array>>(entryVal));
-            auto entry = std::get<std::shared_ptr<Array>>(entryVal);
+            REQUIRE(entryVal.isArray());
+            auto entry = entryVal.asArray();
             REQUIRE(entry->elements.size() == 2);
-            REQUIRE(std::holds_alternative<std::string>(entry->elements[0]));  // key
+            REQUIRE(entry->elements[0].isString());  // key
         }
     }
 }
@@ -143,7 +143,7 @@ TEST_CASE("Map entries() returns array of key-value pairs", "[collections][map]"
 // ============ Set Type Tests ============
 
 TEST_CASE("Set can be created and stores unique values", "[collections][set]") {
-    auto set = std::make_shared<Set>();
+    auto set = makeRef<Set>();
 
     SECTION("Empty set has size 0") {
         REQUIRE(set->values.size() == 0);
@@ -166,7 +166,7 @@ TEST_CASE("Set can be created and stores unique values", "[collections][set]") {
 }
 
 TEST_CASE("Set add() adds values to set", "[collections][set]") {
-    auto set = std::make_shared<Set>();
+    auto set = makeRef<Set>();
 
     SECTION("Add string value") {
         std::string key = "apple";
@@ -185,7 +185,7 @@ TEST_CASE("Set add() adds values to set", "[collections][set]") {
 }
 
 TEST_CASE("Set has() checks for value existence", "[collections][set]") {
-    auto set = std::make_shared<Set>();
+    auto set = makeRef<Set>();
     set->values["apple"] = std::string("apple");
     set->values["banana"] = std::string("banana");
 
@@ -201,7 +201,7 @@ TEST_CASE("Set has() checks for value existence", "[collections][set]") {
 }
 
 TEST_CASE("Set delete() removes value from set", "[collections][set]") {
-    auto set = std::make_shared<Set>();
+    auto set = makeRef<Set>();
     set->values["apple"] = std::string("apple");
     set->values["banana"] = std::string("banana");
     set->values["cherry"] = std::string("cherry");
@@ -226,7 +226,7 @@ TEST_CASE("Set delete() removes value from set", "[collections][set]") {
 }
 
 TEST_CASE("Set size() returns number of elements", "[collections][set]") {
-    auto set = std::make_shared<Set>();
+    auto set = makeRef<Set>();
 
     SECTION("Empty set has size 0") {
         REQUIRE(set->values.size() == 0);
@@ -242,7 +242,7 @@ TEST_CASE("Set size() returns number of elements", "[collections][set]") {
 }
 
 TEST_CASE("Set type name is 'set'", "[collections][set]") {
-    auto set = std::make_shared<Set>();
+    auto set = makeRef<Set>();
     Value v = set;
 
     REQUIRE(getTypeName(v) == "set");
@@ -250,13 +250,13 @@ TEST_CASE("Set type name is 'set'", "[collections][set]") {
 
 TEST_CASE("Set isTruthy is correct", "[collections][set]") {
     SECTION("Empty set is falsy") {
-        auto set = std::make_shared<Set>();
+        auto set = makeRef<Set>();
         Value v = set;
         REQUIRE(isTruthy(v) == false);
     }
 
     SECTION("Non-empty set is truthy") {
-        auto set = std::make_shared<Set>();
+        auto set = makeRef<Set>();
         set->values["a"] = std::string("a");
         Value v = set;
         REQUIRE(isTruthy(v) == true);
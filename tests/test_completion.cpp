@@ -0,0 +1,100 @@
+#include "catch.hpp"
+#include "parse/lexer.hpp"
+#include "parse/parser.hpp"
+#include "interp/interpreter.hpp"
+#include <sstream>
+
+using namespace izi;
+
+namespace {
+
+std::string run(const std::string& source) {
+    Lexer lexer(source);
+    auto tokens = lexer.scanTokens();
+    Parser parser(std::move(tokens), source);
+    auto program = parser.parse();
+
+    std::stringstream buffer;
+    std::streambuf* old = std::cout.rdbuf(buffer.rdbuf());
+    try {
+        Interpreter interp(source);
+        interp.interpret(program);
+    } catch (...) {
+        std::cout.rdbuf(old);
+        throw;
+    }
+    std::cout.rdbuf(old);
+    return buffer.str();
+}
+
+}  // namespace
+
+TEST_CASE("Interpreter: return, break and continue complete their statements", "[interp][completion]") {
+    SECTION("Return leaves nested blocks and loops") {
+        REQUIRE(run(R"(
+            fn first(limit) {
+                var i = 0;
+                while (true) {
+                    { i = i + 1; if (i > limit) { return i; } }
+                }
+            }
+            fn early(flag) { if (flag) { return "early"; } return "late"; }
+            fn none() { var x = 1; }
+            print(first(3));
+            print(early(true));
+            print(early(false));
+            print(none());
+        )") == "4\nearly\nlate\nnil\n");
+    }
+
+    SECTION("Break and continue apply to the innermost loop") {
+        REQUIRE(run(R"(
+            var sum = 0;
+            var i = 0;
+            while (i < 3) {
+                i = i + 1;
+                var j = 0;
+                while (true) {
+                    j = j + 1;
+                    if (j == 2) { continue; }
+                    if (j > 3) { break; }
+                    sum = sum + i * 10 + j;
+                }
+            }
+            print(sum);
+        )") == "132\n");
+    }
+
+    SECTION("A top-level return ends the program") {
+        REQUIRE(run("print(1); return; print(2);") == "1\n");
+    }
+
+    SECTION("Break outside a loop is an error") {
+        REQUIRE_THROWS_WITH(run("fn f() { break; } f();"), "Break statement outside of loop.");
+    }
+}
+
+TEST_CASE("Interpreter: thrown values complete to the nearest catch", "[interp][completion]") {
+    SECTION("Within a function and across calls") {
+        REQUIRE(run(R"(
+            fn local() { try { throw "a"; } catch (e) { return "local " + e; } }
+            fn thrower() { throw "b"; }
+            fn remote() { try { thrower(); } catch (e) { return "remote " + e; } }
+            print(local());
+            print(remote());
+        )") == "local a\nremote b\n");
+    }
+
+    SECTION("Finally runs before the value propagates") {
+        REQUIRE(run(R"(
+            fn inner() { try { throw "x"; } finally { print("finally"); } }
+            try { inner(); } catch (e) { print("caught " + e); }
+            try { try { throw "y"; } catch (e) { throw e + "!"; } } catch (e) { print(e); }
+        )") == "finally\ncaught x\ny!\n");
+    }
+
+    SECTION("Uncaught values leave the program") {
+        REQUIRE_THROWS_AS(run("fn f() { throw 1; } f();"), ThrowSignal);
+        REQUIRE_THROWS_AS(run("while (true) { throw 2; }"), ThrowSignal);
+    }
+}
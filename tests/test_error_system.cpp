@@ -7,7 +7,7 @@ using namespace izi;
 
 TEST_CASE("Error: Basic error creation", "[error]") {
     SECTION("Create base Error with message") {
-        auto err = std::make_shared<Error>("Something went wrong");
+        auto err = makeRef<Error>("Something went wrong");
         REQUIRE(err->message == "Something went wrong");
         REQUIRE(err->type == "Error");
         REQUIRE(err->cause == nullptr);
@@ -15,28 +15,28 @@ TEST_CASE("Error: Basic error creation", "[error]") {
     }
 
     SECTION("Error full message without cause") {
-        auto err = std::make_shared<Error>("Test error", "CustomError");
+        auto err = makeRef<Error>("Test error", "CustomError");
         REQUIRE(err->fullMessage() == "CustomError: Test error");
     }
 }
 
 TEST_CASE("Error: Named error types", "[error]") {
     SECTION("Create IOError") {
-        auto err = std::make_shared<IOError>("file not found");
+        auto err = makeRef<IOError>("file not found");
         REQUIRE(err->message == "file not found");
         REQUIRE(err->type == "IOError");
         REQUIRE(err->cause == nullptr);
     }
 
     SECTION("Create TypeError") {
-        auto err = std::make_shared<TypeError>("expected number, got string");
+        auto err = makeRef<TypeError>("expected number, got string");
         REQUIRE(err->message == "expected number, got string");
         REQUIRE(err->type == "TypeError");
         REQUIRE(err->cause == nullptr);
     }
 
     SECTION("Create ValueError") {
-        auto err = std::make_shared<ValueError>("invalid value: -1");
+        auto err = makeRef<ValueError>("invalid value: -1");
         REQUIRE(err->message == "invalid value: -1");
         REQUIRE(err->type == "ValueError");
         REQUIRE(err->cause == nullptr);
@@ -45,8 +45,8 @@ TEST_CASE("Error: Named error types", "[error]") {
 
 TEST_CASE("Error: Error chaining with cause", "[error]") {
     SECTION("Chain two errors") {
-        auto rootCause = std::make_shared<IOError>("connection timeout");
-        auto topError = std::make_shared<ValueError>("failed to fetch data", rootCause);
+        auto rootCause = makeRef<IOError>("connection timeout");
+        auto topError = makeRef<ValueError>("failed to fetch data", rootCause);
 
         REQUIRE(topError->cause != nullptr);
         REQUIRE(topError->cause->message == "connection timeout");
@@ -54,9 +54,9 @@ TEST_CASE("Error: Error chaining with cause", "[error]") {
     }
 
     SECTION("Full message with cause chain") {
-        auto rootCause = std::make_shared<IOError>("disk full");
-        auto midError = std::make_shared<Error>("write failed", "WriteError", rootCause);
-        auto topError = std::make_shared<ValueError>("save failed", midError);
+        auto rootCause = makeRef<IOError>("disk full");
+        auto midError = makeRef<Error>("write failed", "WriteError", rootCause);
+        auto topError = makeRef<ValueError>("save failed", midError);
 
         std::string fullMsg = topError->fullMessage();
         REQUIRE(fullMsg.find("ValueError: save failed") != std::string::npos);
@@ -65,9 +65,9 @@ TEST_CASE("Error: Error chaining with cause", "[error]") {
     }
 
     SECTION("Error chaining preserves cause") {
-        auto cause1 = std::make_shared<IOError>("network error");
-        auto cause2 = std::make_shared<TypeError>("type mismatch", cause1);
-        auto finalError = std::make_shared<ValueError>("validation failed", cause2);
+        auto cause1 = makeRef<IOError>("network error");
+        auto cause2 = makeRef<TypeError>("type mismatch", cause1);
+        auto finalError = makeRef<ValueError>("validation failed", cause2);
 
         REQUIRE(finalError->cause != nullptr);
         REQUIRE(finalError->cause->cause != nullptr);
@@ -77,7 +77,7 @@ TEST_CASE("Error: Error chaining with cause", "[error]") {
 
 TEST_CASE("Error: Stack traces", "[error]") {
     SECTION("Add stack frames to error") {
-        auto err = std::make_shared<Error>("runtime error");
+        auto err = makeRef<Error>("runtime error");
 
         err->addStackFrame("main", "main.izi", 10, 5);
         err->addStackFrame("helper", "utils.izi", 25, 12);
@@ -95,7 +95,7 @@ TEST_CASE("Error: Stack traces", "[error]") {
     }
 
     SECTION("Format stack trace") {
-        auto err = std::make_shared<IOError>("file not found");
+        auto err = makeRef<IOError>("file not found");
         err->addStackFrame("readFile", "io.izi", 42, 8);
         err->addStackFrame("processData", "main.izi", 15, 3);
 
@@ -108,12 +108,12 @@ TEST_CASE("Error: Stack traces", "[error]") {
     }
 
     SECTION("Empty stack trace returns empty string") {
-        auto err = std::make_shared<Error>("no trace");
+        auto err = makeRef<Error>("no trace");
         REQUIRE(err->formatStackTrace() == "");
     }
 
     SECTION("Add stack frame using StackFrame object") {
-        auto err = std::make_shared<TypeError>("type error");
+        auto err = makeRef<TypeError>("type error");
         StackFrame frame("validate", "validator.izi", 100, 20);
         err->addStackFrame(frame);
 
@@ -124,32 +124,32 @@ TEST_CASE("Error: Stack traces", "[error]") {
 
 TEST_CASE("Error: Integration with Value variant", "[error][value]") {
     SECTION("Error as Value") {
-        auto err = std::make_shared<IOError>("test error");
+        auto err = makeRef<IOError>("test error");
         Value v = err;
 
-        REQUIRE(std::holds_alternative<std::shared_ptr<Error>>(v));
-        auto extractedErr = std::get<std::shared_ptr<Error>>(v);
+        REQUIRE(v.isError());
+        auto extractedErr = v.asError();
         REQUIRE(extractedErr->message == "test error");
         REQUIRE(extractedErr->type == "IOError");
     }
 
     SECTION("getTypeName returns 'error' for Error values") {
-        auto err = std::make_shared<ValueError>("value error");
+        auto err = makeRef<ValueError>("value error");
         Value v = err;
 
         REQUIRE(getTypeName(v) == "error");
     }
 
     SECTION("isTruthy returns true for Error values") {
-        auto err = std::make_shared<TypeError>("type error");
+        auto err = makeRef<TypeError>("type error");
         Value v = err;
 
         REQUIRE(isTruthy(v) == true);
     }
 
     SECTION("valueToString formats error properly") {
-        auto rootCause = std::make_shared<IOError>("disk error");
-        auto err = std::make_shared<ValueError>("invalid input", rootCause);
+        auto rootCause = makeRef<IOError>("disk error");
+        auto err = makeRef<ValueError>("invalid input", rootCause);
         Value v = err;
 
         std::string str = valueToString(v);
@@ -160,10 +160,10 @@ TEST_CASE("Error: Integration with Value variant", "[error][value]") {
 
 TEST_CASE("Error: Stack traces preserved across error chain", "[error]") {
     SECTION("Multiple errors with different stack traces") {
-        auto cause = std::make_shared<IOError>("network timeout");
+        auto cause = makeRef<IOError>("network timeout");
         cause->addStackFrame("connect", "network.izi", 50, 10);
 
-        auto topError = std::make_shared<ValueError>("operation failed", cause);
+        auto topError = makeRef<ValueError>("operation failed", cause);
         topError->addStackFrame("performOperation", "main.izi", 20, 5);
 
         // Each error maintains its own stack trace
@@ -176,14 +176,14 @@ TEST_CASE("Error: Stack traces preserved across error chain", "[error]") {
 
 TEST_CASE("Error: Type system completeness", "[error]") {
     SECTION("All error types derive from Error") {
-        auto ioErr = std::make_shared<IOError>("io");
-        auto typeErr = std::make_shared<TypeError>("type");
-        auto valErr = std::make_shared<ValueError>("value");
+        auto ioErr = makeRef<IOError>("io");
+        auto typeErr = makeRef<TypeError>("type");
+        auto valErr = makeRef<ValueError>("value");
 
         // All should be convertible to base Error pointer
-        std::shared_ptr<Error> base1 = ioErr;
-        std::shared_ptr<Error> base2 = typeErr;
-        std::shared_ptr<Error> base3 = valErr;
+        Ref<Error> base1 = ioErr;
+        Ref<Error> base2 = typeErr;
+        Ref<Error> base3 = valErr;
 
         REQUIRE(base1->type == "IOError");
         REQUIRE(base2->type == "TypeError");
@@ -0,0 +1,170 @@
+#include "catch.hpp"
+#include "parse/lexer.hpp"
+#include "parse/parser.hpp"
+#include "compile/compiler.hpp"
+#include "bytecode/vm.hpp"
+#include "bytecode/vm_native.hpp"
+#include "interp/interpreter.hpp"
+#include "interp/izi_class.hpp"
+#include "common/gc.hpp"
+
+using namespace izi;
+
+namespace {
+
+std::vector<StmtPtr> parseSource(const std::string& source) {
+    Lexer lexer(source);
+    auto tokens = lexer.scanTokens();
+    Parser parser(std::move(tokens), source);
+    return parser.parse();
+}
+
+// An array that records when it is freed
+struct ProbeArray : Array {
+    explicit ProbeArray(bool& freed) : freed(freed) {}
+    ~ProbeArray() override { freed = true; }
+    bool& freed;
+};
+
+// Each iteration leaves behind two instances pointing at each other, a map
+// holding itself, an array holding itself and a closure that captures itself
+const std::string cycleScript = R"(
+class Node {
+    var other;
+    fn init() { this.other = nil; }
+}
+fn makeCounter() {
+    var count = 0;
+    fn step() { count = count + 1; return step; }
+    return step;
+}
+var i = 0;
+while (i < 300) {
+    var a = Node();
+    var b = Node();
+    a.other = b;
+    b.other = a;
+    var m = {};
+    m["self"] = m;
+    var f = makeCounter();
+    f();
+    var arr = [1, 2];
+    arr[0] = arr;
+    i = i + 1;
+}
+)";
+
+}  // namespace
+
+TEST_CASE("Gc: frees a container that holds itself", "[gc]") {
+    Gc::collect();
+    size_t before = Gc::liveObjects();
+
+    bool freed = false;
+    Value array(Ref<Array>(makeRef<ProbeArray>(freed)));
+    array.asArray()->elements.push_back(array);
+
+    Value map(makeRef<Map>());
+    map.asMap()->entries["self"] = map;
+    map.asMap()->entries["array"] = array;
+
+    array = Value();
+    map = Value();
+    REQUIRE_FALSE(freed);
+    REQUIRE(Gc::liveObjects() == before + 2);
+
+    REQUIRE(Gc::collect() == 2);
+    REQUIRE(freed);
+    REQUIRE(Gc::liveObjects() == before);
+}
+
+TEST_CASE("Gc: keeps cycles that are still referenced", "[gc]") {
+    Value outer(makeRef<Array>());
+    Value inner(makeRef<Map>());
+    outer.asArray()->elements.push_back(inner);
+    inner.asMap()->entries["parent"] = outer;
+    inner.asMap()->entries["name"] = Value("inner");
+
+    // Held only through a copy of the Value and a bare Ref
+    Value copy = outer;
+    outer = Value();
+    Ref<Map> direct = inner.asMap();
+    inner = Value();
+
+    REQUIRE(Gc::collect() == 0);
+    REQUIRE(copy.asArray()->elements.size() == 1);
+    REQUIRE(direct->entries.at("name").asString() == "inner");
+
+    copy = Value();
+    REQUIRE(Gc::collect() == 0);  // The map still holds the array
+    REQUIRE(direct->entries.at("parent").asArray()->elements.size() == 1);
+    direct.reset();
+    REQUIRE(Gc::collect() == 2);
+}
+
+TEST_CASE("Gc: VM cycles of instances, maps and closures are reclaimed", "[gc]") {
+    Gc::collect();
+    size_t before = Gc::liveObjects();
+    {
+        auto program = parseSource(cycleScript);
+        BytecodeCompiler compiler;
+        Chunk chunk = compiler.compile(program);
+        VM vm;
+        registerVmNatives(vm);
+        (void)vm.run(chunk);
+        // Two instances, a map, an array and a closure for every iteration
+        // but the last, whose objects the globals still reach
+        REQUIRE(Gc::collect() == 5 * 299);
+    }
+    Gc::collect();
+    REQUIRE(Gc::liveObjects() == before);
+}
+
+TEST_CASE("Gc: interpreter cycles are reclaimed once their environments are gone", "[gc]") {
+    Gc::collect();
+    size_t before = Gc::liveObjects();
+    {
+        auto program = parseSource(cycleScript);
+        Interpreter interp(cycleScript);
+        interp.interpret(program);
+        // The loop body's environment is recycled every iteration, so the
+        // instances, maps, arrays and closures are garbage while the
+        // interpreter still runs
+        REQUIRE(Gc::collect() >= 5 * 300);
+    }
+    // The top-level functions and the globals they close over
+    Gc::collect();
+    REQUIRE(Gc::liveObjects() == before);
+}
+
+TEST_CASE("Gc: interpreter cycles through captured call environments are reclaimed", "[gc]") {
+    // Each call's environment holds an instance whose field is a closure over
+    // that same environment, and a map holding a closure that captures it
+    const std::string source = R"(
+class Box {
+    var value;
+    fn init() { this.value = nil; }
+}
+fn tangle(n) {
+    var box = Box();
+    box.value = fn() { return box; };
+    var table = {};
+    table["get"] = fn() { return table; };
+    return n;
+}
+var i = 0;
+while (i < 200) {
+    tangle(i);
+    i = i + 1;
+}
+)";
+    Gc::collect();
+    size_t before = Gc::liveObjects();
+    auto program = parseSource(source);
+    Interpreter interp(source);
+    interp.interpret(program);
+    // A box, a map and two closures per call, freed with the interpreter
+    // still alive
+    REQUIRE(Gc::collect() >= 4 * 200);
+    REQUIRE(Gc::liveObjects() < before + 10);
+}
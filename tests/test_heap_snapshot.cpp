@@ -0,0 +1,136 @@
+#include "catch.hpp"
+#include "parse/lexer.hpp"
+#include "parse/parser.hpp"
+#include "compile/compiler.hpp"
+#include "bytecode/heap_snapshot.hpp"
+#include "bytecode/vm.hpp"
+#include "bytecode/vm_native.hpp"
+
+#include <sstream>
+
+using namespace izi;
+
+namespace {
+
+Chunk compileSource(const std::string& source) {
+    Lexer lexer(source);
+    auto tokens = lexer.scanTokens();
+    Parser parser(std::move(tokens), source);
+    auto program = parser.parse();
+    BytecodeCompiler compiler;
+    return compiler.compile(program);
+}
+
+// Run `init` in one VM, restore its snapshot into a second VM and run `use` there
+std::string initializeThenRun(const std::string& init, const std::string& use) {
+    std::string snapshot;
+    {
+        VM vm;
+        registerVmNatives(vm);
+        Chunk chunk = compileSource(init);
+        (void)vm.run(chunk);
+        snapshot = HeapSnapshot::save(vm);
+    }
+
+    std::ostringstream out;
+    std::streambuf* old = std::cout.rdbuf(out.rdbuf());
+    try {
+        VM vm;
+        registerVmNatives(vm);
+        HeapSnapshot::restore(vm, snapshot.data(), snapshot.size());
+        Chunk chunk = compileSource(use);
+        (void)vm.run(chunk);
+    } catch (...) {
+        std::cout.rdbuf(old);
+        throw;
+    }
+    std::cout.rdbuf(old);
+    return out.str();
+}
+
+}  // namespace
+
+TEST_CASE("Heap snapshots: data structures keep sharing and cycles", "[heap-snapshot]") {
+    std::string out = initializeThenRun(R"(
+        var shared = [1, 2, 3];
+        var pair = [shared, shared];
+        var node = {"name": "loop"};
+        node["self"] = node;
+        var flags = Set();
+        setAdd(flags, "on");
+        var mixed = [nil, true, 2.5, "text"];
+    )",
+                                        R"(
+        shared[0] = 99;
+        print(pair[1][0], node["self"]["self"]["name"], setHas(flags, "on"), mixed);
+    )");
+    REQUIRE(out == "99 loop true [nil, true, 2.5, text]\n");
+}
+
+TEST_CASE("Heap snapshots: closures keep their shared upvalue cells", "[heap-snapshot]") {
+    std::string out = initializeThenRun(R"(
+        fn makeCounter() {
+            var count = 0;
+            fn inc() { count = count + 1; return count; }
+            fn get() { return count; }
+            return [inc, get];
+        }
+        var counter = makeCounter();
+        counter[0]();
+        counter[0]();
+    )",
+                                        R"(
+        var inc = counter[0];
+        var get = counter[1];
+        inc();
+        print(get());
+    )");
+    REQUIRE(out == "3\n");
+}
+
+TEST_CASE("Heap snapshots: classes, instances and bound methods", "[heap-snapshot]") {
+    std::string out = initializeThenRun(R"(
+        class Animal {
+            fn init(name) { this.name = name; }
+            fn speak() { return this.name + " makes a sound"; }
+        }
+        class Dog extends Animal {
+            fn speak() { return this.name + " barks"; }
+        }
+        var rex = Dog("Rex");
+        rex.age = 3;
+        var speak = rex.speak;
+    )",
+                                        R"(
+        print(rex.speak(), rex.age, speak(), Dog("Fido").speak(), Animal("Cat").speak());
+    )");
+    REQUIRE(out == "Rex barks 3 Rex barks Fido barks Cat makes a sound\n");
+}
+
+TEST_CASE("Heap snapshots: natives are re-bound in the restoring VM", "[heap-snapshot]") {
+    std::string out = initializeThenRun(R"(
+        import "math";
+        var root = math.sqrt;
+        var say = print;
+    )",
+                                        R"(
+        say(root(81), math.floor(2.5));
+    )");
+    REQUIRE(out == "9 2\n");
+}
+
+TEST_CASE("Heap snapshots: damaged snapshots are rejected", "[heap-snapshot]") {
+    VM vm;
+    registerVmNatives(vm);
+    Chunk chunk = compileSource("var list = [1, 2, 3]; var name = \"x\";");
+    (void)vm.run(chunk);
+    std::string snapshot = HeapSnapshot::save(vm);
+
+    VM target;
+    registerVmNatives(target);
+    REQUIRE_THROWS_AS(HeapSnapshot::restore(target, snapshot.data(), snapshot.size() - 3), std::runtime_error);
+    std::string wrongMagic = snapshot;
+    wrongMagic[0] = 'X';
+    REQUIRE_THROWS_WITH(HeapSnapshot::restore(target, wrongMagic.data(), wrongMagic.size()),
+                        Catch::Contains("magic"));
+}
@@ -0,0 +1,201 @@
+#include "catch.hpp"
+#include "parse/lexer.hpp"
+#include "parse/parser.hpp"
+#include "compile/compiler.hpp"
+#include "bytecode/jit.hpp"
+#include "bytecode/vm.hpp"
+#include "bytecode/vm_native.hpp"
+
+#include <sstream>
+
+using namespace izi;
+
+namespace {
+
+Chunk compileSource(const std::string& source) {
+    Lexer lexer(source);
+    auto tokens = lexer.scanTokens();
+    Parser parser(std::move(tokens), source);
+    auto program = parser.parse();
+    BytecodeCompiler compiler;
+    return compiler.compile(program);
+}
+
+// Output of the program; the JIT is on with `threshold` when `jit` is set
+std::string runVm(const Chunk& chunk, bool jit, uint32_t threshold = 0) {
+    std::ostringstream out;
+    std::streambuf* old = std::cout.rdbuf(out.rdbuf());
+    VM vm;
+    registerVmNatives(vm);
+    if (jit) {
+        vm.enableJit(threshold);
+    } else {
+        vm.disableJit();
+    }
+    try {
+        (void)vm.run(chunk);
+    } catch (...) {
+        std::cout.rdbuf(old);
+        throw;
+    }
+    std::cout.rdbuf(old);
+    return out.str();
+}
+
+void requireSameAsInterpreter(const std::string& source) {
+    const std::string expected = runVm(compileSource(source), false);
+    Chunk chunk = compileSource(source);
+    const std::string actual = runVm(chunk, true);
+    REQUIRE(actual == expected);
+    if (jitSupported()) {
+        REQUIRE(chunk.jitCode);
+        REQUIRE(chunk.jitCode->compiled());
+    }
+}
+
+}  // namespace
+
+TEST_CASE("JIT: numeric kernels match the interpreter", "[jit]") {
+    requireSameAsInterpreter(R"(
+        fn kernel(n) {
+            var sum = 0;
+            var i = 0;
+            while (i < n) {
+                sum = sum + i * 2 - 1;
+                if (i % 3 == 0) sum = sum / 2;
+                i = i + 1;
+            }
+            return sum;
+        }
+        print(kernel(1000));
+        var total = 0;
+        for (var k = 0; k < 50; k = k + 1) {
+            total = total + kernel(k);
+        }
+        print(total);
+        print(-total);
+        print(1 < 2, 2 <= 2, 3 > 4, 4 >= 5, 1 == 1, 1 != 1, !true, !nil);
+        print(0 / 0 < 1, 0 / 0 >= 1, -0);
+    )");
+}
+
+TEST_CASE("JIT: arrays, globals and upvalues", "[jit]") {
+    requireSameAsInterpreter(R"(
+        var data = [];
+        var i = 0;
+        while (i < 100) {
+            push(data, i * i);
+            i = i + 1;
+        }
+        var sum = 0;
+        var j = 0;
+        while (j < len(data)) {
+            sum = sum + data[j];
+            j = j + 1;
+        }
+        print(sum);
+
+        fn counter() {
+            var count = 0;
+            return fn() {
+                count = count + 1;
+                return count;
+            };
+        }
+        var next = counter();
+        var last = 0;
+        var k = 0;
+        while (k < 10) { last = next(); k = k + 1; }
+        print(last);
+    )");
+}
+
+TEST_CASE("JIT: guard failures fall back to the interpreter", "[jit]") {
+    requireSameAsInterpreter(R"(
+        fn add(a, b) { return a + b; }
+        fn at(c, k) { return c[k]; }
+        fn check(x) { if (x) return "yes"; return "no"; }
+        var i = 0;
+        while (i < 20) { add(i, i); i = i + 1; }
+        print(add("ab", "cd"));
+        print(add(1.5, 2));
+        print(at([1, 2, 3], 2));
+        print(at({"k": "map"}, "k"));
+        print(check(0), check(1), check(""), check("s"), check([]), check(nil), check(true));
+        try {
+            at([1, 2], 5);
+        } catch (e) {
+            print("caught " + e);
+        }
+        try {
+            at([1, 2], 0.5);
+        } catch (e) {
+            print("caught " + e);
+        }
+        fn useUndefined() { return notDefinedYet; }
+        try {
+            useUndefined();
+        } catch (e) {
+            print("caught " + e);
+        }
+        var notDefinedYet = "defined";
+        print(useUndefined());
+    )");
+}
+
+TEST_CASE("JIT: chunks compile only once they are hot", "[jit]") {
+    if (!jitSupported()) {
+        return;
+    }
+    Chunk chunk = compileSource(R"(
+        fn square(x) { return x * x; }
+        var i = 0;
+        var sum = 0;
+        while (i < 3) { sum = sum + square(i); i = i + 1; }
+        print(sum);
+    )");
+    REQUIRE(runVm(chunk, true, 100) == "5\n");
+    REQUIRE_FALSE(chunk.jitCode);
+
+    Chunk hot = compileSource(R"(
+        var i = 0;
+        while (i < 500) { i = i + 1; }
+        print(i);
+    )");
+    REQUIRE(runVm(hot, true, 100) == "500\n");
+    REQUIRE(hot.jitCode);
+    REQUIRE(hot.jitCode->compiled());
+}
+
+TEST_CASE("JIT: loops leave native code to reach a safepoint", "[jit]") {
+    if (!jitSupported()) {
+        return;
+    }
+    Chunk script = compileSource(R"(
+        fn count(n) {
+            var i = 0;
+            while (i < n) { i = i + 1; }
+            return i;
+        }
+    )");
+    const Chunk* body = nullptr;
+    for (const auto& constant : script.constants) {
+        if (constant.isVmCallable()) {
+            body = &staticRefCast<VmUserFunction>(constant.asVmCallable())->getChunk();
+        }
+    }
+    REQUIRE(body != nullptr);
+    auto native = compileChunk(*body);
+    REQUIRE(native->compiled());
+
+    // Locals only, so the loop needs neither a VM nor a frame
+    std::vector<Value> stack(16);
+    stack[0] = Value(1000000.0);
+    JitContext context{stack.data() + 1, stack.data(), body->constants.data(), stack.data() + stack.size(),
+                       nullptr, nullptr};
+    context.backEdgesLeft = 5;
+    uint32_t offset = native->run(context, 0);
+
+    REQUIRE(static_cast<OpCode>(body->code[offset]) == OpCode::LOOP);
+    REQUIRE(stack[1].asNumber() == 5);
+}
@@ -0,0 +1,83 @@
+#include "catch.hpp"
+#include "parse/lexer.hpp"
+#include "parse/parser.hpp"
+#include "ast/expr.hpp"
+#include "ast/node_pool.hpp"
+#include <thread>
+
+using namespace izi;
+
+namespace {
+
+std::vector<StmtPtr> parseSource(const std::string& source) {
+    Lexer lexer(source);
+    auto tokens = lexer.scanTokens();
+    Parser parser(std::move(tokens), source);
+    return parser.parse();
+}
+
+const std::string poolSource = R"(
+fn area(shape) {
+    var kind = shape["kind"];
+    if (kind == "square") { return shape["side"] * shape["side"]; }
+    return match kind { "circle" => 3.14 * shape["r"] * shape["r"], _ => 0 };
+}
+class Counter {
+    fn init() { this.count = 0; }
+    fn add(n) { this.count = this.count + n; return this; }
+}
+var total = 0;
+while (total < 10) { total = total + area({"kind": "square", "side": 2}); }
+)";
+
+}  // namespace
+
+TEST_CASE("NodePool: a parse's arena is released with its tree", "[ast][pool]") {
+    size_t before = NodePool::reservedBytes();
+    auto program = parseSource(poolSource);
+    REQUIRE(program.size() == 4);
+    REQUIRE(NodePool::reservedBytes() > before);
+    program.clear();
+    REQUIRE(NodePool::reservedBytes() == before);
+}
+
+TEST_CASE("NodePool: any node kept alive keeps its arena", "[ast][pool]") {
+    size_t before = NodePool::reservedBytes();
+    auto program = parseSource(poolSource);
+    StmtPtr kept = std::move(program[0]);
+    program.clear();
+    REQUIRE(NodePool::reservedBytes() > before);
+
+    auto* fn = dynamic_cast<FunctionStmt*>(kept.get());
+    REQUIRE(fn != nullptr);
+    REQUIRE(fn->body.size() == 3);
+    kept.reset();
+    REQUIRE(NodePool::reservedBytes() == before);
+}
+
+TEST_CASE("NodePool: nodes made outside a parse use the heap", "[ast][pool]") {
+    size_t before = NodePool::reservedBytes();
+    ExprPtr literal = std::make_unique<LiteralExpr>(Value(1.0));
+    REQUIRE(NodePool::reservedBytes() == before);
+    literal.reset();
+}
+
+TEST_CASE("NodePool: nodes outlive the thread that parsed them", "[ast][pool]") {
+    std::vector<StmtPtr> program;
+    std::thread worker([&program] { program = parseSource(poolSource); });
+    worker.join();
+
+    auto* fn = dynamic_cast<FunctionStmt*>(program[0].get());
+    REQUIRE(fn != nullptr);
+    REQUIRE(fn->name == "area");
+    REQUIRE(fn->body.size() == 3);
+    program.clear();
+}
+
+TEST_CASE("NodePool: a tree freed on another thread releases its arena", "[ast][pool]") {
+    size_t before = NodePool::reservedBytes();
+    auto program = parseSource(poolSource);
+    std::thread worker([&program] { program.clear(); });
+    worker.join();
+    REQUIRE(NodePool::reservedBytes() == before);
+}
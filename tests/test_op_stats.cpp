@@ -0,0 +1,85 @@
+#include "catch.hpp"
+#include "parse/lexer.hpp"
+#include "parse/parser.hpp"
+#include "compile/compiler.hpp"
+#include "bytecode/op_stats.hpp"
+#include "bytecode/vm.hpp"
+#include "bytecode/vm_native.hpp"
+
+#include <sstream>
+
+using namespace izi;
+
+namespace {
+
+Chunk compileSource(const std::string& source) {
+    Lexer lexer(source);
+    auto tokens = lexer.scanTokens();
+    Parser parser(std::move(tokens), source);
+    auto program = parser.parse();
+    BytecodeCompiler compiler;
+    return compiler.compile(program);
+}
+
+// Output of the script, run with `stats` attached
+std::string runWithStats(const std::string& source, OpStats& stats) {
+    Chunk chunk = compileSource(source);
+    std::ostringstream out;
+    std::streambuf* old = std::cout.rdbuf(out.rdbuf());
+    VM vm;
+    registerVmNatives(vm);
+    vm.setOpStats(&stats);
+    (void)vm.run(chunk);
+    std::cout.rdbuf(old);
+    return out.str();
+}
+
+const std::string loopScript = R"(
+fn count(n) {
+    var i = 0;
+    while (i < n) {
+        i = i + 1;
+    }
+    return i;
+}
+print(count(10));
+)";
+
+}  // namespace
+
+TEST_CASE("OpStats: counts every dispatched opcode and pair", "[opstats]") {
+    OpStats stats;
+    REQUIRE(runWithStats(loopScript, stats) == "10\n");
+
+    REQUIRE(stats.count(OpCode::LOOP) == 10);
+    REQUIRE(stats.count(OpCode::CALL) == 2);  // count() and print()
+    REQUIRE(stats.count(OpCode::RETURN) == 2);  // count() and the script
+    REQUIRE(stats.pairCount(OpCode::LOOP, OpCode::GET_LOCAL_1) == 10);
+
+    // Per-opcode counts add up to the total
+    uint64_t total = 0;
+    for (size_t op = 0; op < OPCODE_COUNT; ++op) {
+        total += stats.count(static_cast<OpCode>(op));
+    }
+    REQUIRE(total == stats.instructions());
+}
+
+TEST_CASE("OpStats: table and JSON break counts down per function", "[opstats]") {
+    OpStats stats;
+    (void)runWithStats(loopScript, stats);
+
+    std::ostringstream table;
+    stats.writeTable(table);
+    REQUIRE(table.str().find("Opcode statistics: " + std::to_string(stats.instructions()) + " instructions") == 0);
+    REQUIRE(table.str().find("LOOP -> GET_LOCAL_1") != std::string::npos);
+    REQUIRE(table.str().find("  count:3 ") != std::string::npos);
+    REQUIRE(table.str().find("  <script>:2 ") != std::string::npos);
+
+    std::ostringstream json;
+    stats.writeJson(json);
+    const std::string text = json.str();
+    REQUIRE(text.find("{\"instructions\":" + std::to_string(stats.instructions()) + ",") == 0);
+    REQUIRE(text.find("{\"first\":\"LOOP\",\"second\":\"GET_LOCAL_1\",\"count\":10}") != std::string::npos);
+    REQUIRE(text.find("{\"name\":\"count\",\"line\":3,") != std::string::npos);
+    REQUIRE(text.find("{\"opcode\":\"LOOP\",\"count\":10,") != std::string::npos);
+}
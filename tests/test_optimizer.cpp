@@ -31,8 +31,8 @@ TEST_CASE("Optimizer: Constant folding for binary expressions", "[optimizer][con
 
         auto* literal = dynamic_cast<LiteralExpr*>(varStmt->initializer.get());
         REQUIRE(literal != nullptr);
-        REQUIRE(std::holds_alternative<double>(literal->value));
-        REQUIRE(std::get<double>(literal->value) == 5.0);
+        REQUIRE(literal->value.isNumber());
+        REQUIRE(literal->value.asNumber() == 5.0);
     }
 
     SECTION("Subtraction") {
@@ -42,7 +42,7 @@ TEST_CASE("Optimizer: Constant folding for binary expressions", "[optimizer][con
 
         auto* varStmt = dynamic_cast<VarStmt*>(optimized[0].get());
         auto* literal = dynamic_cast<LiteralExpr*>(varStmt->initializer.get());
-        REQUIRE(std::get<double>(literal->value) == 6.0);
+        REQUIRE(literal->value.asNumber() == 6.0);
     }
 
     SECTION("Multiplication") {
@@ -52,7 +52,7 @@ TEST_CASE("Optimizer: Constant folding for binary expressions", "[optimizer][con
 
         auto* varStmt = dynamic_cast<VarStmt*>(optimized[0].get());
         auto* literal = dynamic_cast<LiteralExpr*>(varStmt->initializer.get());
-        REQUIRE(std::get<double>(literal->value) == 30.0);
+        REQUIRE(literal->value.asNumber() == 30.0);
     }
 
     SECTION("Division") {
@@ -62,7 +62,7 @@ TEST_CASE("Optimizer: Constant folding for binary expressions", "[optimizer][con
 
         auto* varStmt = dynamic_cast<VarStmt*>(optimized[0].get());
         auto* literal = dynamic_cast<LiteralExpr*>(varStmt->initializer.get());
-        REQUIRE(std::get<double>(literal->value) == 5.0);
+        REQUIRE(literal->value.asNumber() == 5.0);
     }
 
     SECTION("Comparison operators") {
@@ -72,8 +72,8 @@ TEST_CASE("Optimizer: Constant folding for binary expressions", "[optimizer][con
 
         auto* varStmt = dynamic_cast<VarStmt*>(optimized[0].get());
         auto* literal = dynamic_cast<LiteralExpr*>(varStmt->initializer.get());
-        REQUIRE(std::holds_alternative<bool>(literal->value));
-        REQUIRE(std::get<bool>(literal->value) == true);
+        REQUIRE(literal->value.isBool());
+        REQUIRE(literal->value.asBool() == true);
     }
 }
 
@@ -85,7 +85,7 @@ TEST_CASE("Optimizer: Constant folding for unary expressions", "[optimizer][cons
 
         auto* varStmt = dynamic_cast<VarStmt*>(optimized[0].get());
         auto* literal = dynamic_cast<LiteralExpr*>(varStmt->initializer.get());
-        REQUIRE(std::get<double>(literal->value) == -5.0);
+        REQUIRE(literal->value.asNumber() == -5.0);
     }
 
     SECTION("Logical NOT") {
@@ -95,8 +95,8 @@ TEST_CASE("Optimizer: Constant folding for unary expressions", "[optimizer][cons
 
         auto* varStmt = dynamic_cast<VarStmt*>(optimized[0].get());
         auto* literal = dynamic_cast<LiteralExpr*>(varStmt->initializer.get());
-        REQUIRE(std::holds_alternative<bool>(literal->value));
-        REQUIRE(std::get<bool>(literal->value) == true);
+        REQUIRE(literal->value.isBool());
+        REQUIRE(literal->value.asBool() == true);
     }
 }
 
@@ -207,8 +207,8 @@ TEST_CASE("Register allocation: function parameters use GET_LOCAL", "[optimizer]
         // Verify the function chunk uses GET_LOCAL, not GET_GLOBAL.
         REQUIRE(!chunk.constants.empty());
         auto& fnVal = chunk.constants[0];
-        REQUIRE(std::holds_alternative<std::shared_ptr<VmCallable>>(fnVal));
-        auto callable = std::get<std::shared_ptr<VmCallable>>(fnVal);
+        REQUIRE(fnVal.isVmCallable());
+        auto callable = fnVal.asVmCallable();
         auto* userFn = dynamic_cast<VmUserFunction*>(callable.get());
         REQUIRE(userFn != nullptr);
 
@@ -220,6 +220,8 @@ TEST_CASE("Register allocation: function parameters use GET_LOCAL", "[optimizer]
             if (op == OpCode::GET_LOCAL) {
                 hasGetLocal = true;
                 ++i;  // advance past slot operand byte
+            } else if (op >= OpCode::GET_LOCAL_0 && op <= OpCode::GET_LOCAL_3) {
+                hasGetLocal = true;  // Slots 0-3 have operand-free forms
             } else if (op == OpCode::GET_GLOBAL) {
                 // A GET_GLOBAL whose name is "n" means the param wasn't allocated locally.
                 ++i;  // advance i from opcode to name-index operand byte
@@ -266,8 +268,8 @@ TEST_CASE("Register allocation: function calls produce correct results", "[optim
         const auto& globals = vm.getGlobals();
         auto it = globals.find("r");
         REQUIRE(it != globals.end());
-        REQUIRE(std::holds_alternative<double>(it->second));
-        REQUIRE(std::get<double>(it->second) == -7.0);
+        REQUIRE(it->second.isNumber());
+        REQUIRE(it->second.asNumber() == -7.0);
     }
 
     SECTION("Multi-parameter function") {
@@ -291,8 +293,8 @@ TEST_CASE("Register allocation: function calls produce correct results", "[optim
         const auto& globals = vm.getGlobals();
         auto it = globals.find("r");
         REQUIRE(it != globals.end());
-        REQUIRE(std::holds_alternative<double>(it->second));
-        REQUIRE(std::get<double>(it->second) == 7.0);
+        REQUIRE(it->second.isNumber());
+        REQUIRE(it->second.asNumber() == 7.0);
     }
 
     SECTION("Recursive function") {
@@ -319,7 +321,7 @@ TEST_CASE("Register allocation: function calls produce correct results", "[optim
         const auto& globals = vm.getGlobals();
         auto it = globals.find("r");
         REQUIRE(it != globals.end());
-        REQUIRE(std::holds_alternative<double>(it->second));
-        REQUIRE(std::get<double>(it->second) == 120.0);
+        REQUIRE(it->second.isNumber());
+        REQUIRE(it->second.asNumber() == 120.0);
     }
 }
@@ -197,7 +197,7 @@ TEST_CASE("Parser handles return statements", "[parser][core]") {
         REQUIRE(ret->value != nullptr);
         auto* lit = dynamic_cast<LiteralExpr*>(ret->value.get());
         REQUIRE(lit != nullptr);
-        REQUIRE(std::get<double>(lit->value) == 42.0);
+        REQUIRE(lit->value.asNumber() == 42.0);
     }
 
     SECTION("Parse return with complex expression") {
@@ -329,25 +329,25 @@ TEST_CASE("Parser handles expressions", "[parser][core]") {
         REQUIRE(nVar != nullptr);
         auto* numLit = dynamic_cast<LiteralExpr*>(nVar->initializer.get());
         REQUIRE(numLit != nullptr);
-        REQUIRE(std::get<double>(numLit->value) == Approx(3.14));
+        REQUIRE(numLit->value.asNumber() == Approx(3.14));
 
         auto* sVar = dynamic_cast<VarStmt*>(stmts[1].get());
         REQUIRE(sVar != nullptr);
         auto* strLit = dynamic_cast<LiteralExpr*>(sVar->initializer.get());
         REQUIRE(strLit != nullptr);
-        REQUIRE(std::get<std::string>(strLit->value) == "hello");
+        REQUIRE(strLit->value.asString() == "hello");
 
         auto* bVar = dynamic_cast<VarStmt*>(stmts[2].get());
         REQUIRE(bVar != nullptr);
         auto* boolLit = dynamic_cast<LiteralExpr*>(bVar->initializer.get());
         REQUIRE(boolLit != nullptr);
-        REQUIRE(std::get<bool>(boolLit->value) == true);
+        REQUIRE(boolLit->value.asBool() == true);
 
         auto* zVar = dynamic_cast<VarStmt*>(stmts[3].get());
         REQUIRE(zVar != nullptr);
         auto* nilLit = dynamic_cast<LiteralExpr*>(zVar->initializer.get());
         REQUIRE(nilLit != nullptr);
-        REQUIRE(std::holds_alternative<Nil>(nilLit->value));
+        REQUIRE(nilLit->value.isNil());
     }
 }
 
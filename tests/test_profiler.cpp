@@ -0,0 +1,116 @@
+#include "catch.hpp"
+#include "parse/lexer.hpp"
+#include "parse/parser.hpp"
+#include "compile/compiler.hpp"
+#include "bytecode/vm.hpp"
+#include "bytecode/vm_native.hpp"
+#include "common/profiler.hpp"
+#include "interp/profiler_hook.hpp"
+
+#include <sstream>
+
+using namespace izi;
+
+namespace {
+
+std::vector<StmtPtr> parseSource(const std::string& source) {
+    Lexer lexer(source);
+    auto tokens = lexer.scanTokens();
+    Parser parser(std::move(tokens), source);
+    return parser.parse();
+}
+
+// CPU-bound: the timer counts CPU time, so every call collects samples
+const std::string busyScript = R"(
+fn inner(n) {
+    var s = 0;
+    var i = 0;
+    while (i < n) {
+        s = s + i;
+        i = i + 1;
+    }
+    return s;
+}
+fn outer(n) {
+    return inner(n);
+}
+outer(200000);
+)";
+
+}  // namespace
+
+TEST_CASE("Profiler: folded stacks and the self/total table", "[profiler]") {
+    Profiler profiler(100);
+    profiler.beginSample();
+    profiler.addFrame("<script>", 10);
+    profiler.addFrame("fib", 3);
+    profiler.addFrame("fib", 3);
+    profiler.endSample(3);
+    profiler.beginSample();
+    profiler.addFrame("<script>", 11);
+    profiler.addFrame("loop", 0);
+    profiler.endSample(1);
+    profiler.beginSample();
+    profiler.addFrame("<script>", 10);
+    profiler.addFrame("fib", 3);
+    profiler.addFrame("fib", 3);
+    profiler.endSample(2);
+    REQUIRE(profiler.totalSamples() == 6);
+
+    std::ostringstream folded;
+    profiler.writeFolded(folded);
+    REQUIRE(folded.str() == "<script>:10;fib:3;fib:3 5\n<script>:11;loop 1\n");
+
+    std::ostringstream table;
+    profiler.writeTable(table, 2);
+    const std::string text = table.str();
+    REQUIRE(text.find("6 samples at 100 Hz") != std::string::npos);
+    // Recursion counts once toward total; only the top 2 by self are listed
+    REQUIRE(text.find("       5  83.3%        5  83.3%  fib\n") != std::string::npos);
+    REQUIRE(text.find("       1  16.7%        1  16.7%  loop\n") != std::string::npos);
+    REQUIRE(text.find("<script>") == std::string::npos);
+}
+
+#ifndef _WIN32
+TEST_CASE("Profiler: samples the VM call stack with lines", "[profiler]") {
+    BytecodeCompiler compiler;
+    auto program = parseSource(busyScript);
+    Chunk chunk = compiler.compile(program);
+
+    Profiler profiler(1000);
+    REQUIRE(profiler.start());
+    Profiler second;
+    REQUIRE_FALSE(second.start());  // One timer per process
+    for (int i = 0; i < 200 && profiler.totalSamples() < 5; ++i) {
+        VM vm;
+        registerVmNatives(vm);
+        vm.setProfiler(&profiler);
+        (void)vm.run(chunk);
+    }
+    profiler.stop();
+    REQUIRE(profiler.totalSamples() >= 5);
+
+    std::ostringstream folded;
+    profiler.writeFolded(folded);
+    REQUIRE(folded.str().find("<script>:14;outer:12;inner:") != std::string::npos);
+}
+
+TEST_CASE("Profiler: samples the interpreter call stack through its debug hook", "[profiler]") {
+    auto program = parseSource(busyScript);
+
+    Profiler profiler(1000);
+    REQUIRE(profiler.start());
+    for (int i = 0; i < 200 && profiler.totalSamples() < 5; ++i) {
+        ProfilerHook hook(profiler);
+        Interpreter interp(busyScript);
+        interp.setDebugHook(&hook);
+        interp.interpret(program);
+    }
+    profiler.stop();
+    REQUIRE(profiler.totalSamples() >= 5);
+
+    std::ostringstream folded;
+    profiler.writeFolded(folded);
+    REQUIRE(folded.str().find("<script>:14;outer:12;inner:") != std::string::npos);
+}
+#endif
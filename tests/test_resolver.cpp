@@ -0,0 +1,190 @@
+#include "catch.hpp"
+#include "parse/lexer.hpp"
+#include "parse/parser.hpp"
+#include "interp/interpreter.hpp"
+#include "interp/resolver.hpp"
+#include <sstream>
+
+using namespace izi;
+
+namespace {
+
+std::vector<StmtPtr> parseSource(const std::string& source) {
+    Lexer lexer(source);
+    auto tokens = lexer.scanTokens();
+    Parser parser(std::move(tokens), source);
+    return parser.parse();
+}
+
+std::string run(const std::string& source) {
+    auto program = parseSource(source);
+    std::stringstream buffer;
+    std::streambuf* old = std::cout.rdbuf(buffer.rdbuf());
+    try {
+        Interpreter interp(source);
+        interp.interpret(program);
+    } catch (...) {
+        std::cout.rdbuf(old);
+        throw;
+    }
+    std::cout.rdbuf(old);
+    return buffer.str();
+}
+
+}  // namespace
+
+TEST_CASE("Resolver: locals get (depth, slot) pairs", "[resolver]") {
+    auto program = parseSource(R"(
+        var top = 1;
+        fn outer(a, b) {
+            var c = a;
+            {
+                var d = b;
+                return fn() { return c + d + top; };
+            }
+        }
+    )");
+    Environment globals;
+    Resolver resolver(&globals);
+    resolver.resolve(program);
+
+    REQUIRE(globals.find("top") != NO_SLOT);
+    REQUIRE(globals.find("outer") != NO_SLOT);
+    REQUIRE_FALSE(globals.isDefined(globals.find("top")));
+
+    auto* outer = dynamic_cast<FunctionStmt*>(program[1].get());
+    REQUIRE(outer->scope.names == std::vector<std::string>{"a", "b", "c"});
+    auto* block = dynamic_cast<BlockStmt*>(outer->body[1].get());
+    REQUIRE(block->scope.names == std::vector<std::string>{"d"});
+
+    auto* ret = dynamic_cast<ReturnStmt*>(block->statements[1].get());
+    auto* closure = dynamic_cast<FunctionExpr*>(ret->value.get());
+    auto* inner = dynamic_cast<ReturnStmt*>(closure->body[0].get());
+    auto* sum = dynamic_cast<BinaryExpr*>(inner->value.get());
+    auto* left = dynamic_cast<BinaryExpr*>(sum->left.get());
+
+    const VarSlot& c = dynamic_cast<VariableExpr*>(left->left.get())->slot;
+    const VarSlot& d = dynamic_cast<VariableExpr*>(left->right.get())->slot;
+    const VarSlot& top = dynamic_cast<VariableExpr*>(sum->right.get())->slot;
+    REQUIRE((c.depth == 2 && c.slot == 2 && !c.checked));
+    REQUIRE((d.depth == 1 && d.slot == 0 && !d.checked));
+    REQUIRE((top.depth == 3 && top.slot == globals.find("top") && top.checked));
+}
+
+TEST_CASE("Resolver: scoping matches name lookup", "[resolver]") {
+    SECTION("Shadowing and initializers that read the outer name") {
+        REQUIRE(run(R"(
+            var x = "global";
+            fn f() {
+                var x = "local";
+                { var x = x + "!"; print(x); }
+                print(x);
+            }
+            f();
+            print(x);
+        )") == "local!\nlocal\nglobal\n");
+    }
+
+    SECTION("Nested functions see names declared after them") {
+        REQUIRE(run(R"(
+            fn outer() {
+                fn isEven(n) { if (n == 0) { return true; } return isOdd(n - 1); }
+                fn isOdd(n) { if (n == 0) { return false; } return isEven(n - 1); }
+                return isEven(10);
+            }
+            fn later() { return laterValue; }
+            var laterValue = 42;
+            print(outer());
+            print(later());
+        )") == "true\n42\n");
+    }
+
+    SECTION("Functions read an outer name until a later declaration shadows it") {
+        REQUIRE(run(R"(
+            var x = "global";
+            {
+                fn f() { return x; }
+                print(f());
+                var x = "block";
+                print(f());
+            }
+            fn outer() {
+                fn g() { x = x + "!"; return x; }
+                print(g());
+                var x = "local";
+                print(g());
+            }
+            outer();
+            print(x);
+        )") == "global\nblock\nglobal!\nlocal!\nglobal!\n");
+    }
+
+    SECTION("Closures, destructuring, match, catch and methods") {
+        REQUIRE(run(R"(
+            fn counter() { var n = 0; return fn() { n = n + 1; return n; }; }
+            var next = counter();
+            next();
+            print(next());
+            fn pair() { var [a, b] = [1, 2]; var {c} = {"c": 3}; return a + b + c; }
+            print(pair());
+            print(match 7 { n if n > 5 => n * 2, _ => 0 });
+            try { throw "boom"; } catch (e) { var message = "caught " + e; print(message); }
+            class A { fn init(v) { this.v = v; } fn get() { return this.v; } }
+            class B extends A {
+                fn init(v) { super.init(v * 2); }
+                fn get() { var f = fn() { return super.get() + 1; }; return f(); }
+            }
+            print(B(5).get());
+        )") == "2\n6\n14\ncaught boom\n11\n");
+    }
+
+    SECTION("Top-level names read before their declaration stay undefined") {
+        REQUIRE_THROWS_WITH(run("print(value); var value = 1;"), "Undefined variable 'value'.");
+    }
+}
+
+TEST_CASE("Resolver: only scopes that create closures are captured", "[resolver]") {
+    auto program = parseSource(R"(
+        fn plain(n) { var total = 0; { var x = n; total = total + x; } return total; }
+        fn maker(n) { { var y = n; } return fn() { return n; }; }
+    )");
+    Environment globals;
+    Resolver resolver(&globals);
+    resolver.resolve(program);
+
+    auto* plain = dynamic_cast<FunctionStmt*>(program[0].get());
+    auto* maker = dynamic_cast<FunctionStmt*>(program[1].get());
+    REQUIRE_FALSE(plain->scope.captured);
+    REQUIRE_FALSE(dynamic_cast<BlockStmt*>(plain->body[1].get())->scope.captured);
+    REQUIRE(maker->scope.captured);
+    REQUIRE_FALSE(dynamic_cast<BlockStmt*>(maker->body[0].get())->scope.captured);
+}
+
+TEST_CASE("Resolver: uncaptured environments are recycled", "[resolver]") {
+    auto program = parseSource(R"(
+        class Box { fn init(v) { this.v = v; } fn get() { return this.v; } }
+        fn work(n) {
+            var sum = 0;
+            var i = 0;
+            while (i < n) {
+                { var step = i; sum = sum + step; }
+                if (i == 3) { try { throw "skip"; } catch (e) { sum = sum + 1; } }
+                i = i + 1;
+            }
+            return sum + Box(match n { k if k > 1 => k, _ => 0 }).get();
+        }
+        var adders = [];
+        var j = 0;
+        while (j < 3) { var k = j; push(adders, fn(x) { return x + k; }); j = j + 1; }
+        print(work(5));
+        print(adders[0](10) + adders[2](10));
+    )");
+    std::stringstream buffer;
+    std::streambuf* old = std::cout.rdbuf(buffer.rdbuf());
+    Interpreter interp("");
+    interp.interpret(program);
+    std::cout.rdbuf(old);
+
+    REQUIRE(buffer.str() == "16\n22\n");
+    REQUIRE(interp.arena_.size() == 0);
+}
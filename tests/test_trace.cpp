@@ -0,0 +1,113 @@
+#include "catch.hpp"
+#include "parse/lexer.hpp"
+#include "parse/parser.hpp"
+#include "compile/compiler.hpp"
+#include "compile/optimizer.hpp"
+#include "bytecode/vm.hpp"
+#include "bytecode/vm_native.hpp"
+#include "common/trace.hpp"
+#include "interp/interpreter.hpp"
+
+#include <sstream>
+
+using namespace izi;
+
+namespace {
+
+const std::string script = R"(
+fn leaf(n) { return n + 1; }
+fn branch(n) { return leaf(n) * 2; }
+var total = 0;
+var i = 0;
+while (i < 3) { total = total + branch(i); i = i + 1; }
+)";
+
+std::vector<StmtPtr> parseSource(const std::string& source) {
+    Lexer lexer(source);
+    auto tokens = lexer.scanTokens();
+    Parser parser(std::move(tokens), source);
+    Optimizer optimizer;
+    return optimizer.optimize(parser.parse());
+}
+
+size_t countOf(const std::string& text, const std::string& needle) {
+    size_t count = 0;
+    for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+}  // namespace
+
+TEST_CASE("Trace: VM run records compiler phases and nested call slices", "[trace]") {
+    Trace::start();
+    {
+        auto program = parseSource(script);
+        BytecodeCompiler compiler;
+        Chunk chunk = compiler.compile(program);
+        VM vm;
+        registerVmNatives(vm);
+        (void)vm.run(chunk);
+    }
+    std::ostringstream out;
+    Trace::stop(out);
+    const std::string json = out.str();
+
+    REQUIRE(json.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0) == 0);
+    for (const char* phase : {"lex", "parse", "optimize", "compile"}) {
+        REQUIRE(json.find("\"cat\":\"compile\",\"name\":\"" + std::string(phase) + "\"") != std::string::npos);
+    }
+    // The script, three calls to branch and three to leaf, all closed again
+    REQUIRE(countOf(json, "\"cat\":\"call\",\"name\":\"<script>\"") == 1);
+    REQUIRE(countOf(json, "\"cat\":\"call\",\"name\":\"branch\"") == 3);
+    REQUIRE(countOf(json, "\"cat\":\"call\",\"name\":\"leaf\"") == 3);
+    REQUIRE(countOf(json, "\"ph\":\"B\"") == 7);
+    REQUIRE(countOf(json, "\"ph\":\"E\"") == 7);
+}
+
+TEST_CASE("Trace: interpreter calls become complete slices", "[trace]") {
+    Trace::start();
+    {
+        auto program = parseSource(script);
+        Interpreter interp(script);
+        interp.interpret(program);
+    }
+    std::ostringstream out;
+    Trace::stop(out);
+    const std::string json = out.str();
+
+    REQUIRE(countOf(json, "\"ph\":\"X\",\"pid\":1") >= 9);  // Three compiler phases and six calls
+    REQUIRE(countOf(json, "\"cat\":\"call\",\"name\":\"leaf\"") == 3);
+    REQUIRE(json.find("\"dur\":") != std::string::npos);
+}
+
+TEST_CASE("Trace: interpreter native calls and imports are slices", "[trace]") {
+    const std::string source = "sleep(1);\nlen(\"fast\");\n";
+    Trace::start();
+    {
+        auto program = parseSource(source);
+        Interpreter interp(source);
+        interp.interpret(program);
+        TraceScope scope("module", "import ", "demo");
+    }
+    std::ostringstream out;
+    Trace::stop(out);
+    const std::string json = out.str();
+
+    REQUIRE(countOf(json, "\"cat\":\"native\",\"name\":\"sleep\"") == 1);
+    REQUIRE(countOf(json, "\"name\":\"len\"") == 0);  // Under the native-call threshold
+    REQUIRE(countOf(json, "\"cat\":\"module\",\"name\":\"import demo\"") == 1);
+}
+
+TEST_CASE("Trace: nothing is recorded while stopped", "[trace]") {
+    REQUIRE_FALSE(Trace::enabled());
+    {
+        TraceScope scope("compile", "ignored");
+        TraceScope prefixed("module", "import ", "ignored");
+    }
+    Trace::start();
+    std::ostringstream out;
+    Trace::stop(out);
+    REQUIRE(out.str().find("ignored") == std::string::npos);
+}
@@ -6,28 +6,28 @@ using namespace izi;
 TEST_CASE("Value types can be created and checked", "[value]") {
     SECTION("Nil value") {
         Value v = Nil{};
-        REQUIRE(std::holds_alternative<Nil>(v));
+        REQUIRE(v.isNil());
         REQUIRE(getTypeName(v) == "nil");
     }
 
     SECTION("Boolean value") {
         Value v = true;
-        REQUIRE(std::holds_alternative<bool>(v));
-        REQUIRE(std::get<bool>(v) == true);
+        REQUIRE(v.isBool());
+        REQUIRE(v.asBool() == true);
         REQUIRE(getTypeName(v) == "boolean");
     }
 
     SECTION("Number value") {
         Value v = 42.5;
-        REQUIRE(std::holds_alternative<double>(v));
-        REQUIRE(std::get<double>(v) == 42.5);
+        REQUIRE(v.isNumber());
+        REQUIRE(v.asNumber() == 42.5);
         REQUIRE(getTypeName(v) == "number");
     }
 
     SECTION("String value") {
         Value v = std::string("hello");
-        REQUIRE(std::holds_alternative<std::string>(v));
-        REQUIRE(std::get<std::string>(v) == "hello");
+        REQUIRE(v.isString());
+        REQUIRE(v.asString() == "hello");
         REQUIRE(getTypeName(v) == "string");
     }
 }
@@ -74,30 +74,30 @@ TEST_CASE("asNumber function works correctly", "[value]") {
 
 TEST_CASE("Array values work correctly", "[value]") {
     SECTION("Create and access array") {
-        auto arr = std::make_shared<Array>();
+        auto arr = makeRef<Array>();
         arr->elements.push_back(1.0);
         arr->elements.push_back(2.0);
         arr->elements.push_back(3.0);
 
         Value v = arr;
-        REQUIRE(std::holds_alternative<std::shared_ptr<Array>>(v));
+        REQUIRE(v.isArray());
         REQUIRE(getTypeName(v) == "array");
 
-        auto extractedArr = std::get<std::shared_ptr<Array>>(v);
+        auto extractedArr = v.asArray();
         REQUIRE(extractedArr->elements.size() == 3);
-        REQUIRE(std::get<double>(extractedArr->elements[0]) == 1.0);
-        REQUIRE(std::get<double>(extractedArr->elements[1]) == 2.0);
-        REQUIRE(std::get<double>(extractedArr->elements[2]) == 3.0);
+        REQUIRE(extractedArr->elements[0].asNumber() == 1.0);
+        REQUIRE(extractedArr->elements[1].asNumber() == 2.0);
+        REQUIRE(extractedArr->elements[2].asNumber() == 3.0);
     }
 
     SECTION("Empty array is falsy") {
-        auto arr = std::make_shared<Array>();
+        auto arr = makeRef<Array>();
         Value v = arr;
         REQUIRE(isTruthy(v) == false);
     }
 
     SECTION("Non-empty array is truthy") {
-        auto arr = std::make_shared<Array>();
+        auto arr = makeRef<Array>();
         arr->elements.push_back(1.0);
         Value v = arr;
         REQUIRE(isTruthy(v) == true);
@@ -106,30 +106,72 @@ TEST_CASE("Array values work correctly", "[value]") {
 
 TEST_CASE("Map values work correctly", "[value]") {
     SECTION("Create and access map") {
-        auto map = std::make_shared<Map>();
+        auto map = makeRef<Map>();
         map->entries["key1"] = 10.0;
         map->entries["key2"] = std::string("value");
 
         Value v = map;
-        REQUIRE(std::holds_alternative<std::shared_ptr<Map>>(v));
+        REQUIRE(v.isMap());
         REQUIRE(getTypeName(v) == "map");
 
-        auto extractedMap = std::get<std::shared_ptr<Map>>(v);
+        auto extractedMap = v.asMap();
         REQUIRE(extractedMap->entries.size() == 2);
-        REQUIRE(std::get<double>(extractedMap->entries["key1"]) == 10.0);
-        REQUIRE(std::get<std::string>(extractedMap->entries["key2"]) == "value");
+        REQUIRE(extractedMap->entries["key1"].asNumber() == 10.0);
+        REQUIRE(extractedMap->entries["key2"].asString() == "value");
     }
 
     SECTION("Empty map is falsy") {
-        auto map = std::make_shared<Map>();
+        auto map = makeRef<Map>();
         Value v = map;
         REQUIRE(isTruthy(v) == false);
     }
 
     SECTION("Non-empty map is truthy") {
-        auto map = std::make_shared<Map>();
+        auto map = makeRef<Map>();
         map->entries["key"] = 1.0;
         Value v = map;
         REQUIRE(isTruthy(v) == true);
     }
 }
+
+TEST_CASE("Value representation is compact", "[value]") {
+    SECTION("Value is a 16-byte tag + payload") {
+        REQUIRE(sizeof(Value) == 16);
+    }
+
+    SECTION("Copies of a string share storage and compare by content") {
+        Value a = std::string("a fairly long string that would not fit in SSO");
+        Value b = a;
+        REQUIRE(&a.asString() == &b.asString());
+        REQUIRE(a == b);
+        REQUIRE(a == Value(std::string("a fairly long string that would not fit in SSO")));
+    }
+
+    SECTION("Moved-from values become nil") {
+        Value a = std::string("moved");
+        Value b = std::move(a);
+        REQUIRE(b.asString() == "moved");
+        REQUIRE(a.isNil());
+    }
+
+    SECTION("Heap values compare by identity") {
+        auto arr = makeRef<Array>();
+        Value a = arr;
+        Value b = arr;
+        Value c = makeRef<Array>();
+        REQUIRE(a == b);
+        REQUIRE_FALSE(a == c);
+        REQUIRE(a.asArray().get() == arr.get());
+    }
+
+    SECTION("Values of different types are never equal") {
+        REQUIRE_FALSE(Value(1.0) == Value(true));
+        REQUIRE_FALSE(Value(Nil{}) == Value(0.0));
+        REQUIRE(Value(Nil{}) == Value());
+    }
+
+    SECTION("Accessors reject the wrong type") {
+        Value v = 42.0;
+        REQUIRE_THROWS_AS(v.asString(), std::runtime_error);
+    }
+}
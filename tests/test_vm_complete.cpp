@@ -328,6 +328,122 @@ TEST_CASE("VM local vars: nested function inside function", "[vm-complete][local
     REQUIRE(out.find("6") != std::string::npos);
 }
 
+// ============================================================
+//  Globals: slot-indexed, resolved when a chunk is linked to a VM
+// ============================================================
+
+static Chunk compileSource(const std::string& source) {
+    Lexer lexer(source);
+    auto tokens = lexer.scanTokens();
+    Parser parser(std::move(tokens), source);
+    auto program = parser.parse();
+    BytecodeCompiler compiler;
+    return compiler.compile(program);
+}
+
+TEST_CASE("VM globals: shared between chunks run on the same VM", "[vm-complete][globals]") {
+    VM vm;
+    registerVmNatives(vm);
+    Chunk first = compileSource("var counter = 1; fn bump() { counter = counter + 1; }");
+    Chunk second = compileSource("bump(); bump(); var result = counter;");
+    vm.run(first);
+    vm.run(second);
+    auto globals = vm.getGlobals();
+    REQUIRE(globals.at("result").asNumber() == 3.0);
+    REQUIRE(globals.at("counter").asNumber() == 3.0);
+}
+
+TEST_CASE("VM globals: late-bound names registered after linking", "[vm-complete][globals]") {
+    VM vm;
+    // `late` gets its slot when the chunk is linked, but nothing defines it
+    // until after the chunk has run once
+    Chunk chunk = compileSource("fn get() { return late; } var result = 0; if (ready) { result = get(); }");
+    vm.setGlobal("ready", Value(false));
+    vm.run(chunk);
+    REQUIRE(vm.getGlobals().at("result").asNumber() == 0.0);
+    REQUIRE(vm.getGlobals().count("late") == 0);
+
+    vm.setGlobal("late", Value(1.0));
+    vm.setGlobal("ready", Value(true));
+    vm.run(chunk);
+    REQUIRE(vm.getGlobals().at("result").asNumber() == 1.0);
+
+    // The function the first run defined reads the slot too
+    Chunk call = compileSource("var again = get();");
+    vm.setGlobal("late", Value(2.0));
+    vm.run(call);
+    REQUIRE(vm.getGlobals().at("again").asNumber() == 2.0);
+}
+
+TEST_CASE("VM globals: a chunk is relinked when run on another VM", "[vm-complete][globals]") {
+    Chunk chunk = compileSource("var result = seed * 2;");
+    VM a;
+    VM b;
+    b.setGlobal("unused", Value(0.0));  // Shift b's slot numbering
+    a.setGlobal("seed", Value(1.0));
+    b.setGlobal("seed", Value(5.0));
+    a.run(chunk);
+    b.run(chunk);
+    REQUIRE(a.getGlobals().at("result").asNumber() == 2.0);
+    REQUIRE(b.getGlobals().at("result").asNumber() == 10.0);
+}
+
+TEST_CASE("VM globals: undefined variable is still reported", "[vm-complete][globals]") {
+    std::stringstream err;
+    std::streambuf* old = std::cerr.rdbuf(err.rdbuf());
+    compileAndRun("print(missing);");
+    std::cerr.rdbuf(old);
+    REQUIRE(err.str().find("Undefined variable 'missing'") != std::string::npos);
+}
+
+// ============================================================
+//  Properties: shapes and inline caches
+// ============================================================
+
+TEST_CASE("VM properties: one site sees several shapes", "[vm-complete][properties]") {
+    std::string source = R"(
+        class A { var v; fn constructor() { this.v = 1; } }
+        class B { var pad; var v; fn constructor() { this.v = 2; } }
+        fn getV(o) { return o.v; }
+        var objs = [A(), B(), A(), B()];
+        var i = 0;
+        var sum = 0;
+        while (i < 4) { sum = sum + getV(objs[i]); i = i + 1; }
+        print(sum);
+    )";
+    REQUIRE(runAndCapture(source) == "6\n");
+}
+
+TEST_CASE("VM properties: fields added at runtime share a transition", "[vm-complete][properties]") {
+    std::string source = R"(
+        class P {
+            fn constructor(n) { this.n = n; this.sq = n * n; }
+            fn sq2() { return this.sq; }
+        }
+        var a = P(2);
+        var b = P(3);
+        b.extra = 1;
+        print(a.sq2() + b.sq2() + b.extra);
+        a.sq = 100;
+        print(a.sq2());
+    )";
+    REQUIRE(runAndCapture(source) == "14\n100\n");
+}
+
+TEST_CASE("VM properties: map receivers are cached and see deletes", "[vm-complete][properties]") {
+    std::string source = R"(
+        var m = {"k": 1};
+        fn get() { return m.k; }
+        print(get());
+        m.k = 5;
+        print(get());
+        delete(m, "k");
+        m.k = 7;
+        print(get());
+    )";
+    REQUIRE(runAndCapture(source) == "1\n5\n7\n");
+}
+
 // ============================================================
 //  BUILD_ARRAY with direct VM opcodes (unit test)
 // ============================================================
@@ -349,12 +465,12 @@ TEST_CASE("VM BUILD_ARRAY opcode: manual chunk", "[vm-complete][array][low-level
 
     VM vm;
     Value result = vm.run(chunk);
-    REQUIRE(std::holds_alternative<std::shared_ptr<Array>>(result));
-    auto arr = std::get<std::shared_ptr<Array>>(result);
+    REQUIRE(result.isArray());
+    auto arr = result.asArray();
     REQUIRE(arr->elements.size() == 3);
-    REQUIRE(std::get<double>(arr->elements[0]) == 1.0);
-    REQUIRE(std::get<double>(arr->elements[1]) == 2.0);
-    REQUIRE(std::get<double>(arr->elements[2]) == 3.0);
+    REQUIRE(arr->elements[0].asNumber() == 1.0);
+    REQUIRE(arr->elements[1].asNumber() == 2.0);
+    REQUIRE(arr->elements[2].asNumber() == 3.0);
 }
 
 TEST_CASE("VM BUILD_MAP opcode: manual chunk", "[vm-complete][map][low-level]") {
@@ -375,10 +491,10 @@ TEST_CASE("VM BUILD_MAP opcode: manual chunk", "[vm-complete][map][low-level]")
 
     VM vm;
     Value result = vm.run(chunk);
-    REQUIRE(std::holds_alternative<std::shared_ptr<Map>>(result));
-    auto map = std::get<std::shared_ptr<Map>>(result);
+    REQUIRE(result.isMap());
+    auto map = result.asMap();
     REQUIRE(map->entries.count("x") == 1);
-    REQUIRE(std::get<double>(map->entries.at("x")) == 10.0);
+    REQUIRE(map->entries.at("x").asNumber() == 10.0);
 }
 
 TEST_CASE("VM JUMP_IF_NOT_NIL opcode: manual chunk", "[vm-complete][nullish][low-level]") {
@@ -401,8 +517,8 @@ TEST_CASE("VM JUMP_IF_NOT_NIL opcode: manual chunk", "[vm-complete][nullish][low
 
         VM vm;
         Value result = vm.run(chunk);
-        REQUIRE(std::holds_alternative<double>(result));
-        REQUIRE(std::get<double>(result) == 42.0);
+        REQUIRE(result.isNumber());
+        REQUIRE(result.asNumber() == 42.0);
     }
 
     SECTION("nil value falls through to fallback") {
@@ -423,7 +539,7 @@ TEST_CASE("VM JUMP_IF_NOT_NIL opcode: manual chunk", "[vm-complete][nullish][low
 
         VM vm;
         Value result = vm.run(chunk);
-        REQUIRE(std::holds_alternative<double>(result));
-        REQUIRE(std::get<double>(result) == 99.0);
+        REQUIRE(result.isNumber());
+        REQUIRE(result.asNumber() == 99.0);
     }
 }
@@ -33,7 +33,7 @@ TEST_CASE("Chunk: write and line tracking", "[vm-core][chunk]") {
     SECTION("constants are stored and retrievable") {
         size_t idx = chunk.addConstant(42.0);
         REQUIRE(idx == 0);
-        REQUIRE(std::get<double>(chunk.constants[0]) == 42.0);
+        REQUIRE(chunk.constants[0].asNumber() == 42.0);
     }
 
     SECTION("names are stored and retrievable") {
@@ -127,8 +127,8 @@ TEST_CASE("VM: load and execute CONSTANT instruction", "[vm-core][vm-execute]")
     VM vm;
     Value result = vm.run(chunk);
 
-    REQUIRE(std::holds_alternative<double>(result));
-    REQUIRE(std::get<double>(result) == 42.0);
+    REQUIRE(result.isNumber());
+    REQUIRE(result.asNumber() == 42.0);
 }
 
 TEST_CASE("VM: load and execute NIL instruction", "[vm-core][vm-execute]") {
@@ -139,7 +139,7 @@ TEST_CASE("VM: load and execute NIL instruction", "[vm-core][vm-execute]") {
     VM vm;
     Value result = vm.run(chunk);
 
-    REQUIRE(std::holds_alternative<Nil>(result));
+    REQUIRE(result.isNil());
 }
 
 TEST_CASE("VM: arithmetic over two constants", "[vm-core][vm-execute]") {
@@ -153,8 +153,8 @@ TEST_CASE("VM: arithmetic over two constants", "[vm-core][vm-execute]") {
         chunk.write(static_cast<uint8_t>(OpCode::RETURN), 1);
         VM vm;
         Value result = vm.run(chunk);
-        REQUIRE(std::holds_alternative<double>(result));
-        REQUIRE(std::get<double>(result) == 15.0);
+        REQUIRE(result.isNumber());
+        REQUIRE(result.asNumber() == 15.0);
     }
 
     SECTION("subtraction") {
@@ -167,8 +167,8 @@ TEST_CASE("VM: arithmetic over two constants", "[vm-core][vm-execute]") {
         chunk.write(static_cast<uint8_t>(OpCode::RETURN), 1);
         VM vm;
         Value result = vm.run(chunk);
-        REQUIRE(std::holds_alternative<double>(result));
-        REQUIRE(std::get<double>(result) == 7.0);
+        REQUIRE(result.isNumber());
+        REQUIRE(result.asNumber() == 7.0);
     }
 
     SECTION("multiplication") {
@@ -181,8 +181,8 @@ TEST_CASE("VM: arithmetic over two constants", "[vm-core][vm-execute]") {
         chunk.write(static_cast<uint8_t>(OpCode::RETURN), 1);
         VM vm;
         Value result = vm.run(chunk);
-        REQUIRE(std::holds_alternative<double>(result));
-        REQUIRE(std::get<double>(result) == 20.0);
+        REQUIRE(result.isNumber());
+        REQUIRE(result.asNumber() == 20.0);
     }
 
     SECTION("comparison: greater than") {
@@ -195,7 +195,72 @@ TEST_CASE("VM: arithmetic over two constants", "[vm-core][vm-execute]") {
         chunk.write(static_cast<uint8_t>(OpCode::RETURN), 1);
         VM vm;
         Value result = vm.run(chunk);
-        REQUIRE(std::holds_alternative<bool>(result));
-        REQUIRE(std::get<bool>(result) == true);
+        REQUIRE(result.isBool());
+        REQUIRE(result.asBool() == true);
+    }
+}
+
+TEST_CASE("VM: type quickening rewrites sites in place", "[vm-core][vm-execute]") {
+    // Quickening happens in the interpreter loop; keep the JIT test mode out
+    // CONSTANT a; CONSTANT b; <op>; RETURN -- the opcode sits at offset 4
+    auto binaryChunk = [](const Value& a, const Value& b, OpCode op) {
+        Chunk chunk;
+        uint8_t ia = static_cast<uint8_t>(chunk.addConstant(a));
+        uint8_t ib = static_cast<uint8_t>(chunk.addConstant(b));
+        chunk.write(static_cast<uint8_t>(OpCode::CONSTANT), 1); chunk.write(ia, 1);
+        chunk.write(static_cast<uint8_t>(OpCode::CONSTANT), 1); chunk.write(ib, 1);
+        chunk.write(static_cast<uint8_t>(op), 1);
+        chunk.write(static_cast<uint8_t>(OpCode::RETURN), 1);
+        return chunk;
+    };
+
+    SECTION("ADD on numbers becomes ADD_NUM") {
+        Chunk chunk = binaryChunk(2.0, 3.0, OpCode::ADD);
+        VM vm;
+        vm.disableJit();
+        REQUIRE(vm.run(chunk).asNumber() == 5.0);
+        REQUIRE(chunk.code[4] == static_cast<uint8_t>(OpCode::ADD_NUM));
+        REQUIRE(vm.run(chunk).asNumber() == 5.0);
+    }
+
+    SECTION("ADD_NUM on strings de-quickens to ADD") {
+        Chunk chunk = binaryChunk(std::string("a"), std::string("b"), OpCode::ADD_NUM);
+        VM vm;
+        vm.disableJit();
+        REQUIRE(vm.run(chunk).asString() == "ab");
+        REQUIRE(chunk.code[4] == static_cast<uint8_t>(OpCode::ADD));
+    }
+
+    SECTION("LESS on numbers becomes LESS_NUM, and a miss still fails") {
+        Chunk chunk = binaryChunk(1.0, 2.0, OpCode::LESS);
+        VM vm;
+        vm.disableJit();
+        REQUIRE(vm.run(chunk).asBool() == true);
+        REQUIRE(chunk.code[4] == static_cast<uint8_t>(OpCode::LESS_NUM));
+
+        Chunk mismatch = binaryChunk(std::string("a"), 2.0, OpCode::LESS_NUM);
+        REQUIRE(vm.run(mismatch).isNil());  // Reported as an uncaught "Expected number" error
+        REQUIRE(mismatch.code[4] == static_cast<uint8_t>(OpCode::LESS));
+    }
+
+    SECTION("INDEX on an array becomes INDEX_ARRAY_NUM") {
+        auto array = makeRef<Array>();
+        array->elements = {Value(10.0), Value(20.0)};
+        Chunk chunk = binaryChunk(array, 1.0, OpCode::INDEX);
+        VM vm;
+        vm.disableJit();
+        REQUIRE(vm.run(chunk).asNumber() == 20.0);
+        REQUIRE(chunk.code[4] == static_cast<uint8_t>(OpCode::INDEX_ARRAY_NUM));
+        REQUIRE(vm.run(chunk).asNumber() == 20.0);
+
+        Chunk outOfRange = binaryChunk(array, 2.0, OpCode::INDEX_ARRAY_NUM);
+        REQUIRE(vm.run(outOfRange).isNil());
+        REQUIRE(outOfRange.code[4] == static_cast<uint8_t>(OpCode::INDEX_ARRAY_NUM));
+
+        auto map = makeRef<Map>();
+        map->entries["k"] = Value(7.0);
+        Chunk onMap = binaryChunk(map, std::string("k"), OpCode::INDEX_ARRAY_NUM);
+        REQUIRE(vm.run(onMap).asNumber() == 7.0);
+        REQUIRE(onMap.code[4] == static_cast<uint8_t>(OpCode::INDEX));
     }
 }
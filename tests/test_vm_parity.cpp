@@ -93,7 +93,7 @@ TEST_CASE("VM parity: arrays and maps", "[vm-parity][p0]") {
     )");
 }
 
-TEST_CASE("VM known gap: functions and closures parity", "[vm-gap][!mayfail]") {
+TEST_CASE("VM parity: functions and closures", "[vm-parity][p0]") {
     requireSameOutput(R"(
         fn makeCounter() {
             var c = 0;
@@ -109,6 +109,53 @@ TEST_CASE("VM known gap: functions and closures parity", "[vm-gap][!mayfail]") {
     )");
 }
 
+TEST_CASE("VM parity: sibling closures share captured variables", "[vm-parity][p0]") {
+    requireSameOutput(R"(
+        fn makePair() {
+            var n = 0;
+            var inc = fn() { n = n + 1; };
+            var get = fn() { return n; };
+            return [inc, get];
+        }
+        var p = makePair();
+        p[0]();
+        p[0]();
+        print(p[1]());
+    )");
+}
+
+TEST_CASE("VM parity: closures capture per-iteration locals and outer scopes", "[vm-parity][p0]") {
+    requireSameOutput(R"(
+        fn collect() {
+            var fns = [];
+            var i = 0;
+            while (i < 3) {
+                var j = i * 10;
+                push(fns, fn() { return j; });
+                i = i + 1;
+            }
+            return fns;
+        }
+        var fns = collect();
+        print(fns[0]() + fns[1]() + fns[2]());
+
+        fn outer() {
+            var base = 100;
+            fn middle() {
+                return fn(x) { return base + x; };
+            }
+            return middle();
+        }
+        print(outer()(5));
+
+        fn countdown() {
+            fn go(n) { if (n == 0) return "done"; return go(n - 1); }
+            return go(3);
+        }
+        print(countdown());
+    )");
+}
+
 TEST_CASE("VM parity: recursion", "[vm-parity][p0]") {
     requireSameOutput(R"(
         fn fact(n) {
@@ -119,6 +166,39 @@ TEST_CASE("VM parity: recursion", "[vm-parity][p0]") {
     )");
 }
 
+TEST_CASE("VM parity: mutual recursion and nested calls", "[vm-parity][p0]") {
+    requireSameOutput(R"(
+        fn isEven(n) { if (n == 0) return true; return isOdd(n - 1); }
+        fn isOdd(n) { if (n == 0) return false; return isEven(n - 1); }
+        fn fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }
+        fn add3(a, b, c) { return a + b + c; }
+        print(isEven(100));
+        print(fib(15));
+        print(add3(fib(5), add3(1, 2, 3), fib(6)));
+    )");
+}
+
+TEST_CASE("VM parity: exception thrown in a callee is caught by the caller", "[vm-parity][p0]") {
+    requireSameOutput(R"(
+        fn inner() { throw "boom"; }
+        fn outer() { inner(); return "unreachable"; }
+        try {
+            outer();
+        } catch (e) {
+            print("caught " + e);
+        }
+        print("after");
+    )");
+}
+
+TEST_CASE("VM call frames: recursion depth is not bounded by the native stack", "[vm-complete][calls]") {
+    std::string out = runWithVm(R"(
+        fn depth(n) { if (n == 0) return 0; return 1 + depth(n - 1); }
+        print(depth(1000));
+    )");
+    REQUIRE(out == "1000\n");
+}
+
 TEST_CASE("VM parity: nullish and logic", "[vm-parity][p0]") {
     requireSameOutput(R"(
         var a = nil;
@@ -143,7 +223,59 @@ TEST_CASE("VM parity: try/catch/finally", "[vm-parity][p0]") {
     )");
 }
 
-TEST_CASE("VM known gap: class inheritance parity", "[vm-gap][!mayfail]") {
+TEST_CASE("VM parity: catch variables are block locals", "[vm-parity][p0]") {
+    requireSameOutput(R"(
+        fn check(n) {
+            var base = 10;
+            try {
+                var partial = base * 2;
+                if (n > 0) throw "bad";
+                return partial;
+            } catch (err) {
+                var note = err + "!";
+                return fn() { return note + " " + err + " " + (base > 5 ? "big" : "small"); };
+            }
+        }
+        print(check(0));
+        print(check(3)());
+        try { throw "top"; } catch (e) { print(e); }
+        var e = "global e";
+        try { throw "shadow"; } catch (e) { print(e); }
+        print(e);
+    )");
+}
+
+TEST_CASE("VM parity: finally without catch rethrows", "[vm-parity][p0]") {
+    requireSameOutput(R"(
+        fn risky() {
+            try {
+                throw "first";
+            } finally {
+                print("cleanup");
+            }
+            return "unreachable";
+        }
+        try {
+            risky();
+        } catch (e) {
+            print("outer " + e);
+        }
+        var total = 0;
+        var i = 0;
+        while (i < 6) {
+            try {
+                if (i % 2 == 0) throw i;
+                total = total + i;
+            } catch (n) {
+                total = total + n * 10;
+            }
+            i = i + 1;
+        }
+        print(total);
+    )");
+}
+
+TEST_CASE("VM parity: class inheritance", "[vm-parity][p0]") {
     requireSameOutput(R"(
         class A {
             fn speak() { return "A"; }
@@ -156,6 +288,105 @@ TEST_CASE("VM known gap: class inheritance parity", "[vm-gap][!mayfail]") {
     )");
 }
 
+TEST_CASE("VM parity: super is bound when the class is created", "[vm-parity][p0]") {
+    requireSameOutput(R"(
+        class Base {
+            fn m() { return "base"; }
+        }
+        class Other {
+            fn m() { return "other"; }
+        }
+        class D extends Base {
+            fn m() { return "d+" + super.m(); }
+            fn later() { return fn() { return super.m(); }; }
+        }
+        class E extends D {
+            fn m() { return "e+" + super.m(); }
+        }
+        var d = D();
+        Base = Other;
+        print(d.m());
+        print(d.later()());
+        print(E().m());
+        Base = nil;
+        print(d.m());
+        D = nil;
+        print(E().m());
+    )");
+}
+
+TEST_CASE("VM parity: methods keep their own 'this' under recursion and nesting", "[vm-parity][p0]") {
+    requireSameOutput(R"(
+        class Node {
+            fn init(value, next) {
+                this.value = value;
+                this.next = next;
+            }
+            fn sum() {
+                if (this.next == nil) return this.value;
+                return this.value + this.next.sum();
+            }
+            fn adder() {
+                return fn(x) { return this.value + x; };
+            }
+        }
+        var list = Node(1, Node(2, Node(3, nil)));
+        print(list.sum());
+        print(list.next.adder()(10));
+        var f = list.sum;
+        print(f());
+    )");
+}
+
+TEST_CASE("VM parity: superinstructions", "[vm-parity][p0]") {
+    requireSameOutput(R"(
+        class Point {
+            fn init(x, y) { this.x = x; this.y = y; }
+            fn norm() { return this.x * this.x + this.y * this.y; }
+        }
+        fn walk(a, b, c, d, e) {
+            var p = Point(a, b);
+            var total = p.x + p.y + c + d + e;
+            var i = 0;
+            while (i < 10) {
+                if (i < 5) total = total + 1; else total = total + 2.5;
+                i = i + 1;
+            }
+            return total + p.norm();
+        }
+        var s = "";
+        var n = 0;
+        while (n < 4) {
+            s = s + "x";
+            n = n + 1;
+        }
+        print(walk(1, 2, 3, 4, 5));
+        print(s);
+        if (n < 4) print("less"); else print("not less");
+    )");
+}
+
+TEST_CASE("VM parity: quickened sites that change operand types", "[vm-parity][p0]") {
+    requireSameOutput(R"(
+        fn add(a, b) { return a + b; }
+        fn less(a, b) { return a < b; }
+        fn at(c, k) { return c[k]; }
+        var arr = [5, 6, 7];
+        var m = {"x": 1};
+        var out = [];
+        var i = 0;
+        while (i < 3) {
+            push(out, add(i, 1));
+            push(out, add("s", "t"));
+            push(out, less(i, 2));
+            push(out, at(arr, i));
+            push(out, at(m, "x"));
+            i = i + 1;
+        }
+        print(out);
+    )");
+}
+
 TEST_CASE("VM known gap: async parity", "[vm-gap][!mayfail]") {
     requireSameOutput(R"(
         async fn v() {
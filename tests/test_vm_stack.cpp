@@ -6,6 +6,17 @@
 
 using namespace izi;
 
+namespace {
+
+// An array that records when it is freed
+struct ProbeArray : Array {
+    explicit ProbeArray(bool& freed) : freed(freed) {}
+    ~ProbeArray() override { freed = true; }
+    bool& freed;
+};
+
+}  // namespace
+
 TEST_CASE("VM Stack Management", "[vm-stack]") {
     SECTION("Variable declarations don't leak stack values") {
         // Bug: VarStmt was leaving values on the stack after SET_GLOBAL
@@ -99,3 +110,46 @@ TEST_CASE("VM Stack Management", "[vm-stack]") {
         REQUIRE_NOTHROW(vm.run(chunk));
     }
 }
+
+TEST_CASE("VM: handlers release the values they pop", "[vm-stack]") {
+    // With computed-goto dispatch a handler's locals are not destroyed when
+    // it jumps to the next one; any Value left in scope keeps its object
+    // alive after the VM is gone
+    std::string source = R"(
+        class Base { fn get() { return this.p; } }
+        class Derived extends Base {
+            fn init() { this.p = probe; }
+            fn get() { return super.get(); }
+        }
+        fn capture(n) { fn get() { return n; } return get; }
+        var i = 0;
+        while (i < 100) {
+            var a = [probe, [probe]];
+            var m = {"k": probe};
+            var x = m["k"];
+            x = a[1];
+            m["k"] = probe;
+            a[0] = probe;
+            x = Derived().get();
+            x = capture(probe)();
+            try { throw probe; } catch (e) { x = e; }
+            i = i + 1;
+        }
+    )";
+
+    Lexer lexer(source);
+    auto tokens = lexer.scanTokens();
+    Parser parser(std::move(tokens), source);
+    auto program = parser.parse();
+    BytecodeCompiler compiler;
+    Chunk chunk = compiler.compile(program);
+
+    bool freed = false;
+    {
+        VM vm;
+        vm.setGlobal("probe", Value(Ref<Array>(makeRef<ProbeArray>(freed))));
+        REQUIRE_NOTHROW(vm.run(chunk));
+        REQUIRE(vm.getGlobals().at("i").asNumber() == 100);
+    }
+    REQUIRE(freed);
+}